@@ -8,12 +8,13 @@
 //////////////
 // INCLUDES //
 //////////////
-#include <d3d11.h>
 #include <DirectXMath.h>
-#include <d3dcompiler.h>
-#include <fstream>
 
-#pragma comment(lib,"D3dcompiler.lib")
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "renderdeviceclass.h"
+#include "constantringclass.h"
 
 using namespace std;
 using namespace DirectX;
@@ -43,23 +44,23 @@ public:
 	// The functions here handle initializing and shutdown of the shader.
 	// The render function sets the shader parameters, then draws the prepared model vertices using the shader.
 
-	bool Initialize(ID3D11Device*, HWND);
+	bool Initialize(RenderDeviceClass*);
+	void SetConstantRing(ConstantRingClass*);
 	void Shutdown();
-	bool Render(ID3D11DeviceContext*, int, XMMATRIX, XMMATRIX, XMMATRIX);
+	bool Render(RenderDeviceClass*, int, XMMATRIX, XMMATRIX, XMMATRIX);
 
 private:
-	bool InitializeShader(ID3D11Device*, HWND, const wchar_t*, const wchar_t*);
+	bool InitializeShader(RenderDeviceClass*, const wchar_t*, const wchar_t*);
 	void ShutdownShader();
-	void OutputShaderErrorMessage(ID3D10Blob*, HWND, const wchar_t*);
 
-	bool SetShaderParameters(ID3D11DeviceContext*, XMMATRIX, XMMATRIX, XMMATRIX);
-	void RenderShader(ID3D11DeviceContext*, int);
+	bool SetShaderParameters(RenderDeviceClass*, XMMATRIX, XMMATRIX, XMMATRIX);
+	void RenderShader(RenderDeviceClass*, int);
 
 private:
-	ID3D11VertexShader* m_vertexShader;
-	ID3D11PixelShader* m_pixelShader;
-	ID3D11InputLayout* m_layout;
-	ID3D11Buffer* m_matrixBuffer;
+	RenderDeviceClass* m_device;
+	unsigned int m_shader;
+	unsigned int m_matrixBuffer;
+	ConstantRingClass* m_constantRing;
 };
 
 #endif
\ No newline at end of file
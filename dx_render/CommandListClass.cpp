@@ -0,0 +1,406 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: commandlistclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "commandlistclass.h"
+#include <cstring>
+
+
+CommandListClass::CommandListClass()
+{
+	m_device = 0;
+	m_lastError = "";
+}
+
+
+CommandListClass::CommandListClass(const CommandListClass& other)
+{
+}
+
+
+CommandListClass::~CommandListClass()
+{
+}
+
+// Initialize makes an empty list that is going to be drawn on device, which the caller keeps owning.
+bool CommandListClass::Initialize(RenderDeviceClass* device)
+{
+	if (!device)
+	{
+		return false;
+	}
+
+	m_device = device;
+	Reset();
+
+	return true;
+}
+
+
+void CommandListClass::Shutdown()
+{
+	m_commands.clear();
+	m_commands.shrink_to_fit();
+	m_vertexBufferData.clear();
+	m_vertexBufferData.shrink_to_fit();
+	m_device = 0;
+
+	return;
+}
+
+
+RenderDeviceClass::CapsType CommandListClass::GetCaps()
+{
+	return m_device->GetCaps();
+}
+
+
+bool CommandListClass::CreateBuffer(const BufferDescType& desc, const void* initialData, OUT unsigned int& buffer)
+{
+	buffer = RENDER_HANDLE_NONE;
+	Error("CreateBuffer");
+
+	return false;
+}
+
+
+void CommandListClass::UpdateBuffer(unsigned int buffer, unsigned int offset, const void* data, unsigned int size)
+{
+	Error("UpdateBuffer");
+
+	return;
+}
+
+
+void CommandListClass::CopyBuffer(unsigned int destination, unsigned int destinationOffset, unsigned int source, unsigned int sourceOffset,
+	unsigned int size)
+{
+	Error("CopyBuffer");
+
+	return;
+}
+
+
+bool CommandListClass::MapBuffer(unsigned int buffer, RenderMapType mapType, unsigned int offset, unsigned int size, OUT void*& data)
+{
+	data = 0;
+	Error("MapBuffer");
+
+	return false;
+}
+
+
+void CommandListClass::UnmapBuffer(unsigned int buffer)
+{
+	Error("UnmapBuffer");
+
+	return;
+}
+
+
+void CommandListClass::ReleaseBuffer(unsigned int buffer)
+{
+	Error("ReleaseBuffer");
+
+	return;
+}
+
+
+bool CommandListClass::CreateTexture(const wchar_t* filename, OUT unsigned int& texture)
+{
+	texture = RENDER_HANDLE_NONE;
+	Error("CreateTexture");
+
+	return false;
+}
+
+
+bool CommandListClass::CreateTexture(const unsigned char* data, size_t size, OUT unsigned int& texture)
+{
+	texture = RENDER_HANDLE_NONE;
+	Error("CreateTexture");
+
+	return false;
+}
+
+
+void CommandListClass::ReleaseTexture(unsigned int texture)
+{
+	Error("ReleaseTexture");
+
+	return;
+}
+
+
+bool CommandListClass::CreateShader(const ShaderDescType& desc, OUT unsigned int& shader)
+{
+	shader = RENDER_HANDLE_NONE;
+	Error("CreateShader");
+
+	return false;
+}
+
+
+void CommandListClass::ReleaseShader(unsigned int shader)
+{
+	Error("ReleaseShader");
+
+	return;
+}
+
+
+bool CommandListClass::CreateQuery(OUT unsigned int& query)
+{
+	query = RENDER_HANDLE_NONE;
+	Error("CreateQuery");
+
+	return false;
+}
+
+
+void CommandListClass::EndQuery(unsigned int query)
+{
+	Error("EndQuery");
+
+	return;
+}
+
+
+bool CommandListClass::IsQueryDone(unsigned int query, bool flush)
+{
+	Error("IsQueryDone");
+
+	return false;
+}
+
+
+void CommandListClass::ReleaseQuery(unsigned int query)
+{
+	Error("ReleaseQuery");
+
+	return;
+}
+
+
+void CommandListClass::BeginScene(float red, float green, float blue, float alpha)
+{
+	Error("BeginScene");
+
+	return;
+}
+
+
+void CommandListClass::EndScene()
+{
+	Error("EndScene");
+
+	return;
+}
+
+// SetVertexBuffers copies the three arrays into the list's vertex buffer data, the command only keeps where they start.
+void CommandListClass::SetVertexBuffers(unsigned int startSlot, unsigned int count, const unsigned int* buffers, const unsigned int* strides,
+	const unsigned int* offsets)
+{
+	Add(RENDER_COMMAND_SET_VERTEX_BUFFERS, startSlot, count, (unsigned int)m_vertexBufferData.size(), 0, 0);
+	m_vertexBufferData.insert(m_vertexBufferData.end(), buffers, buffers + count);
+	m_vertexBufferData.insert(m_vertexBufferData.end(), strides, strides + count);
+	m_vertexBufferData.insert(m_vertexBufferData.end(), offsets, offsets + count);
+	m_stats.bindCount++;
+
+	return;
+}
+
+
+void CommandListClass::SetIndexBuffer(unsigned int buffer, DXGI_FORMAT format, unsigned int offset)
+{
+	Add(RENDER_COMMAND_SET_INDEX_BUFFER, buffer, (unsigned int)format, offset, 0, 0);
+	m_stats.bindCount++;
+
+	return;
+}
+
+
+void CommandListClass::SetShader(unsigned int shader)
+{
+	Add(RENDER_COMMAND_SET_SHADER, shader, 0, 0, 0, 0);
+	m_stats.bindCount++;
+
+	return;
+}
+
+
+void CommandListClass::SetConstantBuffer(RenderShaderStageType stage, unsigned int slot, unsigned int buffer, unsigned int firstConstant,
+	unsigned int constantCount)
+{
+	Add(RENDER_COMMAND_SET_CONSTANT_BUFFER, (unsigned int)stage, slot, buffer, firstConstant, constantCount);
+	m_stats.bindCount++;
+
+	return;
+}
+
+
+void CommandListClass::SetTexture(unsigned int slot, unsigned int texture)
+{
+	Add(RENDER_COMMAND_SET_TEXTURE, slot, texture, 0, 0, 0);
+	m_stats.bindCount++;
+
+	return;
+}
+
+
+void CommandListClass::DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex)
+{
+	Add(RENDER_COMMAND_DRAW_INDEXED, indexCount, startIndex, (unsigned int)baseVertex, 0, 0);
+	m_stats.drawCount++;
+	m_stats.instanceCount++;
+	m_stats.indexCount += indexCount;
+
+	return;
+}
+
+
+void CommandListClass::DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int startIndex, int baseVertex,
+	unsigned int startInstance)
+{
+	Add(RENDER_COMMAND_DRAW_INDEXED_INSTANCED, indexCount, instanceCount, startIndex, (unsigned int)baseVertex, startInstance);
+	m_stats.drawCount++;
+	m_stats.instanceCount += instanceCount;
+	m_stats.indexCount += (unsigned long long)indexCount * instanceCount;
+
+	return;
+}
+
+// A list can not hold other lists.
+bool CommandListClass::CreateCommandList(OUT unsigned int& commandList)
+{
+	commandList = RENDER_HANDLE_NONE;
+	Error("CreateCommandList");
+
+	return false;
+}
+
+
+bool CommandListClass::BeginCommandList(unsigned int commandList, OUT RenderDeviceClass*& recorder)
+{
+	recorder = 0;
+	Error("BeginCommandList");
+
+	return false;
+}
+
+
+void CommandListClass::EndCommandList(unsigned int commandList)
+{
+	Error("EndCommandList");
+
+	return;
+}
+
+
+void CommandListClass::ExecuteCommandList(unsigned int commandList)
+{
+	Error("ExecuteCommandList");
+
+	return;
+}
+
+
+void CommandListClass::ReleaseCommandList(unsigned int commandList)
+{
+	Error("ReleaseCommandList");
+
+	return;
+}
+
+// Reset empties the list for the next recording and starts its stats and errors over. The memory is kept for that recording.
+void CommandListClass::Reset()
+{
+	m_commands.clear();
+	m_vertexBufferData.clear();
+	memset(&m_stats, 0, sizeof(m_stats));
+	m_lastError = "";
+
+	return;
+}
+
+// Execute makes every recorded call on device in the order it was recorded.
+void CommandListClass::Execute(RenderDeviceClass* device)
+{
+	const unsigned int* data;
+	size_t i;
+
+
+	for (i = 0; i < m_commands.size(); i++)
+	{
+		const CommandType& command = m_commands[i];
+
+		switch (command.type)
+		{
+		case RENDER_COMMAND_SET_VERTEX_BUFFERS:
+			data = m_vertexBufferData.data() + command.arguments[2];
+			device->SetVertexBuffers(command.arguments[0], command.arguments[1], data, data + command.arguments[1],
+				data + 2 * command.arguments[1]);
+			break;
+		case RENDER_COMMAND_SET_INDEX_BUFFER:
+			device->SetIndexBuffer(command.arguments[0], (DXGI_FORMAT)command.arguments[1], command.arguments[2]);
+			break;
+		case RENDER_COMMAND_SET_SHADER:
+			device->SetShader(command.arguments[0]);
+			break;
+		case RENDER_COMMAND_SET_CONSTANT_BUFFER:
+			device->SetConstantBuffer((RenderShaderStageType)command.arguments[0], command.arguments[1], command.arguments[2],
+				command.arguments[3], command.arguments[4]);
+			break;
+		case RENDER_COMMAND_SET_TEXTURE:
+			device->SetTexture(command.arguments[0], command.arguments[1]);
+			break;
+		case RENDER_COMMAND_DRAW_INDEXED:
+			device->DrawIndexed(command.arguments[0], command.arguments[1], (int)command.arguments[2]);
+			break;
+		case RENDER_COMMAND_DRAW_INDEXED_INSTANCED:
+			device->DrawIndexedInstanced(command.arguments[0], command.arguments[1], command.arguments[2], (int)command.arguments[3],
+				command.arguments[4]);
+			break;
+		}
+	}
+
+	return;
+}
+
+
+int CommandListClass::GetCommandCount()
+{
+	return (int)m_commands.size();
+}
+
+// GetLastError returns the last call that can not be recorded, or an empty string if there was none since the last Reset.
+const char* CommandListClass::GetLastError()
+{
+	return m_lastError;
+}
+
+
+void CommandListClass::Error(const char* call)
+{
+	m_lastError = call;
+	m_stats.errorCount++;
+
+	return;
+}
+
+
+void CommandListClass::Add(RenderCommandType type, unsigned int argument0, unsigned int argument1, unsigned int argument2, unsigned int argument3,
+	unsigned int argument4)
+{
+	CommandType command;
+
+
+	command.type = type;
+	command.arguments[0] = argument0;
+	command.arguments[1] = argument1;
+	command.arguments[2] = argument2;
+	command.arguments[3] = argument3;
+	command.arguments[4] = argument4;
+	m_commands.push_back(command);
+
+	return;
+}
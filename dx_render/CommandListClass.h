@@ -0,0 +1,122 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: commandlistclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _COMMANDLISTCLASS_H_
+#define _COMMANDLISTCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <vector>
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "renderdeviceclass.h"
+
+
+//////////////
+// TYPEDEFS //
+//////////////
+enum RenderCommandType
+{
+	RENDER_COMMAND_SET_VERTEX_BUFFERS,
+	RENDER_COMMAND_SET_INDEX_BUFFER,
+	RENDER_COMMAND_SET_SHADER,
+	RENDER_COMMAND_SET_CONSTANT_BUFFER,
+	RENDER_COMMAND_SET_TEXTURE,
+	RENDER_COMMAND_DRAW_INDEXED,
+	RENDER_COMMAND_DRAW_INDEXED_INSTANCED
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: CommandListClass
+////////////////////////////////////////////////////////////////////////////////
+// The CommandListClass is a render device that draws nothing, it keeps the binds and draws made to it in order so Execute can make
+// them on another device later. It is the command list of the devices that have no deferred context of their own, the null and the
+// software device, and it touches nothing but its own memory, so every thread can record into a list of its own at the same time.
+// Resources can not be made, mapped or released through a list and neither can scenes be begun, those calls are errors and do
+// nothing. Its stats count what was recorded since the last Reset.
+class CommandListClass : public RenderDeviceClass
+{
+public:
+	// The arguments of a command, in order:
+	// set vertex buffers: start slot, count, where the buffers, strides and offsets start in the list's vertex buffer data. set index
+	// buffer: buffer, format, offset. set shader: shader. set constant buffer: stage, slot, buffer, first constant, constant count.
+	// set texture: slot, texture. draw indexed: index count, start index, base vertex. draw indexed instanced: index count, instance
+	// count, start index, base vertex, start instance.
+	struct CommandType
+	{
+		RenderCommandType type;
+		unsigned int arguments[5];
+	};
+
+public:
+	CommandListClass();
+	CommandListClass(const CommandListClass&);
+	~CommandListClass();
+
+	bool Initialize(RenderDeviceClass* device);
+	void Shutdown();
+	CapsType GetCaps();
+
+	bool CreateBuffer(const BufferDescType&, const void* initialData, OUT unsigned int& buffer);
+	void UpdateBuffer(unsigned int buffer, unsigned int offset, const void* data, unsigned int size);
+	void CopyBuffer(unsigned int destination, unsigned int destinationOffset, unsigned int source, unsigned int sourceOffset, unsigned int size);
+	bool MapBuffer(unsigned int buffer, RenderMapType, unsigned int offset, unsigned int size, OUT void*& data);
+	void UnmapBuffer(unsigned int buffer);
+	void ReleaseBuffer(unsigned int buffer);
+
+	bool CreateTexture(const wchar_t* filename, OUT unsigned int& texture);
+	bool CreateTexture(const unsigned char* data, size_t size, OUT unsigned int& texture);
+	void ReleaseTexture(unsigned int texture);
+
+	bool CreateShader(const ShaderDescType&, OUT unsigned int& shader);
+	void ReleaseShader(unsigned int shader);
+
+	bool CreateQuery(OUT unsigned int& query);
+	void EndQuery(unsigned int query);
+	bool IsQueryDone(unsigned int query, bool flush);
+	void ReleaseQuery(unsigned int query);
+
+	void BeginScene(float red, float green, float blue, float alpha);
+	void EndScene();
+
+	void SetVertexBuffers(unsigned int startSlot, unsigned int count, const unsigned int* buffers, const unsigned int* strides,
+		const unsigned int* offsets);
+	void SetIndexBuffer(unsigned int buffer, DXGI_FORMAT format, unsigned int offset);
+	void SetShader(unsigned int shader);
+	void SetConstantBuffer(RenderShaderStageType, unsigned int slot, unsigned int buffer, unsigned int firstConstant, unsigned int constantCount);
+	void SetTexture(unsigned int slot, unsigned int texture);
+	void DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex);
+	void DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int startIndex, int baseVertex,
+		unsigned int startInstance);
+
+	bool CreateCommandList(OUT unsigned int& commandList);
+	bool BeginCommandList(unsigned int commandList, OUT RenderDeviceClass*& recorder);
+	void EndCommandList(unsigned int commandList);
+	void ExecuteCommandList(unsigned int commandList);
+	void ReleaseCommandList(unsigned int commandList);
+
+	void Reset();
+	void Execute(RenderDeviceClass* device);
+	int GetCommandCount();
+	const char* GetLastError();
+
+private:
+	void Error(const char* call);
+	void Add(RenderCommandType, unsigned int argument0, unsigned int argument1, unsigned int argument2, unsigned int argument3,
+		unsigned int argument4);
+
+private:
+	// The device the list is drawn on, whose caps it reports.
+	RenderDeviceClass* m_device;
+
+	std::vector<CommandType> m_commands;
+	std::vector<unsigned int> m_vertexBufferData;
+	const char* m_lastError;
+};
+
+#endif
@@ -0,0 +1,251 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: constantringclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "constantringclass.h"
+#include <cstring>
+
+
+ConstantRingClass::ConstantRingClass()
+{
+	unsigned int i;
+
+
+	m_device = 0;
+	m_buffer = RENDER_HANDLE_NONE;
+	for (i = 0; i < CONSTANT_RING_FRAMES; i++)
+	{
+		m_frameQueries[i] = RENDER_HANDLE_NONE;
+	}
+	m_nextQuery = 0;
+	m_discardNext = true;
+}
+
+
+ConstantRingClass::ConstantRingClass(const ConstantRingClass& other)
+{
+}
+
+
+ConstantRingClass::~ConstantRingClass()
+{
+}
+
+// Initialize creates a ring of size bytes, a multiple of CONSTANT_RING_ALIGNMENT. It fails on a device that can not map a dynamic
+// constant buffer with RENDER_MAP_NO_OVERWRITE or bind part of one, the caller then keeps a buffer per shader.
+bool ConstantRingClass::Initialize(RenderDeviceClass* device, unsigned int size)
+{
+	RenderDeviceClass::CapsType caps;
+	RenderDeviceClass::BufferDescType bufferDesc;
+	bool result;
+	unsigned int i;
+
+
+	caps = device->GetCaps();
+	if (!caps.constantBufferOffsetting || !caps.mapNoOverwriteOnConstantBuffers)
+	{
+		return false;
+	}
+
+	m_device = device;
+
+	if (!m_allocator.Initialize(size, CONSTANT_RING_ALIGNMENT, CONSTANT_RING_FRAMES))
+	{
+		return false;
+	}
+
+	bufferDesc.bind = RENDER_BIND_CONSTANT_BUFFER;
+	bufferDesc.usage = RENDER_USAGE_DYNAMIC;
+	bufferDesc.byteWidth = size;
+
+	result = m_device->CreateBuffer(bufferDesc, 0, m_buffer);
+	if (!result)
+	{
+		return false;
+	}
+
+	for (i = 0; i < CONSTANT_RING_FRAMES; i++)
+	{
+		result = m_device->CreateQuery(m_frameQueries[i]);
+		if (!result)
+		{
+			return false;
+		}
+	}
+
+	m_nextQuery = 0;
+	m_discardNext = true;
+
+	return true;
+}
+
+
+void ConstantRingClass::Shutdown()
+{
+	unsigned int i;
+
+
+	for (i = 0; i < CONSTANT_RING_FRAMES; i++)
+	{
+		if (m_frameQueries[i])
+		{
+			m_device->ReleaseQuery(m_frameQueries[i]);
+			m_frameQueries[i] = RENDER_HANDLE_NONE;
+		}
+	}
+
+	if (m_buffer)
+	{
+		m_device->ReleaseBuffer(m_buffer);
+		m_buffer = RENDER_HANDLE_NONE;
+	}
+
+	m_device = 0;
+
+	m_allocator.Shutdown();
+
+	return;
+}
+
+// BeginFrame retires every frame the GPU has finished since the last one. When the most frames are in flight already it waits for the
+// oldest, which only happens when the CPU is that far ahead of the GPU.
+void ConstantRingClass::BeginFrame()
+{
+	unsigned int query;
+
+
+	while (m_allocator.GetFramesInFlight() > 0)
+	{
+		query = (m_nextQuery + CONSTANT_RING_FRAMES - m_allocator.GetFramesInFlight()) % CONSTANT_RING_FRAMES;
+		if (m_allocator.GetFramesInFlight() < CONSTANT_RING_FRAMES)
+		{
+			if (!m_device->IsQueryDone(m_frameQueries[query], false))
+			{
+				break;
+			}
+		}
+		else
+		{
+			// Asking with a flush hands the commands the query waits on to the GPU, so this can not spin forever.
+			while (!m_device->IsQueryDone(m_frameQueries[query], true))
+			{
+			}
+		}
+
+		m_allocator.RetireFrame();
+	}
+
+	return;
+}
+
+// EndFrame marks where the frame's commands end, the frame's slices are given back once the GPU gets there.
+void ConstantRingClass::EndFrame()
+{
+	m_device->EndQuery(m_frameQueries[m_nextQuery]);
+	m_nextQuery = (m_nextQuery + 1) % CONSTANT_RING_FRAMES;
+	m_allocator.EndFrame();
+
+	return;
+}
+
+// Write copies size bytes of constants into a free slice of the ring and returns where the slice is, in the 16 byte constants
+// SetVertexShaderConstants takes.
+bool ConstantRingClass::Write(const void* data, unsigned int size, OUT unsigned int& firstConstant, OUT unsigned int& constantCount)
+{
+	void* mappedData;
+	bool result;
+	unsigned int offset, alignedSize;
+
+
+	if (!m_allocator.Allocate(size, offset, alignedSize))
+	{
+		// The frames in flight hold the rest of the ring. Fresh memory from a discard holds nothing, so the ring starts over in it.
+		m_allocator.Reset();
+		m_discardNext = true;
+		if (!m_allocator.Allocate(size, offset, alignedSize))
+		{
+			return false;
+		}
+	}
+
+	result = m_device->MapBuffer(m_buffer, m_discardNext ? RENDER_MAP_DISCARD : RENDER_MAP_NO_OVERWRITE, offset, size, mappedData);
+	if (!result)
+	{
+		return false;
+	}
+	m_discardNext = false;
+
+	memcpy(mappedData, data, size);
+
+	m_device->UnmapBuffer(m_buffer);
+
+	firstConstant = offset / 16;
+	constantCount = alignedSize / 16;
+
+	return true;
+}
+
+// WriteArray copies count blocks of size bytes of constants into one slice of the ring, each starting on the alignment so it can be
+// bound on its own, and returns where the first one is and how many constants apart they are. Writing them one Write at a time would
+// not do for constants that have to stay valid together: a Write that finds the ring full discards it, and with it the slices of the
+// Writes before.
+bool ConstantRingClass::WriteArray(const void* data, unsigned int size, unsigned int count, OUT unsigned int& firstConstant,
+	OUT unsigned int& constantStride)
+{
+	void* mappedData;
+	bool result;
+	unsigned int offset, alignedSize, stride, i;
+
+
+	if (count == 0)
+	{
+		return false;
+	}
+
+	// The blocks go into the ring as one range, a full ring starts over in fresh memory the same as for Write.
+	stride = (size + CONSTANT_RING_ALIGNMENT - 1) & ~(CONSTANT_RING_ALIGNMENT - 1);
+	if (!m_allocator.Allocate(stride * count, offset, alignedSize))
+	{
+		m_allocator.Reset();
+		m_discardNext = true;
+		if (!m_allocator.Allocate(stride * count, offset, alignedSize))
+		{
+			return false;
+		}
+	}
+
+	result = m_device->MapBuffer(m_buffer, m_discardNext ? RENDER_MAP_DISCARD : RENDER_MAP_NO_OVERWRITE, offset,
+		stride * (count - 1) + size, mappedData);
+	if (!result)
+	{
+		return false;
+	}
+	m_discardNext = false;
+
+	for (i = 0; i < count; i++)
+	{
+		memcpy((unsigned char*)mappedData + stride * i, (const unsigned char*)data + size * i, size);
+	}
+
+	m_device->UnmapBuffer(m_buffer);
+
+	firstConstant = offset / 16;
+	constantStride = stride / 16;
+
+	return true;
+}
+
+// SetVertexShaderConstants binds a slice Write returned to a constant buffer slot of the vertex shader. Only the writes go through the
+// ring's own device, the bind is made on device, which may be a command list that a worker thread records the draw into.
+void ConstantRingClass::SetVertexShaderConstants(RenderDeviceClass* device, unsigned int slot, unsigned int firstConstant,
+	unsigned int constantCount)
+{
+	device->SetConstantBuffer(RENDER_STAGE_VERTEX, slot, m_buffer, firstConstant, constantCount);
+
+	return;
+}
+
+
+RingAllocatorClass::StatsType ConstantRingClass::GetStats()
+{
+	return m_allocator.GetStats();
+}
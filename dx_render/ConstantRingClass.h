@@ -0,0 +1,63 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: constantringclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _CONSTANTRINGCLASS_H_
+#define _CONSTANTRINGCLASS_H_
+
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "renderdeviceclass.h"
+#include "ringallocatorclass.h"
+
+
+/////////////
+// GLOBALS //
+/////////////
+// Parts of a constant buffer are bound by offsets and sizes in 16 byte constants, and both have to be multiples of 16 constants.
+const unsigned int CONSTANT_RING_ALIGNMENT = 256;
+// How many frames the GPU may still be reading from the ring while the CPU writes the next one.
+const unsigned int CONSTANT_RING_FRAMES = 3;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: ConstantRingClass
+////////////////////////////////////////////////////////////////////////////////
+// The ConstantRingClass keeps the constants of every draw of a frame in one large dynamic constant buffer. Each Write maps it with
+// RENDER_MAP_NO_OVERWRITE, which promises the driver not to touch anything the GPU may still read, so it neither renames the
+// buffer nor waits, and the draw binds only its slice. A RingAllocatorClass decides where each slice goes and an event query per
+// frame tells it when the GPU is done with a frame's slices.
+// When a frame needs more than the ring has left the buffer is mapped with RENDER_MAP_DISCARD once, which hands out fresh
+// memory, and the ring starts over in it. It needs a device whose caps allow offsetting and mapping constant buffers this way.
+class ConstantRingClass
+{
+public:
+	ConstantRingClass();
+	ConstantRingClass(const ConstantRingClass&);
+	~ConstantRingClass();
+
+	bool Initialize(RenderDeviceClass*, unsigned int size);
+	void Shutdown();
+
+	void BeginFrame();
+	void EndFrame();
+
+	bool Write(const void* data, unsigned int size, OUT unsigned int& firstConstant, OUT unsigned int& constantCount);
+	bool WriteArray(const void* data, unsigned int size, unsigned int count, OUT unsigned int& firstConstant,
+		OUT unsigned int& constantStride);
+	void SetVertexShaderConstants(RenderDeviceClass*, unsigned int slot, unsigned int firstConstant, unsigned int constantCount);
+	RingAllocatorClass::StatsType GetStats();
+
+private:
+	RenderDeviceClass* m_device;
+	unsigned int m_buffer;
+	unsigned int m_frameQueries[CONSTANT_RING_FRAMES];
+	unsigned int m_nextQuery;
+	RingAllocatorClass m_allocator;
+
+	// A dynamic buffer has to be mapped with RENDER_MAP_DISCARD the first time, and again after every time the ring was full.
+	bool m_discardNext;
+};
+
+#endif
@@ -0,0 +1,332 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: d3ddeferredcontextclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "d3ddeferredcontextclass.h"
+#include "d3drenderdeviceclass.h"
+
+
+D3DDeferredContextClass::D3DDeferredContextClass()
+{
+	m_device = 0;
+	m_deviceContext = 0;
+	m_deviceContext1 = 0;
+}
+
+
+D3DDeferredContextClass::D3DDeferredContextClass(const D3DDeferredContextClass& other)
+{
+}
+
+
+D3DDeferredContextClass::~D3DDeferredContextClass()
+{
+}
+
+// Initialize makes the deferred context on the Direct3D device of device. Parts of constant buffers are bound through its Direct3D
+// 11.1 interface, like on the immediate context.
+bool D3DDeferredContextClass::Initialize(D3DRenderDeviceClass* device, ID3D11Device* d3dDevice)
+{
+	HRESULT result;
+
+
+	m_device = device;
+
+	result = d3dDevice->CreateDeferredContext(0, &m_deviceContext);
+	if (FAILED(result))
+	{
+		return false;
+	}
+
+	if (FAILED(m_deviceContext->QueryInterface(__uuidof(ID3D11DeviceContext1), (void**)&m_deviceContext1)))
+	{
+		m_deviceContext1 = 0;
+	}
+
+	return true;
+}
+
+
+void D3DDeferredContextClass::Shutdown()
+{
+	if (m_deviceContext1)
+	{
+		m_deviceContext1->Release();
+		m_deviceContext1 = 0;
+	}
+
+	if (m_deviceContext)
+	{
+		m_deviceContext->Release();
+		m_deviceContext = 0;
+	}
+	m_device = 0;
+
+	return;
+}
+
+
+ID3D11DeviceContext* D3DDeferredContextClass::GetDeviceContext()
+{
+	return m_deviceContext;
+}
+
+
+RenderDeviceClass::CapsType D3DDeferredContextClass::GetCaps()
+{
+	return m_device->GetCaps();
+}
+
+
+bool D3DDeferredContextClass::CreateBuffer(const BufferDescType& desc, const void* initialData, OUT unsigned int& buffer)
+{
+	buffer = RENDER_HANDLE_NONE;
+	m_stats.errorCount++;
+
+	return false;
+}
+
+
+void D3DDeferredContextClass::UpdateBuffer(unsigned int buffer, unsigned int offset, const void* data, unsigned int size)
+{
+	m_stats.errorCount++;
+
+	return;
+}
+
+
+void D3DDeferredContextClass::CopyBuffer(unsigned int destination, unsigned int destinationOffset, unsigned int source,
+	unsigned int sourceOffset, unsigned int size)
+{
+	m_stats.errorCount++;
+
+	return;
+}
+
+
+bool D3DDeferredContextClass::MapBuffer(unsigned int buffer, RenderMapType mapType, unsigned int offset, unsigned int size, OUT void*& data)
+{
+	data = 0;
+	m_stats.errorCount++;
+
+	return false;
+}
+
+
+void D3DDeferredContextClass::UnmapBuffer(unsigned int buffer)
+{
+	m_stats.errorCount++;
+
+	return;
+}
+
+
+void D3DDeferredContextClass::ReleaseBuffer(unsigned int buffer)
+{
+	m_stats.errorCount++;
+
+	return;
+}
+
+
+bool D3DDeferredContextClass::CreateTexture(const wchar_t* filename, OUT unsigned int& texture)
+{
+	texture = RENDER_HANDLE_NONE;
+	m_stats.errorCount++;
+
+	return false;
+}
+
+
+bool D3DDeferredContextClass::CreateTexture(const unsigned char* data, size_t size, OUT unsigned int& texture)
+{
+	texture = RENDER_HANDLE_NONE;
+	m_stats.errorCount++;
+
+	return false;
+}
+
+
+void D3DDeferredContextClass::ReleaseTexture(unsigned int texture)
+{
+	m_stats.errorCount++;
+
+	return;
+}
+
+
+bool D3DDeferredContextClass::CreateShader(const ShaderDescType& desc, OUT unsigned int& shader)
+{
+	shader = RENDER_HANDLE_NONE;
+	m_stats.errorCount++;
+
+	return false;
+}
+
+
+void D3DDeferredContextClass::ReleaseShader(unsigned int shader)
+{
+	m_stats.errorCount++;
+
+	return;
+}
+
+
+bool D3DDeferredContextClass::CreateQuery(OUT unsigned int& query)
+{
+	query = RENDER_HANDLE_NONE;
+	m_stats.errorCount++;
+
+	return false;
+}
+
+
+void D3DDeferredContextClass::EndQuery(unsigned int query)
+{
+	m_stats.errorCount++;
+
+	return;
+}
+
+
+bool D3DDeferredContextClass::IsQueryDone(unsigned int query, bool flush)
+{
+	m_stats.errorCount++;
+
+	return false;
+}
+
+
+void D3DDeferredContextClass::ReleaseQuery(unsigned int query)
+{
+	m_stats.errorCount++;
+
+	return;
+}
+
+
+void D3DDeferredContextClass::BeginScene(float red, float green, float blue, float alpha)
+{
+	m_stats.errorCount++;
+
+	return;
+}
+
+
+void D3DDeferredContextClass::EndScene()
+{
+	m_stats.errorCount++;
+
+	return;
+}
+
+
+void D3DDeferredContextClass::SetVertexBuffers(unsigned int startSlot, unsigned int count, const unsigned int* buffers,
+	const unsigned int* strides, const unsigned int* offsets)
+{
+	m_device->BindVertexBuffers(m_deviceContext, startSlot, count, buffers, strides, offsets);
+	m_stats.bindCount++;
+
+	return;
+}
+
+
+void D3DDeferredContextClass::SetIndexBuffer(unsigned int buffer, DXGI_FORMAT format, unsigned int offset)
+{
+	m_device->BindIndexBuffer(m_deviceContext, buffer, format, offset);
+	m_stats.bindCount++;
+
+	return;
+}
+
+
+void D3DDeferredContextClass::SetShader(unsigned int shader)
+{
+	m_device->BindShader(m_deviceContext, shader);
+	m_stats.bindCount++;
+
+	return;
+}
+
+
+void D3DDeferredContextClass::SetConstantBuffer(RenderShaderStageType stage, unsigned int slot, unsigned int buffer, unsigned int firstConstant,
+	unsigned int constantCount)
+{
+	m_device->BindConstantBuffer(m_deviceContext, m_deviceContext1, stage, slot, buffer, firstConstant, constantCount);
+	m_stats.bindCount++;
+
+	return;
+}
+
+
+void D3DDeferredContextClass::SetTexture(unsigned int slot, unsigned int texture)
+{
+	m_device->BindTexture(m_deviceContext, slot, texture);
+	m_stats.bindCount++;
+
+	return;
+}
+
+
+void D3DDeferredContextClass::DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex)
+{
+	m_deviceContext->DrawIndexed(indexCount, startIndex, baseVertex);
+	m_stats.drawCount++;
+	m_stats.instanceCount++;
+	m_stats.indexCount += indexCount;
+
+	return;
+}
+
+
+void D3DDeferredContextClass::DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int startIndex,
+	int baseVertex, unsigned int startInstance)
+{
+	m_deviceContext->DrawIndexedInstanced(indexCount, instanceCount, startIndex, baseVertex, startInstance);
+	m_stats.drawCount++;
+	m_stats.instanceCount += instanceCount;
+	m_stats.indexCount += (unsigned long long)indexCount * instanceCount;
+
+	return;
+}
+
+// A deferred context can not execute command lists here, the renderer only ever executes them on the immediate context.
+bool D3DDeferredContextClass::CreateCommandList(OUT unsigned int& commandList)
+{
+	commandList = RENDER_HANDLE_NONE;
+	m_stats.errorCount++;
+
+	return false;
+}
+
+
+bool D3DDeferredContextClass::BeginCommandList(unsigned int commandList, OUT RenderDeviceClass*& recorder)
+{
+	recorder = 0;
+	m_stats.errorCount++;
+
+	return false;
+}
+
+
+void D3DDeferredContextClass::EndCommandList(unsigned int commandList)
+{
+	m_stats.errorCount++;
+
+	return;
+}
+
+
+void D3DDeferredContextClass::ExecuteCommandList(unsigned int commandList)
+{
+	m_stats.errorCount++;
+
+	return;
+}
+
+
+void D3DDeferredContextClass::ReleaseCommandList(unsigned int commandList)
+{
+	m_stats.errorCount++;
+
+	return;
+}
@@ -0,0 +1,85 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: d3ddeferredcontextclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _D3DDEFERREDCONTEXTCLASS_H_
+#define _D3DDEFERREDCONTEXTCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <d3d11_1.h>
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "renderdeviceclass.h"
+
+
+class D3DRenderDeviceClass;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: D3DDeferredContextClass
+////////////////////////////////////////////////////////////////////////////////
+// The D3DDeferredContextClass is what a D3DRenderDeviceClass hands out to record one of its command lists: the binds and draws made
+// to it go to a Direct3D deferred context of its own, with the handles looked up in the tables of the device that made it. Those
+// tables are only read, so the threads recording lists do not get in each other's way. Everything else is an error and does nothing.
+// Its stats count what was recorded since the list was begun, the device adds them to its own when it executes the list.
+class D3DDeferredContextClass : public RenderDeviceClass
+{
+public:
+	D3DDeferredContextClass();
+	D3DDeferredContextClass(const D3DDeferredContextClass&);
+	~D3DDeferredContextClass();
+
+	bool Initialize(D3DRenderDeviceClass* device, ID3D11Device*);
+	void Shutdown();
+	ID3D11DeviceContext* GetDeviceContext();
+	CapsType GetCaps();
+
+	bool CreateBuffer(const BufferDescType&, const void* initialData, OUT unsigned int& buffer);
+	void UpdateBuffer(unsigned int buffer, unsigned int offset, const void* data, unsigned int size);
+	void CopyBuffer(unsigned int destination, unsigned int destinationOffset, unsigned int source, unsigned int sourceOffset, unsigned int size);
+	bool MapBuffer(unsigned int buffer, RenderMapType, unsigned int offset, unsigned int size, OUT void*& data);
+	void UnmapBuffer(unsigned int buffer);
+	void ReleaseBuffer(unsigned int buffer);
+
+	bool CreateTexture(const wchar_t* filename, OUT unsigned int& texture);
+	bool CreateTexture(const unsigned char* data, size_t size, OUT unsigned int& texture);
+	void ReleaseTexture(unsigned int texture);
+
+	bool CreateShader(const ShaderDescType&, OUT unsigned int& shader);
+	void ReleaseShader(unsigned int shader);
+
+	bool CreateQuery(OUT unsigned int& query);
+	void EndQuery(unsigned int query);
+	bool IsQueryDone(unsigned int query, bool flush);
+	void ReleaseQuery(unsigned int query);
+
+	void BeginScene(float red, float green, float blue, float alpha);
+	void EndScene();
+
+	void SetVertexBuffers(unsigned int startSlot, unsigned int count, const unsigned int* buffers, const unsigned int* strides,
+		const unsigned int* offsets);
+	void SetIndexBuffer(unsigned int buffer, DXGI_FORMAT format, unsigned int offset);
+	void SetShader(unsigned int shader);
+	void SetConstantBuffer(RenderShaderStageType, unsigned int slot, unsigned int buffer, unsigned int firstConstant, unsigned int constantCount);
+	void SetTexture(unsigned int slot, unsigned int texture);
+	void DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex);
+	void DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int startIndex, int baseVertex,
+		unsigned int startInstance);
+
+	bool CreateCommandList(OUT unsigned int& commandList);
+	bool BeginCommandList(unsigned int commandList, OUT RenderDeviceClass*& recorder);
+	void EndCommandList(unsigned int commandList);
+	void ExecuteCommandList(unsigned int commandList);
+	void ReleaseCommandList(unsigned int commandList);
+
+private:
+	D3DRenderDeviceClass* m_device;
+	ID3D11DeviceContext* m_deviceContext;
+	ID3D11DeviceContext1* m_deviceContext1;
+};
+
+#endif
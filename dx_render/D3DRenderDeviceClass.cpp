@@ -0,0 +1,949 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: d3drenderdeviceclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "d3drenderdeviceclass.h"
+#include <DDSTextureLoader.h>
+#include <WICTextureLoader.h>
+#include <cstring>
+#include <cwchar>
+#include <fstream>
+
+using namespace std;
+
+
+D3DRenderDeviceClass::D3DRenderDeviceClass()
+{
+	m_D3D = 0;
+	m_hwnd = 0;
+	m_device = 0;
+	m_deviceContext = 0;
+	m_deviceContext1 = 0;
+	m_sampleState = 0;
+	memset(&m_caps, 0, sizeof(m_caps));
+}
+
+
+D3DRenderDeviceClass::D3DRenderDeviceClass(const D3DRenderDeviceClass& other)
+{
+}
+
+
+D3DRenderDeviceClass::~D3DRenderDeviceClass()
+{
+}
+
+// Initialize uses the device and context of an initialized D3DClass, which keeps owning them. Shader errors are shown over hwnd.
+bool D3DRenderDeviceClass::Initialize(D3DClass* d3d, HWND hwnd)
+{
+	D3D11_FEATURE_DATA_D3D11_OPTIONS options;
+	D3D11_SAMPLER_DESC samplerDesc;
+	HRESULT result;
+
+
+	m_D3D = d3d;
+	m_hwnd = hwnd;
+	m_device = d3d->GetDevice();
+	m_deviceContext = d3d->GetDeviceContext();
+
+	// Binding part of a constant buffer needs the Direct3D 11.1 context and a driver that supports it.
+	memset(&options, 0, sizeof(options));
+	result = m_device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options));
+	if (SUCCEEDED(result) && SUCCEEDED(m_deviceContext->QueryInterface(__uuidof(ID3D11DeviceContext1), (void**)&m_deviceContext1)))
+	{
+		m_caps.constantBufferOffsetting = options.ConstantBufferOffsetting != 0;
+		m_caps.mapNoOverwriteOnConstantBuffers = options.MapNoOverwriteOnDynamicConstantBuffer != 0;
+	}
+
+	// Every shader samples through one linear sampler that wraps the texture coordinates.
+	samplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+	samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_WRAP;
+	samplerDesc.AddressV = D3D11_TEXTURE_ADDRESS_WRAP;
+	samplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_WRAP;
+	samplerDesc.MipLODBias = 0.0f;
+	samplerDesc.MaxAnisotropy = 1;
+	samplerDesc.ComparisonFunc = D3D11_COMPARISON_ALWAYS;
+	samplerDesc.BorderColor[0] = 0;
+	samplerDesc.BorderColor[1] = 0;
+	samplerDesc.BorderColor[2] = 0;
+	samplerDesc.BorderColor[3] = 0;
+	samplerDesc.MinLOD = 0;
+	samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
+
+	result = m_device->CreateSamplerState(&samplerDesc, &m_sampleState);
+	if (FAILED(result))
+	{
+		return false;
+	}
+
+	// Everything is drawn as triangle lists.
+	SetFixedState(m_deviceContext);
+
+	return true;
+}
+
+// Shutdown releases whatever the renderer did not, and the sampler. The device and context belong to the D3DClass.
+void D3DRenderDeviceClass::Shutdown()
+{
+	size_t i;
+
+
+	for (i = 0; i < m_buffers.size(); i++)
+	{
+		if (m_buffers[i].buffer)
+		{
+			m_buffers[i].buffer->Release();
+		}
+	}
+	for (i = 0; i < m_textures.size(); i++)
+	{
+		if (m_textures[i])
+		{
+			m_textures[i]->Release();
+		}
+	}
+	for (i = 0; i < m_shaders.size(); i++)
+	{
+		if (m_shaders[i].layout)
+		{
+			m_shaders[i].layout->Release();
+			m_shaders[i].pixelShader->Release();
+			m_shaders[i].vertexShader->Release();
+		}
+	}
+	for (i = 0; i < m_queries.size(); i++)
+	{
+		if (m_queries[i])
+		{
+			m_queries[i]->Release();
+		}
+	}
+	for (i = 0; i < m_commandLists.size(); i++)
+	{
+		if (m_commandLists[i].commandList)
+		{
+			m_commandLists[i].commandList->Release();
+		}
+		if (m_commandLists[i].recorder)
+		{
+			m_commandLists[i].recorder->Shutdown();
+			delete m_commandLists[i].recorder;
+		}
+	}
+	m_buffers.clear();
+	m_textures.clear();
+	m_shaders.clear();
+	m_queries.clear();
+	m_commandLists.clear();
+	m_freeBuffers.clear();
+	m_freeTextures.clear();
+	m_freeShaders.clear();
+	m_freeQueries.clear();
+	m_freeCommandLists.clear();
+
+	if (m_sampleState)
+	{
+		m_sampleState->Release();
+		m_sampleState = 0;
+	}
+
+	if (m_deviceContext1)
+	{
+		m_deviceContext1->Release();
+		m_deviceContext1 = 0;
+	}
+
+	m_deviceContext = 0;
+	m_device = 0;
+	m_D3D = 0;
+
+	return;
+}
+
+
+RenderDeviceClass::CapsType D3DRenderDeviceClass::GetCaps()
+{
+	return m_caps;
+}
+
+
+bool D3DRenderDeviceClass::CreateBuffer(const BufferDescType& desc, const void* initialData, OUT unsigned int& buffer)
+{
+	D3D11_BUFFER_DESC bufferDesc;
+	D3D11_SUBRESOURCE_DATA data;
+	BufferType record;
+	unsigned int index;
+	HRESULT result;
+
+
+	buffer = RENDER_HANDLE_NONE;
+
+	bufferDesc.Usage = (desc.usage == RENDER_USAGE_DYNAMIC) ? D3D11_USAGE_DYNAMIC : D3D11_USAGE_DEFAULT;
+	bufferDesc.ByteWidth = desc.byteWidth;
+	switch (desc.bind)
+	{
+	case RENDER_BIND_INDEX_BUFFER:
+		bufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+		break;
+	case RENDER_BIND_CONSTANT_BUFFER:
+		bufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+		break;
+	default:
+		bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+		break;
+	}
+	bufferDesc.CPUAccessFlags = (desc.usage == RENDER_USAGE_DYNAMIC) ? D3D11_CPU_ACCESS_WRITE : 0;
+	bufferDesc.MiscFlags = 0;
+	bufferDesc.StructureByteStride = 0;
+
+	data.pSysMem = initialData;
+	data.SysMemPitch = 0;
+	data.SysMemSlicePitch = 0;
+
+	result = m_device->CreateBuffer(&bufferDesc, initialData ? &data : NULL, &record.buffer);
+	if (FAILED(result))
+	{
+		return false;
+	}
+	record.byteWidth = desc.byteWidth;
+
+	if (!m_freeBuffers.empty())
+	{
+		index = m_freeBuffers.back();
+		m_freeBuffers.pop_back();
+		m_buffers[index] = record;
+	}
+	else
+	{
+		index = (unsigned int)m_buffers.size();
+		m_buffers.push_back(record);
+	}
+	buffer = index + 1;
+
+	if (initialData)
+	{
+		m_stats.uploadBytes += desc.byteWidth;
+	}
+	m_stats.bufferCount++;
+	m_stats.bufferBytes += desc.byteWidth;
+
+	return true;
+}
+
+// UpdateBuffer writes a byte range of a default buffer. Buffers are one dimensional, only the left and right of the box matter.
+void D3DRenderDeviceClass::UpdateBuffer(unsigned int buffer, unsigned int offset, const void* data, unsigned int size)
+{
+	D3D11_BOX box;
+
+
+	box.left = offset;
+	box.right = offset + size;
+	box.top = 0;
+	box.bottom = 1;
+	box.front = 0;
+	box.back = 1;
+	m_deviceContext->UpdateSubresource(m_buffers[buffer - 1].buffer, 0, &box, data, 0, 0);
+
+	m_stats.updateCount++;
+	m_stats.uploadBytes += size;
+
+	return;
+}
+
+
+void D3DRenderDeviceClass::CopyBuffer(unsigned int destination, unsigned int destinationOffset, unsigned int source, unsigned int sourceOffset,
+	unsigned int size)
+{
+	D3D11_BOX box;
+
+
+	box.left = sourceOffset;
+	box.right = sourceOffset + size;
+	box.top = 0;
+	box.bottom = 1;
+	box.front = 0;
+	box.back = 1;
+	m_deviceContext->CopySubresourceRegion(m_buffers[destination - 1].buffer, 0, destinationOffset, 0, 0, m_buffers[source - 1].buffer, 0, &box);
+
+	m_stats.copyCount++;
+	m_stats.copyBytes += size;
+
+	return;
+}
+
+// MapBuffer maps the whole buffer, Direct3D 11 can not map less, and returns where the range starts in it.
+bool D3DRenderDeviceClass::MapBuffer(unsigned int buffer, RenderMapType mapType, unsigned int offset, unsigned int size, OUT void*& data)
+{
+	D3D11_MAPPED_SUBRESOURCE mappedResource;
+	HRESULT result;
+
+
+	data = 0;
+	result = m_deviceContext->Map(m_buffers[buffer - 1].buffer, 0, (mapType == RENDER_MAP_DISCARD) ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE,
+		0, &mappedResource);
+	if (FAILED(result))
+	{
+		return false;
+	}
+	data = (unsigned char*)mappedResource.pData + offset;
+
+	m_stats.mapCount++;
+	m_stats.uploadBytes += size;
+
+	return true;
+}
+
+
+void D3DRenderDeviceClass::UnmapBuffer(unsigned int buffer)
+{
+	m_deviceContext->Unmap(m_buffers[buffer - 1].buffer, 0);
+
+	return;
+}
+
+
+void D3DRenderDeviceClass::ReleaseBuffer(unsigned int buffer)
+{
+	m_stats.bufferCount--;
+	m_stats.bufferBytes -= m_buffers[buffer - 1].byteWidth;
+
+	m_buffers[buffer - 1].buffer->Release();
+	m_buffers[buffer - 1].buffer = 0;
+	m_freeBuffers.push_back(buffer - 1);
+
+	return;
+}
+
+// CreateTexture loads DDS files as they are, other formats such as the PNG and JPEG images glTF models reference are decoded through WIC.
+bool D3DRenderDeviceClass::CreateTexture(const wchar_t* filename, OUT unsigned int& texture)
+{
+	ID3D11ShaderResourceView* view;
+	const wchar_t* extension;
+	HRESULT result;
+
+
+	texture = RENDER_HANDLE_NONE;
+	view = 0;
+
+	extension = wcsrchr(filename, L'.');
+	if (extension && _wcsicmp(extension, L".dds") != 0)
+	{
+		result = CreateWICTextureFromFile(m_device, filename, nullptr, &view);
+	}
+	else
+	{
+		result = CreateDDSTextureFromFile(m_device, filename, nullptr, &view);
+	}
+	if (FAILED(result))
+	{
+		return false;
+	}
+
+	texture = AddTexture(view);
+
+	return true;
+}
+
+// This CreateTexture loads an image file held in memory, such as an image embedded in a .glb file.
+bool D3DRenderDeviceClass::CreateTexture(const unsigned char* data, size_t size, OUT unsigned int& texture)
+{
+	ID3D11ShaderResourceView* view;
+	HRESULT result;
+
+
+	texture = RENDER_HANDLE_NONE;
+	view = 0;
+
+	if (size >= 4 && memcmp(data, "DDS ", 4) == 0)
+	{
+		result = CreateDDSTextureFromMemory(m_device, data, size, nullptr, &view);
+	}
+	else
+	{
+		result = CreateWICTextureFromMemory(m_device, data, size, nullptr, &view);
+	}
+	if (FAILED(result))
+	{
+		return false;
+	}
+
+	texture = AddTexture(view);
+	m_stats.uploadBytes += size;
+
+	return true;
+}
+
+
+void D3DRenderDeviceClass::ReleaseTexture(unsigned int texture)
+{
+	m_stats.textureCount--;
+
+	m_textures[texture - 1]->Release();
+	m_textures[texture - 1] = 0;
+	m_freeTextures.push_back(texture - 1);
+
+	return;
+}
+
+// CreateShader compiles the vertex and pixel shader files and creates the input layout of the vertices the vertex shader reads.
+bool D3DRenderDeviceClass::CreateShader(const ShaderDescType& desc, OUT unsigned int& shader)
+{
+	ID3D10Blob* vertexShaderBuffer;
+	ID3D10Blob* pixelShaderBuffer;
+	std::vector<D3D11_INPUT_ELEMENT_DESC> layout;
+	ShaderType record;
+	unsigned int index, i;
+	HRESULT result;
+
+
+	shader = RENDER_HANDLE_NONE;
+
+	if (!CompileShader(desc.vertexShaderFile, desc.vertexEntryPoint, "vs_5_0", vertexShaderBuffer))
+	{
+		return false;
+	}
+
+	if (!CompileShader(desc.pixelShaderFile, desc.pixelEntryPoint, "ps_5_0", pixelShaderBuffer))
+	{
+		vertexShaderBuffer->Release();
+		return false;
+	}
+
+	layout.resize(desc.elementCount);
+	for (i = 0; i < desc.elementCount; i++)
+	{
+		layout[i].SemanticName = desc.layout[i].semantic;
+		layout[i].SemanticIndex = desc.layout[i].semanticIndex;
+		layout[i].Format = desc.layout[i].format;
+		layout[i].InputSlot = desc.layout[i].slot;
+		layout[i].AlignedByteOffset = desc.layout[i].offset;
+		layout[i].InputSlotClass = desc.layout[i].perInstance ? D3D11_INPUT_PER_INSTANCE_DATA : D3D11_INPUT_PER_VERTEX_DATA;
+		layout[i].InstanceDataStepRate = desc.layout[i].perInstance ? 1 : 0;
+	}
+
+	record.vertexShader = 0;
+	record.pixelShader = 0;
+	record.layout = 0;
+	result = m_device->CreateVertexShader(vertexShaderBuffer->GetBufferPointer(), vertexShaderBuffer->GetBufferSize(), NULL, &record.vertexShader);
+	if (SUCCEEDED(result))
+	{
+		result = m_device->CreatePixelShader(pixelShaderBuffer->GetBufferPointer(), pixelShaderBuffer->GetBufferSize(), NULL, &record.pixelShader);
+	}
+	if (SUCCEEDED(result))
+	{
+		result = m_device->CreateInputLayout(layout.data(), desc.elementCount, vertexShaderBuffer->GetBufferPointer(),
+			vertexShaderBuffer->GetBufferSize(), &record.layout);
+	}
+
+	// Release the vertex shader buffer and pixel shader buffer since they are no longer needed.
+	vertexShaderBuffer->Release();
+	pixelShaderBuffer->Release();
+
+	if (FAILED(result))
+	{
+		if (record.pixelShader)
+		{
+			record.pixelShader->Release();
+		}
+		if (record.vertexShader)
+		{
+			record.vertexShader->Release();
+		}
+		return false;
+	}
+
+	if (!m_freeShaders.empty())
+	{
+		index = m_freeShaders.back();
+		m_freeShaders.pop_back();
+		m_shaders[index] = record;
+	}
+	else
+	{
+		index = (unsigned int)m_shaders.size();
+		m_shaders.push_back(record);
+	}
+	shader = index + 1;
+	m_stats.shaderCount++;
+
+	return true;
+}
+
+
+void D3DRenderDeviceClass::ReleaseShader(unsigned int shader)
+{
+	ShaderType& record = m_shaders[shader - 1];
+
+
+	m_stats.shaderCount--;
+
+	record.layout->Release();
+	record.pixelShader->Release();
+	record.vertexShader->Release();
+	record.layout = 0;
+	record.pixelShader = 0;
+	record.vertexShader = 0;
+	m_freeShaders.push_back(shader - 1);
+
+	return;
+}
+
+// CreateQuery makes an event query, which is done once the GPU has run every command issued before it was ended.
+bool D3DRenderDeviceClass::CreateQuery(OUT unsigned int& query)
+{
+	D3D11_QUERY_DESC queryDesc;
+	ID3D11Query* record;
+	unsigned int index;
+	HRESULT result;
+
+
+	query = RENDER_HANDLE_NONE;
+
+	queryDesc.Query = D3D11_QUERY_EVENT;
+	queryDesc.MiscFlags = 0;
+	result = m_device->CreateQuery(&queryDesc, &record);
+	if (FAILED(result))
+	{
+		return false;
+	}
+
+	if (!m_freeQueries.empty())
+	{
+		index = m_freeQueries.back();
+		m_freeQueries.pop_back();
+		m_queries[index] = record;
+	}
+	else
+	{
+		index = (unsigned int)m_queries.size();
+		m_queries.push_back(record);
+	}
+	query = index + 1;
+	m_stats.queryCount++;
+
+	return true;
+}
+
+
+void D3DRenderDeviceClass::EndQuery(unsigned int query)
+{
+	m_deviceContext->End(m_queries[query - 1]);
+
+	return;
+}
+
+// IsQueryDone only looks without flush. With flush it hands the commands the query waits on to the GPU, so polling it eventually succeeds.
+bool D3DRenderDeviceClass::IsQueryDone(unsigned int query, bool flush)
+{
+	return m_deviceContext->GetData(m_queries[query - 1], NULL, 0, flush ? 0 : D3D11_ASYNC_GETDATA_DONOTFLUSH) == S_OK;
+}
+
+
+void D3DRenderDeviceClass::ReleaseQuery(unsigned int query)
+{
+	m_stats.queryCount--;
+
+	m_queries[query - 1]->Release();
+	m_queries[query - 1] = 0;
+	m_freeQueries.push_back(query - 1);
+
+	return;
+}
+
+
+void D3DRenderDeviceClass::BeginScene(float red, float green, float blue, float alpha)
+{
+	m_D3D->BeginScene(red, green, blue, alpha);
+
+	return;
+}
+
+
+void D3DRenderDeviceClass::EndScene()
+{
+	m_D3D->EndScene();
+	m_stats.frameCount++;
+
+	return;
+}
+
+
+void D3DRenderDeviceClass::SetVertexBuffers(unsigned int startSlot, unsigned int count, const unsigned int* buffers, const unsigned int* strides,
+	const unsigned int* offsets)
+{
+	BindVertexBuffers(m_deviceContext, startSlot, count, buffers, strides, offsets);
+	m_stats.bindCount++;
+
+	return;
+}
+
+
+void D3DRenderDeviceClass::SetIndexBuffer(unsigned int buffer, DXGI_FORMAT format, unsigned int offset)
+{
+	BindIndexBuffer(m_deviceContext, buffer, format, offset);
+	m_stats.bindCount++;
+
+	return;
+}
+
+
+void D3DRenderDeviceClass::SetShader(unsigned int shader)
+{
+	BindShader(m_deviceContext, shader);
+	m_stats.bindCount++;
+
+	return;
+}
+
+
+void D3DRenderDeviceClass::SetConstantBuffer(RenderShaderStageType stage, unsigned int slot, unsigned int buffer, unsigned int firstConstant,
+	unsigned int constantCount)
+{
+	BindConstantBuffer(m_deviceContext, m_deviceContext1, stage, slot, buffer, firstConstant, constantCount);
+	m_stats.bindCount++;
+
+	return;
+}
+
+
+void D3DRenderDeviceClass::SetTexture(unsigned int slot, unsigned int texture)
+{
+	BindTexture(m_deviceContext, slot, texture);
+	m_stats.bindCount++;
+
+	return;
+}
+
+
+void D3DRenderDeviceClass::DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex)
+{
+	m_deviceContext->DrawIndexed(indexCount, startIndex, baseVertex);
+	m_stats.drawCount++;
+	m_stats.instanceCount++;
+	m_stats.indexCount += indexCount;
+
+	return;
+}
+
+
+void D3DRenderDeviceClass::DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int startIndex, int baseVertex,
+	unsigned int startInstance)
+{
+	m_deviceContext->DrawIndexedInstanced(indexCount, instanceCount, startIndex, baseVertex, startInstance);
+	m_stats.drawCount++;
+	m_stats.instanceCount += instanceCount;
+	m_stats.indexCount += (unsigned long long)indexCount * instanceCount;
+
+	return;
+}
+
+// CreateCommandList makes the deferred context the list records on.
+bool D3DRenderDeviceClass::CreateCommandList(OUT unsigned int& commandList)
+{
+	CommandListType record;
+	unsigned int index;
+	bool result;
+
+
+	commandList = RENDER_HANDLE_NONE;
+
+	record.recorder = new D3DDeferredContextClass;
+	if (!record.recorder)
+	{
+		return false;
+	}
+	record.commandList = 0;
+
+	result = record.recorder->Initialize(this, m_device);
+	if (!result)
+	{
+		record.recorder->Shutdown();
+		delete record.recorder;
+		return false;
+	}
+
+	if (!m_freeCommandLists.empty())
+	{
+		index = m_freeCommandLists.back();
+		m_freeCommandLists.pop_back();
+		m_commandLists[index] = record;
+	}
+	else
+	{
+		index = (unsigned int)m_commandLists.size();
+		m_commandLists.push_back(record);
+	}
+	commandList = index + 1;
+
+	return true;
+}
+
+// BeginCommandList is called on the thread that records. A deferred context starts out with nothing bound, not even the back buffer,
+// so the state every draw shares is bound first. A list that was recorded and never executed is thrown away.
+bool D3DRenderDeviceClass::BeginCommandList(unsigned int commandList, OUT RenderDeviceClass*& recorder)
+{
+	CommandListType& record = m_commandLists[commandList - 1];
+
+
+	if (record.commandList)
+	{
+		record.commandList->Release();
+		record.commandList = 0;
+	}
+
+	record.recorder->ResetStats();
+	SetFixedState(record.recorder->GetDeviceContext());
+	recorder = record.recorder;
+
+	return true;
+}
+
+// EndCommandList turns what the deferred context recorded into a Direct3D command list, and leaves the context empty for the next one.
+void D3DRenderDeviceClass::EndCommandList(unsigned int commandList)
+{
+	CommandListType& record = m_commandLists[commandList - 1];
+
+
+	if (FAILED(record.recorder->GetDeviceContext()->FinishCommandList(FALSE, &record.commandList)))
+	{
+		record.commandList = 0;
+	}
+
+	return;
+}
+
+// ExecuteCommandList does not have Direct3D save and restore the state of the immediate context around the list, that costs more
+// than binding it again. Executing leaves the context cleared, so only the state no call of the device binds is put back.
+void D3DRenderDeviceClass::ExecuteCommandList(unsigned int commandList)
+{
+	CommandListType& record = m_commandLists[commandList - 1];
+	StatsType recorded;
+
+
+	if (!record.commandList)
+	{
+		return;
+	}
+
+	m_deviceContext->ExecuteCommandList(record.commandList, FALSE);
+	record.commandList->Release();
+	record.commandList = 0;
+	SetFixedState(m_deviceContext);
+
+	recorded = record.recorder->GetStats();
+	m_stats.drawCount += recorded.drawCount;
+	m_stats.instanceCount += recorded.instanceCount;
+	m_stats.indexCount += recorded.indexCount;
+	m_stats.bindCount += recorded.bindCount;
+	m_stats.errorCount += recorded.errorCount;
+
+	return;
+}
+
+
+void D3DRenderDeviceClass::ReleaseCommandList(unsigned int commandList)
+{
+	CommandListType& record = m_commandLists[commandList - 1];
+
+
+	if (record.commandList)
+	{
+		record.commandList->Release();
+		record.commandList = 0;
+	}
+
+	record.recorder->Shutdown();
+	delete record.recorder;
+	record.recorder = 0;
+	m_freeCommandLists.push_back(commandList - 1);
+
+	return;
+}
+
+// The Bind functions make a bind on a context, the immediate one or the deferred context of a command list.
+void D3DRenderDeviceClass::BindVertexBuffers(ID3D11DeviceContext* deviceContext, unsigned int startSlot, unsigned int count,
+	const unsigned int* buffers, const unsigned int* strides, const unsigned int* offsets)
+{
+	ID3D11Buffer* vertexBuffers[RENDER_MAX_VERTEX_BUFFERS];
+	unsigned int i;
+
+
+	for (i = 0; i < count; i++)
+	{
+		vertexBuffers[i] = buffers[i] ? m_buffers[buffers[i] - 1].buffer : 0;
+	}
+	deviceContext->IASetVertexBuffers(startSlot, count, vertexBuffers, strides, offsets);
+
+	return;
+}
+
+
+void D3DRenderDeviceClass::BindIndexBuffer(ID3D11DeviceContext* deviceContext, unsigned int buffer, DXGI_FORMAT format, unsigned int offset)
+{
+	deviceContext->IASetIndexBuffer(buffer ? m_buffers[buffer - 1].buffer : 0, format, offset);
+
+	return;
+}
+
+
+void D3DRenderDeviceClass::BindShader(ID3D11DeviceContext* deviceContext, unsigned int shader)
+{
+	if (shader)
+	{
+		deviceContext->IASetInputLayout(m_shaders[shader - 1].layout);
+		deviceContext->VSSetShader(m_shaders[shader - 1].vertexShader, NULL, 0);
+		deviceContext->PSSetShader(m_shaders[shader - 1].pixelShader, NULL, 0);
+		deviceContext->PSSetSamplers(0, 1, &m_sampleState);
+	}
+	else
+	{
+		deviceContext->IASetInputLayout(0);
+		deviceContext->VSSetShader(0, NULL, 0);
+		deviceContext->PSSetShader(0, NULL, 0);
+	}
+
+	return;
+}
+
+// BindConstantBuffer binds the whole buffer with a constant count of zero, and otherwise that many constants from firstConstant through
+// the Direct3D 11.1 context. A context without the 11.1 interface, such as a deferred context that could not get it, binds the whole
+// buffer too.
+void D3DRenderDeviceClass::BindConstantBuffer(ID3D11DeviceContext* deviceContext, ID3D11DeviceContext1* deviceContext1, RenderShaderStageType stage,
+	unsigned int slot, unsigned int buffer, unsigned int firstConstant, unsigned int constantCount)
+{
+	ID3D11Buffer* constantBuffer;
+
+
+	constantBuffer = buffer ? m_buffers[buffer - 1].buffer : 0;
+	if (constantCount > 0 && deviceContext1)
+	{
+		if (stage == RENDER_STAGE_VERTEX)
+		{
+			deviceContext1->VSSetConstantBuffers1(slot, 1, &constantBuffer, &firstConstant, &constantCount);
+		}
+		else
+		{
+			deviceContext1->PSSetConstantBuffers1(slot, 1, &constantBuffer, &firstConstant, &constantCount);
+		}
+	}
+	else
+	{
+		if (stage == RENDER_STAGE_VERTEX)
+		{
+			deviceContext->VSSetConstantBuffers(slot, 1, &constantBuffer);
+		}
+		else
+		{
+			deviceContext->PSSetConstantBuffers(slot, 1, &constantBuffer);
+		}
+	}
+
+	return;
+}
+
+
+void D3DRenderDeviceClass::BindTexture(ID3D11DeviceContext* deviceContext, unsigned int slot, unsigned int texture)
+{
+	ID3D11ShaderResourceView* view;
+
+
+	view = texture ? m_textures[texture - 1] : 0;
+	deviceContext->PSSetShaderResources(slot, 1, &view);
+
+	return;
+}
+
+// SetFixedState binds what every draw shares and no call of the device changes: triangle lists and the back buffer with its states.
+void D3DRenderDeviceClass::SetFixedState(ID3D11DeviceContext* deviceContext)
+{
+	deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	m_D3D->SetOutputState(deviceContext);
+
+	return;
+}
+
+// CompileShader compiles one entry point of a shader file. A compile error is written to shader-error.txt, a missing file is shown.
+bool D3DRenderDeviceClass::CompileShader(const wchar_t* filename, const char* entryPoint, const char* target, OUT ID3D10Blob*& shaderBuffer)
+{
+	ID3D10Blob* errorMessage;
+	HRESULT result;
+
+
+	shaderBuffer = 0;
+	errorMessage = 0;
+	result = D3DCompileFromFile(filename, NULL, NULL, entryPoint, target, D3D10_SHADER_ENABLE_STRICTNESS, 0, &shaderBuffer, &errorMessage);
+	if (FAILED(result))
+	{
+		// If the shader failed to compile it should have writen something to the error message.
+		if (errorMessage)
+		{
+			OutputShaderErrorMessage(errorMessage, filename);
+		}
+		// If there was nothing in the error message then it simply could not find the shader file itself.
+		else
+		{
+			MessageBox(m_hwnd, filename, L"Missing Shader File", MB_OK);
+		}
+
+		return false;
+	}
+
+	return true;
+}
+
+// OutputShaderErrorMessage writes out errors to a text file if the HLSL shader could not be loaded.
+void D3DRenderDeviceClass::OutputShaderErrorMessage(ID3D10Blob* errorMessage, const wchar_t* shaderFilename)
+{
+	char* compileErrors;
+	unsigned long long bufferSize, i;
+	ofstream fout;
+
+
+	// Get a pointer to the error message text buffer.
+	compileErrors = (char*)(errorMessage->GetBufferPointer());
+
+	// Get the length of the message.
+	bufferSize = errorMessage->GetBufferSize();
+
+	// Open a file to write the error message to.
+	fout.open("shader-error.txt");
+
+	// Write out the error message.
+	for (i = 0; i < bufferSize; i++)
+	{
+		fout << compileErrors[i];
+	}
+
+	// Close the file.
+	fout.close();
+
+	// Release the error message.
+	errorMessage->Release();
+	errorMessage = 0;
+
+	// Pop a message up on the screen to notify the user to check the text file for compile errors.
+	MessageBox(m_hwnd, L"Error compiling shader.  Check shader-error.txt for message.", shaderFilename, MB_OK);
+
+	return;
+}
+
+
+unsigned int D3DRenderDeviceClass::AddTexture(ID3D11ShaderResourceView* view)
+{
+	unsigned int index;
+
+
+	if (!m_freeTextures.empty())
+	{
+		index = m_freeTextures.back();
+		m_freeTextures.pop_back();
+		m_textures[index] = view;
+	}
+	else
+	{
+		index = (unsigned int)m_textures.size();
+		m_textures.push_back(view);
+	}
+	m_stats.textureCount++;
+
+	return index + 1;
+}
@@ -0,0 +1,138 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: d3drenderdeviceclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _D3DRENDERDEVICECLASS_H_
+#define _D3DRENDERDEVICECLASS_H_
+
+
+/////////////
+// LINKING //
+/////////////
+#pragma comment(lib, "d3dcompiler.lib")
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <d3d11_1.h>
+#include <d3dcompiler.h>
+#include <vector>
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "d3dclass.h"
+#include "renderdeviceclass.h"
+#include "d3ddeferredcontextclass.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: D3DRenderDeviceClass
+////////////////////////////////////////////////////////////////////////////////
+// The D3DRenderDeviceClass is the render device on the Direct3D 11 device and swap chain of a D3DClass. A handle is the index of the
+// Direct3D object in its table plus one. Parts of constant buffers are bound through the Direct3D 11.1 context when the driver can.
+// A command list is recorded on a deferred context of its own through a D3DDeferredContextClass, which binds with the same tables.
+class D3DRenderDeviceClass : public RenderDeviceClass
+{
+	friend class D3DDeferredContextClass;
+
+private:
+	struct BufferType
+	{
+		ID3D11Buffer* buffer;
+		unsigned int byteWidth;
+	};
+
+	struct ShaderType
+	{
+		ID3D11VertexShader* vertexShader;
+		ID3D11PixelShader* pixelShader;
+		ID3D11InputLayout* layout;
+	};
+
+	// The deferred context a list records on, and what it recorded last until that is executed.
+	struct CommandListType
+	{
+		D3DDeferredContextClass* recorder;
+		ID3D11CommandList* commandList;
+	};
+
+public:
+	D3DRenderDeviceClass();
+	D3DRenderDeviceClass(const D3DRenderDeviceClass&);
+	~D3DRenderDeviceClass();
+
+	bool Initialize(D3DClass*, HWND);
+	void Shutdown();
+	CapsType GetCaps();
+
+	bool CreateBuffer(const BufferDescType&, const void* initialData, OUT unsigned int& buffer);
+	void UpdateBuffer(unsigned int buffer, unsigned int offset, const void* data, unsigned int size);
+	void CopyBuffer(unsigned int destination, unsigned int destinationOffset, unsigned int source, unsigned int sourceOffset, unsigned int size);
+	bool MapBuffer(unsigned int buffer, RenderMapType, unsigned int offset, unsigned int size, OUT void*& data);
+	void UnmapBuffer(unsigned int buffer);
+	void ReleaseBuffer(unsigned int buffer);
+
+	bool CreateTexture(const wchar_t* filename, OUT unsigned int& texture);
+	bool CreateTexture(const unsigned char* data, size_t size, OUT unsigned int& texture);
+	void ReleaseTexture(unsigned int texture);
+
+	bool CreateShader(const ShaderDescType&, OUT unsigned int& shader);
+	void ReleaseShader(unsigned int shader);
+
+	bool CreateQuery(OUT unsigned int& query);
+	void EndQuery(unsigned int query);
+	bool IsQueryDone(unsigned int query, bool flush);
+	void ReleaseQuery(unsigned int query);
+
+	void BeginScene(float red, float green, float blue, float alpha);
+	void EndScene();
+
+	void SetVertexBuffers(unsigned int startSlot, unsigned int count, const unsigned int* buffers, const unsigned int* strides,
+		const unsigned int* offsets);
+	void SetIndexBuffer(unsigned int buffer, DXGI_FORMAT format, unsigned int offset);
+	void SetShader(unsigned int shader);
+	void SetConstantBuffer(RenderShaderStageType, unsigned int slot, unsigned int buffer, unsigned int firstConstant, unsigned int constantCount);
+	void SetTexture(unsigned int slot, unsigned int texture);
+	void DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex);
+	void DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int startIndex, int baseVertex,
+		unsigned int startInstance);
+
+	bool CreateCommandList(OUT unsigned int& commandList);
+	bool BeginCommandList(unsigned int commandList, OUT RenderDeviceClass*& recorder);
+	void EndCommandList(unsigned int commandList);
+	void ExecuteCommandList(unsigned int commandList);
+	void ReleaseCommandList(unsigned int commandList);
+
+private:
+	void BindVertexBuffers(ID3D11DeviceContext*, unsigned int startSlot, unsigned int count, const unsigned int* buffers,
+		const unsigned int* strides, const unsigned int* offsets);
+	void BindIndexBuffer(ID3D11DeviceContext*, unsigned int buffer, DXGI_FORMAT format, unsigned int offset);
+	void BindShader(ID3D11DeviceContext*, unsigned int shader);
+	void BindConstantBuffer(ID3D11DeviceContext*, ID3D11DeviceContext1*, RenderShaderStageType, unsigned int slot, unsigned int buffer,
+		unsigned int firstConstant, unsigned int constantCount);
+	void BindTexture(ID3D11DeviceContext*, unsigned int slot, unsigned int texture);
+	void SetFixedState(ID3D11DeviceContext*);
+	bool CompileShader(const wchar_t* filename, const char* entryPoint, const char* target, OUT ID3D10Blob*& shaderBuffer);
+	void OutputShaderErrorMessage(ID3D10Blob*, const wchar_t*);
+	unsigned int AddTexture(ID3D11ShaderResourceView*);
+
+private:
+	D3DClass* m_D3D;
+	HWND m_hwnd;
+	ID3D11Device* m_device;
+	ID3D11DeviceContext* m_deviceContext;
+	ID3D11DeviceContext1* m_deviceContext1;
+	ID3D11SamplerState* m_sampleState;
+	CapsType m_caps;
+
+	// The objects by handle minus one, and the slots that were released so they can be given out again.
+	std::vector<BufferType> m_buffers;
+	std::vector<ID3D11ShaderResourceView*> m_textures;
+	std::vector<ShaderType> m_shaders;
+	std::vector<ID3D11Query*> m_queries;
+	std::vector<CommandListType> m_commandLists;
+	std::vector<unsigned int> m_freeBuffers, m_freeTextures, m_freeShaders, m_freeQueries, m_freeCommandLists;
+};
+
+#endif
@@ -0,0 +1,358 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: geometrypoolclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "geometrypoolclass.h"
+#include <cstdio>
+
+
+GeometryPoolClass::GeometryPoolClass()
+{
+	m_device = 0;
+	m_vertexBuffer = RENDER_HANDLE_NONE;
+	m_indexBuffer = RENDER_HANDLE_NONE;
+	m_vertexStride = 0;
+	m_indexStride = 0;
+	m_indexFormat = DXGI_FORMAT_R32_UINT;
+	m_defragmentCount = 0;
+	m_growCount = 0;
+}
+
+
+GeometryPoolClass::GeometryPoolClass(const GeometryPoolClass& other)
+{
+}
+
+
+GeometryPoolClass::~GeometryPoolClass()
+{
+}
+
+// Initialize creates the two buffers with room for the given number of vertices and indices. They grow when a mesh does not fit.
+bool GeometryPoolClass::Initialize(RenderDeviceClass* device, unsigned int vertexStride, DXGI_FORMAT indexFormat, unsigned int vertexCapacity,
+	unsigned int indexCapacity)
+{
+	bool result;
+
+
+	if (vertexStride == 0 || vertexCapacity == 0 || indexCapacity == 0 ||
+		(indexFormat != DXGI_FORMAT_R16_UINT && indexFormat != DXGI_FORMAT_R32_UINT))
+	{
+		return false;
+	}
+
+	m_vertexStride = vertexStride;
+	m_indexFormat = indexFormat;
+	m_indexStride = (indexFormat == DXGI_FORMAT_R16_UINT) ? 2 : 4;
+	m_device = device;
+
+	result = CreateBuffer(device, RENDER_BIND_VERTEX_BUFFER, m_vertexStride, vertexCapacity, m_vertexBuffer);
+	if (!result)
+	{
+		return false;
+	}
+
+	result = CreateBuffer(device, RENDER_BIND_INDEX_BUFFER, m_indexStride, indexCapacity, m_indexBuffer);
+	if (!result)
+	{
+		return false;
+	}
+
+	m_vertexAllocator.Initialize(vertexCapacity);
+	m_indexAllocator.Initialize(indexCapacity);
+
+	return true;
+}
+
+
+void GeometryPoolClass::Shutdown()
+{
+	if (m_indexBuffer)
+	{
+		m_device->ReleaseBuffer(m_indexBuffer);
+		m_indexBuffer = RENDER_HANDLE_NONE;
+	}
+
+	if (m_vertexBuffer)
+	{
+		m_device->ReleaseBuffer(m_vertexBuffer);
+		m_vertexBuffer = RENDER_HANDLE_NONE;
+	}
+
+	m_vertexAllocator.Shutdown();
+	m_indexAllocator.Shutdown();
+	m_meshes.clear();
+	m_freeHandles.clear();
+
+	return;
+}
+
+// Render binds the pool's buffers. Every mesh of the pool can be drawn after that with its own offsets.
+void GeometryPoolClass::Render(RenderDeviceClass* device)
+{
+	unsigned int stride;
+	unsigned int offset;
+
+
+	stride = m_vertexStride;
+	offset = 0;
+	device->SetVertexBuffers(0, 1, &m_vertexBuffer, &stride, &offset);
+	device->SetIndexBuffer(m_indexBuffer, m_indexFormat, 0);
+
+	return;
+}
+
+// Allocate finds room for a mesh and uploads it. The vertices have to be in the pool's stride and the indices in its format, relative
+// to the first vertex of the mesh. It returns GEOMETRY_POOL_HANDLE_NONE when the buffers can neither be packed nor grown to fit it.
+unsigned int GeometryPoolClass::Allocate(RenderDeviceClass* device, const void* vertices, unsigned int vertexCount, const void* indices,
+	unsigned int indexCount)
+{
+	MeshType mesh;
+	unsigned int handle, offset;
+
+
+	if (!m_vertexBuffer || vertexCount == 0 || indexCount == 0)
+	{
+		return GEOMETRY_POOL_HANDLE_NONE;
+	}
+
+	mesh.vertexBlock = m_vertexAllocator.Allocate(vertexCount);
+	if (mesh.vertexBlock == TLSF_HANDLE_NONE)
+	{
+		if (MakeRoom(device, m_vertexAllocator, m_vertexBuffer, RENDER_BIND_VERTEX_BUFFER, m_vertexStride, vertexCount))
+		{
+			mesh.vertexBlock = m_vertexAllocator.Allocate(vertexCount);
+		}
+		if (mesh.vertexBlock == TLSF_HANDLE_NONE)
+		{
+			return GEOMETRY_POOL_HANDLE_NONE;
+		}
+	}
+
+	mesh.indexBlock = m_indexAllocator.Allocate(indexCount);
+	if (mesh.indexBlock == TLSF_HANDLE_NONE)
+	{
+		if (MakeRoom(device, m_indexAllocator, m_indexBuffer, RENDER_BIND_INDEX_BUFFER, m_indexStride, indexCount))
+		{
+			mesh.indexBlock = m_indexAllocator.Allocate(indexCount);
+		}
+		if (mesh.indexBlock == TLSF_HANDLE_NONE)
+		{
+			m_vertexAllocator.Free(mesh.vertexBlock);
+			return GEOMETRY_POOL_HANDLE_NONE;
+		}
+	}
+
+	offset = m_vertexAllocator.GetOffset(mesh.vertexBlock) * m_vertexStride;
+	device->UpdateBuffer(m_vertexBuffer, offset, vertices, vertexCount * m_vertexStride);
+
+	offset = m_indexAllocator.GetOffset(mesh.indexBlock) * m_indexStride;
+	device->UpdateBuffer(m_indexBuffer, offset, indices, indexCount * m_indexStride);
+
+	if (!m_freeHandles.empty())
+	{
+		handle = m_freeHandles.back();
+		m_freeHandles.pop_back();
+		m_meshes[handle] = mesh;
+	}
+	else
+	{
+		handle = (unsigned int)m_meshes.size();
+		m_meshes.push_back(mesh);
+	}
+
+	return handle;
+}
+
+// Free gives the ranges of a mesh back. The buffers are not packed until an allocation needs the room or Defragment is called.
+void GeometryPoolClass::Free(unsigned int handle)
+{
+	if (handle >= m_meshes.size() || m_meshes[handle].vertexBlock == TLSF_HANDLE_NONE)
+	{
+		return;
+	}
+
+	m_vertexAllocator.Free(m_meshes[handle].vertexBlock);
+	m_indexAllocator.Free(m_meshes[handle].indexBlock);
+	m_meshes[handle].vertexBlock = TLSF_HANDLE_NONE;
+	m_meshes[handle].indexBlock = TLSF_HANDLE_NONE;
+	m_freeHandles.push_back(handle);
+
+	return;
+}
+
+// Defragment packs the meshes of both buffers to their start, leaving all the free room as one block at the end of each.
+bool GeometryPoolClass::Defragment(RenderDeviceClass* device)
+{
+	bool result;
+
+
+	result = DefragmentBuffer(device, m_vertexAllocator, m_vertexBuffer, RENDER_BIND_VERTEX_BUFFER, m_vertexStride);
+	if (!result)
+	{
+		return false;
+	}
+
+	return DefragmentBuffer(device, m_indexAllocator, m_indexBuffer, RENDER_BIND_INDEX_BUFFER, m_indexStride);
+}
+
+
+unsigned int GeometryPoolClass::GetVertexStride()
+{
+	return m_vertexStride;
+}
+
+
+DXGI_FORMAT GeometryPoolClass::GetIndexFormat()
+{
+	return m_indexFormat;
+}
+
+// GetBaseVertex and GetStartIndex return where a mesh is in the buffers now. They change when the pool packs or grows the buffers.
+int GeometryPoolClass::GetBaseVertex(unsigned int handle)
+{
+	return (int)m_vertexAllocator.GetOffset(m_meshes[handle].vertexBlock);
+}
+
+
+unsigned int GeometryPoolClass::GetStartIndex(unsigned int handle)
+{
+	return m_indexAllocator.GetOffset(m_meshes[handle].indexBlock);
+}
+
+
+GeometryPoolClass::StatsType GeometryPoolClass::GetStats()
+{
+	StatsType stats;
+
+
+	stats.vertices = m_vertexAllocator.GetStats();
+	stats.indices = m_indexAllocator.GetStats();
+	stats.meshCount = (unsigned int)(m_meshes.size() - m_freeHandles.size());
+	stats.defragmentCount = m_defragmentCount;
+	stats.growCount = m_growCount;
+
+	return stats;
+}
+
+// MakeRoom is called when count units did not fit into one of the buffers. If the free units would be enough in one piece the buffer
+// is packed, otherwise it grows to at least twice its size. The allocator may round a request up by a sixteenth before it looks for
+// a block, so that much more room is made.
+bool GeometryPoolClass::MakeRoom(RenderDeviceClass* device, TlsfAllocatorClass& allocator, OUT unsigned int& buffer, RenderBindType bind,
+	unsigned int stride, unsigned int count)
+{
+	TlsfAllocatorClass::StatsType stats;
+	std::vector<TlsfAllocatorClass::MoveType> moves;
+	unsigned int newBuffer;
+	unsigned long long needed, capacity;
+	bool result;
+
+
+	stats = allocator.GetStats();
+	needed = (unsigned long long)count + count / 16 + 1;
+	if (stats.freeUnits >= needed)
+	{
+		return DefragmentBuffer(device, allocator, buffer, bind, stride);
+	}
+
+	capacity = stats.capacity * 2ull;
+	if (capacity < stats.capacity + needed)
+	{
+		capacity = stats.capacity + needed;
+	}
+	if (capacity * stride > 0xffffffffull)
+	{
+		return false;
+	}
+
+	result = CreateBuffer(device, bind, stride, (unsigned int)capacity, newBuffer);
+	if (!result)
+	{
+		return false;
+	}
+
+	CopyBuffer(device, newBuffer, stride, stats.capacity, moves, buffer);
+	allocator.Grow((unsigned int)capacity);
+	m_growCount++;
+	printf("Grew a geometry pool buffer from %u to %llu units\n", stats.capacity, capacity);
+
+	return true;
+}
+
+
+// DefragmentBuffer makes the new buffer before the allocator moves anything, so a failure leaves the meshes where they were.
+bool GeometryPoolClass::DefragmentBuffer(RenderDeviceClass* device, TlsfAllocatorClass& allocator, OUT unsigned int& buffer, RenderBindType bind,
+	unsigned int stride)
+{
+	std::vector<TlsfAllocatorClass::MoveType> moves;
+	unsigned int newBuffer;
+	bool result;
+
+
+	if (allocator.IsPacked())
+	{
+		return true;
+	}
+
+	result = CreateBuffer(device, bind, stride, allocator.GetCapacity(), newBuffer);
+	if (!result)
+	{
+		return false;
+	}
+
+	// Everything in front of the first move stayed where it was.
+	allocator.Defragment(moves);
+	CopyBuffer(device, newBuffer, stride, moves.empty() ? allocator.GetCapacity() : moves[0].newOffset, moves, buffer);
+	m_defragmentCount++;
+
+	return true;
+}
+
+// CreateBuffer makes a default buffer of capacity units of stride bytes without initial data, it is filled with UpdateBuffer
+// and CopyBuffer.
+bool GeometryPoolClass::CreateBuffer(RenderDeviceClass* device, RenderBindType bind, unsigned int stride, unsigned int capacity,
+	OUT unsigned int& buffer)
+{
+	RenderDeviceClass::BufferDescType bufferDesc;
+
+
+	bufferDesc.bind = bind;
+	bufferDesc.usage = RENDER_USAGE_DEFAULT;
+	bufferDesc.byteWidth = stride * capacity;
+
+	return device->CreateBuffer(bufferDesc, 0, buffer);
+}
+
+// CopyBuffer moves the contents of buffer into newBuffer and replaces it. The first keepUnits units are copied over as they are and
+// every move from its old offset to its new one, with moves that follow each other in both buffers copied together. A copy inside
+// one buffer may not overlap, which packing would, so the new buffer is always a separate one.
+void GeometryPoolClass::CopyBuffer(RenderDeviceClass* device, unsigned int newBuffer, unsigned int stride, unsigned int keepUnits,
+	const std::vector<TlsfAllocatorClass::MoveType>& moves, OUT unsigned int& buffer)
+{
+	unsigned int oldOffset, newOffset, size;
+	size_t i;
+
+
+	if (keepUnits > 0)
+	{
+		device->CopyBuffer(newBuffer, 0, buffer, 0, keepUnits * stride);
+	}
+
+	i = 0;
+	while (i < moves.size())
+	{
+		oldOffset = moves[i].oldOffset;
+		newOffset = moves[i].newOffset;
+		size = moves[i].size;
+		for (i++; i < moves.size() && moves[i].oldOffset == oldOffset + size && moves[i].newOffset == newOffset + size; i++)
+		{
+			size += moves[i].size;
+		}
+
+		device->CopyBuffer(newBuffer, newOffset * stride, buffer, oldOffset * stride, size * stride);
+	}
+
+	device->ReleaseBuffer(buffer);
+	buffer = newBuffer;
+
+	return;
+}
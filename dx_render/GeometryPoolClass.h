@@ -0,0 +1,90 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: geometrypoolclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _GEOMETRYPOOLCLASS_H_
+#define _GEOMETRYPOOLCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <vector>
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "renderdeviceclass.h"
+#include "tlsfallocatorclass.h"
+
+
+/////////////
+// GLOBALS //
+/////////////
+// What Allocate returns in place of a handle when it fails.
+const unsigned int GEOMETRY_POOL_HANDLE_NONE = 0xffffffff;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: GeometryPoolClass
+////////////////////////////////////////////////////////////////////////////////
+// The GeometryPoolClass keeps the geometry of many meshes in one vertex buffer and one index buffer, so drawing them needs a single
+// buffer binding. Each mesh is a range of vertices and a range of indices handed out by a TlsfAllocatorClass, and is drawn with the
+// base vertex and start index of its ranges. Every mesh in a pool has the same vertex stride and index format.
+// When the buffers have no room left the pool first packs the meshes together if that would make enough room, and otherwise grows
+// the buffers. Both move meshes around, so the offsets of a mesh have to be asked for again after any Allocate or Defragment.
+class GeometryPoolClass
+{
+public:
+	struct StatsType
+	{
+		TlsfAllocatorClass::StatsType vertices, indices;
+		unsigned int meshCount;
+		unsigned int defragmentCount, growCount;
+	};
+
+public:
+	GeometryPoolClass();
+	GeometryPoolClass(const GeometryPoolClass&);
+	~GeometryPoolClass();
+
+	bool Initialize(RenderDeviceClass*, unsigned int vertexStride, DXGI_FORMAT indexFormat, unsigned int vertexCapacity, unsigned int indexCapacity);
+	void Shutdown();
+	void Render(RenderDeviceClass*);
+
+	unsigned int Allocate(RenderDeviceClass*, const void* vertices, unsigned int vertexCount, const void* indices, unsigned int indexCount);
+	void Free(unsigned int handle);
+	bool Defragment(RenderDeviceClass*);
+
+	unsigned int GetVertexStride();
+	DXGI_FORMAT GetIndexFormat();
+	int GetBaseVertex(unsigned int handle);
+	unsigned int GetStartIndex(unsigned int handle);
+	StatsType GetStats();
+
+private:
+	struct MeshType
+	{
+		unsigned int vertexBlock, indexBlock;
+	};
+
+	bool MakeRoom(RenderDeviceClass*, TlsfAllocatorClass& allocator, OUT unsigned int& buffer, RenderBindType bind, unsigned int stride,
+		unsigned int count);
+	bool DefragmentBuffer(RenderDeviceClass*, TlsfAllocatorClass& allocator, OUT unsigned int& buffer, RenderBindType bind, unsigned int stride);
+	bool CreateBuffer(RenderDeviceClass*, RenderBindType bind, unsigned int stride, unsigned int capacity, OUT unsigned int& buffer);
+	void CopyBuffer(RenderDeviceClass*, unsigned int newBuffer, unsigned int stride, unsigned int keepUnits,
+		const std::vector<TlsfAllocatorClass::MoveType>& moves, OUT unsigned int& buffer);
+
+private:
+	RenderDeviceClass* m_device;
+	unsigned int m_vertexBuffer, m_indexBuffer;
+	unsigned int m_vertexStride, m_indexStride;
+	DXGI_FORMAT m_indexFormat;
+	TlsfAllocatorClass m_vertexAllocator, m_indexAllocator;
+
+	// The meshes by handle, and the handles of the ones that were freed so they can be given out again.
+	std::vector<MeshType> m_meshes;
+	std::vector<unsigned int> m_freeHandles;
+	unsigned int m_defragmentCount, m_growCount;
+};
+
+#endif
@@ -0,0 +1,1129 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: gltfloaderclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "gltfloaderclass.h"
+#include <cctype>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+
+/////////////
+// GLOBALS //
+/////////////
+static const uint32_t GLB_MAGIC = 0x46546c67;
+static const uint32_t GLB_CHUNK_JSON = 0x4e4f534a;
+static const uint32_t GLB_CHUNK_BIN = 0x004e4942;
+
+static const unsigned int GLTF_BYTE = 5120;
+static const unsigned int GLTF_UNSIGNED_BYTE = 5121;
+static const unsigned int GLTF_SHORT = 5122;
+static const unsigned int GLTF_UNSIGNED_SHORT = 5123;
+static const unsigned int GLTF_UNSIGNED_INT = 5125;
+static const unsigned int GLTF_FLOAT = 5126;
+static const int GLTF_MODE_TRIANGLES = 4;
+
+
+// ReadFloats copies a JSON array of exactly count numbers, as used by the node transforms.
+static bool ReadFloats(const JsonParserClass::ValueType* array, OUT float* values, size_t count)
+{
+	size_t i;
+
+
+	if (!array || array->kind != JsonParserClass::KIND_ARRAY || array->items.size() != count)
+	{
+		return false;
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		if (array->items[i].kind != JsonParserClass::KIND_NUMBER)
+		{
+			return false;
+		}
+		values[i] = (float)array->items[i].number;
+	}
+
+	return true;
+}
+
+
+static bool IsIdentity(const XMFLOAT4X4& matrix)
+{
+	int row, column;
+
+
+	for (row = 0; row < 4; row++)
+	{
+		for (column = 0; column < 4; column++)
+		{
+			if (matrix.m[row][column] != (row == column ? 1.0f : 0.0f))
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+
+GltfLoaderClass::GltfLoaderClass()
+{
+	m_binChunk = 0;
+	m_binChunkSize = 0;
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+
+
+GltfLoaderClass::GltfLoaderClass(const GltfLoaderClass& other)
+{
+}
+
+
+GltfLoaderClass::~GltfLoaderClass()
+{
+}
+
+// Initialize maps the file, reads its JSON and walks the default scene. Every mesh a node places becomes one primitive per
+// triangle list it has; lines, points, strips and fans are skipped and counted.
+bool GltfLoaderClass::Initialize(const char* filename)
+{
+	JsonParserClass parser;
+	JsonParserClass::ValueType root;
+	const JsonParserClass::ValueType* meshes;
+	const JsonParserClass::ValueType* primitives;
+	std::vector<InstanceType> instances;
+	std::string directory;
+	const char* jsonBegin;
+	const char* jsonEnd;
+	size_t i, j, slash;
+
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	Shutdown();
+	m_filename = filename;
+	if (!m_file.Initialize(filename))
+	{
+		return false;
+	}
+	m_stats.fileSize = m_file.GetSize();
+
+	if (!ReadContainer(jsonBegin, jsonEnd) || !parser.Parse(jsonBegin, jsonEnd, root) || root.kind != JsonParserClass::KIND_OBJECT)
+	{
+		printf("%s is not a glTF 2.0 file\n", filename);
+		return false;
+	}
+
+	// External files are named relative to the model.
+	slash = m_filename.find_last_of("/\\");
+	directory = slash == std::string::npos ? std::string() : m_filename.substr(0, slash + 1);
+
+	if (!ReadBuffers(root, directory) || !ReadBufferViews(root) || !ReadAccessors(root) || !ReadImages(root, directory))
+	{
+		printf("%s has buffers or accessors outside of its data\n", filename);
+		return false;
+	}
+
+	ReadMaterials(root);
+	if (!ReadScene(root, instances))
+	{
+		printf("%s has an invalid node hierarchy\n", filename);
+		return false;
+	}
+
+	meshes = JsonParserClass::GetArray(root, "meshes");
+	for (i = 0; i < instances.size(); i++)
+	{
+		primitives = JsonParserClass::GetArray(meshes->items[instances[i].mesh], "primitives");
+		for (j = 0; primitives && j < primitives->items.size(); j++)
+		{
+			if (!ReadPrimitive(primitives->items[j], instances[i]))
+			{
+				printf("%s has an invalid primitive in mesh %d\n", filename, instances[i].mesh);
+				return false;
+			}
+		}
+	}
+
+	if (m_primitives.empty())
+	{
+		printf("%s contains no triangles\n", filename);
+		return false;
+	}
+
+	m_stats.meshCount = meshes ? (unsigned int)meshes->items.size() : 0;
+	m_stats.primitiveCount = (unsigned int)m_primitives.size();
+	m_stats.imageCount = (unsigned int)m_images.size();
+	m_stats.loadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	return true;
+}
+
+// Shutdown unmaps the files, after which none of the pointers handed out are valid anymore.
+void GltfLoaderClass::Shutdown()
+{
+	size_t i;
+
+
+	for (i = 0; i < m_externalFiles.size(); i++)
+	{
+		m_externalFiles[i]->Shutdown();
+		delete m_externalFiles[i];
+	}
+	m_externalFiles.clear();
+	m_file.Shutdown();
+
+	m_decodedData.clear();
+	m_binChunk = 0;
+	m_binChunkSize = 0;
+	m_buffers.clear();
+	m_bufferViews.clear();
+	m_accessors.clear();
+	m_textureImages.clear();
+	m_materialImages.clear();
+	m_images.clear();
+	m_primitives.clear();
+	m_convertedVertices.clear();
+	m_convertedIndices.clear();
+	m_mergedVertices.clear();
+	m_mergedIndices.clear();
+	m_mergedShortIndices.clear();
+	memset(&m_stats, 0, sizeof(m_stats));
+
+	return;
+}
+
+
+const std::vector<GltfLoaderClass::PrimitiveType>& GltfLoaderClass::GetPrimitives()
+{
+	return m_primitives;
+}
+
+
+const std::vector<GltfLoaderClass::ImageType>& GltfLoaderClass::GetImages()
+{
+	return m_images;
+}
+
+// GetMesh returns all primitives as one indexed mesh with a range of indices for each. Primitives that follow each other in the file
+// share its vertex array as they are, anything else is copied together. The indices of a single primitive are used in place at their
+// own width, those of several are rebased onto the merged vertices, into 16 bits when the merged vertices fit and 32 otherwise.
+bool GltfLoaderClass::GetMesh(OUT const VertexType*& out_verts, OUT unsigned int& vertexCount, OUT const void*& out_indices,
+	OUT unsigned int& indexCount, OUT unsigned int& indexStride, OUT std::vector<RangeType>& out_ranges)
+{
+	const uint16_t* shortIndices;
+	const uint32_t* longIndices;
+	uint64_t totalVertices, totalIndices;
+	unsigned int baseVertex, mergedBase, index, k;
+	RangeType range;
+	bool contiguous;
+	size_t i;
+
+
+	if (m_primitives.empty())
+	{
+		return false;
+	}
+
+	totalVertices = 0;
+	totalIndices = 0;
+	contiguous = true;
+	for (i = 0; i < m_primitives.size(); i++)
+	{
+		totalVertices += m_primitives[i].vertexCount;
+		totalIndices += m_primitives[i].indexCount;
+		if (i > 0 && m_primitives[i].vertices != m_primitives[i - 1].vertices + m_primitives[i - 1].vertexCount)
+		{
+			contiguous = false;
+		}
+	}
+
+	if (totalVertices > UINT32_MAX || totalIndices > UINT32_MAX)
+	{
+		return false;
+	}
+
+	m_mergedVertices.clear();
+	m_mergedIndices.clear();
+	m_mergedShortIndices.clear();
+	m_stats.mergedBytes = 0;
+
+	if (contiguous)
+	{
+		out_verts = m_primitives[0].vertices;
+	}
+	else
+	{
+		m_mergedVertices.reserve((size_t)totalVertices);
+		for (i = 0; i < m_primitives.size(); i++)
+		{
+			m_mergedVertices.insert(m_mergedVertices.end(), m_primitives[i].vertices, m_primitives[i].vertices + m_primitives[i].vertexCount);
+		}
+		out_verts = m_mergedVertices.data();
+		m_stats.mergedBytes += m_mergedVertices.size() * sizeof(VertexType);
+	}
+	vertexCount = (unsigned int)totalVertices;
+
+	out_ranges.clear();
+	totalIndices = 0;
+	for (i = 0; i < m_primitives.size(); i++)
+	{
+		range.firstIndex = (unsigned int)totalIndices;
+		range.indexCount = m_primitives[i].indexCount;
+		range.image = m_primitives[i].image;
+		out_ranges.push_back(range);
+		totalIndices += m_primitives[i].indexCount;
+	}
+	indexCount = (unsigned int)totalIndices;
+
+	if (m_primitives.size() == 1)
+	{
+		out_indices = m_primitives[0].indices;
+		indexStride = m_primitives[0].indexStride;
+		return true;
+	}
+
+	indexStride = totalVertices <= 0x10000 ? sizeof(uint16_t) : sizeof(uint32_t);
+	if (indexStride == sizeof(uint16_t))
+	{
+		m_mergedShortIndices.resize((size_t)totalIndices);
+	}
+	else
+	{
+		m_mergedIndices.resize((size_t)totalIndices);
+	}
+
+	mergedBase = 0;
+	for (i = 0; i < m_primitives.size(); i++)
+	{
+		baseVertex = contiguous ? (unsigned int)(m_primitives[i].vertices - out_verts) : mergedBase;
+		mergedBase += m_primitives[i].vertexCount;
+
+		shortIndices = (const uint16_t*)m_primitives[i].indices;
+		longIndices = (const uint32_t*)m_primitives[i].indices;
+		for (k = 0; k < m_primitives[i].indexCount; k++)
+		{
+			index = (m_primitives[i].indexStride == sizeof(uint16_t) ? shortIndices[k] : longIndices[k]) + baseVertex;
+			if (indexStride == sizeof(uint16_t))
+			{
+				m_mergedShortIndices[out_ranges[i].firstIndex + k] = (uint16_t)index;
+			}
+			else
+			{
+				m_mergedIndices[out_ranges[i].firstIndex + k] = index;
+			}
+		}
+	}
+
+	if (indexStride == sizeof(uint16_t))
+	{
+		out_indices = m_mergedShortIndices.data();
+		m_stats.mergedBytes += m_mergedShortIndices.size() * sizeof(uint16_t);
+	}
+	else
+	{
+		out_indices = m_mergedIndices.data();
+		m_stats.mergedBytes += m_mergedIndices.size() * sizeof(uint32_t);
+	}
+
+	return true;
+}
+
+
+GltfLoaderClass::LoadStatsType GltfLoaderClass::GetStats()
+{
+	return m_stats;
+}
+
+// ReadContainer finds the JSON of the file. A .glb starts with a 12 byte header followed by a JSON chunk and an optional binary
+// chunk, which holds the buffer without a uri. Anything else is taken to be a .gltf, which is all JSON.
+bool GltfLoaderClass::ReadContainer(OUT const char*& jsonBegin, OUT const char*& jsonEnd)
+{
+	const char* data;
+	size_t size, offset;
+	uint32_t header[3], chunk[2];
+
+
+	data = m_file.GetData();
+	size = m_file.GetSize();
+	if (size < sizeof(header) || memcmp(data, &GLB_MAGIC, sizeof(GLB_MAGIC)) != 0)
+	{
+		jsonBegin = data;
+		jsonEnd = data + size;
+		return true;
+	}
+
+	memcpy(header, data, sizeof(header));
+	if (header[1] != 2 || header[2] > size)
+	{
+		return false;
+	}
+
+	jsonBegin = 0;
+	jsonEnd = 0;
+	for (offset = sizeof(header); offset + sizeof(chunk) <= header[2]; offset += sizeof(chunk) + chunk[0])
+	{
+		memcpy(chunk, data + offset, sizeof(chunk));
+		if (chunk[0] > header[2] - offset - sizeof(chunk))
+		{
+			return false;
+		}
+
+		if (chunk[1] == GLB_CHUNK_JSON && !jsonBegin)
+		{
+			jsonBegin = data + offset + sizeof(chunk);
+			jsonEnd = jsonBegin + chunk[0];
+		}
+		else if (chunk[1] == GLB_CHUNK_BIN && !m_binChunk)
+		{
+			m_binChunk = (const unsigned char*)data + offset + sizeof(chunk);
+			m_binChunkSize = chunk[0];
+		}
+	}
+
+	return jsonBegin != 0;
+}
+
+// ReadBuffers resolves every buffer to its bytes: the binary chunk, a base64 data uri or a mapped file next to the model.
+bool GltfLoaderClass::ReadBuffers(const JsonParserClass::ValueType& root, const std::string& directory)
+{
+	const JsonParserClass::ValueType* buffers;
+	MappedFileClass* file;
+	BufferViewType buffer;
+	const char* uri;
+	double byteLength;
+	size_t i;
+
+
+	buffers = JsonParserClass::GetArray(root, "buffers");
+	for (i = 0; buffers && i < buffers->items.size(); i++)
+	{
+		byteLength = JsonParserClass::GetNumber(buffers->items[i], "byteLength", -1.0);
+		uri = JsonParserClass::GetString(buffers->items[i], "uri", 0);
+		buffer.stride = 0;
+
+		if (!uri)
+		{
+			if (i != 0 || !m_binChunk)
+			{
+				return false;
+			}
+			buffer.data = m_binChunk;
+			buffer.size = m_binChunkSize;
+		}
+		else if (strncmp(uri, "data:", 5) == 0)
+		{
+			if (!DecodeDataUri(uri, buffer.data, buffer.size))
+			{
+				return false;
+			}
+		}
+		else
+		{
+			file = new MappedFileClass;
+			m_externalFiles.push_back(file);
+			if (!file->Initialize((directory + DecodeUri(uri)).c_str()))
+			{
+				printf("Could not open the glTF buffer %s\n", uri);
+				return false;
+			}
+			buffer.data = (const unsigned char*)file->GetData();
+			buffer.size = file->GetSize();
+		}
+
+		if (byteLength < 0.0 || byteLength > (double)buffer.size)
+		{
+			return false;
+		}
+		buffer.size = (size_t)byteLength;
+		m_buffers.push_back(buffer);
+	}
+
+	return true;
+}
+
+
+bool GltfLoaderClass::ReadBufferViews(const JsonParserClass::ValueType& root)
+{
+	const JsonParserClass::ValueType* views;
+	BufferViewType view;
+	double byteOffset, byteLength;
+	int buffer, stride;
+	size_t i;
+
+
+	views = JsonParserClass::GetArray(root, "bufferViews");
+	for (i = 0; views && i < views->items.size(); i++)
+	{
+		buffer = JsonParserClass::GetInt(views->items[i], "buffer", -1);
+		byteOffset = JsonParserClass::GetNumber(views->items[i], "byteOffset", 0.0);
+		byteLength = JsonParserClass::GetNumber(views->items[i], "byteLength", -1.0);
+		stride = JsonParserClass::GetInt(views->items[i], "byteStride", 0);
+
+		if (buffer < 0 || buffer >= (int)m_buffers.size() || byteOffset < 0.0 || byteLength < 0.0 || stride < 0 ||
+			byteOffset + byteLength > (double)m_buffers[buffer].size)
+		{
+			return false;
+		}
+
+		view.data = m_buffers[buffer].data + (size_t)byteOffset;
+		view.size = (size_t)byteLength;
+		view.stride = (unsigned int)stride;
+		m_bufferViews.push_back(view);
+	}
+
+	return true;
+}
+
+// ReadAccessors checks that every element of every accessor lies inside its buffer view, so nothing after this reads past the data.
+// Sparse accessors and accessors without a buffer view are left without data and fail only when a primitive uses them.
+bool GltfLoaderClass::ReadAccessors(const JsonParserClass::ValueType& root)
+{
+	const JsonParserClass::ValueType* accessors;
+	const JsonParserClass::ValueType* accessor;
+	AccessorType entry;
+	const char* type;
+	double byteOffset, count;
+	unsigned int componentSize;
+	int view;
+	size_t i;
+
+
+	accessors = JsonParserClass::GetArray(root, "accessors");
+	for (i = 0; accessors && i < accessors->items.size(); i++)
+	{
+		accessor = &accessors->items[i];
+		view = JsonParserClass::GetInt(*accessor, "bufferView", -1);
+		byteOffset = JsonParserClass::GetNumber(*accessor, "byteOffset", 0.0);
+		count = JsonParserClass::GetNumber(*accessor, "count", -1.0);
+		type = JsonParserClass::GetString(*accessor, "type", "");
+
+		entry.data = 0;
+		entry.count = 0;
+		entry.componentType = (unsigned int)JsonParserClass::GetInt(*accessor, "componentType", 0);
+		entry.normalized = JsonParserClass::GetBool(*accessor, "normalized", false);
+
+		if (strcmp(type, "SCALAR") == 0) entry.componentCount = 1;
+		else if (strcmp(type, "VEC2") == 0) entry.componentCount = 2;
+		else if (strcmp(type, "VEC3") == 0) entry.componentCount = 3;
+		else if (strcmp(type, "VEC4") == 0 || strcmp(type, "MAT2") == 0) entry.componentCount = 4;
+		else if (strcmp(type, "MAT3") == 0) entry.componentCount = 9;
+		else if (strcmp(type, "MAT4") == 0) entry.componentCount = 16;
+		else return false;
+
+		switch (entry.componentType)
+		{
+		case GLTF_BYTE:
+		case GLTF_UNSIGNED_BYTE:
+			componentSize = 1;
+			break;
+		case GLTF_SHORT:
+		case GLTF_UNSIGNED_SHORT:
+			componentSize = 2;
+			break;
+		case GLTF_UNSIGNED_INT:
+		case GLTF_FLOAT:
+			componentSize = 4;
+			break;
+		default:
+			return false;
+		}
+
+		entry.elementSize = entry.componentCount * componentSize;
+		entry.stride = entry.elementSize;
+
+		if (count < 0.0 || count > (double)UINT32_MAX || byteOffset < 0.0)
+		{
+			return false;
+		}
+
+		if (view >= 0 && !JsonParserClass::Find(*accessor, "sparse"))
+		{
+			if (view >= (int)m_bufferViews.size())
+			{
+				return false;
+			}
+
+			if (m_bufferViews[view].stride != 0)
+			{
+				entry.stride = m_bufferViews[view].stride;
+			}
+
+			entry.count = (unsigned int)count;
+			if (entry.count > 0 && byteOffset + (double)entry.stride * (entry.count - 1) + entry.elementSize > (double)m_bufferViews[view].size)
+			{
+				return false;
+			}
+			entry.data = m_bufferViews[view].data + (size_t)byteOffset;
+		}
+
+		m_accessors.push_back(entry);
+	}
+
+	return true;
+}
+
+// ReadImages collects the images, embedded in a buffer view or a data uri, or as the name of a file next to the model.
+bool GltfLoaderClass::ReadImages(const JsonParserClass::ValueType& root, const std::string& directory)
+{
+	const JsonParserClass::ValueType* images;
+	ImageType image;
+	const char* uri;
+	int view;
+	size_t i;
+
+
+	images = JsonParserClass::GetArray(root, "images");
+	for (i = 0; images && i < images->items.size(); i++)
+	{
+		view = JsonParserClass::GetInt(images->items[i], "bufferView", -1);
+		uri = JsonParserClass::GetString(images->items[i], "uri", 0);
+		image.data = 0;
+		image.size = 0;
+		image.mimeType = JsonParserClass::GetString(images->items[i], "mimeType", "");
+		image.filename.clear();
+
+		if (view >= 0)
+		{
+			if (view >= (int)m_bufferViews.size())
+			{
+				return false;
+			}
+			image.data = m_bufferViews[view].data;
+			image.size = m_bufferViews[view].size;
+		}
+		else if (uri && strncmp(uri, "data:", 5) == 0)
+		{
+			if (!DecodeDataUri(uri, image.data, image.size))
+			{
+				return false;
+			}
+		}
+		else if (uri)
+		{
+			image.filename = directory + DecodeUri(uri);
+		}
+
+		m_images.push_back(image);
+	}
+
+	return true;
+}
+
+// ReadMaterials finds the base color image of every material. A DDS source from MSFT_texture_dds is preferred since the
+// texture class loads those without decoding.
+void GltfLoaderClass::ReadMaterials(const JsonParserClass::ValueType& root)
+{
+	const JsonParserClass::ValueType* textures;
+	const JsonParserClass::ValueType* materials;
+	const JsonParserClass::ValueType* extensions;
+	const JsonParserClass::ValueType* dds;
+	const JsonParserClass::ValueType* pbr;
+	const JsonParserClass::ValueType* baseColor;
+	int image, texture;
+	size_t i;
+
+
+	textures = JsonParserClass::GetArray(root, "textures");
+	for (i = 0; textures && i < textures->items.size(); i++)
+	{
+		image = JsonParserClass::GetInt(textures->items[i], "source", -1);
+		extensions = JsonParserClass::Find(textures->items[i], "extensions");
+		dds = extensions ? JsonParserClass::Find(*extensions, "MSFT_texture_dds") : 0;
+		if (dds)
+		{
+			image = JsonParserClass::GetInt(*dds, "source", image);
+		}
+
+		m_textureImages.push_back(image >= 0 && image < (int)m_images.size() ? image : -1);
+	}
+
+	materials = JsonParserClass::GetArray(root, "materials");
+	for (i = 0; materials && i < materials->items.size(); i++)
+	{
+		pbr = JsonParserClass::Find(materials->items[i], "pbrMetallicRoughness");
+		baseColor = pbr ? JsonParserClass::Find(*pbr, "baseColorTexture") : 0;
+		texture = baseColor ? JsonParserClass::GetInt(*baseColor, "index", -1) : -1;
+
+		m_materialImages.push_back(texture >= 0 && texture < (int)m_textureImages.size() ? m_textureImages[texture] : -1);
+	}
+
+	return;
+}
+
+// ReadScene walks the node tree of the default scene and lists every mesh it places with its world transform.
+// A file without scenes has its meshes listed once each, untransformed.
+bool GltfLoaderClass::ReadScene(const JsonParserClass::ValueType& root, OUT std::vector<InstanceType>& instances)
+{
+	const JsonParserClass::ValueType* meshes;
+	const JsonParserClass::ValueType* scenes;
+	const JsonParserClass::ValueType* nodes;
+	const JsonParserClass::ValueType* rootNodes;
+	const JsonParserClass::ValueType* children;
+	const JsonParserClass::ValueType* node;
+	std::vector<std::pair<int, XMFLOAT4X4>> stack;
+	std::vector<bool> visited;
+	InstanceType instance;
+	XMFLOAT4X4 identity, parent, matrix;
+	XMMATRIX local;
+	float translation[3], rotation[4], scale[3];
+	int scene, index, mesh;
+	size_t i;
+
+
+	meshes = JsonParserClass::GetArray(root, "meshes");
+	scenes = JsonParserClass::GetArray(root, "scenes");
+	nodes = JsonParserClass::GetArray(root, "nodes");
+	XMStoreFloat4x4(&identity, XMMatrixIdentity());
+
+	if (!meshes)
+	{
+		return true;
+	}
+
+	scene = JsonParserClass::GetInt(root, "scene", 0);
+	if (!scenes || !nodes || scene < 0 || scene >= (int)scenes->items.size())
+	{
+		for (i = 0; i < meshes->items.size(); i++)
+		{
+			instance.mesh = (int)i;
+			instance.world = identity;
+			instances.push_back(instance);
+		}
+		return true;
+	}
+
+	rootNodes = JsonParserClass::GetArray(scenes->items[scene], "nodes");
+	// The nodes are pushed in reverse so they come off the stack in file order, which keeps primitives stored back to back adjacent.
+	for (i = rootNodes ? rootNodes->items.size() : 0; i > 0; i--)
+	{
+		stack.push_back(std::make_pair(rootNodes->items[i - 1].kind == JsonParserClass::KIND_NUMBER ? (int)rootNodes->items[i - 1].number : -1, identity));
+	}
+
+	// A node may only have one parent, so one seen twice means a broken file rather than a shared subtree.
+	visited.assign(nodes->items.size(), false);
+	while (!stack.empty())
+	{
+		index = stack.back().first;
+		parent = stack.back().second;
+		stack.pop_back();
+
+		if (index < 0 || index >= (int)nodes->items.size() || visited[index])
+		{
+			return false;
+		}
+		visited[index] = true;
+		node = &nodes->items[index];
+
+		// glTF stores column major matrices for column vectors, which is the same memory as row major for the row vectors used here.
+		if (ReadFloats(JsonParserClass::Find(*node, "matrix"), &matrix.m[0][0], 16))
+		{
+			local = XMLoadFloat4x4(&matrix);
+		}
+		else
+		{
+			translation[0] = translation[1] = translation[2] = 0.0f;
+			rotation[0] = rotation[1] = rotation[2] = 0.0f;
+			rotation[3] = 1.0f;
+			scale[0] = scale[1] = scale[2] = 1.0f;
+			ReadFloats(JsonParserClass::Find(*node, "translation"), translation, 3);
+			ReadFloats(JsonParserClass::Find(*node, "rotation"), rotation, 4);
+			ReadFloats(JsonParserClass::Find(*node, "scale"), scale, 3);
+
+			local = XMMatrixScaling(scale[0], scale[1], scale[2]) * XMMatrixRotationQuaternion(XMVectorSet(rotation[0], rotation[1], rotation[2], rotation[3])) *
+				XMMatrixTranslation(translation[0], translation[1], translation[2]);
+		}
+		XMStoreFloat4x4(&matrix, local * XMLoadFloat4x4(&parent));
+
+		mesh = JsonParserClass::GetInt(*node, "mesh", -1);
+		if (mesh >= (int)meshes->items.size())
+		{
+			return false;
+		}
+		if (mesh >= 0)
+		{
+			instance.mesh = mesh;
+			instance.world = matrix;
+			instances.push_back(instance);
+		}
+
+		children = JsonParserClass::GetArray(*node, "children");
+		for (i = children ? children->items.size() : 0; i > 0; i--)
+		{
+			stack.push_back(std::make_pair(children->items[i - 1].kind == JsonParserClass::KIND_NUMBER ? (int)children->items[i - 1].number : -1, matrix));
+		}
+	}
+
+	return true;
+}
+
+// ReadPrimitive adds one triangle list. Texture coordinates and normals may be missing, the vertices then get zeros for them.
+bool GltfLoaderClass::ReadPrimitive(const JsonParserClass::ValueType& primitive, const InstanceType& instance)
+{
+	const JsonParserClass::ValueType* attributes;
+	const AccessorType* positions;
+	const AccessorType* textures;
+	const AccessorType* normals;
+	const AccessorType* indices;
+	PrimitiveType entry;
+	int material;
+
+
+	if (JsonParserClass::GetInt(primitive, "mode", GLTF_MODE_TRIANGLES) != GLTF_MODE_TRIANGLES)
+	{
+		m_stats.skippedPrimitiveCount++;
+		return true;
+	}
+
+	attributes = JsonParserClass::Find(primitive, "attributes");
+	if (!attributes || !FindAccessor(*attributes, "POSITION", positions) || !FindAccessor(*attributes, "TEXCOORD_0", textures) ||
+		!FindAccessor(*attributes, "NORMAL", normals) || !FindAccessor(primitive, "indices", indices) || !positions)
+	{
+		return false;
+	}
+
+	if (positions->componentType != GLTF_FLOAT || positions->componentCount != 3 ||
+		(textures && (textures->componentCount != 2 || textures->count != positions->count)) ||
+		(normals && (normals->componentCount != 3 || normals->count != positions->count)) ||
+		(indices && (indices->componentCount != 1 || (indices->componentType != GLTF_UNSIGNED_BYTE &&
+		indices->componentType != GLTF_UNSIGNED_SHORT && indices->componentType != GLTF_UNSIGNED_INT))))
+	{
+		return false;
+	}
+
+	if (positions->count == 0)
+	{
+		m_stats.skippedPrimitiveCount++;
+		return true;
+	}
+
+	entry.mesh = instance.mesh;
+	material = JsonParserClass::GetInt(primitive, "material", -1);
+	entry.image = material >= 0 && material < (int)m_materialImages.size() ? m_materialImages[material] : -1;
+
+	// A mirroring transform turns the triangles inside out, so their winding is reversed to keep the front faces in front.
+	if (!ReadVertices(*positions, textures, normals, instance.world, entry) ||
+		!ReadIndices(indices, XMVectorGetX(XMMatrixDeterminant(XMLoadFloat4x4(&instance.world))) < 0.0f, entry))
+	{
+		return false;
+	}
+
+	m_primitives.push_back(entry);
+
+	return true;
+}
+
+// ReadVertices uses the accessors in place when they interleave float positions, texture coordinates and normals exactly as the
+// VertexType does and no node moves them. Other layouts, normalized integer attributes and placed meshes are converted.
+bool GltfLoaderClass::ReadVertices(const AccessorType& positions, const AccessorType* textures, const AccessorType* normals,
+	const XMFLOAT4X4& world, OUT PrimitiveType& primitive)
+{
+	XMMATRIX transform, normalTransform;
+	XMVECTOR normal;
+	VertexType* vertices;
+	float values[4];
+	bool identity;
+	unsigned int i;
+
+
+	identity = IsIdentity(world);
+	primitive.vertexCount = positions.count;
+
+	if (identity && textures && normals && positions.stride == sizeof(VertexType) && textures->stride == sizeof(VertexType) &&
+		normals->stride == sizeof(VertexType) && textures->componentType == GLTF_FLOAT && normals->componentType == GLTF_FLOAT &&
+		textures->data == positions.data + offsetof(VertexType, texture) && normals->data == positions.data + offsetof(VertexType, normal) &&
+		(uintptr_t)positions.data % alignof(VertexType) == 0)
+	{
+		primitive.vertices = (const VertexType*)positions.data;
+		primitive.verticesInPlace = true;
+		m_stats.vertexBytesInPlace += (size_t)positions.count * sizeof(VertexType);
+		return true;
+	}
+
+	transform = XMLoadFloat4x4(&world);
+	normalTransform = XMMatrixTranspose(XMMatrixInverse(nullptr, transform));
+
+	m_convertedVertices.emplace_back(positions.count);
+	vertices = m_convertedVertices.back().data();
+	for (i = 0; i < positions.count; i++)
+	{
+		ReadElement(positions, i, values);
+		vertices[i].position = XMFLOAT3(values[0], values[1], values[2]);
+
+		vertices[i].texture = XMFLOAT2(0.0f, 0.0f);
+		if (textures)
+		{
+			ReadElement(*textures, i, values);
+			vertices[i].texture = XMFLOAT2(values[0], values[1]);
+		}
+
+		vertices[i].normal = XMFLOAT3(0.0f, 0.0f, 0.0f);
+		if (normals)
+		{
+			ReadElement(*normals, i, values);
+			vertices[i].normal = XMFLOAT3(values[0], values[1], values[2]);
+		}
+
+		if (!identity)
+		{
+			XMStoreFloat3(&vertices[i].position, XMVector3TransformCoord(XMLoadFloat3(&vertices[i].position), transform));
+			normal = XMVector3TransformNormal(XMLoadFloat3(&vertices[i].normal), normalTransform);
+			XMStoreFloat3(&vertices[i].normal, XMVector3Normalize(normal));
+		}
+	}
+
+	primitive.vertices = vertices;
+	primitive.verticesInPlace = false;
+	m_stats.vertexBytesConverted += (size_t)positions.count * sizeof(VertexType);
+
+	return true;
+}
+
+// ReadIndices uses tightly packed 16 and 32 bit indices in place and checks that they stay inside the primitive's vertices.
+// 8 bit indices, a reversed winding and a missing accessor, which means the vertices are the triangle list, are converted to 32 bits.
+// A list that does not end on a whole triangle is rejected either way.
+bool GltfLoaderClass::ReadIndices(const AccessorType* indices, bool flipWinding, OUT PrimitiveType& primitive)
+{
+	const uint16_t* shortIndices;
+	const uint32_t* longIndices;
+	uint32_t* converted;
+	unsigned int i;
+
+
+	if ((indices ? indices->count : primitive.vertexCount) % 3 != 0)
+	{
+		return false;
+	}
+
+	if (indices && !flipWinding && indices->stride == indices->elementSize && (uintptr_t)indices->data % indices->elementSize == 0 &&
+		(indices->componentType == GLTF_UNSIGNED_SHORT || indices->componentType == GLTF_UNSIGNED_INT))
+	{
+		primitive.indices = indices->data;
+		primitive.indexCount = indices->count;
+		primitive.indexStride = indices->elementSize;
+		primitive.indicesInPlace = true;
+
+		if (primitive.indexStride == sizeof(uint16_t))
+		{
+			shortIndices = (const uint16_t*)indices->data;
+			for (i = 0; i < indices->count; i++)
+			{
+				if (shortIndices[i] >= primitive.vertexCount)
+				{
+					return false;
+				}
+			}
+		}
+		else
+		{
+			longIndices = (const uint32_t*)indices->data;
+			for (i = 0; i < indices->count; i++)
+			{
+				if (longIndices[i] >= primitive.vertexCount)
+				{
+					return false;
+				}
+			}
+		}
+
+		m_stats.indexBytesInPlace += (size_t)indices->count * indices->elementSize;
+		return true;
+	}
+
+	m_convertedIndices.emplace_back(indices ? indices->count : primitive.vertexCount);
+	converted = m_convertedIndices.back().data();
+	for (i = 0; i < m_convertedIndices.back().size(); i++)
+	{
+		converted[i] = indices ? ReadIndex(*indices, i) : i;
+
+		if (converted[i] >= primitive.vertexCount)
+		{
+			return false;
+		}
+	}
+
+	if (flipWinding)
+	{
+		for (i = 0; i + 2 < m_convertedIndices.back().size(); i += 3)
+		{
+			std::swap(converted[i + 1], converted[i + 2]);
+		}
+	}
+
+	primitive.indices = converted;
+	primitive.indexCount = (unsigned int)m_convertedIndices.back().size();
+	primitive.indexStride = sizeof(uint32_t);
+	primitive.indicesInPlace = false;
+	m_stats.indexBytesConverted += m_convertedIndices.back().size() * sizeof(uint32_t);
+
+	return true;
+}
+
+// FindAccessor fails only for a reference to an accessor that does not exist or has no data, a missing key leaves it null.
+bool GltfLoaderClass::FindAccessor(const JsonParserClass::ValueType& object, const char* key, OUT const AccessorType*& accessor)
+{
+	int index;
+
+
+	accessor = 0;
+	if (!JsonParserClass::Find(object, key))
+	{
+		return true;
+	}
+
+	index = JsonParserClass::GetInt(object, key, -1);
+	if (index < 0 || index >= (int)m_accessors.size() || !m_accessors[index].data)
+	{
+		return false;
+	}
+
+	accessor = &m_accessors[index];
+
+	return true;
+}
+
+// DecodeDataUri decodes a base64 data uri into an array the loader keeps until Shutdown.
+bool GltfLoaderClass::DecodeDataUri(const char* uri, OUT const unsigned char*& data, OUT size_t& size)
+{
+	const char* payload;
+	unsigned int bits, bitCount, digit;
+	char c;
+
+
+	payload = strchr(uri, ',');
+	if (!payload || payload - uri < 7 || strncmp(payload - 7, ";base64", 7) != 0)
+	{
+		return false;
+	}
+
+	m_decodedData.emplace_back();
+	std::vector<unsigned char>& decoded = m_decodedData.back();
+	decoded.reserve(strlen(payload) / 4 * 3);
+
+	bits = 0;
+	bitCount = 0;
+	for (payload++; *payload && *payload != '='; payload++)
+	{
+		c = *payload;
+		if (c >= 'A' && c <= 'Z') digit = (unsigned int)(c - 'A');
+		else if (c >= 'a' && c <= 'z') digit = (unsigned int)(c - 'a' + 26);
+		else if (c >= '0' && c <= '9') digit = (unsigned int)(c - '0' + 52);
+		else if (c == '+') digit = 62;
+		else if (c == '/') digit = 63;
+		else return false;
+
+		bits = (bits << 6) | digit;
+		bitCount += 6;
+		if (bitCount >= 8)
+		{
+			bitCount -= 8;
+			decoded.push_back((unsigned char)(bits >> bitCount));
+		}
+	}
+
+	data = decoded.data();
+	size = decoded.size();
+
+	return true;
+}
+
+// ReadElement reads up to four components of one element as floats, scaling normalized integers into [0, 1] or [-1, 1].
+void GltfLoaderClass::ReadElement(const AccessorType& accessor, unsigned int index, OUT float* values)
+{
+	const unsigned char* element;
+	unsigned int i, count;
+	int8_t s8;
+	int16_t s16;
+	uint16_t u16;
+	uint32_t u32;
+
+
+	element = accessor.data + (size_t)index * accessor.stride;
+	count = accessor.componentCount < 4 ? accessor.componentCount : 4;
+	for (i = 0; i < count; i++)
+	{
+		switch (accessor.componentType)
+		{
+		case GLTF_FLOAT:
+			memcpy(&values[i], element + i * 4, 4);
+			break;
+		case GLTF_UNSIGNED_INT:
+			memcpy(&u32, element + i * 4, 4);
+			values[i] = (float)u32;
+			break;
+		case GLTF_UNSIGNED_SHORT:
+			memcpy(&u16, element + i * 2, 2);
+			values[i] = accessor.normalized ? u16 / 65535.0f : (float)u16;
+			break;
+		case GLTF_SHORT:
+			memcpy(&s16, element + i * 2, 2);
+			values[i] = accessor.normalized ? (s16 / 32767.0f < -1.0f ? -1.0f : s16 / 32767.0f) : (float)s16;
+			break;
+		case GLTF_UNSIGNED_BYTE:
+			values[i] = accessor.normalized ? element[i] / 255.0f : (float)element[i];
+			break;
+		default:
+			memcpy(&s8, element + i, 1);
+			values[i] = accessor.normalized ? (s8 / 127.0f < -1.0f ? -1.0f : s8 / 127.0f) : (float)s8;
+			break;
+		}
+	}
+
+	return;
+}
+
+// ReadIndex reads one element of an index accessor as the integer it is. Going through a float like ReadElement does would round
+// the 32 bit indices above 2^24.
+uint32_t GltfLoaderClass::ReadIndex(const AccessorType& accessor, unsigned int index)
+{
+	const unsigned char* element;
+	uint16_t u16;
+	uint32_t u32;
+
+
+	element = accessor.data + (size_t)index * accessor.stride;
+	switch (accessor.componentType)
+	{
+	case GLTF_UNSIGNED_INT:
+		memcpy(&u32, element, 4);
+		return u32;
+	case GLTF_UNSIGNED_SHORT:
+		memcpy(&u16, element, 2);
+		return u16;
+	default:
+		return element[0];
+	}
+}
+
+// DecodeUri undoes the percent encoding of a relative file uri.
+std::string GltfLoaderClass::DecodeUri(const char* uri)
+{
+	std::string path;
+	unsigned int value;
+	char hex[3];
+
+
+	for (; *uri; uri++)
+	{
+		if (uri[0] == '%' && isxdigit((unsigned char)uri[1]) && isxdigit((unsigned char)uri[2]))
+		{
+			hex[0] = uri[1];
+			hex[1] = uri[2];
+			hex[2] = 0;
+			value = (unsigned int)strtoul(hex, 0, 16);
+			path += (char)value;
+			uri += 2;
+		}
+		else
+		{
+			path += *uri;
+		}
+	}
+
+	return path;
+}
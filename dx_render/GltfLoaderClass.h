@@ -0,0 +1,146 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: gltfloaderclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _GLTFLOADERCLASS_H_
+#define _GLTFLOADERCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <cstdint>
+#include <string>
+#include <vector>
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "meshtypes.h"
+#include "mappedfileclass.h"
+#include "jsonparserclass.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: GltfLoaderClass
+////////////////////////////////////////////////////////////////////////////////
+// The GltfLoaderClass loads the triangle meshes of a binary .glb file, or of a .gltf file with its buffers, for upload.
+// The file and any external buffers are memory mapped. An accessor whose data is already laid out as the VertexType array, or as
+// 16 or 32 bit indices, is handed out as a pointer into the mapping. Only the primitives that do not match, are placed by a node
+// transform or have no index accessor are converted into arrays the loader owns. All of it stays valid until Shutdown.
+// Images are handed out the same way: embedded ones as the bytes in the buffer, external ones as a file name next to the model.
+class GltfLoaderClass
+{
+public:
+	// One primitive of one mesh as placed by one node, its indices are 16 or 32 bits wide as given by indexStride.
+	struct PrimitiveType
+	{
+		const VertexType* vertices;
+		const void* indices;
+		unsigned int vertexCount, indexCount, indexStride;
+		int mesh, image;
+		bool verticesInPlace, indicesInPlace;
+	};
+
+	// The part of the mesh GetMesh returns that one primitive draws, with the base color image of its material, -1 for none.
+	struct RangeType
+	{
+		unsigned int firstIndex, indexCount;
+		int image;
+	};
+
+	struct ImageType
+	{
+		const unsigned char* data;
+		size_t size;
+		std::string mimeType;
+		std::string filename;
+	};
+
+	struct LoadStatsType
+	{
+		size_t fileSize;
+		unsigned int meshCount, primitiveCount, skippedPrimitiveCount, imageCount;
+		size_t vertexBytesInPlace, vertexBytesConverted, indexBytesInPlace, indexBytesConverted, mergedBytes;
+		double loadSeconds;
+	};
+
+private:
+	// A byte range of a buffer, for buffer views with the stride their accessors step by, 0 when they are tightly packed.
+	struct BufferViewType
+	{
+		const unsigned char* data;
+		size_t size;
+		unsigned int stride;
+	};
+
+	struct AccessorType
+	{
+		const unsigned char* data;
+		unsigned int count, componentType, componentCount, elementSize, stride;
+		bool normalized;
+	};
+
+	struct InstanceType
+	{
+		int mesh;
+		XMFLOAT4X4 world;
+	};
+
+public:
+	GltfLoaderClass();
+	GltfLoaderClass(const GltfLoaderClass&);
+	~GltfLoaderClass();
+
+	bool Initialize(const char* filename);
+	void Shutdown();
+
+	const std::vector<PrimitiveType>& GetPrimitives();
+	const std::vector<ImageType>& GetImages();
+	bool GetMesh(OUT const VertexType*& out_verts, OUT unsigned int& vertexCount, OUT const void*& out_indices, OUT unsigned int& indexCount,
+		OUT unsigned int& indexStride, OUT std::vector<RangeType>& out_ranges);
+	LoadStatsType GetStats();
+
+private:
+	bool ReadContainer(OUT const char*& jsonBegin, OUT const char*& jsonEnd);
+	bool ReadBuffers(const JsonParserClass::ValueType& root, const std::string& directory);
+	bool ReadBufferViews(const JsonParserClass::ValueType& root);
+	bool ReadAccessors(const JsonParserClass::ValueType& root);
+	bool ReadImages(const JsonParserClass::ValueType& root, const std::string& directory);
+	void ReadMaterials(const JsonParserClass::ValueType& root);
+	bool ReadScene(const JsonParserClass::ValueType& root, OUT std::vector<InstanceType>& instances);
+	bool ReadPrimitive(const JsonParserClass::ValueType& primitive, const InstanceType& instance);
+	bool ReadVertices(const AccessorType& positions, const AccessorType* textures, const AccessorType* normals, const XMFLOAT4X4& world,
+		OUT PrimitiveType& primitive);
+	bool ReadIndices(const AccessorType* indices, bool flipWinding, OUT PrimitiveType& primitive);
+	bool FindAccessor(const JsonParserClass::ValueType& object, const char* key, OUT const AccessorType*& accessor);
+	bool DecodeDataUri(const char* uri, OUT const unsigned char*& data, OUT size_t& size);
+
+	static void ReadElement(const AccessorType& accessor, unsigned int index, OUT float* values);
+	static uint32_t ReadIndex(const AccessorType& accessor, unsigned int index);
+	static std::string DecodeUri(const char* uri);
+
+private:
+	std::string m_filename;
+	MappedFileClass m_file;
+	std::vector<MappedFileClass*> m_externalFiles;
+	std::vector<std::vector<unsigned char>> m_decodedData;
+	const unsigned char* m_binChunk;
+	size_t m_binChunkSize;
+
+	std::vector<BufferViewType> m_buffers, m_bufferViews;
+	std::vector<AccessorType> m_accessors;
+	std::vector<int> m_textureImages, m_materialImages;
+	std::vector<ImageType> m_images;
+	std::vector<PrimitiveType> m_primitives;
+
+	// The arrays of the converted primitives and, when they are not already one block in the file, of the merged mesh.
+	std::vector<std::vector<VertexType>> m_convertedVertices;
+	std::vector<std::vector<uint32_t>> m_convertedIndices;
+	std::vector<VertexType> m_mergedVertices;
+	std::vector<uint32_t> m_mergedIndices;
+	std::vector<uint16_t> m_mergedShortIndices;
+
+	LoadStatsType m_stats;
+};
+
+#endif
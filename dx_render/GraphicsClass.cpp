@@ -2,15 +2,44 @@
 // Filename: graphicsclass.cpp
 ////////////////////////////////////////////////////////////////////////////////
 #include "graphicsclass.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
 
 
 GraphicsClass::GraphicsClass()
 {
+#ifdef _WIN32
 	m_D3D = nullptr;
+	m_D3DDevice = nullptr;
+	m_hwnd = 0;
+#endif
+	m_Device = nullptr;
+	m_StateFilter = nullptr;
 	m_Camera = nullptr;
+	m_TransformBatch = nullptr;
+	m_GeometryPool = nullptr;
 	m_Model = nullptr;
+	m_StaticBatch = nullptr;
+	m_InstanceBatch = nullptr;
 	// m_ColorShader = nullptr;
 	m_TextureShader = nullptr;
+	m_ConstantRing = nullptr;
+	m_RenderQueue = nullptr;
+	memset(m_commandLists, 0, sizeof(m_commandLists));
+	m_commandListCount = 0;
+	m_RecordPool = nullptr;
+	m_options.modelFileName = "../cube.obj";
+	m_options.progressive = MODEL_PROGRESSIVE;
+	m_options.staticPropCount = STATIC_PROP_COUNT;
+	m_options.instanceCount = MODEL_INSTANCE_COUNT;
+	m_options.recordThreadCount = RECORD_THREAD_COUNT;
+	m_options.recordMinPackets = RECORD_MIN_PACKETS;
+	m_staticPropSeconds = 0.0;
+	m_screenHeight = 0;
+	memset(&m_frameStats, 0, sizeof(m_frameStats));
+	m_instanceUploadStart = 0;
 }
 
 GraphicsClass::GraphicsClass(const GraphicsClass& other)
@@ -21,12 +50,28 @@ GraphicsClass::~GraphicsClass()
 {
 }
 
+// SetSceneOptions changes what the next Initialize loads. The file name is not copied and has to stay valid until then.
+void GraphicsClass::SetSceneOptions(const SceneOptionsType& options)
+{
+	m_options = options;
+
+	return;
+}
+
+
+GraphicsClass::SceneOptionsType GraphicsClass::GetSceneOptions()
+{
+	return m_options;
+}
+
+#ifdef _WIN32
 bool GraphicsClass::Initialize(int screenWidth, int screenHeight, HWND hwnd)
 {
 	bool result;
-	const char* modelFileName = "../cube.obj";
 
 
+	m_hwnd = hwnd;
+
 	// Create the Direct3D object.
 	m_D3D = new D3DClass;
 	if (!m_D3D)
@@ -41,6 +86,69 @@ bool GraphicsClass::Initialize(int screenWidth, int screenHeight, HWND hwnd)
 		MessageBox(hwnd, L"Could not initialize Direct3D", L"Error", MB_OK);
 		return false;
 	}
+
+	// Create the render device everything is drawn through on top of it.
+	m_D3DDevice = new D3DRenderDeviceClass;
+	if (!m_D3DDevice)
+	{
+		return false;
+	}
+
+	result = m_D3DDevice->Initialize(m_D3D, hwnd);
+	if (!result)
+	{
+		MessageBox(hwnd, L"Could not initialize the render device", L"Error", MB_OK);
+		return false;
+	}
+	m_Device = m_D3DDevice;
+
+	return InitializeScene(screenWidth, screenHeight);
+}
+#endif
+
+// This Initialize draws through a device that is already initialized and stays the caller's, it is not shut down with the graphics.
+bool GraphicsClass::Initialize(RenderDeviceClass* device, int screenWidth, int screenHeight)
+{
+	m_Device = device;
+
+	return InitializeScene(screenWidth, screenHeight);
+}
+
+// InitializeScene puts the state filter in front of m_Device and creates the camera, the model, the props and the shaders on it.
+bool GraphicsClass::InitializeScene(int screenWidth, int screenHeight)
+{
+	bool result;
+	const char* modelFileName = m_options.modelFileName;
+	const VertexElementDescType* layout;
+	unsigned int layoutElementCount;
+	MeshCompressionClass compression;
+
+
+	// Everything below draws through the state filter when there is one, it passes on to the device only the binds that change state.
+	if (FILTER_REDUNDANT_STATE)
+	{
+		m_StateFilter = new StateFilterRenderDeviceClass;
+		if (!m_StateFilter)
+		{
+			return false;
+		}
+
+		result = m_StateFilter->Initialize(m_Device);
+		if (!result)
+		{
+			ShowError(L"Could not initialize the state filter.");
+			return false;
+		}
+		m_Device = m_StateFilter;
+	}
+
+	// The level of detail is picked by its error in pixels, which needs the height of the screen.
+	m_screenHeight = screenHeight;
+
+	// The same projection D3DClass sets up, and the model stays at the origin.
+	XMStoreFloat4x4(&m_projectionMatrix, XMMatrixPerspectiveFovLH(XM_PI / 4.0f, (float)screenWidth / (float)screenHeight, SCREEN_NEAR, SCREEN_DEPTH));
+	XMStoreFloat4x4(&m_worldMatrix, XMMatrixIdentity());
+
 	// Create the camera object.
 	m_Camera = new CameraClass;
 	if (!m_Camera)
@@ -51,6 +159,29 @@ bool GraphicsClass::Initialize(int screenWidth, int screenHeight, HWND hwnd)
 	// Set the initial position of the camera.
 	m_Camera->SetPosition(0.0f, 0.0f, -10.0f);
 
+	// Create the object that works out the shader constants of the frame and of every object in it.
+	m_TransformBatch = new TransformBatchClass;
+	if (!m_TransformBatch)
+	{
+		return false;
+	}
+
+	// Create the geometry pool the model is uploaded into. Its vertices have the stride of the model's vertex format, and its
+	// indices are 16 bit when large meshes are split to fit them.
+	m_GeometryPool = new GeometryPoolClass;
+	if (!m_GeometryPool)
+	{
+		return false;
+	}
+
+	result = m_GeometryPool->Initialize(m_Device, compression.GetVertexStride(MODEL_VERTEX_FORMAT),
+		MODEL_SPLIT_LARGE_MESHES ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT, GEOMETRY_POOL_VERTICES, GEOMETRY_POOL_INDICES);
+	if (!result)
+	{
+		ShowError(L"Could not initialize the geometry pool.");
+		return false;
+	}
+
 	// Create the model object.
 	m_Model = new ModelClass;
 	if (!m_Model)
@@ -59,14 +190,42 @@ bool GraphicsClass::Initialize(int screenWidth, int screenHeight, HWND hwnd)
 	}
 
 	// Initialize the model object.
-	// result = m_Model->Initialize(m_D3D->GetDevice());
-	result = m_Model->Initialize(m_D3D->GetDevice(), modelFileName, L"../happy.dds");
+	// result = m_Model->Initialize(m_Device);
+	m_Model->SetVertexFormat(MODEL_VERTEX_FORMAT, MODEL_SPLIT_LARGE_MESHES);
+	m_Model->SetSplitStreams(MODEL_SPLIT_VERTEX_STREAMS);
+	m_Model->SetMeshletLimits(MODEL_MESHLET_MAX_VERTICES, MODEL_MESHLET_MAX_TRIANGLES);
+	m_Model->SetLodThreshold(MODEL_LOD_PIXEL_ERROR, MODEL_LOD_HYSTERESIS);
+	m_Model->SetProgressive(m_options.progressive, MODEL_REFINE_BYTES_PER_FRAME);
+	m_Model->SetGeometryPool(m_GeometryPool);
+	result = m_Model->Initialize(m_Device, modelFileName, L"../happy.dds");
 	if (!result)
 	{
-		MessageBox(hwnd, L"Could not initialize the model object.", L"Error", MB_OK);
+		ShowError(L"Could not initialize the model object.");
 		return false;
 	}
 
+	// Scatter copies of the model around it as static props, if there are any.
+	if (m_options.staticPropCount > 0)
+	{
+		result = InitializeStaticProps(modelFileName);
+		if (!result)
+		{
+			ShowError(L"Could not initialize the static props.");
+			return false;
+		}
+	}
+
+	// And copies of it that are drawn as instances, if there are any.
+	if (m_options.instanceCount > 0)
+	{
+		result = InitializeInstances();
+		if (!result)
+		{
+			ShowError(L"Could not initialize the instances.");
+			return false;
+		}
+	}
+
 	//// Create the color shader object.
 	//m_ColorShader = new ColorShaderClass;
 	//if (!m_ColorShader)
@@ -75,10 +234,10 @@ bool GraphicsClass::Initialize(int screenWidth, int screenHeight, HWND hwnd)
 	//}
 
 	//// Initialize the color shader object.
-	//result = m_ColorShader->Initialize(m_D3D->GetDevice(), hwnd);
+	//result = m_ColorShader->Initialize(m_Device);
 	//if (!result)
 	//{
-	//	MessageBox(hwnd, L"Could not initialize the color shader object.", L"Error", MB_OK);
+	//	ShowError(L"Could not initialize the color shader object.");
 	//	return false;
 	//}
 	// Create the texture shader object.
@@ -88,14 +247,70 @@ bool GraphicsClass::Initialize(int screenWidth, int screenHeight, HWND hwnd)
 		return false;
 	}
 
-	// Initialize the texture shader object.
-	result = m_TextureShader->Initialize(m_D3D->GetDevice(), hwnd);
+	// Initialize the texture shader object with the input layout of the model's vertex format.
+	m_Model->GetInputLayout(VERTEX_STREAM_ALL, layout, layoutElementCount);
+	result = m_TextureShader->Initialize(m_Device, layout, layoutElementCount);
 	if (!result)
 	{
-		MessageBox(hwnd, L"Could not initialize the texture shader object.", L"Error", MB_OK);
+		ShowError(L"Could not initialize the texture shader object.");
+		return false;
+	}
+
+	// Write the constants of every draw into one ring instead of mapping the shader's buffer per draw. On a device that can not bind
+	// part of a constant buffer the shader keeps its own buffer.
+	if (CONSTANT_RING_SIZE > 0)
+	{
+		m_ConstantRing = new ConstantRingClass;
+		if (!m_ConstantRing)
+		{
+			return false;
+		}
+
+		result = m_ConstantRing->Initialize(m_Device, CONSTANT_RING_SIZE);
+		if (result)
+		{
+			m_TextureShader->SetConstantRing(m_ConstantRing);
+		}
+		else
+		{
+			printf("Constant ring not supported, mapping a constant buffer per draw\n");
+			m_ConstantRing->Shutdown();
+			delete m_ConstantRing;
+			m_ConstantRing = 0;
+		}
+	}
+
+	// Create the queue the draws of every frame are sorted in.
+	m_RenderQueue = new RenderQueueClass;
+	if (!m_RenderQueue)
+	{
 		return false;
 	}
 
+	m_RenderQueue->Initialize(RENDER_QUEUE_CAPACITY);
+
+	// Make a command list for every thread that may record draws. The draws of a list bind slices of the constant ring.
+	if (m_ConstantRing)
+	{
+		while (m_commandListCount < RECORD_THREAD_COUNT && m_commandListCount < m_options.recordThreadCount &&
+			m_Device->CreateCommandList(m_commandLists[m_commandListCount]))
+		{
+			m_commandListCount++;
+		}
+	}
+
+	// Start the threads that record all but the first list, they wait for the frames that have enough draws for them.
+	if (m_commandListCount > 1)
+	{
+		m_RecordPool = new WorkerPoolClass;
+		if (!m_RecordPool)
+		{
+			return false;
+		}
+
+		m_RecordPool->Initialize(m_commandListCount - 1);
+	}
+
 	return true;
 }
 
@@ -108,6 +323,30 @@ void GraphicsClass::Shutdown()
 	//	delete m_ColorShader;
 	//	m_ColorShader = 0;
 	//}
+	// Stop the recording threads.
+	if (m_RecordPool)
+	{
+		m_RecordPool->Shutdown();
+		delete m_RecordPool;
+		m_RecordPool = 0;
+	}
+
+	// Release the command lists.
+	while (m_commandListCount > 0)
+	{
+		m_commandListCount--;
+		m_Device->ReleaseCommandList(m_commandLists[m_commandListCount]);
+		m_commandLists[m_commandListCount] = RENDER_HANDLE_NONE;
+	}
+
+	// Release the render queue.
+	if (m_RenderQueue)
+	{
+		m_RenderQueue->Shutdown();
+		delete m_RenderQueue;
+		m_RenderQueue = 0;
+	}
+
 	// Release the texture shader object.
 	if (m_TextureShader)
 	{
@@ -116,6 +355,14 @@ void GraphicsClass::Shutdown()
 		m_TextureShader = 0;
 	}
 
+	// Release the constant ring after the shaders that wrote to it.
+	if (m_ConstantRing)
+	{
+		m_ConstantRing->Shutdown();
+		delete m_ConstantRing;
+		m_ConstantRing = 0;
+	}
+
 	// Release the model object.
 	if (m_Model)
 	{
@@ -124,12 +371,62 @@ void GraphicsClass::Shutdown()
 		m_Model = 0;
 	}
 
+	// Release the static props.
+	if (m_StaticBatch)
+	{
+		m_StaticBatch->Shutdown();
+		delete m_StaticBatch;
+		m_StaticBatch = 0;
+	}
+
+	// Release the instances.
+	if (m_InstanceBatch)
+	{
+		m_InstanceBatch->Shutdown();
+		delete m_InstanceBatch;
+		m_InstanceBatch = 0;
+	}
+
+	// Release the geometry pool after the models that were in it.
+	if (m_GeometryPool)
+	{
+		m_GeometryPool->Shutdown();
+		delete m_GeometryPool;
+		m_GeometryPool = 0;
+	}
+
+	// Release the transform batch object.
+	if (m_TransformBatch)
+	{
+		delete m_TransformBatch;
+		m_TransformBatch = 0;
+	}
+
 	// Release the camera object.
 	if (m_Camera)
 	{
 		delete m_Camera;
 		m_Camera = 0;
 	}
+	m_Device = 0;
+
+	// Release the state filter before the device behind it.
+	if (m_StateFilter)
+	{
+		m_StateFilter->Shutdown();
+		delete m_StateFilter;
+		m_StateFilter = 0;
+	}
+
+#ifdef _WIN32
+	// Release the render device and then the D3D object it draws with.
+	if (m_D3DDevice)
+	{
+		m_D3DDevice->Shutdown();
+		delete m_D3DDevice;
+		m_D3DDevice = 0;
+	}
+
 	// Release the D3D object
 	if (m_D3D)
 	{
@@ -137,6 +434,7 @@ void GraphicsClass::Shutdown()
 		delete m_D3D;
 		m_D3D = 0;
 	}
+#endif
 	return;
 }
 
@@ -154,41 +452,463 @@ bool GraphicsClass::Frame()
 	return true;
 }
 
+// GetFrameStats returns the stats summed over the frames since ResetFrameStats. The constant ring's are its own, kept since it was
+// made, the instances' are those of the last frame but for the bytes uploaded since ResetFrameStats, and the static props' are those
+// of their batch and the time it took to build and upload it when the scene was initialized. All are zero without them.
+GraphicsClass::FrameStatsType GraphicsClass::GetFrameStats()
+{
+	if (m_ConstantRing)
+	{
+		m_frameStats.constantRing = m_ConstantRing->GetStats();
+	}
+
+	if (m_InstanceBatch)
+	{
+		m_frameStats.instances = m_InstanceBatch->GetStats();
+		m_frameStats.instances.uploadBytes -= m_instanceUploadStart;
+	}
+
+	if (m_StaticBatch)
+	{
+		m_frameStats.staticProps = m_StaticBatch->GetBuildStats();
+		m_frameStats.staticPropSeconds = m_staticPropSeconds;
+	}
+
+	return m_frameStats;
+}
+
+
+void GraphicsClass::ResetFrameStats()
+{
+	memset(&m_frameStats, 0, sizeof(m_frameStats));
+	m_instanceUploadStart = m_InstanceBatch ? m_InstanceBatch->GetStats().uploadBytes : 0;
+
+	return;
+}
+
+// InitializeStaticProps places the scene options' staticPropCount copies of the model at random spots, turns and sizes on the ground around it and
+// merges them into a static batch. The props are taken from the finest level of detail in the mesh cache the model left behind, a
+// model without one, such as a glTF file, gets no props. They share the model's materials and vertex format.
+bool GraphicsClass::InitializeStaticProps(const char* modelFileName)
+{
+	MeshCacheClass cache;
+	std::string cacheFileName;
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> position(-0.5f * STATIC_PROP_SPREAD, 0.5f * STATIC_PROP_SPREAD);
+	std::uniform_real_distribution<float> angle(0.0f, XM_2PI);
+	std::uniform_real_distribution<float> scale(0.5f, 2.0f);
+	XMMATRIX propMatrix;
+	float size;
+	unsigned int i;
+	bool result;
+
+
+	// The props are drawn with the model's input layout but their batch is interleaved.
+	if (MODEL_SPLIT_VERTEX_STREAMS)
+	{
+		printf("The static props can not be drawn with the split vertex streams of the model, leaving them out\n");
+		return true;
+	}
+
+	cacheFileName = MeshCacheClass::GetCacheFilename(modelFileName);
+	if (!cache.Initialize(cacheFileName.c_str(), modelFileName) || cache.GetLodCount() == 0)
+	{
+		printf("No mesh cache for %s, leaving out the static props\n", modelFileName);
+		return true;
+	}
+
+	m_StaticBatch = new StaticBatchClass;
+	if (!m_StaticBatch)
+	{
+		return false;
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	m_StaticBatch->SetCellSize(STATIC_BATCH_CELL_SIZE);
+	for (i = 0; i < m_options.staticPropCount; i++)
+	{
+		size = scale(random);
+		propMatrix = XMMatrixScaling(size, size, size) * XMMatrixRotationY(angle(random));
+		propMatrix = propMatrix * XMMatrixTranslation(position(random), 0.0f, position(random));
+		m_StaticBatch->AddMesh(cache.GetVertices(), cache.GetIndices(), cache.GetSubmeshes() + cache.GetLods()[0].firstSubmesh,
+			cache.GetLods()[0].submeshCount, propMatrix);
+	}
+	cache.Shutdown();
+
+	m_StaticBatch->Build();
+
+	result = m_StaticBatch->Initialize(m_Device, MODEL_VERTEX_FORMAT, m_GeometryPool);
+	if (!result)
+	{
+		return false;
+	}
+	m_staticPropSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	return true;
+}
+
+// InitializeInstances places the scene options' instanceCount copies of the model at random spots, turns and sizes on the ground
+// around it, the same way as the static props. They are drawn from the model's own buffers, so they need none of their own besides
+// the instance stream.
+bool GraphicsClass::InitializeInstances()
+{
+	std::mt19937 random(2);
+	std::uniform_real_distribution<float> position(-0.5f * MODEL_INSTANCE_SPREAD, 0.5f * MODEL_INSTANCE_SPREAD);
+	std::uniform_real_distribution<float> angle(0.0f, XM_2PI);
+	std::uniform_real_distribution<float> scale(0.5f, 2.0f);
+	XMMATRIX decodeMatrix, instanceMatrix;
+	XMFLOAT3 boundsCenter;
+	float boundsRadius, size;
+	unsigned int i;
+	bool result;
+
+
+	// A model without levels of detail, such as a glTF file, has no ranges to draw the instances with.
+	if (m_Model->GetLodCount() == 0)
+	{
+		printf("The model has no levels of detail to draw instances of, leaving them out\n");
+		return true;
+	}
+
+	m_InstanceBatch = new InstanceBatchClass;
+	if (!m_InstanceBatch)
+	{
+		return false;
+	}
+
+	result = m_InstanceBatch->Initialize(m_Device, m_options.instanceCount);
+	if (!result)
+	{
+		return false;
+	}
+
+	m_Model->GetPositionDecodeMatrix(decodeMatrix);
+	m_Model->GetBounds(boundsCenter, boundsRadius);
+	m_InstanceBatch->SetMesh(decodeMatrix, boundsCenter, boundsRadius);
+
+	for (i = 0; i < m_options.instanceCount; i++)
+	{
+		size = scale(random);
+		instanceMatrix = XMMatrixScaling(size, size, size) * XMMatrixRotationY(angle(random));
+		instanceMatrix = instanceMatrix * XMMatrixTranslation(position(random), 0.0f, position(random));
+		m_InstanceBatch->AddInstance(instanceMatrix);
+	}
+
+	return true;
+}
+
+// ShowError tells the user why Initialize failed, in a message box over the window or on the error output without one.
+void GraphicsClass::ShowError(const wchar_t* message)
+{
+#ifdef _WIN32
+	if (m_hwnd)
+	{
+		MessageBox(m_hwnd, message, L"Error", MB_OK);
+		return;
+	}
+#endif
+	fwprintf(stderr, L"%ls\n", message);
+
+	return;
+}
+
 bool GraphicsClass::Render()
 {
-	XMMATRIX viewMatrix, projectionMatrix, worldMatrix;
+	XMMATRIX viewMatrix, projectionMatrix, worldMatrix, decodeMatrix;
+	XMMATRIX objectWorldMatrices[RENDER_OBJECT_COUNT];
+	TransformBatchClass::ObjectConstantsType objectConstants[RENDER_OBJECT_COUNT];
+	RenderQueueClass::PacketType packet;
+	MeshletClass::CullStatsType cullStats;
+	unsigned int threadCount;
 	bool result;
+	int lod, i;
 
 
 	// Clear the buffers to begin the scene.
-	m_D3D->BeginScene(0.0f, 0.2f, 0.0f, 1.0f);
+	m_Device->BeginScene(0.0f, 0.2f, 0.0f, 1.0f);
+
+	// Give back the constants of the frames the GPU is done with.
+	if (m_ConstantRing)
+	{
+		m_ConstantRing->BeginFrame();
+	}
 
 	// Generate the view matrix based on the camera's position.
 	m_Camera->Render();
 
-	// Get the world, view, and projection matrices from the camera and d3d objects.
+	// Get the world, view, and projection matrices from the camera and the screen.
 	m_Camera->GetViewMatrix(viewMatrix);
-	m_D3D->GetWorldMatrix(worldMatrix);
-	m_D3D->GetProjectionMatrix(projectionMatrix);
+	worldMatrix = XMLoadFloat4x4(&m_worldMatrix);
+	projectionMatrix = XMLoadFloat4x4(&m_projectionMatrix);
+
+	// Upload the camera matrices once for every draw of the frame.
+	m_TransformBatch->SetViewProjection(viewMatrix, projectionMatrix);
+	result = m_TextureShader->SetFrameParameters(m_Device, m_TransformBatch->GetFrameConstants());
+	if (!result)
+	{
+		return false;
+	}
+
+	// Stream in more of a progressive model while it is still coarser than the screen needs.
+	m_Model->Refine(m_Device);
+
+	// Pick the level of detail of the model and reject its clusters that are off screen or facing away from the camera.
+	std::chrono::steady_clock::time_point cullStart = std::chrono::steady_clock::now();
+	m_Model->Cull(worldMatrix, viewMatrix, projectionMatrix, m_screenHeight);
+	m_frameStats.cullSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - cullStart).count();
+
+	cullStats = m_Model->GetCullStats();
+	m_frameStats.frameCount++;
+	m_frameStats.trianglesDrawn += cullStats.triangleCount - cullStats.trianglesCulled;
+	m_frameStats.trianglesCulled += cullStats.trianglesCulled;
+	m_frameStats.lastCull = cullStats;
+	m_frameStats.lod = m_Model->GetLod();
+	m_frameStats.lodCount = m_Model->GetLodCount();
+
+	// Compact vertex formats store positions relative to the model bounds, the decode matrix scales them back before the world matrix.
+	// The static props are in world space already, so they only need their decode matrix.
+	m_Model->GetPositionDecodeMatrix(decodeMatrix);
+	objectWorldMatrices[RENDER_OBJECT_MODEL] = XMMatrixMultiply(decodeMatrix, worldMatrix);
+	objectWorldMatrices[RENDER_OBJECT_STATIC_PROPS] = XMMatrixIdentity();
+	objectWorldMatrices[RENDER_OBJECT_INSTANCES] = XMMatrixIdentity();
+	if (m_StaticBatch)
+	{
+		m_StaticBatch->GetPositionDecodeMatrix(objectWorldMatrices[RENDER_OBJECT_STATIC_PROPS]);
+	}
+
+	// Work out the constants of every object drawn this frame in one batch.
+	m_TransformBatch->Transform(objectWorldMatrices, RENDER_OBJECT_COUNT, objectConstants);
 
-	// Put the model vertex and index buffers on the graphics pipeline to prepare them for drawing.
-	m_Model->Render(m_D3D->GetDeviceContext());
+	// Queue a packet for every visible index range of the model, with the texture of its material.
+	m_RenderQueue->Reset();
+	for (i = 0; i < m_Model->GetVisibleRangeCount(); i++)
+	{
+		packet.range = m_Model->GetVisibleRange(i);
+		packet.key = RenderQueueClass::MakeKey(RENDER_PASS_OPAQUE, RENDER_SHADER_TEXTURE, packet.range.material,
+			m_Model->GetVisibleRangeDepth(i));
+		packet.geometry = RENDER_OBJECT_MODEL;
+		packet.object = RENDER_OBJECT_MODEL;
+		packet.texture = m_Model->GetMaterialTexture(packet.range.material);
+		packet.firstInstance = 0;
+		packet.instanceCount = 0;
+		m_RenderQueue->Add(packet);
+	}
+
+	// And one for every run of visible batches of the static props. Their vertices are in world space already.
+	if (m_StaticBatch)
+	{
+		m_StaticBatch->Cull(viewMatrix, projectionMatrix);
+		for (i = 0; i < m_StaticBatch->GetVisibleRangeCount(); i++)
+		{
+			packet.range = m_StaticBatch->GetVisibleRange(i);
+			packet.key = RenderQueueClass::MakeKey(RENDER_PASS_OPAQUE, RENDER_SHADER_TEXTURE, packet.range.material,
+				m_StaticBatch->GetVisibleRangeDepth(i));
+			packet.geometry = RENDER_OBJECT_STATIC_PROPS;
+			packet.object = RENDER_OBJECT_STATIC_PROPS;
+			packet.texture = m_Model->GetMaterialTexture(packet.range.material);
+			packet.firstInstance = 0;
+			packet.instanceCount = 0;
+			m_RenderQueue->Add(packet);
+		}
+	}
+
+	// And one instanced draw for every range of the instances' level of detail, if any of them is visible. Their world matrices are
+	// in the instance stream, so they need no object constants.
+	if (m_InstanceBatch)
+	{
+		result = m_InstanceBatch->Cull(m_Device, viewMatrix, projectionMatrix);
+		if (!result)
+		{
+			return false;
+		}
+
+		if (m_InstanceBatch->GetVisibleCount() > 0)
+		{
+			lod = MODEL_INSTANCE_LOD < m_Model->GetLodCount() ? MODEL_INSTANCE_LOD : m_Model->GetLodCount() - 1;
+			for (i = 0; i < m_Model->GetLodRangeCount(lod); i++)
+			{
+				packet.range = m_Model->GetLodRange(lod, i);
+				packet.key = RenderQueueClass::MakeKey(RENDER_PASS_OPAQUE, RENDER_SHADER_TEXTURE_INSTANCED, packet.range.material,
+					m_InstanceBatch->GetVisibleDepth());
+				packet.geometry = RENDER_OBJECT_INSTANCES;
+				packet.object = RENDER_OBJECT_INSTANCES;
+				packet.texture = m_Model->GetMaterialTexture(packet.range.material);
+				packet.firstInstance = 0;
+				packet.instanceCount = m_InstanceBatch->GetVisibleCount();
+				m_RenderQueue->Add(packet);
+			}
+		}
+	}
 
 	// Render the model using the color shader.
-	/*result = m_ColorShader->Render(m_D3D->GetDeviceContext(), m_Model->GetIndexCount(), worldMatrix, viewMatrix, projectionMatrix);
+	/*result = m_ColorShader->Render(m_Device, m_Model->GetIndexCount(), worldMatrix, viewMatrix, projectionMatrix);
 	if (!result)
 	{
 		return false;
 	}*/
-	// Render the model using the texture shader.
-	result = m_TextureShader->Render(m_D3D->GetDeviceContext(), m_Model->GetIndexCount(), worldMatrix, viewMatrix, projectionMatrix,
-		m_Model->GetTexture());
+	// Draw the packets in key order with the texture shader, straight on the device or recorded on as many threads as there are
+	// enough packets for.
+	m_RenderQueue->Sort();
+	threadCount = m_options.recordMinPackets > 0 ? m_RenderQueue->GetPacketCount() / m_options.recordMinPackets : 0;
+	if (threadCount > m_commandListCount)
+	{
+		threadCount = m_commandListCount;
+	}
+
+	if (threadCount > 1)
+	{
+		result = RecordPackets(objectConstants, threadCount);
+	}
+	else
+	{
+		result = SubmitPackets(m_Device, 0, m_RenderQueue->GetPacketCount(), objectConstants, 0);
+	}
 	if (!result)
 	{
 		return false;
 	}
+
+	// The GPU is done with this frame's constants once it gets past here.
+	if (m_ConstantRing)
+	{
+		m_ConstantRing->EndFrame();
+	}
+
 	// Present the rendered scene to the screen.
-	m_D3D->EndScene();
+	m_Device->EndScene();
+	return true;
+}
+
+
+// SubmitPackets draws the packets from firstPacket up to endPacket on device, which may be a command list. The vertex and index buffers
+// are only put on the pipeline when the packet needs another object's, and the instances are drawn from the model's buffers with the
+// instance stream next to them. Without object slices every draw writes its object constants, with them it binds the object's slice.
+bool GraphicsClass::SubmitPackets(RenderDeviceClass* device, int firstPacket, int endPacket,
+	const TransformBatchClass::ObjectConstantsType* objectConstants, const ConstantSliceType* objectSlices)
+{
+	unsigned int geometry;
+	bool result;
+	int i;
+
+
+	geometry = RENDER_OBJECT_COUNT;
+	for (i = firstPacket; i < endPacket; i++)
+	{
+		const RenderQueueClass::PacketType& queued = m_RenderQueue->GetPacket(i);
+
+		if (queued.geometry != geometry)
+		{
+			geometry = queued.geometry;
+			if (geometry == RENDER_OBJECT_MODEL)
+			{
+				m_Model->Render(device);
+			}
+			else if (geometry == RENDER_OBJECT_STATIC_PROPS)
+			{
+				m_StaticBatch->Render(device);
+			}
+			else
+			{
+				m_Model->Render(device);
+				m_InstanceBatch->Render(device);
+			}
+		}
+
+		if (queued.instanceCount > 0)
+		{
+			m_TextureShader->RenderInstanced(device, queued.range.indexCount, queued.instanceCount, queued.range.startIndex,
+				queued.range.baseVertex, queued.firstInstance, queued.texture);
+			continue;
+		}
+
+		if (objectSlices)
+		{
+			m_TextureShader->Render(device, queued.range.indexCount, queued.range.startIndex, queued.range.baseVertex,
+				objectSlices[queued.object].firstConstant, objectSlices[queued.object].constantCount, queued.texture);
+			continue;
+		}
+
+		result = m_TextureShader->Render(device, queued.range.indexCount, queued.range.startIndex, queued.range.baseVertex,
+			objectConstants[queued.object], queued.texture);
+		if (!result)
+		{
+			return false;
+		}
+	}
+
 	return true;
 }
 
+// RecordPackets splits the sorted packets into threadCount runs that follow each other and records each run into a command list, the
+// first on this thread and the others on the threads of the record pool. The lists are executed in the order of the runs, so the
+// device draws the packets in the order SubmitPackets would. Everything the draws read is written before the threads start, the object
+// constants into one slice of the ring, so the threads only bind and draw.
+bool GraphicsClass::RecordPackets(const TransformBatchClass::ObjectConstantsType* objectConstants, unsigned int threadCount)
+{
+	ConstantSliceType objectSlices[RENDER_OBJECT_COUNT];
+	bool results[RECORD_THREAD_COUNT];
+	unsigned int firstConstant, constantStride, i;
+	int packetCount;
+	bool result;
+
+
+	packetCount = m_RenderQueue->GetPacketCount();
+
+	// The object constants go into one slice together, a ring that filled up between them would discard the ones written before. When
+	// the ring can not take them the frame is drawn without the threads, which writes them per draw.
+	result = m_TextureShader->WriteObjectParameters(objectConstants, RENDER_OBJECT_COUNT, firstConstant, constantStride);
+	if (!result)
+	{
+		return SubmitPackets(m_Device, 0, packetCount, objectConstants, 0);
+	}
+
+	for (i = 0; i < RENDER_OBJECT_COUNT; i++)
+	{
+		objectSlices[i].firstConstant = firstConstant + i * constantStride;
+		objectSlices[i].constantCount = constantStride;
+	}
+
+	std::chrono::steady_clock::time_point recordStart = std::chrono::steady_clock::now();
+
+	auto record = [&](unsigned int thread)
+	{
+		RenderDeviceClass* recorder;
+
+
+		results[thread] = m_Device->BeginCommandList(m_commandLists[thread], recorder);
+		if (!results[thread])
+		{
+			return;
+		}
+
+		m_TextureShader->BindFrameParameters(recorder);
+		results[thread] = SubmitPackets(recorder, (int)((long long)packetCount * thread / threadCount),
+			(int)((long long)packetCount * (thread + 1) / threadCount), objectConstants, objectSlices);
+		m_Device->EndCommandList(m_commandLists[thread]);
+	};
+
+	m_RecordPool->Run(threadCount, record);
+
+	std::chrono::steady_clock::time_point executeStart = std::chrono::steady_clock::now();
+
+	for (i = 0; i < threadCount; i++)
+	{
+		if (!results[i])
+		{
+			return false;
+		}
+	}
+
+	for (i = 0; i < threadCount; i++)
+	{
+		m_Device->ExecuteCommandList(m_commandLists[i]);
+	}
+
+	m_frameStats.recordSeconds += std::chrono::duration<double>(executeStart - recordStart).count();
+	m_frameStats.executeSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - executeStart).count();
+	m_frameStats.recordThreads = threadCount;
+	m_frameStats.recordedFrameCount++;
+
+	return true;
+}
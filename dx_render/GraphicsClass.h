@@ -7,11 +7,24 @@
 ///////////////////////
 // MY CLASS INCLUDES //
 ///////////////////////
+#ifdef _WIN32
 #include "d3dclass.h"
+#include "d3drenderdeviceclass.h"
+#endif
+#include "renderdeviceclass.h"
+#include "statefilterrenderdeviceclass.h"
 #include "cameraclass.h"
+#include "transformbatchclass.h"
+#include "geometrypoolclass.h"
 #include "modelclass.h"
+#include "meshcacheclass.h"
+#include "staticbatchclass.h"
+#include "instancebatchclass.h"
 #include "colorshaderclass.h"
 #include "textureshaderclass.h"
+#include "constantringclass.h"
+#include "renderqueueclass.h"
+#include "workerpoolclass.h"
 
 //////////////
 // INCLUDES //
@@ -26,31 +39,159 @@ const bool FULL_SCREEN = false;
 const bool VSYNC_ENABLED = true;
 const float SCREEN_DEPTH = 1000.0f;
 const float SCREEN_NEAR = 0.1f;
+// The vertex format the model is uploaded with, and whether a mesh too big for 16 bit indices is split into ranges that fit.
+const VertexFormatType MODEL_VERTEX_FORMAT = VERTEX_FORMAT_COMPACT_OCTAHEDRAL;
+const bool MODEL_SPLIT_LARGE_MESHES = true;
+// Whether the model's positions go into a vertex buffer of their own, so passes that only need depth fetch nothing else.
+const bool MODEL_SPLIT_VERTEX_STREAMS = false;
+// The size of the clusters the model is culled in, zero turns cluster culling off.
+const unsigned int MODEL_MESHLET_MAX_VERTICES = 64;
+const unsigned int MODEL_MESHLET_MAX_TRIANGLES = 124;
+// How many pixels the simplification error of the drawn level of detail may cover, and the band around that a switch needs.
+const float MODEL_LOD_PIXEL_ERROR = 1.0f;
+const float MODEL_LOD_HYSTERESIS = 0.25f;
+// Whether an OBJ model streams in from a coarse base, and how many bytes of its stream every frame may read to refine it. A streamed
+// model has no clusters or levels of detail and is not uploaded into the geometry pool, so it is left for a tool to turn on.
+const bool MODEL_PROGRESSIVE = false;
+const unsigned int MODEL_REFINE_BYTES_PER_FRAME = 1024 * 1024;
+// The vertices and indices the shared geometry pool starts out with room for, it grows when a model does not fit.
+const unsigned int GEOMETRY_POOL_VERTICES = 1024 * 1024;
+const unsigned int GEOMETRY_POOL_INDICES = 4 * 1024 * 1024;
+// How many copies of the model are scattered around it as static props and merged into batches, zero leaves them out. They are
+// spread over a square of STATIC_PROP_SPREAD units and batched by cells of STATIC_BATCH_CELL_SIZE units.
+const unsigned int STATIC_PROP_COUNT = 0;
+const float STATIC_PROP_SPREAD = 200.0f;
+const float STATIC_BATCH_CELL_SIZE = 50.0f;
+// How many copies of the model are scattered around it as instances, each with a world matrix of its own, zero leaves them out. They
+// are spread over a square of MODEL_INSTANCE_SPREAD units and drawn at level of detail MODEL_INSTANCE_LOD, or the coarsest one there is.
+const unsigned int MODEL_INSTANCE_COUNT = 0;
+const float MODEL_INSTANCE_SPREAD = 200.0f;
+const int MODEL_INSTANCE_LOD = 0;
+// The size of the ring the constants of every draw of a frame are written to, zero gives every shader a buffer of its own instead.
+const unsigned int CONSTANT_RING_SIZE = 4 * 1024 * 1024;
+// Whether binds that would change nothing are dropped before they reach the device.
+const bool FILTER_REDUNDANT_STATE = true;
+// How many draws the render queue has room for before it grows. A draw of the model is packet geometry and object 0, a draw of the
+// static props 1 and a draw of the instances 2. The texture shader is shader 0 in the sort keys and its instanced variant shader 1.
+const unsigned int RENDER_QUEUE_CAPACITY = 4096;
+const unsigned int RENDER_OBJECT_MODEL = 0;
+const unsigned int RENDER_OBJECT_STATIC_PROPS = 1;
+const unsigned int RENDER_OBJECT_INSTANCES = 2;
+const unsigned int RENDER_OBJECT_COUNT = 3;
+const unsigned int RENDER_SHADER_TEXTURE = 0;
+const unsigned int RENDER_SHADER_TEXTURE_INSTANCED = 1;
+// How many threads may record the sorted draws into command lists at once, and how many draws every one of them has to get, the
+// defaults of the scene options. A frame with fewer draws than that for two threads is drawn straight on the device. Recording needs
+// the constant ring, the object constants are written into it before the threads start.
+const unsigned int RECORD_THREAD_COUNT = 4;
+const unsigned int RECORD_MIN_PACKETS = 256;
 
 ////////////////////////////////////////////////////////////////////////////////
 // Class name: GraphicsClass
 ////////////////////////////////////////////////////////////////////////////////
+// The GraphicsClass draws every frame through a RenderDeviceClass. The window version creates Direct3D and its device itself, the
+// headless version draws through a device the caller made and keeps owning, such as a NullRenderDeviceClass for profiling the frame
+// on a machine without a GPU. Frame is the same for both.
 class GraphicsClass
 {
+private:
+	// Where the constants of an object are in the constant ring this frame.
+	struct ConstantSliceType
+	{
+		unsigned int firstConstant, constantCount;
+	};
+
+public:
+	// What the frames drawn since the last ResetFrameStats did, for a benchmark or a tool to read. The culling of the last frame
+	// and the level of detail it drew are as they were then, the rest adds up over the frames.
+	struct FrameStatsType
+	{
+		unsigned int frameCount;
+		double cullSeconds;
+		unsigned long long trianglesDrawn, trianglesCulled;
+		MeshletClass::CullStatsType lastCull;
+		int lod, lodCount;
+		RingAllocatorClass::StatsType constantRing;
+		InstanceBatchClass::StatsType instances;
+		StaticBatchClass::BuildStatsType staticProps;
+		double staticPropSeconds;
+		unsigned int recordedFrameCount, recordThreads;
+		double recordSeconds, executeSeconds;
+	};
+
+	// The parts of the scene a tool or a test may change before Initialize. They start out as the globals above and the model the
+	// window version loads. At most RECORD_THREAD_COUNT threads record, one or none draws every frame straight on the device.
+	struct SceneOptionsType
+	{
+		const char* modelFileName;
+		bool progressive;
+		unsigned int staticPropCount;
+		unsigned int instanceCount;
+		unsigned int recordThreadCount, recordMinPackets;
+	};
+
 public:
 	GraphicsClass();
 	GraphicsClass(const GraphicsClass&);
 	~GraphicsClass();
 
+	void SetSceneOptions(const SceneOptionsType&);
+	SceneOptionsType GetSceneOptions();
+
+#ifdef _WIN32
 	bool Initialize(int, int, HWND);
+#endif
+	bool Initialize(RenderDeviceClass*, int screenWidth, int screenHeight);
 	void Shutdown();
 	bool Frame();
 
+	FrameStatsType GetFrameStats();
+	void ResetFrameStats();
+
 private:
+	bool InitializeScene(int screenWidth, int screenHeight);
+	bool InitializeStaticProps(const char* modelFileName);
+	bool InitializeInstances();
+	void ShowError(const wchar_t* message);
 	bool Render();
+	bool SubmitPackets(RenderDeviceClass*, int firstPacket, int endPacket, const TransformBatchClass::ObjectConstantsType* objectConstants,
+		const ConstantSliceType* objectSlices);
+	bool RecordPackets(const TransformBatchClass::ObjectConstantsType* objectConstants, unsigned int threadCount);
 
 private:
 
+#ifdef _WIN32
 	D3DClass* m_D3D;
+	D3DRenderDeviceClass* m_D3DDevice;
+	HWND m_hwnd;
+#endif
+	RenderDeviceClass* m_Device;
+	StateFilterRenderDeviceClass* m_StateFilter;
 	CameraClass* m_Camera;
+	TransformBatchClass* m_TransformBatch;
+	GeometryPoolClass* m_GeometryPool;
 	ModelClass* m_Model;
+	StaticBatchClass* m_StaticBatch;
+	InstanceBatchClass* m_InstanceBatch;
 	// ColorShaderClass* m_ColorShader;
 	TextureShaderClass* m_TextureShader;
+	ConstantRingClass* m_ConstantRing;
+	RenderQueueClass* m_RenderQueue;
+
+	// The command list of every recording thread, there are fewer when the device could not make them all. The threads wait in the
+	// pool between frames, the first list is recorded on the thread that draws the frame.
+	unsigned int m_commandLists[RECORD_THREAD_COUNT];
+	unsigned int m_commandListCount;
+	WorkerPoolClass* m_RecordPool;
+
+	// The projection of the screen and where the model is placed in the world.
+	XMFLOAT4X4 m_projectionMatrix, m_worldMatrix;
+
+	SceneOptionsType m_options;
+	double m_staticPropSeconds;
+	int m_screenHeight;
+	FrameStatsType m_frameStats;
+	unsigned long long m_instanceUploadStart;
 };
 
 #endif
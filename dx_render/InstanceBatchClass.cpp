@@ -0,0 +1,298 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: instancebatchclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "instancebatchclass.h"
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+
+InstanceBatchClass::InstanceBatchClass()
+{
+	m_device = 0;
+	m_instanceBuffer = RENDER_HANDLE_NONE;
+	m_capacity = 0;
+	XMStoreFloat4x4(&m_positionDecode, XMMatrixIdentity());
+	m_boundsCenter = XMFLOAT3(0.0f, 0.0f, 0.0f);
+	m_boundsRadius = 0.0f;
+	m_visibleCount = 0;
+	m_visibleDepth = 0.0f;
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+
+
+InstanceBatchClass::InstanceBatchClass(const InstanceBatchClass& other)
+{
+}
+
+
+InstanceBatchClass::~InstanceBatchClass()
+{
+}
+
+// Initialize makes the instance stream with room for capacity instances, it grows past that on its own.
+bool InstanceBatchClass::Initialize(RenderDeviceClass* device, unsigned int capacity)
+{
+	bool result;
+
+
+	m_device = device;
+	memset(&m_stats, 0, sizeof(m_stats));
+
+	if (capacity > 0)
+	{
+		result = Reserve(device, capacity);
+		if (!result)
+		{
+			return false;
+		}
+	}
+	m_stats.growCount = 0;
+
+	return true;
+}
+
+
+void InstanceBatchClass::Shutdown()
+{
+	if (m_instanceBuffer)
+	{
+		m_device->ReleaseBuffer(m_instanceBuffer);
+		m_instanceBuffer = RENDER_HANDLE_NONE;
+	}
+	m_capacity = 0;
+	m_stats.capacity = 0;
+
+	m_instances.clear();
+	m_instances.shrink_to_fit();
+	m_spheres.clear();
+	m_spheres.shrink_to_fit();
+	m_visibleCount = 0;
+	m_device = 0;
+
+	return;
+}
+
+// SetMesh sets the mesh the instances are copies of: the position decode matrix of its vertex format and its bounds in model space,
+// without the decode. The instances so far were packed for the mesh before, so they are removed.
+void InstanceBatchClass::SetMesh(XMMATRIX decodeMatrix, XMFLOAT3 boundsCenter, float boundsRadius)
+{
+	XMStoreFloat4x4(&m_positionDecode, decodeMatrix);
+	m_boundsCenter = boundsCenter;
+	m_boundsRadius = boundsRadius;
+	ClearInstances();
+
+	return;
+}
+
+// AddInstance adds a copy of the mesh placed with worldMatrix and returns its index, which SetInstance moves it with.
+unsigned int InstanceBatchClass::AddInstance(XMMATRIX worldMatrix)
+{
+	m_instances.emplace_back();
+	m_spheres.emplace_back();
+	SetInstance((unsigned int)m_instances.size() - 1, worldMatrix);
+
+	return (unsigned int)m_instances.size() - 1;
+}
+
+// SetInstance packs the world matrix for the shader and works out the sphere around the instance. A scaled instance gets the bounds
+// radius times its largest scale.
+void InstanceBatchClass::SetInstance(unsigned int instance, XMMATRIX worldMatrix)
+{
+	XMFLOAT4X4 packed;
+	XMFLOAT3 center;
+	float scale;
+
+
+	// The transpose of the decode and world matrices together, the shader dots its first three rows with the stored position.
+	XMStoreFloat4x4(&packed, XMMatrixTranspose(XMMatrixMultiply(XMLoadFloat4x4(&m_positionDecode), worldMatrix)));
+	memcpy(m_instances[instance].rows, packed.m, sizeof(m_instances[instance].rows));
+
+	XMStoreFloat3(&center, XMVector3Transform(XMLoadFloat3(&m_boundsCenter), worldMatrix));
+	scale = XMVectorGetX(XMVectorMax(XMVectorMax(XMVector3Length(worldMatrix.r[0]), XMVector3Length(worldMatrix.r[1])),
+		XMVector3Length(worldMatrix.r[2])));
+	m_spheres[instance] = XMFLOAT4(center.x, center.y, center.z, m_boundsRadius * scale);
+
+	return;
+}
+
+
+void InstanceBatchClass::ClearInstances()
+{
+	m_instances.clear();
+	m_spheres.clear();
+	m_visibleCount = 0;
+	m_visibleDepth = 0.0f;
+
+	return;
+}
+
+// Cull tests the sphere of every instance against the view frustum and writes the rows of the ones that are inside straight into the
+// instance stream, in the order they were added. It also finds how far in front of the camera the nearest visible instance may be.
+bool InstanceBatchClass::Cull(RenderDeviceClass* device, XMMATRIX viewMatrix, XMMATRIX projectionMatrix)
+{
+	XMFLOAT4X4 m, view;
+	XMFLOAT4 planes[6];
+	InstanceType* rows;
+	void* mappedData;
+	float length, distance, nearest, depth;
+	unsigned int count, i;
+	int p;
+	bool result;
+
+
+	count = (unsigned int)m_instances.size();
+	m_visibleCount = 0;
+	m_visibleDepth = 0.0f;
+	m_stats.instanceCount = count;
+	m_stats.visibleCount = 0;
+	if (count == 0)
+	{
+		return true;
+	}
+
+	if (count > m_capacity)
+	{
+		result = Reserve(device, count);
+		if (!result)
+		{
+			return false;
+		}
+	}
+
+	XMStoreFloat4x4(&view, viewMatrix);
+	XMStoreFloat4x4(&m, XMMatrixMultiply(viewMatrix, projectionMatrix));
+
+	// Left, right, bottom, top, near and far, with the Direct3D clip space depth of 0 to 1, the same as MeshletClass::Cull.
+	planes[0] = XMFLOAT4(m.m[0][3] + m.m[0][0], m.m[1][3] + m.m[1][0], m.m[2][3] + m.m[2][0], m.m[3][3] + m.m[3][0]);
+	planes[1] = XMFLOAT4(m.m[0][3] - m.m[0][0], m.m[1][3] - m.m[1][0], m.m[2][3] - m.m[2][0], m.m[3][3] - m.m[3][0]);
+	planes[2] = XMFLOAT4(m.m[0][3] + m.m[0][1], m.m[1][3] + m.m[1][1], m.m[2][3] + m.m[2][1], m.m[3][3] + m.m[3][1]);
+	planes[3] = XMFLOAT4(m.m[0][3] - m.m[0][1], m.m[1][3] - m.m[1][1], m.m[2][3] - m.m[2][1], m.m[3][3] - m.m[3][1]);
+	planes[4] = XMFLOAT4(m.m[0][2], m.m[1][2], m.m[2][2], m.m[3][2]);
+	planes[5] = XMFLOAT4(m.m[0][3] - m.m[0][2], m.m[1][3] - m.m[1][2], m.m[2][3] - m.m[2][2], m.m[3][3] - m.m[3][2]);
+
+	for (p = 0; p < 6; p++)
+	{
+		length = sqrtf(planes[p].x * planes[p].x + planes[p].y * planes[p].y + planes[p].z * planes[p].z);
+		if (length > 0.0f)
+		{
+			planes[p] = XMFLOAT4(planes[p].x / length, planes[p].y / length, planes[p].z / length, planes[p].w / length);
+		}
+	}
+
+	// The discard hands out fresh memory, so the rows are only ever written, one after the other, and never read back.
+	result = device->MapBuffer(m_instanceBuffer, RENDER_MAP_DISCARD, 0, count * sizeof(InstanceType), mappedData);
+	if (!result)
+	{
+		return false;
+	}
+	rows = (InstanceType*)mappedData;
+
+	for (i = 0; i < count; i++)
+	{
+		const XMFLOAT4& sphere = m_spheres[i];
+
+		// All six planes are tested and only the nearest one is compared, an early out per plane would be mispredicted whenever
+		// instances inside and outside the view are mixed.
+		nearest = FLT_MAX;
+		for (p = 0; p < 6; p++)
+		{
+			distance = planes[p].x * sphere.x + planes[p].y * sphere.y + planes[p].z * sphere.z + planes[p].w;
+			nearest = distance < nearest ? distance : nearest;
+		}
+
+		if (nearest < -sphere.w)
+		{
+			continue;
+		}
+
+		depth = sphere.x * view.m[0][2] + sphere.y * view.m[1][2] + sphere.z * view.m[2][2] + view.m[3][2] - sphere.w;
+		if (m_visibleCount == 0 || depth < m_visibleDepth)
+		{
+			m_visibleDepth = depth;
+		}
+
+		rows[m_visibleCount] = m_instances[i];
+		m_visibleCount++;
+	}
+
+	device->UnmapBuffer(m_instanceBuffer);
+
+	m_stats.visibleCount = m_visibleCount;
+	m_stats.uploadBytes += (unsigned long long)m_visibleCount * sizeof(InstanceType);
+
+	return true;
+}
+
+// Render puts the instance stream on the pipeline next to the mesh's own vertex buffers, which the caller binds.
+void InstanceBatchClass::Render(RenderDeviceClass* device)
+{
+	unsigned int stride, offset;
+
+
+	stride = sizeof(InstanceType);
+	offset = 0;
+	device->SetVertexBuffers(INSTANCE_VERTEX_SLOT, 1, &m_instanceBuffer, &stride, &offset);
+
+	return;
+}
+
+
+unsigned int InstanceBatchClass::GetInstanceCount()
+{
+	return (unsigned int)m_instances.size();
+}
+
+// GetVisibleCount returns how many instances the last Cull left in the stream, they are drawn as instances 0 up to that.
+unsigned int InstanceBatchClass::GetVisibleCount()
+{
+	return m_visibleCount;
+}
+
+// GetVisibleDepth returns how far in front of the camera the nearest visible instance may be, zero when none is visible.
+float InstanceBatchClass::GetVisibleDepth()
+{
+	return m_visibleDepth;
+}
+
+
+InstanceBatchClass::StatsType InstanceBatchClass::GetStats()
+{
+	return m_stats;
+}
+
+// Reserve replaces the instance stream with one that has room for at least capacity instances, rounded up to a power of two so
+// instances added a few at a time only make it grow a few times.
+bool InstanceBatchClass::Reserve(RenderDeviceClass* device, unsigned int capacity)
+{
+	RenderDeviceClass::BufferDescType bufferDesc;
+	unsigned int newCapacity, newBuffer;
+	bool result;
+
+
+	newCapacity = 1;
+	while (newCapacity < capacity)
+	{
+		newCapacity *= 2;
+	}
+
+	bufferDesc.bind = RENDER_BIND_VERTEX_BUFFER;
+	bufferDesc.usage = RENDER_USAGE_DYNAMIC;
+	bufferDesc.byteWidth = newCapacity * sizeof(InstanceType);
+	result = device->CreateBuffer(bufferDesc, 0, newBuffer);
+	if (!result)
+	{
+		return false;
+	}
+
+	if (m_instanceBuffer)
+	{
+		device->ReleaseBuffer(m_instanceBuffer);
+		m_stats.growCount++;
+	}
+	m_instanceBuffer = newBuffer;
+	m_capacity = newCapacity;
+	m_stats.capacity = newCapacity;
+
+	return true;
+}
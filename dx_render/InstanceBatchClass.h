@@ -0,0 +1,83 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: instancebatchclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _INSTANCEBATCHCLASS_H_
+#define _INSTANCEBATCHCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <DirectXMath.h>
+#include <vector>
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "renderdeviceclass.h"
+
+using namespace DirectX;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: InstanceBatchClass
+////////////////////////////////////////////////////////////////////////////////
+// The InstanceBatchClass draws many copies of one mesh that each have their own world matrix with a single instanced draw per range
+// of the mesh. Every instance keeps its matrix already multiplied by the mesh's position decode matrix and packed as the rows the
+// instanced shader reads, next to its bounding sphere in world space, so a frame only tests the spheres against the view frustum and
+// copies the rows of the visible instances into the instance stream, which Render binds to INSTANCE_VERTEX_SLOT.
+// The stream is one dynamic vertex buffer with room for every instance, it is mapped with a discard once per Cull and grows to the
+// next power of two when instances are added past it.
+class InstanceBatchClass
+{
+public:
+	struct StatsType
+	{
+		unsigned int instanceCount, visibleCount;
+		unsigned int capacity, growCount;
+		unsigned long long uploadBytes;
+	};
+
+public:
+	InstanceBatchClass();
+	InstanceBatchClass(const InstanceBatchClass&);
+	~InstanceBatchClass();
+
+	bool Initialize(RenderDeviceClass*, unsigned int capacity);
+	void Shutdown();
+
+	void SetMesh(XMMATRIX decodeMatrix, XMFLOAT3 boundsCenter, float boundsRadius);
+	unsigned int AddInstance(XMMATRIX worldMatrix);
+	void SetInstance(unsigned int instance, XMMATRIX worldMatrix);
+	void ClearInstances();
+
+	bool Cull(RenderDeviceClass*, XMMATRIX viewMatrix, XMMATRIX projectionMatrix);
+	void Render(RenderDeviceClass*);
+
+	unsigned int GetInstanceCount();
+	unsigned int GetVisibleCount();
+	float GetVisibleDepth();
+	StatsType GetStats();
+
+private:
+	bool Reserve(RenderDeviceClass*, unsigned int capacity);
+
+private:
+	RenderDeviceClass* m_device;
+	unsigned int m_instanceBuffer, m_capacity;
+
+	// The mesh every instance is a copy of: the matrix that decodes its positions and its bounds in model space.
+	XMFLOAT4X4 m_positionDecode;
+	XMFLOAT3 m_boundsCenter;
+	float m_boundsRadius;
+
+	// The packed rows and the world space sphere of every instance, and how many of them and how near the nearest one were visible
+	// at the last Cull.
+	std::vector<InstanceType> m_instances;
+	std::vector<XMFLOAT4> m_spheres;
+	unsigned int m_visibleCount;
+	float m_visibleDepth;
+	StatsType m_stats;
+};
+
+#endif
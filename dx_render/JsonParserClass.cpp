@@ -0,0 +1,351 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: jsonparserclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "jsonparserclass.h"
+#include <charconv>
+#include <cstring>
+
+
+/////////////
+// GLOBALS //
+/////////////
+// Nesting deeper than this is refused rather than risking the stack on a hostile file.
+static const int JSON_MAX_DEPTH = 128;
+
+
+// AppendUtf8 encodes a code point from a \u escape.
+static void AppendUtf8(std::string& text, unsigned int codePoint)
+{
+	if (codePoint < 0x80)
+	{
+		text += (char)codePoint;
+	}
+	else if (codePoint < 0x800)
+	{
+		text += (char)(0xc0 | (codePoint >> 6));
+		text += (char)(0x80 | (codePoint & 0x3f));
+	}
+	else if (codePoint < 0x10000)
+	{
+		text += (char)(0xe0 | (codePoint >> 12));
+		text += (char)(0x80 | ((codePoint >> 6) & 0x3f));
+		text += (char)(0x80 | (codePoint & 0x3f));
+	}
+	else
+	{
+		text += (char)(0xf0 | (codePoint >> 18));
+		text += (char)(0x80 | ((codePoint >> 12) & 0x3f));
+		text += (char)(0x80 | ((codePoint >> 6) & 0x3f));
+		text += (char)(0x80 | (codePoint & 0x3f));
+	}
+
+	return;
+}
+
+
+static bool ParseHex4(const char* p, const char* end, unsigned int& value)
+{
+	int i;
+
+
+	if (end - p < 4)
+	{
+		return false;
+	}
+
+	value = 0;
+	for (i = 0; i < 4; i++)
+	{
+		char c = p[i];
+		value <<= 4;
+		if (c >= '0' && c <= '9') value |= (unsigned int)(c - '0');
+		else if (c >= 'a' && c <= 'f') value |= (unsigned int)(c - 'a' + 10);
+		else if (c >= 'A' && c <= 'F') value |= (unsigned int)(c - 'A' + 10);
+		else return false;
+	}
+
+	return true;
+}
+
+
+JsonParserClass::JsonParserClass()
+{
+	m_end = 0;
+}
+
+
+JsonParserClass::JsonParserClass(const JsonParserClass& other)
+{
+}
+
+
+JsonParserClass::~JsonParserClass()
+{
+}
+
+// Parse reads one value from [begin, end), nothing but white space may follow it.
+bool JsonParserClass::Parse(const char* begin, const char* end, OUT ValueType& root)
+{
+	const char* p;
+
+
+	m_end = end;
+	p = ParseValue(SkipSpace(begin), root, 0);
+	if (!p)
+	{
+		return false;
+	}
+
+	return SkipSpace(p) == end;
+}
+
+
+const JsonParserClass::ValueType* JsonParserClass::Find(const ValueType& object, const char* key)
+{
+	size_t i;
+
+
+	if (object.kind != KIND_OBJECT)
+	{
+		return 0;
+	}
+
+	for (i = 0; i < object.keys.size(); i++)
+	{
+		if (object.keys[i] == key)
+		{
+			return &object.items[i];
+		}
+	}
+
+	return 0;
+}
+
+
+const JsonParserClass::ValueType* JsonParserClass::GetArray(const ValueType& object, const char* key)
+{
+	const ValueType* value = Find(object, key);
+
+
+	return value && value->kind == KIND_ARRAY ? value : 0;
+}
+
+
+double JsonParserClass::GetNumber(const ValueType& object, const char* key, double fallback)
+{
+	const ValueType* value = Find(object, key);
+
+
+	return value && value->kind == KIND_NUMBER ? value->number : fallback;
+}
+
+// GetInt also falls back for numbers that are not whole or do not fit an int, which glTF never uses for indices and counts.
+int JsonParserClass::GetInt(const ValueType& object, const char* key, int fallback)
+{
+	const ValueType* value = Find(object, key);
+
+
+	if (!value || value->kind != KIND_NUMBER || value->number != (double)(int)value->number)
+	{
+		return fallback;
+	}
+
+	return (int)value->number;
+}
+
+
+bool JsonParserClass::GetBool(const ValueType& object, const char* key, bool fallback)
+{
+	const ValueType* value = Find(object, key);
+
+
+	return value && value->kind == KIND_BOOL ? value->boolean : fallback;
+}
+
+
+const char* JsonParserClass::GetString(const ValueType& object, const char* key, const char* fallback)
+{
+	const ValueType* value = Find(object, key);
+
+
+	return value && value->kind == KIND_STRING ? value->text.c_str() : fallback;
+}
+
+// ParseValue returns the position just past the value, or null when the text is not valid JSON.
+const char* JsonParserClass::ParseValue(const char* p, ValueType& value, int depth)
+{
+	value.kind = KIND_NULL;
+	value.boolean = false;
+	value.number = 0.0;
+
+	if (p >= m_end || depth > JSON_MAX_DEPTH)
+	{
+		return 0;
+	}
+
+	if (*p == '{')
+	{
+		value.kind = KIND_OBJECT;
+		p = SkipSpace(p + 1);
+		if (p < m_end && *p == '}')
+		{
+			return p + 1;
+		}
+
+		while (p)
+		{
+			value.keys.emplace_back();
+			value.items.emplace_back();
+			p = p < m_end && *p == '"' ? ParseString(p, value.keys.back()) : 0;
+			p = p ? SkipSpace(p) : 0;
+			p = p && p < m_end && *p == ':' ? SkipSpace(p + 1) : 0;
+			p = p ? ParseValue(p, value.items.back(), depth + 1) : 0;
+			p = p ? SkipSpace(p) : 0;
+			if (p && p < m_end && *p == '}')
+			{
+				return p + 1;
+			}
+			p = p && p < m_end && *p == ',' ? SkipSpace(p + 1) : 0;
+		}
+
+		return 0;
+	}
+
+	if (*p == '[')
+	{
+		value.kind = KIND_ARRAY;
+		p = SkipSpace(p + 1);
+		if (p < m_end && *p == ']')
+		{
+			return p + 1;
+		}
+
+		while (p)
+		{
+			value.items.emplace_back();
+			p = ParseValue(p, value.items.back(), depth + 1);
+			p = p ? SkipSpace(p) : 0;
+			if (p && p < m_end && *p == ']')
+			{
+				return p + 1;
+			}
+			p = p && p < m_end && *p == ',' ? SkipSpace(p + 1) : 0;
+		}
+
+		return 0;
+	}
+
+	if (*p == '"')
+	{
+		value.kind = KIND_STRING;
+		return ParseString(p, value.text);
+	}
+
+	if (m_end - p >= 4 && memcmp(p, "true", 4) == 0)
+	{
+		value.kind = KIND_BOOL;
+		value.boolean = true;
+		return p + 4;
+	}
+
+	if (m_end - p >= 5 && memcmp(p, "false", 5) == 0)
+	{
+		value.kind = KIND_BOOL;
+		return p + 5;
+	}
+
+	if (m_end - p >= 4 && memcmp(p, "null", 4) == 0)
+	{
+		return p + 4;
+	}
+
+	value.kind = KIND_NUMBER;
+	return ParseNumber(p, value.number);
+}
+
+// ParseString reads a quoted string starting at p and resolves its escapes, surrogate pairs included.
+const char* JsonParserClass::ParseString(const char* p, std::string& text)
+{
+	unsigned int codePoint, low;
+
+
+	text.clear();
+	for (p++; p < m_end; p++)
+	{
+		if (*p == '"')
+		{
+			return p + 1;
+		}
+
+		if (*p != '\\')
+		{
+			text += *p;
+			continue;
+		}
+
+		if (++p >= m_end)
+		{
+			return 0;
+		}
+
+		switch (*p)
+		{
+		case '"': text += '"'; break;
+		case '\\': text += '\\'; break;
+		case '/': text += '/'; break;
+		case 'b': text += '\b'; break;
+		case 'f': text += '\f'; break;
+		case 'n': text += '\n'; break;
+		case 'r': text += '\r'; break;
+		case 't': text += '\t'; break;
+		case 'u':
+			if (!ParseHex4(p + 1, m_end, codePoint))
+			{
+				return 0;
+			}
+			p += 4;
+
+			if (codePoint >= 0xd800 && codePoint < 0xdc00)
+			{
+				if (m_end - p < 7 || p[1] != '\\' || p[2] != 'u' || !ParseHex4(p + 3, m_end, low) || low < 0xdc00 || low >= 0xe000)
+				{
+					return 0;
+				}
+				codePoint = 0x10000 + ((codePoint - 0xd800) << 10) + (low - 0xdc00);
+				p += 6;
+			}
+
+			AppendUtf8(text, codePoint);
+			break;
+		default:
+			return 0;
+		}
+	}
+
+	return 0;
+}
+
+// ParseNumber uses from_chars like the OBJ parser, which is exact and does not depend on the locale.
+const char* JsonParserClass::ParseNumber(const char* p, double& number)
+{
+	std::from_chars_result result = std::from_chars(p, m_end, number);
+
+
+	if (result.ec != std::errc() || result.ptr == p)
+	{
+		return 0;
+	}
+
+	return result.ptr;
+}
+
+
+const char* JsonParserClass::SkipSpace(const char* p)
+{
+	while (p < m_end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+	{
+		p++;
+	}
+
+	return p;
+}
@@ -0,0 +1,73 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: jsonparserclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _JSONPARSERCLASS_H_
+#define _JSONPARSERCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <string>
+#include <vector>
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "meshtypes.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: JsonParserClass
+////////////////////////////////////////////////////////////////////////////////
+// The JsonParserClass reads a JSON document into a tree of values, which is all the glTF loader needs from it.
+// Objects keep their members in file order with the keys in a parallel array, lookups are linear since glTF objects are small.
+// The static getters return the fallback for missing members and members of the wrong kind, so optional glTF properties read in one line.
+class JsonParserClass
+{
+public:
+	enum KindType
+	{
+		KIND_NULL,
+		KIND_BOOL,
+		KIND_NUMBER,
+		KIND_STRING,
+		KIND_ARRAY,
+		KIND_OBJECT
+	};
+
+	struct ValueType
+	{
+		KindType kind;
+		bool boolean;
+		double number;
+		std::string text;
+		std::vector<std::string> keys;
+		std::vector<ValueType> items;
+	};
+
+public:
+	JsonParserClass();
+	JsonParserClass(const JsonParserClass&);
+	~JsonParserClass();
+
+	bool Parse(const char* begin, const char* end, OUT ValueType& root);
+
+	static const ValueType* Find(const ValueType& object, const char* key);
+	static const ValueType* GetArray(const ValueType& object, const char* key);
+	static double GetNumber(const ValueType& object, const char* key, double fallback);
+	static int GetInt(const ValueType& object, const char* key, int fallback);
+	static bool GetBool(const ValueType& object, const char* key, bool fallback);
+	static const char* GetString(const ValueType& object, const char* key, const char* fallback);
+
+private:
+	const char* ParseValue(const char* p, ValueType& value, int depth);
+	const char* ParseString(const char* p, std::string& text);
+	const char* ParseNumber(const char* p, double& number);
+	const char* SkipSpace(const char* p);
+
+private:
+	const char* m_end;
+};
+
+#endif
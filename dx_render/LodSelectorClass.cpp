@@ -0,0 +1,115 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: lodselectorclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "lodselectorclass.h"
+#include <algorithm>
+
+
+/////////////
+// GLOBALS //
+/////////////
+// Bounds closer than this to the camera are treated as this close, which keeps the finest level selected inside them.
+static const float LOD_MIN_DISTANCE = 1.0e-4f;
+
+
+LodSelectorClass::LodSelectorClass()
+{
+	m_pixelThreshold = 1.0f;
+	m_hysteresis = 0.25f;
+	m_lod = 0;
+	m_pixelError = 0.0f;
+}
+
+
+LodSelectorClass::LodSelectorClass(const LodSelectorClass& other)
+{
+}
+
+
+LodSelectorClass::~LodSelectorClass()
+{
+}
+
+// SetThreshold sets the largest error in pixels a level may have on screen and the hysteresis as a fraction of it.
+// A level is only given up when its error passes pixelError * (1 + hysteresis) and a coarser one is only taken when its error
+// is below pixelError * (1 - hysteresis).
+void LodSelectorClass::SetThreshold(float pixelError, float hysteresis)
+{
+	m_pixelThreshold = pixelError;
+	m_hysteresis = std::max(0.0f, std::min(hysteresis, 0.99f));
+
+	return;
+}
+
+// Select returns the level to draw. lodErrors holds the model space error of every level, finest first, and the bounds are in model space.
+int LodSelectorClass::Select(const float* lodErrors, int lodCount, const XMFLOAT3& center, float radius, XMMATRIX worldMatrix, XMMATRIX viewMatrix,
+	XMMATRIX projectionMatrix, int screenHeight)
+{
+	float pixelsPerUnit;
+
+
+	if (lodCount <= 1)
+	{
+		m_lod = 0;
+		m_pixelError = 0.0f;
+		return m_lod;
+	}
+
+	pixelsPerUnit = GetPixelsPerUnit(center, radius, worldMatrix, viewMatrix, projectionMatrix, screenHeight);
+
+	m_lod = std::min(std::max(m_lod, 0), lodCount - 1);
+
+	// Refine while the current level is clearly too coarse, then coarsen while the next level is clearly fine enough.
+	while (m_lod > 0 && lodErrors[m_lod] * pixelsPerUnit > m_pixelThreshold * (1.0f + m_hysteresis))
+	{
+		m_lod--;
+	}
+
+	while (m_lod + 1 < lodCount && lodErrors[m_lod + 1] * pixelsPerUnit <= m_pixelThreshold * (1.0f - m_hysteresis))
+	{
+		m_lod++;
+	}
+
+	m_pixelError = lodErrors[m_lod] * pixelsPerUnit;
+
+	return m_lod;
+}
+
+// GetErrorLimit returns the largest model space error that still stays under the pixel threshold at the distance of the bounds.
+// It is for meshes whose detail is not a fixed set of levels, such as a progressive mesh that refines until its error is below it.
+float LodSelectorClass::GetErrorLimit(const XMFLOAT3& center, float radius, XMMATRIX worldMatrix, XMMATRIX viewMatrix, XMMATRIX projectionMatrix,
+	int screenHeight)
+{
+	return m_pixelThreshold / GetPixelsPerUnit(center, radius, worldMatrix, viewMatrix, projectionMatrix, screenHeight);
+}
+
+
+int LodSelectorClass::GetLod()
+{
+	return m_lod;
+}
+
+
+float LodSelectorClass::GetPixelError()
+{
+	return m_pixelError;
+}
+
+// GetPixelsPerUnit returns how many pixels one model space unit covers at the nearest point of the bounds.
+// The projection only contributes its vertical scale, so it works for the perspective matrix of D3DClass::GetProjectionMatrix.
+float LodSelectorClass::GetPixelsPerUnit(const XMFLOAT3& center, float radius, XMMATRIX worldMatrix, XMMATRIX viewMatrix, XMMATRIX projectionMatrix,
+	int screenHeight)
+{
+	XMVECTOR viewCenter;
+	float scale, distance;
+
+
+	// The world matrix may scale the model, the largest axis scale keeps the estimate conservative.
+	scale = std::max(XMVectorGetX(XMVector3Length(worldMatrix.r[0])), std::max(XMVectorGetX(XMVector3Length(worldMatrix.r[1])),
+		XMVectorGetX(XMVector3Length(worldMatrix.r[2]))));
+
+	viewCenter = XMVector3Transform(XMLoadFloat3(&center), XMMatrixMultiply(worldMatrix, viewMatrix));
+	distance = std::max(XMVectorGetX(XMVector3Length(viewCenter)) - radius * scale, LOD_MIN_DISTANCE);
+
+	return XMVectorGetY(projectionMatrix.r[1]) * screenHeight * 0.5f * scale / distance;
+}
@@ -0,0 +1,45 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: lodselectorclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _LODSELECTORCLASS_H_
+#define _LODSELECTORCLASS_H_
+
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "meshtypes.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: LodSelectorClass
+////////////////////////////////////////////////////////////////////////////////
+// The LodSelectorClass picks the level of detail a mesh is drawn with from the size its simplification error has on screen.
+// The error of every level is projected at the distance of the nearest point of the mesh bounds, and the coarsest level whose error
+// stays under the pixel threshold wins. The hysteresis band around the threshold keeps a mesh sitting right at a switching distance
+// from popping between two levels every frame.
+class LodSelectorClass
+{
+public:
+	LodSelectorClass();
+	LodSelectorClass(const LodSelectorClass&);
+	~LodSelectorClass();
+
+	void SetThreshold(float pixelError, float hysteresis);
+	int Select(const float* lodErrors, int lodCount, const XMFLOAT3& center, float radius, XMMATRIX worldMatrix, XMMATRIX viewMatrix,
+		XMMATRIX projectionMatrix, int screenHeight);
+	float GetErrorLimit(const XMFLOAT3& center, float radius, XMMATRIX worldMatrix, XMMATRIX viewMatrix, XMMATRIX projectionMatrix, int screenHeight);
+
+	int GetLod();
+	float GetPixelError();
+
+private:
+	float GetPixelsPerUnit(const XMFLOAT3& center, float radius, XMMATRIX worldMatrix, XMMATRIX viewMatrix, XMMATRIX projectionMatrix, int screenHeight);
+
+private:
+	float m_pixelThreshold, m_hysteresis;
+	int m_lod;
+	float m_pixelError;
+};
+
+#endif
@@ -0,0 +1,164 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: mappedfileclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "mappedfileclass.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+MappedFileClass::MappedFileClass()
+{
+	m_data = 0;
+	m_size = 0;
+#ifdef _WIN32
+	m_file = INVALID_HANDLE_VALUE;
+	m_mapping = 0;
+#else
+	m_file = -1;
+#endif
+}
+
+
+MappedFileClass::MappedFileClass(const MappedFileClass& other)
+{
+}
+
+
+MappedFileClass::~MappedFileClass()
+{
+}
+
+// Initialize opens the file and maps all of it. An empty file is valid and simply has no data pointer.
+bool MappedFileClass::Initialize(const char* filename)
+{
+#ifdef _WIN32
+	LARGE_INTEGER fileSize;
+
+
+	m_file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (m_file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	if (!GetFileSizeEx(m_file, &fileSize))
+	{
+		Shutdown();
+		return false;
+	}
+
+	m_size = (size_t)fileSize.QuadPart;
+	if (m_size == 0)
+	{
+		return true;
+	}
+
+	m_mapping = CreateFileMappingA(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!m_mapping)
+	{
+		Shutdown();
+		return false;
+	}
+
+	m_data = (const char*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!m_data)
+	{
+		Shutdown();
+		return false;
+	}
+#else
+	struct stat fileInfo;
+	void* view;
+
+
+	m_file = open(filename, O_RDONLY);
+	if (m_file < 0)
+	{
+		return false;
+	}
+
+	if (fstat(m_file, &fileInfo) != 0)
+	{
+		Shutdown();
+		return false;
+	}
+
+	m_size = (size_t)fileInfo.st_size;
+	if (m_size == 0)
+	{
+		return true;
+	}
+
+	view = mmap(0, m_size, PROT_READ, MAP_PRIVATE, m_file, 0);
+	if (view == MAP_FAILED)
+	{
+		Shutdown();
+		return false;
+	}
+	m_data = (const char*)view;
+
+	// The loaders walk the file front to back so let the kernel read ahead aggressively.
+	madvise(view, m_size, MADV_SEQUENTIAL);
+#endif
+
+	return true;
+}
+
+// Shutdown unmaps the view and closes the handles.
+void MappedFileClass::Shutdown()
+{
+#ifdef _WIN32
+	if (m_data)
+	{
+		UnmapViewOfFile(m_data);
+		m_data = 0;
+	}
+
+	if (m_mapping)
+	{
+		CloseHandle(m_mapping);
+		m_mapping = 0;
+	}
+
+	if (m_file != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(m_file);
+		m_file = INVALID_HANDLE_VALUE;
+	}
+#else
+	if (m_data)
+	{
+		munmap((void*)m_data, m_size);
+		m_data = 0;
+	}
+
+	if (m_file >= 0)
+	{
+		close(m_file);
+		m_file = -1;
+	}
+#endif
+	m_size = 0;
+
+	return;
+}
+
+
+const char* MappedFileClass::GetData()
+{
+	return m_data;
+}
+
+
+size_t MappedFileClass::GetSize()
+{
+	return m_size;
+}
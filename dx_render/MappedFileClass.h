@@ -0,0 +1,43 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: mappedfileclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _MAPPEDFILECLASS_H_
+#define _MAPPEDFILECLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <cstddef>
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: MappedFileClass
+////////////////////////////////////////////////////////////////////////////////
+// The MappedFileClass maps a whole file read-only into the address space so loaders can parse it in place without copying it into a buffer.
+// It uses file mapping objects on Windows and mmap everywhere else.
+class MappedFileClass
+{
+public:
+	MappedFileClass();
+	MappedFileClass(const MappedFileClass&);
+	~MappedFileClass();
+
+	bool Initialize(const char* filename);
+	void Shutdown();
+
+	const char* GetData();
+	size_t GetSize();
+
+private:
+	const char* m_data;
+	size_t m_size;
+#ifdef _WIN32
+	void* m_file;
+	void* m_mapping;
+#else
+	int m_file;
+#endif
+};
+
+#endif
@@ -0,0 +1,503 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: meshcacheclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "meshcacheclass.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+
+/////////////
+// GLOBALS //
+/////////////
+static const char MESH_CACHE_MAGIC[4] = { 'D', 'X', 'M', 'S' };
+// Bump the version whenever the header, the VertexType layout or the mesh processing changes so old caches are rebuilt.
+static const uint32_t MESH_CACHE_VERSION = 4;
+// The vertex and index arrays start on this boundary inside the file.
+static const uint64_t MESH_CACHE_ALIGNMENT = 64;
+// The source is hashed through a buffer of this size, a multiple of the eight byte words the hash works on.
+static const size_t MESH_CACHE_HASH_BLOCK = 1024 * 1024;
+
+
+static uint64_t AlignOffset(uint64_t offset)
+{
+	return (offset + MESH_CACHE_ALIGNMENT - 1) & ~(MESH_CACHE_ALIGNMENT - 1);
+}
+
+// FitsInFile checks that count elements of stride bytes from offset end inside the file. It compares against what is left of the
+// file rather than adding up the end, so counts and offsets from a corrupt header can not overflow into a range that looks valid.
+static bool FitsInFile(uint64_t offset, uint64_t count, uint64_t stride, uint64_t fileSize)
+{
+	return offset <= fileSize && count <= (fileSize - offset) / stride;
+}
+
+
+MeshCacheClass::MeshCacheClass()
+{
+	m_header = 0;
+}
+
+
+MeshCacheClass::MeshCacheClass(const MeshCacheClass& other)
+{
+}
+
+
+MeshCacheClass::~MeshCacheClass()
+{
+}
+
+// Initialize maps the cache and checks it against the source file, see MatchesSource. A cache that does not match means the caller
+// has to rebuild it.
+bool MeshCacheClass::Initialize(const char* cacheFilename, const char* sourceFilename)
+{
+	SourceStampType stamp;
+	uint64_t fileSize;
+	bool result;
+
+
+	result = m_file.Initialize(cacheFilename);
+	if (!result)
+	{
+		return false;
+	}
+
+	// Validate the header before trusting any of its offsets.
+	if (m_file.GetSize() < sizeof(HeaderType))
+	{
+		Shutdown();
+		return false;
+	}
+
+	m_header = (const HeaderType*)m_file.GetData();
+	if (memcmp(m_header->magic, MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC)) != 0 || m_header->version != MESH_CACHE_VERSION ||
+		m_header->vertexStride != sizeof(VertexType) || m_header->indexStride != sizeof(uint32_t))
+	{
+		Shutdown();
+		return false;
+	}
+
+	// Every array has to lie inside the file, and every count has to fit the unsigned int the getters hand it out as.
+	fileSize = m_file.GetSize();
+	if (!FitsInFile(m_header->vertexOffset, m_header->vertexCount, m_header->vertexStride, fileSize) ||
+		!FitsInFile(m_header->indexOffset, m_header->indexCount, m_header->indexStride, fileSize) ||
+		!FitsInFile(m_header->lodOffset, m_header->lodCount, sizeof(MeshLodType), fileSize) ||
+		!FitsInFile(m_header->submeshOffset, m_header->submeshCount, sizeof(MeshSubmeshType), fileSize) ||
+		!FitsInFile(m_header->nameOffset, m_header->nameBytes, 1, fileSize) || m_header->vertexCount > UINT32_MAX ||
+		m_header->indexCount > UINT32_MAX || m_header->lodCount > UINT32_MAX || m_header->submeshCount > UINT32_MAX ||
+		m_header->vertexOffset % MESH_CACHE_ALIGNMENT != 0 ||
+		m_header->indexOffset % MESH_CACHE_ALIGNMENT != 0 || m_header->lodOffset % MESH_CACHE_ALIGNMENT != 0 ||
+		m_header->submeshOffset % MESH_CACHE_ALIGNMENT != 0 || m_header->lodCount == 0)
+	{
+		Shutdown();
+		return false;
+	}
+
+	if (!ValidateTables())
+	{
+		Shutdown();
+		return false;
+	}
+
+	// Now check the cache is still up to date with its source.
+	stamp.size = m_header->sourceSize;
+	stamp.time = m_header->sourceTime;
+	stamp.hash = m_header->sourceHash;
+	if (!MatchesSource(sourceFilename, stamp))
+	{
+		Shutdown();
+		return false;
+	}
+
+	return true;
+}
+
+// Shutdown unmaps the cache. Any pointers handed out by the getters are invalid afterwards.
+void MeshCacheClass::Shutdown()
+{
+	m_header = 0;
+	m_file.Shutdown();
+
+	return;
+}
+
+
+const VertexType* MeshCacheClass::GetVertices()
+{
+	return (const VertexType*)(m_file.GetData() + m_header->vertexOffset);
+}
+
+
+const uint32_t* MeshCacheClass::GetIndices()
+{
+	return (const uint32_t*)(m_file.GetData() + m_header->indexOffset);
+}
+
+
+unsigned int MeshCacheClass::GetVertexCount()
+{
+	return (unsigned int)m_header->vertexCount;
+}
+
+
+unsigned int MeshCacheClass::GetIndexCount()
+{
+	return (unsigned int)m_header->indexCount;
+}
+
+
+const MeshLodType* MeshCacheClass::GetLods()
+{
+	return (const MeshLodType*)(m_file.GetData() + m_header->lodOffset);
+}
+
+
+unsigned int MeshCacheClass::GetLodCount()
+{
+	return (unsigned int)m_header->lodCount;
+}
+
+
+const MeshSubmeshType* MeshCacheClass::GetSubmeshes()
+{
+	return (const MeshSubmeshType*)(m_file.GetData() + m_header->submeshOffset);
+}
+
+
+unsigned int MeshCacheClass::GetSubmeshCount()
+{
+	return (unsigned int)m_header->submeshCount;
+}
+
+// GetMaterials copies the material libraries and names out of the cache, ValidateTables has made sure there are as many as the header says.
+void MeshCacheClass::GetMaterials(OUT MeshMaterialListType& materials)
+{
+	const char* name;
+	uint64_t i;
+
+
+	materials.libraries.clear();
+	materials.names.clear();
+
+	name = (const char*)(m_file.GetData() + m_header->nameOffset);
+	for (i = 0; i < m_header->libraryCount + m_header->materialCount; i++)
+	{
+		if (i < m_header->libraryCount)
+		{
+			materials.libraries.push_back(name);
+		}
+		else
+		{
+			materials.names.push_back(name);
+		}
+		name += strlen(name) + 1;
+	}
+
+	return;
+}
+
+
+void MeshCacheClass::GetBounds(XMFLOAT3& boundsMin, XMFLOAT3& boundsMax)
+{
+	boundsMin = XMFLOAT3(m_header->boundsMin[0], m_header->boundsMin[1], m_header->boundsMin[2]);
+	boundsMax = XMFLOAT3(m_header->boundsMax[0], m_header->boundsMax[1], m_header->boundsMax[2]);
+
+	return;
+}
+
+// Write stores the processed mesh next to its source, stamped with the current size, time and hash of the source file.
+bool MeshCacheClass::Write(const char* cacheFilename, const char* sourceFilename, const std::vector<VertexType>& verts, const std::vector<uint32_t>& indices,
+	const std::vector<MeshLodType>& lods, const std::vector<MeshSubmeshType>& submeshes, const MeshMaterialListType& materials)
+{
+	SourceStampType stamp;
+	bool result;
+
+
+	result = GetSourceStamp(sourceFilename, stamp);
+	if (!result)
+	{
+		return false;
+	}
+
+	result = HashFile(sourceFilename, stamp.hash);
+	if (!result)
+	{
+		return false;
+	}
+
+	return Write(cacheFilename, stamp, verts, indices, lods, submeshes, materials);
+}
+
+// This Write takes a stamp the caller already has, so a source that produces many caches is only hashed once.
+// It writes to a temporary file first and renames it over the old cache, so an interrupted write never leaves a cache behind that looks valid.
+bool MeshCacheClass::Write(const char* cacheFilename, const SourceStampType& source, const std::vector<VertexType>& verts, const std::vector<uint32_t>& indices,
+	const std::vector<MeshLodType>& lods, const std::vector<MeshSubmeshType>& submeshes, const MeshMaterialListType& materials)
+{
+	HeaderType header;
+	std::string tempFilename, names;
+	std::ofstream fout;
+	std::error_code error;
+	size_t i;
+	char padding[MESH_CACHE_ALIGNMENT];
+
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC));
+	header.version = MESH_CACHE_VERSION;
+	header.vertexStride = sizeof(VertexType);
+	header.indexStride = sizeof(uint32_t);
+	header.vertexCount = verts.size();
+	header.indexCount = indices.size();
+	header.vertexOffset = AlignOffset(sizeof(HeaderType));
+	header.indexOffset = AlignOffset(header.vertexOffset + header.vertexCount * header.vertexStride);
+	header.lodCount = lods.size();
+	header.lodOffset = AlignOffset(header.indexOffset + header.indexCount * header.indexStride);
+	header.submeshCount = submeshes.size();
+	header.submeshOffset = AlignOffset(header.lodOffset + header.lodCount * sizeof(MeshLodType));
+	header.libraryCount = materials.libraries.size();
+	header.materialCount = materials.names.size();
+	header.nameOffset = header.submeshOffset + header.submeshCount * sizeof(MeshSubmeshType);
+	header.sourceSize = source.size;
+	header.sourceTime = source.time;
+	header.sourceHash = source.hash;
+
+	// Compute the bounds while we have the vertices at hand.
+	for (i = 0; i < verts.size(); i++)
+	{
+		const float* p = &verts[i].position.x;
+		for (int k = 0; k < 3; k++)
+		{
+			header.boundsMin[k] = (i == 0 || p[k] < header.boundsMin[k]) ? p[k] : header.boundsMin[k];
+			header.boundsMax[k] = (i == 0 || p[k] > header.boundsMax[k]) ? p[k] : header.boundsMax[k];
+		}
+	}
+
+	for (i = 0; i < materials.libraries.size(); i++)
+	{
+		names.append(materials.libraries[i].c_str(), materials.libraries[i].size() + 1);
+	}
+	for (i = 0; i < materials.names.size(); i++)
+	{
+		names.append(materials.names[i].c_str(), materials.names[i].size() + 1);
+	}
+	header.nameBytes = names.size();
+
+	tempFilename = std::string(cacheFilename) + ".tmp";
+	fout.open(tempFilename, std::ios::binary | std::ios::trunc);
+	if (!fout)
+	{
+		return false;
+	}
+
+	memset(padding, 0, sizeof(padding));
+	fout.write((const char*)&header, sizeof(header));
+	fout.write(padding, header.vertexOffset - sizeof(header));
+	fout.write((const char*)verts.data(), verts.size() * sizeof(VertexType));
+	fout.write(padding, header.indexOffset - (header.vertexOffset + verts.size() * sizeof(VertexType)));
+	fout.write((const char*)indices.data(), indices.size() * sizeof(uint32_t));
+	fout.write(padding, header.lodOffset - (header.indexOffset + indices.size() * sizeof(uint32_t)));
+	fout.write((const char*)lods.data(), lods.size() * sizeof(MeshLodType));
+	fout.write(padding, header.submeshOffset - (header.lodOffset + lods.size() * sizeof(MeshLodType)));
+	fout.write((const char*)submeshes.data(), submeshes.size() * sizeof(MeshSubmeshType));
+	fout.write(names.data(), names.size());
+	fout.close();
+	if (!fout)
+	{
+		std::filesystem::remove(tempFilename, error);
+		return false;
+	}
+
+	std::filesystem::rename(tempFilename, cacheFilename, error);
+	if (error)
+	{
+		std::filesystem::remove(tempFilename, error);
+		return false;
+	}
+
+	return true;
+}
+
+// GetCacheFilename swaps the source extension for .dxmesh, so ../cube.obj is cached as ../cube.dxmesh.
+std::string MeshCacheClass::GetCacheFilename(const char* sourceFilename)
+{
+	std::filesystem::path path(sourceFilename);
+
+
+	path.replace_extension(".dxmesh");
+
+	return path.string();
+}
+
+
+// GetSourceStamp fills in the size and modification time of the source, the hash is left to HashFile or the caller.
+bool MeshCacheClass::GetSourceStamp(const char* sourceFilename, OUT SourceStampType& stamp)
+{
+	std::error_code error;
+
+
+	stamp.hash = 0;
+	stamp.size = (uint64_t)std::filesystem::file_size(sourceFilename, error);
+	if (error)
+	{
+		return false;
+	}
+
+	stamp.time = (int64_t)std::filesystem::last_write_time(sourceFilename, error).time_since_epoch().count();
+	if (error)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+// MatchesSource checks a stamp recorded when a file was built against the source as it is now. The source matches when it still has
+// the recorded size and modification time. If only the time changed (the file was touched or copied) the source is hashed and still
+// matches when the contents are the same.
+bool MeshCacheClass::MatchesSource(const char* sourceFilename, const SourceStampType& recorded)
+{
+	SourceStampType stamp;
+	uint64_t hash;
+	bool result;
+
+
+	result = GetSourceStamp(sourceFilename, stamp);
+	if (!result || stamp.size != recorded.size)
+	{
+		return false;
+	}
+
+	if (stamp.time != recorded.time)
+	{
+		result = HashFile(sourceFilename, hash);
+		if (!result || hash != recorded.hash)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// BeginHash and HashBytes run 64 bit FNV-1a over the file a word at a time, which is enough to tell a changed source from a touched one.
+// A file can be hashed in pieces as long as every piece but the last is a multiple of eight bytes long.
+uint64_t MeshCacheClass::BeginHash()
+{
+	return 14695981039346656037ull;
+}
+
+
+uint64_t MeshCacheClass::HashBytes(uint64_t hash, const char* data, size_t size)
+{
+	uint64_t word;
+	size_t i;
+
+
+	for (i = 0; i + sizeof(word) <= size; i += sizeof(word))
+	{
+		memcpy(&word, data + i, sizeof(word));
+		hash = (hash ^ word) * 1099511628211ull;
+	}
+
+	for (; i < size; i++)
+	{
+		hash = (hash ^ (unsigned char)data[i]) * 1099511628211ull;
+	}
+
+	return hash;
+}
+
+// ValidateTables checks that every index names a vertex of the cache, that every level lies inside the index array, that its submeshes
+// follow each other inside it and use a material that exists, and that the name block holds exactly the strings the header counts.
+// The offsets themselves were checked before. The indices are read once here because the mesh is processed on the CPU straight from
+// the mapped view, a stale or corrupt cache must not send that past the vertices.
+bool MeshCacheClass::ValidateTables()
+{
+	const MeshLodType* lods;
+	const MeshSubmeshType* submeshes;
+	const uint32_t* indices;
+	const char* names;
+	uint64_t i, j, start, terminators;
+	uint32_t largest;
+
+
+	indices = GetIndices();
+	largest = 0;
+	for (i = 0; i < m_header->indexCount; i++)
+	{
+		largest = indices[i] > largest ? indices[i] : largest;
+	}
+	if (m_header->indexCount > 0 && largest >= m_header->vertexCount)
+	{
+		return false;
+	}
+
+	lods = GetLods();
+	submeshes = GetSubmeshes();
+	for (i = 0; i < m_header->lodCount; i++)
+	{
+		if ((uint64_t)lods[i].startIndex + lods[i].indexCount > m_header->indexCount ||
+			(uint64_t)lods[i].firstSubmesh + lods[i].submeshCount > m_header->submeshCount)
+		{
+			return false;
+		}
+
+		start = lods[i].startIndex;
+		for (j = lods[i].firstSubmesh; j < (uint64_t)lods[i].firstSubmesh + lods[i].submeshCount; j++)
+		{
+			if (submeshes[j].startIndex != start || submeshes[j].material >= m_header->materialCount)
+			{
+				return false;
+			}
+			start += submeshes[j].indexCount;
+		}
+
+		if (start != (uint64_t)lods[i].startIndex + lods[i].indexCount)
+		{
+			return false;
+		}
+	}
+
+	names = (const char*)(m_file.GetData() + m_header->nameOffset);
+	terminators = 0;
+	for (i = 0; i < m_header->nameBytes; i++)
+	{
+		terminators += names[i] == 0 ? 1 : 0;
+	}
+
+	if (terminators != m_header->libraryCount + m_header->materialCount || (m_header->nameBytes > 0 && names[m_header->nameBytes - 1] != 0))
+	{
+		return false;
+	}
+
+	return true;
+}
+
+// HashFile reads the file through a fixed buffer rather than mapping it, so hashing a huge source does not grow the working set.
+bool MeshCacheClass::HashFile(const char* filename, OUT uint64_t& hash)
+{
+	std::ifstream fin;
+	std::vector<char> buffer;
+
+
+	fin.open(filename, std::ios::binary);
+	if (!fin)
+	{
+		return false;
+	}
+
+	buffer.resize(MESH_CACHE_HASH_BLOCK);
+	hash = BeginHash();
+	while (fin)
+	{
+		fin.read(buffer.data(), buffer.size());
+		hash = HashBytes(hash, buffer.data(), (size_t)fin.gcount());
+	}
+
+	if (fin.bad())
+	{
+		return false;
+	}
+
+	return true;
+}
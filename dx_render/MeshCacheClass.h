@@ -0,0 +1,96 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: meshcacheclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _MESHCACHECLASS_H_
+#define _MESHCACHECLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <cstdint>
+#include <string>
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "meshtypes.h"
+#include "mappedfileclass.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: MeshCacheClass
+////////////////////////////////////////////////////////////////////////////////
+// The MeshCacheClass reads and writes .dxmesh files, a binary copy of a fully processed mesh.
+// The file holds the final VertexType array, the 32 bit index array with every level of detail after the full mesh, the table
+// of those levels, the submeshes each level is drawn in and the material names they refer to. The arrays are stored exactly as they
+// are uploaded, so a loaded cache is just a mapped view whose pointers can be handed to CreateBuffer. The header records the size, modification time and hash of the source file
+// the cache was built from, and Initialize refuses a cache that no longer matches its source.
+class MeshCacheClass
+{
+public:
+	struct SourceStampType
+	{
+		uint64_t size;
+		int64_t time;
+		uint64_t hash;
+	};
+
+private:
+	struct HeaderType
+	{
+		char magic[4];
+		uint32_t version;
+		uint32_t vertexStride, indexStride;
+		uint64_t vertexCount, indexCount;
+		uint64_t vertexOffset, indexOffset;
+		uint64_t lodCount, lodOffset;
+		uint64_t submeshCount, submeshOffset;
+		// The material libraries and then the material names, each one terminated by a zero byte.
+		uint64_t libraryCount, materialCount, nameOffset, nameBytes;
+		float boundsMin[3], boundsMax[3];
+		uint64_t sourceSize;
+		int64_t sourceTime;
+		uint64_t sourceHash;
+	};
+
+public:
+	MeshCacheClass();
+	MeshCacheClass(const MeshCacheClass&);
+	~MeshCacheClass();
+
+	bool Initialize(const char* cacheFilename, const char* sourceFilename);
+	void Shutdown();
+
+	const VertexType* GetVertices();
+	const uint32_t* GetIndices();
+	unsigned int GetVertexCount();
+	unsigned int GetIndexCount();
+	const MeshLodType* GetLods();
+	unsigned int GetLodCount();
+	const MeshSubmeshType* GetSubmeshes();
+	unsigned int GetSubmeshCount();
+	void GetMaterials(OUT MeshMaterialListType&);
+	void GetBounds(XMFLOAT3& boundsMin, XMFLOAT3& boundsMax);
+
+	static bool Write(const char* cacheFilename, const char* sourceFilename, const std::vector<VertexType>& verts, const std::vector<uint32_t>& indices,
+		const std::vector<MeshLodType>& lods, const std::vector<MeshSubmeshType>& submeshes, const MeshMaterialListType& materials);
+	static bool Write(const char* cacheFilename, const SourceStampType& source, const std::vector<VertexType>& verts, const std::vector<uint32_t>& indices,
+		const std::vector<MeshLodType>& lods, const std::vector<MeshSubmeshType>& submeshes, const MeshMaterialListType& materials);
+	static std::string GetCacheFilename(const char* sourceFilename);
+
+	static bool GetSourceStamp(const char* sourceFilename, OUT SourceStampType&);
+	static bool MatchesSource(const char* sourceFilename, const SourceStampType&);
+	static bool HashFile(const char* filename, OUT uint64_t& hash);
+	static uint64_t BeginHash();
+	static uint64_t HashBytes(uint64_t hash, const char* data, size_t size);
+
+private:
+	bool ValidateTables();
+
+private:
+	MappedFileClass m_file;
+	const HeaderType* m_header;
+};
+
+#endif
@@ -0,0 +1,502 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: meshcompressionclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "meshcompressionclass.h"
+#include "vertexlayouts.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+
+/////////////
+// GLOBALS //
+/////////////
+// A 16 bit index buffer can address this many vertices from its base vertex.
+static const unsigned int SHORT_INDEX_VERTEX_LIMIT = 65536;
+
+
+static float SignNotZero(float value)
+{
+	return value >= 0.0f ? 1.0f : -1.0f;
+}
+
+
+static int16_t FloatToSnorm16(float value)
+{
+	return (int16_t)lroundf(std::max(-1.0f, std::min(1.0f, value)) * 32767.0f);
+}
+
+
+static float Snorm16ToFloat(int16_t value)
+{
+	return std::max(-1.0f, (float)value / 32767.0f);
+}
+
+
+MeshCompressionClass::MeshCompressionClass()
+{
+}
+
+
+MeshCompressionClass::MeshCompressionClass(const MeshCompressionClass& other)
+{
+}
+
+
+MeshCompressionClass::~MeshCompressionClass()
+{
+}
+
+// EncodeVertices packs the full vertices into one of the compact layouts. The position grid spans the mesh bounds,
+// so the quantization step is the extent of each axis divided by 65535.
+void MeshCompressionClass::EncodeVertices(const VertexType* verts, unsigned int vertexCount, VertexFormatType format,
+	OUT std::vector<CompactVertexType>& out_verts, OUT QuantizationType& quantization)
+{
+	XMFLOAT3 boundsMax;
+	unsigned int i;
+
+
+	quantization.boundsMin = XMFLOAT3(0.0f, 0.0f, 0.0f);
+	boundsMax = XMFLOAT3(0.0f, 0.0f, 0.0f);
+	for (i = 0; i < vertexCount; i++)
+	{
+		if (i == 0)
+		{
+			quantization.boundsMin = boundsMax = verts[i].position;
+		}
+		quantization.boundsMin.x = std::min(quantization.boundsMin.x, verts[i].position.x);
+		quantization.boundsMin.y = std::min(quantization.boundsMin.y, verts[i].position.y);
+		quantization.boundsMin.z = std::min(quantization.boundsMin.z, verts[i].position.z);
+		boundsMax.x = std::max(boundsMax.x, verts[i].position.x);
+		boundsMax.y = std::max(boundsMax.y, verts[i].position.y);
+		boundsMax.z = std::max(boundsMax.z, verts[i].position.z);
+	}
+
+	quantization.boundsExtent = XMFLOAT3(boundsMax.x - quantization.boundsMin.x, boundsMax.y - quantization.boundsMin.y, boundsMax.z - quantization.boundsMin.z);
+
+	EncodeVertices(verts, vertexCount, format, quantization, out_verts);
+
+	return;
+}
+
+// This EncodeVertices uses a grid the caller already has, for vertices that arrive a few at a time but have to share one grid.
+// Positions outside its bounds are clamped to them. The format is looked at once, the vertices are packed by the layout of it.
+void MeshCompressionClass::EncodeVertices(const VertexType* verts, unsigned int vertexCount, VertexFormatType format, const QuantizationType& quantization,
+	OUT std::vector<CompactVertexType>& out_verts)
+{
+	VertexPackContextType context;
+	uint8_t* stream;
+	const float* p;
+	unsigned int k;
+
+
+	// A flat axis gets a zero scale on encode and decodes back to the minimum.
+	context.compression = this;
+	p = &quantization.boundsExtent.x;
+	for (k = 0; k < 3; k++)
+	{
+		context.boundsMin[k] = (&quantization.boundsMin.x)[k];
+		context.invExtent[k] = p[k] > 0.0f ? 1.0f / p[k] : 0.0f;
+	}
+
+	out_verts.resize(vertexCount);
+	stream = (uint8_t*)out_verts.data();
+
+	if (format == VERTEX_FORMAT_COMPACT_PACKED)
+	{
+		CompactPackedVertexLayoutType::Pack(verts, vertexCount, context, &stream);
+	}
+	else
+	{
+		CompactOctahedralVertexLayoutType::Pack(verts, vertexCount, context, &stream);
+	}
+
+	return;
+}
+
+// DecodeVertices is the CPU mirror of what the input assembler and the vertex shader do with the compact layouts.
+void MeshCompressionClass::DecodeVertices(const std::vector<CompactVertexType>& verts, VertexFormatType format, const QuantizationType& quantization,
+	OUT std::vector<VertexType>& out_verts)
+{
+	size_t i;
+
+
+	out_verts.resize(verts.size());
+	for (i = 0; i < verts.size(); i++)
+	{
+		const CompactVertexType& compact = verts[i];
+		VertexType& vertex = out_verts[i];
+
+		vertex.position.x = quantization.boundsMin.x + (compact.position[0] / 65535.0f) * quantization.boundsExtent.x;
+		vertex.position.y = quantization.boundsMin.y + (compact.position[1] / 65535.0f) * quantization.boundsExtent.y;
+		vertex.position.z = quantization.boundsMin.z + (compact.position[2] / 65535.0f) * quantization.boundsExtent.z;
+
+		vertex.texture.x = HalfToFloat(compact.texture[0]);
+		vertex.texture.y = HalfToFloat(compact.texture[1]);
+
+		if (format == VERTEX_FORMAT_COMPACT_PACKED)
+		{
+			vertex.normal = DecodePacked1010102(compact.normal);
+		}
+		else
+		{
+			vertex.normal = DecodeOctahedral(compact.normal);
+		}
+	}
+
+	return;
+}
+
+// MeasureError compares decoded vertices against the originals. The position bound is half a quantization step on the longest axis
+// plus the float rounding of the decode itself, every decoded position has to be within it.
+MeshCompressionClass::ErrorStatsType MeshCompressionClass::MeasureError(const VertexType* original, const std::vector<VertexType>& decoded,
+	const QuantizationType& quantization)
+{
+	ErrorStatsType stats;
+	XMVECTOR a, b;
+	float dot, magnitude;
+	size_t i;
+
+
+	memset(&stats, 0, sizeof(stats));
+	magnitude = std::max(std::max(fabsf(quantization.boundsMin.x), fabsf(quantization.boundsMin.x + quantization.boundsExtent.x)),
+		std::max(std::max(fabsf(quantization.boundsMin.y), fabsf(quantization.boundsMin.y + quantization.boundsExtent.y)),
+			std::max(fabsf(quantization.boundsMin.z), fabsf(quantization.boundsMin.z + quantization.boundsExtent.z))));
+	stats.positionErrorBound = 0.5f * std::max(quantization.boundsExtent.x, std::max(quantization.boundsExtent.y, quantization.boundsExtent.z)) / 65535.0f +
+		2.0f * magnitude * FLT_EPSILON;
+
+	for (i = 0; i < decoded.size(); i++)
+	{
+		stats.maxPositionError = std::max(stats.maxPositionError, fabsf(original[i].position.x - decoded[i].position.x));
+		stats.maxPositionError = std::max(stats.maxPositionError, fabsf(original[i].position.y - decoded[i].position.y));
+		stats.maxPositionError = std::max(stats.maxPositionError, fabsf(original[i].position.z - decoded[i].position.z));
+
+		stats.maxTextureError = std::max(stats.maxTextureError, fabsf(original[i].texture.x - decoded[i].texture.x));
+		stats.maxTextureError = std::max(stats.maxTextureError, fabsf(original[i].texture.y - decoded[i].texture.y));
+
+		// Normals are compared by angle, zero length input normals have no direction to lose.
+		a = XMLoadFloat3(&original[i].normal);
+		if (XMVectorGetX(XMVector3LengthSq(a)) > 0.0f)
+		{
+			b = XMLoadFloat3(&decoded[i].normal);
+			dot = XMVectorGetX(XMVector3Dot(XMVector3Normalize(a), XMVector3Normalize(b)));
+			stats.maxNormalAngle = std::max(stats.maxNormalAngle, acosf(std::max(-1.0f, std::min(1.0f, dot))));
+		}
+	}
+
+	return stats;
+}
+
+// GetDecodeMatrix returns the scale and translation that turn UNORM positions back into model space.
+// Multiplying it in front of the world matrix lets the unchanged vertex shader draw quantized positions.
+XMMATRIX MeshCompressionClass::GetDecodeMatrix(const QuantizationType& quantization)
+{
+	return XMMatrixMultiply(XMMatrixScaling(quantization.boundsExtent.x, quantization.boundsExtent.y, quantization.boundsExtent.z),
+		XMMatrixTranslation(quantization.boundsMin.x, quantization.boundsMin.y, quantization.boundsMin.z));
+}
+
+// NarrowIndices converts a 32 bit index buffer to 16 bits when every vertex can be addressed that way.
+bool MeshCompressionClass::NarrowIndices(const uint32_t* indices, unsigned int indexCount, unsigned int vertexCount, OUT std::vector<uint16_t>& out_indices)
+{
+	unsigned int i;
+
+
+	if (vertexCount > SHORT_INDEX_VERTEX_LIMIT)
+	{
+		return false;
+	}
+
+	out_indices.resize(indexCount);
+	for (i = 0; i < indexCount; i++)
+	{
+		out_indices[i] = (uint16_t)indices[i];
+	}
+
+	return true;
+}
+
+// SplitIndices cuts a mesh with too many vertices for 16 bit indices into ranges that each use at most 65536 vertices.
+// Triangles are taken in order so the cache optimized order survives, each range gets its own copy of the vertices it uses
+// (vertices on a range border are duplicated) and its indices are relative to the range's base vertex.
+void MeshCompressionClass::SplitIndices(const VertexType* verts, const uint32_t* indices, unsigned int indexCount, OUT std::vector<VertexType>& out_verts,
+	OUT std::vector<uint16_t>& out_indices, OUT std::vector<IndexRangeType>& out_ranges)
+{
+	std::vector<uint32_t> localIndex, localStamp;
+	IndexRangeType range;
+	unsigned int i, k, newVertices, stamp, vertexCount;
+	uint32_t v;
+
+
+	// Size the lookup tables from the highest index used.
+	vertexCount = 0;
+	for (i = 0; i < indexCount; i++)
+	{
+		vertexCount = std::max(vertexCount, (unsigned int)indices[i] + 1);
+	}
+
+	localIndex.assign(vertexCount, 0);
+	localStamp.assign(vertexCount, 0);
+	out_verts.clear();
+	out_indices.clear();
+	out_ranges.clear();
+	out_indices.reserve(indexCount);
+
+	stamp = 1;
+	range.startIndex = 0;
+	range.indexCount = 0;
+	range.baseVertex = 0;
+	range.material = 0;
+
+	for (i = 0; i + 2 < indexCount; i += 3)
+	{
+		// Count how many vertices this triangle would add to the current range.
+		newVertices = 0;
+		for (k = 0; k < 3; k++)
+		{
+			newVertices += localStamp[indices[i + k]] != stamp ? 1 : 0;
+		}
+
+		// Close the range when the triangle does not fit anymore. The stamp invalidates the local indices of the old range.
+		if (out_verts.size() - range.baseVertex + newVertices > SHORT_INDEX_VERTEX_LIMIT)
+		{
+			out_ranges.push_back(range);
+			range.startIndex = (unsigned int)out_indices.size();
+			range.indexCount = 0;
+			range.baseVertex = (int)out_verts.size();
+			stamp++;
+		}
+
+		for (k = 0; k < 3; k++)
+		{
+			v = indices[i + k];
+			if (localStamp[v] != stamp)
+			{
+				localStamp[v] = stamp;
+				localIndex[v] = (uint32_t)(out_verts.size() - range.baseVertex);
+				out_verts.push_back(verts[v]);
+			}
+			out_indices.push_back((uint16_t)localIndex[v]);
+		}
+		range.indexCount += 3;
+	}
+
+	if (range.indexCount > 0)
+	{
+		out_ranges.push_back(range);
+	}
+
+	return;
+}
+
+// SplitStreams de-interleaves vertices of the given format, VertexType for the full one and CompactVertexType for the others, into a
+// position stream and an attribute stream. Both layouts start with the position, so each vertex is cut in two at its position stride.
+void MeshCompressionClass::SplitStreams(const void* verts, unsigned int vertexCount, VertexFormatType format, OUT std::vector<uint8_t>& out_positions,
+	OUT std::vector<uint8_t>& out_attributes)
+{
+	const uint8_t* source;
+	unsigned int vertexStride, positionStride, attributeStride;
+	unsigned int i;
+
+
+	vertexStride = GetVertexStride(format);
+	positionStride = GetPositionStride(format);
+	attributeStride = GetAttributeStride(format);
+
+	out_positions.resize((size_t)vertexCount * positionStride);
+	out_attributes.resize((size_t)vertexCount * attributeStride);
+
+	source = (const uint8_t*)verts;
+	for (i = 0; i < vertexCount; i++)
+	{
+		memcpy(&out_positions[(size_t)i * positionStride], source, positionStride);
+		memcpy(&out_attributes[(size_t)i * attributeStride], source + positionStride, attributeStride);
+		source += vertexStride;
+	}
+
+	return;
+}
+
+// The strides come from the layouts, the compact formats only differ in how the normal is packed.
+unsigned int MeshCompressionClass::GetVertexStride(VertexFormatType format)
+{
+	return format == VERTEX_FORMAT_FULL ? FullVertexLayoutType::GetStride(0) : CompactOctahedralVertexLayoutType::GetStride(0);
+}
+
+
+unsigned int MeshCompressionClass::GetPositionStride(VertexFormatType format)
+{
+	return format == VERTEX_FORMAT_FULL ? FullSplitVertexLayoutType::GetStride(0) : CompactOctahedralSplitVertexLayoutType::GetStride(0);
+}
+
+
+unsigned int MeshCompressionClass::GetAttributeStride(VertexFormatType format)
+{
+	return GetVertexStride(format) - GetPositionStride(format);
+}
+
+// FloatToHalf converts to IEEE half precision with round to nearest even, the same rounding the GPU uses.
+uint16_t MeshCompressionClass::FloatToHalf(float value)
+{
+	uint32_t bits, sign, mantissa, half, remainder, halfway;
+	int exponent, shift;
+
+
+	memcpy(&bits, &value, sizeof(bits));
+	sign = (bits >> 16) & 0x8000;
+	exponent = (int)((bits >> 23) & 0xff);
+	mantissa = bits & 0x7fffff;
+
+	// Infinity and NaN keep their class.
+	if (exponent == 0xff)
+	{
+		return (uint16_t)(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+	}
+
+	exponent = exponent - 127 + 15;
+	if (exponent >= 31)
+	{
+		return (uint16_t)(sign | 0x7c00);
+	}
+
+	// Values below the smallest normal half become subnormals or zero.
+	if (exponent <= 0)
+	{
+		if (exponent < -10)
+		{
+			return (uint16_t)sign;
+		}
+
+		mantissa |= 0x800000;
+		shift = 14 - exponent;
+		half = mantissa >> shift;
+		remainder = mantissa & ((1u << shift) - 1);
+		halfway = 1u << (shift - 1);
+		if (remainder > halfway || (remainder == halfway && (half & 1)))
+		{
+			half++;
+		}
+		return (uint16_t)(sign | half);
+	}
+
+	// A carry out of the mantissa correctly bumps the exponent, up to infinity.
+	half = ((uint32_t)exponent << 10) | (mantissa >> 13);
+	remainder = mantissa & 0x1fff;
+	if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+	{
+		half++;
+	}
+
+	return (uint16_t)(sign | half);
+}
+
+
+float MeshCompressionClass::HalfToFloat(uint16_t half)
+{
+	uint32_t sign, exponent, mantissa, bits;
+	float value;
+
+
+	sign = (uint32_t)(half & 0x8000) << 16;
+	exponent = (half >> 10) & 0x1f;
+	mantissa = half & 0x3ff;
+
+	if (exponent == 0)
+	{
+		value = ldexpf((float)mantissa, -24);
+		return sign ? -value : value;
+	}
+
+	if (exponent == 31)
+	{
+		bits = sign | 0x7f800000 | (mantissa << 13);
+	}
+	else
+	{
+		bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+	}
+
+	memcpy(&value, &bits, sizeof(value));
+
+	return value;
+}
+
+// EncodeOctahedral projects the unit normal onto the octahedron |x| + |y| + |z| = 1 and folds the lower half over the upper one,
+// which maps the sphere onto a square that two 16 bit SNORMs cover evenly. DXGI_FORMAT_R16G16_SNORM reads it back.
+uint32_t MeshCompressionClass::EncodeOctahedral(const XMFLOAT3& normal)
+{
+	float length, x, y, foldedX;
+
+
+	length = fabsf(normal.x) + fabsf(normal.y) + fabsf(normal.z);
+	if (length <= 0.0f)
+	{
+		return 0;
+	}
+
+	x = normal.x / length;
+	y = normal.y / length;
+	if (normal.z < 0.0f)
+	{
+		foldedX = (1.0f - fabsf(y)) * SignNotZero(x);
+		y = (1.0f - fabsf(x)) * SignNotZero(y);
+		x = foldedX;
+	}
+
+	return (uint32_t)(uint16_t)FloatToSnorm16(x) | ((uint32_t)(uint16_t)FloatToSnorm16(y) << 16);
+}
+
+
+XMFLOAT3 MeshCompressionClass::DecodeOctahedral(uint32_t encoded)
+{
+	XMFLOAT3 normal;
+	float x, y, z, unfoldedX;
+
+
+	x = Snorm16ToFloat((int16_t)(encoded & 0xffff));
+	y = Snorm16ToFloat((int16_t)(encoded >> 16));
+	z = 1.0f - fabsf(x) - fabsf(y);
+	if (z < 0.0f)
+	{
+		unfoldedX = (1.0f - fabsf(y)) * SignNotZero(x);
+		y = (1.0f - fabsf(x)) * SignNotZero(y);
+		x = unfoldedX;
+	}
+
+	XMStoreFloat3(&normal, XMVector3Normalize(XMVectorSet(x, y, z, 0.0f)));
+
+	return normal;
+}
+
+// EncodePacked1010102 biases each component into [0, 1] and stores it in 10 bits for DXGI_FORMAT_R10G10B10A2_UNORM.
+// The shader has to expand it with n * 2 - 1.
+uint32_t MeshCompressionClass::EncodePacked1010102(const XMFLOAT3& normal)
+{
+	const float* n;
+	uint32_t packed, component;
+	int k;
+
+
+	n = &normal.x;
+	packed = 0;
+	for (k = 0; k < 3; k++)
+	{
+		component = (uint32_t)lroundf(std::max(0.0f, std::min(1.0f, n[k] * 0.5f + 0.5f)) * 1023.0f);
+		packed |= component << (10 * k);
+	}
+
+	return packed | (3u << 30);
+}
+
+
+XMFLOAT3 MeshCompressionClass::DecodePacked1010102(uint32_t packed)
+{
+	XMFLOAT3 normal;
+
+
+	normal.x = ((packed & 0x3ff) / 1023.0f) * 2.0f - 1.0f;
+	normal.y = (((packed >> 10) & 0x3ff) / 1023.0f) * 2.0f - 1.0f;
+	normal.z = (((packed >> 20) & 0x3ff) / 1023.0f) * 2.0f - 1.0f;
+
+	return normal;
+}
@@ -0,0 +1,101 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: meshcompressionclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _MESHCOMPRESSIONCLASS_H_
+#define _MESHCOMPRESSIONCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <cstdint>
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "meshtypes.h"
+
+
+//////////////
+// TYPEDEFS //
+//////////////
+// The vertex layouts a mesh can be uploaded with. The full layout is the 32 byte VertexType as it is, the compact layouts
+// are 16 bytes: positions quantized to 16 bit UNORM inside the mesh bounds, half float texture coordinates and a 32 bit normal
+// stored either octahedral encoded in two 16 bit SNORMs or as 10:10:10:2 UNORM.
+enum VertexFormatType
+{
+	VERTEX_FORMAT_FULL,
+	VERTEX_FORMAT_COMPACT_OCTAHEDRAL,
+	VERTEX_FORMAT_COMPACT_PACKED,
+};
+
+// The streams a vertex buffer can be split into, and which of them a pass binds. The position stream holds nothing but tightly
+// packed positions so passes that only need depth fetch the fewest bytes, the attribute stream holds the rest of each vertex.
+// A buffer that is not split has all of it in one interleaved stream.
+enum VertexStreamType
+{
+	VERTEX_STREAM_POSITION = 1,
+	VERTEX_STREAM_ATTRIBUTES = 2,
+	VERTEX_STREAM_ALL = VERTEX_STREAM_POSITION | VERTEX_STREAM_ATTRIBUTES,
+};
+
+struct CompactVertexType
+{
+	uint16_t position[4];
+	uint16_t texture[2];
+	uint32_t normal;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: MeshCompressionClass
+////////////////////////////////////////////////////////////////////////////////
+// The MeshCompressionClass encodes and decodes the compact vertex layouts and narrows index buffers to 16 bits.
+// It is plain CPU code so the precision loss of every format can be measured without a device.
+class MeshCompressionClass
+{
+public:
+	// Quantized positions decode as boundsMin + position * boundsExtent, with position in the [0, 1] UNORM range.
+	struct QuantizationType
+	{
+		XMFLOAT3 boundsMin, boundsExtent;
+	};
+
+	struct ErrorStatsType
+	{
+		float maxPositionError, positionErrorBound;
+		float maxTextureError;
+		float maxNormalAngle;	// In radians.
+	};
+
+public:
+	MeshCompressionClass();
+	MeshCompressionClass(const MeshCompressionClass&);
+	~MeshCompressionClass();
+
+	void EncodeVertices(const VertexType* verts, unsigned int vertexCount, VertexFormatType, OUT std::vector<CompactVertexType>&, OUT QuantizationType&);
+	void EncodeVertices(const VertexType* verts, unsigned int vertexCount, VertexFormatType, const QuantizationType&, OUT std::vector<CompactVertexType>&);
+	void DecodeVertices(const std::vector<CompactVertexType>&, VertexFormatType, const QuantizationType&, OUT std::vector<VertexType>&);
+	ErrorStatsType MeasureError(const VertexType* original, const std::vector<VertexType>& decoded, const QuantizationType&);
+	XMMATRIX GetDecodeMatrix(const QuantizationType&);
+
+	bool NarrowIndices(const uint32_t* indices, unsigned int indexCount, unsigned int vertexCount, OUT std::vector<uint16_t>&);
+	void SplitIndices(const VertexType* verts, const uint32_t* indices, unsigned int indexCount, OUT std::vector<VertexType>& out_verts,
+		OUT std::vector<uint16_t>& out_indices, OUT std::vector<IndexRangeType>& out_ranges);
+
+	void SplitStreams(const void* verts, unsigned int vertexCount, VertexFormatType, OUT std::vector<uint8_t>& out_positions,
+		OUT std::vector<uint8_t>& out_attributes);
+
+	unsigned int GetVertexStride(VertexFormatType);
+	unsigned int GetPositionStride(VertexFormatType);
+	unsigned int GetAttributeStride(VertexFormatType);
+
+	uint16_t FloatToHalf(float);
+	float HalfToFloat(uint16_t);
+	uint32_t EncodeOctahedral(const XMFLOAT3&);
+	XMFLOAT3 DecodeOctahedral(uint32_t);
+	uint32_t EncodePacked1010102(const XMFLOAT3&);
+	XMFLOAT3 DecodePacked1010102(uint32_t);
+};
+
+#endif
@@ -0,0 +1,520 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: meshnormalclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "meshnormalclass.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+
+/////////////
+// GLOBALS //
+/////////////
+// Triangles and vertices are handed to the workers in blocks of this many, small enough to balance and big enough to stay in cache.
+static const size_t NORMAL_BLOCK_TRIANGLES = 16384;
+static const size_t NORMAL_BLOCK_VERTICES = 8192;
+// Texture mappings whose area in uv space is below this have no usable tangent direction.
+static const float NORMAL_MIN_UV_AREA = 1.0e-20f;
+
+
+// CornerAngles returns the angles of a triangle at its three corners, the weight each face gets in the vertex frames.
+static XMVECTOR CornerAngles(FXMVECTOR p0, FXMVECTOR p1, FXMVECTOR p2)
+{
+	XMVECTOR e01, e02, e12;
+	float a0, a1, a2;
+
+
+	e01 = XMVector3Normalize(XMVectorSubtract(p1, p0));
+	e02 = XMVector3Normalize(XMVectorSubtract(p2, p0));
+	e12 = XMVector3Normalize(XMVectorSubtract(p2, p1));
+
+	a0 = acosf(fmaxf(-1.0f, fminf(1.0f, XMVectorGetX(XMVector3Dot(e01, e02)))));
+	a1 = acosf(fmaxf(-1.0f, fminf(1.0f, -XMVectorGetX(XMVector3Dot(e01, e12)))));
+	a2 = XM_PI - a0 - a1;
+
+	return XMVectorSet(a0, a1, a2 > 0.0f ? a2 : 0.0f, 0.0f);
+}
+
+// PerpendicularTo returns some unit vector at a right angle to the normal, for vertices that have no tangent direction of their own.
+static XMVECTOR PerpendicularTo(FXMVECTOR normal)
+{
+	XMVECTOR axis;
+
+
+	axis = fabsf(XMVectorGetX(normal)) < 0.9f ? XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f) : XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+	axis = XMVectorSubtract(axis, XMVectorMultiply(normal, XMVector3Dot(normal, axis)));
+
+	return XMVector3Normalize(axis);
+}
+
+
+MeshNormalClass::MeshNormalClass()
+{
+	m_creaseCosine = cosf(XM_PI / 3.0f);
+	m_creaseHalfCosine = cosf(XM_PI / 6.0f);
+	m_threadCount = 0;
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+
+
+MeshNormalClass::MeshNormalClass(const MeshNormalClass& other)
+{
+}
+
+
+MeshNormalClass::~MeshNormalClass()
+{
+}
+
+
+void MeshNormalClass::SetCreaseAngle(float radians)
+{
+	radians = fmaxf(0.0f, fminf(XM_PI, radians));
+	m_creaseCosine = cosf(radians);
+	m_creaseHalfCosine = cosf(radians * 0.5f);
+
+	return;
+}
+
+
+void MeshNormalClass::SetThreadCount(unsigned int threadCount)
+{
+	m_threadCount = threadCount;
+
+	return;
+}
+
+
+MeshNormalClass::GenerateStatsType MeshNormalClass::GetStats()
+{
+	return m_stats;
+}
+
+// GenerateNormals fills in every MESH_INDEX_NONE in normalIndices, appending the normals it makes to the normals array.
+// Corners that already have a normal keep it, their faces still count towards the smoothing of their neighbours.
+bool MeshNormalClass::GenerateNormals(const std::vector<XMFLOAT3>& positions, const std::vector<unsigned int>& positionIndices,
+	OUT std::vector<XMFLOAT3>& normals, OUT std::vector<unsigned int>& normalIndices)
+{
+	std::vector<XMFLOAT3> faceNormals;
+	std::vector<float> cornerAngles;
+	std::vector<unsigned int> offsets, corners, generated, blockOffsets;
+	std::vector<std::vector<XMFLOAT3>> blockNormals;
+	size_t cornerCount, triangleCount, missingCount, blockCount, base, i;
+
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	cornerCount = positionIndices.size();
+	if (normalIndices.size() != cornerCount || cornerCount % 3 != 0)
+	{
+		return false;
+	}
+
+	missingCount = 0;
+	for (i = 0; i < cornerCount; i++)
+	{
+		if (positionIndices[i] >= positions.size())
+		{
+			return false;
+		}
+		missingCount += normalIndices[i] == MESH_INDEX_NONE ? 1 : 0;
+	}
+
+	m_stats.normalCornerCount = (unsigned int)missingCount;
+	m_stats.normalCount = 0;
+	m_stats.threadCount = m_threadCount ? m_threadCount : std::thread::hardware_concurrency();
+	if (m_stats.threadCount == 0)
+	{
+		m_stats.threadCount = 1;
+	}
+
+	if (missingCount == 0)
+	{
+		m_stats.normalSeconds = 0.0;
+		return true;
+	}
+
+	// The unit normal of every face and its angle at each corner.
+	triangleCount = cornerCount / 3;
+	faceNormals.resize(triangleCount);
+	cornerAngles.resize(cornerCount);
+	RunWorkers((triangleCount + NORMAL_BLOCK_TRIANGLES - 1) / NORMAL_BLOCK_TRIANGLES, [&](size_t block)
+	{
+		XMVECTOR p0, p1, p2, angles;
+		size_t triangle, last;
+
+
+		last = (block + 1) * NORMAL_BLOCK_TRIANGLES < triangleCount ? (block + 1) * NORMAL_BLOCK_TRIANGLES : triangleCount;
+		for (triangle = block * NORMAL_BLOCK_TRIANGLES; triangle < last; triangle++)
+		{
+			p0 = XMLoadFloat3(&positions[positionIndices[triangle * 3]]);
+			p1 = XMLoadFloat3(&positions[positionIndices[triangle * 3 + 1]]);
+			p2 = XMLoadFloat3(&positions[positionIndices[triangle * 3 + 2]]);
+
+			XMStoreFloat3(&faceNormals[triangle], XMVector3Normalize(XMVector3Cross(XMVectorSubtract(p1, p0), XMVectorSubtract(p2, p0))));
+			angles = CornerAngles(p0, p1, p2);
+			cornerAngles[triangle * 3] = XMVectorGetX(angles);
+			cornerAngles[triangle * 3 + 1] = XMVectorGetY(angles);
+			cornerAngles[triangle * 3 + 2] = XMVectorGetZ(angles);
+		}
+	});
+
+	BuildAdjacency(positionIndices.data(), cornerCount, positions.size(), offsets, corners);
+
+	// Every block of positions collects its own new normals, numbered from zero, so the workers never share an output array.
+	blockCount = (positions.size() + NORMAL_BLOCK_VERTICES - 1) / NORMAL_BLOCK_VERTICES;
+	blockNormals.resize(blockCount);
+	generated.assign(cornerCount, MESH_INDEX_NONE);
+	RunWorkers(blockCount, [&](size_t block)
+	{
+		std::vector<XMFLOAT3>& out_normals = blockNormals[block];
+		XMVECTOR faceNormal, otherNormal, sum, smoothSum, smoothNormal;
+		XMFLOAT3 normal;
+		size_t position, last, first, j, k, corner, other;
+		bool smooth;
+
+
+		last = (block + 1) * NORMAL_BLOCK_VERTICES < positions.size() ? (block + 1) * NORMAL_BLOCK_VERTICES : positions.size();
+		for (position = block * NORMAL_BLOCK_VERTICES; position < last; position++)
+		{
+			// Most positions lie on a smooth surface. When every face is within half the crease angle of their average, any two are
+			// within the crease angle of each other, so every corner takes in every face and the sum is the same for all of them.
+			smoothSum = XMVectorZero();
+			for (k = offsets[position]; k < offsets[position + 1]; k++)
+			{
+				other = corners[k];
+				smoothSum = XMVectorAdd(smoothSum, XMVectorScale(XMLoadFloat3(&faceNormals[other / 3]), cornerAngles[other]));
+			}
+
+			smoothNormal = XMVector3Normalize(smoothSum);
+			smooth = XMVectorGetX(XMVector3LengthSq(smoothSum)) > 0.0f;
+			for (k = offsets[position]; k < offsets[position + 1] && smooth; k++)
+			{
+				smooth = XMVectorGetX(XMVector3Dot(smoothNormal, XMLoadFloat3(&faceNormals[corners[k] / 3]))) >= m_creaseHalfCosine;
+			}
+
+			first = out_normals.size();
+			for (j = offsets[position]; j < offsets[position + 1]; j++)
+			{
+				corner = corners[j];
+				if (normalIndices[corner] != MESH_INDEX_NONE)
+				{
+					continue;
+				}
+
+				faceNormal = XMLoadFloat3(&faceNormals[corner / 3]);
+				sum = smoothSum;
+				if (!smooth)
+				{
+					sum = XMVectorZero();
+					for (k = offsets[position]; k < offsets[position + 1]; k++)
+					{
+						other = corners[k];
+						otherNormal = XMLoadFloat3(&faceNormals[other / 3]);
+						if (XMVectorGetX(XMVector3Dot(faceNormal, otherNormal)) >= m_creaseCosine)
+						{
+							sum = XMVectorAdd(sum, XMVectorScale(otherNormal, cornerAngles[other]));
+						}
+					}
+				}
+
+				if (XMVectorGetX(XMVector3LengthSq(sum)) > 0.0f)
+				{
+					faceNormal = XMVector3Normalize(sum);
+				}
+				XMStoreFloat3(&normal, faceNormal);
+
+				// Corners whose sums took in the same faces come out bit identical, those share one normal.
+				for (k = first; k < out_normals.size(); k++)
+				{
+					if (memcmp(&out_normals[k], &normal, sizeof(normal)) == 0)
+					{
+						break;
+					}
+				}
+				if (k == out_normals.size())
+				{
+					out_normals.push_back(normal);
+				}
+				generated[corner] = (unsigned int)k;
+			}
+		}
+	});
+
+	// Append the blocks one after the other and move the corners' block numbers to the final ones.
+	base = normals.size();
+	blockOffsets.resize(blockCount);
+	for (i = 0; i < blockCount; i++)
+	{
+		blockOffsets[i] = (unsigned int)(normals.size() - base);
+		normals.insert(normals.end(), blockNormals[i].begin(), blockNormals[i].end());
+		std::vector<XMFLOAT3>().swap(blockNormals[i]);
+	}
+
+	if (normals.size() >= MESH_INDEX_NONE)
+	{
+		return false;
+	}
+
+	RunWorkers((cornerCount + NORMAL_BLOCK_TRIANGLES - 1) / NORMAL_BLOCK_TRIANGLES, [&](size_t block)
+	{
+		size_t corner, last;
+
+
+		last = (block + 1) * NORMAL_BLOCK_TRIANGLES < cornerCount ? (block + 1) * NORMAL_BLOCK_TRIANGLES : cornerCount;
+		for (corner = block * NORMAL_BLOCK_TRIANGLES; corner < last; corner++)
+		{
+			if (generated[corner] != MESH_INDEX_NONE)
+			{
+				normalIndices[corner] = (unsigned int)base + blockOffsets[positionIndices[corner] / NORMAL_BLOCK_VERTICES] + generated[corner];
+			}
+		}
+	});
+
+	m_stats.normalCount = (unsigned int)(normals.size() - base);
+	m_stats.normalSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	return true;
+}
+
+// GenerateTangents computes a tangent for every vertex of a welded mesh, out_tangents comes back parallel to verts.
+// A vertex used by faces of both handedness is given to the side with more faces, the other side gets a copy appended to verts
+// and its corners in indices are moved to it. Call it before optimizing so those copies are ordered with the rest.
+bool MeshNormalClass::GenerateTangents(OUT std::vector<VertexType>& verts, OUT std::vector<uint32_t>& indices, OUT std::vector<XMFLOAT4>& out_tangents)
+{
+	std::vector<unsigned int> cornerVertices, offsets, corners, splits;
+	std::vector<XMFLOAT3> faceTangents, faceBitangents;
+	std::vector<float> cornerAngles;
+	std::vector<signed char> cornerSigns;
+	std::vector<XMFLOAT4> splitTangents;
+	std::atomic<unsigned int> degenerateCount(0);
+	size_t cornerCount, triangleCount, vertexCount, i, j;
+	unsigned int copy;
+
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	cornerCount = indices.size();
+	vertexCount = verts.size();
+	if (cornerCount % 3 != 0)
+	{
+		return false;
+	}
+
+	cornerVertices.resize(cornerCount);
+	for (i = 0; i < cornerCount; i++)
+	{
+		if (indices[i] >= vertexCount)
+		{
+			return false;
+		}
+		cornerVertices[i] = (unsigned int)indices[i];
+	}
+
+	m_stats.threadCount = m_threadCount ? m_threadCount : std::thread::hardware_concurrency();
+	if (m_stats.threadCount == 0)
+	{
+		m_stats.threadCount = 1;
+	}
+
+	// The directions of increasing u and v across every face, from its edges and their texture coordinate deltas.
+	triangleCount = cornerCount / 3;
+	faceTangents.resize(triangleCount);
+	faceBitangents.resize(triangleCount);
+	cornerAngles.resize(cornerCount);
+	RunWorkers((triangleCount + NORMAL_BLOCK_TRIANGLES - 1) / NORMAL_BLOCK_TRIANGLES, [&](size_t block)
+	{
+		XMVECTOR p0, p1, p2, e1, e2, angles;
+		float du1, dv1, du2, dv2, area;
+		size_t triangle, last;
+
+
+		last = (block + 1) * NORMAL_BLOCK_TRIANGLES < triangleCount ? (block + 1) * NORMAL_BLOCK_TRIANGLES : triangleCount;
+		for (triangle = block * NORMAL_BLOCK_TRIANGLES; triangle < last; triangle++)
+		{
+			const VertexType& v0 = verts[cornerVertices[triangle * 3]];
+			const VertexType& v1 = verts[cornerVertices[triangle * 3 + 1]];
+			const VertexType& v2 = verts[cornerVertices[triangle * 3 + 2]];
+
+			p0 = XMLoadFloat3(&v0.position);
+			p1 = XMLoadFloat3(&v1.position);
+			p2 = XMLoadFloat3(&v2.position);
+			e1 = XMVectorSubtract(p1, p0);
+			e2 = XMVectorSubtract(p2, p0);
+			du1 = v1.texture.x - v0.texture.x;
+			dv1 = v1.texture.y - v0.texture.y;
+			du2 = v2.texture.x - v0.texture.x;
+			dv2 = v2.texture.y - v0.texture.y;
+
+			area = du1 * dv2 - du2 * dv1;
+			if (fabsf(area) < NORMAL_MIN_UV_AREA)
+			{
+				faceTangents[triangle] = XMFLOAT3(0.0f, 0.0f, 0.0f);
+				faceBitangents[triangle] = XMFLOAT3(0.0f, 0.0f, 0.0f);
+			}
+			else
+			{
+				XMStoreFloat3(&faceTangents[triangle], XMVectorScale(XMVectorSubtract(XMVectorScale(e1, dv2), XMVectorScale(e2, dv1)), 1.0f / area));
+				XMStoreFloat3(&faceBitangents[triangle], XMVectorScale(XMVectorSubtract(XMVectorScale(e2, du1), XMVectorScale(e1, du2)), 1.0f / area));
+			}
+
+			angles = CornerAngles(p0, p1, p2);
+			cornerAngles[triangle * 3] = XMVectorGetX(angles);
+			cornerAngles[triangle * 3 + 1] = XMVectorGetY(angles);
+			cornerAngles[triangle * 3 + 2] = XMVectorGetZ(angles);
+		}
+	});
+
+	BuildAdjacency(cornerVertices.data(), cornerCount, vertexCount, offsets, corners);
+
+	// Sum the face tangents around every vertex, each projected into the plane of the vertex normal, separately for both handedness.
+	out_tangents.resize(vertexCount);
+	splitTangents.resize(vertexCount);
+	cornerSigns.assign(cornerCount, 0);
+	splits.assign(vertexCount, 0);
+	RunWorkers((vertexCount + NORMAL_BLOCK_VERTICES - 1) / NORMAL_BLOCK_VERTICES, [&](size_t block)
+	{
+		XMVECTOR normal, tangent, sums[2];
+		unsigned int counts[2];
+		size_t vertex, last, k, corner;
+		int side, major;
+
+
+		last = (block + 1) * NORMAL_BLOCK_VERTICES < vertexCount ? (block + 1) * NORMAL_BLOCK_VERTICES : vertexCount;
+		for (vertex = block * NORMAL_BLOCK_VERTICES; vertex < last; vertex++)
+		{
+			normal = XMVector3Normalize(XMLoadFloat3(&verts[vertex].normal));
+			sums[0] = sums[1] = XMVectorZero();
+			counts[0] = counts[1] = 0;
+
+			for (k = offsets[vertex]; k < offsets[vertex + 1]; k++)
+			{
+				corner = corners[k];
+				tangent = XMLoadFloat3(&faceTangents[corner / 3]);
+				tangent = XMVectorSubtract(tangent, XMVectorMultiply(normal, XMVector3Dot(normal, tangent)));
+				if (XMVectorGetX(XMVector3LengthSq(tangent)) <= 0.0f)
+				{
+					continue;
+				}
+				tangent = XMVector3Normalize(tangent);
+
+				// Side 0 has its bitangent along cross(normal, tangent), side 1 is mirrored.
+				side = XMVectorGetX(XMVector3Dot(XMVector3Cross(normal, tangent), XMLoadFloat3(&faceBitangents[corner / 3]))) < 0.0f ? 1 : 0;
+				sums[side] = XMVectorAdd(sums[side], XMVectorScale(tangent, cornerAngles[corner]));
+				counts[side]++;
+				cornerSigns[corner] = (signed char)(side ? -1 : 1);
+			}
+
+			major = counts[1] > counts[0] ? 1 : 0;
+			if (counts[major] == 0 || XMVectorGetX(XMVector3LengthSq(sums[major])) <= 0.0f)
+			{
+				tangent = PerpendicularTo(normal);
+				degenerateCount++;
+			}
+			else
+			{
+				tangent = XMVector3Normalize(sums[major]);
+			}
+			XMStoreFloat4(&out_tangents[vertex], XMVectorSetW(tangent, major ? -1.0f : 1.0f));
+
+			if (counts[1 - major] > 0)
+			{
+				tangent = XMVectorGetX(XMVector3LengthSq(sums[1 - major])) > 0.0f ? XMVector3Normalize(sums[1 - major]) : PerpendicularTo(normal);
+				XMStoreFloat4(&splitTangents[vertex], XMVectorSetW(tangent, major ? 1.0f : -1.0f));
+				splits[vertex] = 1;
+			}
+		}
+	});
+
+	// Give the minority side of every mixed vertex its own copy.
+	m_stats.splitVertexCount = 0;
+	for (i = 0; i < vertexCount; i++)
+	{
+		if (!splits[i])
+		{
+			continue;
+		}
+
+		copy = (unsigned int)verts.size();
+		verts.push_back(verts[i]);
+		out_tangents.push_back(splitTangents[i]);
+		for (j = offsets[i]; j < offsets[i + 1]; j++)
+		{
+			if (cornerSigns[corners[j]] != 0 && cornerSigns[corners[j]] != (signed char)out_tangents[i].w)
+			{
+				indices[corners[j]] = copy;
+			}
+		}
+		m_stats.splitVertexCount++;
+	}
+
+	m_stats.tangentCount = (unsigned int)out_tangents.size();
+	m_stats.degenerateTangentCount = degenerateCount;
+	m_stats.tangentSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	return true;
+}
+
+// BuildAdjacency lists the corners of every vertex: those of vertex v are corners[offsets[v]] up to corners[offsets[v + 1]],
+// in corner order so the sums above always add up in the same order.
+void MeshNormalClass::BuildAdjacency(const unsigned int* cornerVertices, size_t cornerCount, size_t vertexCount, OUT std::vector<unsigned int>& offsets,
+	OUT std::vector<unsigned int>& corners)
+{
+	std::vector<unsigned int> cursor;
+	size_t i;
+
+
+	offsets.assign(vertexCount + 1, 0);
+	for (i = 0; i < cornerCount; i++)
+	{
+		offsets[cornerVertices[i] + 1]++;
+	}
+
+	for (i = 0; i < vertexCount; i++)
+	{
+		offsets[i + 1] += offsets[i];
+	}
+
+	cursor.assign(offsets.begin(), offsets.end() - 1);
+	corners.resize(cornerCount);
+	for (i = 0; i < cornerCount; i++)
+	{
+		corners[cursor[cornerVertices[i]]++] = (unsigned int)i;
+	}
+
+	return;
+}
+
+// RunWorkers calls work for every item on m_stats.threadCount threads, the calling thread included, like the ObjParserClass does.
+void MeshNormalClass::RunWorkers(size_t itemCount, const std::function<void(size_t)>& work)
+{
+	std::vector<std::thread> workers;
+	std::atomic<size_t> nextItem(0);
+	unsigned int i;
+
+
+	auto worker = [&]()
+	{
+		size_t item;
+		while ((item = nextItem.fetch_add(1)) < itemCount)
+		{
+			work(item);
+		}
+	};
+
+	for (i = 1; i < m_stats.threadCount && i < itemCount; i++)
+	{
+		workers.emplace_back(worker);
+	}
+
+	worker();
+
+	for (i = 0; i < workers.size(); i++)
+	{
+		workers[i].join();
+	}
+
+	return;
+}
@@ -0,0 +1,69 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: meshnormalclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _MESHNORMALCLASS_H_
+#define _MESHNORMALCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <functional>
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "meshtypes.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: MeshNormalClass
+////////////////////////////////////////////////////////////////////////////////
+// The MeshNormalClass generates the shading frames a mesh does not come with.
+// GenerateNormals works on the per-corner indices of an OBJ file before welding and gives every corner without a normal the sum
+// of the face normals around its position, weighted by the angle each face has there. Faces bent further than the crease angle
+// from the corner's own face are left out of the sum, so hard edges stay hard. Corners of a position that end up with the same
+// normal share one, which lets the welder merge them.
+// GenerateTangents works on a welded mesh and follows the MikkTSpace conventions: the tangent is the angle weighted direction of
+// increasing u projected into the plane of the normal, and w holds the sign of the bitangent, cross(normal, tangent) * w. Vertices
+// shared by faces whose texture mapping is mirrored are split so each side gets its own frame.
+// Both passes first compute the per-triangle values and then gather them per vertex over an adjacency list, so every thread only
+// writes what it owns and the work splits over as many threads as there are.
+class MeshNormalClass
+{
+public:
+	struct GenerateStatsType
+	{
+		unsigned int normalCornerCount, normalCount;
+		unsigned int tangentCount, splitVertexCount, degenerateTangentCount;
+		unsigned int threadCount;
+		double normalSeconds, tangentSeconds;
+	};
+
+public:
+	MeshNormalClass();
+	MeshNormalClass(const MeshNormalClass&);
+	~MeshNormalClass();
+
+	// The crease angle is in radians, a thread count of zero uses every hardware thread and one keeps the work on the calling thread.
+	void SetCreaseAngle(float);
+	void SetThreadCount(unsigned int);
+
+	bool GenerateNormals(const std::vector<XMFLOAT3>& positions, const std::vector<unsigned int>& positionIndices, OUT std::vector<XMFLOAT3>& normals,
+		OUT std::vector<unsigned int>& normalIndices);
+	bool GenerateTangents(OUT std::vector<VertexType>& verts, OUT std::vector<uint32_t>& indices, OUT std::vector<XMFLOAT4>& out_tangents);
+
+	GenerateStatsType GetStats();
+
+private:
+	void BuildAdjacency(const unsigned int* cornerVertices, size_t cornerCount, size_t vertexCount, OUT std::vector<unsigned int>& offsets,
+		OUT std::vector<unsigned int>& corners);
+	void RunWorkers(size_t itemCount, const std::function<void(size_t)>& work);
+
+private:
+	float m_creaseCosine, m_creaseHalfCosine;
+	unsigned int m_threadCount;
+	GenerateStatsType m_stats;
+};
+
+#endif
@@ -0,0 +1,675 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: meshoptimizerclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "meshoptimizerclass.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+
+/////////////
+// GLOBALS //
+/////////////
+// The cache the Forsyth scores are tuned for. It is larger than real hardware FIFOs on purpose, which gives better orders in practice.
+static const int FORSYTH_CACHE_SIZE = 32;
+static const float FORSYTH_CACHE_DECAY_POWER = 1.5f;
+static const float FORSYTH_LAST_TRIANGLE_SCORE = 0.75f;
+static const float FORSYTH_VALENCE_BOOST_SCALE = 2.0f;
+static const float FORSYTH_VALENCE_BOOST_POWER = 0.5f;
+// The FIFO size used for the statistics and the overdraw cluster boundaries, close to what current GPUs reuse.
+static const unsigned int OPTIMIZER_FIFO_SIZE = 16;
+// The overdraw pass may make the cache order this much worse before it is rejected.
+static const float OPTIMIZER_OVERDRAW_THRESHOLD = 1.05f;
+static const unsigned int FETCH_CACHE_LINE = 64;
+static const unsigned int FETCH_CACHE_LINES = 128;
+// The square viewport AnalyzeOverdraw renders the mesh into from each side.
+static const int OVERDRAW_VIEWPORT = 256;
+
+
+// ForsythVertexScore rates how much emitting a triangle that uses this vertex would help. Vertices near the front of the cache
+// score high, and so do vertices with few triangles left so they get finished off instead of being left stranded.
+static float ForsythVertexScore(int cachePosition, unsigned int liveTriangles)
+{
+	float score;
+
+
+	if (liveTriangles == 0)
+	{
+		return -1.0f;
+	}
+
+	score = 0.0f;
+	if (cachePosition >= 0)
+	{
+		if (cachePosition < 3)
+		{
+			// The vertices of the triangle that was just emitted get a fixed score so the next triangle does not just mirror it.
+			score = FORSYTH_LAST_TRIANGLE_SCORE;
+		}
+		else
+		{
+			score = powf(1.0f - (float)(cachePosition - 3) / (float)(FORSYTH_CACHE_SIZE - 3), FORSYTH_CACHE_DECAY_POWER);
+		}
+	}
+
+	score += FORSYTH_VALENCE_BOOST_SCALE * powf((float)liveTriangles, -FORSYTH_VALENCE_BOOST_POWER);
+
+	return score;
+}
+
+
+MeshOptimizerClass::MeshOptimizerClass()
+{
+}
+
+
+MeshOptimizerClass::MeshOptimizerClass(const MeshOptimizerClass& other)
+{
+}
+
+
+MeshOptimizerClass::~MeshOptimizerClass()
+{
+}
+
+// Optimize runs the three passes in the order they depend on each other.
+void MeshOptimizerClass::Optimize(std::vector<VertexType>& verts, std::vector<uint32_t>& indices)
+{
+	OptimizeVertexCache(indices, (unsigned int)verts.size());
+	OptimizeOverdraw(indices, verts, OPTIMIZER_OVERDRAW_THRESHOLD);
+	OptimizeVertexFetch(verts, indices);
+
+	return;
+}
+
+// This Optimize runs the cache and overdraw passes on every submesh by itself, so no triangle leaves its material's run, and then
+// renumbers the vertices for the whole index buffer.
+void MeshOptimizerClass::Optimize(std::vector<VertexType>& verts, std::vector<uint32_t>& indices, const std::vector<MeshSubmeshType>& submeshes)
+{
+	std::vector<uint32_t> submeshIndices;
+	size_t i;
+
+
+	for (i = 0; i < submeshes.size(); i++)
+	{
+		submeshIndices.assign(indices.begin() + submeshes[i].startIndex, indices.begin() + submeshes[i].startIndex + submeshes[i].indexCount);
+		OptimizeVertexCache(submeshIndices, (unsigned int)verts.size());
+		OptimizeOverdraw(submeshIndices, verts, OPTIMIZER_OVERDRAW_THRESHOLD);
+		std::copy(submeshIndices.begin(), submeshIndices.end(), indices.begin() + submeshes[i].startIndex);
+	}
+
+	OptimizeVertexFetch(verts, indices);
+
+	return;
+}
+
+// GroupByMaterial moves the triangles of each material together, in material order and otherwise keeping their order, and returns
+// a submesh for every material that has triangles. It is a counting sort, one pass to size the runs and one to fill them.
+void MeshOptimizerClass::GroupByMaterial(std::vector<uint32_t>& indices, const std::vector<unsigned int>& triangleMaterials, unsigned int materialCount,
+	OUT std::vector<MeshSubmeshType>& out_submeshes)
+{
+	std::vector<uint32_t> output;
+	std::vector<unsigned int> offsets;
+	MeshSubmeshType submesh;
+	unsigned int material, start;
+	size_t triangle;
+
+
+	offsets.assign(materialCount + 1, 0);
+	for (triangle = 0; triangle < triangleMaterials.size(); triangle++)
+	{
+		offsets[triangleMaterials[triangle] + 1] += 3;
+	}
+
+	out_submeshes.clear();
+	for (material = 0; material < materialCount; material++)
+	{
+		if (offsets[material + 1] > 0)
+		{
+			submesh.material = material;
+			submesh.startIndex = offsets[material];
+			submesh.indexCount = offsets[material + 1];
+			out_submeshes.push_back(submesh);
+		}
+		offsets[material + 1] += offsets[material];
+	}
+
+	// Only a mesh with more than one material needs to move anything.
+	if (out_submeshes.size() < 2)
+	{
+		return;
+	}
+
+	output.resize(indices.size());
+	for (triangle = 0; triangle < triangleMaterials.size(); triangle++)
+	{
+		start = offsets[triangleMaterials[triangle]];
+		output[start] = indices[triangle * 3];
+		output[start + 1] = indices[triangle * 3 + 1];
+		output[start + 2] = indices[triangle * 3 + 2];
+		offsets[triangleMaterials[triangle]] += 3;
+	}
+	indices.swap(output);
+
+	return;
+}
+
+// OptimizeVertexCache is Tom Forsyth's linear-speed greedy reordering. It keeps a simulated LRU cache and always emits the
+// highest scoring triangle that touches a cached vertex, only falling back to a linear scan when the cached vertices are used up.
+void MeshOptimizerClass::OptimizeVertexCache(std::vector<uint32_t>& indices, unsigned int vertexCount)
+{
+	std::vector<unsigned int> liveTriangles, adjacencyOffsets, adjacency;
+	std::vector<int> cachePosition;
+	std::vector<float> vertexScores, triangleScores;
+	std::vector<char> emitted;
+	std::vector<uint32_t> output;
+	unsigned int cache[FORSYTH_CACHE_SIZE + 3], newCache[FORSYTH_CACHE_SIZE + 3];
+	unsigned int triangleCount, cacheCount, newCount, cursor, i, j, k, v, t;
+	int bestTriangle;
+	float bestScore;
+
+
+	triangleCount = (unsigned int)(indices.size() / 3);
+	if (triangleCount == 0)
+	{
+		return;
+	}
+
+	// Build the vertex to triangle adjacency as one flat array with per-vertex offsets.
+	liveTriangles.assign(vertexCount, 0);
+	for (i = 0; i < triangleCount * 3; i++)
+	{
+		liveTriangles[indices[i]]++;
+	}
+
+	adjacencyOffsets.resize(vertexCount + 1);
+	adjacencyOffsets[0] = 0;
+	for (v = 0; v < vertexCount; v++)
+	{
+		adjacencyOffsets[v + 1] = adjacencyOffsets[v] + liveTriangles[v];
+	}
+
+	adjacency.resize(triangleCount * 3);
+	std::vector<unsigned int> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+	for (i = 0; i < triangleCount * 3; i++)
+	{
+		adjacency[fill[indices[i]]++] = i / 3;
+	}
+
+	// Score every vertex and triangle as if the cache were empty.
+	cachePosition.assign(vertexCount, -1);
+	vertexScores.resize(vertexCount);
+	for (v = 0; v < vertexCount; v++)
+	{
+		vertexScores[v] = ForsythVertexScore(-1, liveTriangles[v]);
+	}
+
+	bestTriangle = 0;
+	bestScore = -1.0f;
+	triangleScores.resize(triangleCount);
+	for (t = 0; t < triangleCount; t++)
+	{
+		triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+		if (triangleScores[t] > bestScore)
+		{
+			bestScore = triangleScores[t];
+			bestTriangle = (int)t;
+		}
+	}
+
+	emitted.assign(triangleCount, 0);
+	output.reserve(indices.size());
+	cacheCount = 0;
+	cursor = 0;
+
+	for (i = 0; i < triangleCount; i++)
+	{
+		// Nothing in the cache has triangles left, so continue with the next triangle in the original order.
+		if (bestTriangle < 0)
+		{
+			while (emitted[cursor])
+			{
+				cursor++;
+			}
+			bestTriangle = (int)cursor;
+		}
+
+		t = (unsigned int)bestTriangle;
+		emitted[t] = 1;
+
+		// Emit the triangle and take it out of the adjacency of its vertices.
+		for (j = 0; j < 3; j++)
+		{
+			v = indices[t * 3 + j];
+			output.push_back(v);
+
+			unsigned int* begin = &adjacency[adjacencyOffsets[v]];
+			for (k = 0; k < liveTriangles[v]; k++)
+			{
+				if (begin[k] == t)
+				{
+					begin[k] = begin[liveTriangles[v] - 1];
+					break;
+				}
+			}
+			liveTriangles[v]--;
+		}
+
+		// The emitted triangle's vertices move to the front of the cache and everything else shifts back.
+		newCount = 0;
+		for (j = 0; j < 3; j++)
+		{
+			newCache[newCount++] = indices[t * 3 + j];
+		}
+
+		for (j = 0; j < cacheCount; j++)
+		{
+			v = cache[j];
+			if (v != indices[t * 3] && v != indices[t * 3 + 1] && v != indices[t * 3 + 2])
+			{
+				newCache[newCount++] = v;
+			}
+		}
+
+		// Rescore the vertices that moved, including the ones that just fell out of the cache.
+		for (j = 0; j < newCount; j++)
+		{
+			v = newCache[j];
+			cachePosition[v] = j < (unsigned int)FORSYTH_CACHE_SIZE ? (int)j : -1;
+			vertexScores[v] = ForsythVertexScore(cachePosition[v], liveTriangles[v]);
+		}
+
+		// Rescore the triangles around them and pick the best one as the next triangle.
+		bestTriangle = -1;
+		bestScore = -1.0f;
+		for (j = 0; j < newCount; j++)
+		{
+			v = newCache[j];
+			for (k = 0; k < liveTriangles[v]; k++)
+			{
+				unsigned int neighbor = adjacency[adjacencyOffsets[v] + k];
+				float score = vertexScores[indices[neighbor * 3]] + vertexScores[indices[neighbor * 3 + 1]] + vertexScores[indices[neighbor * 3 + 2]];
+				triangleScores[neighbor] = score;
+				if (score > bestScore)
+				{
+					bestScore = score;
+					bestTriangle = (int)neighbor;
+				}
+			}
+		}
+
+		cacheCount = std::min(newCount, (unsigned int)FORSYTH_CACHE_SIZE);
+		for (j = 0; j < cacheCount; j++)
+		{
+			cache[j] = newCache[j];
+		}
+	}
+
+	indices.swap(output);
+
+	return;
+}
+
+// OptimizeOverdraw cuts the cache-optimized triangle order into clusters wherever the simulated FIFO starts cold, so moving whole
+// clusters around costs almost no vertex reuse. The clusters are then sorted so the ones facing away from the mesh center,
+// which tend to occlude the rest, are drawn first. The new order is only kept if the cache efficiency stays within the threshold.
+void MeshOptimizerClass::OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<VertexType>& verts, float threshold)
+{
+	struct ClusterType
+	{
+		unsigned int start, count;
+		float sortKey;
+	};
+
+	std::vector<ClusterType> clusters;
+	std::vector<unsigned int> cacheTime;
+	std::vector<uint32_t> output;
+	ClusterType cluster;
+	XMVECTOR center, centroid, normal, areaNormal, p0, p1, p2;
+	VertexCacheStatsType before, after;
+	unsigned int triangleCount, time, misses, t, j, v;
+	float area, totalArea, clusterArea;
+
+
+	triangleCount = (unsigned int)(indices.size() / 3);
+	if (triangleCount < 2)
+	{
+		return;
+	}
+
+	// Find the cluster boundaries: triangles whose three vertices all miss the FIFO.
+	cacheTime.assign(verts.size(), 0);
+	time = OPTIMIZER_FIFO_SIZE + 1;
+	cluster.start = 0;
+	for (t = 0; t < triangleCount; t++)
+	{
+		misses = 0;
+		for (j = 0; j < 3; j++)
+		{
+			v = indices[t * 3 + j];
+			if (time - cacheTime[v] > OPTIMIZER_FIFO_SIZE)
+			{
+				cacheTime[v] = time++;
+				misses++;
+			}
+		}
+
+		if (misses == 3 && t > cluster.start)
+		{
+			cluster.count = t - cluster.start;
+			clusters.push_back(cluster);
+			cluster.start = t;
+		}
+	}
+	cluster.count = triangleCount - cluster.start;
+	clusters.push_back(cluster);
+
+	if (clusters.size() < 2)
+	{
+		return;
+	}
+
+	// The area weighted centroid of the whole mesh is the reference point for the sort.
+	center = XMVectorZero();
+	totalArea = 0.0f;
+	for (t = 0; t < triangleCount; t++)
+	{
+		p0 = XMLoadFloat3(&verts[indices[t * 3]].position);
+		p1 = XMLoadFloat3(&verts[indices[t * 3 + 1]].position);
+		p2 = XMLoadFloat3(&verts[indices[t * 3 + 2]].position);
+		area = XMVectorGetX(XMVector3Length(XMVector3Cross(XMVectorSubtract(p1, p0), XMVectorSubtract(p2, p0))));
+		center = XMVectorAdd(center, XMVectorScale(XMVectorAdd(XMVectorAdd(p0, p1), p2), area / 3.0f));
+		totalArea += area;
+	}
+	if (totalArea > 0.0f)
+	{
+		center = XMVectorScale(center, 1.0f / totalArea);
+	}
+
+	// Each cluster is keyed by how far its centroid lies along its own average normal, seen from the mesh center.
+	for (size_t c = 0; c < clusters.size(); c++)
+	{
+		centroid = XMVectorZero();
+		normal = XMVectorZero();
+		clusterArea = 0.0f;
+		for (t = clusters[c].start; t < clusters[c].start + clusters[c].count; t++)
+		{
+			p0 = XMLoadFloat3(&verts[indices[t * 3]].position);
+			p1 = XMLoadFloat3(&verts[indices[t * 3 + 1]].position);
+			p2 = XMLoadFloat3(&verts[indices[t * 3 + 2]].position);
+			areaNormal = XMVector3Cross(XMVectorSubtract(p1, p0), XMVectorSubtract(p2, p0));
+			area = XMVectorGetX(XMVector3Length(areaNormal));
+			centroid = XMVectorAdd(centroid, XMVectorScale(XMVectorAdd(XMVectorAdd(p0, p1), p2), area / 3.0f));
+			normal = XMVectorAdd(normal, areaNormal);
+			clusterArea += area;
+		}
+
+		if (clusterArea > 0.0f)
+		{
+			centroid = XMVectorScale(centroid, 1.0f / clusterArea);
+		}
+		clusters[c].sortKey = XMVectorGetX(XMVector3Dot(XMVectorSubtract(centroid, center), XMVector3Normalize(normal)));
+	}
+
+	std::stable_sort(clusters.begin(), clusters.end(), [](const ClusterType& a, const ClusterType& b)
+	{
+		return a.sortKey > b.sortKey;
+	});
+
+	output.reserve(indices.size());
+	for (size_t c = 0; c < clusters.size(); c++)
+	{
+		output.insert(output.end(), indices.begin() + clusters[c].start * 3, indices.begin() + (clusters[c].start + clusters[c].count) * 3);
+	}
+
+	before = AnalyzeVertexCache(indices, (unsigned int)verts.size(), OPTIMIZER_FIFO_SIZE);
+	after = AnalyzeVertexCache(output, (unsigned int)verts.size(), OPTIMIZER_FIFO_SIZE);
+	if (after.acmr <= before.acmr * threshold)
+	{
+		indices.swap(output);
+	}
+
+	return;
+}
+
+// OptimizeVertexFetch renumbers the vertices in the order the index buffer first touches them and rewrites the vertex array to match.
+// Vertices that are never referenced are dropped.
+void MeshOptimizerClass::OptimizeVertexFetch(std::vector<VertexType>& verts, std::vector<uint32_t>& indices)
+{
+	std::vector<unsigned int> remap;
+	std::vector<VertexType> output;
+	size_t i;
+	uint32_t v;
+
+
+	remap.assign(verts.size(), 0xffffffff);
+	output.reserve(verts.size());
+
+	for (i = 0; i < indices.size(); i++)
+	{
+		v = indices[i];
+		if (remap[v] == 0xffffffff)
+		{
+			remap[v] = (unsigned int)output.size();
+			output.push_back(verts[v]);
+		}
+		indices[i] = remap[v];
+	}
+
+	verts.swap(output);
+
+	return;
+}
+
+// AnalyzeVertexCache replays the index buffer through a FIFO cache of the given size, which is how GPUs reuse transformed vertices.
+// A FIFO entry can be tested with a timestamp: a vertex is still cached if fewer than cacheSize misses happened since it was inserted.
+MeshOptimizerClass::VertexCacheStatsType MeshOptimizerClass::AnalyzeVertexCache(const std::vector<uint32_t>& indices, unsigned int vertexCount, unsigned int cacheSize)
+{
+	VertexCacheStatsType stats;
+	std::vector<unsigned int> cacheTime;
+	unsigned int time;
+	size_t i;
+
+
+	cacheTime.assign(vertexCount, 0);
+	time = cacheSize + 1;
+	stats.vertexTransforms = 0;
+
+	for (i = 0; i < indices.size(); i++)
+	{
+		if (time - cacheTime[indices[i]] > cacheSize)
+		{
+			cacheTime[indices[i]] = time++;
+			stats.vertexTransforms++;
+		}
+	}
+
+	stats.acmr = indices.size() >= 3 ? (float)stats.vertexTransforms / (float)(indices.size() / 3) : 0.0f;
+	stats.atvr = vertexCount ? (float)stats.vertexTransforms / (float)vertexCount : 0.0f;
+
+	return stats;
+}
+
+// AnalyzeVertexFetch replays the vertex fetches through a small FIFO of 64 byte cache lines to measure how much memory traffic
+// the index order causes compared to reading every vertex exactly once.
+MeshOptimizerClass::VertexFetchStatsType MeshOptimizerClass::AnalyzeVertexFetch(const std::vector<uint32_t>& indices, unsigned int vertexCount, unsigned int vertexSize)
+{
+	VertexFetchStatsType stats;
+	std::vector<unsigned int> lineTime;
+	size_t i, firstLine, lastLine, line;
+	unsigned int time;
+
+
+	lineTime.assign(((size_t)vertexCount * vertexSize + FETCH_CACHE_LINE - 1) / FETCH_CACHE_LINE + 1, 0);
+	time = FETCH_CACHE_LINES + 1;
+	stats.bytesFetched = 0;
+
+	for (i = 0; i < indices.size(); i++)
+	{
+		firstLine = ((size_t)indices[i] * vertexSize) / FETCH_CACHE_LINE;
+		lastLine = ((size_t)indices[i] * vertexSize + vertexSize - 1) / FETCH_CACHE_LINE;
+		for (line = firstLine; line <= lastLine; line++)
+		{
+			if (time - lineTime[line] > FETCH_CACHE_LINES)
+			{
+				lineTime[line] = time++;
+				stats.bytesFetched += FETCH_CACHE_LINE;
+			}
+		}
+	}
+
+	stats.overfetch = vertexCount ? (float)stats.bytesFetched / (float)((size_t)vertexCount * vertexSize) : 0.0f;
+
+	return stats;
+}
+
+// OverdrawEdge is the edge function of a to b at p, positive when p is left of the edge.
+static float OverdrawEdge(const float* a, const float* b, float x, float y)
+{
+	return (b[0] - a[0]) * (y - a[1]) - (b[1] - a[1]) * (x - a[0]);
+}
+
+// OverdrawOwnsEdge applies the top-left rule to a pixel center exactly on an edge of a counter-clockwise triangle, so a pixel on
+// the edge two triangles share is only drawn by one of them.
+static bool OverdrawOwnsEdge(float weight, const float* a, const float* b)
+{
+	if (weight != 0.0f)
+	{
+		return weight > 0.0f;
+	}
+
+	return b[1] < a[1] || (b[1] == a[1] && b[0] < a[0]);
+}
+
+// AnalyzeOverdraw renders the mesh with a depth test into a small orthographic viewport from each of the six axis directions and
+// counts every pixel a front facing triangle writes against the pixels the mesh covers. Drawing back to front writes the same
+// pixel again for every layer, drawing front to back makes the later layers fail the depth test, which is what the overdraw pass
+// tries to arrange.
+MeshOptimizerClass::OverdrawStatsType MeshOptimizerClass::AnalyzeOverdraw(const std::vector<uint32_t>& indices, const std::vector<VertexType>& verts)
+{
+	// The forward and up vector of each view, right is up x forward as in a left handed view.
+	static const float views[6][2][3] =
+	{
+		{ { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f } }, { { -1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f } },
+		{ { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } }, { { 0.0f, -1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } },
+		{ { 0.0f, 0.0f, 1.0f }, { 0.0f, 1.0f, 0.0f } }, { { 0.0f, 0.0f, -1.0f }, { 0.0f, 1.0f, 0.0f } }
+	};
+	OverdrawStatsType stats;
+	std::vector<float> depthBuffer;
+	float minimum[3], maximum[3], center[3], right[3], corner[3][3], offset[3];
+	const float* forward;
+	const float* up;
+	float radius, scale, area, w0, w1, w2, depth, x, y;
+	int minX, maxX, minY, maxY, px, py, view, k;
+	size_t i, t, j;
+
+
+	stats.pixelsCovered = 0;
+	stats.pixelsShaded = 0;
+	stats.overdraw = 0.0f;
+	if (verts.empty() || indices.size() < 3)
+	{
+		return stats;
+	}
+
+	// Fit the bounding sphere of the mesh into the viewport, so every view sees all of it at the same scale.
+	for (k = 0; k < 3; k++)
+	{
+		minimum[k] = FLT_MAX;
+		maximum[k] = -FLT_MAX;
+	}
+	for (i = 0; i < verts.size(); i++)
+	{
+		const float* p = &verts[i].position.x;
+		for (k = 0; k < 3; k++)
+		{
+			minimum[k] = std::min(minimum[k], p[k]);
+			maximum[k] = std::max(maximum[k], p[k]);
+		}
+	}
+	for (k = 0; k < 3; k++)
+	{
+		center[k] = (minimum[k] + maximum[k]) * 0.5f;
+	}
+	radius = 0.0f;
+	for (i = 0; i < verts.size(); i++)
+	{
+		const float* p = &verts[i].position.x;
+		radius = std::max(radius, sqrtf((p[0] - center[0]) * (p[0] - center[0]) + (p[1] - center[1]) * (p[1] - center[1]) +
+			(p[2] - center[2]) * (p[2] - center[2])));
+	}
+	scale = radius > 0.0f ? (OVERDRAW_VIEWPORT * 0.5f - 1.0f) / radius : 1.0f;
+
+	for (view = 0; view < 6; view++)
+	{
+		forward = views[view][0];
+		up = views[view][1];
+		right[0] = up[1] * forward[2] - up[2] * forward[1];
+		right[1] = up[2] * forward[0] - up[0] * forward[2];
+		right[2] = up[0] * forward[1] - up[1] * forward[0];
+		depthBuffer.assign((size_t)OVERDRAW_VIEWPORT * OVERDRAW_VIEWPORT, FLT_MAX);
+
+		for (t = 0; t + 2 < indices.size(); t += 3)
+		{
+			for (j = 0; j < 3; j++)
+			{
+				const float* p = &verts[indices[t + j]].position.x;
+				for (k = 0; k < 3; k++)
+				{
+					offset[k] = p[k] - center[k];
+				}
+				corner[j][0] = (offset[0] * right[0] + offset[1] * right[1] + offset[2] * right[2]) * scale + OVERDRAW_VIEWPORT * 0.5f;
+				corner[j][1] = (offset[0] * up[0] + offset[1] * up[1] + offset[2] * up[2]) * scale + OVERDRAW_VIEWPORT * 0.5f;
+				corner[j][2] = offset[0] * forward[0] + offset[1] * forward[1] + offset[2] * forward[2];
+			}
+
+			// Front faces are clockwise on screen, the rest is culled like the rasterizer state does. The two last corners are
+			// swapped so the edge functions of the counter-clockwise order are positive inside.
+			area = OverdrawEdge(corner[0], corner[1], corner[2][0], corner[2][1]);
+			if (area >= 0.0f)
+			{
+				continue;
+			}
+			std::swap(corner[1], corner[2]);
+			area = -area;
+
+			minX = std::max(0, (int)floorf(std::min({ corner[0][0], corner[1][0], corner[2][0] })));
+			maxX = std::min(OVERDRAW_VIEWPORT - 1, (int)ceilf(std::max({ corner[0][0], corner[1][0], corner[2][0] })));
+			minY = std::max(0, (int)floorf(std::min({ corner[0][1], corner[1][1], corner[2][1] })));
+			maxY = std::min(OVERDRAW_VIEWPORT - 1, (int)ceilf(std::max({ corner[0][1], corner[1][1], corner[2][1] })));
+
+			for (py = minY; py <= maxY; py++)
+			{
+				for (px = minX; px <= maxX; px++)
+				{
+					x = px + 0.5f;
+					y = py + 0.5f;
+					w0 = OverdrawEdge(corner[1], corner[2], x, y);
+					w1 = OverdrawEdge(corner[2], corner[0], x, y);
+					w2 = OverdrawEdge(corner[0], corner[1], x, y);
+					if (!OverdrawOwnsEdge(w0, corner[1], corner[2]) || !OverdrawOwnsEdge(w1, corner[2], corner[0]) ||
+						!OverdrawOwnsEdge(w2, corner[0], corner[1]))
+					{
+						continue;
+					}
+
+					depth = (w0 * corner[0][2] + w1 * corner[1][2] + w2 * corner[2][2]) / area;
+					if (depth < depthBuffer[(size_t)py * OVERDRAW_VIEWPORT + px])
+					{
+						depthBuffer[(size_t)py * OVERDRAW_VIEWPORT + px] = depth;
+						stats.pixelsShaded++;
+					}
+				}
+			}
+		}
+
+		for (i = 0; i < depthBuffer.size(); i++)
+		{
+			stats.pixelsCovered += depthBuffer[i] != FLT_MAX;
+		}
+	}
+
+	stats.overdraw = stats.pixelsCovered ? (float)stats.pixelsShaded / (float)stats.pixelsCovered : 0.0f;
+
+	return stats;
+}
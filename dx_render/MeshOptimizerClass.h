@@ -0,0 +1,65 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: meshoptimizerclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _MESHOPTIMIZERCLASS_H_
+#define _MESHOPTIMIZERCLASS_H_
+
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "meshtypes.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: MeshOptimizerClass
+////////////////////////////////////////////////////////////////////////////////
+// The MeshOptimizerClass reorders an indexed mesh for the GPU before it is uploaded. It runs three passes in order:
+// the triangles are sorted for the post-transform vertex cache (Forsyth), the resulting cache-friendly runs are reordered
+// so outward facing clusters are drawn first to reduce overdraw, and the vertices are renumbered in first-use order so fetches walk
+// the vertex buffer front to back. The Analyze functions measure the effect of each pass.
+// A mesh with several materials is first grouped into one run of triangles per material, the cache and overdraw passes then stay
+// inside each run so every submesh remains a single draw.
+class MeshOptimizerClass
+{
+public:
+	struct VertexCacheStatsType
+	{
+		unsigned int vertexTransforms;
+		float acmr;	// Average cache miss ratio, transformed vertices per triangle. 0.5 is the best a regular grid can do, 3 is the worst.
+		float atvr;	// Average transform to vertex ratio, transformed vertices per unique vertex. 1 is optimal.
+	};
+
+	struct VertexFetchStatsType
+	{
+		size_t bytesFetched;
+		float overfetch;	// Bytes pulled through the fetch cache per byte of vertex data. 1 is optimal.
+	};
+
+	struct OverdrawStatsType
+	{
+		size_t pixelsCovered;
+		size_t pixelsShaded;
+		float overdraw;	// Pixels shaded per pixel covered, over six views along the axes. 1 is optimal.
+	};
+
+public:
+	MeshOptimizerClass();
+	MeshOptimizerClass(const MeshOptimizerClass&);
+	~MeshOptimizerClass();
+
+	void Optimize(std::vector<VertexType>& verts, std::vector<uint32_t>& indices);
+	void Optimize(std::vector<VertexType>& verts, std::vector<uint32_t>& indices, const std::vector<MeshSubmeshType>& submeshes);
+	void GroupByMaterial(std::vector<uint32_t>& indices, const std::vector<unsigned int>& triangleMaterials, unsigned int materialCount,
+		OUT std::vector<MeshSubmeshType>& out_submeshes);
+
+	void OptimizeVertexCache(std::vector<uint32_t>& indices, unsigned int vertexCount);
+	void OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<VertexType>& verts, float threshold);
+	void OptimizeVertexFetch(std::vector<VertexType>& verts, std::vector<uint32_t>& indices);
+
+	VertexCacheStatsType AnalyzeVertexCache(const std::vector<uint32_t>& indices, unsigned int vertexCount, unsigned int cacheSize);
+	VertexFetchStatsType AnalyzeVertexFetch(const std::vector<uint32_t>& indices, unsigned int vertexCount, unsigned int vertexSize);
+	OverdrawStatsType AnalyzeOverdraw(const std::vector<uint32_t>& indices, const std::vector<VertexType>& verts);
+};
+
+#endif
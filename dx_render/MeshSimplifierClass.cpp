@@ -0,0 +1,781 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: meshsimplifierclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "meshsimplifierclass.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+
+/////////////
+// GLOBALS //
+/////////////
+// How a vertex may move. Manifold vertices collapse anywhere, border and seam vertices only along their own edge loop,
+// locked vertices never move but others may collapse onto them.
+enum
+{
+	KIND_MANIFOLD,
+	KIND_BORDER,
+	KIND_SEAM,
+	KIND_LOCKED,
+	KIND_COUNT
+};
+
+static const bool CAN_COLLAPSE[KIND_COUNT][KIND_COUNT] =
+{
+	{ true, true, true, true },
+	{ false, true, false, true },
+	{ false, false, true, true },
+	{ false, false, false, false },
+};
+
+// Edges between these kinds show up in two triangles, one in each direction, so only one of the two is looked at.
+static const bool HAS_OPPOSITE[KIND_COUNT][KIND_COUNT] =
+{
+	{ true, true, true, true },
+	{ true, false, true, false },
+	{ true, true, true, true },
+	{ true, false, true, false },
+};
+
+// Border edges are kept in place much harder than seams, which only need to stay roughly where they are.
+static const float BORDER_EDGE_WEIGHT = 10.0f;
+static const float SEAM_EDGE_WEIGHT = 1.0f;
+static const unsigned int NO_VERTEX = ~0u;
+
+
+static XMVECTOR LoadPosition(const XMFLOAT3& position)
+{
+	return XMLoadFloat3(&position);
+}
+
+
+MeshSimplifierClass::MeshSimplifierClass()
+{
+	m_textureWeight = 0.01f;
+	m_normalWeight = 0.01f;
+	m_verts = 0;
+}
+
+
+MeshSimplifierClass::MeshSimplifierClass(const MeshSimplifierClass& other)
+{
+}
+
+
+MeshSimplifierClass::~MeshSimplifierClass()
+{
+}
+
+// SetAttributeWeights scales the penalty for collapsing vertices with different texture coordinates or normals. The penalty is added
+// to the squared geometric error, which is measured in units of the mesh size, so 0.01 makes a texture coordinate difference of 0.1
+// cost as much as moving the surface by 1% of the mesh.
+void MeshSimplifierClass::SetAttributeWeights(float textureWeight, float normalWeight)
+{
+	m_textureWeight = textureWeight;
+	m_normalWeight = normalWeight;
+
+	return;
+}
+
+// Simplify collapses edges until the index count reaches targetIndexCount or the next collapse would move the surface by more than
+// targetError, given as a fraction of the largest mesh extent. It returns the largest error it accepted in the same units.
+float MeshSimplifierClass::Simplify(const std::vector<VertexType>& verts, const std::vector<uint32_t>& indices, unsigned int targetIndexCount,
+	float targetError, OUT std::vector<uint32_t>& out_indices)
+{
+	return SimplifyMesh(verts, indices, targetIndexCount, targetError, out_indices, 0, 0);
+}
+
+// This Simplify also records the collapses in the order they were applied. out_triangleCollapses has one entry per input triangle,
+// the index of the collapse that removed it or MESH_INDEX_NONE for the triangles that are still in out_indices.
+float MeshSimplifierClass::Simplify(const std::vector<VertexType>& verts, const std::vector<uint32_t>& indices, unsigned int targetIndexCount,
+	float targetError, OUT std::vector<uint32_t>& out_indices, OUT std::vector<CollapseRecordType>& out_collapses,
+	OUT std::vector<unsigned int>& out_triangleCollapses)
+{
+	return SimplifyMesh(verts, indices, targetIndexCount, targetError, out_indices, &out_collapses, &out_triangleCollapses);
+}
+
+// SimplifyMesh does the work of both Simplify functions, the collapse lists are only filled in when they are given.
+// The collapses run in passes: every pass ranks all candidate edges, then applies the cheapest ones that do not touch each other.
+float MeshSimplifierClass::SimplifyMesh(const std::vector<VertexType>& verts, const std::vector<uint32_t>& indices, unsigned int targetIndexCount,
+	float targetError, OUT std::vector<uint32_t>& out_indices, OUT std::vector<CollapseRecordType>* out_collapses,
+	OUT std::vector<unsigned int>* out_triangleCollapses)
+{
+	AdjacencyType adjacency;
+	std::vector<CollapseType> collapses;
+	std::vector<unsigned int> order, collapseRemap;
+	std::vector<unsigned int> triangleIds, vertexCollapses;
+	std::vector<unsigned char> collapseLocked;
+	XMFLOAT3 boundsMin;
+	CollapseType collapse;
+	CollapseRecordType record;
+	unsigned int vertexCount, i0, i1, r0, r1, s0, s1, k0, k1, l, moved;
+	size_t i, e, write, triangleGoal, edgeGoal, triangleCollapses;
+	float scale, errorLimit, errorGoal, resultError, ei, ej, di, dj;
+	static const unsigned int next[3] = { 1, 2, 0 };
+
+
+	vertexCount = (unsigned int)verts.size();
+	out_indices.assign(indices.begin(), indices.begin() + indices.size() / 3 * 3);
+
+	// Follow every triangle through the passes so the one that removes it can be told apart, and every vertex to the record of its collapse.
+	if (out_collapses)
+	{
+		out_collapses->clear();
+		out_triangleCollapses->assign(out_indices.size() / 3, MESH_INDEX_NONE);
+		triangleIds.resize(out_indices.size() / 3);
+		for (i = 0; i < triangleIds.size(); i++)
+		{
+			triangleIds[i] = (unsigned int)i;
+		}
+		vertexCollapses.assign(vertexCount, MESH_INDEX_NONE);
+	}
+
+	if (vertexCount == 0 || out_indices.size() <= targetIndexCount)
+	{
+		return 0.0f;
+	}
+
+	// Scale the positions into the unit cube so every error below is relative to the mesh size.
+	m_verts = verts.data();
+	scale = GetScale(verts);
+	boundsMin = verts[0].position;
+	for (i = 0; i < vertexCount; i++)
+	{
+		boundsMin.x = std::min(boundsMin.x, verts[i].position.x);
+		boundsMin.y = std::min(boundsMin.y, verts[i].position.y);
+		boundsMin.z = std::min(boundsMin.z, verts[i].position.z);
+	}
+
+	m_positions.resize(vertexCount);
+	for (i = 0; i < vertexCount; i++)
+	{
+		m_positions[i] = XMFLOAT3((verts[i].position.x - boundsMin.x) / scale, (verts[i].position.y - boundsMin.y) / scale,
+			(verts[i].position.z - boundsMin.z) / scale);
+	}
+
+	// Vertices with the same position but different attributes are wedges of one position. Sorting by position groups them,
+	// remap points every wedge at the first of its group and wedge links the group into a ring.
+	order.resize(vertexCount);
+	for (i = 0; i < vertexCount; i++)
+	{
+		order[i] = (unsigned int)i;
+	}
+	std::sort(order.begin(), order.end(), [&verts](unsigned int a, unsigned int b)
+	{
+		int c = memcmp(&verts[a].position, &verts[b].position, sizeof(XMFLOAT3));
+		return c != 0 ? c < 0 : a < b;
+	});
+
+	m_remap.resize(vertexCount);
+	m_wedge.resize(vertexCount);
+	for (i = 0; i < vertexCount; )
+	{
+		for (e = i + 1; e < vertexCount && memcmp(&verts[order[i]].position, &verts[order[e]].position, sizeof(XMFLOAT3)) == 0; e++)
+		{
+		}
+
+		for (l = (unsigned int)i; l < e; l++)
+		{
+			m_remap[order[l]] = order[i];
+			m_wedge[order[l]] = order[l + 1 < e ? l + 1 : i];
+		}
+		i = e;
+	}
+
+	ClassifyVertices(out_indices);
+	FillQuadrics(out_indices);
+
+	collapseRemap.resize(vertexCount);
+	collapseLocked.resize(vertexCount);
+	errorLimit = targetError * targetError;
+	resultError = 0.0f;
+
+	while (out_indices.size() > targetIndexCount)
+	{
+		BuildAdjacency(out_indices, out_indices.size(), m_remap.data(), adjacency);
+
+		// Pick the edges that may collapse, in the direction they may collapse.
+		collapses.clear();
+		for (i = 0; i < out_indices.size(); i += 3)
+		{
+			for (e = 0; e < 3; e++)
+			{
+				i0 = (unsigned int)out_indices[i + e];
+				i1 = (unsigned int)out_indices[i + next[e]];
+				k0 = m_kind[i0];
+				k1 = m_kind[i1];
+
+				if (!CAN_COLLAPSE[k0][k1] && !CAN_COLLAPSE[k1][k0])
+				{
+					continue;
+				}
+
+				if (HAS_OPPOSITE[k0][k1] && m_remap[i1] > m_remap[i0])
+				{
+					continue;
+				}
+
+				// Border and seam vertices only move along the edge loop they are on.
+				if ((k0 == KIND_BORDER || k0 == KIND_SEAM) && k1 != KIND_MANIFOLD && m_loop[i0] != i1)
+				{
+					continue;
+				}
+				if ((k1 == KIND_BORDER || k1 == KIND_SEAM) && k0 != KIND_MANIFOLD && m_loopBack[i1] != i0)
+				{
+					continue;
+				}
+
+				collapse.bidirectional = CAN_COLLAPSE[k0][k1] && CAN_COLLAPSE[k1][k0];
+				collapse.v0 = CAN_COLLAPSE[k0][k1] ? i0 : i1;
+				collapse.v1 = CAN_COLLAPSE[k0][k1] ? i1 : i0;
+				collapses.push_back(collapse);
+			}
+		}
+
+		if (collapses.empty())
+		{
+			break;
+		}
+
+		// Rank every collapse by the quadric error of moving v0 onto v1, trying both directions where both are allowed.
+		for (i = 0; i < collapses.size(); i++)
+		{
+			CollapseType& c = collapses[i];
+
+			di = QuadricError(m_quadrics[m_remap[c.v0]], m_positions[c.v1]);
+			ei = di + AttributeError(c.v0, c.v1);
+			dj = c.bidirectional ? QuadricError(m_quadrics[m_remap[c.v1]], m_positions[c.v0]) : FLT_MAX;
+			ej = c.bidirectional ? dj + AttributeError(c.v1, c.v0) : FLT_MAX;
+
+			if (ej < ei)
+			{
+				std::swap(c.v0, c.v1);
+			}
+			c.error = std::min(ei, ej);
+			c.distance = ej < ei ? dj : di;
+		}
+
+		order.resize(collapses.size());
+		for (i = 0; i < collapses.size(); i++)
+		{
+			order[i] = (unsigned int)i;
+		}
+		std::sort(order.begin(), order.end(), [&collapses](unsigned int a, unsigned int b)
+		{
+			return collapses[a].error < collapses[b].error;
+		});
+
+		for (i = 0; i < vertexCount; i++)
+		{
+			collapseRemap[i] = (unsigned int)i;
+		}
+		std::fill(collapseLocked.begin(), collapseLocked.end(), 0);
+
+		// Most collapses remove two triangles. The error goal stops the pass once the cheap collapses are used up, since collapses
+		// next to an applied one are skipped and only ranked again in the next pass.
+		triangleGoal = (out_indices.size() - targetIndexCount) / 3;
+		edgeGoal = triangleGoal / 2;
+		triangleCollapses = 0;
+		s0 = NO_VERTEX;
+		s1 = NO_VERTEX;
+
+		for (i = 0; i < collapses.size(); i++)
+		{
+			const CollapseType& c = collapses[order[i]];
+
+			if (c.distance > errorLimit || triangleCollapses >= triangleGoal)
+			{
+				break;
+			}
+
+			errorGoal = edgeGoal < collapses.size() ? 1.5f * collapses[order[edgeGoal]].error : FLT_MAX;
+			if (c.error > errorGoal && triangleCollapses > triangleGoal / 6)
+			{
+				break;
+			}
+
+			i0 = c.v0;
+			i1 = c.v1;
+			r0 = m_remap[i0];
+			r1 = m_remap[i1];
+
+			if (collapseLocked[r0] || collapseLocked[r1])
+			{
+				continue;
+			}
+
+			if (HasTriangleFlips(adjacency, collapseRemap.data(), r0, r1))
+			{
+				edgeGoal++;
+				continue;
+			}
+
+			// A seam moves both of its wedges, the second one along the matching edge on the other side of the seam.
+			if (m_kind[i0] == KIND_SEAM)
+			{
+				s0 = m_wedge[i0];
+				s1 = m_loop[i0] == i1 ? m_loopBack[s0] : m_loop[s0];
+				if (s1 == NO_VERTEX || m_remap[s1] != r1)
+				{
+					continue;
+				}
+
+				collapseRemap[i0] = i1;
+				collapseRemap[s0] = s1;
+			}
+			else
+			{
+				collapseRemap[i0] = i1;
+			}
+
+			if (out_collapses)
+			{
+				record.error = sqrtf(c.distance);
+				record.vertex = i0;
+				record.target = i1;
+				vertexCollapses[i0] = (unsigned int)out_collapses->size();
+				out_collapses->push_back(record);
+				if (m_kind[i0] == KIND_SEAM)
+				{
+					record.vertex = s0;
+					record.target = s1;
+					vertexCollapses[s0] = (unsigned int)out_collapses->size();
+					out_collapses->push_back(record);
+				}
+			}
+
+			QuadricAdd(m_quadrics[r1], m_quadrics[r0]);
+			collapseLocked[r0] = 1;
+			collapseLocked[r1] = 1;
+			triangleCollapses += m_kind[i0] == KIND_BORDER ? 1 : 2;
+			resultError = std::max(resultError, c.distance);
+		}
+
+		if (triangleCollapses == 0)
+		{
+			break;
+		}
+
+		// Keep the border and seam loops pointing at vertices that still exist.
+		for (i = 0; i < vertexCount; i++)
+		{
+			if (m_loop[i] != NO_VERTEX)
+			{
+				l = m_loop[i];
+				m_loop[i] = collapseRemap[l] == i ? m_loop[l] : collapseRemap[l];
+			}
+			if (m_loopBack[i] != NO_VERTEX)
+			{
+				l = m_loopBack[i];
+				m_loopBack[i] = collapseRemap[l] == i ? m_loopBack[l] : collapseRemap[l];
+			}
+		}
+
+		// Apply the collapses and drop the triangles that lost their area.
+		write = 0;
+		for (i = 0; i < out_indices.size(); i += 3)
+		{
+			i0 = collapseRemap[out_indices[i]];
+			i1 = collapseRemap[out_indices[i + 1]];
+			l = collapseRemap[out_indices[i + 2]];
+			if (m_remap[i0] != m_remap[i1] && m_remap[i0] != m_remap[l] && m_remap[i1] != m_remap[l])
+			{
+				if (out_collapses)
+				{
+					triangleIds[write / 3] = triangleIds[i / 3];
+				}
+				out_indices[write] = i0;
+				out_indices[write + 1] = i1;
+				out_indices[write + 2] = l;
+				write += 3;
+			}
+			else if (out_collapses)
+			{
+				// Two corners now share a position. Exactly one of them moved in this pass, since the collapses of a pass do not
+				// touch each other, and its collapse is the one that removed the triangle.
+				if (m_remap[i0] == m_remap[i1])
+				{
+					moved = collapseRemap[out_indices[i]] != out_indices[i] ? (unsigned int)out_indices[i] : (unsigned int)out_indices[i + 1];
+				}
+				else if (m_remap[i0] == m_remap[l])
+				{
+					moved = collapseRemap[out_indices[i]] != out_indices[i] ? (unsigned int)out_indices[i] : (unsigned int)out_indices[i + 2];
+				}
+				else
+				{
+					moved = collapseRemap[out_indices[i + 1]] != out_indices[i + 1] ? (unsigned int)out_indices[i + 1] : (unsigned int)out_indices[i + 2];
+				}
+				(*out_triangleCollapses)[triangleIds[i / 3]] = vertexCollapses[moved];
+			}
+		}
+		out_indices.resize(write);
+		if (out_collapses)
+		{
+			triangleIds.resize(write / 3);
+		}
+	}
+
+	return sqrtf(resultError);
+}
+
+// GetScale returns the largest extent of the mesh bounds, the unit Simplify measures its errors in.
+float MeshSimplifierClass::GetScale(const std::vector<VertexType>& verts)
+{
+	XMVECTOR boundsMin, boundsMax, position;
+	XMFLOAT3 extent;
+	size_t i;
+
+
+	if (verts.empty())
+	{
+		return 1.0f;
+	}
+
+	boundsMin = boundsMax = XMLoadFloat3(&verts[0].position);
+	for (i = 1; i < verts.size(); i++)
+	{
+		position = XMLoadFloat3(&verts[i].position);
+		boundsMin = XMVectorMin(boundsMin, position);
+		boundsMax = XMVectorMax(boundsMax, position);
+	}
+
+	XMStoreFloat3(&extent, XMVectorSubtract(boundsMax, boundsMin));
+
+	return std::max(std::max(extent.x, extent.y), std::max(extent.z, FLT_MIN));
+}
+
+
+void MeshSimplifierClass::QuadricFromPlane(double a, double b, double c, double d, double weight, OUT QuadricType& q)
+{
+	q.a00 = weight * a * a;
+	q.a11 = weight * b * b;
+	q.a22 = weight * c * c;
+	q.a10 = weight * b * a;
+	q.a20 = weight * c * a;
+	q.a21 = weight * c * b;
+	q.b0 = weight * a * d;
+	q.b1 = weight * b * d;
+	q.b2 = weight * c * d;
+	q.c = weight * d * d;
+	q.w = weight;
+
+	return;
+}
+
+
+void MeshSimplifierClass::QuadricAdd(QuadricType& q, const QuadricType& other)
+{
+	q.a00 += other.a00;
+	q.a11 += other.a11;
+	q.a22 += other.a22;
+	q.a10 += other.a10;
+	q.a20 += other.a20;
+	q.a21 += other.a21;
+	q.b0 += other.b0;
+	q.b1 += other.b1;
+	q.b2 += other.b2;
+	q.c += other.c;
+	q.w += other.w;
+
+	return;
+}
+
+// QuadricError is the weighted mean squared distance of the position to the planes summed into the quadric.
+float MeshSimplifierClass::QuadricError(const QuadricType& q, const XMFLOAT3& position)
+{
+	double x, y, z, r;
+
+
+	if (q.w <= 0.0)
+	{
+		return 0.0f;
+	}
+
+	x = position.x;
+	y = position.y;
+	z = position.z;
+	r = q.a00 * x * x + q.a11 * y * y + q.a22 * z * z + 2.0 * (q.a10 * x * y + q.a20 * x * z + q.a21 * y * z) +
+		2.0 * (q.b0 * x + q.b1 * y + q.b2 * z) + q.c;
+
+	return (float)(fabs(r) / q.w);
+}
+
+// BuildAdjacency lists the triangle edges leaving every vertex. With a remap table the edges are between positions,
+// otherwise between the vertices themselves.
+void MeshSimplifierClass::BuildAdjacency(const std::vector<uint32_t>& indices, size_t indexCount, const unsigned int* remap, OUT AdjacencyType& adjacency)
+{
+	std::vector<unsigned int> fill;
+	unsigned int v[3];
+	size_t i, vertexCount;
+	int k;
+
+
+	vertexCount = m_positions.size();
+	adjacency.offsets.assign(vertexCount + 1, 0);
+	for (i = 0; i < indexCount; i++)
+	{
+		adjacency.offsets[(remap ? remap[indices[i]] : indices[i]) + 1]++;
+	}
+	for (i = 0; i < vertexCount; i++)
+	{
+		adjacency.offsets[i + 1] += adjacency.offsets[i];
+	}
+
+	adjacency.edges.resize(indexCount);
+	fill.assign(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+	for (i = 0; i < indexCount; i += 3)
+	{
+		for (k = 0; k < 3; k++)
+		{
+			v[k] = remap ? remap[indices[i + k]] : (unsigned int)indices[i + k];
+		}
+
+		for (k = 0; k < 3; k++)
+		{
+			EdgeType& edge = adjacency.edges[fill[v[k]]++];
+			edge.next = v[(k + 1) % 3];
+			edge.prev = v[(k + 2) % 3];
+		}
+	}
+
+	return;
+}
+
+
+bool MeshSimplifierClass::HasEdge(const AdjacencyType& adjacency, unsigned int a, unsigned int b)
+{
+	unsigned int i;
+
+
+	for (i = adjacency.offsets[a]; i < adjacency.offsets[a + 1]; i++)
+	{
+		if (adjacency.edges[i].next == b)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// ClassifyVertices finds the open edges, half edges without a twin, and sorts the vertices into kinds from them.
+// A vertex with one wedge and no open edges is manifold, with exactly one open edge in and out it is on a border.
+// A position with two wedges whose open edges meet the same neighbours on both sides is on a UV seam. Everything else is locked.
+void MeshSimplifierClass::ClassifyVertices(const std::vector<uint32_t>& indices)
+{
+	AdjacencyType adjacency;
+	unsigned int vertexCount, v, target, w, openIn, openOut, openInW, openOutW;
+	unsigned int i;
+
+
+	vertexCount = (unsigned int)m_positions.size();
+	BuildAdjacency(indices, indices.size(), 0, adjacency);
+
+	m_loop.assign(vertexCount, NO_VERTEX);
+	m_loopBack.assign(vertexCount, NO_VERTEX);
+	for (v = 0; v < vertexCount; v++)
+	{
+		for (i = adjacency.offsets[v]; i < adjacency.offsets[v + 1]; i++)
+		{
+			target = adjacency.edges[i].next;
+			if (!HasEdge(adjacency, target, v))
+			{
+				// A second open edge marks the vertex by pointing it at itself.
+				m_loopBack[target] = m_loopBack[target] == NO_VERTEX ? v : target;
+				m_loop[v] = m_loop[v] == NO_VERTEX ? target : v;
+			}
+		}
+	}
+
+	m_kind.assign(vertexCount, KIND_LOCKED);
+	for (v = 0; v < vertexCount; v++)
+	{
+		if (m_remap[v] != v)
+		{
+			continue;
+		}
+
+		openIn = m_loopBack[v];
+		openOut = m_loop[v];
+		w = m_wedge[v];
+
+		if (w == v)
+		{
+			if (openIn == NO_VERTEX && openOut == NO_VERTEX)
+			{
+				m_kind[v] = KIND_MANIFOLD;
+			}
+			else if (openIn != NO_VERTEX && openOut != NO_VERTEX && openIn != v && openOut != v)
+			{
+				m_kind[v] = KIND_BORDER;
+			}
+		}
+		else if (m_wedge[w] == v)
+		{
+			openInW = m_loopBack[w];
+			openOutW = m_loop[w];
+			if (openIn != NO_VERTEX && openIn != v && openOut != NO_VERTEX && openOut != v &&
+				openInW != NO_VERTEX && openInW != w && openOutW != NO_VERTEX && openOutW != w &&
+				m_remap[openIn] == m_remap[openOutW] && m_remap[openOut] == m_remap[openInW])
+			{
+				m_kind[v] = KIND_SEAM;
+			}
+		}
+	}
+
+	for (v = 0; v < vertexCount; v++)
+	{
+		m_kind[v] = m_kind[m_remap[v]];
+	}
+
+	return;
+}
+
+// FillQuadrics sums the plane of every triangle into its corners, weighted by the square root of its area,
+// and adds a plane through every border and seam edge that stands upright on the triangle so those edges resist moving sideways.
+void MeshSimplifierClass::FillQuadrics(const std::vector<uint32_t>& indices)
+{
+	QuadricType quadric;
+	XMVECTOR p0, p1, p2, normal, edge;
+	float area, length, projection;
+	unsigned int i0, i1, i2, k0, k1;
+	size_t i;
+	int e;
+	static const unsigned int next[3] = { 1, 2, 0 };
+
+
+	memset(&quadric, 0, sizeof(quadric));
+	m_quadrics.assign(m_positions.size(), quadric);
+
+	for (i = 0; i < indices.size(); i += 3)
+	{
+		p0 = LoadPosition(m_positions[indices[i]]);
+		p1 = LoadPosition(m_positions[indices[i + 1]]);
+		p2 = LoadPosition(m_positions[indices[i + 2]]);
+
+		normal = XMVector3Cross(XMVectorSubtract(p1, p0), XMVectorSubtract(p2, p0));
+		area = XMVectorGetX(XMVector3Length(normal));
+		if (area <= 0.0f)
+		{
+			continue;
+		}
+
+		normal = XMVectorScale(normal, 1.0f / area);
+		QuadricFromPlane(XMVectorGetX(normal), XMVectorGetY(normal), XMVectorGetZ(normal), -XMVectorGetX(XMVector3Dot(normal, p0)), sqrtf(area), quadric);
+		for (e = 0; e < 3; e++)
+		{
+			QuadricAdd(m_quadrics[m_remap[indices[i + e]]], quadric);
+		}
+	}
+
+	for (i = 0; i < indices.size(); i += 3)
+	{
+		for (e = 0; e < 3; e++)
+		{
+			i0 = (unsigned int)indices[i + e];
+			i1 = (unsigned int)indices[i + next[e]];
+			i2 = (unsigned int)indices[i + next[next[e]]];
+			k0 = m_kind[i0];
+			k1 = m_kind[i1];
+
+			if (k0 != KIND_BORDER && k0 != KIND_SEAM && k1 != KIND_BORDER && k1 != KIND_SEAM)
+			{
+				continue;
+			}
+			if ((k0 == KIND_BORDER || k0 == KIND_SEAM) && m_loop[i0] != i1)
+			{
+				continue;
+			}
+			if ((k1 == KIND_BORDER || k1 == KIND_SEAM) && m_loopBack[i1] != i0)
+			{
+				continue;
+			}
+			if (HAS_OPPOSITE[k0][k1] && m_remap[i1] > m_remap[i0])
+			{
+				continue;
+			}
+
+			p0 = LoadPosition(m_positions[i0]);
+			p1 = LoadPosition(m_positions[i1]);
+			p2 = LoadPosition(m_positions[i2]);
+
+			// The plane contains the edge and is perpendicular to the triangle, its normal is the triangle's altitude onto the edge.
+			edge = XMVectorSubtract(p1, p0);
+			length = XMVectorGetX(XMVector3Length(edge));
+			if (length <= 0.0f)
+			{
+				continue;
+			}
+			edge = XMVectorScale(edge, 1.0f / length);
+			projection = XMVectorGetX(XMVector3Dot(XMVectorSubtract(p2, p0), edge));
+			normal = XMVectorSubtract(XMVectorSubtract(p2, p0), XMVectorScale(edge, projection));
+			if (XMVectorGetX(XMVector3LengthSq(normal)) <= 0.0f)
+			{
+				continue;
+			}
+			normal = XMVector3Normalize(normal);
+
+			QuadricFromPlane(XMVectorGetX(normal), XMVectorGetY(normal), XMVectorGetZ(normal), -XMVectorGetX(XMVector3Dot(normal, p0)),
+				length * (k0 == KIND_BORDER || k1 == KIND_BORDER ? BORDER_EDGE_WEIGHT : SEAM_EDGE_WEIGHT), quadric);
+			QuadricAdd(m_quadrics[m_remap[i0]], quadric);
+			QuadricAdd(m_quadrics[m_remap[i1]], quadric);
+		}
+	}
+
+	return;
+}
+
+// HasTriangleFlips checks whether moving position r0 onto r1 would turn any of the remaining triangles around r0 over.
+bool MeshSimplifierClass::HasTriangleFlips(const AdjacencyType& adjacency, const unsigned int* collapseRemap, unsigned int r0, unsigned int r1)
+{
+	XMVECTOR a, b, v0, v1, edge, before, after;
+	unsigned int i, ia, ib;
+
+
+	v0 = LoadPosition(m_positions[r0]);
+	v1 = LoadPosition(m_positions[r1]);
+
+	for (i = adjacency.offsets[r0]; i < adjacency.offsets[r0 + 1]; i++)
+	{
+		ia = collapseRemap[adjacency.edges[i].next];
+		ib = collapseRemap[adjacency.edges[i].prev];
+
+		// Triangles on the collapsed edge disappear, and so did ones an earlier collapse of this pass made degenerate.
+		if (m_remap[ia] == r1 || m_remap[ib] == r1 || m_remap[ia] == m_remap[ib])
+		{
+			continue;
+		}
+
+		a = LoadPosition(m_positions[ia]);
+		b = LoadPosition(m_positions[ib]);
+		edge = XMVectorSubtract(b, a);
+		before = XMVector3Cross(edge, XMVectorSubtract(v0, a));
+		after = XMVector3Cross(edge, XMVectorSubtract(v1, a));
+		// Turning a triangle by more than about 75 degrees counts as a flip too, that also catches triangles collapsing into slivers.
+		if (XMVectorGetX(XMVector3Dot(before, after)) <= 0.25f * XMVectorGetX(XMVector3Length(before)) * XMVectorGetX(XMVector3Length(after)))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// AttributeError is the penalty for the attributes of i0 being replaced by those of i1.
+float MeshSimplifierClass::AttributeError(unsigned int i0, unsigned int i1)
+{
+	const VertexType& a = m_verts[i0];
+	const VertexType& b = m_verts[i1];
+	float du, dv, dx, dy, dz;
+
+
+	du = a.texture.x - b.texture.x;
+	dv = a.texture.y - b.texture.y;
+	dx = a.normal.x - b.normal.x;
+	dy = a.normal.y - b.normal.y;
+	dz = a.normal.z - b.normal.z;
+
+	return m_textureWeight * (du * du + dv * dv) + m_normalWeight * (dx * dx + dy * dy + dz * dz);
+}
@@ -0,0 +1,100 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: meshsimplifierclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _MESHSIMPLIFIERCLASS_H_
+#define _MESHSIMPLIFIERCLASS_H_
+
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "meshtypes.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: MeshSimplifierClass
+////////////////////////////////////////////////////////////////////////////////
+// The MeshSimplifierClass reduces the triangle count of an indexed mesh with quadric error edge collapses (Garland and Heckbert).
+// Vertices are only ever collapsed onto other existing vertices, so a simplified index buffer still refers to the original vertex
+// buffer and every level of detail can share it. Open borders only collapse along themselves and carry heavily weighted edge
+// quadrics, UV seams collapse both sides together, and vertices where neither works are locked. Texture coordinate and normal
+// differences add a weighted penalty to each collapse so detail in the attributes is removed last.
+// The second Simplify also hands back every collapse it applied, in order, and for every input triangle the collapse that removed it.
+// Undoing them from the last one back is a sequence of vertex splits that rebuilds the input mesh, see ProgressiveMeshClass.
+class MeshSimplifierClass
+{
+public:
+	// A collapse moved vertex onto target, which was still in the mesh at the time. The error is the distance the surface moved,
+	// relative to the largest mesh extent like the error Simplify returns.
+	struct CollapseRecordType
+	{
+		unsigned int vertex, target;
+		float error;
+	};
+
+private:
+	struct QuadricType
+	{
+		double a00, a11, a22, a10, a20, a21;
+		double b0, b1, b2, c;
+		double w;
+	};
+
+	struct EdgeType
+	{
+		unsigned int next, prev;
+	};
+
+	// The error ranks the collapses and includes the attribute penalty, the distance is the geometric part alone.
+	struct CollapseType
+	{
+		unsigned int v0, v1;
+		bool bidirectional;
+		float error, distance;
+	};
+
+	struct AdjacencyType
+	{
+		std::vector<unsigned int> offsets;
+		std::vector<EdgeType> edges;
+	};
+
+public:
+	MeshSimplifierClass();
+	MeshSimplifierClass(const MeshSimplifierClass&);
+	~MeshSimplifierClass();
+
+	void SetAttributeWeights(float textureWeight, float normalWeight);
+	float Simplify(const std::vector<VertexType>& verts, const std::vector<uint32_t>& indices, unsigned int targetIndexCount, float targetError,
+		OUT std::vector<uint32_t>& out_indices);
+	float Simplify(const std::vector<VertexType>& verts, const std::vector<uint32_t>& indices, unsigned int targetIndexCount, float targetError,
+		OUT std::vector<uint32_t>& out_indices, OUT std::vector<CollapseRecordType>& out_collapses, OUT std::vector<unsigned int>& out_triangleCollapses);
+	float GetScale(const std::vector<VertexType>& verts);
+
+private:
+	float SimplifyMesh(const std::vector<VertexType>& verts, const std::vector<uint32_t>& indices, unsigned int targetIndexCount, float targetError,
+		OUT std::vector<uint32_t>& out_indices, OUT std::vector<CollapseRecordType>* out_collapses, OUT std::vector<unsigned int>* out_triangleCollapses);
+	static void QuadricFromPlane(double a, double b, double c, double d, double weight, OUT QuadricType&);
+	static void QuadricAdd(QuadricType& q, const QuadricType& other);
+	static float QuadricError(const QuadricType&, const XMFLOAT3& position);
+
+	void BuildAdjacency(const std::vector<uint32_t>& indices, size_t indexCount, const unsigned int* remap, OUT AdjacencyType&);
+	bool HasEdge(const AdjacencyType&, unsigned int a, unsigned int b);
+	void ClassifyVertices(const std::vector<uint32_t>& indices);
+	void FillQuadrics(const std::vector<uint32_t>& indices);
+	bool HasTriangleFlips(const AdjacencyType&, const unsigned int* collapseRemap, unsigned int r0, unsigned int r1);
+	float AttributeError(unsigned int i0, unsigned int i1);
+
+private:
+	float m_textureWeight, m_normalWeight;
+
+	// Per vertex state of the current Simplify call. Positions are scaled into the unit cube so errors are relative to the mesh size.
+	const VertexType* m_verts;
+	std::vector<XMFLOAT3> m_positions;
+	std::vector<unsigned int> m_remap, m_wedge;
+	std::vector<unsigned int> m_loop, m_loopBack;
+	std::vector<unsigned char> m_kind;
+	std::vector<QuadricType> m_quadrics;
+};
+
+#endif
@@ -0,0 +1,79 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: meshtypes.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _MESHTYPES_H_
+#define _MESHTYPES_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <DirectXMath.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace DirectX;
+
+// The mesh processing classes (welding, parsing, optimizing) do not touch Direct3D so they can be built and run without a window or a GPU.
+// They all share the vertex type below, which is the same layout the ModelClass uploads into its vertex buffer.
+
+///////////////////////////////
+// PRE-PROCESSING DIRECTIVES //
+///////////////////////////////
+#ifndef OUT
+#define OUT
+#endif
+
+
+/////////////
+// GLOBALS //
+/////////////
+// The index a face corner has for an attribute it does not specify, such as the texture coordinate of a v//vn corner.
+const unsigned int MESH_INDEX_NONE = 0xffffffff;
+
+
+//////////////
+// TYPEDEFS //
+//////////////
+struct VertexType
+{
+	XMFLOAT3 position;
+	XMFLOAT2 texture;
+	XMFLOAT3 normal;
+};
+
+// An IndexRangeType is one DrawIndexed call worth of a mesh: the indices to draw, the value added to each of them and the material
+// to draw them with.
+struct IndexRangeType
+{
+	unsigned int startIndex, indexCount;
+	int baseVertex;
+	unsigned int material;
+};
+
+// A MeshSubmeshType is the run of a level of detail's triangles that use one material, an index into the mesh's material names.
+struct MeshSubmeshType
+{
+	unsigned int material;
+	unsigned int startIndex, indexCount;
+};
+
+// A MeshLodType is one level of detail: its triangles in the shared index buffer, the submeshes they are grouped into and the largest
+// distance, in model units, by which its surface may deviate from the full mesh. The submeshes lie back to back inside the triangles.
+struct MeshLodType
+{
+	unsigned int startIndex, indexCount;
+	float error;
+	unsigned int firstSubmesh, submeshCount;
+};
+
+// The materials of a mesh as the OBJ file names them: the .mtl files it loads and the names its submeshes refer to by index.
+// Triangles that come before any usemtl get a material with an empty name.
+struct MeshMaterialListType
+{
+	std::vector<std::string> libraries;
+	std::vector<std::string> names;
+};
+
+#endif
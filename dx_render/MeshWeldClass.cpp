@@ -0,0 +1,333 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: meshweldclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "meshweldclass.h"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+
+
+/////////////
+// GLOBALS //
+/////////////
+static const unsigned int WELD_EMPTY_SLOT = 0xffffffff;
+// The most corners a weld takes. The table has twice as many slots, which still fit the 32 bit hash, and every vertex index is
+// below WELD_EMPTY_SLOT.
+static const size_t WELD_MAX_CORNERS = (size_t)1 << 31;
+
+
+// HashTriplet mixes the three OBJ indices of a face corner into a single value for the weld table.
+static unsigned int HashTriplet(unsigned int v, unsigned int vt, unsigned int vn)
+{
+	unsigned int h;
+
+
+	h = v * 0x9e3779b1u;
+	h ^= vt * 0x85ebca77u + (h << 6) + (h >> 2);
+	h ^= vn * 0xc2b2ae3du + (h << 6) + (h >> 2);
+	h ^= h >> 16;
+	h *= 0x7feb352du;
+	h ^= h >> 15;
+
+	return h;
+}
+
+
+MeshWeldClass::MeshWeldClass()
+{
+	m_tolerance = 0.0f;
+	m_removeDegenerates = true;
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+
+
+MeshWeldClass::MeshWeldClass(const MeshWeldClass& other)
+{
+}
+
+
+MeshWeldClass::~MeshWeldClass()
+{
+}
+
+
+void MeshWeldClass::SetTolerance(float tolerance)
+{
+	m_tolerance = tolerance > 0.0f ? tolerance : 0.0f;
+
+	return;
+}
+
+
+void MeshWeldClass::SetRemoveDegenerates(bool remove)
+{
+	m_removeDegenerates = remove;
+
+	return;
+}
+
+
+MeshWeldClass::WeldStats MeshWeldClass::GetStats()
+{
+	return m_stats;
+}
+
+// Weld takes the attribute arrays and the zero based per-corner index triplets and builds the indexed mesh.
+// The weld table uses open addressing sized to twice the corner count so a lookup almost never probes more than a slot or two.
+// The triangles keep their order. When triangleMaterials is given it holds the material of every input triangle and is shortened
+// along with the triangles that are dropped, so it still lines up with out_indices.
+bool MeshWeldClass::Weld(const std::vector<XMFLOAT3>& positions, const std::vector<XMFLOAT2>& uvs, const std::vector<XMFLOAT3>& normals,
+	const std::vector<unsigned int>& positionIndices, const std::vector<unsigned int>& uvIndices, const std::vector<unsigned int>& normalIndices,
+	OUT std::vector<VertexType>& out_verts, OUT std::vector<uint32_t>& out_indices, OUT std::vector<unsigned int>* triangleMaterials)
+{
+	std::vector<unsigned int> table, keys;
+	size_t tableSize, mask, slot;
+	unsigned int cornerCount, i, vertexIndex;
+	unsigned int v, vt, vn;
+	VertexType vertex;
+
+
+	// More corners than that can not be indexed, and would overflow the size of the table.
+	if (positionIndices.size() > WELD_MAX_CORNERS)
+	{
+		return false;
+	}
+
+	cornerCount = (unsigned int)positionIndices.size();
+	if (uvIndices.size() != cornerCount || normalIndices.size() != cornerCount || cornerCount % 3 != 0 ||
+		(triangleMaterials && triangleMaterials->size() != cornerCount / 3))
+	{
+		return false;
+	}
+
+	memset(&m_stats, 0, sizeof(m_stats));
+	m_stats.inputVertexCount = cornerCount;
+	m_stats.inputIndexCount = cornerCount;
+	m_stats.inputBytes = (size_t)cornerCount * (sizeof(VertexType) + sizeof(uint32_t));
+
+	// Size the table to the next power of two above twice the corner count.
+	tableSize = 16;
+	while (tableSize < (size_t)cornerCount * 2)
+	{
+		tableSize <<= 1;
+	}
+	mask = tableSize - 1;
+
+	table.assign(tableSize, WELD_EMPTY_SLOT);
+	keys.reserve(cornerCount);
+	out_verts.clear();
+	out_verts.reserve(cornerCount / 2);
+	out_indices.resize(cornerCount);
+
+	for (i = 0; i < cornerCount; i++)
+	{
+		v = positionIndices[i];
+		vt = uvIndices[i];
+		vn = normalIndices[i];
+
+		// Reject files that reference attributes they never declared instead of reading past the arrays.
+		// Corners without a texture coordinate or normal are fine, they get zeros.
+		if (v >= positions.size() || (vt != MESH_INDEX_NONE && vt >= uvs.size()) || (vn != MESH_INDEX_NONE && vn >= normals.size()))
+		{
+			return false;
+		}
+
+		slot = HashTriplet(v, vt, vn) & mask;
+		vertexIndex = WELD_EMPTY_SLOT;
+		while (table[slot] != WELD_EMPTY_SLOT)
+		{
+			unsigned int candidate = table[slot];
+			if (keys[(size_t)candidate * 3] == v && keys[(size_t)candidate * 3 + 1] == vt && keys[(size_t)candidate * 3 + 2] == vn)
+			{
+				vertexIndex = candidate;
+				break;
+			}
+			slot = (slot + 1) & mask;
+		}
+
+		// First time we see this triplet, so it becomes a new vertex.
+		if (vertexIndex == WELD_EMPTY_SLOT)
+		{
+			vertexIndex = (unsigned int)out_verts.size();
+			table[slot] = vertexIndex;
+			keys.push_back(v);
+			keys.push_back(vt);
+			keys.push_back(vn);
+
+			vertex.position = positions[v];
+			vertex.texture = vt != MESH_INDEX_NONE ? uvs[vt] : XMFLOAT2(0.0f, 0.0f);
+			vertex.normal = vn != MESH_INDEX_NONE ? normals[vn] : XMFLOAT3(0.0f, 0.0f, 0.0f);
+			out_verts.push_back(vertex);
+		}
+
+		out_indices[i] = vertexIndex;
+	}
+
+	if (m_tolerance > 0.0f)
+	{
+		MergeNearbyVertices(out_verts, out_indices);
+	}
+
+	if (m_removeDegenerates)
+	{
+		RemoveDegenerateTriangles(out_verts, out_indices, triangleMaterials);
+	}
+
+	CompactVertices(out_verts, out_indices);
+
+	m_stats.outputVertexCount = (unsigned int)out_verts.size();
+	m_stats.outputIndexCount = (unsigned int)out_indices.size();
+	m_stats.outputBytes = out_verts.size() * sizeof(VertexType) + out_indices.size() * sizeof(uint32_t);
+
+	return true;
+}
+
+// MergeNearbyVertices snaps every attribute onto a grid the size of the tolerance and merges vertices that land in the same cell
+// and are within the tolerance on every component. Vertices straddling a cell boundary are left alone, which only costs a little compression.
+void MeshWeldClass::MergeNearbyVertices(std::vector<VertexType>& verts, std::vector<uint32_t>& indices)
+{
+	std::unordered_map<uint64_t, unsigned int> cellHeads;
+	std::vector<unsigned int> remap, nextInCell;
+	const float* a;
+	const float* b;
+	float invTolerance;
+	unsigned int i, j, k, candidate;
+	uint64_t key;
+	bool close;
+
+
+	invTolerance = 1.0f / m_tolerance;
+	remap.resize(verts.size());
+	nextInCell.assign(verts.size(), WELD_EMPTY_SLOT);
+	cellHeads.reserve(verts.size());
+
+	for (i = 0; i < verts.size(); i++)
+	{
+		// The vertex is eight tightly packed floats so it can be walked as an array.
+		a = &verts[i].position.x;
+
+		key = 1469598103934665603ull;
+		for (k = 0; k < 8; k++)
+		{
+			key ^= (uint64_t)(int64_t)floorf(a[k] * invTolerance);
+			key *= 1099511628211ull;
+		}
+
+		remap[i] = i;
+		auto head = cellHeads.find(key);
+		if (head == cellHeads.end())
+		{
+			cellHeads.emplace(key, i);
+			continue;
+		}
+
+		// Walk the representatives already in this cell looking for one close enough.
+		for (candidate = head->second; candidate != WELD_EMPTY_SLOT; candidate = nextInCell[candidate])
+		{
+			b = &verts[candidate].position.x;
+			close = true;
+			for (j = 0; j < 8 && close; j++)
+			{
+				close = fabsf(a[j] - b[j]) <= m_tolerance;
+			}
+
+			if (close)
+			{
+				remap[i] = candidate;
+				break;
+			}
+		}
+
+		if (remap[i] == i)
+		{
+			nextInCell[i] = head->second;
+			head->second = i;
+		}
+		else
+		{
+			m_stats.mergedVertexCount++;
+		}
+	}
+
+	for (i = 0; i < indices.size(); i++)
+	{
+		indices[i] = remap[indices[i]];
+	}
+
+	return;
+}
+
+// RemoveDegenerateTriangles drops triangles that reference the same vertex twice or whose corners share a position, since they cover no pixels.
+void MeshWeldClass::RemoveDegenerateTriangles(const std::vector<VertexType>& verts, std::vector<uint32_t>& indices, std::vector<unsigned int>* triangleMaterials)
+{
+	size_t read, write;
+	uint32_t i0, i1, i2;
+
+
+	write = 0;
+	for (read = 0; read + 2 < indices.size(); read += 3)
+	{
+		i0 = indices[read];
+		i1 = indices[read + 1];
+		i2 = indices[read + 2];
+
+		if (i0 == i1 || i1 == i2 || i0 == i2 ||
+			memcmp(&verts[i0].position, &verts[i1].position, sizeof(XMFLOAT3)) == 0 ||
+			memcmp(&verts[i1].position, &verts[i2].position, sizeof(XMFLOAT3)) == 0 ||
+			memcmp(&verts[i0].position, &verts[i2].position, sizeof(XMFLOAT3)) == 0)
+		{
+			m_stats.degenerateTriangleCount++;
+			continue;
+		}
+
+		indices[write] = i0;
+		indices[write + 1] = i1;
+		indices[write + 2] = i2;
+		if (triangleMaterials)
+		{
+			(*triangleMaterials)[write / 3] = (*triangleMaterials)[read / 3];
+		}
+		write += 3;
+	}
+	indices.resize(write);
+	if (triangleMaterials)
+	{
+		triangleMaterials->resize(write / 3);
+	}
+
+	return;
+}
+
+// CompactVertices removes vertices that are no longer referenced after merging and degenerate removal, keeping the original order.
+void MeshWeldClass::CompactVertices(std::vector<VertexType>& verts, std::vector<uint32_t>& indices)
+{
+	std::vector<unsigned int> remap;
+	unsigned int i, count;
+
+
+	remap.assign(verts.size(), WELD_EMPTY_SLOT);
+	for (i = 0; i < indices.size(); i++)
+	{
+		remap[indices[i]] = 0;
+	}
+
+	count = 0;
+	for (i = 0; i < verts.size(); i++)
+	{
+		if (remap[i] != WELD_EMPTY_SLOT)
+		{
+			remap[i] = count;
+			verts[count] = verts[i];
+			count++;
+		}
+	}
+	verts.resize(count);
+
+	for (i = 0; i < indices.size(); i++)
+	{
+		indices[i] = remap[indices[i]];
+	}
+
+	return;
+}
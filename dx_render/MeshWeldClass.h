@@ -0,0 +1,57 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: meshweldclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _MESHWELDCLASS_H_
+#define _MESHWELDCLASS_H_
+
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "meshtypes.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: MeshWeldClass
+////////////////////////////////////////////////////////////////////////////////
+// The MeshWeldClass turns the per-corner (v, vt, vn) index triplets of an OBJ file into a compact indexed mesh.
+// Every unique triplet becomes one vertex, so corners shared between faces are stored once and referenced through the index buffer.
+// Optionally vertices whose attributes all lie within a tolerance of each other are merged as well, and triangles that collapse are dropped.
+class MeshWeldClass
+{
+public:
+	struct WeldStats
+	{
+		unsigned int inputVertexCount, inputIndexCount;
+		unsigned int outputVertexCount, outputIndexCount;
+		unsigned int mergedVertexCount, degenerateTriangleCount;
+		size_t inputBytes, outputBytes;
+	};
+
+public:
+	MeshWeldClass();
+	MeshWeldClass(const MeshWeldClass&);
+	~MeshWeldClass();
+
+	// A tolerance of zero only welds identical triplets, anything above that also merges near-identical attributes.
+	void SetTolerance(float);
+	void SetRemoveDegenerates(bool);
+
+	bool Weld(const std::vector<XMFLOAT3>& positions, const std::vector<XMFLOAT2>& uvs, const std::vector<XMFLOAT3>& normals,
+		const std::vector<unsigned int>& positionIndices, const std::vector<unsigned int>& uvIndices, const std::vector<unsigned int>& normalIndices,
+		OUT std::vector<VertexType>& out_verts, OUT std::vector<uint32_t>& out_indices, OUT std::vector<unsigned int>* triangleMaterials);
+
+	WeldStats GetStats();
+
+private:
+	void MergeNearbyVertices(std::vector<VertexType>& verts, std::vector<uint32_t>& indices);
+	void RemoveDegenerateTriangles(const std::vector<VertexType>& verts, std::vector<uint32_t>& indices, std::vector<unsigned int>* triangleMaterials);
+	void CompactVertices(std::vector<VertexType>& verts, std::vector<uint32_t>& indices);
+
+private:
+	float m_tolerance;
+	bool m_removeDegenerates;
+	WeldStats m_stats;
+};
+
+#endif
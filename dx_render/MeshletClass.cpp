@@ -0,0 +1,319 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: meshletclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "meshletclass.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+
+MeshletClass::MeshletClass()
+{
+	m_maxVertices = 64;
+	m_maxTriangles = 124;
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+
+
+MeshletClass::MeshletClass(const MeshletClass& other)
+{
+}
+
+
+MeshletClass::~MeshletClass()
+{
+}
+
+// SetLimits sets the most vertices and triangles a cluster may have. The defaults are the 64 and 124 mesh shader hardware prefers,
+// which also keeps clusters small enough to cull well.
+void MeshletClass::SetLimits(unsigned int maxVertices, unsigned int maxTriangles)
+{
+	m_maxVertices = std::max(maxVertices, 3u);
+	m_maxTriangles = std::max(maxTriangles, 1u);
+
+	return;
+}
+
+// Build walks the triangles of the range in order and closes the current cluster as soon as the next triangle would take it past
+// either limit. The clusters are appended to out_meshlets, so several ranges of one index buffer can share the list.
+// The indices are relative to range.baseVertex, like the ones DrawIndexed reads.
+void MeshletClass::Build(const VertexType* verts, const uint32_t* indices, const IndexRangeType& range, OUT std::vector<MeshletType>& out_meshlets)
+{
+	MeshletType meshlet;
+	unsigned int i, k, end, vertexCount, triangleCount, newVertices, stamp;
+	uint32_t v;
+
+
+	// The stamps mark which vertices the current cluster already uses, a new cluster just takes the next stamp value.
+	end = range.startIndex + range.indexCount / 3 * 3;
+	vertexCount = 0;
+	for (i = range.startIndex; i < end; i++)
+	{
+		vertexCount = std::max(vertexCount, (unsigned int)indices[i] + 1);
+	}
+	m_vertexStamp.assign(vertexCount, 0);
+
+	memset(&meshlet, 0, sizeof(meshlet));
+	meshlet.range.startIndex = range.startIndex;
+	meshlet.range.baseVertex = range.baseVertex;
+	meshlet.range.material = range.material;
+	vertexCount = 0;
+	triangleCount = 0;
+	stamp = 1;
+
+	for (i = range.startIndex; i < end; i += 3)
+	{
+		newVertices = 0;
+		for (k = 0; k < 3; k++)
+		{
+			newVertices += m_vertexStamp[indices[i + k]] != stamp ? 1 : 0;
+		}
+
+		if (triangleCount > 0 && (vertexCount + newVertices > m_maxVertices || triangleCount + 1 > m_maxTriangles))
+		{
+			ComputeBounds(verts + range.baseVertex, indices, meshlet);
+			out_meshlets.push_back(meshlet);
+
+			meshlet.range.startIndex = i;
+			meshlet.range.indexCount = 0;
+			vertexCount = 0;
+			triangleCount = 0;
+			stamp++;
+		}
+
+		for (k = 0; k < 3; k++)
+		{
+			v = indices[i + k];
+			if (m_vertexStamp[v] != stamp)
+			{
+				m_vertexStamp[v] = stamp;
+				vertexCount++;
+			}
+		}
+
+		meshlet.range.indexCount += 3;
+		triangleCount++;
+	}
+
+	if (triangleCount > 0)
+	{
+		ComputeBounds(verts + range.baseVertex, indices, meshlet);
+		out_meshlets.push_back(meshlet);
+	}
+
+	return;
+}
+
+// Cull tests every cluster against the view frustum and its normal cone and returns the index ranges left to draw, each with the
+// view space depth of the nearest point of the bounding spheres of its clusters.
+// Both tests run in model space: the frustum planes are taken from the world * view * projection matrix and the camera position
+// from the inverse of world * view. The cone test assumes the world matrix has no non-uniform scale.
+void MeshletClass::Cull(const MeshletType* meshlets, unsigned int meshletCount, XMMATRIX worldMatrix, XMMATRIX viewMatrix, XMMATRIX projectionMatrix,
+	OUT std::vector<IndexRangeType>& out_ranges, OUT std::vector<float>& out_depths)
+{
+	XMMATRIX worldViewMatrix;
+	XMFLOAT4X4 m, worldView;
+	XMFLOAT4 planes[6];
+	XMFLOAT3 camera;
+	float length, dx, dy, dz, distance, depth;
+	unsigned int i;
+	int p;
+	bool visible;
+
+
+	worldViewMatrix = XMMatrixMultiply(worldMatrix, viewMatrix);
+	XMStoreFloat4x4(&worldView, worldViewMatrix);
+	XMStoreFloat4x4(&m, XMMatrixMultiply(worldViewMatrix, projectionMatrix));
+	XMStoreFloat3(&camera, XMMatrixInverse(0, worldViewMatrix).r[3]);
+
+	// Left, right, bottom, top, near and far, with the Direct3D clip space depth of 0 to 1.
+	planes[0] = XMFLOAT4(m.m[0][3] + m.m[0][0], m.m[1][3] + m.m[1][0], m.m[2][3] + m.m[2][0], m.m[3][3] + m.m[3][0]);
+	planes[1] = XMFLOAT4(m.m[0][3] - m.m[0][0], m.m[1][3] - m.m[1][0], m.m[2][3] - m.m[2][0], m.m[3][3] - m.m[3][0]);
+	planes[2] = XMFLOAT4(m.m[0][3] + m.m[0][1], m.m[1][3] + m.m[1][1], m.m[2][3] + m.m[2][1], m.m[3][3] + m.m[3][1]);
+	planes[3] = XMFLOAT4(m.m[0][3] - m.m[0][1], m.m[1][3] - m.m[1][1], m.m[2][3] - m.m[2][1], m.m[3][3] - m.m[3][1]);
+	planes[4] = XMFLOAT4(m.m[0][2], m.m[1][2], m.m[2][2], m.m[3][2]);
+	planes[5] = XMFLOAT4(m.m[0][3] - m.m[0][2], m.m[1][3] - m.m[1][2], m.m[2][3] - m.m[2][2], m.m[3][3] - m.m[3][2]);
+
+	// Normalize the planes so the sphere test compares real distances.
+	for (p = 0; p < 6; p++)
+	{
+		length = sqrtf(planes[p].x * planes[p].x + planes[p].y * planes[p].y + planes[p].z * planes[p].z);
+		if (length > 0.0f)
+		{
+			planes[p] = XMFLOAT4(planes[p].x / length, planes[p].y / length, planes[p].z / length, planes[p].w / length);
+		}
+	}
+
+	memset(&m_stats, 0, sizeof(m_stats));
+	m_stats.meshletCount = meshletCount;
+	out_ranges.clear();
+	out_depths.clear();
+
+	for (i = 0; i < meshletCount; i++)
+	{
+		const MeshletType& meshlet = meshlets[i];
+
+		m_stats.triangleCount += meshlet.range.indexCount / 3;
+
+		visible = true;
+		for (p = 0; p < 6 && visible; p++)
+		{
+			distance = planes[p].x * meshlet.center.x + planes[p].y * meshlet.center.y + planes[p].z * meshlet.center.z + planes[p].w;
+			visible = distance >= -meshlet.radius;
+		}
+
+		if (!visible)
+		{
+			m_stats.frustumCulled++;
+			m_stats.trianglesCulled += meshlet.range.indexCount / 3;
+			continue;
+		}
+
+		// dot(normalize(apex - camera), axis) >= cutoff, written without the square root.
+		if (meshlet.coneCutoff < 1.0f)
+		{
+			dx = meshlet.coneApex.x - camera.x;
+			dy = meshlet.coneApex.y - camera.y;
+			dz = meshlet.coneApex.z - camera.z;
+			distance = dx * meshlet.coneAxis.x + dy * meshlet.coneAxis.y + dz * meshlet.coneAxis.z;
+			if (distance > 0.0f && distance * distance >= meshlet.coneCutoff * meshlet.coneCutoff * (dx * dx + dy * dy + dz * dz))
+			{
+				m_stats.backfaceCulled++;
+				m_stats.trianglesCulled += meshlet.range.indexCount / 3;
+				continue;
+			}
+		}
+
+		// The world matrix is assumed to have no scale for the depth, the same as for the cone test.
+		depth = meshlet.center.x * worldView.m[0][2] + meshlet.center.y * worldView.m[1][2] + meshlet.center.z * worldView.m[2][2] +
+			worldView.m[3][2] - meshlet.radius;
+
+		// Clusters that follow each other in the index buffer are drawn with one call, as long as they share a material.
+		if (!out_ranges.empty() && out_ranges.back().startIndex + out_ranges.back().indexCount == meshlet.range.startIndex &&
+			out_ranges.back().baseVertex == meshlet.range.baseVertex && out_ranges.back().material == meshlet.range.material)
+		{
+			out_ranges.back().indexCount += meshlet.range.indexCount;
+			out_depths.back() = depth < out_depths.back() ? depth : out_depths.back();
+		}
+		else
+		{
+			out_ranges.push_back(meshlet.range);
+			out_depths.push_back(depth);
+		}
+	}
+
+	m_stats.drawCount = (unsigned int)out_ranges.size();
+
+	return;
+}
+
+
+MeshletClass::CullStatsType MeshletClass::GetStats()
+{
+	return m_stats;
+}
+
+// ComputeBounds fills in the bounding sphere, the box and the normal cone of a cluster.
+// The sphere is centered on the box, which is slightly looser than a minimal sphere but cheap and stable.
+// The cone follows meshoptimizer: the axis is the average triangle normal, the cutoff comes from the widest triangle normal
+// and the apex is moved back along the axis until every triangle plane is in front of it.
+void MeshletClass::ComputeBounds(const VertexType* verts, const uint32_t* indices, MeshletType& meshlet)
+{
+	XMVECTOR boundsMin, boundsMax, center, axis, normal, corner;
+	std::vector<XMFLOAT3> normals;
+	XMFLOAT3 unitNormal;
+	float radius, minDot, dot, apexOffset, t;
+	unsigned int i, k, end;
+
+
+	end = meshlet.range.startIndex + meshlet.range.indexCount;
+
+	boundsMin = XMLoadFloat3(&verts[indices[meshlet.range.startIndex]].position);
+	boundsMax = boundsMin;
+	for (i = meshlet.range.startIndex; i < end; i++)
+	{
+		corner = XMLoadFloat3(&verts[indices[i]].position);
+		boundsMin = XMVectorMin(boundsMin, corner);
+		boundsMax = XMVectorMax(boundsMax, corner);
+	}
+
+	center = XMVectorScale(XMVectorAdd(boundsMin, boundsMax), 0.5f);
+	radius = 0.0f;
+	for (i = meshlet.range.startIndex; i < end; i++)
+	{
+		corner = XMLoadFloat3(&verts[indices[i]].position);
+		radius = std::max(radius, XMVectorGetX(XMVector3Length(XMVectorSubtract(corner, center))));
+	}
+
+	XMStoreFloat3(&meshlet.boundsMin, boundsMin);
+	XMStoreFloat3(&meshlet.boundsMax, boundsMax);
+	XMStoreFloat3(&meshlet.center, center);
+	meshlet.radius = radius;
+
+	// Collect the unit normals of the triangles with an area, clockwise triangles face along cross(v1 - v0, v2 - v0).
+	axis = XMVectorZero();
+	normals.reserve(meshlet.range.indexCount / 3);
+	for (i = meshlet.range.startIndex; i < end; i += 3)
+	{
+		XMVECTOR p0 = XMLoadFloat3(&verts[indices[i]].position);
+		XMVECTOR p1 = XMLoadFloat3(&verts[indices[i + 1]].position);
+		XMVECTOR p2 = XMLoadFloat3(&verts[indices[i + 2]].position);
+
+		normal = XMVector3Cross(XMVectorSubtract(p1, p0), XMVectorSubtract(p2, p0));
+		if (XMVectorGetX(XMVector3LengthSq(normal)) > 0.0f)
+		{
+			normal = XMVector3Normalize(normal);
+			XMStoreFloat3(&unitNormal, normal);
+			normals.push_back(unitNormal);
+			axis = XMVectorAdd(axis, normal);
+		}
+	}
+
+	// Without a usable axis the cluster can not be culled by its facing.
+	meshlet.coneApex = meshlet.center;
+	meshlet.coneAxis = XMFLOAT3(0.0f, 0.0f, 0.0f);
+	meshlet.coneCutoff = 1.0f;
+	if (normals.empty() || XMVectorGetX(XMVector3LengthSq(axis)) <= 0.0f)
+	{
+		return;
+	}
+
+	axis = XMVector3Normalize(axis);
+	minDot = 1.0f;
+	for (k = 0; k < normals.size(); k++)
+	{
+		minDot = std::min(minDot, XMVectorGetX(XMVector3Dot(XMLoadFloat3(&normals[k]), axis)));
+	}
+
+	XMStoreFloat3(&meshlet.coneAxis, axis);
+
+	// A cone wider than a half space can see every direction, leave the cutoff at 1.
+	if (minDot <= 0.0f)
+	{
+		return;
+	}
+
+	// Solve dot(center - t * axis - corner, normal) = 0 for each triangle and keep the largest t.
+	apexOffset = 0.0f;
+	k = 0;
+	for (i = meshlet.range.startIndex; i < end; i += 3)
+	{
+		XMVECTOR p0 = XMLoadFloat3(&verts[indices[i]].position);
+		XMVECTOR p1 = XMLoadFloat3(&verts[indices[i + 1]].position);
+		XMVECTOR p2 = XMLoadFloat3(&verts[indices[i + 2]].position);
+
+		normal = XMVector3Cross(XMVectorSubtract(p1, p0), XMVectorSubtract(p2, p0));
+		if (XMVectorGetX(XMVector3LengthSq(normal)) > 0.0f)
+		{
+			normal = XMLoadFloat3(&normals[k++]);
+			dot = XMVectorGetX(XMVector3Dot(axis, normal));
+			t = XMVectorGetX(XMVector3Dot(XMVectorSubtract(center, p0), normal)) / dot;
+			apexOffset = std::max(apexOffset, t);
+		}
+	}
+
+	XMStoreFloat3(&meshlet.coneApex, XMVectorSubtract(center, XMVectorScale(axis, apexOffset)));
+	meshlet.coneCutoff = sqrtf(1.0f - minDot * minDot);
+
+	return;
+}
@@ -0,0 +1,74 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: meshletclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _MESHLETCLASS_H_
+#define _MESHLETCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <cstdint>
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "meshtypes.h"
+
+
+//////////////
+// TYPEDEFS //
+//////////////
+// A MeshletType is a run of consecutive triangles in the index buffer together with the bounds used to cull it.
+// The normal cone contains the facing of every triangle, a camera for which dot(normalize(coneApex - camera), coneAxis) >= coneCutoff
+// sees all of them from behind. A cutoff of 1 means the cluster faces too many ways to ever be rejected that way.
+struct MeshletType
+{
+	IndexRangeType range;
+	XMFLOAT3 center;
+	float radius;
+	XMFLOAT3 boundsMin, boundsMax;
+	XMFLOAT3 coneApex, coneAxis;
+	float coneCutoff;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: MeshletClass
+////////////////////////////////////////////////////////////////////////////////
+// The MeshletClass cuts an index range into clusters of at most a given number of vertices and triangles and culls them on the CPU.
+// Clusters take the triangles in index buffer order, so the vertex cache order of the MeshOptimizerClass keeps them compact and
+// the index buffer does not need to be rewritten. Culling rejects clusters outside the view frustum or facing away from the camera
+// and merges the survivors that are next to each other in the index buffer into as few draws as possible.
+class MeshletClass
+{
+public:
+	struct CullStatsType
+	{
+		unsigned int meshletCount, frustumCulled, backfaceCulled;
+		unsigned int triangleCount, trianglesCulled;
+		unsigned int drawCount;
+	};
+
+public:
+	MeshletClass();
+	MeshletClass(const MeshletClass&);
+	~MeshletClass();
+
+	void SetLimits(unsigned int maxVertices, unsigned int maxTriangles);
+	void Build(const VertexType* verts, const uint32_t* indices, const IndexRangeType& range, OUT std::vector<MeshletType>& out_meshlets);
+	void Cull(const MeshletType* meshlets, unsigned int meshletCount, XMMATRIX worldMatrix, XMMATRIX viewMatrix, XMMATRIX projectionMatrix,
+		OUT std::vector<IndexRangeType>& out_ranges, OUT std::vector<float>& out_depths);
+
+	CullStatsType GetStats();
+
+private:
+	void ComputeBounds(const VertexType* verts, const uint32_t* indices, MeshletType& meshlet);
+
+private:
+	unsigned int m_maxVertices, m_maxTriangles;
+	std::vector<uint32_t> m_vertexStamp;
+	CullStatsType m_stats;
+};
+
+#endif
@@ -2,13 +2,181 @@
 // Filename: modelclass.cpp
 ////////////////////////////////////////////////////////////////////////////////
 #include "modelclass.h"
+#include "meshweldclass.h"
+#include "objparserclass.h"
+#include "meshcacheclass.h"
+#include "meshoptimizerclass.h"
+#include "meshsimplifierclass.h"
+#include "meshnormalclass.h"
+#include "gltfloaderclass.h"
+#include "mtlparserclass.h"
+#include "progressivemeshclass.h"
+#include "vertexlayouts.h"
+#include <array>
+#include <cctype>
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+
+/////////////
+// GLOBALS //
+/////////////
+// Attributes closer than this are merged when welding, set it to zero to only weld exact (v, vt, vn) matches.
+const float MODEL_WELD_TOLERANCE = 1.0e-6f;
+
+// Faces of an OBJ without normals are smoothed together with their neighbours unless they meet at more than this, 60 degrees.
+const float MODEL_NORMAL_CREASE_ANGLE = XM_PI / 3.0f;
+
+// The level of detail chain halves the triangles of the previous level until a level would exceed the error or keep more than
+// nine tenths of them, or there are MODEL_LOD_MAX_LEVELS levels including the full mesh. The error is relative to the mesh size.
+const int MODEL_LOD_MAX_LEVELS = 6;
+const float MODEL_LOD_RATIO = 0.5f;
+const float MODEL_LOD_MAX_ERROR = 0.02f;
+const float MODEL_LOD_MIN_REDUCTION = 0.9f;
+
+// MakeInputLayout collects the elements of a vertex layout into the array a shader of the render device is created with.
+template <typename Layout>
+static constexpr std::array<VertexElementDescType, Layout::elementCount> MakeInputLayout()
+{
+	std::array<VertexElementDescType, Layout::elementCount> layout = {};
+	unsigned int i;
+
+
+	for (i = 0; i < Layout::elementCount; i++)
+	{
+		layout[i] = Layout::GetElement(i);
+	}
+
+	return layout;
+}
+
+// The input layouts for each VertexFormatType, interleaved and with split streams, generated from vertexlayouts.h.
+// The shader reads the same float4 position and float2 texture coordinates from all of them, the UNORM positions are scaled back
+// by the position decode matrix and the normal is expanded by whoever reads it. The first element of every layout is the position
+// alone at the start of slot 0, which is all a position only pass needs whether the streams are split or not.
+static constexpr std::array<VertexElementDescType, 3> FULL_VERTEX_LAYOUT = MakeInputLayout<FullVertexLayoutType>();
+static constexpr std::array<VertexElementDescType, 3> COMPACT_OCTAHEDRAL_VERTEX_LAYOUT = MakeInputLayout<CompactOctahedralVertexLayoutType>();
+static constexpr std::array<VertexElementDescType, 3> COMPACT_PACKED_VERTEX_LAYOUT = MakeInputLayout<CompactPackedVertexLayoutType>();
+static constexpr std::array<VertexElementDescType, 3> FULL_SPLIT_VERTEX_LAYOUT = MakeInputLayout<FullSplitVertexLayoutType>();
+static constexpr std::array<VertexElementDescType, 3> COMPACT_OCTAHEDRAL_SPLIT_VERTEX_LAYOUT = MakeInputLayout<CompactOctahedralSplitVertexLayoutType>();
+static constexpr std::array<VertexElementDescType, 3> COMPACT_PACKED_SPLIT_VERTEX_LAYOUT = MakeInputLayout<CompactPackedSplitVertexLayoutType>();
+
+// HasExtension tells whether a file name ends in the given extension, ignoring the case of ASCII letters.
+static bool HasExtension(const char* filename, const char* extension)
+{
+	size_t nameLength, extensionLength, i;
+
+
+	nameLength = strlen(filename);
+	extensionLength = strlen(extension);
+	if (nameLength < extensionLength)
+	{
+		return false;
+	}
+
+	filename += nameLength - extensionLength;
+	for (i = 0; i < extensionLength; i++)
+	{
+		if (tolower((unsigned char)filename[i]) != tolower((unsigned char)extension[i]))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Utf8ToWide converts a UTF-8 file name, which is what glTF stores, to the wide names textures are loaded by. Elsewhere than Windows
+// a wchar_t holds a whole code point, malformed bytes are taken as they are.
+static std::wstring Utf8ToWide(const std::string& text)
+{
+	std::wstring wide;
+
+
+#ifdef _WIN32
+	int length;
+
+	length = MultiByteToWideChar(CP_UTF8, 0, text.c_str(), (int)text.size(), nullptr, 0);
+	if (length > 0)
+	{
+		wide.resize(length);
+		MultiByteToWideChar(CP_UTF8, 0, text.c_str(), (int)text.size(), &wide[0], length);
+	}
+#else
+	size_t i, extra;
+	unsigned int codePoint;
+	unsigned char byte;
+
+	for (i = 0; i < text.size(); i++)
+	{
+		byte = (unsigned char)text[i];
+		if (byte >= 0xf0)
+		{
+			codePoint = byte & 0x07;
+			extra = 3;
+		}
+		else if (byte >= 0xe0)
+		{
+			codePoint = byte & 0x0f;
+			extra = 2;
+		}
+		else if (byte >= 0xc0)
+		{
+			codePoint = byte & 0x1f;
+			extra = 1;
+		}
+		else
+		{
+			codePoint = byte;
+			extra = 0;
+		}
+
+		for (; extra > 0 && i + 1 < text.size() && ((unsigned char)text[i + 1] & 0xc0) == 0x80; extra--)
+		{
+			i++;
+			codePoint = (codePoint << 6) | ((unsigned char)text[i] & 0x3f);
+		}
+		wide += (wchar_t)codePoint;
+	}
+#endif
+
+	return wide;
+}
 
 // The class constructor initializes the vertex and index buffer pointers to null.
 ModelClass::ModelClass()
 {
-	m_vertexBuffer = 0;
-	m_indexBuffer = 0;
+	m_device = 0;
+	m_vertexBuffer = RENDER_HANDLE_NONE;
+	m_indexBuffer = RENDER_HANDLE_NONE;
+	m_attributeBuffer = RENDER_HANDLE_NONE;
 	m_Texture = 0;
+	m_vertexFormat = VERTEX_FORMAT_FULL;
+	m_splitLargeMeshes = false;
+	m_vertexStride = sizeof(VertexType);
+	m_indexFormat = DXGI_FORMAT_R32_UINT;
+	XMStoreFloat4x4(&m_positionDecode, XMMatrixIdentity());
+	m_splitStreams = false;
+	m_positionStride = 0;
+	m_attributeStride = 0;
+	m_meshletMaxVertices = 0;
+	m_meshletMaxTriangles = 0;
+	m_boundsCenter = XMFLOAT3(0.0f, 0.0f, 0.0f);
+	m_boundsRadius = 0.0f;
+	m_progressiveEnabled = false;
+	m_refineBytesPerFrame = 0;
+	m_refineErrorLimit = 0.0f;
+	m_geometryPool = 0;
+	m_poolHandle = GEOMETRY_POOL_HANDLE_NONE;
 }
 
 
@@ -21,32 +189,146 @@ ModelClass::~ModelClass()
 {
 }
 
+// SetVertexFormat picks the layout the next Initialize uploads the mesh with. When splitLargeMeshes is set a mesh with more vertices
+// than 16 bit indices can address is cut into ranges that each fit, otherwise it keeps 32 bit indices.
+void ModelClass::SetVertexFormat(VertexFormatType format, bool splitLargeMeshes)
+{
+	m_vertexFormat = format;
+	m_splitLargeMeshes = splitLargeMeshes;
+
+	return;
+}
+
+// SetSplitStreams makes the next Initialize upload the positions and the other attributes into separate vertex buffers, so a pass that
+// binds only the positions, such as a depth or shadow pass, fetches 12 bytes a vertex instead of 32, 8 instead of 16 when compact.
+// A model with split streams does not go into the geometry pool, which only holds interleaved vertices.
+void ModelClass::SetSplitStreams(bool enabled)
+{
+	m_splitStreams = enabled;
+
+	return;
+}
+
+// SetMeshletLimits makes the next Initialize cut the index buffer into clusters of at most this many vertices and triangles,
+// which Cull can then reject one by one. Zero for either limit leaves the model without clusters.
+void ModelClass::SetMeshletLimits(unsigned int maxVertices, unsigned int maxTriangles)
+{
+	m_meshletMaxVertices = maxVertices;
+	m_meshletMaxTriangles = maxTriangles;
+
+	return;
+}
+
+// SetLodThreshold sets how many pixels the simplification error of the drawn level of detail may cover on screen, and by what
+// fraction of that a level has to be past the threshold before Cull switches away from it.
+void ModelClass::SetLodThreshold(float pixelError, float hysteresis)
+{
+	m_lodSelector.SetThreshold(pixelError, hysteresis);
+
+	return;
+}
+
+// SetProgressive makes the next Initialize stream an OBJ model from its .dxpm file, building that first when it is missing or out of
+// date. Each Refine then reads at most refineBytesPerFrame more of it.
+void ModelClass::SetProgressive(bool enabled, unsigned int refineBytesPerFrame)
+{
+	m_progressiveEnabled = enabled;
+	m_refineBytesPerFrame = refineBytesPerFrame;
+
+	return;
+}
+
+// SetGeometryPool makes the next Initialize upload an OBJ model into the shared buffers of the pool, which has to outlive the model.
+// Streamed and glTF models, and meshes the pool's vertex stride or index format does not fit, still get buffers of their own.
+void ModelClass::SetGeometryPool(GeometryPoolClass* geometryPool)
+{
+	m_geometryPool = geometryPool;
+
+	return;
+}
+
 // The Initialize function will call the initialization functions for the vertex and index buffers.
-bool ModelClass::Initialize(ID3D11Device * device, const char* modelFileName, const wchar_t* textureFilename)
+// The processed mesh is cached next to the OBJ as a .dxmesh file. When the cache is current it is memory mapped and its arrays go
+// straight to CreateBuffer, otherwise the OBJ is parsed and welded and the cache is rewritten for the next start.
+// A progressive model only uploads the base of its stream here and is refined by Refine, if it can not be streamed it is loaded whole.
+// .glb and .gltf models are already in a binary layout and are uploaded from the file without a cache.
+// The given texture is used for the materials of the OBJ that do not have one of their own.
+bool ModelClass::Initialize(RenderDeviceClass* device, const char* modelFileName, const wchar_t* textureFilename)
 {
 	bool result;
-	std::vector<VertexType> obj_verts;
-	std::vector<unsigned long> obj_indices;
-	result = LoadOBJ(modelFileName, obj_verts, obj_indices);
-	if (!result)
+	MeshCacheClass cache;
+	MeshMaterialListType materials;
+	std::string cacheFileName;
+
+
+	// The buffers and textures are released through the device they were created on.
+	m_device = device;
+
+	if (HasExtension(modelFileName, ".glb") || HasExtension(modelFileName, ".gltf"))
 	{
-		return false;
+		return InitializeGLTF(device, modelFileName, textureFilename);
 	}
 
-	// Initialize the vertex and index buffer that hold the geometry for the triangle.
-	// result = InitializeBuffers(device);
-	result = InitializeOBJBuffers(device,obj_verts,obj_indices);
-	if (!result)
+	result = false;
+	if (m_progressiveEnabled)
 	{
-		return false;
+		result = InitializeProgressive(device, modelFileName, materials);
+		if (!result)
+		{
+			printf("Could not stream %s progressively, loading it whole\n", modelFileName);
+		}
+	}
+
+	// A progressive model has its base uploaded by now, the rest streams in through Refine. Anything else comes from the cache or the OBJ.
+	cacheFileName = MeshCacheClass::GetCacheFilename(modelFileName);
+	if (!result && cache.Initialize(cacheFileName.c_str(), modelFileName))
+	{
+		// Initialize the vertex and index buffer directly from the mapped cache.
+		result = InitializeOBJBuffers(device, cache.GetVertices(), cache.GetVertexCount(), cache.GetIndices(), 0, cache.GetIndexCount(), cache.GetLods(),
+			cache.GetLodCount(), cache.GetSubmeshes(), cache.GetSubmeshCount());
+		cache.GetMaterials(materials);
+		cache.Shutdown();
+		if (!result)
+		{
+			return false;
+		}
+	}
+	else if (!result)
+	{
+		std::vector<VertexType> obj_verts;
+		std::vector<uint32_t> obj_indices;
+		std::vector<MeshLodType> obj_lods;
+		std::vector<MeshSubmeshType> obj_submeshes;
+		result = LoadOBJ(modelFileName, obj_verts, obj_indices, obj_lods, obj_submeshes, materials);
+		if (!result)
+		{
+			return false;
+		}
+
+		// A missing cache only costs the next start some time, so failing to write one is not an error.
+		if (!MeshCacheClass::Write(cacheFileName.c_str(), modelFileName, obj_verts, obj_indices, obj_lods, obj_submeshes, materials))
+		{
+			printf("Could not write the mesh cache %s\n", cacheFileName.c_str());
+		}
+
+		// Initialize the vertex and index buffer that hold the geometry for the triangle.
+		// result = InitializeBuffers(device);
+		result = InitializeOBJBuffers(device, obj_verts.data(), (int)obj_verts.size(), obj_indices.data(), 0, (int)obj_indices.size(),
+			obj_lods.data(), (int)obj_lods.size(), obj_submeshes.data(), (int)obj_submeshes.size());
+		if (!result)
+		{
+			return false;
+		}
 	}
-	// Load the texture for this model.
+
+	// Load the texture for this model, and the textures of its materials.
 	result = LoadTexture(device, textureFilename);
 	if (!result)
 	{
 		return false;
 	}
 
+	LoadMaterials(device, modelFileName, materials);
 
 	return true;
 }
@@ -54,7 +336,10 @@ bool ModelClass::Initialize(ID3D11Device * device, const char* modelFileName, co
 // The Shutdown function will call the shutdown functions for the vertex and index buffers.
 void ModelClass::Shutdown()
 {
-	// Release the model texture.
+	// Stop streaming, then release the material textures and the model texture.
+	m_progressive.Shutdown();
+	m_materialTextures.clear();
+	m_textureCache.Shutdown();
 	ReleaseTexture();
 	// Release the vertex and index buffers.
 	ShutdownBuffers();
@@ -64,10 +349,104 @@ void ModelClass::Shutdown()
 
 // Render is called from the GraphicsClass::Render function.
 // This function calls RenderBuffers to put the vertex and index buffers on the graphics pipeline so the color shader will be able to render them.
-void ModelClass::Render(ID3D11DeviceContext * deviceContext)
+void ModelClass::Render(RenderDeviceClass* device)
+{
+	Render(device, VERTEX_STREAM_ALL);
+
+	return;
+}
+
+// This Render binds only the vertex streams a pass asks for, a combination of VertexStreamType. A model whose streams are not split
+// binds its interleaved buffer for any of them.
+void ModelClass::Render(RenderDeviceClass* device, unsigned int streams)
 {
 	// Put the vertex and index buffers on the graphics pipeline to prepare them for drawing.
-	RenderBuffers(deviceContext);
+	if (m_poolHandle != GEOMETRY_POOL_HANDLE_NONE)
+	{
+		m_geometryPool->Render(device);
+	}
+	else
+	{
+		RenderBuffers(device, streams);
+	}
+
+	return;
+}
+
+// Refine reads the next part of a progressive model's stream and uploads the vertices and indices it changed. It does nothing for
+// other models, once the whole stream is in, or while the error is already below the limit the last Cull computed.
+void ModelClass::Refine(RenderDeviceClass* device)
+{
+	ProgressiveLoaderClass::DirtyRangeType vertexRange;
+	const void* source;
+	unsigned int indexStride;
+	const uint32_t* indices;
+	size_t i;
+	unsigned int j;
+	bool result;
+
+
+	if (!m_progressive.IsLoaded() || m_progressive.IsComplete() || m_progressive.GetError() <= m_refineErrorLimit)
+	{
+		return;
+	}
+
+	// A stream that turns out corrupt still has the splits before the bad one applied, they are uploaded before it is closed.
+	result = m_progressive.Refine(m_refineBytesPerFrame, m_refineErrorLimit);
+
+	vertexRange = m_progressive.GetDirtyVertices();
+	if (vertexRange.count > 0)
+	{
+		if (m_vertexFormat != VERTEX_FORMAT_FULL)
+		{
+			MeshCompressionClass compression;
+			compression.EncodeVertices(m_progressive.GetVertices() + vertexRange.start, vertexRange.count, m_vertexFormat, m_quantization, m_uploadVertices);
+			source = m_uploadVertices.data();
+		}
+		else
+		{
+			source = m_progressive.GetVertices() + vertexRange.start;
+		}
+
+		UpdateVertexBuffers(device, source, vertexRange.start, vertexRange.count);
+	}
+
+	indices = m_progressive.GetIndices();
+	m_progressive.GetDirtyIndices(m_dirtyRanges);
+	for (i = 0; i < m_dirtyRanges.size(); i++)
+	{
+		if (m_indexFormat == DXGI_FORMAT_R16_UINT)
+		{
+			m_uploadIndices.resize(m_dirtyRanges[i].count);
+			for (j = 0; j < m_dirtyRanges[i].count; j++)
+			{
+				m_uploadIndices[j] = (uint16_t)indices[m_dirtyRanges[i].start + j];
+			}
+			source = m_uploadIndices.data();
+			indexStride = sizeof(uint16_t);
+		}
+		else
+		{
+			source = indices + m_dirtyRanges[i].start;
+			indexStride = sizeof(uint32_t);
+		}
+		device->UpdateBuffer(m_indexBuffer, m_dirtyRanges[i].start * indexStride, source, m_dirtyRanges[i].count * indexStride);
+	}
+	m_progressive.ClearDirty();
+
+	// Every submesh is one range that grows with the splits, the next Cull picks the new counts up.
+	for (i = 0; i < m_ranges.size(); i++)
+	{
+		m_ranges[i].indexCount = m_progressive.GetSubmeshes()[i].indexCount;
+	}
+	m_submeshes.assign(m_progressive.GetSubmeshes(), m_progressive.GetSubmeshes() + m_progressive.GetSubmeshCount());
+	m_lodErrors[0] = m_progressive.GetError();
+
+	if (!result)
+	{
+		printf("Stopped refining the progressive mesh, its stream is corrupt or can not be read\n");
+		m_progressive.Shutdown();
+	}
 
 	return;
 }
@@ -79,21 +458,220 @@ int ModelClass::GetIndexCount()
 	return m_indexCount;
 }
 
-ID3D11ShaderResourceView* ModelClass::GetTexture()
+// GetRangeCount and GetRange return the DrawIndexed calls that together draw the whole model.
+int ModelClass::GetRangeCount()
+{
+	return (int)m_ranges.size();
+}
+
+
+IndexRangeType ModelClass::GetRange(int index)
+{
+	IndexRangeType range;
+
+
+	range = m_ranges[index];
+	if (m_poolHandle != GEOMETRY_POOL_HANDLE_NONE)
+	{
+		range.startIndex += m_geometryPool->GetStartIndex(m_poolHandle);
+		range.baseVertex += m_geometryPool->GetBaseVertex(m_poolHandle);
+	}
+
+	return range;
+}
+
+// GetLodRangeCount and GetLodRange return the DrawIndexed calls that together draw one level of detail whole, without culling.
+int ModelClass::GetLodRangeCount(int lod)
+{
+	return m_lods[lod].rangeCount;
+}
+
+
+IndexRangeType ModelClass::GetLodRange(int lod, int index)
+{
+	return GetRange(m_lods[lod].firstRange + index);
+}
+
+// GetBounds returns the sphere around the model in model space, before the position decode matrix.
+void ModelClass::GetBounds(OUT XMFLOAT3& center, OUT float& radius)
+{
+	center = m_boundsCenter;
+	radius = m_boundsRadius;
+
+	return;
+}
+
+// GetInputLayout returns the vertex elements for the vertex format and streams the model was uploaded with. Asking for
+// VERTEX_STREAM_POSITION alone gives the layout of a position only pass, to go with a Render that binds only that stream.
+void ModelClass::GetInputLayout(unsigned int streams, OUT const VertexElementDescType*& layout, OUT unsigned int& elementCount)
+{
+	switch (m_vertexFormat)
+	{
+	case VERTEX_FORMAT_COMPACT_OCTAHEDRAL:
+		layout = m_splitStreams ? COMPACT_OCTAHEDRAL_SPLIT_VERTEX_LAYOUT.data() : COMPACT_OCTAHEDRAL_VERTEX_LAYOUT.data();
+		elementCount = (unsigned int)COMPACT_OCTAHEDRAL_VERTEX_LAYOUT.size();
+		break;
+	case VERTEX_FORMAT_COMPACT_PACKED:
+		layout = m_splitStreams ? COMPACT_PACKED_SPLIT_VERTEX_LAYOUT.data() : COMPACT_PACKED_VERTEX_LAYOUT.data();
+		elementCount = (unsigned int)COMPACT_PACKED_VERTEX_LAYOUT.size();
+		break;
+	default:
+		layout = m_splitStreams ? FULL_SPLIT_VERTEX_LAYOUT.data() : FULL_VERTEX_LAYOUT.data();
+		elementCount = (unsigned int)FULL_VERTEX_LAYOUT.size();
+		break;
+	}
+
+	if (!(streams & VERTEX_STREAM_ATTRIBUTES))
+	{
+		elementCount = 1;
+	}
+
+	return;
+}
+
+// GetPositionDecodeMatrix returns the matrix that takes quantized positions back to model space, it has to be applied before the world matrix.
+// It is the identity for the full vertex format.
+void ModelClass::GetPositionDecodeMatrix(OUT XMMATRIX& decodeMatrix)
+{
+	decodeMatrix = XMLoadFloat4x4(&m_positionDecode);
+
+	return;
+}
+
+// Cull picks the level of detail for the size of the model on screen, rejects its clusters the camera can not see and collects
+// the index ranges left to draw. The world matrix is the one the model is placed with, without the position decode matrix.
+void ModelClass::Cull(XMMATRIX worldMatrix, XMMATRIX viewMatrix, XMMATRIX projectionMatrix, int screenHeight)
+{
+	XMFLOAT3 center;
+	int lod;
+
+
+	if (m_lods.empty())
+	{
+		return;
+	}
+
+	// A progressive model has a single level that Refine keeps refining until its error covers less than the pixel threshold.
+	if (m_progressive.IsLoaded())
+	{
+		m_refineErrorLimit = m_lodSelector.GetErrorLimit(m_boundsCenter, m_boundsRadius, worldMatrix, viewMatrix, projectionMatrix, screenHeight);
+	}
+
+	lod = m_lodSelector.Select(m_lodErrors.data(), (int)m_lodErrors.size(), m_boundsCenter, m_boundsRadius, worldMatrix, viewMatrix,
+		projectionMatrix, screenHeight);
+
+	const LodRangesType& lodRanges = m_lods[lod];
+	if (lodRanges.meshletCount > 0)
+	{
+		m_meshletCuller.Cull(&m_meshlets[lodRanges.firstMeshlet], lodRanges.meshletCount, worldMatrix, viewMatrix, projectionMatrix,
+			m_visibleRanges, m_visibleDepths);
+	}
+	else
+	{
+		// Every range is as near as the nearest point of the bounds of the whole model.
+		m_visibleRanges.assign(m_ranges.begin() + lodRanges.firstRange, m_ranges.begin() + lodRanges.firstRange + lodRanges.rangeCount);
+		XMStoreFloat3(&center, XMVector3Transform(XMLoadFloat3(&m_boundsCenter), XMMatrixMultiply(worldMatrix, viewMatrix)));
+		m_visibleDepths.assign(m_visibleRanges.size(), center.z - m_boundsRadius);
+	}
+
+	return;
+}
+
+// GetVisibleRangeCount and GetVisibleRange return the DrawIndexed calls left after the last Cull, the full mesh before the first one.
+int ModelClass::GetVisibleRangeCount()
+{
+	return (int)m_visibleRanges.size();
+}
+
+
+IndexRangeType ModelClass::GetVisibleRange(int index)
+{
+	IndexRangeType range;
+
+
+	range = m_visibleRanges[index];
+	if (m_poolHandle != GEOMETRY_POOL_HANDLE_NONE)
+	{
+		range.startIndex += m_geometryPool->GetStartIndex(m_poolHandle);
+		range.baseVertex += m_geometryPool->GetBaseVertex(m_poolHandle);
+	}
+
+	return range;
+}
+
+// GetVisibleRangeDepth returns how far in front of the camera the nearest part of a visible range may be, zero before the first Cull.
+float ModelClass::GetVisibleRangeDepth(int index)
+{
+	return m_visibleDepths[index];
+}
+
+
+MeshletClass::CullStatsType ModelClass::GetCullStats()
+{
+	return m_meshletCuller.GetStats();
+}
+
+// GetLod returns the level of detail the last Cull picked, zero being the full mesh.
+int ModelClass::GetLod()
+{
+	return m_lodSelector.GetLod();
+}
+
+
+int ModelClass::GetLodCount()
+{
+	return (int)m_lods.size();
+}
+
+// GetSubmeshCount and GetSubmesh return the submesh table: every level of detail, finest first, has one submesh per material it uses.
+int ModelClass::GetSubmeshCount()
+{
+	return (int)m_submeshes.size();
+}
+
+
+MeshSubmeshType ModelClass::GetSubmesh(int index)
+{
+	return m_submeshes[index];
+}
+
+
+int ModelClass::GetMaterialCount()
+{
+	return (int)m_materials.names.size();
+}
+
+
+const char* ModelClass::GetMaterialName(unsigned int material)
+{
+	return m_materials.names[material].c_str();
+}
+
+unsigned int ModelClass::GetTexture()
 {
 	return m_Texture->GetTexture();
 }
 
+// GetMaterialTexture returns the texture to draw the ranges of a material with, see IndexRangeType::material.
+unsigned int ModelClass::GetMaterialTexture(unsigned int material)
+{
+	if (material >= m_materialTextures.size())
+	{
+		return m_Texture->GetTexture();
+	}
+
+	return m_materialTextures[material]->GetTexture();
+}
+
 // The InitializeBuffers function is where we handle creating the vertexand index buffers.
 // Usually you would read in a model and create the buffers from that data file.
 // For this tutorial we will just set the points in the vertex and index buffer manually since it is only a single triangle.
-bool ModelClass::InitializeBuffers(ID3D11Device * device)
+bool ModelClass::InitializeBuffers(RenderDeviceClass* device)
 {
 	VertexType* vertices;
-	unsigned long* indices;
-	D3D11_BUFFER_DESC vertexBufferDesc, indexBufferDesc;
-	D3D11_SUBRESOURCE_DATA vertexData, indexData;
-	HRESULT result;
+	uint32_t* indices;
+	RenderDeviceClass::BufferDescType vertexBufferDesc, indexBufferDesc;
+	bool result;
 	
 	// First create two temporary arrays to hold the vertex and index data that we will use later to populate the final buffers with.
 
@@ -111,7 +689,7 @@ bool ModelClass::InitializeBuffers(ID3D11Device * device)
 	}
 
 	// Create the index array.
-	indices = new unsigned long[m_indexCount];
+	indices = new uint32_t[m_indexCount];
 	if (!indices)
 	{
 		return false;
@@ -156,41 +734,25 @@ bool ModelClass::InitializeBuffers(ID3D11Device * device)
 	// With the description and subresource pointer you can call CreateBuffer using the D3D device and it will return a pointer to your new buffer.
 
 	// Set up the description of the static vertex buffer.
-	vertexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-	vertexBufferDesc.ByteWidth = sizeof(VertexType) * m_vertexCount;
-	vertexBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-	vertexBufferDesc.CPUAccessFlags = 0;
-	vertexBufferDesc.MiscFlags = 0;
-	vertexBufferDesc.StructureByteStride = 0;
-
-	// Give the subresource structure a pointer to the vertex data.
-	vertexData.pSysMem = vertices;
-	vertexData.SysMemPitch = 0;
-	vertexData.SysMemSlicePitch = 0;
-
-	// Now create the vertex buffer.
-	result = device->CreateBuffer(&vertexBufferDesc, &vertexData, &m_vertexBuffer);
-	if (FAILED(result))
+	vertexBufferDesc.bind = RENDER_BIND_VERTEX_BUFFER;
+	vertexBufferDesc.usage = RENDER_USAGE_DEFAULT;
+	vertexBufferDesc.byteWidth = sizeof(VertexType) * m_vertexCount;
+
+	// Now create the vertex buffer from the vertex data.
+	result = device->CreateBuffer(vertexBufferDesc, vertices, m_vertexBuffer);
+	if (!result)
 	{
 		return false;
 	}
 
 	// Set up the description of the static index buffer.
-	indexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-	indexBufferDesc.ByteWidth = sizeof(unsigned long) * m_indexCount;
-	indexBufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
-	indexBufferDesc.CPUAccessFlags = 0;
-	indexBufferDesc.MiscFlags = 0;
-	indexBufferDesc.StructureByteStride = 0;
-
-	// Give the subresource structure a pointer to the index data.
-	indexData.pSysMem = indices;
-	indexData.SysMemPitch = 0;
-	indexData.SysMemSlicePitch = 0;
-
-	// Create the index buffer.
-	result = device->CreateBuffer(&indexBufferDesc, &indexData, &m_indexBuffer);
-	if (FAILED(result))
+	indexBufferDesc.bind = RENDER_BIND_INDEX_BUFFER;
+	indexBufferDesc.usage = RENDER_USAGE_DEFAULT;
+	indexBufferDesc.byteWidth = sizeof(uint32_t) * m_indexCount;
+
+	// Create the index buffer from the index data.
+	result = device->CreateBuffer(indexBufferDesc, indices, m_indexBuffer);
+	if (!result)
 	{
 		return false;
 	}
@@ -206,78 +768,464 @@ bool ModelClass::InitializeBuffers(ID3D11Device * device)
 	return true;
 }
 
-bool ModelClass::InitializeOBJBuffers(ID3D11Device* device, std::vector<VertexType>& obj_verts, std::vector<unsigned long>& obj_indices)
+// InitializeOBJBuffers takes plain pointers so the data can come from a vector or straight from a mapped mesh cache.
+// On the way to the GPU the indices are narrowed to 16 bits when the mesh allows it and the vertices are encoded in the selected format.
+// The full format with 32 bit indices still uploads straight from the given arrays. Every level of detail is a slice of the index
+// buffer and gets its own ranges and clusters, every submesh of it at least one range drawn with its material.
+// A mesh that already has 16 bit indices passes them as obj_shortIndices instead of obj_indices, and they are uploaded as they are.
+bool ModelClass::InitializeOBJBuffers(RenderDeviceClass* device, const VertexType* obj_verts, int vertexCount, const uint32_t* obj_indices,
+	const uint16_t* obj_shortIndices, int indexCount, const MeshLodType* lods, int lodCount, const MeshSubmeshType* submeshes, int submeshCount)
 {
-	VertexType* vertices;
-	unsigned long* indices;
-	D3D11_BUFFER_DESC vertexBufferDesc, indexBufferDesc;
-	D3D11_SUBRESOURCE_DATA vertexData, indexData;
-	HRESULT result;
-
-	// First create two temporary arrays to hold the vertex and index data that we will use later to populate the final buffers with.
-
-	// Set the number of vertices in the vertex array.
-	m_vertexCount = obj_verts.size();
-
-	// Set the number of indices in the index array.
-	m_indexCount = obj_indices.size();
-
-
-	// With the vertex array and index array filled out we can now use those to create the vertex buffer and index buffer.
-	// Creating both buffers is done in the same fashion.
-	// First, fill out a description of the buffer.
-	// In the description the ByteWidth(size of the buffer) and the BindFlags(type of buffer) are what you need to ensure are filled out correctly.
-	// After the description is filled out you need to also fill out a subresource pointer which will point to either your vertex or index array you previously created.
-	// With the description and subresource pointer you can call CreateBuffer using the D3D device and it will return a pointer to your new buffer.
-
-	// Set up the description of the static vertex buffer.
-	vertexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-	vertexBufferDesc.ByteWidth = sizeof(VertexType) * m_vertexCount;
-	vertexBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-	vertexBufferDesc.CPUAccessFlags = 0;
-	vertexBufferDesc.MiscFlags = 0;
-	vertexBufferDesc.StructureByteStride = 0;
-
-	// Give the subresource structure a pointer to the vertex data.
-	vertexData.pSysMem = obj_verts.data();
-	vertexData.SysMemPitch = 0;
-	vertexData.SysMemSlicePitch = 0;
-
-	// Now create the vertex buffer.
-	result = device->CreateBuffer(&vertexBufferDesc, &vertexData, &m_vertexBuffer);
-	if (FAILED(result))
+	RenderDeviceClass::BufferDescType indexBufferDesc;
+	bool result;
+	MeshCompressionClass compression;
+	MeshCompressionClass::QuantizationType quantization;
+	std::vector<VertexType> splitVerts, lodVerts;
+	std::vector<CompactVertexType> compactVerts;
+	std::vector<uint16_t> shortIndices, lodIndices;
+	std::vector<uint32_t> splitIndices;
+	std::vector<IndexRangeType> lodRanges;
+	const void* vertexSource;
+	const void* indexSource;
+	const uint16_t* shortSource;
+	size_t shortCount;
+	unsigned int indexStride;
+	IndexRangeType range;
+	LodRangesType lodSlice;
+	XMVECTOR boundsMin, boundsMax, center, position;
+	float radiusSq;
+	size_t i;
+	int lod, j, submesh;
+
+
+	m_submeshes.assign(submeshes, submeshes + submeshCount);
+
+	// Use 16 bit indices when every vertex can be addressed with them. A bigger mesh is either split into ranges that can,
+	// with the vertices on the range borders duplicated, or keeps its 32 bit indices. Each submesh of each level of detail is split
+	// on its own so its ranges only carry the vertices it still uses and all draw with one material.
+	m_ranges.clear();
+	m_lods.clear();
+	m_lodErrors.clear();
+	if (obj_shortIndices)
 	{
-		return false;
+		m_indexFormat = DXGI_FORMAT_R16_UINT;
+	}
+	else if (compression.NarrowIndices(obj_indices, indexCount, vertexCount, shortIndices))
+	{
+		m_indexFormat = DXGI_FORMAT_R16_UINT;
+	}
+	else if (m_splitLargeMeshes)
+	{
+		for (lod = 0; lod < lodCount; lod++)
+		{
+			lodSlice.firstRange = (int)m_ranges.size();
+			for (submesh = lods[lod].firstSubmesh; submesh < (int)(lods[lod].firstSubmesh + lods[lod].submeshCount); submesh++)
+			{
+				compression.SplitIndices(obj_verts, obj_indices + submeshes[submesh].startIndex, submeshes[submesh].indexCount, lodVerts, lodIndices,
+					lodRanges);
+				for (i = 0; i < lodRanges.size(); i++)
+				{
+					lodRanges[i].startIndex += (unsigned int)shortIndices.size();
+					lodRanges[i].baseVertex += (int)splitVerts.size();
+					lodRanges[i].material = submeshes[submesh].material;
+				}
+
+				m_ranges.insert(m_ranges.end(), lodRanges.begin(), lodRanges.end());
+				splitVerts.insert(splitVerts.end(), lodVerts.begin(), lodVerts.end());
+				shortIndices.insert(shortIndices.end(), lodIndices.begin(), lodIndices.end());
+			}
+			lodSlice.rangeCount = (int)m_ranges.size() - lodSlice.firstRange;
+			m_lods.push_back(lodSlice);
+		}
+		m_indexFormat = DXGI_FORMAT_R16_UINT;
+	}
+	else
+	{
+		m_indexFormat = DXGI_FORMAT_R32_UINT;
+	}
+
+	// Without a split every submesh of every level of detail is a single range of the shared vertex buffer.
+	if (m_lods.empty())
+	{
+		for (lod = 0; lod < lodCount; lod++)
+		{
+			lodSlice.firstRange = (int)m_ranges.size();
+			for (submesh = lods[lod].firstSubmesh; submesh < (int)(lods[lod].firstSubmesh + lods[lod].submeshCount); submesh++)
+			{
+				range.startIndex = submeshes[submesh].startIndex;
+				range.indexCount = submeshes[submesh].indexCount;
+				range.baseVertex = 0;
+				range.material = submeshes[submesh].material;
+				m_ranges.push_back(range);
+			}
+			lodSlice.rangeCount = (int)m_ranges.size() - lodSlice.firstRange;
+			m_lods.push_back(lodSlice);
+		}
+	}
+
+	for (lod = 0; lod < lodCount; lod++)
+	{
+		m_lodErrors.push_back(lods[lod].error);
+	}
+
+	// The bounding sphere the level of detail error is projected from, around the center of the full precision bounding box.
+	boundsMin = XMVectorReplicate(FLT_MAX);
+	boundsMax = XMVectorReplicate(-FLT_MAX);
+	for (j = 0; j < vertexCount; j++)
+	{
+		position = XMLoadFloat3(&obj_verts[j].position);
+		boundsMin = XMVectorMin(boundsMin, position);
+		boundsMax = XMVectorMax(boundsMax, position);
+	}
+
+	center = XMVectorScale(XMVectorAdd(boundsMin, boundsMax), 0.5f);
+	radiusSq = 0.0f;
+	for (j = 0; j < vertexCount; j++)
+	{
+		position = XMLoadFloat3(&obj_verts[j].position);
+		radiusSq = fmaxf(radiusSq, XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(position, center))));
+	}
+
+	XMStoreFloat3(&m_boundsCenter, center);
+	m_boundsRadius = sqrtf(radiusSq);
+
+	if (!splitVerts.empty())
+	{
+		obj_verts = splitVerts.data();
+		vertexCount = (int)splitVerts.size();
+	}
+
+	shortSource = obj_shortIndices ? obj_shortIndices : shortIndices.data();
+	shortCount = obj_shortIndices ? (size_t)indexCount : shortIndices.size();
+	if (m_indexFormat == DXGI_FORMAT_R16_UINT)
+	{
+		indexSource = shortSource;
+		indexStride = sizeof(uint16_t);
+	}
+	else
+	{
+		indexSource = obj_indices;
+		indexStride = sizeof(uint32_t);
+	}
+
+	// Encode the vertices in the compact format.
+	if (m_vertexFormat != VERTEX_FORMAT_FULL)
+	{
+		compression.EncodeVertices(obj_verts, vertexCount, m_vertexFormat, compactVerts, quantization);
+		vertexSource = compactVerts.data();
+		XMStoreFloat4x4(&m_positionDecode, compression.GetDecodeMatrix(quantization));
+	}
+	else
+	{
+		vertexSource = obj_verts;
+		XMStoreFloat4x4(&m_positionDecode, XMMatrixIdentity());
+	}
+
+	m_vertexStride = compression.GetVertexStride(m_vertexFormat);
+
+	// Cut the ranges of every level of detail into clusters for culling. They are built from the full precision vertices, the
+	// clusters of a split mesh from its range relative 16 bit indices.
+	m_meshlets.clear();
+	if (m_meshletMaxVertices > 0 && m_meshletMaxTriangles > 0)
+	{
+		if (!splitVerts.empty() || !obj_indices)
+		{
+			splitIndices.assign(shortSource, shortSource + shortCount);
+			obj_indices = splitIndices.data();
+		}
+
+		m_meshletCuller.SetLimits(m_meshletMaxVertices, m_meshletMaxTriangles);
+		for (i = 0; i < m_lods.size(); i++)
+		{
+			m_lods[i].firstMeshlet = (int)m_meshlets.size();
+			for (j = 0; j < m_lods[i].rangeCount; j++)
+			{
+				m_meshletCuller.Build(obj_verts, obj_indices, m_ranges[m_lods[i].firstRange + j], m_meshlets);
+			}
+			m_lods[i].meshletCount = (int)m_meshlets.size() - m_lods[i].firstMeshlet;
+		}
+	}
+	else
+	{
+		for (i = 0; i < m_lods.size(); i++)
+		{
+			m_lods[i].firstMeshlet = 0;
+			m_lods[i].meshletCount = 0;
+		}
+	}
+
+	// Until the first Cull the full mesh is drawn.
+	m_visibleRanges.assign(m_ranges.begin(), m_ranges.begin() + m_lods[0].rangeCount);
+	m_visibleDepths.assign(m_visibleRanges.size(), 0.0f);
+
+	// Set the number of vertices in the vertex array.
+	m_vertexCount = vertexCount;
+
+	// Set the number of indices in the index array.
+	m_indexCount = indexCount;
+
+
+	// A pooled model only needs its place in the shared buffers. A 32 bit pool takes 16 bit indices widened, a 16 bit pool can not
+	// take 32 bit ones.
+	if (m_geometryPool && !m_splitStreams && m_geometryPool->GetVertexStride() == m_vertexStride &&
+		(m_geometryPool->GetIndexFormat() == m_indexFormat || m_geometryPool->GetIndexFormat() == DXGI_FORMAT_R32_UINT))
+	{
+		if (m_geometryPool->GetIndexFormat() != m_indexFormat)
+		{
+			splitIndices.assign(shortSource, shortSource + shortCount);
+			indexSource = splitIndices.data();
+		}
+
+		m_poolHandle = m_geometryPool->Allocate(device, vertexSource, m_vertexCount, indexSource, m_indexCount);
+		if (m_poolHandle != GEOMETRY_POOL_HANDLE_NONE)
+		{
+			return true;
+		}
+
+		printf("Could not fit the model into the geometry pool, it gets buffers of its own\n");
+	}
+
+	// With the vertex array and index array filled out we can now use those to create the vertex buffer and index buffer.
+	// Creating both buffers is done in the same fashion.
+	// First, fill out a description of the buffer.
+	// In the description the ByteWidth(size of the buffer) and the BindFlags(type of buffer) are what you need to ensure are filled out correctly.
+	// After the description is filled out you need to also fill out a subresource pointer which will point to either your vertex or index array you previously created.
+	// With the description and subresource pointer you can call CreateBuffer using the D3D device and it will return a pointer to your new buffer.
+
+	// Create the vertex buffer, or the position and attribute buffers when the streams are split.
+	if (!InitializeVertexBuffers(device, vertexSource))
+	{
+		return false;
 	}
 
 	// Set up the description of the static index buffer.
-	indexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-	indexBufferDesc.ByteWidth = sizeof(unsigned long) * m_indexCount;
-	indexBufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
-	indexBufferDesc.CPUAccessFlags = 0;
-	indexBufferDesc.MiscFlags = 0;
-	indexBufferDesc.StructureByteStride = 0;
-
-	// Give the subresource structure a pointer to the index data.
-	indexData.pSysMem = obj_indices.data();
-	indexData.SysMemPitch = 0;
-	indexData.SysMemSlicePitch = 0;
-
-	// Create the index buffer.
-	result = device->CreateBuffer(&indexBufferDesc, &indexData, &m_indexBuffer);
-	if (FAILED(result))
+	indexBufferDesc.bind = RENDER_BIND_INDEX_BUFFER;
+	indexBufferDesc.usage = RENDER_USAGE_DEFAULT;
+	indexBufferDesc.byteWidth = indexStride * m_indexCount;
+
+	// Create the index buffer from the index data.
+	result = device->CreateBuffer(indexBufferDesc, indexSource, m_indexBuffer);
+	if (!result)
 	{
 		return false;
 	}
-	// After the vertex and index buffers have been created, you can delete the vertex and index arrays as they are no longer needed, since the data was copied into the buffers.
+	// After the vertex and index buffers have been created the data has been copied into them.
+	// The arrays belong to the caller, a vector or the mapped mesh cache, or are the encoded copies that go out of scope here.
 
-	// Release the arrays now that the vertex and index buffers have been created and loaded.
-	// Not sure if this is needed
+	return true;
+}
+
+// InitializeProgressive opens the .dxpm stream of an OBJ model, building it first when it is missing or no longer matches the OBJ,
+// and creates buffers of the full size with only its base mesh in them.
+bool ModelClass::InitializeProgressive(RenderDeviceClass* device, const char* modelFileName, OUT MeshMaterialListType& materials)
+{
+	std::string streamFileName;
+	bool result;
+
+
+	streamFileName = ProgressiveMeshClass::GetStreamFilename(modelFileName);
+	result = m_progressive.Initialize(streamFileName.c_str(), modelFileName);
+	if (!result)
+	{
+		result = BuildProgressive(modelFileName, streamFileName.c_str());
+		if (!result)
+		{
+			return false;
+		}
+
+		result = m_progressive.Initialize(streamFileName.c_str(), modelFileName);
+		if (!result)
+		{
+			return false;
+		}
+	}
+
+	m_progressive.GetMaterials(materials);
+
+	result = InitializeProgressiveBuffers(device);
+	if (!result)
+	{
+		m_progressive.Shutdown();
+		ShutdownBuffers();
+		return false;
+	}
 
 	return true;
 }
 
-bool ModelClass::LoadTexture(ID3D11Device* device, const wchar_t* filename)
+// BuildProgressive writes the .dxpm stream from the finest level of detail of the model, taken from the mesh cache when it is
+// current and from the OBJ file otherwise, which also writes the cache.
+bool ModelClass::BuildProgressive(const char* modelFileName, const char* streamFileName)
+{
+	MeshCacheClass cache;
+	ProgressiveMeshClass progressive;
+	std::vector<VertexType> verts;
+	std::vector<uint32_t> indices;
+	std::vector<MeshLodType> lods;
+	std::vector<MeshSubmeshType> submeshes;
+	MeshMaterialListType materials;
+	std::string cacheFileName;
+	unsigned int i;
+	bool result;
+
+
+	cacheFileName = MeshCacheClass::GetCacheFilename(modelFileName);
+	if (cache.Initialize(cacheFileName.c_str(), modelFileName))
+	{
+		verts.assign(cache.GetVertices(), cache.GetVertices() + cache.GetVertexCount());
+		indices.assign(cache.GetIndices(), cache.GetIndices() + cache.GetIndexCount());
+		lods.assign(cache.GetLods(), cache.GetLods() + cache.GetLodCount());
+		submeshes.assign(cache.GetSubmeshes(), cache.GetSubmeshes() + cache.GetSubmeshCount());
+		cache.GetMaterials(materials);
+		cache.Shutdown();
+	}
+	else
+	{
+		result = LoadOBJ(modelFileName, verts, indices, lods, submeshes, materials);
+		if (!result)
+		{
+			return false;
+		}
+
+		if (!MeshCacheClass::Write(cacheFileName.c_str(), modelFileName, verts, indices, lods, submeshes, materials))
+		{
+			printf("Could not write the mesh cache %s\n", cacheFileName.c_str());
+		}
+	}
+
+	if (lods.empty())
+	{
+		return false;
+	}
+
+	// Only the finest level goes into the stream, with its submeshes moved to the start of its own index array.
+	indices.erase(indices.begin() + lods[0].startIndex + lods[0].indexCount, indices.end());
+	indices.erase(indices.begin(), indices.begin() + lods[0].startIndex);
+	submeshes.erase(submeshes.begin() + lods[0].firstSubmesh + lods[0].submeshCount, submeshes.end());
+	submeshes.erase(submeshes.begin(), submeshes.begin() + lods[0].firstSubmesh);
+	for (i = 0; i < submeshes.size(); i++)
+	{
+		submeshes[i].startIndex -= lods[0].startIndex;
+	}
+
+	result = progressive.Build(verts, indices, submeshes, materials);
+	if (!result)
+	{
+		return false;
+	}
+
+	return progressive.Write(streamFileName, modelFileName);
+}
+
+// InitializeProgressiveBuffers creates the vertex and index buffers with room for the full mesh and uploads what the loader has so far.
+// Every submesh is one range of the shared vertex buffer at the start of its slot, and there is a single level of detail without
+// clusters: the splits change the index buffer in place, which neither the 16 bit split of a large mesh nor the meshlets can follow.
+// Compact vertices are quantized to the bounds of the full mesh from the header, so the splits that come later fit the same grid.
+bool ModelClass::InitializeProgressiveBuffers(RenderDeviceClass* device)
+{
+	RenderDeviceClass::BufferDescType indexBufferDesc;
+	bool result;
+	MeshCompressionClass compression;
+	std::vector<CompactVertexType> compactVerts;
+	std::vector<uint16_t> shortIndices;
+	const void* vertexSource;
+	const void* indexSource;
+	unsigned int indexStride;
+	IndexRangeType range;
+	LodRangesType lodSlice;
+	XMFLOAT3 boundsMin, boundsMax;
+	XMVECTOR minVector, maxVector;
+	unsigned int i;
+
+
+	m_submeshes.assign(m_progressive.GetSubmeshes(), m_progressive.GetSubmeshes() + m_progressive.GetSubmeshCount());
+
+	m_ranges.clear();
+	for (i = 0; i < m_submeshes.size(); i++)
+	{
+		range.startIndex = m_submeshes[i].startIndex;
+		range.indexCount = m_submeshes[i].indexCount;
+		range.baseVertex = 0;
+		range.material = m_submeshes[i].material;
+		m_ranges.push_back(range);
+	}
+
+	lodSlice.firstRange = 0;
+	lodSlice.rangeCount = (int)m_ranges.size();
+	lodSlice.firstMeshlet = 0;
+	lodSlice.meshletCount = 0;
+	m_lods.assign(1, lodSlice);
+	m_lodErrors.assign(1, m_progressive.GetError());
+	m_meshlets.clear();
+
+	// The bounding sphere of the full mesh is the one around its bounding box, the vertices are not all there to fit a tighter one.
+	m_progressive.GetBounds(boundsMin, boundsMax);
+	minVector = XMLoadFloat3(&boundsMin);
+	maxVector = XMLoadFloat3(&boundsMax);
+	XMStoreFloat3(&m_boundsCenter, XMVectorScale(XMVectorAdd(minVector, maxVector), 0.5f));
+	m_boundsRadius = 0.5f * XMVectorGetX(XMVector3Length(XMVectorSubtract(maxVector, minVector)));
+
+	// The arrays of the loader have the full size already, with the slots the splits have not reached yet zero.
+	m_vertexCount = (int)m_progressive.GetVertexCapacity();
+	m_indexCount = (int)m_progressive.GetIndexCapacity();
+
+	if (compression.NarrowIndices(m_progressive.GetIndices(), m_indexCount, m_vertexCount, shortIndices))
+	{
+		m_indexFormat = DXGI_FORMAT_R16_UINT;
+		indexSource = shortIndices.data();
+		indexStride = sizeof(uint16_t);
+	}
+	else
+	{
+		m_indexFormat = DXGI_FORMAT_R32_UINT;
+		indexSource = m_progressive.GetIndices();
+		indexStride = sizeof(uint32_t);
+	}
+
+	if (m_vertexFormat != VERTEX_FORMAT_FULL)
+	{
+		m_quantization.boundsMin = boundsMin;
+		m_quantization.boundsExtent = XMFLOAT3(boundsMax.x - boundsMin.x, boundsMax.y - boundsMin.y, boundsMax.z - boundsMin.z);
+		compression.EncodeVertices(m_progressive.GetVertices(), m_vertexCount, m_vertexFormat, m_quantization, compactVerts);
+
+		vertexSource = compactVerts.data();
+		XMStoreFloat4x4(&m_positionDecode, compression.GetDecodeMatrix(m_quantization));
+	}
+	else
+	{
+		vertexSource = m_progressive.GetVertices();
+		XMStoreFloat4x4(&m_positionDecode, XMMatrixIdentity());
+	}
+
+	m_vertexStride = compression.GetVertexStride(m_vertexFormat);
+
+	// Until the first Cull the base mesh is drawn.
+	m_visibleRanges = m_ranges;
+	m_visibleDepths.assign(m_visibleRanges.size(), 0.0f);
+
+	// Both buffers are updated in place by Refine, so they are default buffers of the full size.
+	if (!InitializeVertexBuffers(device, vertexSource))
+	{
+		return false;
+	}
+
+	indexBufferDesc.bind = RENDER_BIND_INDEX_BUFFER;
+	indexBufferDesc.usage = RENDER_USAGE_DEFAULT;
+	indexBufferDesc.byteWidth = indexStride * m_indexCount;
+
+	result = device->CreateBuffer(indexBufferDesc, indexSource, m_indexBuffer);
+	if (!result)
+	{
+		return false;
+	}
+
+	// The base is in the buffers now, Refine uploads what changes after it.
+	m_progressive.ClearDirty();
+
+	return true;
+}
+
+bool ModelClass::LoadTexture(RenderDeviceClass* device, const wchar_t* filename)
 {
 	bool result;
 
@@ -299,6 +1247,29 @@ bool ModelClass::LoadTexture(ID3D11Device* device, const wchar_t* filename)
 	return true;
 }
 
+// This LoadTexture creates the texture from an image file held in memory, such as one embedded in a .glb file.
+bool ModelClass::LoadTexture(RenderDeviceClass* device, const unsigned char* data, size_t size)
+{
+	bool result;
+
+
+	// Create the texture object.
+	m_Texture = new TextureClass;
+	if (!m_Texture)
+	{
+		return false;
+	}
+
+	// Initialize the texture object.
+	result = m_Texture->Initialize(device, data, size);
+	if (!result)
+	{
+		return false;
+	}
+
+	return true;
+}
+
 void ModelClass::ReleaseTexture()
 {
 	// Release the texture object.
@@ -312,96 +1283,389 @@ void ModelClass::ReleaseTexture()
 	return;
 }
 
-bool ModelClass::LoadOBJ(const char* filename, OUT std::vector<VertexType>& out_verts, OUT std::vector<unsigned long>& obj_indices)
+// LoadMaterials reads the .mtl files the OBJ names, next to the OBJ, and gives every material the texture of its map_Kd. The textures
+// come from the texture cache so a file several materials share is loaded once. Materials that have no map, are not defined in any
+// library or whose map does not load are drawn with the model's texture. None of that is an error, the model just looks plainer.
+void ModelClass::LoadMaterials(RenderDeviceClass* device, const char* modelFileName, const MeshMaterialListType& materials)
 {
-	FILE* f = nullptr;
-	bool res = fopen_s(&f, filename, "r");
-	std::vector< unsigned int > vertexIndices, uvIndices, normalIndices;
-	std::vector<XMFLOAT3> verts;
-	std::vector<XMFLOAT2> uvs;
-	std::vector<XMFLOAT3> norms;
-	if (res == 0) {
-		printf("The file %s was opened\n",filename);
+	MtlParserClass parser;
+	std::vector<MtlParserClass::MaterialType> definitions;
+	std::unordered_map<std::string, std::string> diffuseMaps;
+	std::filesystem::path folder, library;
+	TextureClass* texture;
+	size_t i;
+
+
+	m_materials = materials;
+	folder = std::filesystem::path(modelFileName).parent_path();
+	for (i = 0; i < materials.libraries.size(); i++)
+	{
+		library = folder / materials.libraries[i];
+		if (!parser.Parse(library.string().c_str(), definitions))
+		{
+			printf("Could not read the material library %s\n", library.string().c_str());
+		}
+	}
+
+	// The first definition of a name wins, like it does for the OBJ exporters that write the same material to several libraries.
+	for (i = 0; i < definitions.size(); i++)
+	{
+		diffuseMaps.emplace(definitions[i].name, definitions[i].diffuseMap);
+	}
+
+	m_materialTextures.assign(materials.names.size(), m_Texture);
+	for (i = 0; i < materials.names.size(); i++)
+	{
+		auto found = diffuseMaps.find(materials.names[i]);
+		if (found == diffuseMaps.end() || found->second.empty())
+		{
+			continue;
+		}
+
+		texture = m_textureCache.GetTexture(device, std::filesystem::path(found->second).wstring().c_str());
+		if (!texture)
+		{
+			printf("Could not load the texture %s of material %s, using the default texture\n", found->second.c_str(), materials.names[i].c_str());
+			continue;
+		}
+		m_materialTextures[i] = texture;
+	}
+
+	return;
+}
+
+// InitializeGLTF uploads the meshes of a glTF model from the GltfLoaderClass, which hands out the vertex and index data in place
+// wherever its layout already matches. Such files come out of an exporter that has optimized them, so unlike an OBJ they are
+// neither optimized nor simplified here and are drawn with a single level of detail, one submesh per primitive. Every base color
+// image the primitives use is a material of its own, material 0 is the given texture for those without an image or whose image
+// does not load.
+bool ModelClass::InitializeGLTF(RenderDeviceClass* device, const char* modelFileName, const wchar_t* textureFilename)
+{
+	GltfLoaderClass loader;
+	const VertexType* verts;
+	const void* indices;
+	unsigned int vertexCount, indexCount, indexStride;
+	std::vector<GltfLoaderClass::RangeType> ranges;
+	std::vector<MeshSubmeshType> submeshes;
+	std::vector<int> imageMaterials, materialImages;
+	MeshLodType lod;
+	MeshSubmeshType submesh;
+	MeshMaterialListType materials;
+	const GltfLoaderClass::ImageType* source;
+	TextureClass* texture;
+	std::wstring imageName;
+	int image;
+	bool result;
+	size_t i;
+
+
+	result = loader.Initialize(modelFileName);
+	if (!result)
+	{
+		return false;
+	}
+
+	result = loader.GetMesh(verts, vertexCount, indices, indexCount, indexStride, ranges);
+	if (!result || vertexCount > INT_MAX || indexCount > INT_MAX)
+	{
+		loader.Shutdown();
+		return false;
+	}
+
+	materials.names.push_back(std::string());
+	materialImages.push_back(-1);
+	imageMaterials.assign(loader.GetImages().size(), -1);
+	for (i = 0; i < ranges.size(); i++)
+	{
+		image = ranges[i].image;
+		if (image >= 0 && image < (int)imageMaterials.size() && imageMaterials[image] < 0)
+		{
+			imageMaterials[image] = (int)materials.names.size();
+			materials.names.push_back("image " + std::to_string(image));
+			materialImages.push_back(image);
+		}
+
+		submesh.material = image >= 0 && image < (int)imageMaterials.size() ? imageMaterials[image] : 0;
+		submesh.startIndex = ranges[i].firstIndex;
+		submesh.indexCount = ranges[i].indexCount;
+		submeshes.push_back(submesh);
+	}
+
+	lod.startIndex = 0;
+	lod.indexCount = indexCount;
+	lod.error = 0.0f;
+	lod.firstSubmesh = 0;
+	lod.submeshCount = (unsigned int)submeshes.size();
+	if (indexStride == sizeof(uint16_t))
+	{
+		result = InitializeOBJBuffers(device, verts, (int)vertexCount, 0, (const uint16_t*)indices, (int)indexCount, &lod, 1, submeshes.data(),
+			(int)submeshes.size());
 	}
-	else {
-		printf("File opening failed for %s\n", filename);
+	else
+	{
+		result = InitializeOBJBuffers(device, verts, (int)vertexCount, (const uint32_t*)indices, 0, (int)indexCount, &lod, 1, submeshes.data(),
+			(int)submeshes.size());
+	}
+	if (!result)
+	{
+		loader.Shutdown();
 		return false;
 	}
-	fseek(f, 0L, SEEK_SET);
-	while (1) {
-
-		char lineHeader[128];
-		// read the first word of the line
-		int res = fscanf_s(f, "%s", lineHeader, 128);
-		if (res == EOF)
-			break; // EOF = End Of File. Quit the loop.
-		if (strcmp(lineHeader, "v") == 0) {
-			XMFLOAT3 vertex;
-			fscanf_s(f, "%f %f %f\n", &vertex.x, &vertex.y, &vertex.z);
-			verts.push_back(vertex);
-		}
-		else if (strcmp(lineHeader, "vt") == 0) {
-			XMFLOAT2 uv;
-			fscanf_s(f, "%f %f\n", &uv.x, &uv.y);
-			uvs.push_back(uv);
-		}
-		else if (strcmp(lineHeader, "vn") == 0) {
-			XMFLOAT3 normal;
-			fscanf_s(f, "%f %f %f\n", &normal.x, &normal.y, &normal.z);
-			norms.push_back(normal);
-		}
-		else if (strcmp(lineHeader, "f") == 0) {
-			std::string vertex1, vertex2, vertex3;
-			unsigned int vertexIndex[3], uvIndex[3], normalIndex[3];
-			int matches = fscanf_s(f, "%d/%d/%d %d/%d/%d %d/%d/%d\n", &vertexIndex[0], &uvIndex[0], &normalIndex[0], &vertexIndex[1], &uvIndex[1], &normalIndex[1], &vertexIndex[2], &uvIndex[2], &normalIndex[2]);
-			if (matches != 9) {
-				printf("File can't be read by our simple parser : ( Try exporting with other options\n");
-				return false;
+
+	result = LoadTexture(device, textureFilename);
+	if (!result)
+	{
+		loader.Shutdown();
+		return false;
+	}
+
+	// Embedded images are cached under the model's name and their index, external ones by their file like the maps of an OBJ.
+	m_materials = materials;
+	m_materialTextures.assign(materials.names.size(), m_Texture);
+	for (i = 1; i < materialImages.size(); i++)
+	{
+		source = &loader.GetImages()[materialImages[i]];
+		if (source->data)
+		{
+			imageName = Utf8ToWide(std::string(modelFileName) + "#" + materials.names[i]);
+			texture = m_textureCache.GetTexture(device, imageName.c_str(), source->data, source->size);
+		}
+		else if (!source->filename.empty())
+		{
+			imageName = Utf8ToWide(source->filename);
+			texture = m_textureCache.GetTexture(device, imageName.c_str());
+		}
+		else
+		{
+			texture = 0;
+		}
+
+		if (!texture)
+		{
+			printf("Could not load image %d of %s, using the default texture\n", materialImages[i], modelFileName);
+			continue;
+		}
+		m_materialTextures[i] = texture;
+	}
+
+	loader.Shutdown();
+
+	return true;
+}
+
+// LoadOBJ parses the file with the memory mapped ObjParserClass, welds the face corners into an indexed mesh, groups its triangles
+// by material and optimizes their order. The coarser levels of detail are then simplified one from the other and appended to the
+// index buffer, all sharing the vertices. Every submesh is simplified by itself so its triangles stay with their material.
+bool ModelClass::LoadOBJ(const char* filename, OUT std::vector<VertexType>& out_verts, OUT std::vector<uint32_t>& obj_indices,
+	OUT std::vector<MeshLodType>& out_lods, OUT std::vector<MeshSubmeshType>& out_submeshes, OUT MeshMaterialListType& out_materials)
+{
+	ObjParserClass parser;
+	ObjParserClass::ObjDataType obj;
+	MeshSimplifierClass simplifier;
+	std::vector<uint32_t> submeshIndices, simplifiedIndices, lodIndices;
+	std::vector<MeshSubmeshType> lodSubmeshes;
+	MeshLodType lod, previousLod;
+	MeshSubmeshType submesh;
+	float scale, levelError;
+	unsigned int targetIndexCount, i;
+	int level;
+	bool result;
+
+
+	// Let the parser spread large files over every hardware thread.
+	parser.SetThreadCount(0);
+	result = parser.Parse(filename, obj);
+	if (!result)
+	{
+		printf("File can't be read by our simple parser : ( Try exporting with other options\n");
+		return false;
+	}
+
+	// Give the corners that were written without a normal, the v and v/vt forms, smooth normals split at creases.
+	MeshNormalClass normals;
+	normals.SetCreaseAngle(MODEL_NORMAL_CREASE_ANGLE);
+	normals.SetThreadCount(0);
+	if (!normals.GenerateNormals(obj.positions, obj.positionIndices, obj.normals, obj.normalIndices))
+	{
+		printf("File %s references vertex data it does not contain\n", filename);
+		return false;
+	}
+
+	// Weld the face corners into unique vertices so the index buffer actually shares corners between triangles.
+	MeshWeldClass weld;
+	weld.SetTolerance(MODEL_WELD_TOLERANCE);
+	weld.SetRemoveDegenerates(true);
+	if (!weld.Weld(obj.positions, obj.uvs, obj.normals, obj.positionIndices, obj.uvIndices, obj.normalIndices, out_verts, obj_indices,
+		&obj.triangleMaterials))
+	{
+		printf("File %s references vertex data it does not contain\n", filename);
+		return false;
+	}
+
+	// Reorder the welded mesh for the vertex cache, overdraw and vertex fetch before it is uploaded.
+	MeshOptimizerClass optimizer;
+
+	// Every material becomes one run of the index buffer that is drawn with a single DrawIndexed, the optimizer keeps to the runs.
+	out_materials = obj.materials;
+	optimizer.GroupByMaterial(obj_indices, obj.triangleMaterials, (unsigned int)out_materials.names.size(), out_submeshes);
+
+	optimizer.Optimize(out_verts, obj_indices, out_submeshes);
+
+	// The full mesh is the first level of detail. Each coarser level starts from the one before, so its error in model units is
+	// the sum of the relative errors of every step scaled by the mesh size. The error of a step is the largest of its submeshes.
+	out_lods.clear();
+	lod.startIndex = 0;
+	lod.indexCount = (unsigned int)obj_indices.size();
+	lod.error = 0.0f;
+	lod.firstSubmesh = 0;
+	lod.submeshCount = (unsigned int)out_submeshes.size();
+	out_lods.push_back(lod);
+
+	scale = simplifier.GetScale(out_verts);
+	for (level = 1; level < MODEL_LOD_MAX_LEVELS; level++)
+	{
+		previousLod = out_lods.back();
+		lodIndices.clear();
+		lodSubmeshes.clear();
+		levelError = 0.0f;
+		for (i = previousLod.firstSubmesh; i < previousLod.firstSubmesh + previousLod.submeshCount; i++)
+		{
+			submesh = out_submeshes[i];
+			submeshIndices.assign(obj_indices.begin() + submesh.startIndex, obj_indices.begin() + submesh.startIndex + submesh.indexCount);
+
+			targetIndexCount = (unsigned int)(submeshIndices.size() * MODEL_LOD_RATIO) / 3 * 3;
+			levelError = fmaxf(levelError, simplifier.Simplify(out_verts, submeshIndices, targetIndexCount, MODEL_LOD_MAX_ERROR, simplifiedIndices));
+			if (simplifiedIndices.empty())
+			{
+				continue;
 			}
-			vertexIndices.push_back(vertexIndex[0]);
-			vertexIndices.push_back(vertexIndex[1]);
-			vertexIndices.push_back(vertexIndex[2]);
-			uvIndices.push_back(uvIndex[0]);
-			uvIndices.push_back(uvIndex[1]);
-			uvIndices.push_back(uvIndex[2]);
-			normalIndices.push_back(normalIndex[0]);
-			normalIndices.push_back(normalIndex[1]);
-			normalIndices.push_back(normalIndex[2]);
-		}
-	}
-	for (unsigned int i = 0; i < vertexIndices.size(); i++) {
-		VertexType v;
-		v.position = verts[vertexIndices[i]-1];
-		v.texture = uvs[uvIndices[i]-1];
-		v.normal = norms[normalIndices[i]-1];
-		out_verts.push_back(v);
-	}
-	// [NOTE] This could be unnecessary/redundant, we could probably grab them from above - need to see how DX11 handles this sort of thing
-	for (unsigned int i = 0; i < vertexIndices.size(); i++) {
-		unsigned long vInd;
-		//vInd = vertexIndices[i];
-		vInd = unsigned long(i);
-		obj_indices.push_back(vInd);
+
+			// Collapsing leaves the triangles in their old order with holes in the reuse, so sort them for the vertex cache again.
+			optimizer.OptimizeVertexCache(simplifiedIndices, (unsigned int)out_verts.size());
+
+			submesh.startIndex = (unsigned int)(obj_indices.size() + lodIndices.size());
+			submesh.indexCount = (unsigned int)simplifiedIndices.size();
+			lodSubmeshes.push_back(submesh);
+			lodIndices.insert(lodIndices.end(), simplifiedIndices.begin(), simplifiedIndices.end());
+		}
+
+		if (lodIndices.empty() || lodIndices.size() > previousLod.indexCount * MODEL_LOD_MIN_REDUCTION)
+		{
+			break;
+		}
+
+		lod.startIndex = (unsigned int)obj_indices.size();
+		lod.indexCount = (unsigned int)lodIndices.size();
+		lod.error = previousLod.error + levelError * scale;
+		lod.firstSubmesh = (unsigned int)out_submeshes.size();
+		lod.submeshCount = (unsigned int)lodSubmeshes.size();
+		out_lods.push_back(lod);
+		out_submeshes.insert(out_submeshes.end(), lodSubmeshes.begin(), lodSubmeshes.end());
+		obj_indices.insert(obj_indices.end(), lodIndices.begin(), lodIndices.end());
 	}
 
 	return true;
 }
 
+// InitializeVertexBuffers creates the default vertex buffers for m_vertexCount vertices of m_vertexFormat: one interleaved buffer, or
+// a position buffer and an attribute buffer when the streams are split.
+bool ModelClass::InitializeVertexBuffers(RenderDeviceClass* device, const void* vertexSource)
+{
+	RenderDeviceClass::BufferDescType vertexBufferDesc;
+	bool result;
+	MeshCompressionClass compression;
+	std::vector<uint8_t> positions, attributes;
+
+
+	vertexBufferDesc.bind = RENDER_BIND_VERTEX_BUFFER;
+	vertexBufferDesc.usage = RENDER_USAGE_DEFAULT;
+
+	if (!m_splitStreams)
+	{
+		vertexBufferDesc.byteWidth = m_vertexStride * m_vertexCount;
+
+		result = device->CreateBuffer(vertexBufferDesc, vertexSource, m_vertexBuffer);
+		if (!result)
+		{
+			return false;
+		}
+
+		return true;
+	}
+
+	m_positionStride = compression.GetPositionStride(m_vertexFormat);
+	m_attributeStride = compression.GetAttributeStride(m_vertexFormat);
+	compression.SplitStreams(vertexSource, m_vertexCount, m_vertexFormat, positions, attributes);
+
+	vertexBufferDesc.byteWidth = m_positionStride * m_vertexCount;
+
+	result = device->CreateBuffer(vertexBufferDesc, positions.data(), m_vertexBuffer);
+	if (!result)
+	{
+		return false;
+	}
+
+	vertexBufferDesc.byteWidth = m_attributeStride * m_vertexCount;
+
+	result = device->CreateBuffer(vertexBufferDesc, attributes.data(), m_attributeBuffer);
+	if (!result)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+// UpdateVertexBuffers overwrites count interleaved vertices from start on, splitting them first when the streams are split.
+void ModelClass::UpdateVertexBuffers(RenderDeviceClass* device, const void* vertexSource, unsigned int start, unsigned int count)
+{
+	MeshCompressionClass compression;
+
+
+	if (!m_splitStreams)
+	{
+		device->UpdateBuffer(m_vertexBuffer, start * m_vertexStride, vertexSource, count * m_vertexStride);
+
+		return;
+	}
+
+	compression.SplitStreams(vertexSource, count, m_vertexFormat, m_uploadPositions, m_uploadAttributes);
+
+	device->UpdateBuffer(m_vertexBuffer, start * m_positionStride, m_uploadPositions.data(), count * m_positionStride);
+	device->UpdateBuffer(m_attributeBuffer, start * m_attributeStride, m_uploadAttributes.data(), count * m_attributeStride);
+
+	return;
+}
+
 // The ShutdownBuffers function just releases the vertex and index buffers that were created in the InitializeBuffers function.
 void ModelClass::ShutdownBuffers()
 {
+	// Give the model's place in the geometry pool back.
+	if (m_poolHandle != GEOMETRY_POOL_HANDLE_NONE)
+	{
+		m_geometryPool->Free(m_poolHandle);
+		m_poolHandle = GEOMETRY_POOL_HANDLE_NONE;
+	}
+
 	// Release the index buffer.
 	if (m_indexBuffer)
 	{
-		m_indexBuffer->Release();
-		m_indexBuffer = 0;
+		m_device->ReleaseBuffer(m_indexBuffer);
+		m_indexBuffer = RENDER_HANDLE_NONE;
+	}
+
+	// Release the attribute buffer of split streams.
+	if (m_attributeBuffer)
+	{
+		m_device->ReleaseBuffer(m_attributeBuffer);
+		m_attributeBuffer = RENDER_HANDLE_NONE;
 	}
 
 	// Release the vertex buffer.
 	if (m_vertexBuffer)
 	{
-		m_vertexBuffer->Release();
-		m_vertexBuffer = 0;
+		m_device->ReleaseBuffer(m_vertexBuffer);
+		m_vertexBuffer = RENDER_HANDLE_NONE;
 	}
 
 	return;
@@ -412,25 +1676,39 @@ void ModelClass::ShutdownBuffers()
 // Once the GPU has an active vertex buffer it can then use the shader to render that buffer.
 // This function also defines how those buffers should be drawn such as triangles, lines, fans, and so forth.
 // In this tutorial we set the vertex and index buffers as active on the input assembler,
-// and tell the GPU that the buffers should be drawn as triangles using the IASetPrimitiveTopology DirectX function.
-void ModelClass::RenderBuffers(ID3D11DeviceContext* deviceContext)
+// the render device draws everything as triangles.
+void ModelClass::RenderBuffers(RenderDeviceClass* device, unsigned int streams)
 {
-	unsigned int stride;
-	unsigned int offset;
+	unsigned int buffers[2];
+	unsigned int strides[2];
+	unsigned int offsets[2];
+	unsigned int bufferCount;
 
 
 	// Set vertex buffer stride and offset.
-	stride = sizeof(VertexType);
-	offset = 0;
+	buffers[0] = m_vertexBuffer;
+	strides[0] = m_vertexStride;
+	offsets[0] = 0;
+	bufferCount = 1;
+
+	// Split streams put the positions in slot 0 and the attributes in slot 1, a pass that does not read the attributes leaves slot 1 alone.
+	if (m_splitStreams)
+	{
+		strides[0] = m_positionStride;
+		if (streams & VERTEX_STREAM_ATTRIBUTES)
+		{
+			buffers[1] = m_attributeBuffer;
+			strides[1] = m_attributeStride;
+			offsets[1] = 0;
+			bufferCount = 2;
+		}
+	}
 
 	// Set the vertex buffer to active in the input assembler so it can be rendered.
-	deviceContext->IASetVertexBuffers(0, 1, &m_vertexBuffer, &stride, &offset);
+	device->SetVertexBuffers(0, bufferCount, buffers, strides, offsets);
 
 	// Set the index buffer to active in the input assembler so it can be rendered.
-	deviceContext->IASetIndexBuffer(m_indexBuffer, DXGI_FORMAT_R32_UINT, 0);
-
-	// Set the type of primitive that should be rendered from this vertex buffer, in this case triangles.
-	deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	device->SetIndexBuffer(m_indexBuffer, m_indexFormat, 0);
 
 	return;
 }
\ No newline at end of file
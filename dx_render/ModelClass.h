@@ -8,13 +8,20 @@
 //////////////
 // INCLUDES //
 //////////////
-#include <d3d11.h>
 #include <DirectXMath.h>
 
 ///////////////////////
 // MY CLASS INCLUDES //
 ///////////////////////
+#include "renderdeviceclass.h"
 #include "textureclass.h"
+#include "texturecacheclass.h"
+#include "meshtypes.h"
+#include "meshcompressionclass.h"
+#include "meshletclass.h"
+#include "lodselectorclass.h"
+#include "progressiveloaderclass.h"
+#include "geometrypoolclass.h"
 
 using namespace DirectX;
 
@@ -34,11 +41,14 @@ private:
 		XMFLOAT4 color;
 	};*/
 
-	struct VertexType
+	// The vertex type is now shared with the mesh processing classes, see meshtypes.h.
+	typedef ::VertexType VertexType;
+
+	// The ranges and clusters of one level of detail, as slices of m_ranges and m_meshlets. Its ranges are grouped by submesh.
+	struct LodRangesType
 	{
-		XMFLOAT3 position;
-		XMFLOAT2 texture;
-		XMFLOAT3 normal;
+		int firstRange, rangeCount;
+		int firstMeshlet, meshletCount;
 	};
 
 public:
@@ -49,31 +59,125 @@ public:
 	// The functions here handle initializing and shutdown of the model's vertex and index buffers.
 	// The Render function puts the model geometry on the video card to prepare it for drawing by the color shader.
 
-	bool Initialize(ID3D11Device*, const char* modelFileName, const wchar_t* textureFilename);
+	void SetVertexFormat(VertexFormatType, bool splitLargeMeshes);
+	void SetSplitStreams(bool enabled);
+	void SetMeshletLimits(unsigned int maxVertices, unsigned int maxTriangles);
+	void SetLodThreshold(float pixelError, float hysteresis);
+	void SetProgressive(bool enabled, unsigned int refineBytesPerFrame);
+	void SetGeometryPool(GeometryPoolClass*);
+	bool Initialize(RenderDeviceClass*, const char* modelFileName, const wchar_t* textureFilename);
 	void Shutdown();
-	void Render(ID3D11DeviceContext*);
+	void Render(RenderDeviceClass*);
+	void Render(RenderDeviceClass*, unsigned int streams);
+	void Refine(RenderDeviceClass*);
 
 	int GetIndexCount();
-
-	ID3D11ShaderResourceView* GetTexture();
+	int GetRangeCount();
+	IndexRangeType GetRange(int);
+	int GetLodRangeCount(int lod);
+	IndexRangeType GetLodRange(int lod, int index);
+	void GetBounds(OUT XMFLOAT3& center, OUT float& radius);
+	void GetInputLayout(unsigned int streams, OUT const VertexElementDescType*& layout, OUT unsigned int& elementCount);
+	void GetPositionDecodeMatrix(OUT XMMATRIX&);
+
+	void Cull(XMMATRIX worldMatrix, XMMATRIX viewMatrix, XMMATRIX projectionMatrix, int screenHeight);
+	int GetVisibleRangeCount();
+	IndexRangeType GetVisibleRange(int);
+	float GetVisibleRangeDepth(int);
+	MeshletClass::CullStatsType GetCullStats();
+	int GetLod();
+	int GetLodCount();
+
+	int GetSubmeshCount();
+	MeshSubmeshType GetSubmesh(int);
+	int GetMaterialCount();
+	const char* GetMaterialName(unsigned int material);
+
+	unsigned int GetTexture();
+	unsigned int GetMaterialTexture(unsigned int material);
 
 private:
-	bool InitializeBuffers(ID3D11Device*);
-	bool InitializeOBJBuffers(ID3D11Device*,std::vector<VertexType> & obj_verts,std::vector<unsigned long>& obj_indices);
+	bool InitializeBuffers(RenderDeviceClass*);
+	bool InitializeOBJBuffers(RenderDeviceClass*, const VertexType* obj_verts, int vertexCount, const uint32_t* obj_indices,
+		const uint16_t* obj_shortIndices, int indexCount, const MeshLodType* lods, int lodCount, const MeshSubmeshType* submeshes, int submeshCount);
+	bool InitializeGLTF(RenderDeviceClass*, const char* modelFileName, const wchar_t* textureFilename);
+	bool InitializeProgressive(RenderDeviceClass*, const char* modelFileName, OUT MeshMaterialListType& materials);
+	bool InitializeProgressiveBuffers(RenderDeviceClass*);
+	bool BuildProgressive(const char* modelFileName, const char* streamFileName);
+	bool InitializeVertexBuffers(RenderDeviceClass*, const void* vertexSource);
+	void UpdateVertexBuffers(RenderDeviceClass*, const void* vertexSource, unsigned int start, unsigned int count);
 	void ShutdownBuffers();
-	void RenderBuffers(ID3D11DeviceContext*);
+	void RenderBuffers(RenderDeviceClass*, unsigned int streams);
 
-	bool LoadTexture(ID3D11Device*, const wchar_t*);
+	bool LoadTexture(RenderDeviceClass*, const wchar_t*);
+	bool LoadTexture(RenderDeviceClass*, const unsigned char* data, size_t size);
 	void ReleaseTexture();
-	bool LoadOBJ(const char* filename,OUT std::vector<VertexType> & out_verts, OUT std::vector<unsigned long>& out_indices);
+	void LoadMaterials(RenderDeviceClass*, const char* modelFileName, const MeshMaterialListType& materials);
+	bool LoadOBJ(const char* filename,OUT std::vector<VertexType> & out_verts, OUT std::vector<uint32_t>& out_indices,
+		OUT std::vector<MeshLodType>& out_lods, OUT std::vector<MeshSubmeshType>& out_submeshes, OUT MeshMaterialListType& out_materials);
 	
 	// The private variables in the ModelClass are the vertex and index buffer as well as two integers to keep track of the size of each buffer.
-	// Note that all DirectX 11 buffers generally use the generic ID3D11Buffer type and are more clearly identified by a buffer description when they are first created.
+	// The buffers are handles of the render device the model was initialized on, which they are released through.
 
 private:
-	ID3D11Buffer * m_vertexBuffer, * m_indexBuffer;
+	RenderDeviceClass* m_device;
+	unsigned int m_vertexBuffer, m_indexBuffer;
+	unsigned int m_attributeBuffer;
 	int m_vertexCount, m_indexCount;
 	TextureClass* m_Texture;
+
+	// The layout the vertex buffer was uploaded with and the ranges the index buffer is drawn in.
+	// Every level of detail of a mesh with 16 bit indices that had to be split has one range per split, otherwise it has a single range.
+	VertexFormatType m_vertexFormat;
+	bool m_splitLargeMeshes;
+	unsigned int m_vertexStride;
+	DXGI_FORMAT m_indexFormat;
+	XMFLOAT4X4 m_positionDecode;
+	std::vector<IndexRangeType> m_ranges;
+
+	// With split streams m_vertexBuffer holds only the positions and m_attributeBuffer the rest of every vertex, otherwise
+	// m_vertexBuffer is interleaved and there is no attribute buffer.
+	bool m_splitStreams;
+	unsigned int m_positionStride, m_attributeStride;
+
+	// The clusters of the index buffer and the ranges that survived the last Cull with the view depth of each. Without clusters every
+	// range is visible.
+	unsigned int m_meshletMaxVertices, m_meshletMaxTriangles;
+	MeshletClass m_meshletCuller;
+	std::vector<MeshletType> m_meshlets;
+	std::vector<IndexRangeType> m_visibleRanges;
+	std::vector<float> m_visibleDepths;
+
+	// The levels of detail in the index buffer, finest first, and the bounds their error is projected from to pick one.
+	LodSelectorClass m_lodSelector;
+	std::vector<LodRangesType> m_lods;
+	std::vector<float> m_lodErrors;
+	XMFLOAT3 m_boundsCenter;
+	float m_boundsRadius;
+
+	// The submeshes of every level of detail and the texture of each material. Materials without a texture of their own share m_Texture,
+	// the others point into the texture cache, which loads a file only once however many materials use it.
+	std::vector<MeshSubmeshType> m_submeshes;
+	MeshMaterialListType m_materials;
+	std::vector<TextureClass*> m_materialTextures;
+	TextureCacheClass m_textureCache;
+
+	// A progressive model starts out as the base of its .dxpm stream in buffers sized for the full mesh, and every Refine reads at most
+	// m_refineBytesPerFrame more of it and uploads what changed. It stops once the error is below what the last Cull allowed on screen.
+	bool m_progressiveEnabled;
+	unsigned int m_refineBytesPerFrame;
+	ProgressiveLoaderClass m_progressive;
+	float m_refineErrorLimit;
+	MeshCompressionClass::QuantizationType m_quantization;
+	std::vector<ProgressiveLoaderClass::DirtyRangeType> m_dirtyRanges;
+	std::vector<CompactVertexType> m_uploadVertices;
+	std::vector<uint8_t> m_uploadPositions, m_uploadAttributes;
+	std::vector<uint16_t> m_uploadIndices;
+
+	// The shared buffers an OBJ model is uploaded into instead of its own, and its place in them. The ranges above stay relative to
+	// the mesh, the pool offsets are added when they are handed out because the pool moves meshes as it packs and grows.
+	GeometryPoolClass* m_geometryPool;
+	unsigned int m_poolHandle;
 };
 
 #endif
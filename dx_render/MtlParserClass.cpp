@@ -0,0 +1,163 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: mtlparserclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "mtlparserclass.h"
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+
+
+static bool IsBlank(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+
+static const char* SkipBlanks(const char* p, const char* end)
+{
+	while (p < end && IsBlank(*p))
+	{
+		p++;
+	}
+
+	return p;
+}
+
+// MatchKeyword tells whether the line starts with the keyword followed by a blank or the end of the line.
+static bool MatchKeyword(const char* p, const char* end, const char* keyword)
+{
+	size_t length = strlen(keyword);
+
+
+	return (size_t)(end - p) >= length && memcmp(p, keyword, length) == 0 && (p + length == end || IsBlank(p[length]));
+}
+
+// ReadName returns the rest of the line without the blanks around it, names and file names may contain spaces.
+static std::string ReadName(const char* p, const char* end)
+{
+	p = SkipBlanks(p, end);
+	while (end > p && IsBlank(end[-1]))
+	{
+		end--;
+	}
+
+	return std::string(p, end);
+}
+
+// IsOptionValue tells whether a token is one of the numbers or on/off switches a texture map option takes.
+static bool IsOptionValue(const char* p, const char* end)
+{
+	double value;
+
+
+	if ((end - p == 2 && memcmp(p, "on", 2) == 0) || (end - p == 3 && memcmp(p, "off", 3) == 0))
+	{
+		return true;
+	}
+
+	if (p < end && *p == '+')
+	{
+		p++;
+	}
+
+	std::from_chars_result result = std::from_chars(p, end, value);
+	return result.ec == std::errc() && result.ptr == end;
+}
+
+
+MtlParserClass::MtlParserClass()
+{
+}
+
+
+MtlParserClass::MtlParserClass(const MtlParserClass& other)
+{
+}
+
+
+MtlParserClass::~MtlParserClass()
+{
+}
+
+// Parse appends the materials of the file to out_materials, so every mtllib of an OBJ can be read into the same list.
+bool MtlParserClass::Parse(const char* filename, OUT std::vector<MaterialType>& out_materials)
+{
+	MappedFileClass file;
+	std::filesystem::path folder;
+	std::string map;
+	const char* p;
+	const char* end;
+	const char* lineEnd;
+	MaterialType* material;
+	bool result;
+
+
+	result = file.Initialize(filename);
+	if (!result)
+	{
+		return false;
+	}
+
+	folder = std::filesystem::path(filename).parent_path();
+	material = 0;
+	end = file.GetData() + file.GetSize();
+	for (p = file.GetData(); p < end; p = lineEnd + 1)
+	{
+		lineEnd = (const char*)memchr(p, '\n', end - p);
+		if (!lineEnd)
+		{
+			lineEnd = end;
+		}
+
+		p = SkipBlanks(p, lineEnd);
+		if (MatchKeyword(p, lineEnd, "newmtl"))
+		{
+			out_materials.emplace_back();
+			material = &out_materials.back();
+			material->name = ReadName(p + 6, lineEnd);
+		}
+		else if (material && MatchKeyword(p, lineEnd, "map_Kd"))
+		{
+			map = ReadMapFilename(p + 6, lineEnd);
+			if (!map.empty())
+			{
+				material->diffuseMap = (folder / map).string();
+			}
+		}
+	}
+
+	file.Shutdown();
+
+	return true;
+}
+
+// ReadMapFilename skips the options of a texture map statement, each a -name followed by its numbers or on/off switches,
+// and returns the rest of the line as the file name.
+std::string MtlParserClass::ReadMapFilename(const char* p, const char* end)
+{
+	const char* token;
+
+
+	p = SkipBlanks(p, end);
+	while (p < end && *p == '-')
+	{
+		// Step over the option name, then over every value after it.
+		do
+		{
+			while (p < end && !IsBlank(*p))
+			{
+				p++;
+			}
+			p = SkipBlanks(p, end);
+
+			token = p;
+			while (p < end && !IsBlank(*p))
+			{
+				p++;
+			}
+		} while (token < p && IsOptionValue(token, p));
+		p = token;
+	}
+
+	return ReadName(p, end);
+}
@@ -0,0 +1,47 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: mtlparserclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _MTLPARSERCLASS_H_
+#define _MTLPARSERCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <string>
+#include <vector>
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "meshtypes.h"
+#include "mappedfileclass.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: MtlParserClass
+////////////////////////////////////////////////////////////////////////////////
+// The MtlParserClass reads the materials of a Wavefront .mtl file, the newmtl name and map_Kd diffuse texture of each.
+// The texture path is resolved against the folder of the .mtl file, options such as -s or -clamp in front of it are skipped.
+// Everything else in the file is ignored since the texture shader draws with nothing but the diffuse texture.
+class MtlParserClass
+{
+public:
+	struct MaterialType
+	{
+		std::string name;
+		std::string diffuseMap;
+	};
+
+public:
+	MtlParserClass();
+	MtlParserClass(const MtlParserClass&);
+	~MtlParserClass();
+
+	bool Parse(const char* filename, OUT std::vector<MaterialType>& out_materials);
+
+private:
+	std::string ReadMapFilename(const char* p, const char* end);
+};
+
+#endif
@@ -0,0 +1,1145 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: nullrenderdeviceclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "nullrenderdeviceclass.h"
+#include <cstdio>
+#include <cstring>
+
+
+NullRenderDeviceClass::NullRenderDeviceClass()
+{
+	memset(&m_caps, 0, sizeof(m_caps));
+	m_gpuLatencyFrames = 0;
+	memset(m_vertexBuffers, 0, sizeof(m_vertexBuffers));
+	memset(m_vertexStrides, 0, sizeof(m_vertexStrides));
+	memset(m_vertexOffsets, 0, sizeof(m_vertexOffsets));
+	m_indexBuffer = 0;
+	m_indexStride = 0;
+	m_indexOffset = 0;
+	m_shader = 0;
+	memset(m_constantBuffers, 0, sizeof(m_constantBuffers));
+	memset(m_boundTextures, 0, sizeof(m_boundTextures));
+	m_mappedCount = 0;
+	m_inScene = false;
+	m_frame = 0;
+	m_finishedFrames = 0;
+	m_recording = false;
+}
+
+
+NullRenderDeviceClass::NullRenderDeviceClass(const NullRenderDeviceClass& other)
+{
+}
+
+
+NullRenderDeviceClass::~NullRenderDeviceClass()
+{
+}
+
+// Initialize sets what the device claims to support and how many frames behind the CPU its GPU finishes frames. With a latency of
+// zero a frame is finished as soon as it is submitted.
+bool NullRenderDeviceClass::Initialize(const CapsType& caps, unsigned int gpuLatencyFrames)
+{
+	m_caps = caps;
+	m_gpuLatencyFrames = gpuLatencyFrames;
+	m_frame = 0;
+	m_finishedFrames = 0;
+
+	return true;
+}
+
+// Shutdown reports every resource that is still alive as an error, the Direct3D device would leak it.
+void NullRenderDeviceClass::Shutdown()
+{
+	size_t i;
+
+
+	for (i = 0; i < m_buffers.size(); i++)
+	{
+		if (m_buffers[i].live)
+		{
+			Error("Shutdown", "a buffer was not released");
+		}
+	}
+	for (i = 0; i < m_textures.size(); i++)
+	{
+		if (m_textures[i].live)
+		{
+			Error("Shutdown", "a texture was not released");
+		}
+	}
+	for (i = 0; i < m_shaders.size(); i++)
+	{
+		if (m_shaders[i].live)
+		{
+			Error("Shutdown", "a shader was not released");
+		}
+	}
+	for (i = 0; i < m_queries.size(); i++)
+	{
+		if (m_queries[i].live)
+		{
+			Error("Shutdown", "a query was not released");
+		}
+	}
+	for (i = 0; i < m_commandLists.size(); i++)
+	{
+		if (m_commandLists[i].live)
+		{
+			Error("Shutdown", "a command list was not released");
+		}
+		if (m_commandLists[i].commands)
+		{
+			m_commandLists[i].commands->Shutdown();
+			delete m_commandLists[i].commands;
+		}
+	}
+
+	m_buffers.clear();
+	m_textures.clear();
+	m_shaders.clear();
+	m_queries.clear();
+	m_commandLists.clear();
+	m_freeBuffers.clear();
+	m_freeTextures.clear();
+	m_freeShaders.clear();
+	m_freeQueries.clear();
+	m_freeCommandLists.clear();
+	m_calls.clear();
+	m_stats.bufferCount = 0;
+	m_stats.textureCount = 0;
+	m_stats.shaderCount = 0;
+	m_stats.queryCount = 0;
+	m_stats.bufferBytes = 0;
+
+	return;
+}
+
+
+RenderDeviceClass::CapsType NullRenderDeviceClass::GetCaps()
+{
+	return m_caps;
+}
+
+// CreateBuffer only keeps memory for dynamic buffers, the contents of a default buffer are never read back so they are not kept.
+bool NullRenderDeviceClass::CreateBuffer(const BufferDescType& desc, const void* initialData, OUT unsigned int& buffer)
+{
+	BufferType* record;
+
+
+	buffer = RENDER_HANDLE_NONE;
+	if (desc.byteWidth == 0)
+	{
+		Error("CreateBuffer", "the buffer is empty");
+		return false;
+	}
+	if (desc.bind == RENDER_BIND_CONSTANT_BUFFER && desc.byteWidth % 16 != 0)
+	{
+		Error("CreateBuffer", "a constant buffer has to be a multiple of 16 bytes");
+		return false;
+	}
+
+	buffer = AddResource(m_buffers, m_freeBuffers);
+	record = &m_buffers[(buffer & 0xffffff) - 1];
+	record->desc = desc;
+	record->mapped = false;
+	record->discarded = false;
+	record->readRanges.clear();
+	record->memory.clear();
+	if (desc.usage == RENDER_USAGE_DYNAMIC)
+	{
+		record->memory.resize(desc.byteWidth);
+	}
+
+	if (initialData)
+	{
+		m_stats.uploadBytes += desc.byteWidth;
+	}
+	m_stats.bufferCount++;
+	m_stats.bufferBytes += desc.byteWidth;
+
+	return true;
+}
+
+
+void NullRenderDeviceClass::UpdateBuffer(unsigned int buffer, unsigned int offset, const void* data, unsigned int size)
+{
+	BufferType* record;
+
+
+	Record(RENDER_CALL_UPDATE_BUFFER, buffer, offset, size, 0, 0);
+	record = FindBuffer(buffer, "UpdateBuffer");
+	if (!record)
+	{
+		return;
+	}
+
+	if (record->desc.usage != RENDER_USAGE_DEFAULT)
+	{
+		Error("UpdateBuffer", "only default buffers can be updated, dynamic ones are mapped");
+	}
+	if (!data || (unsigned long long)offset + size > record->desc.byteWidth)
+	{
+		Error("UpdateBuffer", "the range is past the end of the buffer");
+	}
+
+	m_stats.updateCount++;
+	m_stats.uploadBytes += size;
+
+	return;
+}
+
+
+void NullRenderDeviceClass::CopyBuffer(unsigned int destination, unsigned int destinationOffset, unsigned int source, unsigned int sourceOffset,
+	unsigned int size)
+{
+	BufferType* destinationRecord, * sourceRecord;
+
+
+	Record(RENDER_CALL_COPY_BUFFER, destination, destinationOffset, source, size, 0);
+	destinationRecord = FindBuffer(destination, "CopyBuffer");
+	sourceRecord = FindBuffer(source, "CopyBuffer");
+	if (!destinationRecord || !sourceRecord)
+	{
+		return;
+	}
+
+	if ((unsigned long long)destinationOffset + size > destinationRecord->desc.byteWidth ||
+		(unsigned long long)sourceOffset + size > sourceRecord->desc.byteWidth)
+	{
+		Error("CopyBuffer", "the range is past the end of a buffer");
+	}
+	if (destination == source && destinationOffset < sourceOffset + size && sourceOffset < destinationOffset + size)
+	{
+		Error("CopyBuffer", "the source and destination overlap");
+	}
+
+	m_stats.copyCount++;
+	m_stats.copyBytes += size;
+
+	return;
+}
+
+// MapBuffer returns the memory of the mapped range. A discard forgets what earlier frames read, the memory behind it is new.
+bool NullRenderDeviceClass::MapBuffer(unsigned int buffer, RenderMapType mapType, unsigned int offset, unsigned int size, OUT void*& data)
+{
+	BufferType* record;
+	size_t i;
+
+
+	data = 0;
+	Record(RENDER_CALL_MAP_BUFFER, buffer, (unsigned int)mapType, offset, size, 0);
+	record = FindBuffer(buffer, "MapBuffer");
+	if (!record)
+	{
+		return false;
+	}
+
+	if (record->desc.usage != RENDER_USAGE_DYNAMIC)
+	{
+		Error("MapBuffer", "only dynamic buffers can be mapped");
+		return false;
+	}
+	if (record->mapped)
+	{
+		Error("MapBuffer", "the buffer is mapped already");
+		return false;
+	}
+	if ((unsigned long long)offset + size > record->desc.byteWidth)
+	{
+		Error("MapBuffer", "the range is past the end of the buffer");
+		return false;
+	}
+
+	if (mapType == RENDER_MAP_DISCARD)
+	{
+		record->discarded = true;
+		record->readRanges.clear();
+	}
+	else
+	{
+		if (record->desc.bind == RENDER_BIND_CONSTANT_BUFFER && !m_caps.mapNoOverwriteOnConstantBuffers)
+		{
+			Error("MapBuffer", "the device can not map a constant buffer without overwriting");
+			return false;
+		}
+		if (!record->discarded)
+		{
+			Error("MapBuffer", "a dynamic buffer has to be discarded before it is mapped without overwriting");
+		}
+
+		// Ranges of frames the GPU finished are dropped from the front, they are in the order the frames were drawn.
+		while (!record->readRanges.empty() && record->readRanges.front().frame < m_finishedFrames)
+		{
+			record->readRanges.pop_front();
+		}
+		for (i = 0; i < record->readRanges.size(); i++)
+		{
+			if (offset < record->readRanges[i].end && record->readRanges[i].start < offset + size)
+			{
+				Error("MapBuffer", "the range overwrites constants a draw the GPU has not finished reads");
+				break;
+			}
+		}
+	}
+
+	record->mapped = true;
+	m_mappedCount++;
+	data = record->memory.data() + offset;
+
+	m_stats.mapCount++;
+	m_stats.uploadBytes += size;
+
+	return true;
+}
+
+
+void NullRenderDeviceClass::UnmapBuffer(unsigned int buffer)
+{
+	BufferType* record;
+
+
+	record = FindBuffer(buffer, "UnmapBuffer");
+	if (!record)
+	{
+		return;
+	}
+
+	if (!record->mapped)
+	{
+		Error("UnmapBuffer", "the buffer is not mapped");
+		return;
+	}
+
+	record->mapped = false;
+	m_mappedCount--;
+
+	return;
+}
+
+
+void NullRenderDeviceClass::ReleaseBuffer(unsigned int buffer)
+{
+	BufferType* record;
+
+
+	record = FindBuffer(buffer, "ReleaseBuffer");
+	if (!record)
+	{
+		return;
+	}
+
+	if (record->mapped)
+	{
+		Error("ReleaseBuffer", "the buffer is still mapped");
+		m_mappedCount--;
+	}
+
+	m_stats.bufferCount--;
+	m_stats.bufferBytes -= record->desc.byteWidth;
+	record->memory.clear();
+	record->memory.shrink_to_fit();
+	record->readRanges.clear();
+	RemoveResource(m_buffers, m_freeBuffers, buffer);
+
+	return;
+}
+
+// The null device reads no files, any texture it is asked for exists.
+bool NullRenderDeviceClass::CreateTexture(const wchar_t* filename, OUT unsigned int& texture)
+{
+	texture = RENDER_HANDLE_NONE;
+	if (!filename || !filename[0])
+	{
+		Error("CreateTexture", "there is no file name");
+		return false;
+	}
+
+	texture = AddResource(m_textures, m_freeTextures);
+	m_stats.textureCount++;
+
+	return true;
+}
+
+
+bool NullRenderDeviceClass::CreateTexture(const unsigned char* data, size_t size, OUT unsigned int& texture)
+{
+	texture = RENDER_HANDLE_NONE;
+	if (!data || size == 0)
+	{
+		Error("CreateTexture", "there is no image");
+		return false;
+	}
+
+	texture = AddResource(m_textures, m_freeTextures);
+	m_stats.textureCount++;
+	m_stats.uploadBytes += size;
+
+	return true;
+}
+
+
+void NullRenderDeviceClass::ReleaseTexture(unsigned int texture)
+{
+	if (!FindResource(m_textures, texture, "ReleaseTexture", "texture"))
+	{
+		return;
+	}
+
+	m_stats.textureCount--;
+	RemoveResource(m_textures, m_freeTextures, texture);
+
+	return;
+}
+
+// CreateShader checks the input layout and remembers which vertex buffer slots it reads, a draw needs a buffer in each of them. A slot
+// is either per vertex or per instance, the input assembler steps all elements of a slot the same way.
+bool NullRenderDeviceClass::CreateShader(const ShaderDescType& desc, OUT unsigned int& shader)
+{
+	ShaderType* record;
+	unsigned int slotMask, instanceSlotMask, instanceExtents[RENDER_MAX_VERTEX_BUFFERS], slot, end, i;
+
+
+	shader = RENDER_HANDLE_NONE;
+	if (!desc.vertexShaderFile || !desc.vertexEntryPoint || !desc.pixelShaderFile || !desc.pixelEntryPoint)
+	{
+		Error("CreateShader", "a shader file or entry point is missing");
+		return false;
+	}
+	if (!desc.layout || desc.elementCount == 0)
+	{
+		Error("CreateShader", "there is no input layout");
+		return false;
+	}
+
+	slotMask = 0;
+	instanceSlotMask = 0;
+	memset(instanceExtents, 0, sizeof(instanceExtents));
+	for (i = 0; i < desc.elementCount; i++)
+	{
+		if (!desc.layout[i].semantic || GetFormatSize(desc.layout[i].format) == 0 || desc.layout[i].slot >= RENDER_MAX_VERTEX_BUFFERS)
+		{
+			Error("CreateShader", "an input element has no semantic, an unknown format or a slot out of range");
+			return false;
+		}
+		slot = desc.layout[i].slot;
+		if ((slotMask & (1u << slot)) && ((instanceSlotMask & (1u << slot)) != 0) != desc.layout[i].perInstance)
+		{
+			Error("CreateShader", "a vertex buffer slot has both per vertex and per instance elements");
+			return false;
+		}
+		slotMask |= 1u << slot;
+
+		if (desc.layout[i].perInstance)
+		{
+			instanceSlotMask |= 1u << slot;
+			end = desc.layout[i].offset + GetFormatSize(desc.layout[i].format);
+			instanceExtents[slot] = end > instanceExtents[slot] ? end : instanceExtents[slot];
+		}
+	}
+
+	shader = AddResource(m_shaders, m_freeShaders);
+	record = &m_shaders[(shader & 0xffffff) - 1];
+	record->slotMask = slotMask;
+	record->instanceSlotMask = instanceSlotMask;
+	memcpy(record->instanceExtents, instanceExtents, sizeof(instanceExtents));
+	m_stats.shaderCount++;
+
+	return true;
+}
+
+
+void NullRenderDeviceClass::ReleaseShader(unsigned int shader)
+{
+	if (!FindResource(m_shaders, shader, "ReleaseShader", "shader"))
+	{
+		return;
+	}
+
+	m_stats.shaderCount--;
+	RemoveResource(m_shaders, m_freeShaders, shader);
+
+	return;
+}
+
+
+bool NullRenderDeviceClass::CreateQuery(OUT unsigned int& query)
+{
+	query = AddResource(m_queries, m_freeQueries);
+	m_queries[(query & 0xffffff) - 1].ended = false;
+	m_queries[(query & 0xffffff) - 1].frame = 0;
+	m_stats.queryCount++;
+
+	return true;
+}
+
+// EndQuery marks the point of the frame being recorded, the query is done once the GPU finishes that frame.
+void NullRenderDeviceClass::EndQuery(unsigned int query)
+{
+	QueryType* record;
+
+
+	record = FindResource(m_queries, query, "EndQuery", "query");
+	if (!record)
+	{
+		return;
+	}
+
+	record->ended = true;
+	record->frame = m_frame;
+
+	return;
+}
+
+// IsQueryDone with flush waits for the GPU, which then has finished everything up to the frame of the query.
+bool NullRenderDeviceClass::IsQueryDone(unsigned int query, bool flush)
+{
+	QueryType* record;
+
+
+	record = FindResource(m_queries, query, "IsQueryDone", "query");
+	if (!record)
+	{
+		return true;
+	}
+
+	if (!record->ended)
+	{
+		Error("IsQueryDone", "the query was never ended");
+		return true;
+	}
+
+	if (flush && record->frame >= m_finishedFrames)
+	{
+		FinishFrames(record->frame + 1);
+	}
+
+	return record->frame < m_finishedFrames;
+}
+
+
+void NullRenderDeviceClass::ReleaseQuery(unsigned int query)
+{
+	if (!FindResource(m_queries, query, "ReleaseQuery", "query"))
+	{
+		return;
+	}
+
+	m_stats.queryCount--;
+	RemoveResource(m_queries, m_freeQueries, query);
+
+	return;
+}
+
+
+void NullRenderDeviceClass::BeginScene(float red, float green, float blue, float alpha)
+{
+	if (m_inScene)
+	{
+		Error("BeginScene", "the last scene was not ended");
+	}
+	m_inScene = true;
+
+	return;
+}
+
+// EndScene submits the frame. The GPU finishes the frame m_gpuLatencyFrames submissions later.
+void NullRenderDeviceClass::EndScene()
+{
+	Record(RENDER_CALL_END_SCENE, 0, 0, 0, 0, 0);
+	if (!m_inScene)
+	{
+		Error("EndScene", "no scene was begun");
+	}
+	if (m_mappedCount > 0)
+	{
+		Error("EndScene", "a buffer is still mapped");
+	}
+	m_inScene = false;
+
+	m_frame++;
+	if (m_frame >= m_gpuLatencyFrames)
+	{
+		FinishFrames(m_frame - m_gpuLatencyFrames);
+	}
+	m_stats.frameCount++;
+
+	return;
+}
+
+
+void NullRenderDeviceClass::SetVertexBuffers(unsigned int startSlot, unsigned int count, const unsigned int* buffers, const unsigned int* strides,
+	const unsigned int* offsets)
+{
+	BufferType* record;
+	unsigned int i;
+
+
+	if (startSlot + count > RENDER_MAX_VERTEX_BUFFERS)
+	{
+		Error("SetVertexBuffers", "the slots are out of range");
+		return;
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		Record(RENDER_CALL_SET_VERTEX_BUFFER, startSlot + i, buffers[i], strides[i], offsets[i], 0);
+		if (buffers[i])
+		{
+			record = FindBuffer(buffers[i], "SetVertexBuffers");
+			if (record && record->desc.bind != RENDER_BIND_VERTEX_BUFFER)
+			{
+				Error("SetVertexBuffers", "the buffer is not a vertex buffer");
+			}
+		}
+		m_vertexBuffers[startSlot + i] = buffers[i];
+		m_vertexStrides[startSlot + i] = strides[i];
+		m_vertexOffsets[startSlot + i] = offsets[i];
+	}
+	m_stats.bindCount++;
+
+	return;
+}
+
+
+void NullRenderDeviceClass::SetIndexBuffer(unsigned int buffer, DXGI_FORMAT format, unsigned int offset)
+{
+	BufferType* record;
+
+
+	Record(RENDER_CALL_SET_INDEX_BUFFER, buffer, (unsigned int)format, offset, 0, 0);
+	if (buffer)
+	{
+		record = FindBuffer(buffer, "SetIndexBuffer");
+		if (record && record->desc.bind != RENDER_BIND_INDEX_BUFFER)
+		{
+			Error("SetIndexBuffer", "the buffer is not an index buffer");
+		}
+		if (format != DXGI_FORMAT_R16_UINT && format != DXGI_FORMAT_R32_UINT)
+		{
+			Error("SetIndexBuffer", "indices have to be 16 or 32 bit unsigned integers");
+		}
+	}
+
+	m_indexBuffer = buffer;
+	m_indexStride = (format == DXGI_FORMAT_R16_UINT) ? 2 : 4;
+	m_indexOffset = offset;
+	m_stats.bindCount++;
+
+	return;
+}
+
+
+void NullRenderDeviceClass::SetShader(unsigned int shader)
+{
+	Record(RENDER_CALL_SET_SHADER, shader, 0, 0, 0, 0);
+	if (shader)
+	{
+		FindResource(m_shaders, shader, "SetShader", "shader");
+	}
+
+	m_shader = shader;
+	m_stats.bindCount++;
+
+	return;
+}
+
+// SetConstantBuffer binds the whole buffer with a constant count of zero, otherwise that many 16 byte constants from firstConstant,
+// which like the count has to be a multiple of 16 constants.
+void NullRenderDeviceClass::SetConstantBuffer(RenderShaderStageType stage, unsigned int slot, unsigned int buffer, unsigned int firstConstant,
+	unsigned int constantCount)
+{
+	BufferType* record;
+
+
+	Record(RENDER_CALL_SET_CONSTANT_BUFFER, (unsigned int)stage * RENDER_MAX_CONSTANT_BUFFERS + slot, buffer, firstConstant, constantCount, 0);
+	if ((stage != RENDER_STAGE_VERTEX && stage != RENDER_STAGE_PIXEL) || slot >= RENDER_MAX_CONSTANT_BUFFERS)
+	{
+		Error("SetConstantBuffer", "the stage or slot is out of range");
+		return;
+	}
+
+	if (buffer)
+	{
+		record = FindBuffer(buffer, "SetConstantBuffer");
+		if (record && record->desc.bind != RENDER_BIND_CONSTANT_BUFFER)
+		{
+			Error("SetConstantBuffer", "the buffer is not a constant buffer");
+		}
+		if (record && constantCount > 0)
+		{
+			if (!m_caps.constantBufferOffsetting)
+			{
+				Error("SetConstantBuffer", "the device can not bind part of a constant buffer");
+			}
+			if (firstConstant % 16 != 0 || constantCount % 16 != 0 || constantCount > 4096 ||
+				(unsigned long long)(firstConstant + constantCount) * 16 > record->desc.byteWidth)
+			{
+				Error("SetConstantBuffer", "the constants are not aligned to 16 constants, too many or past the end of the buffer");
+			}
+		}
+	}
+
+	m_constantBuffers[stage][slot].buffer = buffer;
+	m_constantBuffers[stage][slot].firstConstant = firstConstant;
+	m_constantBuffers[stage][slot].constantCount = constantCount;
+	m_stats.bindCount++;
+
+	return;
+}
+
+
+void NullRenderDeviceClass::SetTexture(unsigned int slot, unsigned int texture)
+{
+	Record(RENDER_CALL_SET_TEXTURE, slot, texture, 0, 0, 0);
+	if (slot >= RENDER_MAX_TEXTURES)
+	{
+		Error("SetTexture", "the slot is out of range");
+		return;
+	}
+
+	if (texture)
+	{
+		FindResource(m_textures, texture, "SetTexture", "texture");
+	}
+
+	m_boundTextures[slot] = texture;
+	m_stats.bindCount++;
+
+	return;
+}
+
+// DrawIndexed checks everything the draw reads is there and in range, and remembers which constants of dynamic buffers it reads.
+void NullRenderDeviceClass::DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex)
+{
+	Record(RENDER_CALL_DRAW_INDEXED, indexCount, startIndex, (unsigned int)baseVertex, 0, 0);
+	CheckDraw("DrawIndexed", indexCount, startIndex, 1, 0);
+
+	m_stats.drawCount++;
+	m_stats.instanceCount++;
+	m_stats.indexCount += indexCount;
+
+	return;
+}
+
+// DrawIndexedInstanced checks the same as DrawIndexed, and that the instances are inside the buffers of the per instance slots.
+void NullRenderDeviceClass::DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int startIndex, int baseVertex,
+	unsigned int startInstance)
+{
+	Record(RENDER_CALL_DRAW_INDEXED_INSTANCED, indexCount, instanceCount, startIndex, (unsigned int)baseVertex, startInstance);
+	CheckDraw("DrawIndexedInstanced", indexCount, startIndex, instanceCount, startInstance);
+
+	m_stats.drawCount++;
+	m_stats.instanceCount += instanceCount;
+	m_stats.indexCount += (unsigned long long)indexCount * instanceCount;
+
+	return;
+}
+
+// CreateCommandList makes an empty list. A list keeps the memory of its commands until it is released, so recording it again every
+// frame does not allocate once it has grown to the size of a frame.
+bool NullRenderDeviceClass::CreateCommandList(OUT unsigned int& commandList)
+{
+	CommandListType* record;
+
+
+	commandList = AddResource(m_commandLists, m_freeCommandLists);
+	record = &m_commandLists[(commandList & 0xffffff) - 1];
+	record->recording = false;
+	record->commands = new CommandListClass;
+	if (!record->commands)
+	{
+		RemoveResource(m_commandLists, m_freeCommandLists, commandList);
+		commandList = RENDER_HANDLE_NONE;
+		return false;
+	}
+	record->commands->Initialize(this);
+
+	return true;
+}
+
+// BeginCommandList is called on the thread that records, so it only touches the list. What the list held before is thrown away.
+bool NullRenderDeviceClass::BeginCommandList(unsigned int commandList, OUT RenderDeviceClass*& recorder)
+{
+	CommandListType* record;
+
+
+	recorder = 0;
+	record = FindResource(m_commandLists, commandList, "BeginCommandList", "command list");
+	if (!record)
+	{
+		return false;
+	}
+
+	if (record->recording)
+	{
+		Error("BeginCommandList", "the command list is already recording");
+		return false;
+	}
+
+	record->recording = true;
+	record->commands->Reset();
+	recorder = record->commands;
+
+	return true;
+}
+
+
+void NullRenderDeviceClass::EndCommandList(unsigned int commandList)
+{
+	CommandListType* record;
+
+
+	record = FindResource(m_commandLists, commandList, "EndCommandList", "command list");
+	if (!record)
+	{
+		return;
+	}
+
+	if (!record->recording)
+	{
+		Error("EndCommandList", "the command list is not recording");
+	}
+	record->recording = false;
+
+	return;
+}
+
+// ExecuteCommandList checks the calls of the list as they are made on the device, starting from nothing bound. Calls the list could
+// not record are errors of the device now.
+void NullRenderDeviceClass::ExecuteCommandList(unsigned int commandList)
+{
+	CommandListType* record;
+	unsigned int errorCount;
+	std::string message;
+
+
+	Record(RENDER_CALL_EXECUTE_COMMAND_LIST, commandList, 0, 0, 0, 0);
+	record = FindResource(m_commandLists, commandList, "ExecuteCommandList", "command list");
+	if (!record)
+	{
+		return;
+	}
+
+	if (record->recording)
+	{
+		Error("ExecuteCommandList", "the command list is still recording");
+		return;
+	}
+
+	errorCount = record->commands->GetStats().errorCount;
+	if (errorCount > 0)
+	{
+		message = std::to_string(errorCount) + " calls the command list can not record were made to it, the last was " +
+			record->commands->GetLastError();
+		Error("ExecuteCommandList", message.c_str());
+	}
+
+	ClearBindings();
+	record->commands->Execute(this);
+	ClearBindings();
+
+	return;
+}
+
+
+void NullRenderDeviceClass::ReleaseCommandList(unsigned int commandList)
+{
+	CommandListType* record;
+
+
+	record = FindResource(m_commandLists, commandList, "ReleaseCommandList", "command list");
+	if (!record)
+	{
+		return;
+	}
+
+	if (record->recording)
+	{
+		Error("ReleaseCommandList", "the command list is still recording");
+	}
+
+	record->commands->Shutdown();
+	delete record->commands;
+	record->commands = 0;
+	RemoveResource(m_commandLists, m_freeCommandLists, commandList);
+
+	return;
+}
+
+// SetRecording turns the call log on or off, it is off by default so long benchmarks do not grow it.
+void NullRenderDeviceClass::SetRecording(bool enabled)
+{
+	m_recording = enabled;
+
+	return;
+}
+
+
+int NullRenderDeviceClass::GetCallCount()
+{
+	return (int)m_calls.size();
+}
+
+
+NullRenderDeviceClass::CallType NullRenderDeviceClass::GetCall(int index)
+{
+	return m_calls[index];
+}
+
+
+void NullRenderDeviceClass::ClearCalls()
+{
+	m_calls.clear();
+
+	return;
+}
+
+// GetLastError returns the last error found, or an empty string while there is none.
+const char* NullRenderDeviceClass::GetLastError()
+{
+	return m_lastError.c_str();
+}
+
+
+void NullRenderDeviceClass::Error(const char* call, const char* message)
+{
+	m_lastError = std::string(call) + ": " + message;
+	if (m_stats.errorCount < NULL_RENDER_DEVICE_PRINTED_ERRORS)
+	{
+		printf("Null render device error in %s\n", m_lastError.c_str());
+	}
+	m_stats.errorCount++;
+
+	return;
+}
+
+
+void NullRenderDeviceClass::Record(RenderCallType type, unsigned int argument0, unsigned int argument1, unsigned int argument2, unsigned int argument3,
+	unsigned int argument4)
+{
+	CallType call;
+
+
+	if (!m_recording)
+	{
+		return;
+	}
+
+	call.type = type;
+	call.arguments[0] = argument0;
+	call.arguments[1] = argument1;
+	call.arguments[2] = argument2;
+	call.arguments[3] = argument3;
+	call.arguments[4] = argument4;
+	m_calls.push_back(call);
+
+	return;
+}
+
+// CheckDraw is what every draw checks, call is the name errors are reported under.
+void NullRenderDeviceClass::CheckDraw(const char* call, unsigned int indexCount, unsigned int startIndex, unsigned int instanceCount,
+	unsigned int startInstance)
+{
+	BufferType* record;
+	ShaderType* shader;
+	ConstantBindingType* binding;
+	unsigned int slot, stage;
+
+
+	if (!m_inScene)
+	{
+		Error(call, "the draw is outside of a scene");
+	}
+	if (m_mappedCount > 0)
+	{
+		Error(call, "a buffer is still mapped");
+	}
+
+	shader = 0;
+	if (!m_shader)
+	{
+		Error(call, "no shader is set");
+	}
+	else
+	{
+		shader = FindResource(m_shaders, m_shader, call, "shader");
+	}
+
+	if (!m_indexBuffer)
+	{
+		Error(call, "no index buffer is set");
+	}
+	else
+	{
+		record = FindBuffer(m_indexBuffer, call);
+		if (record && m_indexOffset + ((unsigned long long)startIndex + indexCount) * m_indexStride > record->desc.byteWidth)
+		{
+			Error(call, "the indices are past the end of the index buffer");
+		}
+	}
+
+	if (shader)
+	{
+		for (slot = 0; slot < RENDER_MAX_VERTEX_BUFFERS; slot++)
+		{
+			if ((shader->slotMask & (1u << slot)) && (!m_vertexBuffers[slot] || !FindBuffer(m_vertexBuffers[slot], call)))
+			{
+				Error(call, "a vertex buffer slot the input layout reads is empty");
+			}
+			else if ((shader->instanceSlotMask & (1u << slot)) && instanceCount > 0)
+			{
+				record = FindBuffer(m_vertexBuffers[slot], call);
+				if (record && m_vertexOffsets[slot] + ((unsigned long long)startInstance + instanceCount - 1) * m_vertexStrides[slot] +
+					shader->instanceExtents[slot] > record->desc.byteWidth)
+				{
+					Error(call, "the instances are past the end of a per instance vertex buffer");
+				}
+			}
+		}
+	}
+
+	for (stage = 0; stage < 2; stage++)
+	{
+		for (slot = 0; slot < RENDER_MAX_CONSTANT_BUFFERS; slot++)
+		{
+			binding = &m_constantBuffers[stage][slot];
+			if (binding->buffer)
+			{
+				record = FindBuffer(binding->buffer, call);
+				if (record && record->desc.usage == RENDER_USAGE_DYNAMIC)
+				{
+					if (binding->constantCount > 0)
+					{
+						AddReadRange(binding->buffer, binding->firstConstant * 16, (binding->firstConstant + binding->constantCount) * 16);
+					}
+					else
+					{
+						AddReadRange(binding->buffer, 0, record->desc.byteWidth);
+					}
+				}
+			}
+		}
+	}
+
+	return;
+}
+
+
+NullRenderDeviceClass::BufferType* NullRenderDeviceClass::FindBuffer(unsigned int buffer, const char* call)
+{
+	return FindResource(m_buffers, buffer, call, "buffer");
+}
+
+// AddReadRange extends the last range of the buffer when the draw reads right after it in the same frame, as the draws of a constant
+// ring do, so a frame usually needs a single range.
+void NullRenderDeviceClass::AddReadRange(unsigned int buffer, unsigned int start, unsigned int end)
+{
+	BufferType* record;
+	ReadRangeType range;
+
+
+	record = &m_buffers[(buffer & 0xffffff) - 1];
+	if (!record->readRanges.empty())
+	{
+		ReadRangeType& last = record->readRanges.back();
+		if (last.frame == m_frame && start <= last.end && last.start <= end)
+		{
+			last.start = (start < last.start) ? start : last.start;
+			last.end = (end > last.end) ? end : last.end;
+			return;
+		}
+	}
+
+	range.frame = m_frame;
+	range.start = start;
+	range.end = end;
+	record->readRanges.push_back(range);
+
+	return;
+}
+
+// FinishFrames lets the GPU catch up to the given number of finished frames, it never goes back.
+void NullRenderDeviceClass::FinishFrames(unsigned int frameCount)
+{
+	if (frameCount > m_finishedFrames)
+	{
+		m_finishedFrames = frameCount;
+	}
+
+	return;
+}
+
+
+// ClearBindings unbinds everything, the way executing a command list leaves the state.
+void NullRenderDeviceClass::ClearBindings()
+{
+	memset(m_vertexBuffers, 0, sizeof(m_vertexBuffers));
+	memset(m_vertexStrides, 0, sizeof(m_vertexStrides));
+	memset(m_vertexOffsets, 0, sizeof(m_vertexOffsets));
+	m_indexBuffer = 0;
+	m_indexStride = 0;
+	m_indexOffset = 0;
+	m_shader = 0;
+	memset(m_constantBuffers, 0, sizeof(m_constantBuffers));
+	memset(m_boundTextures, 0, sizeof(m_boundTextures));
+
+	return;
+}
+
+
+template <typename ResourceType>
+unsigned int NullRenderDeviceClass::AddResource(std::vector<ResourceType>& resources, std::vector<unsigned int>& freeIndices)
+{
+	unsigned int index;
+
+
+	if (!freeIndices.empty())
+	{
+		index = freeIndices.back();
+		freeIndices.pop_back();
+	}
+	else
+	{
+		index = (unsigned int)resources.size();
+		resources.push_back(ResourceType());
+		resources[index].generation = 0;
+	}
+	resources[index].live = true;
+
+	return (resources[index].generation << 24) | (index + 1);
+}
+
+
+template <typename ResourceType>
+ResourceType* NullRenderDeviceClass::FindResource(std::vector<ResourceType>& resources, unsigned int handle, const char* call, const char* kind)
+{
+	unsigned int index;
+	std::string message;
+
+
+	index = (handle & 0xffffff) - 1;
+	if (handle == RENDER_HANDLE_NONE || index >= resources.size() || !resources[index].live || resources[index].generation != handle >> 24)
+	{
+		message = std::string("the ") + kind + " was released or never created";
+		Error(call, message.c_str());
+		return 0;
+	}
+
+	return &resources[index];
+}
+
+
+template <typename ResourceType>
+void NullRenderDeviceClass::RemoveResource(std::vector<ResourceType>& resources, std::vector<unsigned int>& freeIndices, unsigned int handle)
+{
+	unsigned int index;
+
+
+	index = (handle & 0xffffff) - 1;
+	resources[index].live = false;
+	resources[index].generation = (resources[index].generation + 1) & 0xff;
+	freeIndices.push_back(index);
+
+	return;
+}
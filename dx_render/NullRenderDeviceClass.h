@@ -0,0 +1,229 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: nullrenderdeviceclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _NULLRENDERDEVICECLASS_H_
+#define _NULLRENDERDEVICECLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <deque>
+#include <string>
+#include <vector>
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "renderdeviceclass.h"
+#include "commandlistclass.h"
+
+
+/////////////
+// GLOBALS //
+/////////////
+// Only the first errors are printed as they are found, the rest are only counted.
+const unsigned int NULL_RENDER_DEVICE_PRINTED_ERRORS = 8;
+
+
+//////////////
+// TYPEDEFS //
+//////////////
+// The calls the null device records. What the arguments of each are is listed with NullRenderDeviceClass::CallType.
+enum RenderCallType
+{
+	RENDER_CALL_UPDATE_BUFFER,
+	RENDER_CALL_COPY_BUFFER,
+	RENDER_CALL_MAP_BUFFER,
+	RENDER_CALL_SET_VERTEX_BUFFER,
+	RENDER_CALL_SET_INDEX_BUFFER,
+	RENDER_CALL_SET_SHADER,
+	RENDER_CALL_SET_CONSTANT_BUFFER,
+	RENDER_CALL_SET_TEXTURE,
+	RENDER_CALL_DRAW_INDEXED,
+	RENDER_CALL_DRAW_INDEXED_INSTANCED,
+	RENDER_CALL_EXECUTE_COMMAND_LIST,
+	RENDER_CALL_END_SCENE
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: NullRenderDeviceClass
+////////////////////////////////////////////////////////////////////////////////
+// The NullRenderDeviceClass is a render device without a GPU. Resources are only bookkeeping, apart from the memory of dynamic
+// buffers which is handed out by MapBuffer, so the frame runs on any machine at the cost of its own CPU work.
+// Every call is checked the way the Direct3D debug layer would: handles that were never made or were released, buffers bound as what
+// they were not made for, ranges past the end of a buffer, maps that are not paired, draws that are missing state, and resources still
+// alive at Shutdown. The GPU is taken to finish a frame a fixed number of frames after it was submitted, and a map with
+// RENDER_MAP_NO_OVERWRITE that touches constants a draw of an unfinished frame reads is an error too.
+// A command list is a CommandListClass, which worker threads record into without touching the device. ExecuteCommandList checks and
+// logs its calls the same as calls made straight to the device, so a frame recorded on threads can be compared to one that was not.
+class NullRenderDeviceClass : public RenderDeviceClass
+{
+public:
+	// The arguments of a recorded call, in order:
+	// update buffer: buffer, offset, size. copy buffer: destination, destination offset, source, size. map buffer: buffer, map type,
+	// offset, size. set vertex buffer: slot, buffer, stride, offset. set index buffer: buffer, format, offset. set shader: shader.
+	// set constant buffer: stage and slot as stage * RENDER_MAX_CONSTANT_BUFFERS + slot, buffer, first constant, constant count.
+	// set texture: slot, texture. draw indexed: index count, start index, base vertex. draw indexed instanced: index count, instance
+	// count, start index, base vertex, start instance. execute command list: command list, its calls follow. end scene: none.
+	struct CallType
+	{
+		RenderCallType type;
+		unsigned int arguments[5];
+	};
+
+private:
+	// A range of a dynamic buffer a draw of a frame reads.
+	struct ReadRangeType
+	{
+		unsigned int frame;
+		unsigned int start, end;
+	};
+
+	struct BufferType
+	{
+		unsigned int generation;
+		bool live;
+		BufferDescType desc;
+		std::vector<unsigned char> memory;
+		bool mapped, discarded;
+		std::deque<ReadRangeType> readRanges;
+	};
+
+	struct TextureType
+	{
+		unsigned int generation;
+		bool live;
+	};
+
+	// The vertex buffer slots the input layout reads, and for the per instance ones how far into a stride its elements go.
+	struct ShaderType
+	{
+		unsigned int generation;
+		bool live;
+		unsigned int slotMask, instanceSlotMask;
+		unsigned int instanceExtents[RENDER_MAX_VERTEX_BUFFERS];
+	};
+
+	struct QueryType
+	{
+		unsigned int generation;
+		bool live, ended;
+		unsigned int frame;
+	};
+
+	struct ConstantBindingType
+	{
+		unsigned int buffer;
+		unsigned int firstConstant, constantCount;
+	};
+
+	struct CommandListType
+	{
+		unsigned int generation;
+		bool live, recording;
+		CommandListClass* commands;
+	};
+
+public:
+	NullRenderDeviceClass();
+	NullRenderDeviceClass(const NullRenderDeviceClass&);
+	~NullRenderDeviceClass();
+
+	bool Initialize(const CapsType& caps, unsigned int gpuLatencyFrames);
+	void Shutdown();
+	CapsType GetCaps();
+
+	bool CreateBuffer(const BufferDescType&, const void* initialData, OUT unsigned int& buffer);
+	void UpdateBuffer(unsigned int buffer, unsigned int offset, const void* data, unsigned int size);
+	void CopyBuffer(unsigned int destination, unsigned int destinationOffset, unsigned int source, unsigned int sourceOffset, unsigned int size);
+	bool MapBuffer(unsigned int buffer, RenderMapType, unsigned int offset, unsigned int size, OUT void*& data);
+	void UnmapBuffer(unsigned int buffer);
+	void ReleaseBuffer(unsigned int buffer);
+
+	bool CreateTexture(const wchar_t* filename, OUT unsigned int& texture);
+	bool CreateTexture(const unsigned char* data, size_t size, OUT unsigned int& texture);
+	void ReleaseTexture(unsigned int texture);
+
+	bool CreateShader(const ShaderDescType&, OUT unsigned int& shader);
+	void ReleaseShader(unsigned int shader);
+
+	bool CreateQuery(OUT unsigned int& query);
+	void EndQuery(unsigned int query);
+	bool IsQueryDone(unsigned int query, bool flush);
+	void ReleaseQuery(unsigned int query);
+
+	void BeginScene(float red, float green, float blue, float alpha);
+	void EndScene();
+
+	void SetVertexBuffers(unsigned int startSlot, unsigned int count, const unsigned int* buffers, const unsigned int* strides,
+		const unsigned int* offsets);
+	void SetIndexBuffer(unsigned int buffer, DXGI_FORMAT format, unsigned int offset);
+	void SetShader(unsigned int shader);
+	void SetConstantBuffer(RenderShaderStageType, unsigned int slot, unsigned int buffer, unsigned int firstConstant, unsigned int constantCount);
+	void SetTexture(unsigned int slot, unsigned int texture);
+	void DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex);
+	void DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int startIndex, int baseVertex,
+		unsigned int startInstance);
+
+	bool CreateCommandList(OUT unsigned int& commandList);
+	bool BeginCommandList(unsigned int commandList, OUT RenderDeviceClass*& recorder);
+	void EndCommandList(unsigned int commandList);
+	void ExecuteCommandList(unsigned int commandList);
+	void ReleaseCommandList(unsigned int commandList);
+
+	void SetRecording(bool enabled);
+	int GetCallCount();
+	CallType GetCall(int);
+	void ClearCalls();
+	const char* GetLastError();
+
+private:
+	void Error(const char* call, const char* message);
+	void Record(RenderCallType, unsigned int argument0, unsigned int argument1, unsigned int argument2, unsigned int argument3,
+		unsigned int argument4);
+	void CheckDraw(const char* call, unsigned int indexCount, unsigned int startIndex, unsigned int instanceCount, unsigned int startInstance);
+	BufferType* FindBuffer(unsigned int buffer, const char* call);
+	void AddReadRange(unsigned int buffer, unsigned int start, unsigned int end);
+	void FinishFrames(unsigned int frameCount);
+	void ClearBindings();
+
+	// A handle is the index of a resource plus one in its low bits and the generation of that index in the top ones, so a handle that
+	// was released is told apart from a new resource that got the same index.
+	template <typename ResourceType>
+	unsigned int AddResource(std::vector<ResourceType>& resources, std::vector<unsigned int>& freeIndices);
+	template <typename ResourceType>
+	ResourceType* FindResource(std::vector<ResourceType>& resources, unsigned int handle, const char* call, const char* kind);
+	template <typename ResourceType>
+	void RemoveResource(std::vector<ResourceType>& resources, std::vector<unsigned int>& freeIndices, unsigned int handle);
+
+private:
+	CapsType m_caps;
+	unsigned int m_gpuLatencyFrames;
+
+	std::vector<BufferType> m_buffers;
+	std::vector<TextureType> m_textures;
+	std::vector<ShaderType> m_shaders;
+	std::vector<QueryType> m_queries;
+	std::vector<CommandListType> m_commandLists;
+	std::vector<unsigned int> m_freeBuffers, m_freeTextures, m_freeShaders, m_freeQueries, m_freeCommandLists;
+
+	// The state the next draw reads.
+	unsigned int m_vertexBuffers[RENDER_MAX_VERTEX_BUFFERS], m_vertexStrides[RENDER_MAX_VERTEX_BUFFERS], m_vertexOffsets[RENDER_MAX_VERTEX_BUFFERS];
+	unsigned int m_indexBuffer, m_indexStride, m_indexOffset;
+	unsigned int m_shader;
+	ConstantBindingType m_constantBuffers[2][RENDER_MAX_CONSTANT_BUFFERS];
+	unsigned int m_boundTextures[RENDER_MAX_TEXTURES];
+	unsigned int m_mappedCount;
+	bool m_inScene;
+
+	// The frames submitted so far, the frame that is being recorded, and how many of them the GPU has finished.
+	unsigned int m_frame, m_finishedFrames;
+
+	bool m_recording;
+	std::vector<CallType> m_calls;
+	std::string m_lastError;
+};
+
+#endif
@@ -0,0 +1,703 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: objparserclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "objparserclass.h"
+#include <charconv>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <thread>
+#include <unordered_map>
+#include <algorithm>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define OBJ_PARSER_SSE2 1
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+
+/////////////
+// GLOBALS //
+/////////////
+// Files smaller than this are parsed on the calling thread since starting workers would cost more than it saves.
+static const size_t OBJ_PARALLEL_MIN_BYTES = 4 * 1024 * 1024;
+// Each worker gets several chunks so threads that drew vertex heavy chunks are not left waiting on face heavy ones.
+static const unsigned int OBJ_CHUNKS_PER_THREAD = 4;
+// What an index that points outside the file resolves to. It is one below MESH_INDEX_NONE and beyond any array the welder sees.
+static const unsigned int OBJ_INDEX_INVALID = MESH_INDEX_NONE - 1;
+// The material of the triangles a chunk has before its first usemtl, they carry on with whatever the chunk before it ended with.
+static const unsigned int OBJ_MATERIAL_INHERIT = MESH_INDEX_NONE;
+
+
+// The helpers below work on [p, end) ranges of the mapped file, which is not null terminated.
+// Each returns the position just past what it consumed, or null when the text is not what was expected.
+
+#ifdef OBJ_PARSER_SSE2
+static unsigned int CountTrailingZeros(unsigned int mask)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return index;
+#else
+	return (unsigned int)__builtin_ctz(mask);
+#endif
+}
+#endif
+
+// FindLineEnd returns the next '\n' at or after p, or end. Sixteen bytes are compared at a time with SSE2.
+static const char* FindLineEnd(const char* p, const char* end)
+{
+	const void* hit;
+
+
+#ifdef OBJ_PARSER_SSE2
+	const __m128i newline = _mm_set1_epi8('\n');
+	while (end - p >= 16)
+	{
+		int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)p), newline));
+		if (mask)
+		{
+			return p + CountTrailingZeros((unsigned int)mask);
+		}
+		p += 16;
+	}
+#endif
+
+	hit = memchr(p, '\n', end - p);
+	return hit ? (const char*)hit : end;
+}
+
+
+static bool IsBlank(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+
+static const char* SkipBlanks(const char* p, const char* end)
+{
+	while (p < end && IsBlank(*p))
+	{
+		p++;
+	}
+
+	return p;
+}
+
+// MatchKeyword tells whether the line starts with the keyword followed by a blank or the end of the line.
+static bool MatchKeyword(const char* p, const char* end, const char* keyword, size_t length)
+{
+	return (size_t)(end - p) >= length && memcmp(p, keyword, length) == 0 && (p + length == end || IsBlank(p[length]));
+}
+
+// ReadName returns the rest of the line without the blanks around it. Material and file names may contain spaces.
+static std::string ReadName(const char* p, const char* end)
+{
+	p = SkipBlanks(p, end);
+	while (end > p && IsBlank(end[-1]))
+	{
+		end--;
+	}
+
+	return std::string(p, end);
+}
+
+// ParseFloat uses from_chars, which is exact and locale free, so the values match what fscanf_s("%f") produced before.
+static const char* ParseFloat(const char* p, const char* end, float& value)
+{
+	char buffer[64];
+	size_t length;
+
+
+	p = SkipBlanks(p, end);
+	if (p < end && *p == '+')
+	{
+		p++;
+	}
+
+	std::from_chars_result result = std::from_chars(p, end, value);
+	if (result.ec == std::errc())
+	{
+		return result.ptr;
+	}
+
+	// Values that over or underflow a float still parse with fscanf, so fall back to strtof for those rare tokens.
+	if (result.ec == std::errc::result_out_of_range)
+	{
+		length = (size_t)(result.ptr - p);
+		if (length >= sizeof(buffer))
+		{
+			return 0;
+		}
+		memcpy(buffer, p, length);
+		buffer[length] = 0;
+		value = strtof(buffer, 0);
+		return result.ptr;
+	}
+
+	return 0;
+}
+
+
+// ParseIndex reads a signed face index. Digits past the largest index a file can use no longer add to the value, it stays one above
+// that limit so ResolveIndex rejects it, and a long run of digits can not wrap around into an index that looks valid.
+static const char* ParseIndex(const char* p, const char* end, long long& value)
+{
+	bool negative;
+
+
+	negative = false;
+	if (p < end && *p == '-')
+	{
+		negative = true;
+		p++;
+	}
+
+	if (p >= end || *p < '0' || *p > '9')
+	{
+		return 0;
+	}
+
+	value = 0;
+	while (p < end && *p >= '0' && *p <= '9')
+	{
+		if (value <= (long long)OBJ_INDEX_INVALID)
+		{
+			value = value * 10 + (*p - '0');
+		}
+		else
+		{
+			value = (long long)OBJ_INDEX_INVALID + 1;
+		}
+		p++;
+	}
+
+	if (negative)
+	{
+		value = -value;
+	}
+
+	return p;
+}
+
+// ResolveIndex turns a one based or negative relative OBJ index into a zero based one.
+// Zero and out of range references become OBJ_INDEX_INVALID, which the welder rejects, so they can not pass for MESH_INDEX_NONE.
+static unsigned int ResolveIndex(long long index, size_t definedSoFar)
+{
+	if (index > 0 && index <= (long long)OBJ_INDEX_INVALID)
+	{
+		return (unsigned int)(index - 1);
+	}
+
+	if (index < 0 && (long long)definedSoFar + index >= 0)
+	{
+		return (unsigned int)((long long)definedSoFar + index);
+	}
+
+	return OBJ_INDEX_INVALID;
+}
+
+
+ObjParserClass::ObjParserClass()
+{
+	m_threadCount = 0;
+	m_usedThreadCount = 1;
+	m_fileSize = 0;
+	m_parseSeconds = 0.0;
+}
+
+
+ObjParserClass::ObjParserClass(const ObjParserClass& other)
+{
+}
+
+
+ObjParserClass::~ObjParserClass()
+{
+}
+
+void ObjParserClass::SetThreadCount(unsigned int threadCount)
+{
+	m_threadCount = threadCount;
+
+	return;
+}
+
+// Parse maps the file and parses all of it as a single range.
+bool ObjParserClass::Parse(const char* filename, OUT ObjDataType& data)
+{
+	MappedFileClass file;
+	RecordCountType defined;
+	bool result;
+
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	result = file.Initialize(filename);
+	if (!result)
+	{
+		return false;
+	}
+
+	m_fileSize = file.GetSize();
+	memset(&defined, 0, sizeof(defined));
+	result = ParseRange(file.GetData(), file.GetData() + m_fileSize, defined, data);
+
+	file.Shutdown();
+
+	m_parseSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	return result;
+}
+
+// ParseBlock parses one line aligned block of a file that is read a piece at a time. Defined holds the number of records of each kind
+// in all the blocks before this one, the arrays only receive the records of this block but the indices are resolved against the whole file.
+bool ObjParserClass::ParseBlock(const char* begin, const char* end, const RecordCountType& defined, OUT ObjDataType& data)
+{
+	return ParseRange(begin, end, defined, data);
+}
+
+// ParseRange counts every record type, sizes the output arrays once and then fills them in place.
+// Both passes run per chunk: the counts of all chunks before a chunk are the offsets of its records in the arrays,
+// and together with defined also what OBJ needs to resolve negative indices since they count back from the vertices defined so far.
+bool ObjParserClass::ParseRange(const char* begin, const char* end, const RecordCountType& defined, OUT ObjDataType& data)
+{
+	std::vector<const char*> boundaries;
+	std::vector<RecordCountType> counts;
+	std::vector<ChunkMaterialsType> chunkMaterials;
+	std::vector<char> chunkResults;
+	RecordCountType total;
+	unsigned int threadCount;
+	size_t chunkCount, i;
+
+
+	threadCount = m_threadCount ? m_threadCount : std::thread::hardware_concurrency();
+	if (threadCount == 0 || (size_t)(end - begin) < OBJ_PARALLEL_MIN_BYTES)
+	{
+		threadCount = 1;
+	}
+	m_usedThreadCount = threadCount;
+
+	SplitChunks(begin, end, threadCount == 1 ? 1 : threadCount * OBJ_CHUNKS_PER_THREAD, boundaries);
+	chunkCount = boundaries.size() - 1;
+
+	// Count the records of every chunk.
+	counts.resize(chunkCount);
+	RunWorkers(threadCount, chunkCount, [&](size_t chunk)
+	{
+		CountRecords(boundaries[chunk], boundaries[chunk + 1], counts[chunk]);
+	});
+
+	// Turn the counts into exclusive prefix sums, so each entry now holds the offset of the chunk's first record.
+	memset(&total, 0, sizeof(total));
+	for (i = 0; i < chunkCount; i++)
+	{
+		RecordCountType chunkCounts = counts[i];
+		counts[i] = total;
+		total.positions += chunkCounts.positions;
+		total.uvs += chunkCounts.uvs;
+		total.normals += chunkCounts.normals;
+		total.corners += chunkCounts.corners;
+	}
+
+	data.positions.resize(total.positions);
+	data.uvs.resize(total.uvs);
+	data.normals.resize(total.normals);
+	data.positionIndices.resize(total.corners);
+	data.uvIndices.resize(total.corners);
+	data.normalIndices.resize(total.corners);
+	data.triangleMaterials.resize(total.corners / 3);
+
+	// Parse every chunk into its own slice of the shared arrays.
+	chunkResults.assign(chunkCount, 0);
+	chunkMaterials.resize(chunkCount);
+	RunWorkers(threadCount, chunkCount, [&](size_t chunk)
+	{
+		chunkResults[chunk] = ParseRecords(boundaries[chunk], boundaries[chunk + 1], counts[chunk], defined, data, chunkMaterials[chunk]) ? 1 : 0;
+	});
+
+	for (i = 0; i < chunkCount; i++)
+	{
+		if (!chunkResults[i])
+		{
+			return false;
+		}
+	}
+
+	ResolveMaterials(counts, chunkMaterials, data);
+
+	return true;
+}
+
+
+unsigned int ObjParserClass::GetThreadCount()
+{
+	return m_usedThreadCount;
+}
+
+
+size_t ObjParserClass::GetFileSize()
+{
+	return m_fileSize;
+}
+
+
+double ObjParserClass::GetParseSeconds()
+{
+	return m_parseSeconds;
+}
+
+
+double ObjParserClass::GetMegabytesPerSecond()
+{
+	if (m_parseSeconds <= 0.0)
+	{
+		return 0.0;
+	}
+
+	return ((double)m_fileSize / (1024.0 * 1024.0)) / m_parseSeconds;
+}
+
+// CountRecords is the pre-scan. It only looks at the first characters of each line, except for faces where the corners are counted
+// so that polygons can be reserved as the fan of triangles they will be split into.
+void ObjParserClass::CountRecords(const char* begin, const char* end, OUT RecordCountType& counts)
+{
+	const char* p;
+	const char* lineEnd;
+	size_t tokens;
+
+
+	memset(&counts, 0, sizeof(counts));
+
+	for (p = begin; p < end; p = lineEnd + 1)
+	{
+		lineEnd = FindLineEnd(p, end);
+		p = SkipBlanks(p, lineEnd);
+		if (lineEnd - p < 2)
+		{
+			continue;
+		}
+
+		if (p[0] == 'v')
+		{
+			if (IsBlank(p[1]))
+			{
+				counts.positions++;
+			}
+			else if (p[1] == 't' && lineEnd - p > 2 && IsBlank(p[2]))
+			{
+				counts.uvs++;
+			}
+			else if (p[1] == 'n' && lineEnd - p > 2 && IsBlank(p[2]))
+			{
+				counts.normals++;
+			}
+		}
+		else if (p[0] == 'f' && IsBlank(p[1]))
+		{
+			tokens = 0;
+			for (p += 1; p < lineEnd; )
+			{
+				p = SkipBlanks(p, lineEnd);
+				if (p >= lineEnd || *p == '#')
+				{
+					break;
+				}
+				tokens++;
+				while (p < lineEnd && !IsBlank(*p))
+				{
+					p++;
+				}
+			}
+
+			if (tokens >= 3)
+			{
+				counts.corners += (tokens - 2) * 3;
+			}
+		}
+	}
+
+	return;
+}
+
+// ParseRecords fills the arrays starting at the offsets in base. Every line is classified exactly like CountRecords does,
+// so the writes land precisely inside the space that was counted for this range. Defined is added when resolving indices.
+// Triangles get the position of their usemtl in the chunk's own list, ResolveMaterials turns that into a material of the file.
+bool ObjParserClass::ParseRecords(const char* begin, const char* end, const RecordCountType& base, const RecordCountType& defined, ObjDataType& data,
+	OUT ChunkMaterialsType& materials)
+{
+	const char* p;
+	const char* lineEnd;
+	size_t position, uv, normal, corner;
+	unsigned int first[3] = {}, previous[3] = {}, current[3] = {};
+	const unsigned int* triangle[3] = { first, previous, current };
+	unsigned int material;
+	long long index[3];
+	int cornerCount, k;
+
+
+	position = base.positions;
+	uv = base.uvs;
+	normal = base.normals;
+	corner = base.corners;
+	material = OBJ_MATERIAL_INHERIT;
+	materials.names.clear();
+	materials.libraries.clear();
+
+	for (p = begin; p < end; p = lineEnd + 1)
+	{
+		lineEnd = FindLineEnd(p, end);
+		p = SkipBlanks(p, lineEnd);
+		if (lineEnd - p < 2)
+		{
+			continue;
+		}
+
+		if (p[0] == 'v' && IsBlank(p[1]))
+		{
+			XMFLOAT3& vertex = data.positions[position++];
+			p = ParseFloat(p + 1, lineEnd, vertex.x);
+			if (p) p = ParseFloat(p, lineEnd, vertex.y);
+			if (p) p = ParseFloat(p, lineEnd, vertex.z);
+			if (!p)
+			{
+				return false;
+			}
+		}
+		else if (p[0] == 'v' && p[1] == 't' && lineEnd - p > 2 && IsBlank(p[2]))
+		{
+			XMFLOAT2& texture = data.uvs[uv++];
+			p = ParseFloat(p + 2, lineEnd, texture.x);
+			if (p) p = ParseFloat(p, lineEnd, texture.y);
+			if (!p)
+			{
+				return false;
+			}
+		}
+		else if (p[0] == 'v' && p[1] == 'n' && lineEnd - p > 2 && IsBlank(p[2]))
+		{
+			XMFLOAT3& norm = data.normals[normal++];
+			p = ParseFloat(p + 2, lineEnd, norm.x);
+			if (p) p = ParseFloat(p, lineEnd, norm.y);
+			if (p) p = ParseFloat(p, lineEnd, norm.z);
+			if (!p)
+			{
+				return false;
+			}
+		}
+		else if (p[0] == 'f' && IsBlank(p[1]))
+		{
+			// Polygons are split into a fan around their first corner.
+			cornerCount = 0;
+			for (p += 1; ; )
+			{
+				p = SkipBlanks(p, lineEnd);
+				if (p >= lineEnd || *p == '#')
+				{
+					break;
+				}
+
+				// A corner is v, v/vt, v//vn or v/vt/vn. The attributes it leaves out get MESH_INDEX_NONE and are filled in later.
+				index[1] = 0;
+				index[2] = 0;
+				p = ParseIndex(p, lineEnd, index[0]);
+				if (p && p < lineEnd && *p == '/')
+				{
+					p++;
+					if (p < lineEnd && *p != '/')
+					{
+						p = ParseIndex(p, lineEnd, index[1]);
+					}
+
+					if (p && p < lineEnd && *p == '/')
+					{
+						p = ParseIndex(p + 1, lineEnd, index[2]);
+					}
+					else if (p && index[1] == 0)
+					{
+						p = 0;
+					}
+				}
+
+				if (!p || (p < lineEnd && !IsBlank(*p) && *p != '#'))
+				{
+					return false;
+				}
+
+				current[0] = ResolveIndex(index[0], defined.positions + position);
+				current[1] = index[1] != 0 ? ResolveIndex(index[1], defined.uvs + uv) : MESH_INDEX_NONE;
+				current[2] = index[2] != 0 ? ResolveIndex(index[2], defined.normals + normal) : MESH_INDEX_NONE;
+
+				if (cornerCount == 0)
+				{
+					memcpy(first, current, sizeof(first));
+				}
+				else if (cornerCount >= 2)
+				{
+					for (k = 0; k < 3; k++)
+					{
+						data.positionIndices[corner + k] = triangle[k][0];
+						data.uvIndices[corner + k] = triangle[k][1];
+						data.normalIndices[corner + k] = triangle[k][2];
+					}
+					data.triangleMaterials[corner / 3] = material;
+					corner += 3;
+				}
+
+				memcpy(previous, current, sizeof(previous));
+				cornerCount++;
+			}
+
+			if (cornerCount < 3)
+			{
+				return false;
+			}
+		}
+		else if (MatchKeyword(p, lineEnd, "usemtl", 6))
+		{
+			material = (unsigned int)materials.names.size();
+			materials.names.push_back(ReadName(p + 6, lineEnd));
+		}
+		else if (MatchKeyword(p, lineEnd, "mtllib", 6))
+		{
+			materials.libraries.push_back(ReadName(p + 6, lineEnd));
+		}
+	}
+
+	return true;
+}
+
+// ResolveMaterials gives every usemtl name one index in the order the file first uses it and rewrites the chunk local material of
+// every triangle with it. This runs over the chunks in file order, so triangles before the first usemtl of a chunk can take the
+// material the chunk before it ended with. The triangles before any usemtl in the file get a material with an empty name.
+void ObjParserClass::ResolveMaterials(const std::vector<RecordCountType>& chunkOffsets, const std::vector<ChunkMaterialsType>& chunkMaterials,
+	ObjDataType& data)
+{
+	std::unordered_map<std::string, unsigned int> materialIds;
+	std::vector<unsigned int> localIds;
+	unsigned int current;
+	size_t chunk, i, triangle, first, last;
+
+
+	data.materials.libraries.clear();
+	data.materials.names.clear();
+	current = MESH_INDEX_NONE;
+
+	for (chunk = 0; chunk < chunkMaterials.size(); chunk++)
+	{
+		const ChunkMaterialsType& materials = chunkMaterials[chunk];
+
+		first = chunkOffsets[chunk].corners / 3;
+		last = chunk + 1 < chunkOffsets.size() ? chunkOffsets[chunk + 1].corners / 3 : data.triangleMaterials.size();
+		if (current == MESH_INDEX_NONE && first < last && data.triangleMaterials[first] == OBJ_MATERIAL_INHERIT)
+		{
+			current = (unsigned int)data.materials.names.size();
+			materialIds.emplace(std::string(), current);
+			data.materials.names.push_back(std::string());
+		}
+
+		for (i = 0; i < materials.libraries.size(); i++)
+		{
+			if (std::find(data.materials.libraries.begin(), data.materials.libraries.end(), materials.libraries[i]) == data.materials.libraries.end())
+			{
+				data.materials.libraries.push_back(materials.libraries[i]);
+			}
+		}
+
+		localIds.resize(materials.names.size());
+		for (i = 0; i < materials.names.size(); i++)
+		{
+			auto inserted = materialIds.emplace(materials.names[i], (unsigned int)data.materials.names.size());
+			if (inserted.second)
+			{
+				data.materials.names.push_back(materials.names[i]);
+			}
+			localIds[i] = inserted.first->second;
+		}
+
+		for (triangle = first; triangle < last; triangle++)
+		{
+			unsigned int& material = data.triangleMaterials[triangle];
+			material = material != OBJ_MATERIAL_INHERIT ? localIds[material] : current;
+		}
+
+		if (!localIds.empty())
+		{
+			current = localIds.back();
+		}
+	}
+
+	return;
+}
+
+// SplitChunks cuts the file into roughly equal pieces and moves every cut forward to the start of the next line,
+// so no record is ever split between two chunks. Boundaries holds chunkCount + 1 pointers, possibly with empty chunks.
+void ObjParserClass::SplitChunks(const char* begin, const char* end, unsigned int chunkCount, OUT std::vector<const char*>& boundaries)
+{
+	const char* cut;
+	size_t size;
+	unsigned int i;
+
+
+	size = (size_t)(end - begin);
+	boundaries.clear();
+	boundaries.push_back(begin);
+
+	for (i = 1; i < chunkCount; i++)
+	{
+		cut = begin + size / chunkCount * i;
+		if (cut < boundaries.back())
+		{
+			cut = boundaries.back();
+		}
+
+		cut = FindLineEnd(cut, end);
+		if (cut < end)
+		{
+			cut++;
+		}
+		boundaries.push_back(cut);
+	}
+
+	boundaries.push_back(end);
+
+	return;
+}
+
+// RunWorkers calls work for every item on threadCount threads, the calling thread being one of them.
+// Items are handed out through an atomic counter so faster threads simply pick up more chunks.
+void ObjParserClass::RunWorkers(unsigned int threadCount, size_t itemCount, const std::function<void(size_t)>& work)
+{
+	std::vector<std::thread> workers;
+	std::atomic<size_t> nextItem(0);
+	unsigned int i;
+
+
+	auto worker = [&]()
+	{
+		size_t item;
+		while ((item = nextItem.fetch_add(1)) < itemCount)
+		{
+			work(item);
+		}
+	};
+
+	for (i = 1; i < threadCount && i < itemCount; i++)
+	{
+		workers.emplace_back(worker);
+	}
+
+	worker();
+
+	for (i = 0; i < workers.size(); i++)
+	{
+		workers[i].join();
+	}
+
+	return;
+}
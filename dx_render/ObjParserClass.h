@@ -0,0 +1,87 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: objparserclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _OBJPARSERCLASS_H_
+#define _OBJPARSERCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <functional>
+#include <string>
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "meshtypes.h"
+#include "mappedfileclass.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: ObjParserClass
+////////////////////////////////////////////////////////////////////////////////
+// The ObjParserClass reads the v, vt, vn and f records of a Wavefront OBJ file straight out of a memory mapped view.
+// A first pass counts the records so every output array is allocated exactly once, the second pass parses the numbers in place.
+// Face indices come out zero based and already resolved, negative (relative) OBJ indices included, ready for the MeshWeldClass.
+// Corners of the v, v/vt and v//vn forms get MESH_INDEX_NONE for the attributes they leave out.
+// The mtllib files and usemtl names are collected as they come, and every triangle gets the index of the material it was written under.
+// Large files are split into line aligned chunks that are counted and parsed on worker threads. A prefix sum over the per-chunk counts
+// gives every chunk the global offset of its first record, so each worker writes straight into the shared arrays and the indices stay correct.
+// Files too big to map at once can be fed through ParseBlock a line aligned block at a time.
+class ObjParserClass
+{
+public:
+	struct ObjDataType
+	{
+		std::vector<XMFLOAT3> positions;
+		std::vector<XMFLOAT2> uvs;
+		std::vector<XMFLOAT3> normals;
+		std::vector<unsigned int> positionIndices, uvIndices, normalIndices;
+		MeshMaterialListType materials;
+		std::vector<unsigned int> triangleMaterials;
+	};
+
+	struct RecordCountType
+	{
+		size_t positions, uvs, normals, corners;
+	};
+
+private:
+	// The usemtl names and mtllib files one chunk came across, in order. The chunk's triangles refer to the names by their position here.
+	struct ChunkMaterialsType
+	{
+		std::vector<std::string> names, libraries;
+	};
+
+public:
+	ObjParserClass();
+	ObjParserClass(const ObjParserClass&);
+	~ObjParserClass();
+
+	// A thread count of zero uses every hardware thread, one keeps the parse on the calling thread.
+	void SetThreadCount(unsigned int);
+	bool Parse(const char* filename, OUT ObjDataType&);
+	bool ParseBlock(const char* begin, const char* end, const RecordCountType& defined, OUT ObjDataType&);
+
+	unsigned int GetThreadCount();
+	size_t GetFileSize();
+	double GetParseSeconds();
+	double GetMegabytesPerSecond();
+
+private:
+	void CountRecords(const char* begin, const char* end, OUT RecordCountType&);
+	bool ParseRange(const char* begin, const char* end, const RecordCountType& defined, OUT ObjDataType&);
+	bool ParseRecords(const char* begin, const char* end, const RecordCountType& base, const RecordCountType& defined, ObjDataType&,
+		OUT ChunkMaterialsType& materials);
+	void ResolveMaterials(const std::vector<RecordCountType>& chunkOffsets, const std::vector<ChunkMaterialsType>& chunkMaterials, ObjDataType&);
+	void SplitChunks(const char* begin, const char* end, unsigned int chunkCount, OUT std::vector<const char*>& boundaries);
+	void RunWorkers(unsigned int threadCount, size_t itemCount, const std::function<void(size_t)>& work);
+
+private:
+	unsigned int m_threadCount, m_usedThreadCount;
+	size_t m_fileSize;
+	double m_parseSeconds;
+};
+
+#endif
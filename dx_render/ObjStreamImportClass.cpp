@@ -0,0 +1,1136 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: objstreamimportclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "objstreamimportclass.h"
+#include "objparserclass.h"
+#include "meshweldclass.h"
+#include "meshnormalclass.h"
+#include "meshoptimizerclass.h"
+#include <algorithm>
+#include <chrono>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+
+/////////////
+// GLOBALS //
+/////////////
+static const char OBJ_STREAM_MANIFEST_MAGIC[4] = { 'D', 'X', 'T', 'L' };
+static const uint32_t OBJ_STREAM_MANIFEST_VERSION = 1;
+
+// Budgets below this leave too little for the fixed buffers to be worth streaming.
+static const size_t OBJ_STREAM_MIN_BUDGET = 64 * 1024 * 1024;
+// The file is read in blocks of a sixteenth of the budget, the block, the carried over line and the parsed records stay under half of it.
+static const size_t OBJ_STREAM_BLOCK_DIVISOR = 16;
+static const size_t OBJ_STREAM_MAX_BLOCK = 64 * 1024 * 1024;
+// Records are streamed to and from the temporary files in batches of this many.
+static const size_t OBJ_STREAM_IO_RECORDS = 64 * 1024;
+// Routing keeps a 16 bit tile number per vertex of the current block in half the budget and the tile buckets in a quarter of it.
+static const size_t OBJ_STREAM_ROUTE_DIVISOR = 2;
+static const size_t OBJ_STREAM_BUCKET_DIVISOR = 4;
+static const size_t OBJ_STREAM_MIN_BUCKET_TRIANGLES = 64;
+// Building a chunk peaks at about this many bytes per triangle (the routed triangles, the remapped corners, the weld table and its
+// output, the optimizer and the 32 bit copy written to the cache), and gets three quarters of the budget. Generating missing
+// normals comes before the weld and needs less than it.
+static const size_t OBJ_STREAM_BYTES_PER_TRIANGLE = 512;
+// The crease angle for generated normals, the same 60 degrees the ModelClass uses.
+static const float OBJ_STREAM_CREASE_ANGLE = XM_PI / 3.0f;
+// Each tile should span several grid cells so the Morton grouping can follow the density of the mesh.
+static const uint64_t OBJ_STREAM_CELLS_PER_TILE = 16;
+static const unsigned int OBJ_STREAM_MAX_CELLS = 1 << 18;
+static const unsigned int OBJ_STREAM_MAX_GRID = 1024;
+static const unsigned int OBJ_STREAM_MAX_TILES = 0xffff;
+// Gathering a chunk's attributes reads the records between two wanted ones when they are at most this many apart.
+static const uint32_t OBJ_STREAM_GATHER_SPAN = 4096;
+
+
+// SpreadBits moves the low ten bits of value three bits apart for a Morton code.
+static uint32_t SpreadBits(uint32_t value)
+{
+	value &= 0x3ff;
+	value = (value | (value << 16)) & 0x030000ff;
+	value = (value | (value << 8)) & 0x0300f00f;
+	value = (value | (value << 4)) & 0x030c30c3;
+	value = (value | (value << 2)) & 0x09249249;
+
+	return value;
+}
+
+
+// WriteRecords appends count records to a temporary file and reports whether the stream is still good.
+static bool WriteRecords(std::ofstream& file, const void* records, size_t count, size_t recordSize)
+{
+	file.write((const char*)records, (std::streamsize)(count * recordSize));
+
+	return (bool)file;
+}
+
+
+ObjStreamImportClass::ObjStreamImportClass()
+{
+	m_memoryBudget = 1024 * 1024 * 1024;
+	m_weldTolerance = 0.0f;
+	m_threadCount = 0;
+	memset(&m_stats, 0, sizeof(m_stats));
+	m_startPeakMemory = 0;
+	memset(&m_source, 0, sizeof(m_source));
+	m_boundsMin = XMFLOAT3(0.0f, 0.0f, 0.0f);
+	m_boundsMax = XMFLOAT3(0.0f, 0.0f, 0.0f);
+	memset(m_gridSize, 0, sizeof(m_gridSize));
+	memset(m_cellScale, 0, sizeof(m_cellScale));
+}
+
+
+ObjStreamImportClass::ObjStreamImportClass(const ObjStreamImportClass& other)
+{
+}
+
+
+ObjStreamImportClass::~ObjStreamImportClass()
+{
+}
+
+// SetMemoryBudget sets how many bytes the import may add to the working set of the process at its peak.
+void ObjStreamImportClass::SetMemoryBudget(size_t bytes)
+{
+	m_memoryBudget = bytes;
+
+	return;
+}
+
+
+void ObjStreamImportClass::SetWeldTolerance(float tolerance)
+{
+	m_weldTolerance = tolerance;
+
+	return;
+}
+
+// A thread count of zero parses every block on all hardware threads.
+void ObjStreamImportClass::SetThreadCount(unsigned int threadCount)
+{
+	m_threadCount = threadCount;
+
+	return;
+}
+
+
+ObjStreamImportClass::ImportStatsType ObjStreamImportClass::GetStats()
+{
+	return m_stats;
+}
+
+// Import runs the passes over the source and writes the chunks and the manifest next to it. The temporary files are removed
+// whether it succeeds or not. The chunks are stamped with the source, so MeshCacheClass accepts them for as long as it is unchanged.
+bool ObjStreamImportClass::Import(const char* sourceFilename, OUT std::vector<TileType>& out_tiles)
+{
+	std::filesystem::path tempPath(sourceFilename);
+	bool result;
+
+
+	out_tiles.clear();
+	memset(&m_stats, 0, sizeof(m_stats));
+	m_stats.memoryBudget = m_memoryBudget;
+	m_stats.startMemory = GetCurrentMemory();
+	m_startPeakMemory = GetPeakMemory();
+
+	if (m_memoryBudget < OBJ_STREAM_MIN_BUDGET)
+	{
+		printf("The streaming import needs a memory budget of at least %zu MB\n", OBJ_STREAM_MIN_BUDGET / (1024 * 1024));
+		return false;
+	}
+
+	result = MeshCacheClass::GetSourceStamp(sourceFilename, m_source);
+	if (!result)
+	{
+		return false;
+	}
+
+	tempPath.replace_extension(".stream");
+	m_tempBase = tempPath.string();
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	result = ParseSource(sourceFilename);
+	m_stats.parseSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	if (result)
+	{
+		result = PlanTiles();
+	}
+
+	if (result)
+	{
+		start = std::chrono::steady_clock::now();
+		result = RouteTriangles();
+		m_stats.routeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	if (result)
+	{
+		start = std::chrono::steady_clock::now();
+		result = BuildTiles(sourceFilename, out_tiles);
+		m_stats.buildSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	if (result)
+	{
+		result = WriteManifest(sourceFilename, out_tiles);
+	}
+
+	RemoveTempFiles();
+	m_cellTiles.clear();
+	m_cellTiles.shrink_to_fit();
+	m_tileTriangleCounts.clear();
+	m_tileTriangleCounts.shrink_to_fit();
+
+	// The last look also catches a peak of the process between the samples the passes took.
+	if (!CheckMemory())
+	{
+		result = false;
+	}
+
+	return result;
+}
+
+// ParseSource is the first pass. It reads the source a block at a time, hashes it on the way, and spills the positions,
+// texture coordinates, normals and triangles into temporary files while it tracks the bounds.
+bool ObjStreamImportClass::ParseSource(const char* sourceFilename)
+{
+	ObjParserClass parser;
+	ObjParserClass::ObjDataType block;
+	ObjParserClass::RecordCountType defined;
+	std::ifstream fin;
+	std::ofstream positionFile, uvFile, normalFile, triangleFile;
+	std::vector<char> buffer;
+	std::vector<TriangleType> triangles;
+	TriangleType triangle;
+	size_t blockBytes, carry, readBytes, parseBytes, cornerCount, i, j;
+	XMVECTOR boundsMin, boundsMax, position;
+	bool endOfFile, result;
+
+
+	blockBytes = m_memoryBudget / OBJ_STREAM_BLOCK_DIVISOR;
+	if (blockBytes > OBJ_STREAM_MAX_BLOCK)
+	{
+		blockBytes = OBJ_STREAM_MAX_BLOCK;
+	}
+	blockBytes &= ~(size_t)7;
+
+	fin.open(sourceFilename, std::ios::binary);
+	positionFile.open(m_tempBase + ".positions", std::ios::binary | std::ios::trunc);
+	uvFile.open(m_tempBase + ".uvs", std::ios::binary | std::ios::trunc);
+	normalFile.open(m_tempBase + ".normals", std::ios::binary | std::ios::trunc);
+	triangleFile.open(m_tempBase + ".triangles", std::ios::binary | std::ios::trunc);
+	if (!fin || !positionFile || !uvFile || !normalFile || !triangleFile)
+	{
+		return false;
+	}
+
+	parser.SetThreadCount(m_threadCount);
+	memset(&defined, 0, sizeof(defined));
+	boundsMin = XMVectorReplicate(FLT_MAX);
+	boundsMax = XMVectorReplicate(-FLT_MAX);
+	m_source.hash = MeshCacheClass::BeginHash();
+
+	// The buffer holds the partial line carried over from the last block followed by the next block. Every read but the last is
+	// a whole block, a multiple of eight bytes, which is what the cache hash needs to be computed in pieces.
+	buffer.resize(blockBytes * 2);
+	triangles.reserve(OBJ_STREAM_IO_RECORDS);
+	carry = 0;
+	endOfFile = false;
+	while (!endOfFile)
+	{
+		fin.read(buffer.data() + carry, (std::streamsize)blockBytes);
+		readBytes = (size_t)fin.gcount();
+		endOfFile = readBytes < blockBytes;
+		if (fin.bad())
+		{
+			return false;
+		}
+
+		m_source.hash = MeshCacheClass::HashBytes(m_source.hash, buffer.data() + carry, readBytes);
+		m_stats.fileSize += readBytes;
+
+		// Parse up to the last complete line and keep the rest for the next block.
+		parseBytes = carry + readBytes;
+		if (!endOfFile)
+		{
+			while (parseBytes > 0 && buffer[parseBytes - 1] != '\n')
+			{
+				parseBytes--;
+			}
+		}
+
+		carry = carry + readBytes - parseBytes;
+		if (carry > blockBytes)
+		{
+			printf("%s has a line longer than the %zu byte streaming block\n", sourceFilename, blockBytes);
+			return false;
+		}
+
+		result = parser.ParseBlock(buffer.data(), buffer.data() + parseBytes, defined, block);
+		if (!result)
+		{
+			printf("File can't be read by our simple parser : ( Try exporting with other options\n");
+			return false;
+		}
+
+		if (!CheckMemory())
+		{
+			return false;
+		}
+
+		for (i = 0; i < block.positions.size(); i++)
+		{
+			position = XMLoadFloat3(&block.positions[i]);
+			boundsMin = XMVectorMin(boundsMin, position);
+			boundsMax = XMVectorMax(boundsMax, position);
+		}
+
+		// Interleave the corners into triangles, the unit everything after this pass works on.
+		cornerCount = block.positionIndices.size();
+		for (i = 0; i < cornerCount; i += 3)
+		{
+			for (j = 0; j < 3; j++)
+			{
+				triangle.corners[j * 3 + 0] = block.positionIndices[i + j];
+				triangle.corners[j * 3 + 1] = block.uvIndices[i + j];
+				triangle.corners[j * 3 + 2] = block.normalIndices[i + j];
+			}
+			triangles.push_back(triangle);
+
+			if (triangles.size() == OBJ_STREAM_IO_RECORDS || i + 3 == cornerCount)
+			{
+				if (!WriteRecords(triangleFile, triangles.data(), triangles.size(), sizeof(TriangleType)))
+				{
+					return false;
+				}
+				triangles.clear();
+			}
+		}
+
+		if (!WriteRecords(positionFile, block.positions.data(), block.positions.size(), sizeof(XMFLOAT3)) ||
+			!WriteRecords(uvFile, block.uvs.data(), block.uvs.size(), sizeof(XMFLOAT2)) ||
+			!WriteRecords(normalFile, block.normals.data(), block.normals.size(), sizeof(XMFLOAT3)))
+		{
+			return false;
+		}
+
+		defined.positions += block.positions.size();
+		defined.uvs += block.uvs.size();
+		defined.normals += block.normals.size();
+		defined.corners += cornerCount;
+
+		memmove(buffer.data(), buffer.data() + parseBytes, carry);
+	}
+
+	m_stats.positionCount = defined.positions;
+	m_stats.uvCount = defined.uvs;
+	m_stats.normalCount = defined.normals;
+	m_stats.triangleCount = defined.corners / 3;
+
+	// Everything after this pass addresses records with 32 bit indices.
+	if (defined.positions >= 0xffffffff || defined.uvs >= 0xffffffff || defined.normals >= 0xffffffff)
+	{
+		printf("%s has more than 4 billion records of one kind\n", sourceFilename);
+		return false;
+	}
+
+	if (m_stats.positionCount == 0 || m_stats.triangleCount == 0)
+	{
+		return false;
+	}
+
+	XMStoreFloat3(&m_boundsMin, boundsMin);
+	XMStoreFloat3(&m_boundsMax, boundsMax);
+
+	positionFile.close();
+	uvFile.close();
+	normalFile.close();
+	triangleFile.close();
+
+	return positionFile && uvFile && normalFile && triangleFile;
+}
+
+// PlanTiles sizes the chunks to the budget, lays a grid over the bounds with enough cells for every tile to span several of them,
+// and counts the vertices in each cell. The cells are then taken in Morton order and grouped into tiles of about one chunk of
+// triangles each, so dense areas get small tiles and empty space costs nothing.
+bool ObjStreamImportClass::PlanTiles()
+{
+	std::ifstream positionFile;
+	std::vector<XMFLOAT3> positions;
+	std::vector<uint32_t> cellVertices;
+	std::vector<uint64_t> mortonOrder;
+	uint64_t tileTarget, cellTarget, remaining;
+	double trianglesPerVertex, estimate, cellEstimate;
+	float extent[3], maxExtent;
+	unsigned int resolution, low, high, cellCount, cell, tile, x, y, z, k;
+	size_t count, i;
+
+
+	m_stats.trianglesPerChunk = (m_memoryBudget / 4 * 3) / OBJ_STREAM_BYTES_PER_TRIANGLE;
+	tileTarget = (m_stats.triangleCount + m_stats.trianglesPerChunk - 1) / m_stats.trianglesPerChunk;
+	cellTarget = tileTarget * OBJ_STREAM_CELLS_PER_TILE;
+	if (cellTarget > OBJ_STREAM_MAX_CELLS)
+	{
+		cellTarget = OBJ_STREAM_MAX_CELLS;
+	}
+
+	// Find the finest grid with cubic cells that stays under the target number of cells.
+	extent[0] = m_boundsMax.x - m_boundsMin.x;
+	extent[1] = m_boundsMax.y - m_boundsMin.y;
+	extent[2] = m_boundsMax.z - m_boundsMin.z;
+	maxExtent = fmaxf(extent[0], fmaxf(extent[1], extent[2]));
+
+	low = 1;
+	high = OBJ_STREAM_MAX_GRID;
+	while (low < high)
+	{
+		resolution = (low + high + 1) / 2;
+		cellCount = 1;
+		for (k = 0; k < 3; k++)
+		{
+			cellCount *= maxExtent > 0.0f ? (unsigned int)fmaxf(1.0f, ceilf(extent[k] / maxExtent * resolution)) : 1;
+		}
+
+		if (cellCount <= cellTarget)
+		{
+			low = resolution;
+		}
+		else
+		{
+			high = resolution - 1;
+		}
+	}
+
+	cellCount = 1;
+	for (k = 0; k < 3; k++)
+	{
+		m_gridSize[k] = maxExtent > 0.0f ? (unsigned int)fmaxf(1.0f, ceilf(extent[k] / maxExtent * low)) : 1;
+		m_cellScale[k] = extent[k] > 0.0f ? m_gridSize[k] / extent[k] : 0.0f;
+		cellCount *= m_gridSize[k];
+	}
+	m_stats.cellCount = cellCount;
+
+	// Count the vertices in each cell, they stand in for the triangles which are only placed once the vertices can be looked up.
+	positionFile.open(m_tempBase + ".positions", std::ios::binary);
+	if (!positionFile)
+	{
+		return false;
+	}
+
+	cellVertices.assign(cellCount, 0);
+	positions.resize(OBJ_STREAM_IO_RECORDS);
+	remaining = m_stats.positionCount;
+	while (remaining > 0)
+	{
+		count = remaining < OBJ_STREAM_IO_RECORDS ? (size_t)remaining : OBJ_STREAM_IO_RECORDS;
+		positionFile.read((char*)positions.data(), (std::streamsize)(count * sizeof(XMFLOAT3)));
+		if (!positionFile)
+		{
+			return false;
+		}
+
+		for (i = 0; i < count; i++)
+		{
+			cellVertices[GetCell(positions[i])]++;
+		}
+		remaining -= count;
+	}
+
+	// Walk the cells along the Morton curve and start a new tile whenever the next cell would overfill the current one.
+	mortonOrder.resize(cellCount);
+	for (z = 0; z < m_gridSize[2]; z++)
+	{
+		for (y = 0; y < m_gridSize[1]; y++)
+		{
+			for (x = 0; x < m_gridSize[0]; x++)
+			{
+				cell = (z * m_gridSize[1] + y) * m_gridSize[0] + x;
+				mortonOrder[cell] = ((uint64_t)(SpreadBits(x) | (SpreadBits(y) << 1) | (SpreadBits(z) << 2)) << 32) | cell;
+			}
+		}
+	}
+	std::sort(mortonOrder.begin(), mortonOrder.end());
+	if (!CheckMemory())
+	{
+		return false;
+	}
+
+	trianglesPerVertex = (double)m_stats.triangleCount / (double)m_stats.positionCount;
+	m_cellTiles.assign(cellCount, 0);
+	tile = 0;
+	estimate = 0.0;
+	for (i = 0; i < cellCount; i++)
+	{
+		cell = (unsigned int)(mortonOrder[i] & 0xffffffff);
+		cellEstimate = cellVertices[cell] * trianglesPerVertex;
+		if (estimate > 0.0 && estimate + cellEstimate > (double)m_stats.trianglesPerChunk)
+		{
+			tile++;
+			estimate = 0.0;
+		}
+
+		if (tile >= OBJ_STREAM_MAX_TILES)
+		{
+			printf("The streaming import needs more than %u tiles, raise the memory budget\n", OBJ_STREAM_MAX_TILES);
+			return false;
+		}
+
+		m_cellTiles[cell] = (uint16_t)tile;
+		estimate += cellEstimate;
+	}
+	m_stats.tileCount = tile + 1;
+
+	return true;
+}
+
+// RouteTriangles is the external memory join. Each pass loads the tile numbers of as many vertices as fit in its share of the
+// budget, streams every triangle and appends those whose first corner falls in that block to the bucket file of its tile.
+bool ObjStreamImportClass::RouteTriangles()
+{
+	std::ifstream positionFile, triangleFile;
+	std::vector<uint16_t> vertexTiles;
+	std::vector<XMFLOAT3> positions;
+	std::vector<TriangleType> triangles;
+	std::vector<std::vector<TriangleType>> buckets;
+	std::error_code error;
+	uint64_t blockVertices, firstVertex, vertexCount, remaining;
+	size_t bucketTriangles, count, i, j;
+	unsigned int tile;
+	uint32_t vertex;
+
+
+	blockVertices = (m_memoryBudget / OBJ_STREAM_ROUTE_DIVISOR) / sizeof(uint16_t);
+	bucketTriangles = (m_memoryBudget / OBJ_STREAM_BUCKET_DIVISOR) / (m_stats.tileCount * sizeof(TriangleType));
+	if (bucketTriangles < OBJ_STREAM_MIN_BUCKET_TRIANGLES)
+	{
+		printf("The streaming import needs %u tiles which do not fit the memory budget, raise it\n", m_stats.tileCount);
+		return false;
+	}
+
+	for (tile = 0; tile < m_stats.tileCount; tile++)
+	{
+		std::filesystem::remove(GetBucketFilename(tile), error);
+	}
+
+	positionFile.open(m_tempBase + ".positions", std::ios::binary);
+	if (!positionFile)
+	{
+		return false;
+	}
+
+	buckets.resize(m_stats.tileCount);
+	m_tileTriangleCounts.assign(m_stats.tileCount, 0);
+	positions.resize(OBJ_STREAM_IO_RECORDS);
+	triangles.resize(OBJ_STREAM_IO_RECORDS);
+
+	// Appending a full bucket to its file frees it for the next triangles of that tile.
+	auto flushBucket = [&](unsigned int bucket)
+	{
+		std::ofstream bucketFile(GetBucketFilename(bucket), std::ios::binary | std::ios::app);
+		bucketFile.write((const char*)buckets[bucket].data(), (std::streamsize)(buckets[bucket].size() * sizeof(TriangleType)));
+		buckets[bucket].clear();
+		return (bool)bucketFile;
+	};
+
+	for (firstVertex = 0; firstVertex < m_stats.positionCount; firstVertex += blockVertices)
+	{
+		m_stats.routingPasses++;
+
+		// Look up the tile of every vertex in this block, the positions file is read in order so this is a plain stream.
+		vertexCount = m_stats.positionCount - firstVertex < blockVertices ? m_stats.positionCount - firstVertex : blockVertices;
+		vertexTiles.resize((size_t)vertexCount);
+		for (i = 0; i < vertexCount; i += count)
+		{
+			count = vertexCount - i < OBJ_STREAM_IO_RECORDS ? (size_t)(vertexCount - i) : OBJ_STREAM_IO_RECORDS;
+			positionFile.read((char*)positions.data(), (std::streamsize)(count * sizeof(XMFLOAT3)));
+			if (!positionFile)
+			{
+				return false;
+			}
+
+			for (j = 0; j < count; j++)
+			{
+				vertexTiles[i + j] = m_cellTiles[GetCell(positions[j])];
+			}
+		}
+
+		triangleFile.open(m_tempBase + ".triangles", std::ios::binary);
+		if (!triangleFile)
+		{
+			return false;
+		}
+
+		remaining = m_stats.triangleCount;
+		while (remaining > 0)
+		{
+			count = remaining < OBJ_STREAM_IO_RECORDS ? (size_t)remaining : OBJ_STREAM_IO_RECORDS;
+			triangleFile.read((char*)triangles.data(), (std::streamsize)(count * sizeof(TriangleType)));
+			if (!triangleFile)
+			{
+				return false;
+			}
+
+			for (i = 0; i < count; i++)
+			{
+				vertex = triangles[i].corners[0];
+				if (vertex < firstVertex || vertex - firstVertex >= vertexCount)
+				{
+					continue;
+				}
+
+				tile = vertexTiles[(size_t)(vertex - firstVertex)];
+				if (buckets[tile].capacity() < bucketTriangles)
+				{
+					buckets[tile].reserve(bucketTriangles);
+				}
+
+				buckets[tile].push_back(triangles[i]);
+				m_tileTriangleCounts[tile]++;
+				if (buckets[tile].size() == bucketTriangles && !flushBucket(tile))
+				{
+					return false;
+				}
+			}
+			remaining -= count;
+		}
+
+		triangleFile.close();
+		if (!CheckMemory())
+		{
+			return false;
+		}
+	}
+
+	for (tile = 0; tile < m_stats.tileCount; tile++)
+	{
+		if (!buckets[tile].empty() && !flushBucket(tile))
+		{
+			return false;
+		}
+	}
+
+	// A triangle whose first corner is not a vertex of the file was never routed.
+	remaining = 0;
+	for (tile = 0; tile < m_stats.tileCount; tile++)
+	{
+		remaining += m_tileTriangleCounts[tile];
+	}
+
+	if (remaining != m_stats.triangleCount)
+	{
+		printf("The OBJ file references vertices it does not contain\n");
+		return false;
+	}
+
+	return true;
+}
+
+// BuildTiles turns every bucket into chunks of at most the planned number of triangles. A tile normally is one chunk, a tile
+// denser than the vertex counts suggested is cut into several chunks in file order rather than going over the budget.
+bool ObjStreamImportClass::BuildTiles(const char* sourceFilename, OUT std::vector<TileType>& out_tiles)
+{
+	std::ifstream bucketFile;
+	std::vector<TriangleType> triangles;
+	TileType tileInfo;
+	uint64_t remaining;
+	size_t count;
+	unsigned int tile;
+	bool result;
+
+
+	for (tile = 0; tile < m_stats.tileCount; tile++)
+	{
+		if (m_tileTriangleCounts[tile] == 0)
+		{
+			continue;
+		}
+
+		bucketFile.open(GetBucketFilename(tile), std::ios::binary);
+		if (!bucketFile)
+		{
+			return false;
+		}
+
+		remaining = m_tileTriangleCounts[tile];
+		while (remaining > 0)
+		{
+			count = remaining < m_stats.trianglesPerChunk ? (size_t)remaining : (size_t)m_stats.trianglesPerChunk;
+			triangles.resize(count);
+			bucketFile.read((char*)triangles.data(), (std::streamsize)(count * sizeof(TriangleType)));
+			if (!bucketFile)
+			{
+				return false;
+			}
+
+			result = BuildChunk(triangles, GetTileFilename(sourceFilename, (unsigned int)out_tiles.size()), tileInfo);
+			if (!result)
+			{
+				return false;
+			}
+
+			out_tiles.push_back(tileInfo);
+			remaining -= count;
+		}
+
+		bucketFile.close();
+		m_stats.chunkCount = (unsigned int)out_tiles.size();
+	}
+
+	return true;
+}
+
+// BuildChunk gathers the attributes the triangles use from the temporary files, renumbers the corners to those local arrays and
+// then runs the same weld and optimization as a mesh that is loaded whole. The triangles are released as soon as they are renumbered.
+bool ObjStreamImportClass::BuildChunk(std::vector<TriangleType>& triangles, const std::string& tileFilename, OUT TileType& tile)
+{
+	std::ifstream attributeFile;
+	std::vector<uint32_t> ids;
+	std::vector<XMFLOAT3> positions, normals;
+	std::vector<XMFLOAT2> uvs;
+	std::vector<unsigned int> positionIndices, uvIndices, normalIndices;
+	std::vector<VertexType> verts;
+	std::vector<uint32_t> indices;
+	std::vector<MeshLodType> lods;
+	std::vector<MeshSubmeshType> submeshes;
+	MeshMaterialListType materials;
+	MeshWeldClass weld;
+	MeshNormalClass normalGenerator;
+	MeshOptimizerClass optimizer;
+	MeshLodType lod;
+	MeshSubmeshType submesh;
+	size_t cornerCount, i, j;
+	int attribute;
+	bool result;
+
+
+	cornerCount = triangles.size() * 3;
+
+	// Do the positions, texture coordinates and normals one after the other so only one sorted id list exists at a time.
+	for (attribute = 0; attribute < 3; attribute++)
+	{
+		std::vector<unsigned int>& localIndices = attribute == 0 ? positionIndices : (attribute == 1 ? uvIndices : normalIndices);
+
+		ids.resize(cornerCount);
+		for (i = 0; i < triangles.size(); i++)
+		{
+			for (j = 0; j < 3; j++)
+			{
+				ids[i * 3 + j] = triangles[i].corners[j * 3 + attribute];
+			}
+		}
+		std::sort(ids.begin(), ids.end());
+		ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+		// Corners without this attribute sort last, they are not read and keep MESH_INDEX_NONE below.
+		if (!ids.empty() && ids.back() == MESH_INDEX_NONE)
+		{
+			ids.pop_back();
+		}
+
+		if (attribute == 0)
+		{
+			attributeFile.open(m_tempBase + ".positions", std::ios::binary);
+			positions.resize(ids.size());
+			result = attributeFile && GatherRecords(attributeFile, m_stats.positionCount, sizeof(XMFLOAT3), ids, (char*)positions.data());
+		}
+		else if (attribute == 1)
+		{
+			attributeFile.open(m_tempBase + ".uvs", std::ios::binary);
+			uvs.resize(ids.size());
+			result = attributeFile && GatherRecords(attributeFile, m_stats.uvCount, sizeof(XMFLOAT2), ids, (char*)uvs.data());
+		}
+		else
+		{
+			attributeFile.open(m_tempBase + ".normals", std::ios::binary);
+			normals.resize(ids.size());
+			result = attributeFile && GatherRecords(attributeFile, m_stats.normalCount, sizeof(XMFLOAT3), ids, (char*)normals.data());
+		}
+		attributeFile.close();
+		if (!result)
+		{
+			printf("The OBJ file references vertex data it does not contain\n");
+			return false;
+		}
+
+		localIndices.resize(cornerCount);
+		for (i = 0; i < triangles.size(); i++)
+		{
+			for (j = 0; j < 3; j++)
+			{
+				localIndices[i * 3 + j] = triangles[i].corners[j * 3 + attribute] == MESH_INDEX_NONE ? MESH_INDEX_NONE :
+					(unsigned int)(std::lower_bound(ids.begin(), ids.end(), triangles[i].corners[j * 3 + attribute]) - ids.begin());
+			}
+		}
+	}
+
+	std::vector<uint32_t>().swap(ids);
+	std::vector<TriangleType>().swap(triangles);
+
+	// Missing normals are generated from the faces of this chunk alone, so a smooth surface can show a seam along chunk borders.
+	normalGenerator.SetCreaseAngle(OBJ_STREAM_CREASE_ANGLE);
+	normalGenerator.SetThreadCount(m_threadCount);
+	result = normalGenerator.GenerateNormals(positions, positionIndices, normals, normalIndices);
+	if (!result)
+	{
+		return false;
+	}
+
+	weld.SetTolerance(m_weldTolerance);
+	weld.SetRemoveDegenerates(true);
+	result = weld.Weld(positions, uvs, normals, positionIndices, uvIndices, normalIndices, verts, indices, 0);
+	if (!result)
+	{
+		return false;
+	}
+
+	std::vector<XMFLOAT3>().swap(positions);
+	std::vector<XMFLOAT2>().swap(uvs);
+	std::vector<XMFLOAT3>().swap(normals);
+	std::vector<unsigned int>().swap(positionIndices);
+	std::vector<unsigned int>().swap(uvIndices);
+	std::vector<unsigned int>().swap(normalIndices);
+
+	optimizer.Optimize(verts, indices);
+	if (!CheckMemory())
+	{
+		return false;
+	}
+
+	// Triangles are routed without their usemtl, so every chunk is one submesh with the unnamed material.
+	submesh.material = 0;
+	submesh.startIndex = 0;
+	submesh.indexCount = (unsigned int)indices.size();
+	submeshes.push_back(submesh);
+	materials.names.push_back(std::string());
+
+	lod.startIndex = 0;
+	lod.indexCount = (unsigned int)indices.size();
+	lod.error = 0.0f;
+	lod.firstSubmesh = 0;
+	lod.submeshCount = 1;
+	lods.push_back(lod);
+
+	result = MeshCacheClass::Write(tileFilename.c_str(), m_source, verts, indices, lods, submeshes, materials);
+	if (!result)
+	{
+		return false;
+	}
+
+	tile.boundsMin = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX);
+	tile.boundsMax = XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	for (i = 0; i < verts.size(); i++)
+	{
+		XMStoreFloat3(&tile.boundsMin, XMVectorMin(XMLoadFloat3(&tile.boundsMin), XMLoadFloat3(&verts[i].position)));
+		XMStoreFloat3(&tile.boundsMax, XMVectorMax(XMLoadFloat3(&tile.boundsMax), XMLoadFloat3(&verts[i].position)));
+	}
+	tile.vertexCount = (unsigned int)verts.size();
+	tile.indexCount = (unsigned int)indices.size();
+
+	return true;
+}
+
+// GatherRecords reads the records with the given sorted ids from a temporary file. Ids close together are read with one
+// sequential read of everything between them, which is the common case since OBJ exporters write nearby vertices together.
+bool ObjStreamImportClass::GatherRecords(std::ifstream& file, uint64_t recordCount, size_t recordSize, const std::vector<uint32_t>& ids, OUT char* out_records)
+{
+	std::vector<char> span;
+	size_t first, last, k;
+
+
+	if (ids.empty())
+	{
+		return true;
+	}
+
+	if (ids.back() >= recordCount)
+	{
+		return false;
+	}
+
+	span.resize(OBJ_STREAM_GATHER_SPAN * recordSize);
+	for (first = 0; first < ids.size(); first = last + 1)
+	{
+		last = first;
+		while (last + 1 < ids.size() && ids[last + 1] - ids[first] < OBJ_STREAM_GATHER_SPAN)
+		{
+			last++;
+		}
+
+		file.seekg((std::streamoff)ids[first] * (std::streamoff)recordSize);
+		file.read(span.data(), (std::streamsize)((ids[last] - ids[first] + 1) * recordSize));
+		if (!file)
+		{
+			return false;
+		}
+
+		for (k = first; k <= last; k++)
+		{
+			memcpy(out_records + k * recordSize, span.data() + (ids[k] - ids[first]) * recordSize, recordSize);
+		}
+	}
+
+	return true;
+}
+
+// WriteManifest lists the chunks with their bounds, stamped with the source like the chunks themselves.
+bool ObjStreamImportClass::WriteManifest(const char* sourceFilename, const std::vector<TileType>& tiles)
+{
+	ManifestHeaderType header;
+	std::ofstream fout;
+
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, OBJ_STREAM_MANIFEST_MAGIC, sizeof(OBJ_STREAM_MANIFEST_MAGIC));
+	header.version = OBJ_STREAM_MANIFEST_VERSION;
+	header.tileCount = tiles.size();
+	header.sourceSize = m_source.size;
+	header.sourceTime = m_source.time;
+	header.sourceHash = m_source.hash;
+
+	fout.open(GetManifestFilename(sourceFilename), std::ios::binary | std::ios::trunc);
+	if (!fout)
+	{
+		return false;
+	}
+
+	fout.write((const char*)&header, sizeof(header));
+	fout.write((const char*)tiles.data(), (std::streamsize)(tiles.size() * sizeof(TileType)));
+	fout.close();
+
+	return (bool)fout;
+}
+
+// ReadManifest loads the chunk list of an earlier import, as long as the source still has the size and time it was imported with.
+bool ObjStreamImportClass::ReadManifest(const char* sourceFilename, OUT std::vector<TileType>& out_tiles)
+{
+	ManifestHeaderType header;
+	MeshCacheClass::SourceStampType stamp;
+	std::string manifestFilename;
+	std::ifstream fin;
+	std::error_code error;
+	uint64_t fileSize;
+	bool result;
+
+
+	result = MeshCacheClass::GetSourceStamp(sourceFilename, stamp);
+	if (!result)
+	{
+		return false;
+	}
+
+	manifestFilename = GetManifestFilename(sourceFilename);
+	fileSize = (uint64_t)std::filesystem::file_size(manifestFilename, error);
+	if (error || fileSize < sizeof(header))
+	{
+		return false;
+	}
+
+	fin.open(manifestFilename, std::ios::binary);
+	if (!fin)
+	{
+		return false;
+	}
+
+	// Check the header before trusting its tile count.
+	fin.read((char*)&header, sizeof(header));
+	if (!fin || memcmp(header.magic, OBJ_STREAM_MANIFEST_MAGIC, sizeof(OBJ_STREAM_MANIFEST_MAGIC)) != 0 || header.version != OBJ_STREAM_MANIFEST_VERSION ||
+		header.sourceSize != stamp.size || header.sourceTime != stamp.time || header.tileCount != (fileSize - sizeof(header)) / sizeof(TileType))
+	{
+		return false;
+	}
+
+	out_tiles.resize((size_t)header.tileCount);
+	fin.read((char*)out_tiles.data(), (std::streamsize)(out_tiles.size() * sizeof(TileType)));
+
+	return (bool)fin;
+}
+
+// GetManifestFilename swaps the source extension for .dxtiles, GetTileFilename numbers the chunks next to it.
+std::string ObjStreamImportClass::GetManifestFilename(const char* sourceFilename)
+{
+	std::filesystem::path path(sourceFilename);
+
+
+	path.replace_extension(".dxtiles");
+
+	return path.string();
+}
+
+
+std::string ObjStreamImportClass::GetTileFilename(const char* sourceFilename, unsigned int tile)
+{
+	std::filesystem::path path(sourceFilename);
+	char suffix[32];
+
+
+	snprintf(suffix, sizeof(suffix), ".tile%05u.dxmesh", tile);
+	path.replace_extension(suffix);
+
+	return path.string();
+}
+
+// CheckMemory samples the working set and records how far it has grown since the import started. The peak of the process counts
+// as well once it has gone past where it was at the start, it holds the highs of the steps that fell between two samples.
+// It fails when the growth is over the budget.
+bool ObjStreamImportClass::CheckMemory()
+{
+	size_t current, peak;
+
+
+	current = GetCurrentMemory();
+	if (current > m_stats.startMemory && current - m_stats.startMemory > m_stats.peakMemory)
+	{
+		m_stats.peakMemory = current - m_stats.startMemory;
+	}
+
+	peak = GetPeakMemory();
+	if (peak > m_startPeakMemory && peak > m_stats.startMemory && peak - m_stats.startMemory > m_stats.peakMemory)
+	{
+		m_stats.peakMemory = peak - m_stats.startMemory;
+	}
+
+	if (m_stats.peakMemory > m_memoryBudget)
+	{
+		printf("The streaming import grew the working set by %zu MB, over its budget of %zu MB\n", m_stats.peakMemory / (1024 * 1024),
+			m_memoryBudget / (1024 * 1024));
+		return false;
+	}
+
+	return true;
+}
+
+// GetCurrentMemory and GetPeakMemory return the working set of the process now and at its largest, which is what the budget limits.
+size_t ObjStreamImportClass::GetCurrentMemory()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+
+
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+	{
+		return 0;
+	}
+
+	return counters.WorkingSetSize;
+#else
+	FILE* statm;
+	unsigned long long pages, residentPages;
+	int fields;
+
+
+	statm = fopen("/proc/self/statm", "r");
+	if (!statm)
+	{
+		return 0;
+	}
+
+	fields = fscanf(statm, "%llu %llu", &pages, &residentPages);
+	fclose(statm);
+	if (fields != 2)
+	{
+		return 0;
+	}
+
+	return (size_t)residentPages * (size_t)sysconf(_SC_PAGESIZE);
+#endif
+}
+
+
+size_t ObjStreamImportClass::GetPeakMemory()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+
+
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+	{
+		return 0;
+	}
+
+	return counters.PeakWorkingSetSize;
+#else
+	struct rusage usage;
+
+
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+	{
+		return 0;
+	}
+
+#ifdef __APPLE__
+	return (size_t)usage.ru_maxrss;
+#else
+	return (size_t)usage.ru_maxrss * 1024;
+#endif
+#endif
+}
+
+// GetCell returns the grid cell of a position, positions on the upper bounds go into the last cell.
+unsigned int ObjStreamImportClass::GetCell(const XMFLOAT3& position)
+{
+	unsigned int cell[3];
+	float coordinate[3];
+	const float* boundsMin;
+	int k;
+
+
+	boundsMin = &m_boundsMin.x;
+	coordinate[0] = position.x;
+	coordinate[1] = position.y;
+	coordinate[2] = position.z;
+	for (k = 0; k < 3; k++)
+	{
+		float scaled = (coordinate[k] - boundsMin[k]) * m_cellScale[k];
+		cell[k] = scaled > 0.0f ? (unsigned int)scaled : 0;
+		if (cell[k] >= m_gridSize[k])
+		{
+			cell[k] = m_gridSize[k] - 1;
+		}
+	}
+
+	return (cell[2] * m_gridSize[1] + cell[1]) * m_gridSize[0] + cell[0];
+}
+
+
+std::string ObjStreamImportClass::GetBucketFilename(unsigned int tile)
+{
+	char suffix[32];
+
+
+	snprintf(suffix, sizeof(suffix), ".bucket%05u", tile);
+
+	return m_tempBase + suffix;
+}
+
+
+void ObjStreamImportClass::RemoveTempFiles()
+{
+	std::error_code error;
+	unsigned int tile;
+
+
+	std::filesystem::remove(m_tempBase + ".positions", error);
+	std::filesystem::remove(m_tempBase + ".uvs", error);
+	std::filesystem::remove(m_tempBase + ".normals", error);
+	std::filesystem::remove(m_tempBase + ".triangles", error);
+	for (tile = 0; tile < m_stats.tileCount; tile++)
+	{
+		std::filesystem::remove(GetBucketFilename(tile), error);
+	}
+
+	return;
+}
@@ -0,0 +1,118 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: objstreamimportclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _OBJSTREAMIMPORTCLASS_H_
+#define _OBJSTREAMIMPORTCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "meshtypes.h"
+#include "meshcacheclass.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: ObjStreamImportClass
+////////////////////////////////////////////////////////////////////////////////
+// The ObjStreamImportClass imports OBJ files that are too big to load at once, within a fixed memory budget.
+// The file is read a block at a time and its records are spilled into temporary files next to it. The bounds are then cut into a grid
+// whose cells are grouped along a Morton curve into tiles of a size that fits the budget, and every triangle is routed to the tile
+// of its first corner. That needs the tile of each vertex, so the vertices are joined in as many passes over the triangles as it
+// takes for their tile numbers to fit in memory. Finally every tile is welded, optimized and written as its own .dxmesh chunk with
+// its own bounds, and a .dxtiles manifest lists the chunks. Every buffer is sized from the budget before anything is read, and the
+// working set is checked against the budget after every step so an import that grows past it fails instead of carrying on.
+class ObjStreamImportClass
+{
+public:
+	struct TileType
+	{
+		XMFLOAT3 boundsMin, boundsMax;
+		unsigned int vertexCount, indexCount;
+	};
+
+	struct ImportStatsType
+	{
+		uint64_t fileSize;
+		uint64_t positionCount, uvCount, normalCount, triangleCount;
+		unsigned int cellCount, tileCount, chunkCount, routingPasses;
+		uint64_t trianglesPerChunk;
+		// The working set when the import started, and the most it grew by over that, which the budget is held to.
+		size_t memoryBudget, startMemory, peakMemory;
+		double parseSeconds, routeSeconds, buildSeconds;
+	};
+
+private:
+	// A triangle as it is routed: the v, vt and vn index of each of its corners.
+	struct TriangleType
+	{
+		uint32_t corners[9];
+	};
+
+	struct ManifestHeaderType
+	{
+		char magic[4];
+		uint32_t version;
+		uint64_t tileCount;
+		uint64_t sourceSize;
+		int64_t sourceTime;
+		uint64_t sourceHash;
+	};
+
+public:
+	ObjStreamImportClass();
+	ObjStreamImportClass(const ObjStreamImportClass&);
+	~ObjStreamImportClass();
+
+	void SetMemoryBudget(size_t bytes);
+	void SetWeldTolerance(float);
+	void SetThreadCount(unsigned int);
+	bool Import(const char* sourceFilename, OUT std::vector<TileType>& out_tiles);
+
+	ImportStatsType GetStats();
+
+	static std::string GetManifestFilename(const char* sourceFilename);
+	static std::string GetTileFilename(const char* sourceFilename, unsigned int tile);
+	static bool ReadManifest(const char* sourceFilename, OUT std::vector<TileType>& out_tiles);
+	static size_t GetCurrentMemory();
+	static size_t GetPeakMemory();
+
+private:
+	bool ParseSource(const char* sourceFilename);
+	bool PlanTiles();
+	bool RouteTriangles();
+	bool BuildTiles(const char* sourceFilename, OUT std::vector<TileType>& out_tiles);
+	bool BuildChunk(std::vector<TriangleType>& triangles, const std::string& tileFilename, OUT TileType& tile);
+	bool GatherRecords(std::ifstream& file, uint64_t recordCount, size_t recordSize, const std::vector<uint32_t>& ids, OUT char* out_records);
+	bool WriteManifest(const char* sourceFilename, const std::vector<TileType>& tiles);
+	void RemoveTempFiles();
+	bool CheckMemory();
+
+	unsigned int GetCell(const XMFLOAT3& position);
+	std::string GetBucketFilename(unsigned int tile);
+
+private:
+	size_t m_memoryBudget;
+	float m_weldTolerance;
+	unsigned int m_threadCount;
+	ImportStatsType m_stats;
+	size_t m_startPeakMemory;
+	MeshCacheClass::SourceStampType m_source;
+
+	// The temporary files of the current import and the tile of every grid cell.
+	std::string m_tempBase;
+	XMFLOAT3 m_boundsMin, m_boundsMax;
+	unsigned int m_gridSize[3];
+	float m_cellScale[3];
+	std::vector<uint16_t> m_cellTiles;
+	std::vector<uint64_t> m_tileTriangleCounts;
+};
+
+#endif
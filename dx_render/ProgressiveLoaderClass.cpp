@@ -0,0 +1,549 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: progressiveloaderclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "progressiveloaderclass.h"
+#include "meshcacheclass.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+
+
+/////////////
+// GLOBALS //
+/////////////
+// The dirty part of the index array is tracked in pages of this many indices, the updates of a split touch slots all over it.
+static const unsigned int PROGRESSIVE_DIRTY_PAGE = 1024;
+
+
+ProgressiveLoaderClass::ProgressiveLoaderClass()
+{
+	memset(&m_header, 0, sizeof(m_header));
+	m_loaded = false;
+	m_failed = false;
+	m_endOfFile = false;
+	m_pendingStart = 0;
+	m_vertexCount = 0;
+	m_splitsApplied = 0;
+	m_error = 0.0f;
+	m_bytesRead = 0;
+	m_fileBytes = 0;
+	m_dirtyVertexStart = 0;
+}
+
+
+ProgressiveLoaderClass::ProgressiveLoaderClass(const ProgressiveLoaderClass& other)
+{
+}
+
+
+ProgressiveLoaderClass::~ProgressiveLoaderClass()
+{
+}
+
+// Initialize opens the file and reads the base mesh. With a source file the stamp in the header has to match it the way a mesh cache
+// does, without one the file is taken as it is. Nothing is dirty afterwards, the caller uploads the arrays as they are.
+bool ProgressiveLoaderClass::Initialize(const char* filename, const char* sourceFilename)
+{
+	MeshCacheClass::SourceStampType stamp;
+	std::vector<char> base;
+	std::vector<uint32_t> baseCounts;
+	std::error_code error;
+	const char* data;
+	const uint32_t* baseIndices;
+	uint64_t nameBytes, baseBytes, start, terminators;
+	unsigned int i, j, baseIndexCount;
+
+
+	Shutdown();
+
+	m_fileBytes = (uint64_t)std::filesystem::file_size(filename, error);
+	if (error || m_fileBytes < sizeof(m_header))
+	{
+		return false;
+	}
+
+	m_file.open(filename, std::ios::binary);
+	if (!m_file)
+	{
+		return false;
+	}
+
+	// Validate the header before trusting any of its counts.
+	m_file.read((char*)&m_header, sizeof(m_header));
+	if (!m_file || !ProgressiveMeshClass::IsHeaderValid(m_header))
+	{
+		Shutdown();
+		return false;
+	}
+
+	nameBytes = ((uint64_t)m_header.nameBytes + 3) / 4 * 4;
+	baseBytes = nameBytes + (uint64_t)m_header.submeshCount * (sizeof(MeshSubmeshType) + sizeof(uint32_t)) +
+		(uint64_t)m_header.baseVertexCount * sizeof(VertexType) + (uint64_t)m_header.baseIndexCount * sizeof(uint32_t);
+	if (m_header.baseVertexCount == 0 || m_header.baseVertexCount > m_header.vertexCount || m_header.baseIndexCount > m_header.indexCount ||
+		m_header.indexCount % 3 != 0 || m_header.vertexCount - m_header.baseVertexCount != m_header.splitCount || m_header.submeshCount == 0 ||
+		m_header.baseBytes != baseBytes || sizeof(m_header) + baseBytes > m_fileBytes)
+	{
+		Shutdown();
+		return false;
+	}
+
+	if (sourceFilename)
+	{
+		stamp.size = m_header.sourceSize;
+		stamp.time = m_header.sourceTime;
+		stamp.hash = m_header.sourceHash;
+		if (!MeshCacheClass::MatchesSource(sourceFilename, stamp))
+		{
+			Shutdown();
+			return false;
+		}
+	}
+
+	base.resize((size_t)baseBytes);
+	m_file.read(base.data(), base.size());
+	if (!m_file)
+	{
+		Shutdown();
+		return false;
+	}
+
+	// The names have to hold exactly the strings the header counts.
+	data = base.data();
+	terminators = 0;
+	for (i = 0; i < m_header.nameBytes; i++)
+	{
+		terminators += data[i] == 0 ? 1 : 0;
+	}
+
+	if (terminators != (uint64_t)m_header.libraryCount + m_header.materialCount || (m_header.nameBytes > 0 && data[m_header.nameBytes - 1] != 0))
+	{
+		Shutdown();
+		return false;
+	}
+
+	for (i = 0; i < m_header.libraryCount + m_header.materialCount; i++)
+	{
+		if (i < m_header.libraryCount)
+		{
+			m_materials.libraries.push_back(data);
+		}
+		else
+		{
+			m_materials.names.push_back(data);
+		}
+		data += strlen(data) + 1;
+	}
+
+	// The submeshes follow each other over the whole index array, and each has room for its base triangles.
+	data = base.data() + nameBytes;
+	m_submeshSlots.resize(m_header.submeshCount);
+	baseCounts.resize(m_header.submeshCount);
+	memcpy(m_submeshSlots.data(), data, m_header.submeshCount * sizeof(MeshSubmeshType));
+	memcpy(baseCounts.data(), data + m_header.submeshCount * sizeof(MeshSubmeshType), m_header.submeshCount * sizeof(uint32_t));
+
+	start = 0;
+	baseIndexCount = 0;
+	for (i = 0; i < m_header.submeshCount; i++)
+	{
+		if (m_submeshSlots[i].startIndex != start || m_submeshSlots[i].indexCount % 3 != 0 || m_submeshSlots[i].material >= m_header.materialCount ||
+			(uint64_t)baseCounts[i] * 3 > m_submeshSlots[i].indexCount)
+		{
+			Shutdown();
+			return false;
+		}
+		start += m_submeshSlots[i].indexCount;
+		baseIndexCount += baseCounts[i] * 3;
+	}
+
+	if (start != m_header.indexCount || baseIndexCount != m_header.baseIndexCount)
+	{
+		Shutdown();
+		return false;
+	}
+
+	// Copy the base into arrays the size of the full mesh, each submesh's triangles at the start of its slot.
+	data += m_header.submeshCount * (sizeof(MeshSubmeshType) + sizeof(uint32_t));
+	m_vertices.resize(m_header.vertexCount);
+	memcpy(m_vertices.data(), data, m_header.baseVertexCount * sizeof(VertexType));
+	m_vertexCount = m_header.baseVertexCount;
+
+	baseIndices = (const uint32_t*)(data + m_header.baseVertexCount * sizeof(VertexType));
+	m_indices.assign(m_header.indexCount, 0);
+	m_submeshes = m_submeshSlots;
+	for (i = 0; i < m_header.submeshCount; i++)
+	{
+		m_submeshes[i].indexCount = baseCounts[i] * 3;
+		for (j = 0; j < m_submeshes[i].indexCount; j++)
+		{
+			if (baseIndices[j] >= m_vertexCount)
+			{
+				Shutdown();
+				return false;
+			}
+			m_indices[m_submeshes[i].startIndex + j] = baseIndices[j];
+		}
+		baseIndices += m_submeshes[i].indexCount;
+	}
+
+	m_error = m_header.baseError;
+	m_bytesRead = sizeof(m_header) + baseBytes;
+	m_endOfFile = m_bytesRead == m_fileBytes;
+	m_dirtyPages.assign((m_header.indexCount + PROGRESSIVE_DIRTY_PAGE - 1) / PROGRESSIVE_DIRTY_PAGE, 0);
+	m_dirtyVertexStart = m_vertexCount;
+	m_loaded = true;
+
+	return true;
+}
+
+// Shutdown closes the file and drops the mesh.
+void ProgressiveLoaderClass::Shutdown()
+{
+	if (m_file.is_open())
+	{
+		m_file.close();
+	}
+	m_file.clear();
+
+	memset(&m_header, 0, sizeof(m_header));
+	m_materials.libraries.clear();
+	m_materials.names.clear();
+	m_loaded = false;
+	m_failed = false;
+	m_endOfFile = false;
+	m_pending.clear();
+	m_pendingStart = 0;
+	m_vertices.clear();
+	m_indices.clear();
+	m_submeshes.clear();
+	m_submeshSlots.clear();
+	m_vertexCount = 0;
+	m_splitsApplied = 0;
+	m_error = 0.0f;
+	m_bytesRead = 0;
+	m_fileBytes = 0;
+	m_dirtyVertexStart = 0;
+	m_dirtyPages.clear();
+
+	return;
+}
+
+// Refine applies splits until the error is at or below targetError, all of them are applied or it would have to read more than
+// maxBytes from the file. A split that is only partly read is kept for the next call. It returns false once the file turned out
+// to be unreadable or corrupt, the mesh then stays as it was after the last good split.
+bool ProgressiveLoaderClass::Refine(unsigned int maxBytes, float targetError)
+{
+	size_t splitBytes, readBytes, size;
+
+
+	if (!m_loaded || m_failed)
+	{
+		return false;
+	}
+
+	readBytes = 0;
+	while (m_splitsApplied < m_header.splitCount && m_error > targetError)
+	{
+		if (ApplySplit(m_pending.data() + m_pendingStart, m_pending.size() - m_pendingStart, splitBytes))
+		{
+			m_pendingStart += splitBytes;
+			continue;
+		}
+
+		if (m_failed)
+		{
+			return false;
+		}
+
+		// The next split is not all there yet, read on if the budget allows it.
+		if (m_endOfFile || readBytes >= maxBytes)
+		{
+			break;
+		}
+
+		size = maxBytes - readBytes;
+		if (!ReadBytes(size))
+		{
+			m_failed = true;
+			return false;
+		}
+		readBytes += size;
+	}
+
+	return true;
+}
+
+// IsLoaded is true between a successful Initialize and Shutdown. IsComplete is true once every split has been applied, which a file
+// that was cut short never gets to.
+bool ProgressiveLoaderClass::IsLoaded()
+{
+	return m_loaded;
+}
+
+
+bool ProgressiveLoaderClass::IsComplete()
+{
+	return m_loaded && m_splitsApplied == m_header.splitCount;
+}
+
+// GetError returns how far, in model units, the surface of the mesh so far may be from the full mesh.
+float ProgressiveLoaderClass::GetError()
+{
+	return m_error;
+}
+
+// GetVertices returns the vertex array with room for the full mesh, the first GetVertexCount of them are there so far.
+const VertexType* ProgressiveLoaderClass::GetVertices()
+{
+	return m_vertices.data();
+}
+
+
+unsigned int ProgressiveLoaderClass::GetVertexCount()
+{
+	return m_vertexCount;
+}
+
+
+unsigned int ProgressiveLoaderClass::GetVertexCapacity()
+{
+	return m_header.vertexCount;
+}
+
+// GetIndices returns the index array of the full mesh. Only the slots the submeshes cover so far are meaningful, the rest are zero.
+const uint32_t* ProgressiveLoaderClass::GetIndices()
+{
+	return m_indices.data();
+}
+
+
+unsigned int ProgressiveLoaderClass::GetIndexCapacity()
+{
+	return m_header.indexCount;
+}
+
+// GetSubmeshes returns one submesh per slot of the index array with the number of indices it has so far.
+const MeshSubmeshType* ProgressiveLoaderClass::GetSubmeshes()
+{
+	return m_submeshes.data();
+}
+
+
+unsigned int ProgressiveLoaderClass::GetSubmeshCount()
+{
+	return (unsigned int)m_submeshes.size();
+}
+
+
+void ProgressiveLoaderClass::GetMaterials(OUT MeshMaterialListType& materials)
+{
+	materials = m_materials;
+
+	return;
+}
+
+// GetBounds returns the bounds of the full mesh, which the base already lies inside.
+void ProgressiveLoaderClass::GetBounds(OUT XMFLOAT3& boundsMin, OUT XMFLOAT3& boundsMax)
+{
+	boundsMin = XMFLOAT3(m_header.boundsMin[0], m_header.boundsMin[1], m_header.boundsMin[2]);
+	boundsMax = XMFLOAT3(m_header.boundsMax[0], m_header.boundsMax[1], m_header.boundsMax[2]);
+
+	return;
+}
+
+// GetDirtyVertices returns the vertices added since the last ClearDirty, they are always at the end of the ones there so far.
+ProgressiveLoaderClass::DirtyRangeType ProgressiveLoaderClass::GetDirtyVertices()
+{
+	DirtyRangeType range;
+
+
+	range.start = m_dirtyVertexStart;
+	range.count = m_vertexCount - m_dirtyVertexStart;
+
+	return range;
+}
+
+// GetDirtyIndices returns the runs of index pages written since the last ClearDirty.
+void ProgressiveLoaderClass::GetDirtyIndices(OUT std::vector<DirtyRangeType>& ranges)
+{
+	DirtyRangeType range;
+	size_t page, end;
+
+
+	ranges.clear();
+	for (page = 0; page < m_dirtyPages.size(); page = end)
+	{
+		for (end = page + 1; end < m_dirtyPages.size() && m_dirtyPages[end] == m_dirtyPages[page]; end++)
+		{
+		}
+
+		if (m_dirtyPages[page])
+		{
+			range.start = (unsigned int)(page * PROGRESSIVE_DIRTY_PAGE);
+			range.count = (unsigned int)std::min<size_t>(end * PROGRESSIVE_DIRTY_PAGE, m_header.indexCount) - range.start;
+			ranges.push_back(range);
+		}
+	}
+
+	return;
+}
+
+
+void ProgressiveLoaderClass::ClearDirty()
+{
+	m_dirtyVertexStart = m_vertexCount;
+	std::fill(m_dirtyPages.begin(), m_dirtyPages.end(), 0);
+
+	return;
+}
+
+
+ProgressiveLoaderClass::LoadStatsType ProgressiveLoaderClass::GetStats()
+{
+	LoadStatsType stats;
+	size_t i;
+
+
+	stats.bytesRead = m_bytesRead;
+	stats.fileBytes = m_fileBytes;
+	stats.splitsApplied = m_splitsApplied;
+	stats.splitCount = m_header.splitCount;
+	stats.triangleCount = 0;
+	for (i = 0; i < m_submeshes.size(); i++)
+	{
+		stats.triangleCount += m_submeshes[i].indexCount / 3;
+	}
+	stats.triangleCapacity = m_header.indexCount / 3;
+
+	return stats;
+}
+
+// ReadBytes appends up to size more bytes of the file to the pending ones, dropping those already applied first.
+// Running into the end of the file is not an error, a stream error is.
+bool ProgressiveLoaderClass::ReadBytes(size_t size)
+{
+	size_t used;
+
+
+	m_pending.erase(m_pending.begin(), m_pending.begin() + m_pendingStart);
+	m_pendingStart = 0;
+
+	used = m_pending.size();
+	size = (size_t)std::min<uint64_t>(size, m_fileBytes - m_bytesRead);
+	m_pending.resize(used + size);
+	m_file.read(m_pending.data() + used, size);
+	m_pending.resize(used + (size_t)m_file.gcount());
+	m_bytesRead += (uint64_t)m_file.gcount();
+
+	if (m_file.eof() || m_bytesRead == m_fileBytes)
+	{
+		m_endOfFile = true;
+		return true;
+	}
+
+	return !m_file.fail();
+}
+
+// ApplySplit applies the split at the start of data when it is all there and returns its size. It returns false without a change
+// when the split is incomplete, and also sets m_failed when it is corrupt: indices of vertices that are not there yet, a submesh
+// that would overflow its slot or slots outside the index array. Everything is checked before anything is changed.
+bool ProgressiveLoaderClass::ApplySplit(const char* data, size_t size, OUT size_t& splitBytes)
+{
+	ProgressiveMeshClass::SplitType split;
+	const uint32_t* triangles;
+	const uint32_t* updates;
+	unsigned int vertex, added, i, k;
+	bool valid;
+
+
+	splitBytes = 0;
+	if (size < sizeof(split))
+	{
+		return false;
+	}
+
+	memcpy(&split, data, sizeof(split));
+	if (split.triangleCount > m_header.indexCount / 3 || split.updateCount > m_header.indexCount)
+	{
+		m_failed = true;
+		return false;
+	}
+
+	splitBytes = sizeof(split) + sizeof(VertexType) + split.triangleCount * 4 * sizeof(uint32_t) + split.updateCount * sizeof(uint32_t);
+	if (size < splitBytes)
+	{
+		splitBytes = 0;
+		return false;
+	}
+
+	vertex = m_vertexCount;
+	triangles = (const uint32_t*)(data + sizeof(split) + sizeof(VertexType));
+	updates = triangles + split.triangleCount * 4;
+
+	// Count the new triangles into their submeshes to check the slots, then take them back out.
+	valid = vertex < m_header.vertexCount;
+	added = 0;
+	for (i = 0; i < split.triangleCount && valid; i++)
+	{
+		valid = triangles[i * 4] < m_submeshes.size() && triangles[i * 4 + 1] <= vertex && triangles[i * 4 + 2] <= vertex && triangles[i * 4 + 3] <= vertex;
+		if (valid)
+		{
+			m_submeshes[triangles[i * 4]].indexCount += 3;
+			added++;
+			valid = m_submeshes[triangles[i * 4]].indexCount <= m_submeshSlots[triangles[i * 4]].indexCount;
+		}
+	}
+	for (k = 0; k < added; k++)
+	{
+		m_submeshes[triangles[k * 4]].indexCount -= 3;
+	}
+	for (i = 0; i < split.updateCount && valid; i++)
+	{
+		valid = updates[i] < m_header.indexCount;
+	}
+
+	if (!valid)
+	{
+		splitBytes = 0;
+		m_failed = true;
+		return false;
+	}
+
+	memcpy(&m_vertices[vertex], data + sizeof(split), sizeof(VertexType));
+	m_vertexCount++;
+
+	for (i = 0; i < split.triangleCount; i++)
+	{
+		MeshSubmeshType& submesh = m_submeshes[triangles[i * 4]];
+		for (k = 0; k < 3; k++)
+		{
+			m_indices[submesh.startIndex + submesh.indexCount + k] = triangles[i * 4 + 1 + k];
+		}
+		MarkIndices(submesh.startIndex + submesh.indexCount, 3);
+		submesh.indexCount += 3;
+	}
+
+	for (i = 0; i < split.updateCount; i++)
+	{
+		m_indices[updates[i]] = vertex;
+		MarkIndices(updates[i], 1);
+	}
+
+	m_error = split.error;
+	m_splitsApplied++;
+
+	return true;
+}
+
+
+void ProgressiveLoaderClass::MarkIndices(unsigned int start, unsigned int count)
+{
+	unsigned int page;
+
+
+	for (page = start / PROGRESSIVE_DIRTY_PAGE; page <= (start + count - 1) / PROGRESSIVE_DIRTY_PAGE; page++)
+	{
+		m_dirtyPages[page] = 1;
+	}
+
+	return;
+}
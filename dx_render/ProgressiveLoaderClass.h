@@ -0,0 +1,101 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: progressiveloaderclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _PROGRESSIVELOADERCLASS_H_
+#define _PROGRESSIVELOADERCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <cstdint>
+#include <fstream>
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "meshtypes.h"
+#include "progressivemeshclass.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: ProgressiveLoaderClass
+////////////////////////////////////////////////////////////////////////////////
+// The ProgressiveLoaderClass reads a .dxpm file a piece at a time. Initialize only reads the header and the base mesh, every Refine
+// reads at most a given number of bytes more and applies the vertex splits they hold, and stops early once the mesh error is small
+// enough. The vertex and index arrays have the size of the full mesh from the start so their pointers never change and the buffers
+// made from them never have to grow, and the parts a Refine changed are kept as dirty ranges until the caller has uploaded them.
+// A file that ends in the middle of the splits, or a split that does not make sense, leaves the mesh as it was after the last good one.
+class ProgressiveLoaderClass
+{
+public:
+	struct DirtyRangeType
+	{
+		unsigned int start, count;
+	};
+
+	struct LoadStatsType
+	{
+		uint64_t bytesRead, fileBytes;
+		unsigned int splitsApplied, splitCount;
+		unsigned int triangleCount, triangleCapacity;
+	};
+
+public:
+	ProgressiveLoaderClass();
+	ProgressiveLoaderClass(const ProgressiveLoaderClass&);
+	~ProgressiveLoaderClass();
+
+	bool Initialize(const char* filename, const char* sourceFilename);
+	void Shutdown();
+	bool Refine(unsigned int maxBytes, float targetError);
+
+	bool IsLoaded();
+	bool IsComplete();
+	float GetError();
+
+	const VertexType* GetVertices();
+	unsigned int GetVertexCount();
+	unsigned int GetVertexCapacity();
+	const uint32_t* GetIndices();
+	unsigned int GetIndexCapacity();
+	const MeshSubmeshType* GetSubmeshes();
+	unsigned int GetSubmeshCount();
+	void GetMaterials(OUT MeshMaterialListType&);
+	void GetBounds(OUT XMFLOAT3& boundsMin, OUT XMFLOAT3& boundsMax);
+
+	DirtyRangeType GetDirtyVertices();
+	void GetDirtyIndices(OUT std::vector<DirtyRangeType>&);
+	void ClearDirty();
+
+	LoadStatsType GetStats();
+
+private:
+	bool ReadBytes(size_t size);
+	bool ApplySplit(const char* data, size_t size, OUT size_t& splitBytes);
+	void MarkIndices(unsigned int start, unsigned int count);
+
+private:
+	std::ifstream m_file;
+	ProgressiveMeshClass::HeaderType m_header;
+	MeshMaterialListType m_materials;
+	bool m_loaded, m_failed, m_endOfFile;
+
+	// The bytes read from the file that do not make a whole split yet.
+	std::vector<char> m_pending;
+	size_t m_pendingStart;
+
+	// The mesh so far. Its submeshes have the slots of the full mesh with the index count the splits so far have filled in.
+	std::vector<VertexType> m_vertices;
+	std::vector<uint32_t> m_indices;
+	std::vector<MeshSubmeshType> m_submeshes, m_submeshSlots;
+	unsigned int m_vertexCount, m_splitsApplied;
+	float m_error;
+	uint64_t m_bytesRead, m_fileBytes;
+
+	// The vertices from m_dirtyVertexStart on and the index pages with a flag set changed since the last ClearDirty.
+	unsigned int m_dirtyVertexStart;
+	std::vector<unsigned char> m_dirtyPages;
+};
+
+#endif
@@ -0,0 +1,445 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: progressivemeshclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "progressivemeshclass.h"
+#include "meshsimplifierclass.h"
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+
+/////////////
+// GLOBALS //
+/////////////
+static const char PROGRESSIVE_MESH_MAGIC[4] = { 'D', 'X', 'P', 'M' };
+// Bump the version whenever the layout of the file or the way it is built changes so old files are rebuilt.
+static const uint32_t PROGRESSIVE_MESH_VERSION = 1;
+// The base mesh keeps this fraction of the triangles when the simplifier can get that far.
+static const float PROGRESSIVE_MESH_BASE_RATIO = 0.02f;
+
+
+ProgressiveMeshClass::ProgressiveMeshClass()
+{
+	m_baseRatio = PROGRESSIVE_MESH_BASE_RATIO;
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+
+
+ProgressiveMeshClass::ProgressiveMeshClass(const ProgressiveMeshClass& other)
+{
+}
+
+
+ProgressiveMeshClass::~ProgressiveMeshClass()
+{
+}
+
+// SetBaseRatio sets the fraction of the triangles the base mesh is simplified to. A smaller base shows up sooner but looks coarser.
+void ProgressiveMeshClass::SetBaseRatio(float ratio)
+{
+	m_baseRatio = ratio;
+
+	return;
+}
+
+// Build simplifies the mesh down to its base and turns the collapses into the splits that undo them, one after the other.
+// The submeshes are those of the full mesh, back to back over the whole index array. The triangles keep their submesh however far
+// the mesh is simplified, so the whole mesh is simplified at once and material borders move with the collapses instead of tearing.
+// The file is built in memory, Write stores it.
+bool ProgressiveMeshClass::Build(const std::vector<VertexType>& verts, const std::vector<uint32_t>& indices, const std::vector<MeshSubmeshType>& submeshes,
+	const MeshMaterialListType& materials)
+{
+	MeshSimplifierClass simplifier;
+	std::vector<uint32_t> simplifiedIndices;
+	std::vector<MeshSimplifierClass::CollapseRecordType> collapses;
+	std::vector<unsigned int> triangleCollapses, triangleSubmeshes, roots, newIndices, parents, order, bucketOffsets, slots, baseCounts, fill;
+	std::vector<unsigned int> updateOffsets, updateSlots;
+	std::vector<uint32_t> cornerValues;
+	std::vector<float> errors;
+	std::vector<VertexType> splitVerts;
+	std::string names;
+	HeaderType header;
+	SplitType split;
+	unsigned int triangleCount, vertexCount, baseVertexCount, splitCount, submesh, record, value, appearance, i, j, k;
+	uint64_t start;
+	float scale, error;
+	char padding[4];
+
+
+	std::chrono::steady_clock::time_point buildStart = std::chrono::steady_clock::now();
+
+	m_file.clear();
+	memset(&m_stats, 0, sizeof(m_stats));
+
+	triangleCount = (unsigned int)(indices.size() / 3);
+	vertexCount = (unsigned int)verts.size();
+	if (triangleCount == 0 || indices.size() % 3 != 0 || submeshes.empty())
+	{
+		return false;
+	}
+
+	for (i = 0; i < indices.size(); i++)
+	{
+		if (indices[i] >= vertexCount)
+		{
+			return false;
+		}
+	}
+
+	// Every triangle has to belong to exactly one submesh, and the submeshes follow each other.
+	triangleSubmeshes.resize(triangleCount);
+	start = 0;
+	for (i = 0; i < submeshes.size(); i++)
+	{
+		if (submeshes[i].startIndex != start || submeshes[i].indexCount % 3 != 0 || submeshes[i].material >= materials.names.size())
+		{
+			return false;
+		}
+
+		for (j = submeshes[i].startIndex / 3; j < (submeshes[i].startIndex + submeshes[i].indexCount) / 3; j++)
+		{
+			triangleSubmeshes[j] = i;
+		}
+		start += submeshes[i].indexCount;
+	}
+
+	if (start != indices.size())
+	{
+		return false;
+	}
+
+	// Simplify as far as the base ratio, whatever the error, and keep the record of what was collapsed.
+	scale = simplifier.GetScale(verts);
+	simplifier.Simplify(verts, indices, (unsigned int)(indices.size() * m_baseRatio) / 3 * 3, FLT_MAX, simplifiedIndices, collapses, triangleCollapses);
+	splitCount = (unsigned int)collapses.size();
+
+	// A collapse target was still in the mesh when the vertex moved onto it, so it is collapsed later or never. Walking the collapses
+	// backwards finds the vertex of the base mesh every vertex ended up on.
+	roots.resize(vertexCount);
+	for (i = 0; i < vertexCount; i++)
+	{
+		roots[i] = i;
+	}
+	for (i = splitCount; i-- > 0; )
+	{
+		roots[collapses[i].vertex] = roots[collapses[i].target];
+	}
+
+	// Order the triangles the way the index buffer is filled: the base triangles first, then those of every split in turn.
+	// Split k undoes collapse splitCount - 1 - k, appearance 0 is the base and appearance k + 1 is split k.
+	bucketOffsets.assign(splitCount + 2, 0);
+	for (i = 0; i < triangleCount; i++)
+	{
+		appearance = triangleCollapses[i] == MESH_INDEX_NONE ? 0 : splitCount - triangleCollapses[i];
+		bucketOffsets[appearance + 1]++;
+	}
+	for (i = 0; i < splitCount + 1; i++)
+	{
+		bucketOffsets[i + 1] += bucketOffsets[i];
+	}
+
+	order.resize(triangleCount);
+	fill.assign(bucketOffsets.begin(), bucketOffsets.end() - 1);
+	for (i = 0; i < triangleCount; i++)
+	{
+		appearance = triangleCollapses[i] == MESH_INDEX_NONE ? 0 : splitCount - triangleCollapses[i];
+		order[fill[appearance]++] = i;
+	}
+
+	// Every triangle gets the next free slot of its submesh in that order.
+	slots.resize(triangleCount);
+	fill.resize(submeshes.size());
+	baseCounts.assign(submeshes.size(), 0);
+	for (i = 0; i < submeshes.size(); i++)
+	{
+		fill[i] = submeshes[i].startIndex;
+	}
+	for (i = 0; i < triangleCount; i++)
+	{
+		submesh = triangleSubmeshes[order[i]];
+		slots[order[i]] = fill[submesh];
+		fill[submesh] += 3;
+		if (i < bucketOffsets[1])
+		{
+			baseCounts[submesh]++;
+		}
+	}
+
+	// Number the base vertices in the order the base triangles first use them, then the ones no base triangle uses any more but that
+	// never collapsed either, and then one new vertex per split. Vertices no triangle uses are left out.
+	newIndices.assign(vertexCount, MESH_INDEX_NONE);
+	baseVertexCount = 0;
+	for (i = 0; i < submeshes.size(); i++)
+	{
+		for (j = 0; j < bucketOffsets[1]; j++)
+		{
+			if (triangleSubmeshes[order[j]] != i)
+			{
+				continue;
+			}
+
+			for (k = 0; k < 3; k++)
+			{
+				value = roots[indices[order[j] * 3 + k]];
+				if (newIndices[value] == MESH_INDEX_NONE)
+				{
+					newIndices[value] = baseVertexCount++;
+				}
+			}
+		}
+	}
+
+	for (i = 0; i < indices.size(); i++)
+	{
+		if (newIndices[indices[i]] == MESH_INDEX_NONE && roots[indices[i]] == indices[i])
+		{
+			newIndices[indices[i]] = baseVertexCount++;
+		}
+	}
+
+	parents.resize(baseVertexCount + splitCount);
+	splitVerts.resize(baseVertexCount + splitCount);
+	for (i = 0; i < vertexCount; i++)
+	{
+		if (roots[i] == i && newIndices[i] != MESH_INDEX_NONE)
+		{
+			splitVerts[newIndices[i]] = verts[i];
+		}
+	}
+	for (k = 0; k < splitCount; k++)
+	{
+		newIndices[collapses[splitCount - 1 - k].vertex] = baseVertexCount + k;
+	}
+	for (k = 0; k < splitCount; k++)
+	{
+		const MeshSimplifierClass::CollapseRecordType& collapse = collapses[splitCount - 1 - k];
+		parents[baseVertexCount + k] = newIndices[collapse.target];
+		splitVerts[baseVertexCount + k] = verts[collapse.vertex];
+	}
+
+	// A corner points at the first vertex of its collapse chain that is already there when its triangle appears. Every later vertex
+	// of the chain is an update of its slot when that vertex is split off, until the corner is back at its own vertex.
+	cornerValues.resize(indices.size());
+	updateOffsets.assign(splitCount + 1, 0);
+	for (j = 0; j < 2; j++)
+	{
+		for (i = 0; i < indices.size(); i++)
+		{
+			appearance = triangleCollapses[i / 3] == MESH_INDEX_NONE ? 0 : splitCount - triangleCollapses[i / 3];
+			value = newIndices[indices[i]];
+			while (value >= baseVertexCount + appearance)
+			{
+				record = value - baseVertexCount;
+				if (j == 0)
+				{
+					updateOffsets[record + 1]++;
+				}
+				else
+				{
+					updateSlots[fill[record]++] = slots[i / 3] + i % 3;
+				}
+				value = parents[value];
+			}
+			cornerValues[i] = value;
+		}
+
+		if (j == 0)
+		{
+			for (k = 0; k < splitCount; k++)
+			{
+				updateOffsets[k + 1] += updateOffsets[k];
+			}
+			updateSlots.resize(updateOffsets[splitCount]);
+			fill.assign(updateOffsets.begin(), updateOffsets.end() - 1);
+		}
+	}
+
+	// The error of the mesh after a split is the largest of the collapses still applied, and those are the ones before it.
+	errors.resize(splitCount);
+	error = 0.0f;
+	for (i = 0; i < splitCount; i++)
+	{
+		errors[i] = error;
+		error = fmaxf(error, collapses[i].error * scale);
+	}
+
+	for (i = 0; i < materials.libraries.size(); i++)
+	{
+		names.append(materials.libraries[i].c_str(), materials.libraries[i].size() + 1);
+	}
+	for (i = 0; i < materials.names.size(); i++)
+	{
+		names.append(materials.names[i].c_str(), materials.names[i].size() + 1);
+	}
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, PROGRESSIVE_MESH_MAGIC, sizeof(PROGRESSIVE_MESH_MAGIC));
+	header.version = PROGRESSIVE_MESH_VERSION;
+	header.vertexStride = sizeof(VertexType);
+	header.vertexCount = baseVertexCount + splitCount;
+	header.indexCount = (uint32_t)indices.size();
+	header.baseVertexCount = baseVertexCount;
+	header.baseIndexCount = bucketOffsets[1] * 3;
+	header.splitCount = splitCount;
+	header.submeshCount = (uint32_t)submeshes.size();
+	header.libraryCount = (uint32_t)materials.libraries.size();
+	header.materialCount = (uint32_t)materials.names.size();
+	header.nameBytes = (uint32_t)names.size();
+	header.baseError = error;
+	for (i = 0; i < splitVerts.size(); i++)
+	{
+		const float* p = &splitVerts[i].position.x;
+		for (k = 0; k < 3; k++)
+		{
+			header.boundsMin[k] = (i == 0 || p[k] < header.boundsMin[k]) ? p[k] : header.boundsMin[k];
+			header.boundsMax[k] = (i == 0 || p[k] > header.boundsMax[k]) ? p[k] : header.boundsMax[k];
+		}
+	}
+	header.baseBytes = (names.size() + 3) / 4 * 4 + submeshes.size() * (sizeof(MeshSubmeshType) + sizeof(uint32_t)) + baseVertexCount * sizeof(VertexType) +
+		header.baseIndexCount * sizeof(uint32_t);
+
+	// The base, in the order of the index buffer slots so its indices can be copied in submesh by submesh.
+	memset(padding, 0, sizeof(padding));
+	Append(&header, sizeof(header));
+	Append(names.data(), names.size());
+	Append(padding, (4 - names.size() % 4) % 4);
+	Append(submeshes.data(), submeshes.size() * sizeof(MeshSubmeshType));
+	Append(baseCounts.data(), baseCounts.size() * sizeof(uint32_t));
+	Append(splitVerts.data(), baseVertexCount * sizeof(VertexType));
+	for (i = 0; i < submeshes.size(); i++)
+	{
+		for (j = 0; j < bucketOffsets[1]; j++)
+		{
+			if (triangleSubmeshes[order[j]] == i)
+			{
+				Append(&cornerValues[order[j] * 3], 3 * sizeof(uint32_t));
+			}
+		}
+	}
+
+	for (k = 0; k < splitCount; k++)
+	{
+		split.triangleCount = bucketOffsets[k + 2] - bucketOffsets[k + 1];
+		split.updateCount = updateOffsets[k + 1] - updateOffsets[k];
+		split.error = errors[splitCount - 1 - k];
+		Append(&split, sizeof(split));
+		Append(&splitVerts[baseVertexCount + k], sizeof(VertexType));
+		for (j = bucketOffsets[k + 1]; j < bucketOffsets[k + 2]; j++)
+		{
+			submesh = triangleSubmeshes[order[j]];
+			Append(&submesh, sizeof(uint32_t));
+			Append(&cornerValues[order[j] * 3], 3 * sizeof(uint32_t));
+		}
+		Append(&updateSlots[updateOffsets[k]], split.updateCount * sizeof(uint32_t));
+	}
+
+	m_stats.baseVertexCount = baseVertexCount;
+	m_stats.baseTriangleCount = bucketOffsets[1];
+	m_stats.splitCount = splitCount;
+	m_stats.updateCount = (unsigned int)updateSlots.size();
+	m_stats.baseBytes = sizeof(header) + header.baseBytes;
+	m_stats.fileBytes = m_file.size();
+	m_stats.baseError = error;
+	m_stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - buildStart).count();
+
+	return true;
+}
+
+// Write stamps the built file with the source it was made from and writes it through a temporary file, like MeshCacheClass::Write.
+bool ProgressiveMeshClass::Write(const char* filename, const char* sourceFilename)
+{
+	MeshCacheClass::SourceStampType stamp;
+	HeaderType* header;
+	std::string tempFilename;
+	std::ofstream fout;
+	std::error_code error;
+	bool result;
+
+
+	if (m_file.size() < sizeof(HeaderType))
+	{
+		return false;
+	}
+
+	result = MeshCacheClass::GetSourceStamp(sourceFilename, stamp);
+	if (!result)
+	{
+		return false;
+	}
+
+	result = MeshCacheClass::HashFile(sourceFilename, stamp.hash);
+	if (!result)
+	{
+		return false;
+	}
+
+	header = (HeaderType*)m_file.data();
+	header->sourceSize = stamp.size;
+	header->sourceTime = stamp.time;
+	header->sourceHash = stamp.hash;
+
+	tempFilename = std::string(filename) + ".tmp";
+	fout.open(tempFilename, std::ios::binary | std::ios::trunc);
+	if (!fout)
+	{
+		return false;
+	}
+
+	fout.write(m_file.data(), m_file.size());
+	fout.close();
+	if (!fout)
+	{
+		std::filesystem::remove(tempFilename, error);
+		return false;
+	}
+
+	std::filesystem::rename(tempFilename, filename, error);
+	if (error)
+	{
+		std::filesystem::remove(tempFilename, error);
+		return false;
+	}
+
+	return true;
+}
+
+// GetFileData returns the file Build made, without a source stamp until Write has filled it in.
+const std::vector<char>& ProgressiveMeshClass::GetFileData()
+{
+	return m_file;
+}
+
+
+ProgressiveMeshClass::BuildStatsType ProgressiveMeshClass::GetStats()
+{
+	return m_stats;
+}
+
+// GetStreamFilename swaps the source extension for .dxpm, so ../cube.obj is streamed from ../cube.dxpm.
+std::string ProgressiveMeshClass::GetStreamFilename(const char* sourceFilename)
+{
+	std::filesystem::path path(sourceFilename);
+
+
+	path.replace_extension(".dxpm");
+
+	return path.string();
+}
+
+// IsHeaderValid checks the header is one this build writes, its counts are left to the reader.
+bool ProgressiveMeshClass::IsHeaderValid(const HeaderType& header)
+{
+	return memcmp(header.magic, PROGRESSIVE_MESH_MAGIC, sizeof(PROGRESSIVE_MESH_MAGIC)) == 0 && header.version == PROGRESSIVE_MESH_VERSION &&
+		header.vertexStride == sizeof(VertexType);
+}
+
+
+void ProgressiveMeshClass::Append(const void* data, size_t size)
+{
+	m_file.insert(m_file.end(), (const char*)data, (const char*)data + size);
+
+	return;
+}
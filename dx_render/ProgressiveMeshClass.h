@@ -0,0 +1,98 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: progressivemeshclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _PROGRESSIVEMESHCLASS_H_
+#define _PROGRESSIVEMESHCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <cstdint>
+#include <string>
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "meshtypes.h"
+#include "meshcacheclass.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: ProgressiveMeshClass
+////////////////////////////////////////////////////////////////////////////////
+// The ProgressiveMeshClass builds and writes .dxpm files, a mesh stored coarse first. The file starts with a base mesh, the result of
+// simplifying the full mesh down to a few percent of its triangles, and continues with one vertex split for every collapse that took,
+// last collapse first. Every split adds the vertex that was collapsed, the triangles that collapse removed and the index buffer slots
+// that have to point at the new vertex from then on. Reading any prefix of the splits gives a valid mesh whose error is stored with
+// every split, and reading all of them gives back the full mesh.
+// The index buffer is laid out for the full mesh up front: every submesh has room for all of its triangles, the base triangles first
+// and then the others in the order the splits add them, so a submesh is always drawn as the first indexCount indices of its slot.
+// ProgressiveLoaderClass reads the file back a piece at a time.
+class ProgressiveMeshClass
+{
+public:
+	struct HeaderType
+	{
+		char magic[4];
+		uint32_t version;
+		uint32_t vertexStride;
+		// The full mesh, and the part of it the base mesh has.
+		uint32_t vertexCount, indexCount;
+		uint32_t baseVertexCount, baseIndexCount;
+		uint32_t splitCount, submeshCount;
+		// The material libraries and then the material names follow the header, each one terminated by a zero byte.
+		uint32_t libraryCount, materialCount, nameBytes;
+		float boundsMin[3], boundsMax[3];
+		float baseError;
+		// The bytes from the end of the header to the first split: the names padded to four bytes, the submeshes with the slot of
+		// each, the number of base triangles in each, the base vertices and the base indices.
+		uint64_t baseBytes;
+		uint64_t sourceSize;
+		int64_t sourceTime;
+		uint64_t sourceHash;
+	};
+
+	// A split is followed by the new vertex, triangleCount triangles of a submesh index and three vertex indices, and updateCount
+	// index buffer slots that are set to the new vertex. The error is the one the mesh has once the split is applied.
+	struct SplitType
+	{
+		uint32_t triangleCount, updateCount;
+		float error;
+	};
+
+	struct BuildStatsType
+	{
+		unsigned int baseVertexCount, baseTriangleCount;
+		unsigned int splitCount, updateCount;
+		uint64_t baseBytes, fileBytes;
+		float baseError;
+		double seconds;
+	};
+
+public:
+	ProgressiveMeshClass();
+	ProgressiveMeshClass(const ProgressiveMeshClass&);
+	~ProgressiveMeshClass();
+
+	void SetBaseRatio(float);
+	bool Build(const std::vector<VertexType>& verts, const std::vector<uint32_t>& indices, const std::vector<MeshSubmeshType>& submeshes,
+		const MeshMaterialListType& materials);
+	bool Write(const char* filename, const char* sourceFilename);
+
+	const std::vector<char>& GetFileData();
+	BuildStatsType GetStats();
+
+	static std::string GetStreamFilename(const char* sourceFilename);
+	static bool IsHeaderValid(const HeaderType&);
+
+private:
+	void Append(const void* data, size_t size);
+
+private:
+	float m_baseRatio;
+	std::vector<char> m_file;
+	BuildStatsType m_stats;
+};
+
+#endif
@@ -0,0 +1,44 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: renderdeviceclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "renderdeviceclass.h"
+#include <cstring>
+
+
+RenderDeviceClass::RenderDeviceClass()
+{
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+
+
+RenderDeviceClass::RenderDeviceClass(const RenderDeviceClass& other)
+{
+}
+
+
+RenderDeviceClass::~RenderDeviceClass()
+{
+}
+
+
+RenderDeviceClass::StatsType RenderDeviceClass::GetStats()
+{
+	return m_stats;
+}
+
+// ResetStats starts counting calls and bytes over. The counts of the resources alive and of the errors found are kept.
+void RenderDeviceClass::ResetStats()
+{
+	m_stats.frameCount = 0;
+	m_stats.drawCount = 0;
+	m_stats.instanceCount = 0;
+	m_stats.indexCount = 0;
+	m_stats.bindCount = 0;
+	m_stats.mapCount = 0;
+	m_stats.updateCount = 0;
+	m_stats.copyCount = 0;
+	m_stats.uploadBytes = 0;
+	m_stats.copyBytes = 0;
+
+	return;
+}
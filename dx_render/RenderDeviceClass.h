@@ -0,0 +1,179 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: renderdeviceclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _RENDERDEVICECLASS_H_
+#define _RENDERDEVICECLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <dxgiformat.h>
+#include <cstddef>
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "meshtypes.h"
+#include "vertexlayouts.h"
+
+
+/////////////
+// GLOBALS //
+/////////////
+// Resources are handed out as handles. Zero is never a valid handle, so a handle member starts out and is reset to zero like the
+// pointer it replaces, and can be tested the same way.
+const unsigned int RENDER_HANDLE_NONE = 0;
+// The vertex buffer, constant buffer and texture slots the device keeps track of.
+const unsigned int RENDER_MAX_VERTEX_BUFFERS = 4;
+const unsigned int RENDER_MAX_CONSTANT_BUFFERS = 4;
+const unsigned int RENDER_MAX_TEXTURES = 4;
+
+static_assert(INSTANCE_VERTEX_SLOT < RENDER_MAX_VERTEX_BUFFERS && INSTANCE_VERTEX_SLOT >= VERTEX_LAYOUT_MAX_SLOTS,
+	"The instance stream needs a vertex buffer slot of its own");
+
+
+//////////////
+// TYPEDEFS //
+//////////////
+enum RenderBindType
+{
+	RENDER_BIND_VERTEX_BUFFER,
+	RENDER_BIND_INDEX_BUFFER,
+	RENDER_BIND_CONSTANT_BUFFER
+};
+
+// A default buffer lives on the GPU and is written with UpdateBuffer and CopyBuffer, a dynamic one is written by mapping it.
+enum RenderUsageType
+{
+	RENDER_USAGE_DEFAULT,
+	RENDER_USAGE_DYNAMIC
+};
+
+// A discard hands out fresh memory for the whole buffer, a no overwrite promises not to touch anything the GPU may still read.
+enum RenderMapType
+{
+	RENDER_MAP_DISCARD,
+	RENDER_MAP_NO_OVERWRITE
+};
+
+enum RenderShaderStageType
+{
+	RENDER_STAGE_VERTEX,
+	RENDER_STAGE_PIXEL
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: RenderDeviceClass
+////////////////////////////////////////////////////////////////////////////////
+// The RenderDeviceClass is everything the renderer asks of the GPU: buffers, textures, shaders, queries, the state a draw reads and
+// the draws themselves. The models, pools and shaders only ever talk to this interface, so the frame runs the same on the Direct3D 11
+// device and on the null device, which draws nothing but checks and counts every call, for profiling on machines without a GPU.
+// Every draw is a triangle list, and every shader samples its textures through one linear, wrapping sampler in slot zero.
+class RenderDeviceClass
+{
+public:
+	struct BufferDescType
+	{
+		RenderBindType bind;
+		RenderUsageType usage;
+		unsigned int byteWidth;
+	};
+
+	// A shader is the vertex and pixel shader of a pass together with the input layout of the vertices it reads.
+	struct ShaderDescType
+	{
+		const wchar_t* vertexShaderFile;
+		const char* vertexEntryPoint;
+		const wchar_t* pixelShaderFile;
+		const char* pixelEntryPoint;
+		const VertexElementDescType* layout;
+		unsigned int elementCount;
+	};
+
+	// Binding part of a constant buffer and mapping a dynamic constant buffer with RENDER_MAP_NO_OVERWRITE both need Direct3D 11.1.
+	struct CapsType
+	{
+		bool constantBufferOffsetting;
+		bool mapNoOverwriteOnConstantBuffers;
+	};
+
+	// The calls and bytes since the last ResetStats, the resources alive now and every error found. Only the null and software devices find errors.
+	// A plain draw is one instance, and the indices of an instanced draw count once for every instance.
+	struct StatsType
+	{
+		unsigned int frameCount;
+		unsigned int drawCount;
+		unsigned long long instanceCount, indexCount;
+		unsigned int bindCount;
+		unsigned int mapCount, updateCount, copyCount;
+		unsigned long long uploadBytes, copyBytes;
+		unsigned int bufferCount, textureCount, shaderCount, queryCount;
+		unsigned long long bufferBytes;
+		unsigned int errorCount;
+	};
+
+public:
+	RenderDeviceClass();
+	RenderDeviceClass(const RenderDeviceClass&);
+	virtual ~RenderDeviceClass();
+
+	virtual void Shutdown() = 0;
+	virtual CapsType GetCaps() = 0;
+
+	virtual bool CreateBuffer(const BufferDescType&, const void* initialData, OUT unsigned int& buffer) = 0;
+	virtual void UpdateBuffer(unsigned int buffer, unsigned int offset, const void* data, unsigned int size) = 0;
+	virtual void CopyBuffer(unsigned int destination, unsigned int destinationOffset, unsigned int source, unsigned int sourceOffset,
+		unsigned int size) = 0;
+	virtual bool MapBuffer(unsigned int buffer, RenderMapType, unsigned int offset, unsigned int size, OUT void*& data) = 0;
+	virtual void UnmapBuffer(unsigned int buffer) = 0;
+	virtual void ReleaseBuffer(unsigned int buffer) = 0;
+
+	virtual bool CreateTexture(const wchar_t* filename, OUT unsigned int& texture) = 0;
+	virtual bool CreateTexture(const unsigned char* data, size_t size, OUT unsigned int& texture) = 0;
+	virtual void ReleaseTexture(unsigned int texture) = 0;
+
+	virtual bool CreateShader(const ShaderDescType&, OUT unsigned int& shader) = 0;
+	virtual void ReleaseShader(unsigned int shader) = 0;
+
+	virtual bool CreateQuery(OUT unsigned int& query) = 0;
+	virtual void EndQuery(unsigned int query) = 0;
+	virtual bool IsQueryDone(unsigned int query, bool flush) = 0;
+	virtual void ReleaseQuery(unsigned int query) = 0;
+
+	virtual void BeginScene(float red, float green, float blue, float alpha) = 0;
+	virtual void EndScene() = 0;
+
+	virtual void SetVertexBuffers(unsigned int startSlot, unsigned int count, const unsigned int* buffers, const unsigned int* strides,
+		const unsigned int* offsets) = 0;
+	virtual void SetIndexBuffer(unsigned int buffer, DXGI_FORMAT format, unsigned int offset) = 0;
+	virtual void SetShader(unsigned int shader) = 0;
+	virtual void SetConstantBuffer(RenderShaderStageType, unsigned int slot, unsigned int buffer, unsigned int firstConstant,
+		unsigned int constantCount) = 0;
+	virtual void SetTexture(unsigned int slot, unsigned int texture) = 0;
+	virtual void DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex) = 0;
+	// DrawIndexedInstanced draws the range instanceCount times, the elements of per instance slots step once for each instance
+	// starting at startInstance.
+	virtual void DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int startIndex, int baseVertex,
+		unsigned int startInstance) = 0;
+
+	// Command lists let worker threads record draws at the same time. BeginCommandList hands out a device that records the binds and
+	// draws made to it into the list until EndCommandList, both called on the thread that records. Only its Set and Draw calls may be
+	// used, and the list starts out with nothing bound. Any number of lists may record at once while nothing else is called on this
+	// device. ExecuteCommandList draws a finished list on this device, and leaves nothing bound on it either.
+	virtual bool CreateCommandList(OUT unsigned int& commandList) = 0;
+	virtual bool BeginCommandList(unsigned int commandList, OUT RenderDeviceClass*& recorder) = 0;
+	virtual void EndCommandList(unsigned int commandList) = 0;
+	virtual void ExecuteCommandList(unsigned int commandList) = 0;
+	virtual void ReleaseCommandList(unsigned int commandList) = 0;
+
+	// A device that passes its calls on to another one reports the stats of that device instead.
+	virtual StatsType GetStats();
+	virtual void ResetStats();
+
+protected:
+	StatsType m_stats;
+};
+
+#endif
@@ -0,0 +1,238 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: renderqueueclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "renderqueueclass.h"
+#include <cstring>
+
+
+RenderQueueClass::RenderQueueClass()
+{
+	m_sorted = false;
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+
+
+RenderQueueClass::RenderQueueClass(const RenderQueueClass& other)
+{
+}
+
+
+RenderQueueClass::~RenderQueueClass()
+{
+}
+
+// Initialize makes room for a frame of capacity packets up front, the queue grows past that on its own.
+void RenderQueueClass::Initialize(unsigned int capacity)
+{
+	memset(&m_stats, 0, sizeof(m_stats));
+	Reserve(capacity);
+	Reset();
+
+	return;
+}
+
+
+void RenderQueueClass::Shutdown()
+{
+	m_packets.clear();
+	m_packets.shrink_to_fit();
+	m_entries.clear();
+	m_entries.shrink_to_fit();
+	m_scratch.clear();
+	m_scratch.shrink_to_fit();
+	m_sorted = false;
+	m_stats.capacity = 0;
+
+	return;
+}
+
+// MakeKey builds the sort key of a draw. The depth is the distance in front of the camera, anything behind it counts as zero.
+unsigned long long RenderQueueClass::MakeKey(RenderPassType pass, unsigned int shader, unsigned int material, float depth)
+{
+	unsigned long long key, shaderBits, materialBits;
+	unsigned int depthBits;
+
+
+	// Negative depths and NaN both fail the test.
+	if (!(depth > 0.0f))
+	{
+		depth = 0.0f;
+	}
+	memcpy(&depthBits, &depth, sizeof(depthBits));
+
+	shaderBits = shader & ((1u << RENDER_QUEUE_SHADER_BITS) - 1);
+	materialBits = material & ((1u << RENDER_QUEUE_MATERIAL_BITS) - 1);
+
+	key = (unsigned long long)pass << 62;
+	if (pass == RENDER_PASS_TRANSPARENT)
+	{
+		key |= (unsigned long long)~depthBits << (RENDER_QUEUE_SHADER_BITS + RENDER_QUEUE_MATERIAL_BITS);
+		key |= shaderBits << RENDER_QUEUE_MATERIAL_BITS;
+		key |= materialBits;
+	}
+	else
+	{
+		key |= shaderBits << (RENDER_QUEUE_MATERIAL_BITS + 32);
+		key |= materialBits << 32;
+		key |= depthBits;
+	}
+
+	return key;
+}
+
+// Reset empties the queue for the next frame, its memory is kept.
+void RenderQueueClass::Reset()
+{
+	m_packets.clear();
+	m_entries.clear();
+	m_sorted = false;
+	m_stats.packetCount = 0;
+	m_stats.sortPasses = 0;
+	m_stats.skippedPasses = 0;
+
+	return;
+}
+
+
+void RenderQueueClass::Add(const PacketType& packet)
+{
+	SortEntryType entry;
+
+
+	// Grow to twice the size at once, so a busy frame only allocates a few times.
+	if (m_packets.size() == m_packets.capacity())
+	{
+		Reserve(m_packets.empty() ? 256 : (unsigned int)m_packets.size() * 2);
+		m_stats.growCount++;
+	}
+
+	entry.key = packet.key;
+	entry.packet = (unsigned int)m_packets.size();
+	m_entries.push_back(entry);
+	m_packets.push_back(packet);
+	m_sorted = false;
+
+	m_stats.packetCount++;
+	if (m_stats.packetCount > m_stats.peakPacketCount)
+	{
+		m_stats.peakPacketCount = m_stats.packetCount;
+	}
+
+	return;
+}
+
+// Sort counts every digit of every key in a single pass over the keys and then moves the entries once for each digit that does not
+// hold the same value in all of them, from the lowest digit up.
+void RenderQueueClass::Sort()
+{
+	const unsigned int radix = 1 << RENDER_QUEUE_RADIX_BITS;
+	unsigned int offsets[1 << RENDER_QUEUE_RADIX_BITS];
+	unsigned long long key;
+	unsigned int count, pass, shift, digit, total, i, j;
+	SortEntryType entry;
+	SortEntryType* source;
+	SortEntryType* destination;
+	SortEntryType* swap;
+
+
+	count = (unsigned int)m_entries.size();
+	m_sorted = true;
+	if (count < 2)
+	{
+		return;
+	}
+
+	// A short queue is sorted in place, moving each entry back past the ones with a larger key only.
+	if (count <= RENDER_QUEUE_INSERTION_SORT_LIMIT)
+	{
+		for (i = 1; i < count; i++)
+		{
+			entry = m_entries[i];
+			for (j = i; j > 0 && m_entries[j - 1].key > entry.key; j--)
+			{
+				m_entries[j] = m_entries[j - 1];
+			}
+			m_entries[j] = entry;
+		}
+
+		return;
+	}
+
+	memset(m_counts, 0, sizeof(m_counts));
+	for (i = 0; i < count; i++)
+	{
+		key = m_entries[i].key;
+		for (pass = 0; pass < RENDER_QUEUE_RADIX_PASSES; pass++)
+		{
+			m_counts[pass][(key >> (pass * RENDER_QUEUE_RADIX_BITS)) & (radix - 1)]++;
+		}
+	}
+
+	// m_scratch has the capacity of m_entries, so this does not allocate.
+	m_scratch.resize(count);
+	source = m_entries.data();
+	destination = m_scratch.data();
+	for (pass = 0; pass < RENDER_QUEUE_RADIX_PASSES; pass++)
+	{
+		shift = pass * RENDER_QUEUE_RADIX_BITS;
+		if (m_counts[pass][(source[0].key >> shift) & (radix - 1)] == count)
+		{
+			m_stats.skippedPasses++;
+			continue;
+		}
+
+		total = 0;
+		for (digit = 0; digit < radix; digit++)
+		{
+			offsets[digit] = total;
+			total += m_counts[pass][digit];
+		}
+
+		for (i = 0; i < count; i++)
+		{
+			destination[offsets[(source[i].key >> shift) & (radix - 1)]++] = source[i];
+		}
+
+		swap = source;
+		source = destination;
+		destination = swap;
+		m_stats.sortPasses++;
+	}
+
+	// After an odd number of passes the sorted keys are in the scratch array, which becomes the entries.
+	if (source != m_entries.data())
+	{
+		m_entries.swap(m_scratch);
+	}
+
+	return;
+}
+
+
+int RenderQueueClass::GetPacketCount()
+{
+	return (int)m_packets.size();
+}
+
+// GetPacket returns the packets in key order after Sort, and in the order they were added before it.
+const RenderQueueClass::PacketType& RenderQueueClass::GetPacket(int index)
+{
+	return m_sorted ? m_packets[m_entries[index].packet] : m_packets[index];
+}
+
+
+RenderQueueClass::StatsType RenderQueueClass::GetStats()
+{
+	return m_stats;
+}
+
+
+void RenderQueueClass::Reserve(unsigned int capacity)
+{
+	m_packets.reserve(capacity);
+	m_entries.reserve(capacity);
+	m_scratch.reserve(capacity);
+	m_stats.capacity = (unsigned int)m_packets.capacity();
+
+	return;
+}
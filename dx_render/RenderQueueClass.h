@@ -0,0 +1,112 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: renderqueueclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _RENDERQUEUECLASS_H_
+#define _RENDERQUEUECLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <vector>
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "meshtypes.h"
+
+
+/////////////
+// GLOBALS //
+/////////////
+// How many bits of a sort key the shader and the material take, larger ids are cut to fit.
+const unsigned int RENDER_QUEUE_SHADER_BITS = 8;
+const unsigned int RENDER_QUEUE_MATERIAL_BITS = 22;
+// Sort takes the keys this many bits at a time, in as many passes as it needs to cover all 64. Queues of up to
+// RENDER_QUEUE_INSERTION_SORT_LIMIT packets are insertion sorted instead, as the radix sort has a fixed cost per pass.
+const unsigned int RENDER_QUEUE_RADIX_BITS = 11;
+const unsigned int RENDER_QUEUE_RADIX_PASSES = (64 + RENDER_QUEUE_RADIX_BITS - 1) / RENDER_QUEUE_RADIX_BITS;
+const unsigned int RENDER_QUEUE_INSERTION_SORT_LIMIT = 64;
+
+
+//////////////
+// TYPEDEFS //
+//////////////
+// The passes of a frame in the order they are drawn.
+enum RenderPassType
+{
+	RENDER_PASS_OPAQUE,
+	RENDER_PASS_TRANSPARENT
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: RenderQueueClass
+////////////////////////////////////////////////////////////////////////////////
+// The RenderQueueClass collects the draws of a frame as packets and hands them back sorted by a 64 bit key. MakeKey puts the pass in
+// the top bits. Opaque draws follow with the shader, the material and then the depth, so state changes as little as possible and
+// each run of a material is drawn front to back for early depth rejection. Transparent draws follow with the depth inverted and then
+// the shader and the material, so they are drawn back to front. The depth goes in as the bits of the float, which sort like the
+// value for depths of zero and more.
+// Sort is a stable least significant digit radix sort of the keys that skips the digits every key has the same. Packets with the
+// same key keep the order they were added in. The arrays keep their memory from frame to frame, so after the busiest frame has been
+// seen the queue no longer allocates.
+class RenderQueueClass
+{
+public:
+	// One draw: which of the caller's geometry bindings it needs, the index of its object constants, the texture and the range to draw.
+	// An instanced draw draws the range for instanceCount instances from firstInstance on, a plain draw has an instanceCount of zero.
+	struct PacketType
+	{
+		unsigned long long key;
+		unsigned int geometry, object;
+		unsigned int texture;
+		IndexRangeType range;
+		unsigned int firstInstance, instanceCount;
+	};
+
+	struct StatsType
+	{
+		unsigned int packetCount, peakPacketCount;
+		unsigned int capacity, growCount;
+		unsigned int sortPasses, skippedPasses;
+	};
+
+private:
+	struct SortEntryType
+	{
+		unsigned long long key;
+		unsigned int packet;
+	};
+
+public:
+	RenderQueueClass();
+	RenderQueueClass(const RenderQueueClass&);
+	~RenderQueueClass();
+
+	void Initialize(unsigned int capacity);
+	void Shutdown();
+
+	static unsigned long long MakeKey(RenderPassType, unsigned int shader, unsigned int material, float depth);
+
+	void Reset();
+	void Add(const PacketType&);
+	void Sort();
+
+	int GetPacketCount();
+	const PacketType& GetPacket(int);
+	StatsType GetStats();
+
+private:
+	void Reserve(unsigned int capacity);
+
+private:
+	// The packets in the order they were added, and the keys with the packet of each, sorted by Sort through m_scratch.
+	std::vector<PacketType> m_packets;
+	std::vector<SortEntryType> m_entries, m_scratch;
+	unsigned int m_counts[RENDER_QUEUE_RADIX_PASSES][1 << RENDER_QUEUE_RADIX_BITS];
+	bool m_sorted;
+	StatsType m_stats;
+};
+
+#endif
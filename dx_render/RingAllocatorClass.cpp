@@ -0,0 +1,193 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: ringallocatorclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "ringallocatorclass.h"
+
+
+RingAllocatorClass::RingAllocatorClass()
+{
+	m_capacity = 0;
+	m_alignment = 1;
+	m_head = 0;
+	m_tail = 0;
+	m_maxFrames = 0;
+	m_firstFrame = 0;
+	m_frameCount = 0;
+	m_peakBytes = 0;
+	m_allocationCount = 0;
+	m_wrapCount = 0;
+	m_failCount = 0;
+	m_resetCount = 0;
+}
+
+
+RingAllocatorClass::RingAllocatorClass(const RingAllocatorClass& other)
+{
+}
+
+
+RingAllocatorClass::~RingAllocatorClass()
+{
+}
+
+// Initialize starts over with an empty ring of capacity bytes that hands out ranges on alignment byte boundaries, a power of two the
+// capacity is a multiple of, and keeps up to maxFrames frames in flight.
+bool RingAllocatorClass::Initialize(unsigned int capacity, unsigned int alignment, unsigned int maxFrames)
+{
+	Shutdown();
+
+	if (alignment == 0 || (alignment & (alignment - 1)) != 0 || capacity == 0 || capacity % alignment != 0 || maxFrames == 0)
+	{
+		return false;
+	}
+
+	m_capacity = capacity;
+	m_alignment = alignment;
+	m_maxFrames = maxFrames;
+	m_frameEnds.assign(maxFrames, 0);
+
+	return true;
+}
+
+
+void RingAllocatorClass::Shutdown()
+{
+	m_capacity = 0;
+	m_alignment = 1;
+	m_head = 0;
+	m_tail = 0;
+	m_frameEnds.clear();
+	m_maxFrames = 0;
+	m_firstFrame = 0;
+	m_frameCount = 0;
+	m_peakBytes = 0;
+	m_allocationCount = 0;
+	m_wrapCount = 0;
+	m_failCount = 0;
+	m_resetCount = 0;
+
+	return;
+}
+
+// Allocate returns the offset of size bytes, rounded up to the alignment, that no frame in flight uses. It fails, and leaves the ring
+// as it was, when there is not that much room left before the oldest frame in flight, counting the bytes a wrap would skip.
+bool RingAllocatorClass::Allocate(unsigned int size, OUT unsigned int& offset, OUT unsigned int& alignedSize)
+{
+	uint64_t start;
+	unsigned int skipped;
+
+
+	alignedSize = (size + m_alignment - 1) & ~(m_alignment - 1);
+	if (size == 0 || alignedSize > m_capacity)
+	{
+		m_failCount++;
+		return false;
+	}
+
+	// Every range is a multiple of the alignment, so the head is always aligned and only the end of the block can get in the way.
+	start = m_head;
+	skipped = 0;
+	if (start % m_capacity + alignedSize > m_capacity)
+	{
+		skipped = m_capacity - (unsigned int)(start % m_capacity);
+		start += skipped;
+	}
+
+	if (start + alignedSize - m_tail > m_capacity)
+	{
+		m_failCount++;
+		return false;
+	}
+
+	if (skipped > 0)
+	{
+		m_wrapCount++;
+	}
+
+	offset = (unsigned int)(start % m_capacity);
+	m_head = start + alignedSize;
+	m_allocationCount++;
+	if (m_head - m_tail > m_peakBytes)
+	{
+		m_peakBytes = (unsigned int)(m_head - m_tail);
+	}
+
+	return true;
+}
+
+// EndFrame closes the frame the ranges since the last EndFrame belong to. It fails when maxFrames frames are in flight already,
+// the oldest has to be retired first.
+bool RingAllocatorClass::EndFrame()
+{
+	if (m_frameCount == m_maxFrames)
+	{
+		return false;
+	}
+
+	m_frameEnds[(m_firstFrame + m_frameCount) % m_maxFrames] = m_head;
+	m_frameCount++;
+
+	return true;
+}
+
+// RetireFrame gives back the ranges of the oldest frame in flight, once the GPU is done with it.
+void RingAllocatorClass::RetireFrame()
+{
+	if (m_frameCount == 0)
+	{
+		return;
+	}
+
+	m_tail = m_frameEnds[m_firstFrame];
+	m_firstFrame = (m_firstFrame + 1) % m_maxFrames;
+	m_frameCount--;
+
+	return;
+}
+
+// Reset gives back every range at once, for when the memory behind the ring was replaced and the GPU reads the old memory. The frames
+// in flight stay so they can still be retired in order, they just no longer hold anything.
+void RingAllocatorClass::Reset()
+{
+	unsigned int i;
+
+
+	m_tail = m_head;
+	for (i = 0; i < m_frameCount; i++)
+	{
+		m_frameEnds[(m_firstFrame + i) % m_maxFrames] = m_head;
+	}
+	m_resetCount++;
+
+	return;
+}
+
+
+unsigned int RingAllocatorClass::GetFramesInFlight()
+{
+	return m_frameCount;
+}
+
+
+unsigned int RingAllocatorClass::GetMaxFrames()
+{
+	return m_maxFrames;
+}
+
+
+RingAllocatorClass::StatsType RingAllocatorClass::GetStats()
+{
+	StatsType stats;
+
+
+	stats.capacity = m_capacity;
+	stats.usedBytes = (unsigned int)(m_head - m_tail);
+	stats.peakBytes = m_peakBytes;
+	stats.framesInFlight = m_frameCount;
+	stats.allocationCount = m_allocationCount;
+	stats.wrapCount = m_wrapCount;
+	stats.failCount = m_failCount;
+	stats.resetCount = m_resetCount;
+
+	return stats;
+}
@@ -0,0 +1,71 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: ringallocatorclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _RINGALLOCATORCLASS_H_
+#define _RINGALLOCATORCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <cstdint>
+#include <vector>
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "meshtypes.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: RingAllocatorClass
+////////////////////////////////////////////////////////////////////////////////
+// The RingAllocatorClass hands out aligned ranges of a block of bytes it never touches, one after the other, for data that is written
+// once and read by the GPU a frame or so later, such as the constants of every draw. A frame's ranges are given back all at once when
+// the GPU is done with the frame, so the ring only has to remember where each frame in flight ended. A range that would run past the
+// end of the block starts over at the beginning instead, the bytes it skips belong to the frame until it is retired.
+// Positions only ever grow, the offset of a position is the position modulo the capacity, so a full ring and an empty one can not be
+// mistaken for each other.
+class RingAllocatorClass
+{
+public:
+	struct StatsType
+	{
+		unsigned int capacity;
+		unsigned int usedBytes, peakBytes;
+		unsigned int framesInFlight;
+		unsigned int allocationCount, wrapCount, failCount, resetCount;
+	};
+
+public:
+	RingAllocatorClass();
+	RingAllocatorClass(const RingAllocatorClass&);
+	~RingAllocatorClass();
+
+	bool Initialize(unsigned int capacity, unsigned int alignment, unsigned int maxFrames);
+	void Shutdown();
+
+	bool Allocate(unsigned int size, OUT unsigned int& offset, OUT unsigned int& alignedSize);
+	bool EndFrame();
+	void RetireFrame();
+	void Reset();
+
+	unsigned int GetFramesInFlight();
+	unsigned int GetMaxFrames();
+	StatsType GetStats();
+
+private:
+	unsigned int m_capacity, m_alignment;
+
+	// Where the next range starts and where the oldest range the GPU may still read starts, as positions that are never wrapped.
+	uint64_t m_head, m_tail;
+
+	// Where every frame in flight ended, oldest first from m_firstFrame, as a queue of m_maxFrames entries.
+	std::vector<uint64_t> m_frameEnds;
+	unsigned int m_maxFrames, m_firstFrame, m_frameCount;
+
+	unsigned int m_peakBytes;
+	unsigned int m_allocationCount, m_wrapCount, m_failCount, m_resetCount;
+};
+
+#endif
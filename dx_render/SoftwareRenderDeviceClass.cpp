@@ -0,0 +1,2027 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: softwarerenderdeviceclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "softwarerenderdeviceclass.h"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <utility>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define SOFTWARE_RASTER_SSE2 1
+#include <emmintrin.h>
+#endif
+
+
+/////////////
+// GLOBALS //
+/////////////
+// The outcodes of a clip space vertex. The first six are the view volume, a triangle with all its vertices outside one of them is
+// not drawn. A triangle with a vertex in front of the near plane or outside the guard band is clipped.
+static const unsigned int OUTCODE_LEFT = 1, OUTCODE_RIGHT = 2, OUTCODE_BOTTOM = 4, OUTCODE_TOP = 8, OUTCODE_NEAR = 16, OUTCODE_FAR = 32;
+static const unsigned int OUTCODE_GUARD_LEFT = 64, OUTCODE_GUARD_RIGHT = 128, OUTCODE_GUARD_BOTTOM = 256, OUTCODE_GUARD_TOP = 512;
+static const unsigned int OUTCODE_VIEW = 63;
+static const unsigned int OUTCODE_CLIP = OUTCODE_NEAR | OUTCODE_GUARD_LEFT | OUTCODE_GUARD_RIGHT | OUTCODE_GUARD_BOTTOM | OUTCODE_GUARD_TOP;
+// Clipping a triangle against the five clip planes leaves at most eight vertices.
+static const int CLIP_MAX_VERTICES = 8;
+
+
+// HalfToFloat widens a 16 bit float, the texture coordinates of the compact vertex formats.
+static float HalfToFloat(unsigned short half)
+{
+	unsigned int sign, exponent, mantissa, bits;
+	float value;
+
+
+	sign = (unsigned int)(half & 0x8000) << 16;
+	exponent = (half >> 10) & 0x1f;
+	mantissa = half & 0x3ff;
+
+	if (exponent == 0)
+	{
+		value = ldexpf((float)mantissa, -24);
+		return sign ? -value : value;
+	}
+
+	if (exponent == 31)
+	{
+		bits = sign | 0x7f800000 | (mantissa << 13);
+	}
+	else
+	{
+		bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+	}
+	memcpy(&value, &bits, sizeof(value));
+
+	return value;
+}
+
+// FetchElement reads one vertex element as the input assembler does, the components the format does not have are 0, 0, 0, 1.
+static void FetchElement(const unsigned char* data, DXGI_FORMAT format, float* out)
+{
+	unsigned short shorts[4];
+	short signedShorts[2];
+	unsigned int packed;
+	int i;
+
+
+	out[0] = 0.0f;
+	out[1] = 0.0f;
+	out[2] = 0.0f;
+	out[3] = 1.0f;
+
+	switch (format)
+	{
+	case DXGI_FORMAT_R32G32B32A32_FLOAT:
+		memcpy(out, data, 16);
+		break;
+	case DXGI_FORMAT_R32G32B32_FLOAT:
+		memcpy(out, data, 12);
+		break;
+	case DXGI_FORMAT_R32G32_FLOAT:
+		memcpy(out, data, 8);
+		break;
+	case DXGI_FORMAT_R16G16B16A16_UNORM:
+		memcpy(shorts, data, 8);
+		for (i = 0; i < 4; i++)
+		{
+			out[i] = (float)shorts[i] / 65535.0f;
+		}
+		break;
+	case DXGI_FORMAT_R16G16_FLOAT:
+		memcpy(shorts, data, 4);
+		out[0] = HalfToFloat(shorts[0]);
+		out[1] = HalfToFloat(shorts[1]);
+		break;
+	case DXGI_FORMAT_R16G16_SNORM:
+		memcpy(signedShorts, data, 4);
+		for (i = 0; i < 2; i++)
+		{
+			out[i] = signedShorts[i] > -32767 ? (float)signedShorts[i] / 32767.0f : -1.0f;
+		}
+		break;
+	case DXGI_FORMAT_R10G10B10A2_UNORM:
+		memcpy(&packed, data, 4);
+		out[0] = (float)(packed & 0x3ff) / 1023.0f;
+		out[1] = (float)((packed >> 10) & 0x3ff) / 1023.0f;
+		out[2] = (float)((packed >> 20) & 0x3ff) / 1023.0f;
+		out[3] = (float)(packed >> 30) / 3.0f;
+		break;
+	default:
+		break;
+	}
+
+	return;
+}
+
+// MultiplyMatrices multiplies two row major 4x4 matrices, out is neither of them.
+static void MultiplyMatrices(const float* a, const float* b, float* out)
+{
+	int row, column;
+
+
+	for (row = 0; row < 4; row++)
+	{
+		for (column = 0; column < 4; column++)
+		{
+			out[row * 4 + column] = a[row * 4 + 0] * b[0 * 4 + column] + a[row * 4 + 1] * b[1 * 4 + column] + a[row * 4 + 2] * b[2 * 4 + column] +
+				a[row * 4 + 3] * b[3 * 4 + column];
+		}
+	}
+
+	return;
+}
+
+
+static unsigned int GetOutcode(const float* position, float guardX, float guardY)
+{
+	unsigned int outcode;
+	float x, y, z, w;
+
+
+	x = position[0];
+	y = position[1];
+	z = position[2];
+	w = position[3];
+
+	outcode = 0;
+	outcode |= x < -w ? OUTCODE_LEFT : 0;
+	outcode |= x > w ? OUTCODE_RIGHT : 0;
+	outcode |= y < -w ? OUTCODE_BOTTOM : 0;
+	outcode |= y > w ? OUTCODE_TOP : 0;
+	outcode |= z < 0.0f ? OUTCODE_NEAR : 0;
+	outcode |= z > w ? OUTCODE_FAR : 0;
+	outcode |= x < -guardX * w ? OUTCODE_GUARD_LEFT : 0;
+	outcode |= x > guardX * w ? OUTCODE_GUARD_RIGHT : 0;
+	outcode |= y < -guardY * w ? OUTCODE_GUARD_BOTTOM : 0;
+	outcode |= y > guardY * w ? OUTCODE_GUARD_TOP : 0;
+
+	return outcode;
+}
+
+// ClipDistance is how far inside one clip plane a vertex is, negative outside.
+static float ClipDistance(const float* position, unsigned int plane, float guardX, float guardY)
+{
+	switch (plane)
+	{
+	case OUTCODE_NEAR:
+		return position[2];
+	case OUTCODE_GUARD_LEFT:
+		return position[0] + guardX * position[3];
+	case OUTCODE_GUARD_RIGHT:
+		return guardX * position[3] - position[0];
+	case OUTCODE_GUARD_BOTTOM:
+		return position[1] + guardY * position[3];
+	default:
+		return guardY * position[3] - position[1];
+	}
+}
+
+// LerpTexels blends two RGBA texels by weight out of 256, red and blue and then green and alpha two channels at a time.
+static unsigned int LerpTexels(unsigned int a, unsigned int b, unsigned int weight)
+{
+	unsigned int redBlue, greenAlpha;
+
+
+	redBlue = (((a & 0x00ff00ff) * (256 - weight) + (b & 0x00ff00ff) * weight) >> 8) & 0x00ff00ff;
+	greenAlpha = (((a >> 8) & 0x00ff00ff) * (256 - weight) + ((b >> 8) & 0x00ff00ff) * weight) & 0xff00ff00;
+
+	return redBlue | greenAlpha;
+}
+
+// PackColor converts a color to RGBA bytes, clamped to zero and one the way a UNORM render target stores it.
+static unsigned int PackColor(float red, float green, float blue, float alpha)
+{
+	float channels[4];
+	unsigned int color;
+	int i;
+
+
+	channels[0] = red;
+	channels[1] = green;
+	channels[2] = blue;
+	channels[3] = alpha;
+
+	color = 0;
+	for (i = 0; i < 4; i++)
+	{
+		// Written so that a NaN ends up as zero.
+		channels[i] = channels[i] < 1.0f ? channels[i] : 1.0f;
+		channels[i] = channels[i] > 0.0f ? channels[i] : 0.0f;
+		color |= (unsigned int)(channels[i] * 255.0f + 0.5f) << (i * 8);
+	}
+
+	return color;
+}
+
+// ExtractChannel scales the bits of a pixel under a mask to a byte, a channel without a mask reads as missing.
+static unsigned int ExtractChannel(unsigned int pixel, unsigned int mask, unsigned int missing)
+{
+	unsigned int value, maximum;
+
+
+	if (mask == 0)
+	{
+		return missing;
+	}
+
+	value = (pixel & mask) >> std::countr_zero(mask);
+	maximum = mask >> std::countr_zero(mask);
+
+	return (value * 255 + maximum / 2) / maximum;
+}
+
+
+static unsigned int ReadUint32(const unsigned char* data)
+{
+	return (unsigned int)data[0] | ((unsigned int)data[1] << 8) | ((unsigned int)data[2] << 16) | ((unsigned int)data[3] << 24);
+}
+
+// ReadWholeFile reads a file into memory. The name is wide like the texture names of the models, elsewhere than Windows it is
+// opened by its UTF-8 encoding.
+static bool ReadWholeFile(const wchar_t* filename, OUT std::vector<unsigned char>& data)
+{
+	FILE* file;
+	long size;
+
+
+	data.clear();
+
+#ifdef _WIN32
+	file = _wfopen(filename, L"rb");
+#else
+	std::string path;
+	const wchar_t* character;
+	unsigned int codePoint;
+
+	for (character = filename; *character; character++)
+	{
+		codePoint = (unsigned int)*character;
+		if (codePoint < 0x80)
+		{
+			path += (char)codePoint;
+		}
+		else if (codePoint < 0x800)
+		{
+			path += (char)(0xc0 | (codePoint >> 6));
+			path += (char)(0x80 | (codePoint & 0x3f));
+		}
+		else if (codePoint < 0x10000)
+		{
+			path += (char)(0xe0 | (codePoint >> 12));
+			path += (char)(0x80 | ((codePoint >> 6) & 0x3f));
+			path += (char)(0x80 | (codePoint & 0x3f));
+		}
+		else
+		{
+			path += (char)(0xf0 | (codePoint >> 18));
+			path += (char)(0x80 | ((codePoint >> 12) & 0x3f));
+			path += (char)(0x80 | ((codePoint >> 6) & 0x3f));
+			path += (char)(0x80 | (codePoint & 0x3f));
+		}
+	}
+	file = fopen(path.c_str(), "rb");
+#endif
+	if (!file)
+	{
+		return false;
+	}
+
+	fseek(file, 0, SEEK_END);
+	size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	if (size <= 0)
+	{
+		fclose(file);
+		return false;
+	}
+
+	data.resize((size_t)size);
+	if (fread(data.data(), 1, data.size(), file) != data.size())
+	{
+		fclose(file);
+		data.clear();
+		return false;
+	}
+
+	fclose(file);
+
+	return true;
+}
+
+
+SoftwareRenderDeviceClass::SoftwareRenderDeviceClass()
+{
+	m_screenWidth = 0;
+	m_screenHeight = 0;
+	m_threadCount = 0;
+	m_tilesX = 0;
+	m_tilesY = 0;
+	m_pitch = 0;
+	m_clearColor = 0;
+	memset(m_vertexBuffers, 0, sizeof(m_vertexBuffers));
+	memset(m_vertexStrides, 0, sizeof(m_vertexStrides));
+	memset(m_vertexOffsets, 0, sizeof(m_vertexOffsets));
+	m_indexBuffer = 0;
+	m_indexOffset = 0;
+	m_indexFormat = DXGI_FORMAT_R32_UINT;
+	m_shader = 0;
+	memset(m_constantBuffers, 0, sizeof(m_constantBuffers));
+	memset(m_boundTextures, 0, sizeof(m_boundTextures));
+	m_chunkCount = 0;
+	memset(&m_frameStats, 0, sizeof(m_frameStats));
+	memset(&m_lastFrameStats, 0, sizeof(m_lastFrameStats));
+}
+
+
+SoftwareRenderDeviceClass::SoftwareRenderDeviceClass(const SoftwareRenderDeviceClass& other)
+{
+}
+
+
+SoftwareRenderDeviceClass::~SoftwareRenderDeviceClass()
+{
+}
+
+// Initialize makes the render target, padded out to whole tiles so every tile is drawn the same way.
+bool SoftwareRenderDeviceClass::Initialize(int screenWidth, int screenHeight)
+{
+	if (screenWidth <= 0 || screenHeight <= 0 || screenWidth > SOFTWARE_MAX_TARGET_SIZE || screenHeight > SOFTWARE_MAX_TARGET_SIZE)
+	{
+		return false;
+	}
+
+	m_screenWidth = screenWidth;
+	m_screenHeight = screenHeight;
+	m_tilesX = (screenWidth + SOFTWARE_TILE_SIZE - 1) / SOFTWARE_TILE_SIZE;
+	m_tilesY = (screenHeight + SOFTWARE_TILE_SIZE - 1) / SOFTWARE_TILE_SIZE;
+	m_pitch = m_tilesX * SOFTWARE_TILE_SIZE;
+
+	m_colorBuffer.assign((size_t)m_pitch * m_tilesY * SOFTWARE_TILE_SIZE, 0);
+	m_depthBuffer.assign((size_t)m_pitch * m_tilesY * SOFTWARE_TILE_SIZE, 1.0f);
+
+	return true;
+}
+
+// SetThreadCount sets how many threads set up and rasterize the frame, zero uses every hardware thread.
+void SoftwareRenderDeviceClass::SetThreadCount(unsigned int threadCount)
+{
+	m_threadCount = threadCount;
+
+	return;
+}
+
+
+void SoftwareRenderDeviceClass::Shutdown()
+{
+	size_t i;
+
+
+	for (i = 0; i < m_commandLists.size(); i++)
+	{
+		if (m_commandLists[i])
+		{
+			m_commandLists[i]->Shutdown();
+			delete m_commandLists[i];
+		}
+	}
+
+	m_buffers.clear();
+	m_textures.clear();
+	m_shaders.clear();
+	m_queries.clear();
+	m_commandLists.clear();
+	m_freeBuffers.clear();
+	m_freeTextures.clear();
+	m_freeShaders.clear();
+	m_freeQueries.clear();
+	m_freeCommandLists.clear();
+	m_draws.clear();
+	m_chunks.clear();
+	m_chunkCount = 0;
+	m_clipVertices.clear();
+	m_colorBuffer.clear();
+	m_depthBuffer.clear();
+	m_stats.bufferCount = 0;
+	m_stats.textureCount = 0;
+	m_stats.shaderCount = 0;
+	m_stats.queryCount = 0;
+	m_stats.bufferBytes = 0;
+
+	return;
+}
+
+// Draws are transformed as they are made, so constants can be overwritten by the next draw whichever way they are mapped.
+RenderDeviceClass::CapsType SoftwareRenderDeviceClass::GetCaps()
+{
+	CapsType caps;
+
+
+	caps.constantBufferOffsetting = true;
+	caps.mapNoOverwriteOnConstantBuffers = true;
+
+	return caps;
+}
+
+// Every buffer is plain memory, vertex and index buffers are read by the draws.
+bool SoftwareRenderDeviceClass::CreateBuffer(const BufferDescType& desc, const void* initialData, OUT unsigned int& buffer)
+{
+	unsigned int index;
+
+
+	buffer = RENDER_HANDLE_NONE;
+	if (desc.byteWidth == 0)
+	{
+		return false;
+	}
+
+	if (!m_freeBuffers.empty())
+	{
+		index = m_freeBuffers.back();
+		m_freeBuffers.pop_back();
+	}
+	else
+	{
+		index = (unsigned int)m_buffers.size();
+		m_buffers.push_back(BufferType());
+	}
+	m_buffers[index].live = true;
+	m_buffers[index].desc = desc;
+	m_buffers[index].memory.assign(desc.byteWidth, 0);
+	if (initialData)
+	{
+		memcpy(m_buffers[index].memory.data(), initialData, desc.byteWidth);
+		m_stats.uploadBytes += desc.byteWidth;
+	}
+	buffer = index + 1;
+
+	m_stats.bufferCount++;
+	m_stats.bufferBytes += desc.byteWidth;
+
+	return true;
+}
+
+
+void SoftwareRenderDeviceClass::UpdateBuffer(unsigned int buffer, unsigned int offset, const void* data, unsigned int size)
+{
+	BufferType* record;
+
+
+	record = &m_buffers[buffer - 1];
+	if ((unsigned long long)offset + size <= record->desc.byteWidth)
+	{
+		memcpy(record->memory.data() + offset, data, size);
+	}
+
+	m_stats.updateCount++;
+	m_stats.uploadBytes += size;
+
+	return;
+}
+
+
+void SoftwareRenderDeviceClass::CopyBuffer(unsigned int destination, unsigned int destinationOffset, unsigned int source, unsigned int sourceOffset,
+	unsigned int size)
+{
+	BufferType* destinationRecord, * sourceRecord;
+
+
+	destinationRecord = &m_buffers[destination - 1];
+	sourceRecord = &m_buffers[source - 1];
+	if ((unsigned long long)destinationOffset + size <= destinationRecord->desc.byteWidth &&
+		(unsigned long long)sourceOffset + size <= sourceRecord->desc.byteWidth)
+	{
+		memmove(destinationRecord->memory.data() + destinationOffset, sourceRecord->memory.data() + sourceOffset, size);
+	}
+
+	m_stats.copyCount++;
+	m_stats.copyBytes += size;
+
+	return;
+}
+
+// MapBuffer hands out the buffer's own memory. Nothing reads it later than the draw that uses it, so a discard needs no fresh memory.
+bool SoftwareRenderDeviceClass::MapBuffer(unsigned int buffer, RenderMapType mapType, unsigned int offset, unsigned int size, OUT void*& data)
+{
+	BufferType* record;
+
+
+	data = 0;
+	record = &m_buffers[buffer - 1];
+	if ((unsigned long long)offset + size > record->desc.byteWidth)
+	{
+		return false;
+	}
+	data = record->memory.data() + offset;
+
+	m_stats.mapCount++;
+	m_stats.uploadBytes += size;
+
+	return true;
+}
+
+
+void SoftwareRenderDeviceClass::UnmapBuffer(unsigned int buffer)
+{
+	return;
+}
+
+
+void SoftwareRenderDeviceClass::ReleaseBuffer(unsigned int buffer)
+{
+	m_stats.bufferCount--;
+	m_stats.bufferBytes -= m_buffers[buffer - 1].desc.byteWidth;
+
+	m_buffers[buffer - 1].live = false;
+	std::vector<unsigned char>().swap(m_buffers[buffer - 1].memory);
+	m_freeBuffers.push_back(buffer - 1);
+
+	return;
+}
+
+// CreateTexture fails for a file that can not be read. An image it can not decode is drawn as white, so a model still gets drawn.
+bool SoftwareRenderDeviceClass::CreateTexture(const wchar_t* filename, OUT unsigned int& texture)
+{
+	std::vector<unsigned char> data;
+	TextureType record;
+
+
+	texture = RENDER_HANDLE_NONE;
+	if (!ReadWholeFile(filename, data))
+	{
+		return false;
+	}
+
+	if (!DecodeImage(data.data(), data.size(), record))
+	{
+		printf("The software device can not decode %ls, it is drawn as white\n", filename);
+	}
+
+	texture = AddTexture(record);
+
+	return true;
+}
+
+// This CreateTexture decodes an image held in memory, such as an image embedded in a .glb file.
+bool SoftwareRenderDeviceClass::CreateTexture(const unsigned char* data, size_t size, OUT unsigned int& texture)
+{
+	TextureType record;
+
+
+	texture = RENDER_HANDLE_NONE;
+	if (!data || size == 0)
+	{
+		return false;
+	}
+
+	if (!DecodeImage(data, size, record))
+	{
+		printf("The software device can not decode an embedded image, it is drawn as white\n");
+	}
+	m_stats.uploadBytes += size;
+
+	texture = AddTexture(record);
+
+	return true;
+}
+
+
+void SoftwareRenderDeviceClass::ReleaseTexture(unsigned int texture)
+{
+	m_stats.textureCount--;
+
+	m_textures[texture - 1].live = false;
+	std::vector<unsigned int>().swap(m_textures[texture - 1].texels);
+	m_freeTextures.push_back(texture - 1);
+
+	return;
+}
+
+// CreateShader knows the shaders by their entry points, it can not compile HLSL. It finds the position and the attribute the
+// program reads in the input layout, and the rows of the world matrix for the instanced shader.
+bool SoftwareRenderDeviceClass::CreateShader(const ShaderDescType& desc, OUT unsigned int& shader)
+{
+	ShaderType record;
+	const char* attributeSemantic;
+	bool foundPosition, foundAttribute, foundRows[3];
+	unsigned int index, i;
+
+
+	shader = RENDER_HANDLE_NONE;
+	if (!desc.vertexEntryPoint || !desc.pixelEntryPoint || !desc.layout)
+	{
+		return false;
+	}
+
+	record.instanced = false;
+	if (strcmp(desc.vertexEntryPoint, "TextureVertexShader") == 0 && strcmp(desc.pixelEntryPoint, "TexturePixelShader") == 0)
+	{
+		record.program = SOFTWARE_PROGRAM_TEXTURE;
+		attributeSemantic = "TEXCOORD";
+	}
+	else if (strcmp(desc.vertexEntryPoint, "TextureInstancedVertexShader") == 0 && strcmp(desc.pixelEntryPoint, "TexturePixelShader") == 0)
+	{
+		record.program = SOFTWARE_PROGRAM_TEXTURE;
+		record.instanced = true;
+		attributeSemantic = "TEXCOORD";
+	}
+	else if (strcmp(desc.vertexEntryPoint, "ColorVertexShader") == 0 && strcmp(desc.pixelEntryPoint, "ColorPixelShader") == 0)
+	{
+		record.program = SOFTWARE_PROGRAM_COLOR;
+		attributeSemantic = "COLOR";
+	}
+	else
+	{
+		printf("The software device has no program for %s and %s\n", desc.vertexEntryPoint, desc.pixelEntryPoint);
+		return false;
+	}
+
+	foundPosition = false;
+	foundAttribute = false;
+	foundRows[0] = false;
+	foundRows[1] = false;
+	foundRows[2] = false;
+	for (i = 0; i < desc.elementCount; i++)
+	{
+		if (!desc.layout[i].semantic || GetFormatSize(desc.layout[i].format) == 0 || desc.layout[i].slot >= RENDER_MAX_VERTEX_BUFFERS)
+		{
+			return false;
+		}
+
+		if (strcmp(desc.layout[i].semantic, "POSITION") == 0)
+		{
+			record.position.format = desc.layout[i].format;
+			record.position.slot = desc.layout[i].slot;
+			record.position.offset = desc.layout[i].offset;
+			foundPosition = true;
+		}
+		else if (strcmp(desc.layout[i].semantic, attributeSemantic) == 0)
+		{
+			record.attribute.format = desc.layout[i].format;
+			record.attribute.slot = desc.layout[i].slot;
+			record.attribute.offset = desc.layout[i].offset;
+			foundAttribute = true;
+		}
+		else if (record.instanced && strcmp(desc.layout[i].semantic, "WORLD") == 0 && desc.layout[i].semanticIndex < 3 && desc.layout[i].perInstance)
+		{
+			record.worldRows[desc.layout[i].semanticIndex].format = desc.layout[i].format;
+			record.worldRows[desc.layout[i].semanticIndex].slot = desc.layout[i].slot;
+			record.worldRows[desc.layout[i].semanticIndex].offset = desc.layout[i].offset;
+			foundRows[desc.layout[i].semanticIndex] = true;
+		}
+	}
+	if (!foundPosition || !foundAttribute)
+	{
+		return false;
+	}
+	if (record.instanced && (!foundRows[0] || !foundRows[1] || !foundRows[2]))
+	{
+		return false;
+	}
+	record.live = true;
+
+	if (!m_freeShaders.empty())
+	{
+		index = m_freeShaders.back();
+		m_freeShaders.pop_back();
+		m_shaders[index] = record;
+	}
+	else
+	{
+		index = (unsigned int)m_shaders.size();
+		m_shaders.push_back(record);
+	}
+	shader = index + 1;
+
+	m_stats.shaderCount++;
+
+	return true;
+}
+
+
+void SoftwareRenderDeviceClass::ReleaseShader(unsigned int shader)
+{
+	m_stats.shaderCount--;
+
+	m_shaders[shader - 1].live = false;
+	m_freeShaders.push_back(shader - 1);
+
+	return;
+}
+
+
+bool SoftwareRenderDeviceClass::CreateQuery(OUT unsigned int& query)
+{
+	unsigned int index;
+
+
+	if (!m_freeQueries.empty())
+	{
+		index = m_freeQueries.back();
+		m_freeQueries.pop_back();
+		m_queries[index] = true;
+	}
+	else
+	{
+		index = (unsigned int)m_queries.size();
+		m_queries.push_back(true);
+	}
+	query = index + 1;
+
+	m_stats.queryCount++;
+
+	return true;
+}
+
+
+void SoftwareRenderDeviceClass::EndQuery(unsigned int query)
+{
+	return;
+}
+
+// The work before a query is always done, draws are set up when they are made and rasterized before EndScene returns.
+bool SoftwareRenderDeviceClass::IsQueryDone(unsigned int query, bool flush)
+{
+	return true;
+}
+
+
+void SoftwareRenderDeviceClass::ReleaseQuery(unsigned int query)
+{
+	m_stats.queryCount--;
+
+	m_queries[query - 1] = false;
+	m_freeQueries.push_back(query - 1);
+
+	return;
+}
+
+// BeginScene keeps the clear color, every tile is cleared to it just before it is rasterized.
+void SoftwareRenderDeviceClass::BeginScene(float red, float green, float blue, float alpha)
+{
+	m_clearColor = PackColor(red, green, blue, alpha);
+
+	return;
+}
+
+// EndScene rasterizes the tiles of the frame on every thread, each tile draws the triangles binned into it in the order they were made.
+void SoftwareRenderDeviceClass::EndScene()
+{
+	std::chrono::steady_clock::time_point start;
+	std::atomic<unsigned long long> pixelCount(0);
+	unsigned int texture, threadCount;
+	size_t i;
+
+
+	start = std::chrono::steady_clock::now();
+
+	m_drawTextures.resize(m_draws.size());
+	for (i = 0; i < m_draws.size(); i++)
+	{
+		texture = m_draws[i].texture;
+		m_drawTextures[i] = (texture && texture <= m_textures.size() && m_textures[texture - 1].live) ? &m_textures[texture - 1] : 0;
+	}
+
+	RunWorkers((size_t)m_tilesX * m_tilesY, [&](size_t tile)
+	{
+		pixelCount += RasterizeTile((unsigned int)tile);
+	});
+
+	threadCount = m_threadCount ? m_threadCount : std::thread::hardware_concurrency();
+	m_frameStats.threadCount = threadCount ? threadCount : 1;
+	m_frameStats.pixelCount = pixelCount;
+	m_frameStats.rasterSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	m_lastFrameStats = m_frameStats;
+	memset(&m_frameStats, 0, sizeof(m_frameStats));
+
+	m_draws.clear();
+	m_chunkCount = 0;
+	m_stats.frameCount++;
+
+	return;
+}
+
+
+void SoftwareRenderDeviceClass::SetVertexBuffers(unsigned int startSlot, unsigned int count, const unsigned int* buffers, const unsigned int* strides,
+	const unsigned int* offsets)
+{
+	unsigned int i;
+
+
+	for (i = 0; i < count && startSlot + i < RENDER_MAX_VERTEX_BUFFERS; i++)
+	{
+		m_vertexBuffers[startSlot + i] = buffers[i];
+		m_vertexStrides[startSlot + i] = strides[i];
+		m_vertexOffsets[startSlot + i] = offsets[i];
+	}
+	m_stats.bindCount++;
+
+	return;
+}
+
+
+void SoftwareRenderDeviceClass::SetIndexBuffer(unsigned int buffer, DXGI_FORMAT format, unsigned int offset)
+{
+	m_indexBuffer = buffer;
+	m_indexFormat = format;
+	m_indexOffset = offset;
+	m_stats.bindCount++;
+
+	return;
+}
+
+
+void SoftwareRenderDeviceClass::SetShader(unsigned int shader)
+{
+	m_shader = shader;
+	m_stats.bindCount++;
+
+	return;
+}
+
+// Only the vertex shaders read constants, the bindings of the pixel stage are counted and otherwise ignored.
+void SoftwareRenderDeviceClass::SetConstantBuffer(RenderShaderStageType stage, unsigned int slot, unsigned int buffer, unsigned int firstConstant,
+	unsigned int constantCount)
+{
+	if (stage == RENDER_STAGE_VERTEX && slot < RENDER_MAX_CONSTANT_BUFFERS)
+	{
+		m_constantBuffers[slot].buffer = buffer;
+		m_constantBuffers[slot].firstConstant = firstConstant;
+		m_constantBuffers[slot].constantCount = constantCount;
+	}
+	m_stats.bindCount++;
+
+	return;
+}
+
+
+void SoftwareRenderDeviceClass::SetTexture(unsigned int slot, unsigned int texture)
+{
+	if (slot < RENDER_MAX_TEXTURES)
+	{
+		m_boundTextures[slot] = texture;
+	}
+	m_stats.bindCount++;
+
+	return;
+}
+
+// DrawIndexed runs the vertex shader over the vertices the indices reach, then sets up and bins the triangles, both spread over the
+// threads. A draw the bound state can not make is skipped and counted as an error.
+void SoftwareRenderDeviceClass::DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex)
+{
+	m_stats.drawCount++;
+	m_stats.instanceCount++;
+	m_stats.indexCount += indexCount;
+
+	Draw(indexCount, 1, startIndex, baseVertex, 0);
+
+	return;
+}
+
+
+void SoftwareRenderDeviceClass::DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int startIndex, int baseVertex,
+	unsigned int startInstance)
+{
+	m_stats.drawCount++;
+	m_stats.instanceCount += instanceCount;
+	m_stats.indexCount += (unsigned long long)indexCount * instanceCount;
+
+	Draw(indexCount, instanceCount, startIndex, baseVertex, startInstance);
+
+	return;
+}
+
+
+bool SoftwareRenderDeviceClass::CreateCommandList(OUT unsigned int& commandList)
+{
+	CommandListClass* commands;
+	unsigned int index;
+
+
+	commandList = RENDER_HANDLE_NONE;
+	commands = new CommandListClass;
+	if (!commands)
+	{
+		return false;
+	}
+	commands->Initialize(this);
+
+	if (!m_freeCommandLists.empty())
+	{
+		index = m_freeCommandLists.back();
+		m_freeCommandLists.pop_back();
+		m_commandLists[index] = commands;
+	}
+	else
+	{
+		index = (unsigned int)m_commandLists.size();
+		m_commandLists.push_back(commands);
+	}
+	commandList = index + 1;
+
+	return true;
+}
+
+// BeginCommandList is called on the thread that records, it only empties the list.
+bool SoftwareRenderDeviceClass::BeginCommandList(unsigned int commandList, OUT RenderDeviceClass*& recorder)
+{
+	m_commandLists[commandList - 1]->Reset();
+	recorder = m_commandLists[commandList - 1];
+
+	return true;
+}
+
+
+void SoftwareRenderDeviceClass::EndCommandList(unsigned int commandList)
+{
+	return;
+}
+
+// ExecuteCommandList draws the list from nothing bound. Calls the list could not record count as errors of the device.
+void SoftwareRenderDeviceClass::ExecuteCommandList(unsigned int commandList)
+{
+	CommandListClass* commands;
+
+
+	commands = m_commandLists[commandList - 1];
+	m_stats.errorCount += commands->GetStats().errorCount;
+
+	ClearBindings();
+	commands->Execute(this);
+	ClearBindings();
+
+	return;
+}
+
+
+void SoftwareRenderDeviceClass::ReleaseCommandList(unsigned int commandList)
+{
+	m_commandLists[commandList - 1]->Shutdown();
+	delete m_commandLists[commandList - 1];
+	m_commandLists[commandList - 1] = 0;
+	m_freeCommandLists.push_back(commandList - 1);
+
+	return;
+}
+
+
+int SoftwareRenderDeviceClass::GetWidth()
+{
+	return m_screenWidth;
+}
+
+
+int SoftwareRenderDeviceClass::GetHeight()
+{
+	return m_screenHeight;
+}
+
+// ReadPixels copies out the last frame, a row after the other without the padding, RGBA with red in the low byte.
+void SoftwareRenderDeviceClass::ReadPixels(OUT std::vector<unsigned int>& pixels)
+{
+	int y;
+
+
+	pixels.resize((size_t)m_screenWidth * m_screenHeight);
+	for (y = 0; y < m_screenHeight; y++)
+	{
+		memcpy(&pixels[(size_t)y * m_screenWidth], &m_colorBuffer[(size_t)y * m_pitch], m_screenWidth * sizeof(unsigned int));
+	}
+
+	return;
+}
+
+// SaveBitmap writes the last frame to a 32 bit top down BMP file.
+bool SoftwareRenderDeviceClass::SaveBitmap(const char* filename)
+{
+	FILE* file;
+	unsigned char header[54];
+	std::vector<unsigned char> row;
+	unsigned int imageSize, fields[13], color;
+	int x, y, i;
+
+
+	file = fopen(filename, "wb");
+	if (!file)
+	{
+		return false;
+	}
+
+	// The file header and the BITMAPINFOHEADER, little endian. A negative height puts the first row at the top.
+	imageSize = (unsigned int)m_screenWidth * m_screenHeight * 4;
+	fields[0] = sizeof(header) + imageSize;
+	fields[1] = 0;
+	fields[2] = sizeof(header);
+	fields[3] = 40;
+	fields[4] = (unsigned int)m_screenWidth;
+	fields[5] = (unsigned int)-m_screenHeight;
+	fields[6] = 1 | (32 << 16);
+	fields[7] = 0;
+	fields[8] = imageSize;
+	fields[9] = 2835;
+	fields[10] = 2835;
+	fields[11] = 0;
+	fields[12] = 0;
+	header[0] = 'B';
+	header[1] = 'M';
+	for (i = 0; i < 13; i++)
+	{
+		header[2 + i * 4] = (unsigned char)fields[i];
+		header[3 + i * 4] = (unsigned char)(fields[i] >> 8);
+		header[4 + i * 4] = (unsigned char)(fields[i] >> 16);
+		header[5 + i * 4] = (unsigned char)(fields[i] >> 24);
+	}
+	fwrite(header, 1, sizeof(header), file);
+
+	// BMP pixels are blue, green, red, alpha.
+	row.resize((size_t)m_screenWidth * 4);
+	for (y = 0; y < m_screenHeight; y++)
+	{
+		for (x = 0; x < m_screenWidth; x++)
+		{
+			color = m_colorBuffer[(size_t)y * m_pitch + x];
+			row[x * 4 + 0] = (unsigned char)(color >> 16);
+			row[x * 4 + 1] = (unsigned char)(color >> 8);
+			row[x * 4 + 2] = (unsigned char)color;
+			row[x * 4 + 3] = (unsigned char)(color >> 24);
+		}
+		fwrite(row.data(), 1, row.size(), file);
+	}
+
+	if (fclose(file) != 0)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+
+SoftwareRenderDeviceClass::FrameStatsType SoftwareRenderDeviceClass::GetFrameStats()
+{
+	return m_lastFrameStats;
+}
+
+// GetConstants returns where the constants bound to a vertex shader slot start, if the binding holds at least size bytes.
+const unsigned char* SoftwareRenderDeviceClass::GetConstants(unsigned int slot, unsigned int size)
+{
+	const ConstantBindingType& binding = m_constantBuffers[slot];
+	const BufferType* buffer;
+	unsigned long long offset, available;
+
+
+	if (!binding.buffer || binding.buffer > m_buffers.size() || !m_buffers[binding.buffer - 1].live)
+	{
+		return 0;
+	}
+	buffer = &m_buffers[binding.buffer - 1];
+
+	offset = (unsigned long long)binding.firstConstant * 16;
+	if (offset >= buffer->desc.byteWidth)
+	{
+		return 0;
+	}
+	available = binding.constantCount ? (unsigned long long)binding.constantCount * 16 : buffer->desc.byteWidth - offset;
+	if (size > available || offset + size > buffer->desc.byteWidth)
+	{
+		return 0;
+	}
+
+	return buffer->memory.data() + offset;
+}
+
+// DecodeImage reads the top level of an uncompressed DDS file with 16, 24 or 32 bits to a pixel, or 8 bit RGBA and BGRA through the
+// DX10 header. Anything else leaves a white texel and returns false.
+bool SoftwareRenderDeviceClass::DecodeImage(const unsigned char* data, size_t size, TextureType& texture)
+{
+	unsigned int width, height, flags, fourCC, bitCount, masks[4], format, pixel, byteCount, x, y, i;
+	size_t offset, rowPitch;
+	const unsigned char* source;
+
+
+	texture.live = true;
+	texture.width = 1;
+	texture.height = 1;
+	texture.texels.assign(1, 0xffffffff);
+
+	if (size < 128 || memcmp(data, "DDS ", 4) != 0)
+	{
+		return false;
+	}
+
+	height = ReadUint32(data + 12);
+	width = ReadUint32(data + 16);
+	flags = ReadUint32(data + 80);
+	fourCC = ReadUint32(data + 84);
+	bitCount = ReadUint32(data + 88);
+	for (i = 0; i < 4; i++)
+	{
+		masks[i] = ReadUint32(data + 92 + i * 4);
+	}
+	offset = 128;
+
+	// A fourCC of DX10 has the DXGI format in an extra header, no other fourCC is an uncompressed format this reads.
+	if (flags & 0x4)
+	{
+		if (fourCC != 0x30315844 || size < 148)
+		{
+			return false;
+		}
+		format = ReadUint32(data + 128);
+		offset = 148;
+		bitCount = 32;
+		if (format == DXGI_FORMAT_R8G8B8A8_UNORM || format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB)
+		{
+			masks[0] = 0x000000ff;
+			masks[1] = 0x0000ff00;
+			masks[2] = 0x00ff0000;
+			masks[3] = 0xff000000;
+		}
+		else if (format == DXGI_FORMAT_B8G8R8A8_UNORM || format == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB)
+		{
+			masks[0] = 0x00ff0000;
+			masks[1] = 0x0000ff00;
+			masks[2] = 0x000000ff;
+			masks[3] = 0xff000000;
+		}
+		else
+		{
+			return false;
+		}
+	}
+	else if (flags & 0x40)
+	{
+		if (bitCount != 16 && bitCount != 24 && bitCount != 32)
+		{
+			return false;
+		}
+		// Without the alpha pixels flag the alpha mask means nothing.
+		if (!(flags & 0x1))
+		{
+			masks[3] = 0;
+		}
+	}
+	else
+	{
+		return false;
+	}
+
+	byteCount = bitCount / 8;
+	rowPitch = (size_t)width * byteCount;
+	if (width == 0 || height == 0 || width > 16384 || height > 16384 || offset + rowPitch * height > size)
+	{
+		return false;
+	}
+
+	texture.width = (int)width;
+	texture.height = (int)height;
+	texture.texels.resize((size_t)width * height);
+	for (y = 0; y < height; y++)
+	{
+		source = data + offset + rowPitch * y;
+		for (x = 0; x < width; x++)
+		{
+			pixel = 0;
+			for (i = 0; i < byteCount; i++)
+			{
+				pixel |= (unsigned int)source[x * byteCount + i] << (i * 8);
+			}
+			texture.texels[(size_t)y * width + x] = ExtractChannel(pixel, masks[0], 0) | (ExtractChannel(pixel, masks[1], 0) << 8) |
+				(ExtractChannel(pixel, masks[2], 0) << 16) | (ExtractChannel(pixel, masks[3], 255) << 24);
+		}
+	}
+
+	return true;
+}
+
+
+unsigned int SoftwareRenderDeviceClass::AddTexture(TextureType& texture)
+{
+	unsigned int index;
+
+
+	if (!m_freeTextures.empty())
+	{
+		index = m_freeTextures.back();
+		m_freeTextures.pop_back();
+		m_textures[index] = std::move(texture);
+	}
+	else
+	{
+		index = (unsigned int)m_textures.size();
+		m_textures.push_back(std::move(texture));
+	}
+	m_stats.textureCount++;
+
+	return index + 1;
+}
+
+// Draw transforms, sets up and bins the triangles of a draw once for every instance. An instanced shader puts the world matrix of each
+// instance from the instance stream in front of the view-projection matrix of the frame constants, any other shader draws the same
+// vertices for every instance.
+void SoftwareRenderDeviceClass::Draw(unsigned int indexCount, unsigned int instanceCount, unsigned int startIndex, int baseVertex,
+	unsigned int startInstance)
+{
+	std::chrono::steady_clock::time_point start;
+	const ShaderType* shader;
+	const ElementType* elements[2];
+	const ElementType* row;
+	const BufferType* buffer;
+	const unsigned char* constants;
+	const unsigned char* indices;
+	float transform[16], viewWorld[16], world[16];
+	bool wideIndices;
+	unsigned int indexSize, triangleCount, lowest, highest, index, vertexCount, blockCount, chunkCount, attributeCount, draw, slot, instance, i;
+	long long firstVertex, lastVertex;
+	DrawType drawState;
+
+
+	triangleCount = indexCount / 3;
+	if (triangleCount == 0 || instanceCount == 0)
+	{
+		return;
+	}
+
+	start = std::chrono::steady_clock::now();
+
+	if (!m_shader || m_shader > m_shaders.size() || !m_shaders[m_shader - 1].live || !m_indexBuffer)
+	{
+		m_stats.errorCount++;
+		return;
+	}
+	shader = &m_shaders[m_shader - 1];
+
+	// The indices of the draw have to be inside the index buffer.
+	buffer = &m_buffers[m_indexBuffer - 1];
+	wideIndices = m_indexFormat == DXGI_FORMAT_R32_UINT;
+	indexSize = wideIndices ? 4 : 2;
+	if ((unsigned long long)m_indexOffset + ((unsigned long long)startIndex + triangleCount * 3) * indexSize > buffer->desc.byteWidth)
+	{
+		m_stats.errorCount++;
+		return;
+	}
+	indices = buffer->memory.data() + m_indexOffset + (size_t)startIndex * indexSize;
+
+	// The constants are transposed for the shader, so the rows of the stored matrix dotted with the position give clip space. The
+	// texture shader reads the world-view-projection matrix from the object constants, the color shader multiplies out its three and
+	// the instanced texture shader reads the view-projection matrix from the frame constants. Every row of every instance has to be
+	// inside its buffer.
+	if (shader->instanced)
+	{
+		constants = GetConstants(0, 192);
+		if (!constants)
+		{
+			m_stats.errorCount++;
+			return;
+		}
+
+		for (i = 0; i < 3; i++)
+		{
+			row = &shader->worldRows[i];
+			slot = row->slot;
+			if (!m_vertexBuffers[slot] || (unsigned long long)m_vertexOffsets[slot] + ((unsigned long long)startInstance + instanceCount - 1) *
+				m_vertexStrides[slot] + row->offset + GetFormatSize(row->format) > m_buffers[m_vertexBuffers[slot] - 1].desc.byteWidth)
+			{
+				m_stats.errorCount++;
+				return;
+			}
+		}
+	}
+	else if (shader->program == SOFTWARE_PROGRAM_TEXTURE)
+	{
+		constants = GetConstants(1, 64);
+		if (!constants)
+		{
+			m_stats.errorCount++;
+			return;
+		}
+		memcpy(transform, constants, sizeof(transform));
+	}
+	else
+	{
+		constants = GetConstants(0, 192);
+		if (!constants)
+		{
+			m_stats.errorCount++;
+			return;
+		}
+		MultiplyMatrices((const float*)(constants + 64), (const float*)constants, viewWorld);
+		MultiplyMatrices((const float*)(constants + 128), viewWorld, transform);
+	}
+
+	// Only the vertices between the lowest and highest index are transformed.
+	lowest = 0xffffffff;
+	highest = 0;
+	for (i = 0; i < triangleCount * 3; i++)
+	{
+		index = wideIndices ? ((const unsigned int*)indices)[i] : ((const unsigned short*)indices)[i];
+		lowest = index < lowest ? index : lowest;
+		highest = index > highest ? index : highest;
+	}
+
+	firstVertex = (long long)lowest + baseVertex;
+	lastVertex = (long long)highest + baseVertex;
+	if (firstVertex < 0)
+	{
+		m_stats.errorCount++;
+		return;
+	}
+
+	elements[0] = &shader->position;
+	elements[1] = &shader->attribute;
+	for (i = 0; i < 2; i++)
+	{
+		slot = elements[i]->slot;
+		if (!m_vertexBuffers[slot] ||
+			(unsigned long long)m_vertexOffsets[slot] + lastVertex * m_vertexStrides[slot] + elements[i]->offset + GetFormatSize(elements[i]->format) >
+			m_buffers[m_vertexBuffers[slot] - 1].desc.byteWidth)
+		{
+			m_stats.errorCount++;
+			return;
+		}
+	}
+
+	vertexCount = highest - lowest + 1;
+	if (m_clipVertices.size() < vertexCount)
+	{
+		m_clipVertices.resize(vertexCount);
+	}
+
+	// The texture is looked up again at EndScene, the triangles only keep which draw they came from.
+	drawState.program = shader->program;
+	drawState.texture = m_boundTextures[0];
+	draw = (unsigned int)m_draws.size();
+	m_draws.push_back(drawState);
+	attributeCount = (shader->program == SOFTWARE_PROGRAM_TEXTURE) ? 2 : 4;
+
+	blockCount = (vertexCount + SOFTWARE_VERTEX_BLOCK - 1) / SOFTWARE_VERTEX_BLOCK;
+	chunkCount = (triangleCount + SOFTWARE_CHUNK_TRIANGLES - 1) / SOFTWARE_CHUNK_TRIANGLES;
+	for (instance = 0; instance < instanceCount; instance++)
+	{
+		// The rows of the world matrix are stored without the last one, which is 0, 0, 0, 1.
+		if (shader->instanced)
+		{
+			for (i = 0; i < 3; i++)
+			{
+				row = &shader->worldRows[i];
+				slot = row->slot;
+				FetchElement(m_buffers[m_vertexBuffers[slot] - 1].memory.data() + m_vertexOffsets[slot] +
+					(size_t)(startInstance + instance) * m_vertexStrides[slot] + row->offset, row->format, &world[i * 4]);
+			}
+			world[12] = 0.0f;
+			world[13] = 0.0f;
+			world[14] = 0.0f;
+			world[15] = 1.0f;
+			MultiplyMatrices((const float*)(constants + 128), world, transform);
+		}
+
+		if (instance == 0 || shader->instanced)
+		{
+			RunWorkers(blockCount, [&](size_t block)
+			{
+				unsigned int first, count;
+
+				first = (unsigned int)block * SOFTWARE_VERTEX_BLOCK;
+				count = vertexCount - first < SOFTWARE_VERTEX_BLOCK ? vertexCount - first : SOFTWARE_VERTEX_BLOCK;
+				TransformVertices(*shader, transform, (unsigned int)firstVertex + first, count, &m_clipVertices[first]);
+			});
+		}
+
+		if (m_chunks.size() < m_chunkCount + chunkCount)
+		{
+			m_chunks.resize(m_chunkCount + chunkCount);
+		}
+
+		RunWorkers(chunkCount, [&](size_t chunk)
+		{
+			unsigned int first, count;
+
+			first = (unsigned int)chunk * SOFTWARE_CHUNK_TRIANGLES;
+			count = triangleCount - first < SOFTWARE_CHUNK_TRIANGLES ? triangleCount - first : SOFTWARE_CHUNK_TRIANGLES;
+			SetupChunk(m_chunks[m_chunkCount + chunk], indices + (size_t)first * 3 * indexSize, wideIndices, count, lowest, m_clipVertices.data(),
+				attributeCount, draw);
+		});
+
+		for (i = 0; i < chunkCount; i++)
+		{
+			m_frameStats.culledCount += m_chunks[m_chunkCount + i].culledCount;
+			m_frameStats.clippedCount += m_chunks[m_chunkCount + i].clippedCount;
+			m_frameStats.binnedCount += (unsigned int)m_chunks[m_chunkCount + i].tileTriangles.size();
+		}
+		m_chunkCount += chunkCount;
+		m_frameStats.triangleCount += triangleCount;
+	}
+	m_frameStats.setupSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	return;
+}
+
+// TransformVertices is the vertex shader: the position with a w of one times the transform, and the attribute passed on as it is.
+void SoftwareRenderDeviceClass::TransformVertices(const ShaderType& shader, const float* transform, unsigned int firstVertex, unsigned int vertexCount,
+	ClipVertexType* vertices)
+{
+	const unsigned char* positions;
+	const unsigned char* attributes;
+	unsigned int positionStride, attributeStride, i;
+	float position[4];
+	int row;
+
+
+	positions = m_buffers[m_vertexBuffers[shader.position.slot] - 1].memory.data() + m_vertexOffsets[shader.position.slot] + shader.position.offset;
+	positionStride = m_vertexStrides[shader.position.slot];
+	attributes = m_buffers[m_vertexBuffers[shader.attribute.slot] - 1].memory.data() + m_vertexOffsets[shader.attribute.slot] +
+		shader.attribute.offset;
+	attributeStride = m_vertexStrides[shader.attribute.slot];
+
+	for (i = 0; i < vertexCount; i++)
+	{
+		FetchElement(positions + (size_t)(firstVertex + i) * positionStride, shader.position.format, position);
+		position[3] = 1.0f;
+
+		for (row = 0; row < 4; row++)
+		{
+			vertices[i].position[row] = transform[row * 4 + 0] * position[0] + transform[row * 4 + 1] * position[1] + transform[row * 4 + 2] * position[2] +
+				transform[row * 4 + 3];
+		}
+
+		FetchElement(attributes + (size_t)(firstVertex + i) * attributeStride, shader.attribute.format, vertices[i].attribute);
+	}
+
+	return;
+}
+
+// SetupChunk sets up one chunk of a draw's triangles. Triangles entirely outside one side of the view are dropped, those crossing the
+// near plane or the guard band are clipped and the polygon left over is drawn as a fan.
+void SoftwareRenderDeviceClass::SetupChunk(ChunkType& chunk, const void* indices, bool wideIndices, unsigned int triangleCount,
+	unsigned int firstVertex, const ClipVertexType* vertices, unsigned int attributeCount, unsigned int draw)
+{
+	const ClipVertexType* corners[3];
+	ClipVertexType polygons[2][CLIP_MAX_VERTICES + 1];
+	TriangleType triangle;
+	float guardX, guardY, distance, nextDistance, t;
+	unsigned int outcodes[3], planes, plane, index, i, k;
+	int vertexCount, newCount, current, v, next, c;
+
+
+	chunk.triangles.clear();
+	chunk.culledCount = 0;
+	chunk.clippedCount = 0;
+
+	// The guard band in clip space, the screen reaches one either side of the center.
+	guardX = (2.0f * SOFTWARE_GUARD_BAND_PIXELS - (float)m_screenWidth) / (float)m_screenWidth;
+	guardY = (2.0f * SOFTWARE_GUARD_BAND_PIXELS - (float)m_screenHeight) / (float)m_screenHeight;
+
+	for (i = 0; i < triangleCount; i++)
+	{
+		for (k = 0; k < 3; k++)
+		{
+			index = wideIndices ? ((const unsigned int*)indices)[i * 3 + k] : ((const unsigned short*)indices)[i * 3 + k];
+			corners[k] = &vertices[index - firstVertex];
+			outcodes[k] = GetOutcode(corners[k]->position, guardX, guardY);
+		}
+
+		if (outcodes[0] & outcodes[1] & outcodes[2] & OUTCODE_VIEW)
+		{
+			chunk.culledCount++;
+			continue;
+		}
+
+		planes = (outcodes[0] | outcodes[1] | outcodes[2]) & OUTCODE_CLIP;
+		if (!planes)
+		{
+			if (SetupTriangle(*corners[0], *corners[1], *corners[2], attributeCount, draw, triangle))
+			{
+				chunk.triangles.push_back(triangle);
+			}
+			else
+			{
+				chunk.culledCount++;
+			}
+			continue;
+		}
+
+		// Sutherland-Hodgman against each plane a vertex is outside of, going back and forth between the two polygons.
+		chunk.clippedCount++;
+		for (k = 0; k < 3; k++)
+		{
+			polygons[0][k] = *corners[k];
+		}
+		vertexCount = 3;
+		current = 0;
+		for (plane = OUTCODE_NEAR; plane <= OUTCODE_GUARD_TOP && vertexCount >= 3; plane <<= 1)
+		{
+			if (!(planes & plane))
+			{
+				continue;
+			}
+
+			newCount = 0;
+			for (v = 0; v < vertexCount; v++)
+			{
+				next = (v + 1) % vertexCount;
+				distance = ClipDistance(polygons[current][v].position, plane, guardX, guardY);
+				nextDistance = ClipDistance(polygons[current][next].position, plane, guardX, guardY);
+				if (distance >= 0.0f)
+				{
+					polygons[1 - current][newCount++] = polygons[current][v];
+				}
+				if ((distance >= 0.0f) != (nextDistance >= 0.0f))
+				{
+					t = distance / (distance - nextDistance);
+					for (c = 0; c < 4; c++)
+					{
+						polygons[1 - current][newCount].position[c] = polygons[current][v].position[c] +
+							(polygons[current][next].position[c] - polygons[current][v].position[c]) * t;
+						polygons[1 - current][newCount].attribute[c] = polygons[current][v].attribute[c] +
+							(polygons[current][next].attribute[c] - polygons[current][v].attribute[c]) * t;
+					}
+					newCount++;
+				}
+			}
+			vertexCount = newCount;
+			current = 1 - current;
+		}
+
+		for (v = 1; v + 1 < vertexCount; v++)
+		{
+			if (SetupTriangle(polygons[current][0], polygons[current][v], polygons[current][v + 1], attributeCount, draw, triangle))
+			{
+				chunk.triangles.push_back(triangle);
+			}
+		}
+	}
+
+	BinChunk(chunk);
+
+	return;
+}
+
+// SetupTriangle projects and snaps a triangle and works out its edge functions, its bounds and the planes of what is interpolated
+// over it. It returns false for a triangle that faces away, as the rasterizer state culls back faces of clockwise fronts, or that
+// covers no pixel center.
+bool SoftwareRenderDeviceClass::SetupTriangle(const ClipVertexType& vertex0, const ClipVertexType& vertex1, const ClipVertexType& vertex2,
+	unsigned int attributeCount, unsigned int draw, OUT TriangleType& triangle)
+{
+	const ClipVertexType* corners[3];
+	float halfWidth, halfHeight, invW[3], screenX[3], screenY[3], values[6][3], d1x, d1y, d2x, d2y, invArea, df1, df2;
+	int fixedX[3], fixedY[3], minFixedX, maxFixedX, minFixedY, maxFixedY, i, j, k;
+	long long area;
+
+
+	corners[0] = &vertex0;
+	corners[1] = &vertex1;
+	corners[2] = &vertex2;
+
+	halfWidth = 0.5f * (float)m_screenWidth;
+	halfHeight = 0.5f * (float)m_screenHeight;
+
+	// The viewport transform with y down, snapped to sixteenths of a pixel.
+	for (k = 0; k < 3; k++)
+	{
+		if (!(corners[k]->position[3] > 0.0f))
+		{
+			return false;
+		}
+		invW[k] = 1.0f / corners[k]->position[3];
+		fixedX[k] = (int)lrintf((corners[k]->position[0] * invW[k] * halfWidth + halfWidth) * 16.0f);
+		fixedY[k] = (int)lrintf((halfHeight - corners[k]->position[1] * invW[k] * halfHeight) * 16.0f);
+		screenX[k] = (float)fixedX[k] * (1.0f / 16.0f);
+		screenY[k] = (float)fixedY[k] * (1.0f / 16.0f);
+	}
+
+	// With y down a clockwise triangle has a positive area.
+	area = (long long)(fixedX[1] - fixedX[0]) * (fixedY[2] - fixedY[0]) - (long long)(fixedX[2] - fixedX[0]) * (fixedY[1] - fixedY[0]);
+	if (area <= 0)
+	{
+		return false;
+	}
+
+	// The first and last pixel whose center is inside the bounds, clamped to the screen.
+	minFixedX = fixedX[0] < fixedX[1] ? fixedX[0] : fixedX[1];
+	minFixedX = fixedX[2] < minFixedX ? fixedX[2] : minFixedX;
+	maxFixedX = fixedX[0] > fixedX[1] ? fixedX[0] : fixedX[1];
+	maxFixedX = fixedX[2] > maxFixedX ? fixedX[2] : maxFixedX;
+	minFixedY = fixedY[0] < fixedY[1] ? fixedY[0] : fixedY[1];
+	minFixedY = fixedY[2] < minFixedY ? fixedY[2] : minFixedY;
+	maxFixedY = fixedY[0] > fixedY[1] ? fixedY[0] : fixedY[1];
+	maxFixedY = fixedY[2] > maxFixedY ? fixedY[2] : maxFixedY;
+
+	triangle.minX = (minFixedX + 7) >> 4;
+	triangle.maxX = (maxFixedX - 8) >> 4;
+	triangle.minY = (minFixedY + 7) >> 4;
+	triangle.maxY = (maxFixedY - 8) >> 4;
+	triangle.minX = triangle.minX > 0 ? triangle.minX : 0;
+	triangle.minY = triangle.minY > 0 ? triangle.minY : 0;
+	triangle.maxX = triangle.maxX < m_screenWidth - 1 ? triangle.maxX : m_screenWidth - 1;
+	triangle.maxY = triangle.maxY < m_screenHeight - 1 ? triangle.maxY : m_screenHeight - 1;
+	if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+	{
+		return false;
+	}
+
+	// The edge from each corner to the next is positive inside. A pixel center exactly on an edge belongs to the triangle if the edge is
+	// a left edge or a top one, the others are pulled in by one.
+	for (i = 0; i < 3; i++)
+	{
+		j = (i + 1) % 3;
+		triangle.edgeA[i] = fixedY[i] - fixedY[j];
+		triangle.edgeB[i] = fixedX[j] - fixedX[i];
+		triangle.edgeC[i] = -(long long)triangle.edgeA[i] * fixedX[i] - (long long)triangle.edgeB[i] * fixedY[i];
+		if (!(triangle.edgeA[i] > 0 || (triangle.edgeA[i] == 0 && triangle.edgeB[i] > 0)))
+		{
+			triangle.edgeC[i] -= 1;
+		}
+	}
+
+	// Depth is linear in screen space, the attribute is only linear divided by w. The planes the program has no use for are zero.
+	for (k = 0; k < 3; k++)
+	{
+		values[0][k] = corners[k]->position[2] * invW[k];
+		values[1][k] = invW[k];
+		for (i = 0; i < 4; i++)
+		{
+			values[2 + i][k] = (i < (int)attributeCount) ? corners[k]->attribute[i] * invW[k] : 0.0f;
+		}
+	}
+
+	d1x = screenX[1] - screenX[0];
+	d1y = screenY[1] - screenY[0];
+	d2x = screenX[2] - screenX[0];
+	d2y = screenY[2] - screenY[0];
+	invArea = 256.0f / (float)area;
+	for (i = 0; i < 6; i++)
+	{
+		df1 = values[i][1] - values[i][0];
+		df2 = values[i][2] - values[i][0];
+		triangle.planes[i][0] = (df1 * d2y - df2 * d1y) * invArea;
+		triangle.planes[i][1] = (df2 * d1x - df1 * d2x) * invArea;
+		triangle.planes[i][2] = values[i][0] - triangle.planes[i][0] * screenX[0] - triangle.planes[i][1] * screenY[0];
+	}
+	triangle.draw = draw;
+
+	return true;
+}
+
+// BinChunk lists the triangles of the chunk by the tiles their bounds touch. The triangles of each tile are counted first, so they can
+// be written straight to their place in one array.
+void SoftwareRenderDeviceClass::BinChunk(ChunkType& chunk)
+{
+	unsigned int tileCount, tile, i;
+	int tileX, tileY;
+
+
+	tileCount = (unsigned int)(m_tilesX * m_tilesY);
+	chunk.tileStarts.assign(tileCount + 1, 0);
+
+	for (i = 0; i < chunk.triangles.size(); i++)
+	{
+		const TriangleType& triangle = chunk.triangles[i];
+		for (tileY = triangle.minY / SOFTWARE_TILE_SIZE; tileY <= triangle.maxY / SOFTWARE_TILE_SIZE; tileY++)
+		{
+			for (tileX = triangle.minX / SOFTWARE_TILE_SIZE; tileX <= triangle.maxX / SOFTWARE_TILE_SIZE; tileX++)
+			{
+				chunk.tileStarts[tileY * m_tilesX + tileX + 1]++;
+			}
+		}
+	}
+
+	for (tile = 1; tile <= tileCount; tile++)
+	{
+		chunk.tileStarts[tile] += chunk.tileStarts[tile - 1];
+	}
+	chunk.tileTriangles.resize(chunk.tileStarts[tileCount]);
+
+	// Each start is moved along as its tile is filled, which leaves it at the start of the next tile. Moving them all back one slot
+	// restores the starts.
+	for (i = 0; i < chunk.triangles.size(); i++)
+	{
+		const TriangleType& triangle = chunk.triangles[i];
+		for (tileY = triangle.minY / SOFTWARE_TILE_SIZE; tileY <= triangle.maxY / SOFTWARE_TILE_SIZE; tileY++)
+		{
+			for (tileX = triangle.minX / SOFTWARE_TILE_SIZE; tileX <= triangle.maxX / SOFTWARE_TILE_SIZE; tileX++)
+			{
+				chunk.tileTriangles[chunk.tileStarts[tileY * m_tilesX + tileX]++] = i;
+			}
+		}
+	}
+
+	for (tile = tileCount; tile > 0; tile--)
+	{
+		chunk.tileStarts[tile] = chunk.tileStarts[tile - 1];
+	}
+	chunk.tileStarts[0] = 0;
+
+	return;
+}
+
+// RasterizeTile clears one tile and draws every triangle binned into it, chunk after chunk. It returns the pixels written.
+unsigned long long SoftwareRenderDeviceClass::RasterizeTile(unsigned int tile)
+{
+	unsigned long long pixelCount;
+	int tileX, tileY, y;
+	unsigned int chunk, i;
+
+
+	tileX = (int)(tile % m_tilesX) * SOFTWARE_TILE_SIZE;
+	tileY = (int)(tile / m_tilesX) * SOFTWARE_TILE_SIZE;
+
+	for (y = tileY; y < tileY + SOFTWARE_TILE_SIZE; y++)
+	{
+		std::fill_n(&m_colorBuffer[(size_t)y * m_pitch + tileX], SOFTWARE_TILE_SIZE, m_clearColor);
+		std::fill_n(&m_depthBuffer[(size_t)y * m_pitch + tileX], SOFTWARE_TILE_SIZE, 1.0f);
+	}
+
+	pixelCount = 0;
+	for (chunk = 0; chunk < m_chunkCount; chunk++)
+	{
+		const ChunkType& bins = m_chunks[chunk];
+		for (i = bins.tileStarts[tile]; i < bins.tileStarts[tile + 1]; i++)
+		{
+			const TriangleType& triangle = bins.triangles[bins.tileTriangles[i]];
+			pixelCount += RasterizeTriangle(triangle, m_draws[triangle.draw], m_drawTextures[triangle.draw], tileX, tileY);
+		}
+	}
+
+	return pixelCount;
+}
+
+// RasterizeTriangle draws the part of a triangle inside one tile. Each edge is first tested at the corners of that part: one that has
+// every corner inside needs no test per pixel, and one with every corner outside leaves nothing to draw. The edges that are left cross
+// the tile, which keeps their values within 32 bits. Pixels are tested four at a time along a row, for coverage and then depth, and
+// only the pixels that pass are shaded.
+unsigned long long SoftwareRenderDeviceClass::RasterizeTriangle(const TriangleType& triangle, const DrawType& draw, const TextureType* texture,
+	int tileX, int tileY)
+{
+	int minX, maxX, minY, maxY, startX, columns, rows, edgeRow[3], edgeStepX[3], edgeStepY[3], x, y, lane, k;
+	long long edge, stepX, stepY, low, high;
+	unsigned int* colorRow;
+	float* depthRow;
+	float rowValues[6], attributes[4][4], pixelX;
+	unsigned int coverMask, passMask, color;
+	unsigned long long pixelCount;
+	int attributeCount;
+
+
+	minX = triangle.minX > tileX ? triangle.minX : tileX;
+	maxX = triangle.maxX < tileX + SOFTWARE_TILE_SIZE - 1 ? triangle.maxX : tileX + SOFTWARE_TILE_SIZE - 1;
+	minY = triangle.minY > tileY ? triangle.minY : tileY;
+	maxY = triangle.maxY < tileY + SOFTWARE_TILE_SIZE - 1 ? triangle.maxY : tileY + SOFTWARE_TILE_SIZE - 1;
+	if (minX > maxX || minY > maxY)
+	{
+		return 0;
+	}
+
+	attributeCount = (draw.program == SOFTWARE_PROGRAM_TEXTURE) ? 2 : 4;
+
+	// Rows start on a multiple of four, the tile does too so the extra pixels are still in it.
+	startX = minX & ~3;
+	columns = ((maxX - startX) | 3) + 1;
+	rows = maxY - minY + 1;
+
+	for (k = 0; k < 3; k++)
+	{
+		stepX = (long long)triangle.edgeA[k] * 16;
+		stepY = (long long)triangle.edgeB[k] * 16;
+		edge = (long long)triangle.edgeA[k] * (startX * 16 + 8) + (long long)triangle.edgeB[k] * (minY * 16 + 8) + triangle.edgeC[k];
+		low = edge + (stepX < 0 ? stepX * (columns - 1) : 0) + (stepY < 0 ? stepY * (rows - 1) : 0);
+		high = edge + (stepX > 0 ? stepX * (columns - 1) : 0) + (stepY > 0 ? stepY * (rows - 1) : 0);
+		if (high < 0)
+		{
+			return 0;
+		}
+
+		if (low >= 0)
+		{
+			edgeRow[k] = 0;
+			edgeStepX[k] = 0;
+			edgeStepY[k] = 0;
+		}
+		else
+		{
+			edgeRow[k] = (int)edge;
+			edgeStepX[k] = (int)stepX;
+			edgeStepY[k] = (int)stepY;
+		}
+	}
+
+	pixelCount = 0;
+	for (y = minY; y <= maxY; y++)
+	{
+		colorRow = &m_colorBuffer[(size_t)y * m_pitch];
+		depthRow = &m_depthBuffer[(size_t)y * m_pitch];
+		for (k = 0; k < 6; k++)
+		{
+			rowValues[k] = triangle.planes[k][1] * ((float)y + 0.5f) + triangle.planes[k][2];
+		}
+
+#ifdef SOFTWARE_RASTER_SSE2
+		__m128i edges[3], edgeSteps[3], cover;
+		__m128 depthX, depthStep, depth, passing, pixelXs, ws;
+		const __m128 laneOffsets = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+
+		for (k = 0; k < 3; k++)
+		{
+			edges[k] = _mm_setr_epi32(edgeRow[k], edgeRow[k] + edgeStepX[k], edgeRow[k] + 2 * edgeStepX[k], edgeRow[k] + 3 * edgeStepX[k]);
+			edgeSteps[k] = _mm_set1_epi32(4 * edgeStepX[k]);
+		}
+		pixelX = (float)startX + 0.5f;
+		depthX = _mm_setr_ps(triangle.planes[0][0] * pixelX, triangle.planes[0][0] * (pixelX + 1.0f), triangle.planes[0][0] * (pixelX + 2.0f),
+			triangle.planes[0][0] * (pixelX + 3.0f));
+		depthX = _mm_add_ps(depthX, _mm_set1_ps(rowValues[0]));
+		depthStep = _mm_set1_ps(4.0f * triangle.planes[0][0]);
+#endif
+
+		for (x = startX; x <= maxX; x += 4)
+		{
+#ifdef SOFTWARE_RASTER_SSE2
+			// A pixel is covered when no edge is negative, so when the sign bit of the three or'ed together is clear.
+			cover = _mm_or_si128(_mm_or_si128(edges[0], edges[1]), edges[2]);
+			coverMask = ~_mm_movemask_ps(_mm_castsi128_ps(cover)) & 15;
+			passMask = 0;
+			if (coverMask)
+			{
+				depth = _mm_loadu_ps(depthRow + x);
+				passing = _mm_andnot_ps(_mm_castsi128_ps(_mm_srai_epi32(cover, 31)), _mm_cmplt_ps(depthX, depth));
+				passMask = _mm_movemask_ps(passing);
+				if (passMask)
+				{
+					_mm_storeu_ps(depthRow + x, _mm_or_ps(_mm_and_ps(passing, depthX), _mm_andnot_ps(passing, depth)));
+				}
+			}
+			for (k = 0; k < 3; k++)
+			{
+				edges[k] = _mm_add_epi32(edges[k], edgeSteps[k]);
+			}
+			depthX = _mm_add_ps(depthX, depthStep);
+#else
+			int laneEdge;
+			float laneDepth;
+
+			passMask = 0;
+			for (lane = 0; lane < 4; lane++)
+			{
+				coverMask = 1;
+				for (k = 0; k < 3; k++)
+				{
+					laneEdge = edgeRow[k] + ((x - startX) + lane) * edgeStepX[k];
+					coverMask &= laneEdge >= 0 ? 1 : 0;
+				}
+				laneDepth = triangle.planes[0][0] * ((float)(x + lane) + 0.5f) + rowValues[0];
+				if (coverMask && laneDepth < depthRow[x + lane])
+				{
+					depthRow[x + lane] = laneDepth;
+					passMask |= 1u << lane;
+				}
+			}
+#endif
+			if (!passMask)
+			{
+				continue;
+			}
+
+			// The pixel shader. The attribute is divided by the interpolated one over w to undo the perspective, for the four pixels at once.
+#ifdef SOFTWARE_RASTER_SSE2
+			pixelXs = _mm_add_ps(_mm_set1_ps((float)x + 0.5f), laneOffsets);
+			ws = _mm_div_ps(_mm_set1_ps(1.0f), _mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle.planes[1][0]), pixelXs), _mm_set1_ps(rowValues[1])));
+			for (k = 0; k < attributeCount; k++)
+			{
+				_mm_storeu_ps(attributes[k], _mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle.planes[2 + k][0]), pixelXs),
+					_mm_set1_ps(rowValues[2 + k])), ws));
+			}
+#else
+			for (lane = 0; lane < 4; lane++)
+			{
+				pixelX = (float)(x + lane) + 0.5f;
+				w = 1.0f / (triangle.planes[1][0] * pixelX + rowValues[1]);
+				for (k = 0; k < attributeCount; k++)
+				{
+					attributes[k][lane] = (triangle.planes[2 + k][0] * pixelX + rowValues[2 + k]) * w;
+				}
+			}
+#endif
+			for (lane = 0; lane < 4; lane++)
+			{
+				if (!(passMask & (1u << lane)))
+				{
+					continue;
+				}
+
+				if (draw.program == SOFTWARE_PROGRAM_TEXTURE)
+				{
+					color = texture ? Sample(*texture, attributes[0][lane], attributes[1][lane]) : 0;
+				}
+				else
+				{
+					color = PackColor(attributes[0][lane], attributes[1][lane], attributes[2][lane], attributes[3][lane]);
+				}
+				colorRow[x + lane] = color;
+			}
+			pixelCount += std::popcount(passMask);
+		}
+
+		for (k = 0; k < 3; k++)
+		{
+			edgeRow[k] += edgeStepY[k];
+		}
+	}
+
+	return pixelCount;
+}
+
+// Sample filters the four texels around a point bilinearly, wrapping at the edges of the texture like the device's sampler. Points
+// inside the texture, which are most of them, are found without a division.
+unsigned int SoftwareRenderDeviceClass::Sample(const TextureType& texture, float u, float v)
+{
+	float x, y;
+	int fixedX, fixedY, x0, y0, x1, y1;
+	unsigned int top, bottom;
+	const unsigned int* texels;
+
+
+	x = u * (float)texture.width - 0.5f;
+	y = v * (float)texture.height - 0.5f;
+	if (!(x >= 0.0f && x < (float)texture.width))
+	{
+		x -= floorf(x / (float)texture.width) * (float)texture.width;
+		// Written so that a NaN ends up at zero.
+		x = (x >= 0.0f && x < (float)texture.width) ? x : 0.0f;
+	}
+	if (!(y >= 0.0f && y < (float)texture.height))
+	{
+		y -= floorf(y / (float)texture.height) * (float)texture.height;
+		y = (y >= 0.0f && y < (float)texture.height) ? y : 0.0f;
+	}
+
+	// With eight bits of fraction the texel is the integer part and the weight the fraction.
+	fixedX = (int)(x * 256.0f);
+	fixedY = (int)(y * 256.0f);
+	x0 = fixedX >> 8;
+	y0 = fixedY >> 8;
+	x0 = x0 < texture.width ? x0 : texture.width - 1;
+	y0 = y0 < texture.height ? y0 : texture.height - 1;
+	x1 = (x0 + 1 < texture.width) ? x0 + 1 : 0;
+	y1 = (y0 + 1 < texture.height) ? y0 + 1 : 0;
+
+	texels = texture.texels.data();
+	top = LerpTexels(texels[y0 * texture.width + x0], texels[y0 * texture.width + x1], fixedX & 255);
+	bottom = LerpTexels(texels[y1 * texture.width + x0], texels[y1 * texture.width + x1], fixedX & 255);
+
+	return LerpTexels(top, bottom, fixedY & 255);
+}
+
+// ClearBindings unbinds everything, the way executing a command list leaves the state.
+void SoftwareRenderDeviceClass::ClearBindings()
+{
+	memset(m_vertexBuffers, 0, sizeof(m_vertexBuffers));
+	memset(m_vertexStrides, 0, sizeof(m_vertexStrides));
+	memset(m_vertexOffsets, 0, sizeof(m_vertexOffsets));
+	m_indexBuffer = 0;
+	m_indexOffset = 0;
+	m_indexFormat = DXGI_FORMAT_R32_UINT;
+	m_shader = 0;
+	memset(m_constantBuffers, 0, sizeof(m_constantBuffers));
+	memset(m_boundTextures, 0, sizeof(m_boundTextures));
+
+	return;
+}
+
+// RunWorkers calls work for every item on the device's threads, the calling thread included, like the ObjParserClass does.
+void SoftwareRenderDeviceClass::RunWorkers(size_t itemCount, const std::function<void(size_t)>& work)
+{
+	std::vector<std::thread> workers;
+	std::atomic<size_t> nextItem(0);
+	unsigned int threadCount, i;
+
+
+	threadCount = m_threadCount ? m_threadCount : std::thread::hardware_concurrency();
+
+	auto worker = [&]()
+	{
+		size_t item;
+		while ((item = nextItem.fetch_add(1)) < itemCount)
+		{
+			work(item);
+		}
+	};
+
+	for (i = 1; i < threadCount && i < itemCount; i++)
+	{
+		workers.emplace_back(worker);
+	}
+
+	worker();
+
+	for (i = 0; i < workers.size(); i++)
+	{
+		workers[i].join();
+	}
+
+	return;
+}
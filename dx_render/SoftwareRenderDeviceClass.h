@@ -0,0 +1,256 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: softwarerenderdeviceclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _SOFTWARERENDERDEVICECLASS_H_
+#define _SOFTWARERENDERDEVICECLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <functional>
+#include <vector>
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "renderdeviceclass.h"
+#include "commandlistclass.h"
+
+
+/////////////
+// GLOBALS //
+/////////////
+// The render target is rasterized in square tiles of this many pixels. A tile's color and depth stay in the cache of the one thread
+// that draws it. The size is a multiple of four, the pixels are tested four at a time along a row.
+const int SOFTWARE_TILE_SIZE = 32;
+// A draw is set up and binned in chunks of this many triangles, each chunk is one work item and keeps its own bins so the triangles of
+// a tile are still drawn in the order they were submitted.
+const unsigned int SOFTWARE_CHUNK_TRIANGLES = 4096;
+// Vertices are transformed in blocks of this many per work item.
+const unsigned int SOFTWARE_VERTEX_BLOCK = 8192;
+// The largest render target. Triangles are clipped to a guard band that keeps every vertex within this many pixels of the origin,
+// which with four bits of subpixel precision keeps the edge functions of a tile within 32 bit integers.
+const int SOFTWARE_MAX_TARGET_SIZE = 4096;
+const float SOFTWARE_GUARD_BAND_PIXELS = 8192.0f;
+
+
+//////////////
+// TYPEDEFS //
+//////////////
+// The shaders the software device can run. It recognizes the texture and color shaders by their entry points and does the same math.
+// The instanced texture shader is the texture program with the world matrix of each instance read from the instance stream.
+enum SoftwareProgramType
+{
+	SOFTWARE_PROGRAM_TEXTURE,
+	SOFTWARE_PROGRAM_COLOR
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: SoftwareRenderDeviceClass
+////////////////////////////////////////////////////////////////////////////////
+// The SoftwareRenderDeviceClass draws on the CPU into a render target in memory, for images on machines without a GPU. It runs
+// what the texture and color shaders do. Vertices are transformed by the same constants and clipped to the near plane. Triangles
+// are culled the way D3DClass sets up the rasterizer, and then snapped to a sixteenth of a pixel. The depth test is less than
+// against a float depth buffer. Textures are sampled bilinearly with wrapping and perspective correct coordinates.
+// A draw is transformed, set up and binned into screen tiles when it is made, on every thread. The tiles are rasterized in parallel at
+// EndScene, with edge functions tested four pixels at a time. Textures are read from uncompressed DDS files and get no mipmaps. Other
+// images are drawn as white. A command list is a CommandListClass that is drawn like calls made straight to the device.
+class SoftwareRenderDeviceClass : public RenderDeviceClass
+{
+public:
+	// The work of the last frame. A triangle is culled when it is outside the view, faces away or covers no pixel center.
+	struct FrameStatsType
+	{
+		unsigned int threadCount;
+		unsigned int triangleCount, culledCount, clippedCount;
+		unsigned int binnedCount;
+		unsigned long long pixelCount;
+		double setupSeconds, rasterSeconds;
+	};
+
+private:
+	struct BufferType
+	{
+		bool live;
+		BufferDescType desc;
+		std::vector<unsigned char> memory;
+	};
+
+	// Texels are RGBA with red in the low byte, the same as the DXGI_FORMAT_R8G8B8A8_UNORM back buffer.
+	struct TextureType
+	{
+		bool live;
+		int width, height;
+		std::vector<unsigned int> texels;
+	};
+
+	struct ElementType
+	{
+		DXGI_FORMAT format;
+		unsigned int slot, offset;
+	};
+
+	// The position and the one attribute the program passes on, the texture coordinates or the color. An instanced shader also reads
+	// the three rows of a world matrix per instance.
+	struct ShaderType
+	{
+		bool live;
+		SoftwareProgramType program;
+		ElementType position, attribute;
+		bool instanced;
+		ElementType worldRows[3];
+	};
+
+	struct ConstantBindingType
+	{
+		unsigned int buffer;
+		unsigned int firstConstant, constantCount;
+	};
+
+	struct DrawType
+	{
+		SoftwareProgramType program;
+		unsigned int texture;
+	};
+
+	// A transformed vertex, its clip space position and its attribute as the vertex shader outputs them.
+	struct ClipVertexType
+	{
+		float position[4];
+		float attribute[4];
+	};
+
+	// A triangle set up for rasterization. The edge functions are in sixteenths of a pixel with the top left fill rule in C. The planes
+	// give depth, one over w and the attribute over w at a pixel as a * x + b * y + c. The bounds are the pixels it can cover.
+	struct TriangleType
+	{
+		int edgeA[3], edgeB[3];
+		long long edgeC[3];
+		float planes[6][3];
+		int minX, minY, maxX, maxY;
+		unsigned int draw;
+	};
+
+	// The triangles one work item set up and the triangles of each tile among them, as the start of each tile in tileTriangles.
+	struct ChunkType
+	{
+		std::vector<TriangleType> triangles;
+		std::vector<unsigned int> tileStarts;
+		std::vector<unsigned int> tileTriangles;
+		unsigned int culledCount, clippedCount;
+	};
+
+public:
+	SoftwareRenderDeviceClass();
+	SoftwareRenderDeviceClass(const SoftwareRenderDeviceClass&);
+	~SoftwareRenderDeviceClass();
+
+	bool Initialize(int screenWidth, int screenHeight);
+	void SetThreadCount(unsigned int);
+	void Shutdown();
+	CapsType GetCaps();
+
+	bool CreateBuffer(const BufferDescType&, const void* initialData, OUT unsigned int& buffer);
+	void UpdateBuffer(unsigned int buffer, unsigned int offset, const void* data, unsigned int size);
+	void CopyBuffer(unsigned int destination, unsigned int destinationOffset, unsigned int source, unsigned int sourceOffset, unsigned int size);
+	bool MapBuffer(unsigned int buffer, RenderMapType, unsigned int offset, unsigned int size, OUT void*& data);
+	void UnmapBuffer(unsigned int buffer);
+	void ReleaseBuffer(unsigned int buffer);
+
+	bool CreateTexture(const wchar_t* filename, OUT unsigned int& texture);
+	bool CreateTexture(const unsigned char* data, size_t size, OUT unsigned int& texture);
+	void ReleaseTexture(unsigned int texture);
+
+	bool CreateShader(const ShaderDescType&, OUT unsigned int& shader);
+	void ReleaseShader(unsigned int shader);
+
+	bool CreateQuery(OUT unsigned int& query);
+	void EndQuery(unsigned int query);
+	bool IsQueryDone(unsigned int query, bool flush);
+	void ReleaseQuery(unsigned int query);
+
+	void BeginScene(float red, float green, float blue, float alpha);
+	void EndScene();
+
+	void SetVertexBuffers(unsigned int startSlot, unsigned int count, const unsigned int* buffers, const unsigned int* strides,
+		const unsigned int* offsets);
+	void SetIndexBuffer(unsigned int buffer, DXGI_FORMAT format, unsigned int offset);
+	void SetShader(unsigned int shader);
+	void SetConstantBuffer(RenderShaderStageType, unsigned int slot, unsigned int buffer, unsigned int firstConstant, unsigned int constantCount);
+	void SetTexture(unsigned int slot, unsigned int texture);
+	void DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex);
+	void DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int startIndex, int baseVertex,
+		unsigned int startInstance);
+
+	bool CreateCommandList(OUT unsigned int& commandList);
+	bool BeginCommandList(unsigned int commandList, OUT RenderDeviceClass*& recorder);
+	void EndCommandList(unsigned int commandList);
+	void ExecuteCommandList(unsigned int commandList);
+	void ReleaseCommandList(unsigned int commandList);
+
+	int GetWidth();
+	int GetHeight();
+	void ReadPixels(OUT std::vector<unsigned int>& pixels);
+	bool SaveBitmap(const char* filename);
+	FrameStatsType GetFrameStats();
+
+private:
+	const unsigned char* GetConstants(unsigned int slot, unsigned int size);
+	bool DecodeImage(const unsigned char* data, size_t size, TextureType& texture);
+	unsigned int AddTexture(TextureType& texture);
+
+	void Draw(unsigned int indexCount, unsigned int instanceCount, unsigned int startIndex, int baseVertex, unsigned int startInstance);
+	void TransformVertices(const ShaderType&, const float* transform, unsigned int firstVertex, unsigned int vertexCount,
+		ClipVertexType* vertices);
+	void SetupChunk(ChunkType&, const void* indices, bool wideIndices, unsigned int triangleCount, unsigned int firstVertex,
+		const ClipVertexType* vertices, unsigned int attributeCount, unsigned int draw);
+	bool SetupTriangle(const ClipVertexType&, const ClipVertexType&, const ClipVertexType&, unsigned int attributeCount, unsigned int draw,
+		OUT TriangleType&);
+	void BinChunk(ChunkType&);
+
+	unsigned long long RasterizeTile(unsigned int tile);
+	unsigned long long RasterizeTriangle(const TriangleType&, const DrawType&, const TextureType*, int tileX, int tileY);
+	unsigned int Sample(const TextureType&, float u, float v);
+
+	void ClearBindings();
+	void RunWorkers(size_t itemCount, const std::function<void(size_t)>& work);
+
+private:
+	int m_screenWidth, m_screenHeight;
+	unsigned int m_threadCount;
+
+	// The render target and its depth are padded to whole tiles, m_pitch pixels to a row.
+	int m_tilesX, m_tilesY, m_pitch;
+	std::vector<unsigned int> m_colorBuffer;
+	std::vector<float> m_depthBuffer;
+	unsigned int m_clearColor;
+
+	std::vector<BufferType> m_buffers;
+	std::vector<TextureType> m_textures;
+	std::vector<ShaderType> m_shaders;
+	std::vector<bool> m_queries;
+	std::vector<CommandListClass*> m_commandLists;
+	std::vector<unsigned int> m_freeBuffers, m_freeTextures, m_freeShaders, m_freeQueries, m_freeCommandLists;
+
+	// The state the next draw reads.
+	unsigned int m_vertexBuffers[RENDER_MAX_VERTEX_BUFFERS], m_vertexStrides[RENDER_MAX_VERTEX_BUFFERS], m_vertexOffsets[RENDER_MAX_VERTEX_BUFFERS];
+	unsigned int m_indexBuffer, m_indexOffset;
+	DXGI_FORMAT m_indexFormat;
+	unsigned int m_shader;
+	ConstantBindingType m_constantBuffers[RENDER_MAX_CONSTANT_BUFFERS];
+	unsigned int m_boundTextures[RENDER_MAX_TEXTURES];
+
+	// The draws of the frame and the chunks their triangles were binned into, the first m_chunkCount are in use. The transformed
+	// vertices are only kept while a draw is set up.
+	std::vector<DrawType> m_draws;
+	std::vector<ChunkType> m_chunks;
+	unsigned int m_chunkCount;
+	std::vector<ClipVertexType> m_clipVertices;
+	std::vector<const TextureType*> m_drawTextures;
+
+	FrameStatsType m_frameStats, m_lastFrameStats;
+};
+
+#endif
@@ -0,0 +1,561 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: statefilterrenderdeviceclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "statefilterrenderdeviceclass.h"
+#include <cstring>
+
+
+StateFilterRenderDeviceClass::StateFilterRenderDeviceClass()
+{
+	m_device = 0;
+	Invalidate();
+	memset(&m_filterStats, 0, sizeof(m_filterStats));
+}
+
+
+StateFilterRenderDeviceClass::StateFilterRenderDeviceClass(const StateFilterRenderDeviceClass& other)
+{
+}
+
+
+StateFilterRenderDeviceClass::~StateFilterRenderDeviceClass()
+{
+}
+
+// Initialize puts the filter in front of a device the caller made and keeps owning. Nothing is known to be bound on it yet.
+bool StateFilterRenderDeviceClass::Initialize(RenderDeviceClass* device)
+{
+	if (!device)
+	{
+		return false;
+	}
+
+	m_device = device;
+	Invalidate();
+	memset(&m_filterStats, 0, sizeof(m_filterStats));
+
+	return true;
+}
+
+// Shutdown only lets go of the device, shutting it down is left to its owner. The filters of command lists that are still alive go
+// with it.
+void StateFilterRenderDeviceClass::Shutdown()
+{
+	size_t i;
+
+
+	for (i = 0; i < m_listFilters.size(); i++)
+	{
+		m_listFilters[i].filter->Shutdown();
+		delete m_listFilters[i].filter;
+	}
+	m_listFilters.clear();
+
+	m_device = 0;
+	Invalidate();
+
+	return;
+}
+
+// Invalidate forgets everything that was bound, so the next bind of every slot is passed on.
+void StateFilterRenderDeviceClass::Invalidate()
+{
+	memset(m_vertexBuffers, 0, sizeof(m_vertexBuffers));
+	memset(&m_indexBuffer, 0, sizeof(m_indexBuffer));
+	memset(&m_shader, 0, sizeof(m_shader));
+	memset(m_constantBuffers, 0, sizeof(m_constantBuffers));
+	memset(m_textures, 0, sizeof(m_textures));
+
+	return;
+}
+
+
+RenderDeviceClass::CapsType StateFilterRenderDeviceClass::GetCaps()
+{
+	return m_device->GetCaps();
+}
+
+
+bool StateFilterRenderDeviceClass::CreateBuffer(const BufferDescType& desc, const void* initialData, OUT unsigned int& buffer)
+{
+	return m_device->CreateBuffer(desc, initialData, buffer);
+}
+
+
+void StateFilterRenderDeviceClass::UpdateBuffer(unsigned int buffer, unsigned int offset, const void* data, unsigned int size)
+{
+	m_device->UpdateBuffer(buffer, offset, data, size);
+
+	return;
+}
+
+
+void StateFilterRenderDeviceClass::CopyBuffer(unsigned int destination, unsigned int destinationOffset, unsigned int source,
+	unsigned int sourceOffset, unsigned int size)
+{
+	m_device->CopyBuffer(destination, destinationOffset, source, sourceOffset, size);
+
+	return;
+}
+
+// Mapping a bound buffer, even with a discard, leaves it bound, so maps do not touch the filter's state.
+bool StateFilterRenderDeviceClass::MapBuffer(unsigned int buffer, RenderMapType mapType, unsigned int offset, unsigned int size,
+	OUT void*& data)
+{
+	return m_device->MapBuffer(buffer, mapType, offset, size, data);
+}
+
+
+void StateFilterRenderDeviceClass::UnmapBuffer(unsigned int buffer)
+{
+	m_device->UnmapBuffer(buffer);
+
+	return;
+}
+
+// ReleaseBuffer forgets every slot the buffer is in, the next buffer to get its handle may be bound in the same slot.
+void StateFilterRenderDeviceClass::ReleaseBuffer(unsigned int buffer)
+{
+	unsigned int stage, slot;
+
+
+	for (slot = 0; slot < RENDER_MAX_VERTEX_BUFFERS; slot++)
+	{
+		if (m_vertexBuffers[slot].buffer == buffer)
+		{
+			m_vertexBuffers[slot].known = false;
+		}
+	}
+	if (m_indexBuffer.buffer == buffer)
+	{
+		m_indexBuffer.known = false;
+	}
+	for (stage = 0; stage < 2; stage++)
+	{
+		for (slot = 0; slot < RENDER_MAX_CONSTANT_BUFFERS; slot++)
+		{
+			if (m_constantBuffers[stage][slot].buffer == buffer)
+			{
+				m_constantBuffers[stage][slot].known = false;
+			}
+		}
+	}
+
+	m_device->ReleaseBuffer(buffer);
+
+	return;
+}
+
+
+bool StateFilterRenderDeviceClass::CreateTexture(const wchar_t* filename, OUT unsigned int& texture)
+{
+	return m_device->CreateTexture(filename, texture);
+}
+
+
+bool StateFilterRenderDeviceClass::CreateTexture(const unsigned char* data, size_t size, OUT unsigned int& texture)
+{
+	return m_device->CreateTexture(data, size, texture);
+}
+
+
+void StateFilterRenderDeviceClass::ReleaseTexture(unsigned int texture)
+{
+	unsigned int slot;
+
+
+	for (slot = 0; slot < RENDER_MAX_TEXTURES; slot++)
+	{
+		if (m_textures[slot].handle == texture)
+		{
+			m_textures[slot].known = false;
+		}
+	}
+
+	m_device->ReleaseTexture(texture);
+
+	return;
+}
+
+
+bool StateFilterRenderDeviceClass::CreateShader(const ShaderDescType& desc, OUT unsigned int& shader)
+{
+	return m_device->CreateShader(desc, shader);
+}
+
+
+void StateFilterRenderDeviceClass::ReleaseShader(unsigned int shader)
+{
+	if (m_shader.handle == shader)
+	{
+		m_shader.known = false;
+	}
+
+	m_device->ReleaseShader(shader);
+
+	return;
+}
+
+
+bool StateFilterRenderDeviceClass::CreateQuery(OUT unsigned int& query)
+{
+	return m_device->CreateQuery(query);
+}
+
+
+void StateFilterRenderDeviceClass::EndQuery(unsigned int query)
+{
+	m_device->EndQuery(query);
+
+	return;
+}
+
+
+bool StateFilterRenderDeviceClass::IsQueryDone(unsigned int query, bool flush)
+{
+	return m_device->IsQueryDone(query, flush);
+}
+
+
+void StateFilterRenderDeviceClass::ReleaseQuery(unsigned int query)
+{
+	m_device->ReleaseQuery(query);
+
+	return;
+}
+
+// The bound state lasts from one frame to the next on every device, so beginning and ending a scene keeps it.
+void StateFilterRenderDeviceClass::BeginScene(float red, float green, float blue, float alpha)
+{
+	m_device->BeginScene(red, green, blue, alpha);
+
+	return;
+}
+
+
+void StateFilterRenderDeviceClass::EndScene()
+{
+	m_device->EndScene();
+
+	return;
+}
+
+// SetVertexBuffers passes on the run of slots from the first to the last one that changes. Slots past the last one the device
+// has are passed on as they are, for the device to report.
+void StateFilterRenderDeviceClass::SetVertexBuffers(unsigned int startSlot, unsigned int count, const unsigned int* buffers,
+	const unsigned int* strides, const unsigned int* offsets)
+{
+	VertexBufferBindingType* binding;
+	unsigned int i, first, last;
+	bool changed;
+
+
+	if (startSlot >= RENDER_MAX_VERTEX_BUFFERS || count > RENDER_MAX_VERTEX_BUFFERS - startSlot)
+	{
+		m_filterStats.issuedCounts[RENDER_STATE_VERTEX_BUFFERS]++;
+		m_device->SetVertexBuffers(startSlot, count, buffers, strides, offsets);
+		return;
+	}
+
+	first = 0;
+	last = 0;
+	changed = false;
+	for (i = 0; i < count; i++)
+	{
+		binding = &m_vertexBuffers[startSlot + i];
+		if (!binding->known || binding->buffer != buffers[i] || binding->stride != strides[i] || binding->offset != offsets[i])
+		{
+			if (!changed)
+			{
+				first = i;
+				changed = true;
+			}
+			last = i;
+
+			binding->known = true;
+			binding->buffer = buffers[i];
+			binding->stride = strides[i];
+			binding->offset = offsets[i];
+		}
+	}
+
+	if (!changed)
+	{
+		m_filterStats.filteredCounts[RENDER_STATE_VERTEX_BUFFERS]++;
+		return;
+	}
+
+	m_filterStats.issuedCounts[RENDER_STATE_VERTEX_BUFFERS]++;
+	m_device->SetVertexBuffers(startSlot + first, last - first + 1, buffers + first, strides + first, offsets + first);
+
+	return;
+}
+
+
+void StateFilterRenderDeviceClass::SetIndexBuffer(unsigned int buffer, DXGI_FORMAT format, unsigned int offset)
+{
+	if (m_indexBuffer.known && m_indexBuffer.buffer == buffer && m_indexBuffer.format == format && m_indexBuffer.offset == offset)
+	{
+		m_filterStats.filteredCounts[RENDER_STATE_INDEX_BUFFER]++;
+		return;
+	}
+
+	m_indexBuffer.known = true;
+	m_indexBuffer.buffer = buffer;
+	m_indexBuffer.format = format;
+	m_indexBuffer.offset = offset;
+
+	m_filterStats.issuedCounts[RENDER_STATE_INDEX_BUFFER]++;
+	m_device->SetIndexBuffer(buffer, format, offset);
+
+	return;
+}
+
+
+void StateFilterRenderDeviceClass::SetShader(unsigned int shader)
+{
+	if (m_shader.known && m_shader.handle == shader)
+	{
+		m_filterStats.filteredCounts[RENDER_STATE_SHADER]++;
+		return;
+	}
+
+	m_shader.known = true;
+	m_shader.handle = shader;
+
+	m_filterStats.issuedCounts[RENDER_STATE_SHADER]++;
+	m_device->SetShader(shader);
+
+	return;
+}
+
+// Binding the same buffer at another offset is a change, so the slices of a constant ring are each passed on.
+void StateFilterRenderDeviceClass::SetConstantBuffer(RenderShaderStageType stage, unsigned int slot, unsigned int buffer,
+	unsigned int firstConstant, unsigned int constantCount)
+{
+	ConstantBindingType* binding;
+
+
+	if ((stage != RENDER_STAGE_VERTEX && stage != RENDER_STAGE_PIXEL) || slot >= RENDER_MAX_CONSTANT_BUFFERS)
+	{
+		m_filterStats.issuedCounts[RENDER_STATE_CONSTANT_BUFFER]++;
+		m_device->SetConstantBuffer(stage, slot, buffer, firstConstant, constantCount);
+		return;
+	}
+
+	binding = &m_constantBuffers[stage][slot];
+	if (binding->known && binding->buffer == buffer && binding->firstConstant == firstConstant && binding->constantCount == constantCount)
+	{
+		m_filterStats.filteredCounts[RENDER_STATE_CONSTANT_BUFFER]++;
+		return;
+	}
+
+	binding->known = true;
+	binding->buffer = buffer;
+	binding->firstConstant = firstConstant;
+	binding->constantCount = constantCount;
+
+	m_filterStats.issuedCounts[RENDER_STATE_CONSTANT_BUFFER]++;
+	m_device->SetConstantBuffer(stage, slot, buffer, firstConstant, constantCount);
+
+	return;
+}
+
+
+void StateFilterRenderDeviceClass::SetTexture(unsigned int slot, unsigned int texture)
+{
+	if (slot >= RENDER_MAX_TEXTURES)
+	{
+		m_filterStats.issuedCounts[RENDER_STATE_TEXTURE]++;
+		m_device->SetTexture(slot, texture);
+		return;
+	}
+
+	if (m_textures[slot].known && m_textures[slot].handle == texture)
+	{
+		m_filterStats.filteredCounts[RENDER_STATE_TEXTURE]++;
+		return;
+	}
+
+	m_textures[slot].known = true;
+	m_textures[slot].handle = texture;
+
+	m_filterStats.issuedCounts[RENDER_STATE_TEXTURE]++;
+	m_device->SetTexture(slot, texture);
+
+	return;
+}
+
+
+void StateFilterRenderDeviceClass::DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex)
+{
+	m_device->DrawIndexed(indexCount, startIndex, baseVertex);
+
+	return;
+}
+
+
+void StateFilterRenderDeviceClass::DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int startIndex,
+	int baseVertex, unsigned int startInstance)
+{
+	m_device->DrawIndexedInstanced(indexCount, instanceCount, startIndex, baseVertex, startInstance);
+
+	return;
+}
+
+// CreateCommandList makes the list's filter here, on the main thread, so recording threads only ever look it up.
+bool StateFilterRenderDeviceClass::CreateCommandList(OUT unsigned int& commandList)
+{
+	CommandListFilterType listFilter;
+	bool result;
+
+
+	result = m_device->CreateCommandList(commandList);
+	if (!result)
+	{
+		return false;
+	}
+
+	listFilter.commandList = commandList;
+	listFilter.filter = new StateFilterRenderDeviceClass;
+	if (!listFilter.filter)
+	{
+		m_device->ReleaseCommandList(commandList);
+		commandList = RENDER_HANDLE_NONE;
+		return false;
+	}
+	m_listFilters.push_back(listFilter);
+
+	return true;
+}
+
+// BeginCommandList puts the list's filter in front of the device that records it. What it knew from the last recording is forgotten.
+bool StateFilterRenderDeviceClass::BeginCommandList(unsigned int commandList, OUT RenderDeviceClass*& recorder)
+{
+	StateFilterRenderDeviceClass* filter;
+	RenderDeviceClass* listRecorder;
+	FilterStatsType filterStats;
+	bool result;
+
+
+	recorder = 0;
+	filter = FindListFilter(commandList);
+	if (!filter)
+	{
+		return false;
+	}
+
+	result = m_device->BeginCommandList(commandList, listRecorder);
+	if (!result)
+	{
+		return false;
+	}
+
+	// Initialize starts the counts over too, but they are only reset with the filter's own.
+	filterStats = filter->m_filterStats;
+	filter->Initialize(listRecorder);
+	filter->m_filterStats = filterStats;
+	recorder = filter;
+
+	return true;
+}
+
+
+void StateFilterRenderDeviceClass::EndCommandList(unsigned int commandList)
+{
+	m_device->EndCommandList(commandList);
+
+	return;
+}
+
+// Executing a list leaves nothing bound on the device, so the filter forgets everything.
+void StateFilterRenderDeviceClass::ExecuteCommandList(unsigned int commandList)
+{
+	m_device->ExecuteCommandList(commandList);
+	Invalidate();
+
+	return;
+}
+
+
+void StateFilterRenderDeviceClass::ReleaseCommandList(unsigned int commandList)
+{
+	size_t i;
+
+
+	for (i = 0; i < m_listFilters.size(); i++)
+	{
+		if (m_listFilters[i].commandList == commandList)
+		{
+			m_listFilters[i].filter->Shutdown();
+			delete m_listFilters[i].filter;
+			m_listFilters.erase(m_listFilters.begin() + i);
+			break;
+		}
+	}
+
+	m_device->ReleaseCommandList(commandList);
+
+	return;
+}
+
+// The calls, bytes and resources are those of the device behind the filter, which only sees the binds that were passed on.
+RenderDeviceClass::StatsType StateFilterRenderDeviceClass::GetStats()
+{
+	return m_device->GetStats();
+}
+
+// ResetStats starts both the device's counts and the filter's own over.
+void StateFilterRenderDeviceClass::ResetStats()
+{
+	size_t i;
+
+
+	m_device->ResetStats();
+	memset(&m_filterStats, 0, sizeof(m_filterStats));
+	for (i = 0; i < m_listFilters.size(); i++)
+	{
+		memset(&m_listFilters[i].filter->m_filterStats, 0, sizeof(m_filterStats));
+	}
+
+	return;
+}
+
+
+// GetFilterStats adds the binds made to the filters of the command lists to the filter's own.
+StateFilterRenderDeviceClass::FilterStatsType StateFilterRenderDeviceClass::GetFilterStats()
+{
+	FilterStatsType filterStats;
+	size_t i;
+	int state;
+
+
+	filterStats = m_filterStats;
+	for (i = 0; i < m_listFilters.size(); i++)
+	{
+		for (state = 0; state < RENDER_STATE_COUNT; state++)
+		{
+			filterStats.issuedCounts[state] += m_listFilters[i].filter->m_filterStats.issuedCounts[state];
+			filterStats.filteredCounts[state] += m_listFilters[i].filter->m_filterStats.filteredCounts[state];
+		}
+	}
+
+	return filterStats;
+}
+
+// FindListFilter only reads the table of filters, so it is safe on every recording thread.
+StateFilterRenderDeviceClass* StateFilterRenderDeviceClass::FindListFilter(unsigned int commandList)
+{
+	size_t i;
+
+
+	for (i = 0; i < m_listFilters.size(); i++)
+	{
+		if (m_listFilters[i].commandList == commandList)
+		{
+			return m_listFilters[i].filter;
+		}
+	}
+
+	return 0;
+}
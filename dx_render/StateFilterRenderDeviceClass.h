@@ -0,0 +1,156 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: statefilterrenderdeviceclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _STATEFILTERRENDERDEVICECLASS_H_
+#define _STATEFILTERRENDERDEVICECLASS_H_
+
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "renderdeviceclass.h"
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <vector>
+
+
+//////////////
+// TYPEDEFS //
+//////////////
+// The kinds of state the filter keeps track of, one for each call that binds state.
+enum RenderStateType
+{
+	RENDER_STATE_VERTEX_BUFFERS,
+	RENDER_STATE_INDEX_BUFFER,
+	RENDER_STATE_SHADER,
+	RENDER_STATE_CONSTANT_BUFFER,
+	RENDER_STATE_TEXTURE,
+	RENDER_STATE_COUNT
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: StateFilterRenderDeviceClass
+////////////////////////////////////////////////////////////////////////////////
+// The StateFilterRenderDeviceClass sits in front of another render device and passes every call on to it, apart from binds that
+// would leave the state a draw reads as it is. It keeps a copy of what it last bound in every slot. A SetVertexBuffers is trimmed to
+// the slots that change. State is unknown until it is first bound, and a slot is forgotten when the resource in it is released, so
+// a handle that is given out again is bound again. Anything that binds on the device behind the filter has to call Invalidate.
+// Every command list gets a filter of its own in front of the device that records it, which starts out knowing nothing like the list.
+class StateFilterRenderDeviceClass : public RenderDeviceClass
+{
+public:
+	// The bind calls made to the filter since the last ResetStats, by the state they set, split into the ones passed on and the ones
+	// dropped.
+	struct FilterStatsType
+	{
+		unsigned int issuedCounts[RENDER_STATE_COUNT];
+		unsigned int filteredCounts[RENDER_STATE_COUNT];
+	};
+
+private:
+	struct VertexBufferBindingType
+	{
+		bool known;
+		unsigned int buffer, stride, offset;
+	};
+
+	struct IndexBufferBindingType
+	{
+		bool known;
+		unsigned int buffer, offset;
+		DXGI_FORMAT format;
+	};
+
+	struct ConstantBindingType
+	{
+		bool known;
+		unsigned int buffer;
+		unsigned int firstConstant, constantCount;
+	};
+
+	struct HandleBindingType
+	{
+		bool known;
+		unsigned int handle;
+	};
+
+	struct CommandListFilterType
+	{
+		unsigned int commandList;
+		StateFilterRenderDeviceClass* filter;
+	};
+
+public:
+	StateFilterRenderDeviceClass();
+	StateFilterRenderDeviceClass(const StateFilterRenderDeviceClass&);
+	~StateFilterRenderDeviceClass();
+
+	bool Initialize(RenderDeviceClass* device);
+	void Shutdown();
+	void Invalidate();
+	CapsType GetCaps();
+
+	bool CreateBuffer(const BufferDescType&, const void* initialData, OUT unsigned int& buffer);
+	void UpdateBuffer(unsigned int buffer, unsigned int offset, const void* data, unsigned int size);
+	void CopyBuffer(unsigned int destination, unsigned int destinationOffset, unsigned int source, unsigned int sourceOffset, unsigned int size);
+	bool MapBuffer(unsigned int buffer, RenderMapType, unsigned int offset, unsigned int size, OUT void*& data);
+	void UnmapBuffer(unsigned int buffer);
+	void ReleaseBuffer(unsigned int buffer);
+
+	bool CreateTexture(const wchar_t* filename, OUT unsigned int& texture);
+	bool CreateTexture(const unsigned char* data, size_t size, OUT unsigned int& texture);
+	void ReleaseTexture(unsigned int texture);
+
+	bool CreateShader(const ShaderDescType&, OUT unsigned int& shader);
+	void ReleaseShader(unsigned int shader);
+
+	bool CreateQuery(OUT unsigned int& query);
+	void EndQuery(unsigned int query);
+	bool IsQueryDone(unsigned int query, bool flush);
+	void ReleaseQuery(unsigned int query);
+
+	void BeginScene(float red, float green, float blue, float alpha);
+	void EndScene();
+
+	void SetVertexBuffers(unsigned int startSlot, unsigned int count, const unsigned int* buffers, const unsigned int* strides,
+		const unsigned int* offsets);
+	void SetIndexBuffer(unsigned int buffer, DXGI_FORMAT format, unsigned int offset);
+	void SetShader(unsigned int shader);
+	void SetConstantBuffer(RenderShaderStageType, unsigned int slot, unsigned int buffer, unsigned int firstConstant, unsigned int constantCount);
+	void SetTexture(unsigned int slot, unsigned int texture);
+	void DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex);
+	void DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int startIndex, int baseVertex,
+		unsigned int startInstance);
+
+	bool CreateCommandList(OUT unsigned int& commandList);
+	bool BeginCommandList(unsigned int commandList, OUT RenderDeviceClass*& recorder);
+	void EndCommandList(unsigned int commandList);
+	void ExecuteCommandList(unsigned int commandList);
+	void ReleaseCommandList(unsigned int commandList);
+
+	StatsType GetStats();
+	void ResetStats();
+	FilterStatsType GetFilterStats();
+
+private:
+	StateFilterRenderDeviceClass* FindListFilter(unsigned int commandList);
+
+private:
+	RenderDeviceClass* m_device;
+
+	// The state last passed on to m_device.
+	VertexBufferBindingType m_vertexBuffers[RENDER_MAX_VERTEX_BUFFERS];
+	IndexBufferBindingType m_indexBuffer;
+	HandleBindingType m_shader;
+	ConstantBindingType m_constantBuffers[2][RENDER_MAX_CONSTANT_BUFFERS];
+	HandleBindingType m_textures[RENDER_MAX_TEXTURES];
+
+	FilterStatsType m_filterStats;
+	std::vector<CommandListFilterType> m_listFilters;
+};
+
+#endif
@@ -0,0 +1,587 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: staticbatchclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "staticbatchclass.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+
+/////////////
+// GLOBALS //
+/////////////
+// The most vertices one window of 16 bit indices can address.
+static const unsigned int STATIC_BATCH_WINDOW_VERTICES = 65536;
+// Cell coordinates are kept to 21 bits each so the three of them interleave into one 64 bit key.
+static const int STATIC_BATCH_CELL_BITS = 21;
+
+
+StaticBatchClass::StaticBatchClass()
+{
+	m_cellSize = 16.0f;
+	m_sourceCount = 0;
+	m_shortIndices = true;
+	memset(&m_stats, 0, sizeof(m_stats));
+	m_device = 0;
+	m_vertexBuffer = RENDER_HANDLE_NONE;
+	m_indexBuffer = RENDER_HANDLE_NONE;
+	m_vertexStride = sizeof(VertexType);
+	m_indexFormat = DXGI_FORMAT_R16_UINT;
+	XMStoreFloat4x4(&m_positionDecode, XMMatrixIdentity());
+	m_geometryPool = 0;
+	m_poolHandle = GEOMETRY_POOL_HANDLE_NONE;
+}
+
+
+StaticBatchClass::StaticBatchClass(const StaticBatchClass& other)
+{
+}
+
+
+StaticBatchClass::~StaticBatchClass()
+{
+}
+
+// SetCellSize sets the edge length, in world units, of the grid cells the meshes are batched by. Smaller cells cull closer to the
+// meshes but leave more batches to draw when they are all on screen.
+void StaticBatchClass::SetCellSize(float cellSize)
+{
+	m_cellSize = cellSize > 0.0f ? cellSize : 1.0f;
+
+	return;
+}
+
+// AddMesh transforms a mesh into world space and keeps one piece for each of its submeshes, with just the vertices that submesh uses.
+// Normals are transformed with the inverse transpose, and a mirroring matrix gets its triangles turned around so they keep facing out.
+// The materials of the submeshes are used as they are, every mesh added has to number them the same way. It returns the source
+// number GetSourceRanges finds the mesh by.
+unsigned int StaticBatchClass::AddMesh(const VertexType* verts, const uint32_t* indices, const MeshSubmeshType* submeshes, unsigned int submeshCount,
+	XMMATRIX worldMatrix)
+{
+	PieceType piece;
+	XMMATRIX normalMatrix;
+	XMVECTOR position, normal, boundsMin, boundsMax;
+	XMFLOAT3 center;
+	VertexType vertex;
+	unsigned int submesh, i, end, index, maxIndex;
+	bool mirrored;
+
+
+	normalMatrix = XMMatrixTranspose(XMMatrixInverse(0, worldMatrix));
+	mirrored = XMVectorGetX(XMMatrixDeterminant(worldMatrix)) < 0.0f;
+
+	for (submesh = 0; submesh < submeshCount; submesh++)
+	{
+		if (submeshes[submesh].indexCount < 3)
+		{
+			continue;
+		}
+
+		piece.source = m_sourceCount;
+		piece.material = submeshes[submesh].material;
+		piece.firstVertex = (unsigned int)m_pieceVertices.size();
+		piece.firstIndex = (unsigned int)m_pieceIndices.size();
+
+		end = submeshes[submesh].startIndex + submeshes[submesh].indexCount / 3 * 3;
+		maxIndex = 0;
+		for (i = submeshes[submesh].startIndex; i < end; i++)
+		{
+			if (indices[i] > maxIndex)
+			{
+				maxIndex = indices[i];
+			}
+		}
+		if (m_vertexRemap.size() <= maxIndex)
+		{
+			m_vertexRemap.resize(maxIndex + 1, MESH_INDEX_NONE);
+		}
+
+		// Number the vertices in the order the triangles first use them, which keeps the vertex cache order the mesh came with.
+		boundsMin = XMVectorReplicate(FLT_MAX);
+		boundsMax = XMVectorReplicate(-FLT_MAX);
+		for (i = submeshes[submesh].startIndex; i < end; i++)
+		{
+			index = indices[i];
+			if (m_vertexRemap[index] == MESH_INDEX_NONE)
+			{
+				m_vertexRemap[index] = (uint32_t)(m_pieceVertices.size() - piece.firstVertex);
+
+				position = XMVector3TransformCoord(XMLoadFloat3(&verts[index].position), worldMatrix);
+				normal = XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&verts[index].normal), normalMatrix));
+				XMStoreFloat3(&vertex.position, position);
+				vertex.texture = verts[index].texture;
+				XMStoreFloat3(&vertex.normal, normal);
+				m_pieceVertices.push_back(vertex);
+
+				boundsMin = XMVectorMin(boundsMin, position);
+				boundsMax = XMVectorMax(boundsMax, position);
+			}
+		}
+
+		for (i = submeshes[submesh].startIndex; i < end; i += 3)
+		{
+			m_pieceIndices.push_back(m_vertexRemap[indices[i]]);
+			m_pieceIndices.push_back(m_vertexRemap[indices[i + (mirrored ? 2 : 1)]]);
+			m_pieceIndices.push_back(m_vertexRemap[indices[i + (mirrored ? 1 : 2)]]);
+		}
+
+		// Reset only the entries this submesh set, the next one starts from a clean table.
+		for (i = submeshes[submesh].startIndex; i < end; i++)
+		{
+			m_vertexRemap[indices[i]] = MESH_INDEX_NONE;
+		}
+
+		piece.vertexCount = (unsigned int)m_pieceVertices.size() - piece.firstVertex;
+		piece.indexCount = (unsigned int)m_pieceIndices.size() - piece.firstIndex;
+		XMStoreFloat3(&center, XMVectorScale(XMVectorAdd(boundsMin, boundsMax), 0.5f));
+		piece.cell = GetCellKey(center);
+		m_pieces.push_back(piece);
+	}
+
+	return m_sourceCount++;
+}
+
+// Build lays the pieces out by material and cell and makes a batch of every run of one material in one cell. A batch also ends where
+// a window of 16 bit indices is full, a window only ever ends between pieces. The pieces are released afterwards.
+void StaticBatchClass::Build()
+{
+	std::vector<unsigned int> order, sourceCounts;
+	std::vector<IndexRangeType> pieceRanges;
+	std::vector<uint64_t> cells;
+	MeshletType batch;
+	IndexRangeType range;
+	XMVECTOR boundsMin, boundsMax, position;
+	unsigned int windowBase, windowVertices, i, j;
+	uint64_t batchCell;
+
+
+	m_vertices.clear();
+	m_indices.clear();
+	m_batches.clear();
+	memset(&m_stats, 0, sizeof(m_stats));
+
+	order.resize(m_pieces.size());
+	for (i = 0; i < order.size(); i++)
+	{
+		order[i] = i;
+	}
+	std::sort(order.begin(), order.end(), [this](unsigned int a, unsigned int b)
+		{
+			if (m_pieces[a].material != m_pieces[b].material)
+			{
+				return m_pieces[a].material < m_pieces[b].material;
+			}
+			if (m_pieces[a].cell != m_pieces[b].cell)
+			{
+				return m_pieces[a].cell < m_pieces[b].cell;
+			}
+			return a < b;
+		});
+
+	// One piece too big for a window turns the windows off, the whole batch is then drawn with 32 bit indices.
+	m_shortIndices = true;
+	for (i = 0; i < m_pieces.size(); i++)
+	{
+		if (m_pieces[i].vertexCount > STATIC_BATCH_WINDOW_VERTICES)
+		{
+			m_shortIndices = false;
+		}
+	}
+
+	m_vertices.reserve(m_pieceVertices.size());
+	m_indices.reserve(m_pieceIndices.size());
+	pieceRanges.resize(m_pieces.size());
+
+	memset(&batch, 0, sizeof(batch));
+	batch.coneCutoff = 1.0f;
+	batchCell = 0;
+	boundsMin = XMVectorZero();
+	boundsMax = XMVectorZero();
+	windowBase = 0;
+	windowVertices = 0;
+	m_stats.windowCount = m_pieces.empty() ? 0 : 1;
+	for (i = 0; i < order.size(); i++)
+	{
+		const PieceType& piece = m_pieces[order[i]];
+
+		if (m_shortIndices && windowVertices + piece.vertexCount > STATIC_BATCH_WINDOW_VERTICES)
+		{
+			windowBase = (unsigned int)m_vertices.size();
+			windowVertices = 0;
+			m_stats.windowCount++;
+		}
+
+		if (batch.range.indexCount == 0 || batch.range.material != piece.material || batchCell != piece.cell ||
+			batch.range.baseVertex != (int)windowBase)
+		{
+			if (batch.range.indexCount > 0)
+			{
+				XMStoreFloat3(&batch.boundsMin, boundsMin);
+				XMStoreFloat3(&batch.boundsMax, boundsMax);
+				m_batches.push_back(batch);
+			}
+
+			batch.range.startIndex = (unsigned int)m_indices.size();
+			batch.range.indexCount = 0;
+			batch.range.baseVertex = (int)windowBase;
+			batch.range.material = piece.material;
+			batchCell = piece.cell;
+			boundsMin = XMVectorReplicate(FLT_MAX);
+			boundsMax = XMVectorReplicate(-FLT_MAX);
+		}
+
+		range.startIndex = (unsigned int)m_indices.size();
+		range.indexCount = piece.indexCount;
+		range.baseVertex = (int)windowBase;
+		range.material = piece.material;
+		pieceRanges[order[i]] = range;
+
+		for (j = 0; j < piece.vertexCount; j++)
+		{
+			position = XMLoadFloat3(&m_pieceVertices[piece.firstVertex + j].position);
+			boundsMin = XMVectorMin(boundsMin, position);
+			boundsMax = XMVectorMax(boundsMax, position);
+		}
+		m_vertices.insert(m_vertices.end(), m_pieceVertices.begin() + piece.firstVertex, m_pieceVertices.begin() + piece.firstVertex + piece.vertexCount);
+		for (j = 0; j < piece.indexCount; j++)
+		{
+			m_indices.push_back(m_pieceIndices[piece.firstIndex + j] + windowVertices);
+		}
+
+		batch.range.indexCount += piece.indexCount;
+		windowVertices += piece.vertexCount;
+	}
+
+	if (batch.range.indexCount > 0)
+	{
+		XMStoreFloat3(&batch.boundsMin, boundsMin);
+		XMStoreFloat3(&batch.boundsMax, boundsMax);
+		m_batches.push_back(batch);
+	}
+
+	// The culling sphere of a batch is the one around its bounding box.
+	for (i = 0; i < m_batches.size(); i++)
+	{
+		boundsMin = XMLoadFloat3(&m_batches[i].boundsMin);
+		boundsMax = XMLoadFloat3(&m_batches[i].boundsMax);
+		XMStoreFloat3(&m_batches[i].center, XMVectorScale(XMVectorAdd(boundsMin, boundsMax), 0.5f));
+		m_batches[i].radius = 0.5f * XMVectorGetX(XMVector3Length(XMVectorSubtract(boundsMax, boundsMin)));
+	}
+
+	// Group the piece ranges by source.
+	sourceCounts.assign(m_sourceCount + 1, 0);
+	for (i = 0; i < m_pieces.size(); i++)
+	{
+		sourceCounts[m_pieces[i].source + 1]++;
+	}
+	for (i = 0; i < m_sourceCount; i++)
+	{
+		sourceCounts[i + 1] += sourceCounts[i];
+	}
+	m_sourceFirstRange = sourceCounts;
+	m_sourceRanges.resize(m_pieces.size());
+	for (i = 0; i < m_pieces.size(); i++)
+	{
+		m_sourceRanges[sourceCounts[m_pieces[i].source]++] = pieceRanges[i];
+	}
+
+	cells.resize(m_pieces.size());
+	for (i = 0; i < m_pieces.size(); i++)
+	{
+		cells[i] = m_pieces[i].cell;
+	}
+	std::sort(cells.begin(), cells.end());
+
+	m_stats.sourceCount = m_sourceCount;
+	m_stats.pieceCount = (unsigned int)m_pieces.size();
+	m_stats.cellCount = (unsigned int)(std::unique(cells.begin(), cells.end()) - cells.begin());
+	m_stats.batchCount = (unsigned int)m_batches.size();
+	m_stats.vertexCount = (unsigned int)m_vertices.size();
+	m_stats.indexCount = (unsigned int)m_indices.size();
+
+	std::vector<PieceType>().swap(m_pieces);
+	std::vector<VertexType>().swap(m_pieceVertices);
+	std::vector<uint32_t>().swap(m_pieceIndices);
+	std::vector<uint32_t>().swap(m_vertexRemap);
+
+	return;
+}
+
+// Initialize uploads what Build made in the given vertex format, into the geometry pool when it is not null and takes the format.
+// A compact format quantizes the positions to the bounds of the whole batch. The arrays Build made are released afterwards.
+bool StaticBatchClass::Initialize(RenderDeviceClass* device, VertexFormatType format, GeometryPoolClass* geometryPool)
+{
+	RenderDeviceClass::BufferDescType vertexBufferDesc, indexBufferDesc;
+	bool result;
+	MeshCompressionClass compression;
+	MeshCompressionClass::QuantizationType quantization;
+	std::vector<CompactVertexType> compactVerts;
+	std::vector<uint16_t> shortIndices;
+	const void* vertexSource;
+	const void* indexSource;
+	unsigned int indexStride;
+	size_t i;
+
+
+	if (m_vertices.empty() || m_indices.empty())
+	{
+		return false;
+	}
+
+	m_vertexStride = compression.GetVertexStride(format);
+	if (format != VERTEX_FORMAT_FULL)
+	{
+		compression.EncodeVertices(m_vertices.data(), (unsigned int)m_vertices.size(), format, compactVerts, quantization);
+		vertexSource = compactVerts.data();
+		XMStoreFloat4x4(&m_positionDecode, compression.GetDecodeMatrix(quantization));
+	}
+	else
+	{
+		vertexSource = m_vertices.data();
+		XMStoreFloat4x4(&m_positionDecode, XMMatrixIdentity());
+	}
+
+	// Window relative indices all fit 16 bits by construction.
+	if (m_shortIndices)
+	{
+		shortIndices.resize(m_indices.size());
+		for (i = 0; i < m_indices.size(); i++)
+		{
+			shortIndices[i] = (uint16_t)m_indices[i];
+		}
+		m_indexFormat = DXGI_FORMAT_R16_UINT;
+		indexSource = shortIndices.data();
+		indexStride = sizeof(uint16_t);
+	}
+	else
+	{
+		m_indexFormat = DXGI_FORMAT_R32_UINT;
+		indexSource = m_indices.data();
+		indexStride = sizeof(uint32_t);
+	}
+
+	// Until the first Cull every batch is drawn.
+	m_visibleRanges.clear();
+	for (i = 0; i < m_batches.size(); i++)
+	{
+		m_visibleRanges.push_back(m_batches[i].range);
+	}
+	m_visibleDepths.assign(m_visibleRanges.size(), 0.0f);
+
+	m_device = device;
+	m_geometryPool = geometryPool;
+	if (m_geometryPool && m_geometryPool->GetVertexStride() == m_vertexStride && m_geometryPool->GetIndexFormat() == m_indexFormat)
+	{
+		m_poolHandle = m_geometryPool->Allocate(device, vertexSource, (unsigned int)m_vertices.size(), indexSource, (unsigned int)m_indices.size());
+	}
+
+	if (m_poolHandle == GEOMETRY_POOL_HANDLE_NONE)
+	{
+		vertexBufferDesc.bind = RENDER_BIND_VERTEX_BUFFER;
+		vertexBufferDesc.usage = RENDER_USAGE_DEFAULT;
+		vertexBufferDesc.byteWidth = m_vertexStride * (unsigned int)m_vertices.size();
+
+		result = device->CreateBuffer(vertexBufferDesc, vertexSource, m_vertexBuffer);
+		if (!result)
+		{
+			return false;
+		}
+
+		indexBufferDesc.bind = RENDER_BIND_INDEX_BUFFER;
+		indexBufferDesc.usage = RENDER_USAGE_DEFAULT;
+		indexBufferDesc.byteWidth = indexStride * (unsigned int)m_indices.size();
+
+		result = device->CreateBuffer(indexBufferDesc, indexSource, m_indexBuffer);
+		if (!result)
+		{
+			return false;
+		}
+	}
+
+	std::vector<VertexType>().swap(m_vertices);
+	std::vector<uint32_t>().swap(m_indices);
+
+	return true;
+}
+
+
+void StaticBatchClass::Shutdown()
+{
+	if (m_poolHandle != GEOMETRY_POOL_HANDLE_NONE)
+	{
+		m_geometryPool->Free(m_poolHandle);
+		m_poolHandle = GEOMETRY_POOL_HANDLE_NONE;
+	}
+
+	if (m_indexBuffer)
+	{
+		m_device->ReleaseBuffer(m_indexBuffer);
+		m_indexBuffer = RENDER_HANDLE_NONE;
+	}
+
+	if (m_vertexBuffer)
+	{
+		m_device->ReleaseBuffer(m_vertexBuffer);
+		m_vertexBuffer = RENDER_HANDLE_NONE;
+	}
+
+	m_batches.clear();
+	m_sourceRanges.clear();
+	m_sourceFirstRange.clear();
+	m_visibleRanges.clear();
+	m_visibleDepths.clear();
+
+	return;
+}
+
+
+void StaticBatchClass::Render(RenderDeviceClass* device)
+{
+	unsigned int stride;
+	unsigned int offset;
+
+
+	if (m_poolHandle != GEOMETRY_POOL_HANDLE_NONE)
+	{
+		m_geometryPool->Render(device);
+		return;
+	}
+
+	stride = m_vertexStride;
+	offset = 0;
+	device->SetVertexBuffers(0, 1, &m_vertexBuffer, &stride, &offset);
+	device->SetIndexBuffer(m_indexBuffer, m_indexFormat, 0);
+
+	return;
+}
+
+// Cull rejects the batches outside the view frustum and merges the visible ones that follow each other into as few draws as possible.
+// The vertices are in world space already, so there is no world matrix.
+void StaticBatchClass::Cull(XMMATRIX viewMatrix, XMMATRIX projectionMatrix)
+{
+	m_culler.Cull(m_batches.data(), (unsigned int)m_batches.size(), XMMatrixIdentity(), viewMatrix, projectionMatrix, m_visibleRanges,
+		m_visibleDepths);
+
+	return;
+}
+
+
+int StaticBatchClass::GetVisibleRangeCount()
+{
+	return (int)m_visibleRanges.size();
+}
+
+
+IndexRangeType StaticBatchClass::GetVisibleRange(int index)
+{
+	IndexRangeType range;
+
+
+	range = m_visibleRanges[index];
+	if (m_poolHandle != GEOMETRY_POOL_HANDLE_NONE)
+	{
+		range.startIndex += m_geometryPool->GetStartIndex(m_poolHandle);
+		range.baseVertex += m_geometryPool->GetBaseVertex(m_poolHandle);
+	}
+
+	return range;
+}
+
+// GetVisibleRangeDepth returns how far in front of the camera the nearest batch of a visible range may be, zero before the first Cull.
+float StaticBatchClass::GetVisibleRangeDepth(int index)
+{
+	return m_visibleDepths[index];
+}
+
+
+MeshletClass::CullStatsType StaticBatchClass::GetCullStats()
+{
+	return m_culler.GetStats();
+}
+
+// GetPositionDecodeMatrix returns the matrix that takes compact positions back to world space, it is the world matrix to draw with.
+void StaticBatchClass::GetPositionDecodeMatrix(OUT XMMATRIX& decodeMatrix)
+{
+	decodeMatrix = XMLoadFloat4x4(&m_positionDecode);
+
+	return;
+}
+
+// GetVertices and GetIndices return what Build made until Initialize uploads it. The indices are relative to the base vertex of
+// the batch they are in.
+const VertexType* StaticBatchClass::GetVertices()
+{
+	return m_vertices.data();
+}
+
+
+const uint32_t* StaticBatchClass::GetIndices()
+{
+	return m_indices.data();
+}
+
+
+DXGI_FORMAT StaticBatchClass::GetIndexFormat()
+{
+	return m_shortIndices ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+}
+
+
+unsigned int StaticBatchClass::GetBatchCount()
+{
+	return (unsigned int)m_batches.size();
+}
+
+
+const MeshletType& StaticBatchClass::GetBatch(unsigned int index)
+{
+	return m_batches[index];
+}
+
+// GetSourceRanges returns where the pieces of a mesh AddMesh took ended up, one range for each of its submeshes. Like the batch
+// ranges they do not have the geometry pool offsets added.
+void StaticBatchClass::GetSourceRanges(unsigned int source, OUT std::vector<IndexRangeType>& out_ranges)
+{
+	out_ranges.clear();
+	if (source + 1 >= m_sourceFirstRange.size())
+	{
+		return;
+	}
+
+	out_ranges.assign(m_sourceRanges.begin() + m_sourceFirstRange[source], m_sourceRanges.begin() + m_sourceFirstRange[source + 1]);
+
+	return;
+}
+
+
+StaticBatchClass::BuildStatsType StaticBatchClass::GetBuildStats()
+{
+	return m_stats;
+}
+
+// GetCellKey interleaves the bits of the grid cell coordinates of a point, so sorting by the key walks the cells along a Morton curve.
+uint64_t StaticBatchClass::GetCellKey(const XMFLOAT3& center)
+{
+	const float* coordinates = &center.x;
+	const float half = (float)(1 << (STATIC_BATCH_CELL_BITS - 1));
+	uint64_t key, cell;
+	float value;
+	int axis, bit;
+
+
+	// Points beyond the 2^21 cells around the origin share the border cells.
+	key = 0;
+	for (axis = 0; axis < 3; axis++)
+	{
+		value = floorf(coordinates[axis] / m_cellSize);
+		value = value < -half ? -half : (value > half - 1.0f ? half - 1.0f : value);
+		cell = (uint64_t)(value + half);
+		for (bit = 0; bit < STATIC_BATCH_CELL_BITS; bit++)
+		{
+			key |= ((cell >> bit) & 1) << (bit * 3 + axis);
+		}
+	}
+
+	return key;
+}
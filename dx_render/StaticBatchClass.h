@@ -0,0 +1,120 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: staticbatchclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _STATICBATCHCLASS_H_
+#define _STATICBATCHCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <DirectXMath.h>
+#include <cstdint>
+#include <vector>
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "meshtypes.h"
+#include "renderdeviceclass.h"
+#include "meshcompressionclass.h"
+#include "meshletclass.h"
+#include "geometrypoolclass.h"
+
+using namespace DirectX;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: StaticBatchClass
+////////////////////////////////////////////////////////////////////////////////
+// The StaticBatchClass merges many small meshes that never move into a few draws. Every mesh added is transformed into world space
+// once, and Build sorts its submeshes by material and then by the cell of a uniform grid their center falls in, with the cells in
+// Morton order so cells next to each other in the buffers are mostly next to each other in the world too. The triangles of one
+// material in one cell are a batch, culled as a whole with the MeshletClass, and batches that survive next to each other in the
+// index buffer are drawn with a single call. Each batch keeps the ranges of the meshes it was made of so a caller can still find them.
+// Indices are 16 bit: the vertices are cut into windows of at most 65536, each drawn with its own base vertex, unless a single submesh
+// is too big for that. AddMesh and Build only touch memory, Initialize uploads the result.
+class StaticBatchClass
+{
+public:
+	struct BuildStatsType
+	{
+		unsigned int sourceCount, pieceCount;
+		unsigned int cellCount, batchCount, windowCount;
+		unsigned int vertexCount, indexCount;
+	};
+
+public:
+	StaticBatchClass();
+	StaticBatchClass(const StaticBatchClass&);
+	~StaticBatchClass();
+
+	void SetCellSize(float);
+	unsigned int AddMesh(const VertexType* verts, const uint32_t* indices, const MeshSubmeshType* submeshes, unsigned int submeshCount,
+		XMMATRIX worldMatrix);
+	void Build();
+
+	bool Initialize(RenderDeviceClass*, VertexFormatType, GeometryPoolClass*);
+	void Shutdown();
+	void Render(RenderDeviceClass*);
+
+	void Cull(XMMATRIX viewMatrix, XMMATRIX projectionMatrix);
+	int GetVisibleRangeCount();
+	IndexRangeType GetVisibleRange(int);
+	float GetVisibleRangeDepth(int);
+	MeshletClass::CullStatsType GetCullStats();
+	void GetPositionDecodeMatrix(OUT XMMATRIX&);
+
+	const VertexType* GetVertices();
+	const uint32_t* GetIndices();
+	DXGI_FORMAT GetIndexFormat();
+	unsigned int GetBatchCount();
+	const MeshletType& GetBatch(unsigned int);
+	void GetSourceRanges(unsigned int source, OUT std::vector<IndexRangeType>&);
+	BuildStatsType GetBuildStats();
+
+private:
+	// The part of one added mesh that uses one material, already in world space and with only the vertices it uses.
+	struct PieceType
+	{
+		unsigned int source, material;
+		uint64_t cell;
+		unsigned int firstVertex, vertexCount;
+		unsigned int firstIndex, indexCount;
+	};
+
+	uint64_t GetCellKey(const XMFLOAT3& center);
+
+private:
+	float m_cellSize;
+
+	// The pieces AddMesh collected, with their vertices and piece relative indices.
+	std::vector<PieceType> m_pieces;
+	std::vector<VertexType> m_pieceVertices;
+	std::vector<uint32_t> m_pieceIndices;
+	std::vector<uint32_t> m_vertexRemap;
+	unsigned int m_sourceCount;
+
+	// What Build made: the vertices and window relative indices, a MeshletType for every batch, and the range of every piece by source.
+	std::vector<VertexType> m_vertices;
+	std::vector<uint32_t> m_indices;
+	bool m_shortIndices;
+	std::vector<MeshletType> m_batches;
+	std::vector<IndexRangeType> m_sourceRanges;
+	std::vector<unsigned int> m_sourceFirstRange;
+	BuildStatsType m_stats;
+
+	// The uploaded buffers, either our own or a place in a geometry pool, and the ranges that survived the last Cull with their depths.
+	RenderDeviceClass* m_device;
+	unsigned int m_vertexBuffer, m_indexBuffer;
+	unsigned int m_vertexStride;
+	DXGI_FORMAT m_indexFormat;
+	XMFLOAT4X4 m_positionDecode;
+	GeometryPoolClass* m_geometryPool;
+	unsigned int m_poolHandle;
+	MeshletClass m_culler;
+	std::vector<IndexRangeType> m_visibleRanges;
+	std::vector<float> m_visibleDepths;
+};
+
+#endif
@@ -11,6 +11,7 @@ SystemClass::SystemClass()
 {
 	m_Input = 0;
 	m_Graphics = 0;
+	m_comInitialized = false;
 }
 
 // Here we create an empty copy constructor and empty class destructor.
@@ -43,6 +44,9 @@ bool SystemClass::Initialize()
 	screenWidth = 0;
 	screenHeight = 0;
 
+	// The WIC texture loader used for the PNG and JPEG images of glTF models needs COM on this thread.
+	m_comInitialized = SUCCEEDED(CoInitializeEx(nullptr, COINIT_MULTITHREADED));
+
 	// Initialize the windows api.
 	InitializeWindows(screenWidth, screenHeight);
 
@@ -97,6 +101,12 @@ void SystemClass::Shutdown()
 	// Shutdown the window.
 	ShutdownWindows();
 
+	if (m_comInitialized)
+	{
+		CoUninitialize();
+		m_comInitialized = false;
+	}
+
 	return;
 }
 
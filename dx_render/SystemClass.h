@@ -15,6 +15,7 @@
 // INCLUDES //
 //////////////
 #include <windows.h>
+#include <objbase.h>
 // We have included the headers to the other two classes in the frame work at this point so we can use them in the system class.
 
 ///////////////////////
@@ -50,6 +51,7 @@ private:
 	LPCWSTR m_applicationName;
 	HINSTANCE m_hinstance;
 	HWND m_hwnd;
+	bool m_comInitialized;
 
 	InputClass* m_Input;
 	GraphicsClass* m_Graphics;
@@ -0,0 +1,111 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: texturecacheclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "texturecacheclass.h"
+#include <cstring>
+#include <cwctype>
+#include <filesystem>
+
+
+TextureCacheClass::TextureCacheClass()
+{
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+
+
+TextureCacheClass::TextureCacheClass(const TextureCacheClass& other)
+{
+}
+
+
+TextureCacheClass::~TextureCacheClass()
+{
+}
+
+// Shutdown releases every texture the cache loaded. Pointers handed out by GetTexture are invalid afterwards.
+void TextureCacheClass::Shutdown()
+{
+	for (auto& entry : m_textures)
+	{
+		if (entry.second)
+		{
+			entry.second->Shutdown();
+			delete entry.second;
+		}
+	}
+	m_textures.clear();
+
+	return;
+}
+
+// GetTexture returns the texture of the file, loading it on the first request. It returns null when the file can not be loaded.
+TextureClass* TextureCacheClass::GetTexture(RenderDeviceClass* device, const wchar_t* filename)
+{
+	std::wstring key;
+	std::error_code error;
+	size_t i;
+
+
+	m_stats.requestCount++;
+
+	key = std::filesystem::absolute(std::filesystem::path(filename), error).lexically_normal().wstring();
+	if (error)
+	{
+		key = filename;
+	}
+
+	for (i = 0; i < key.size(); i++)
+	{
+		key[i] = (wchar_t)towlower(key[i]);
+	}
+
+	return Load(device, key, filename, 0, 0);
+}
+
+// This GetTexture returns the texture of an image file held in memory, creating it on the first request for the name. The name
+// is used as it is, so it should not look like a path some other texture is loaded from.
+TextureClass* TextureCacheClass::GetTexture(RenderDeviceClass* device, const wchar_t* name, const unsigned char* data, size_t size)
+{
+	m_stats.requestCount++;
+
+	return Load(device, name, 0, data, size);
+}
+
+// Load returns the texture cached under the key, or creates it from the file or, without one, from the data and caches it.
+TextureClass* TextureCacheClass::Load(RenderDeviceClass* device, const std::wstring& key, const wchar_t* filename, const unsigned char* data,
+	size_t size)
+{
+	TextureClass* texture;
+	bool result;
+
+
+	auto found = m_textures.find(key);
+	if (found != m_textures.end())
+	{
+		return found->second;
+	}
+
+	texture = new TextureClass;
+	result = filename ? texture->Initialize(device, filename) : texture->Initialize(device, data, size);
+	if (!result)
+	{
+		texture->Shutdown();
+		delete texture;
+		texture = 0;
+		m_stats.failedCount++;
+	}
+	else
+	{
+		m_stats.loadCount++;
+	}
+
+	m_textures[key] = texture;
+
+	return texture;
+}
+
+
+TextureCacheClass::CacheStatsType TextureCacheClass::GetStats()
+{
+	return m_stats;
+}
@@ -0,0 +1,54 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: texturecacheclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _TEXTURECACHECLASS_H_
+#define _TEXTURECACHECLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <string>
+#include <unordered_map>
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "textureclass.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: TextureCacheClass
+////////////////////////////////////////////////////////////////////////////////
+// The TextureCacheClass loads every texture file once however many materials use it and owns the textures until Shutdown.
+// Files are told apart by their absolute path ignoring case, the way Windows compares them. A file that fails to load is
+// remembered as well, so it is not tried again for the next material that names it. Images held in memory, such as those embedded
+// in a .glb, are cached under a name the caller makes up for them.
+class TextureCacheClass
+{
+public:
+	struct CacheStatsType
+	{
+		unsigned int requestCount, loadCount, failedCount;
+	};
+
+public:
+	TextureCacheClass();
+	TextureCacheClass(const TextureCacheClass&);
+	~TextureCacheClass();
+
+	void Shutdown();
+
+	TextureClass* GetTexture(RenderDeviceClass*, const wchar_t* filename);
+	TextureClass* GetTexture(RenderDeviceClass*, const wchar_t* name, const unsigned char* data, size_t size);
+	CacheStatsType GetStats();
+
+private:
+	TextureClass* Load(RenderDeviceClass*, const std::wstring& key, const wchar_t* filename, const unsigned char* data, size_t size);
+
+private:
+	std::unordered_map<std::wstring, TextureClass*> m_textures;
+	CacheStatsType m_stats;
+};
+
+#endif
@@ -2,14 +2,12 @@
 // Filename: textureclass.cpp
 ////////////////////////////////////////////////////////////////////////////////
 #include "textureclass.h"
-#include <DDSTextureLoader.h>
 
-using namespace DirectX;
-
-// The class constructor will initialize the texture shader resource pointer to null.
+// The class constructor will initialize the texture handle to none.
 TextureClass::TextureClass()
 {
-	m_texture = 0;
+	m_device = 0;
+	m_texture = RENDER_HANDLE_NONE;
 }
 
 
@@ -22,39 +20,40 @@ TextureClass::~TextureClass()
 {
 }
 
-// Initialize takes in the Direct3D deviceand file name of the texture and then loads the texture file into the shader resource variable called m_texture.
-// The texture can now be used to render with.
-bool TextureClass::Initialize(ID3D11Device* device, const wchar_t* filename)
+// Initialize takes in the render device and file name of the texture and then loads the texture file into the texture called m_texture.
+// The texture can now be used to render with. The device decides how the file is decoded.
+bool TextureClass::Initialize(RenderDeviceClass* device, const wchar_t* filename)
 {
-	HRESULT result;
-	// ID3D11Resource* texture;
+	m_device = device;
 
 	// Load the texture in.
-	result = CreateDDSTextureFromFile(device, filename,nullptr, &m_texture);
-	//result = D3DX11CreateShaderResourceViewFromFile(device, filename, NULL, NULL, &m_texture, NULL);
-	if (FAILED(result))
-	{
-		return false;
-	}
+	return m_device->CreateTexture(filename, m_texture);
+}
+
+// This Initialize loads a texture from an image file held in memory, such as an image embedded in a .glb file.
+// The data only has to stay valid for the duration of the call.
+bool TextureClass::Initialize(RenderDeviceClass* device, const unsigned char* data, size_t size)
+{
+	m_device = device;
 
-	return true;
+	return m_device->CreateTexture(data, size, m_texture);
 }
 
-// The Shutdown function releases the texture resource if it has been loaded and then sets the pointer to null.
+// The Shutdown function releases the texture resource if it has been loaded and then resets the handle.
 void TextureClass::Shutdown()
 {
 	// Release the texture resource.
 	if (m_texture)
 	{
-		m_texture->Release();
-		m_texture = 0;
+		m_device->ReleaseTexture(m_texture);
+		m_texture = RENDER_HANDLE_NONE;
 	}
 
 	return;
 }
 
-// GetTexture is the function that is called by other objects that need access to the texture shader resource so that they can use the texture for rendering.
-ID3D11ShaderResourceView* TextureClass::GetTexture()
+// GetTexture is the function that is called by other objects that need access to the texture so that they can use it for rendering.
+unsigned int TextureClass::GetTexture()
 {
 	return m_texture;
 }
\ No newline at end of file
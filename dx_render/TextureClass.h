@@ -5,12 +5,10 @@
 #define _TEXTURECLASS_H_
 
 
-//////////////
-// INCLUDES //
-//////////////
-#include <d3d11.h>
-#include "pch.h"
-// #include <d3dx11tex.h>
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "renderdeviceclass.h"
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -24,15 +22,17 @@ public:
 	~TextureClass();
 	
 	// The first two functions will load a texture from a given file name and unload that texture when it is no longer needed.
-	bool Initialize(ID3D11Device*, const wchar_t*);
+	bool Initialize(RenderDeviceClass*, const wchar_t*);
+	bool Initialize(RenderDeviceClass*, const unsigned char* data, size_t size);
 	void Shutdown();
 	 
-	// The GetTexture function returns a pointer to the texture resource so that it can be used for rendering by shaders.
-	ID3D11ShaderResourceView* GetTexture();
+	// The GetTexture function returns the handle of the texture so that it can be used for rendering by shaders.
+	unsigned int GetTexture();
 
 private:
-	// This is the private texture resource.
-	ID3D11ShaderResourceView* m_texture;
+	RenderDeviceClass* m_device;
+	// This is the handle of the private texture resource.
+	unsigned int m_texture;
 };
 
 #endif
\ No newline at end of file
@@ -6,13 +6,12 @@
 
 TextureShaderClass::TextureShaderClass()
 {
-	m_vertexShader = 0;
-	m_pixelShader = 0;
-	m_layout = 0;
-	m_matrixBuffer = 0;
-	// The new sampler variable is set to null in the class constructor.
-
-	m_sampleState = 0;
+	m_device = 0;
+	m_shader = RENDER_HANDLE_NONE;
+	m_instancedShader = RENDER_HANDLE_NONE;
+	m_frameBuffer = RENDER_HANDLE_NONE;
+	m_objectBuffer = RENDER_HANDLE_NONE;
+	m_constantRing = 0;
 }
 
 
@@ -26,13 +25,14 @@ TextureShaderClass::~TextureShaderClass()
 }
 
 
-bool TextureShaderClass::Initialize(ID3D11Device* device, HWND hwnd)
+// The input layout comes from the model, so the shader can read whichever vertex format the model was uploaded with.
+bool TextureShaderClass::Initialize(RenderDeviceClass* device, const VertexElementDescType* layout, unsigned int elementCount)
 {
 	bool result;
 	// The new texture.vs and texture.ps HLSL files are loaded for this shader.
 
 	// Initialize the vertex and pixel shaders.
-	result = InitializeShader(device, hwnd, L"../TextureVertShader.hlsl", L"../TexturePixShader.hlsl");
+	result = InitializeShader(device, L"../TextureVertShader.hlsl", L"../TexturePixShader.hlsl", layout, elementCount);
 	if (!result)
 	{
 		return false;
@@ -42,6 +42,15 @@ bool TextureShaderClass::Initialize(ID3D11Device* device, HWND hwnd)
 	return true;
 }
 
+// SetConstantRing makes the shader write its matrices into a ring shared by all draws of a frame instead of its own buffer, null
+// goes back to its own buffer.
+void TextureShaderClass::SetConstantRing(ConstantRingClass* constantRing)
+{
+	m_constantRing = constantRing;
+
+	return;
+}
+
 // The Shutdown function calls the release of the shader variables.
 void TextureShaderClass::Shutdown()
 {
@@ -51,196 +60,159 @@ void TextureShaderClass::Shutdown()
 	return;
 }
 
-// The Render function now takes a new parameter called texture which is the pointer to the texture resource.
-// This is then sent into the SetShaderParameters function so that the texture can be set in the shaderand then used for rendering.
-bool TextureShaderClass::Render(ID3D11DeviceContext * deviceContext, int indexCount, XMMATRIX worldMatrix, XMMATRIX viewMatrix,
-	XMMATRIX projectionMatrix, ID3D11ShaderResourceView * texture)
+// SetFrameParameters uploads the camera matrices once per frame, every Render until the next call draws with them.
+bool TextureShaderClass::SetFrameParameters(RenderDeviceClass* device, const TransformBatchClass::FrameConstantsType& frameConstants)
 {
 	bool result;
+	void* mappedData;
 
 
-	// Set the shader parameters that it will use for rendering.
-	result = SetShaderParameters(deviceContext, worldMatrix, viewMatrix, projectionMatrix, texture);
+	result = device->MapBuffer(m_frameBuffer, RENDER_MAP_DISCARD, 0, sizeof(frameConstants), mappedData);
 	if (!result)
 	{
 		return false;
 	}
 
-	// Now render the prepared buffers with the shader.
-	RenderShader(deviceContext, indexCount);
+	*(TransformBatchClass::FrameConstantsType*)mappedData = frameConstants;
+
+	device->UnmapBuffer(m_frameBuffer);
+
+	BindFrameParameters(device);
 
 	return true;
 }
 
-// InitializeShader sets up the texture shader.
-bool TextureShaderClass::InitializeShader(ID3D11Device * device, HWND hwnd, const wchar_t * vsFilename, const wchar_t * psFilename)
+// BindFrameParameters binds the camera matrices SetFrameParameters uploaded, a command list starts out without them.
+void TextureShaderClass::BindFrameParameters(RenderDeviceClass* device)
 {
-	HRESULT result;
-	ID3D10Blob* errorMessage;
-	ID3D10Blob* vertexShaderBuffer;
-	ID3D10Blob* pixelShaderBuffer;
-	D3D11_INPUT_ELEMENT_DESC polygonLayout[2];
-	unsigned int numElements;
-	D3D11_BUFFER_DESC matrixBufferDesc;
-	// We have a new variable to hold the description of the texture sampler that will be setup in this function.
-
-		D3D11_SAMPLER_DESC samplerDesc;
-
-
-	// Initialize the pointers this function will use to null.
-	errorMessage = 0;
-	vertexShaderBuffer = 0;
-	pixelShaderBuffer = 0;
-	// Load in the new texture vertexand pixel shaders.
-
-	// Compile the vertex shader code.
-	result = D3DCompileFromFile(vsFilename,
-		NULL,
-		NULL,
-		"TextureVertexShader",
-		"vs_5_0",
-		D3D10_SHADER_ENABLE_STRICTNESS,
-		NULL,
-		&vertexShaderBuffer,
-		&errorMessage);
-
-	if (FAILED(result))
-	{
-		// If the shader failed to compile it should have writen something to the error message.
-		if (errorMessage)
-		{
-			OutputShaderErrorMessage(errorMessage, hwnd, vsFilename);
-		}
-		// If there was nothing in the error message then it simply could not find the shader file itself.
-		else
-		{
-			MessageBox(hwnd, vsFilename, L"Missing Shader File", MB_OK);
-		}
+	device->SetConstantBuffer(RENDER_STAGE_VERTEX, 0, m_frameBuffer, 0, 0);
 
-		return false;
-	}
+	return;
+}
 
-	// Compile the pixel shader code.
-	result = D3DCompileFromFile(psFilename,
-		NULL,
-		NULL,
-		"TexturePixelShader",
-		"ps_5_0",
-		D3D10_SHADER_ENABLE_STRICTNESS,
-		NULL,
-		&pixelShaderBuffer,
-		&errorMessage);
-	if (FAILED(result))
+// WriteObjectParameters writes the constants of objectCount objects into one slice of the constant ring ahead of the draws, so every
+// draw of an object binds the same part of it and draws recorded on other threads need no writes of their own. Object i is at
+// firstConstant + i * constantStride and is constantStride constants long. It fails without a ring or when the ring is full.
+bool TextureShaderClass::WriteObjectParameters(const TransformBatchClass::ObjectConstantsType* objectConstants, unsigned int objectCount,
+	OUT unsigned int& firstConstant, OUT unsigned int& constantStride)
+{
+	if (!m_constantRing)
 	{
-		// If the shader failed to compile it should have writen something to the error message.
-		if (errorMessage)
-		{
-			OutputShaderErrorMessage(errorMessage, hwnd, psFilename);
-		}
-		// If there was  nothing in the error message then it simply could not find the file itself.
-		else
-		{
-			MessageBox(hwnd, psFilename, L"Missing Shader File", MB_OK);
-		}
-
 		return false;
 	}
 
-	// Create the vertex shader from the buffer.
-	result = device->CreateVertexShader(vertexShaderBuffer->GetBufferPointer(), vertexShaderBuffer->GetBufferSize(), NULL, &m_vertexShader);
-	if (FAILED(result))
+	return m_constantRing->WriteArray(objectConstants, sizeof(objectConstants[0]), objectCount, firstConstant, constantStride);
+}
+
+// The Render function now takes a new parameter called texture which is the handle of the texture resource.
+// This is then sent into the SetShaderParameters function so that the texture can be set in the shaderand then used for rendering.
+bool TextureShaderClass::Render(RenderDeviceClass* device, int indexCount, const TransformBatchClass::ObjectConstantsType& objectConstants,
+	unsigned int texture)
+{
+	return Render(device, indexCount, 0, 0, objectConstants, texture);
+}
+
+// This Render draws one range of the index buffer, startIndex and baseVertex are passed straight on to DrawIndexed. The object
+// constants come from a TransformBatchClass of the frame SetFrameParameters was last called for.
+bool TextureShaderClass::Render(RenderDeviceClass* device, int indexCount, int startIndex, int baseVertex,
+	const TransformBatchClass::ObjectConstantsType& objectConstants, unsigned int texture)
+{
+	bool result;
+
+
+	// Set the shader parameters that it will use for rendering.
+	result = SetShaderParameters(device, objectConstants, texture);
+	if (!result)
 	{
 		return false;
 	}
 
-	// Create the pixel shader from the buffer.
-	result = device->CreatePixelShader(pixelShaderBuffer->GetBufferPointer(), pixelShaderBuffer->GetBufferSize(), NULL, &m_pixelShader);
-	if (FAILED(result))
+	// Now render the prepared buffers with the shader.
+	RenderShader(device, indexCount, startIndex, baseVertex);
+
+	return true;
+}
+
+// This Render draws with object constants WriteObjectParameters wrote this frame. It only binds, so it can record into a command list.
+void TextureShaderClass::Render(RenderDeviceClass* device, int indexCount, int startIndex, int baseVertex, unsigned int firstConstant,
+	unsigned int constantCount, unsigned int texture)
+{
+	m_constantRing->SetVertexShaderConstants(device, 1, firstConstant, constantCount);
+	device->SetTexture(0, texture);
+	RenderShader(device, indexCount, startIndex, baseVertex);
+
+	return;
+}
+
+// RenderInstanced draws one range of the index buffer once for every instance in the instance stream, with the world matrix of each
+// instance and the camera matrices of SetFrameParameters. It needs no object constants.
+void TextureShaderClass::RenderInstanced(RenderDeviceClass* device, int indexCount, int instanceCount, int startIndex, int baseVertex,
+	int startInstance, unsigned int texture)
+{
+	device->SetTexture(0, texture);
+	device->SetShader(m_instancedShader);
+	device->DrawIndexedInstanced(indexCount, instanceCount, startIndex, baseVertex, startInstance);
+
+	return;
+}
+
+// InitializeShader sets up the texture shader. The device compiles the vertex and pixel shaders and reports compile errors itself.
+bool TextureShaderClass::InitializeShader(RenderDeviceClass* device, const wchar_t* vsFilename, const wchar_t* psFilename,
+	const VertexElementDescType* polygonLayout, unsigned int numElements)
+{
+	bool result;
+	RenderDeviceClass::ShaderDescType shaderDesc;
+	RenderDeviceClass::BufferDescType constantBufferDesc;
+	std::vector<VertexElementDescType> instancedLayout;
+
+
+	m_device = device;
+
+	// The vertex input layout description comes from the model and has to match the vertex format it uploaded.
+	// The shader reads POSITION as a float4 and TEXCOORD as a float2 whatever their format in the vertex buffer is.
+	shaderDesc.vertexShaderFile = vsFilename;
+	shaderDesc.vertexEntryPoint = "TextureVertexShader";
+	shaderDesc.pixelShaderFile = psFilename;
+	shaderDesc.pixelEntryPoint = "TexturePixelShader";
+	shaderDesc.layout = polygonLayout;
+	shaderDesc.elementCount = numElements;
+
+	// Create the vertex and pixel shaders and the vertex input layout.
+	result = m_device->CreateShader(shaderDesc, m_shader);
+	if (!result)
 	{
 		return false;
 	}
 
-	// The input layout has changed as we now have a texture element instead of color.
-	// The first position element stays unchanged but the SemanticNameand Format of the second element have been changed to TEXCOORD and DXGI_FORMAT_R32G32_FLOAT.
-	// These two changes will now align this layout with our new VertexType in both the ModelClass definitionand the typedefs in the shader files.
-
-	// Create the vertex input layout description.
-	// This setup needs to match the VertexType stucture in the ModelClass and in the shader.
-	polygonLayout[0].SemanticName = "POSITION";
-	polygonLayout[0].SemanticIndex = 0;
-	polygonLayout[0].Format = DXGI_FORMAT_R32G32B32_FLOAT;
-	polygonLayout[0].InputSlot = 0;
-	polygonLayout[0].AlignedByteOffset = 0;
-	polygonLayout[0].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
-	polygonLayout[0].InstanceDataStepRate = 0;
-
-	polygonLayout[1].SemanticName = "TEXCOORD";
-	polygonLayout[1].SemanticIndex = 0;
-	polygonLayout[1].Format = DXGI_FORMAT_R32G32_FLOAT;
-	polygonLayout[1].InputSlot = 0;
-	polygonLayout[1].AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
-	polygonLayout[1].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
-	polygonLayout[1].InstanceDataStepRate = 0;
-
-	// Get a count of the elements in the layout.
-	numElements = sizeof(polygonLayout) / sizeof(polygonLayout[0]);
-
-	// Create the vertex input layout.
-	result = device->CreateInputLayout(polygonLayout, numElements, vertexShaderBuffer->GetBufferPointer(), vertexShaderBuffer->GetBufferSize(),
-		&m_layout);
-	if (FAILED(result))
+	// The instanced variant reads the same vertices plus the rows of a world matrix from the instance stream.
+	instancedLayout.assign(polygonLayout, polygonLayout + numElements);
+	instancedLayout.insert(instancedLayout.end(), INSTANCE_VERTEX_LAYOUT, INSTANCE_VERTEX_LAYOUT + INSTANCE_VERTEX_ELEMENT_COUNT);
+	shaderDesc.vertexEntryPoint = "TextureInstancedVertexShader";
+	shaderDesc.layout = instancedLayout.data();
+	shaderDesc.elementCount = (unsigned int)instancedLayout.size();
+
+	result = m_device->CreateShader(shaderDesc, m_instancedShader);
+	if (!result)
 	{
 		return false;
 	}
 
-	// Release the vertex shader buffer and pixel shader buffer since they are no longer needed.
-	vertexShaderBuffer->Release();
-	vertexShaderBuffer = 0;
+	// Setup the description of the dynamic frame constant buffer that is in the vertex shader.
+	constantBufferDesc.bind = RENDER_BIND_CONSTANT_BUFFER;
+	constantBufferDesc.usage = RENDER_USAGE_DYNAMIC;
+	constantBufferDesc.byteWidth = sizeof(TransformBatchClass::FrameConstantsType);
 
-	pixelShaderBuffer->Release();
-	pixelShaderBuffer = 0;
-
-	// Setup the description of the dynamic matrix constant buffer that is in the vertex shader.
-	matrixBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
-	matrixBufferDesc.ByteWidth = sizeof(MatrixBufferType);
-	matrixBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-	matrixBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-	matrixBufferDesc.MiscFlags = 0;
-	matrixBufferDesc.StructureByteStride = 0;
-
-	// Create the constant buffer pointer so we can access the vertex shader constant buffer from within this class.
-	result = device->CreateBuffer(&matrixBufferDesc, NULL, &m_matrixBuffer);
-	if (FAILED(result))
+	// Create the constant buffer so we can access the vertex shader constant buffer from within this class.
+	result = m_device->CreateBuffer(constantBufferDesc, 0, m_frameBuffer);
+	if (!result)
 	{
 		return false;
 	}
-	// The sampler state description is setup here and then can be passed to the pixel shader after.
-	// The most important element of the texture sampler description is Filter.
-	// Filter will determine how it decides which pixels will be used or combined to create the final look of the texture on the polygon face.
-	// In the example here I use D3D11_FILTER_MIN_MAG_MIP_LINEAR which is more expensive in terms of processing but gives the best visual result.
-	// It tells the sampler to use linear interpolation for minification, magnification, and mip - level sampling.
-
-	// AddressU and AddressV are set to Wrap which ensures that the coordinates stay between 0.0f and 1.0f.Anything outside of that wraps around and is placed between 0.0f and 1.0f.
-	// All other settings for the sampler state description are defaults.
-
-	// Create a texture sampler state description.
-	samplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
-	samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_WRAP;
-	samplerDesc.AddressV = D3D11_TEXTURE_ADDRESS_WRAP;
-	samplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_WRAP;
-	samplerDesc.MipLODBias = 0.0f;
-	samplerDesc.MaxAnisotropy = 1;
-	samplerDesc.ComparisonFunc = D3D11_COMPARISON_ALWAYS;
-	samplerDesc.BorderColor[0] = 0;
-	samplerDesc.BorderColor[1] = 0;
-	samplerDesc.BorderColor[2] = 0;
-	samplerDesc.BorderColor[3] = 0;
-	samplerDesc.MinLOD = 0;
-	samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
-
-	// Create the texture sampler state.
-	result = device->CreateSamplerState(&samplerDesc, &m_sampleState);
-	if (FAILED(result))
+
+	// The object constant buffer is the same apart from its size, it is only used when there is no constant ring.
+	constantBufferDesc.byteWidth = sizeof(TransformBatchClass::ObjectConstantsType);
+	result = m_device->CreateBuffer(constantBufferDesc, 0, m_objectBuffer);
+	if (!result)
 	{
 		return false;
 	}
@@ -251,147 +223,98 @@ bool TextureShaderClass::InitializeShader(ID3D11Device * device, HWND hwnd, cons
 // The ShutdownShader function releases all the variables used in the TextureShaderClass.
 void TextureShaderClass::ShutdownShader()
 {
-	// The ShutdownShader function now releases the new sampler state that was created during initialization.
-
-	// Release the sampler state.
-	if (m_sampleState)
-	{
-		m_sampleState->Release();
-		m_sampleState = 0;
-	}
-
-	// Release the matrix constant buffer.
-	if (m_matrixBuffer)
+	// Release the constant buffers.
+	if (m_objectBuffer)
 	{
-		m_matrixBuffer->Release();
-		m_matrixBuffer = 0;
+		m_device->ReleaseBuffer(m_objectBuffer);
+		m_objectBuffer = RENDER_HANDLE_NONE;
 	}
 
-	// Release the layout.
-	if (m_layout)
+	if (m_frameBuffer)
 	{
-		m_layout->Release();
-		m_layout = 0;
+		m_device->ReleaseBuffer(m_frameBuffer);
+		m_frameBuffer = RENDER_HANDLE_NONE;
 	}
 
-	// Release the pixel shader.
-	if (m_pixelShader)
+	// Release the shaders and the layout.
+	if (m_instancedShader)
 	{
-		m_pixelShader->Release();
-		m_pixelShader = 0;
+		m_device->ReleaseShader(m_instancedShader);
+		m_instancedShader = RENDER_HANDLE_NONE;
 	}
 
-	// Release the vertex shader.
-	if (m_vertexShader)
+	if (m_shader)
 	{
-		m_vertexShader->Release();
-		m_vertexShader = 0;
+		m_device->ReleaseShader(m_shader);
+		m_shader = RENDER_HANDLE_NONE;
 	}
 
 	return;
 }
 
-// OutputShaderErrorMessage writes out errors to a text file if the HLSL shader could not be loaded.
-void TextureShaderClass::OutputShaderErrorMessage(ID3D10Blob * errorMessage, HWND hwnd, const wchar_t * shaderFilename)
+// SetShaderParameters function now takes in the handle of a texture and then assigns it to the shader.
+// Note that the texture has to be set before rendering of the buffer occurs.
+bool TextureShaderClass::SetShaderParameters(RenderDeviceClass* device, const TransformBatchClass::ObjectConstantsType& objectConstants,
+	unsigned int texture)
 {
-	char* compileErrors;
-	unsigned long bufferSize, i;
-	ofstream fout;
-
-
-	// Get a pointer to the error message text buffer.
-	compileErrors = (char*)(errorMessage->GetBufferPointer());
-
-	// Get the length of the message.
-	bufferSize = errorMessage->GetBufferSize();
+	bool result;
+	void* mappedData;
+	TransformBatchClass::ObjectConstantsType* dataPtr;
+	unsigned int bufferNumber, firstConstant, constantCount;
 
-	// Open a file to write the error message to.
-	fout.open("shader-error.txt");
 
-	// Write out the error message.
-	for (i = 0; i < bufferSize; i++)
+	// The object constants come transposed for the shader already. With a constant ring they go into the next slice of it, which is
+	// bound at its offset. The shader's own buffer is only mapped without one, or if the ring could not take them.
+	if (m_constantRing)
 	{
-		fout << compileErrors[i];
-	}
-
-	// Close the file.
-	fout.close();
-
-	// Release the error message.
-	errorMessage->Release();
-	errorMessage = 0;
-
-	// Pop a message up on the screen to notify the user to check the text file for compile errors.
-	MessageBox(hwnd, L"Error compiling shader.  Check shader-error.txt for message.", shaderFilename, MB_OK);
-
-	return;
-}
-
-// SetShaderParameters function now takes in a pointer to a texture resourceand then assigns it to the shader using the new texture resource pointer.
-// Note that the texture has to be set before rendering of the buffer occurs.
-bool TextureShaderClass::SetShaderParameters(ID3D11DeviceContext* deviceContext, XMMATRIX worldMatrix, XMMATRIX viewMatrix,
-	XMMATRIX projectionMatrix, ID3D11ShaderResourceView* texture)
-{
-	HRESULT result;
-	D3D11_MAPPED_SUBRESOURCE mappedResource;
-	MatrixBufferType* dataPtr;
-	unsigned int bufferNumber;
-
+		if (m_constantRing->Write(&objectConstants, sizeof(objectConstants), firstConstant, constantCount))
+		{
+			m_constantRing->SetVertexShaderConstants(device, 1, firstConstant, constantCount);
+			device->SetTexture(0, texture);
 
-	// Transpose the matrices to prepare them for the shader.
-	worldMatrix = XMMatrixTranspose(worldMatrix);
-	viewMatrix = XMMatrixTranspose(viewMatrix);
-	projectionMatrix = XMMatrixTranspose(projectionMatrix);
+			return true;
+		}
+	}
 
 	// Lock the constant buffer so it can be written to.
-	result = deviceContext->Map(m_matrixBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
-	if (FAILED(result))
+	result = device->MapBuffer(m_objectBuffer, RENDER_MAP_DISCARD, 0, sizeof(objectConstants), mappedData);
+	if (!result)
 	{
 		return false;
 	}
 
 	// Get a pointer to the data in the constant buffer.
-	dataPtr = (MatrixBufferType*)mappedResource.pData;
+	dataPtr = (TransformBatchClass::ObjectConstantsType*)mappedData;
 
 	// Copy the matrices into the constant buffer.
-	dataPtr->world = worldMatrix;
-	dataPtr->view = viewMatrix;
-	dataPtr->projection = projectionMatrix;
+	*dataPtr = objectConstants;
 
 	// Unlock the constant buffer.
-	deviceContext->Unmap(m_matrixBuffer, 0);
+	device->UnmapBuffer(m_objectBuffer);
 
-	// Set the position of the constant buffer in the vertex shader.
-	bufferNumber = 0;
+	// Set the position of the constant buffer in the vertex shader, the frame constants are in the one before it.
+	bufferNumber = 1;
 
 	// Now set the constant buffer in the vertex shader with the updated values.
-	deviceContext->VSSetConstantBuffers(bufferNumber, 1, &m_matrixBuffer);
+	device->SetConstantBuffer(RENDER_STAGE_VERTEX, bufferNumber, m_objectBuffer, 0, 0);
 	
 	// The SetShaderParameters function has been modified from the previous tutorial to include setting the texture in the pixel shader now.
 
 	// Set shader texture resource in the pixel shader.
-	deviceContext->PSSetShaderResources(0, 1, &texture);
+	device->SetTexture(0, texture);
 
 	return true;
 }
 
 // RenderShader calls the shader technique to render the polygons.
-void TextureShaderClass::RenderShader(ID3D11DeviceContext * deviceContext, int indexCount)
+void TextureShaderClass::RenderShader(RenderDeviceClass* device, int indexCount, int startIndex, int baseVertex)
 {
-	// Set the vertex input layout.
-	deviceContext->IASetInputLayout(m_layout);
-
-	// Set the vertex and pixel shaders that will be used to render this triangle.
-	deviceContext->VSSetShader(m_vertexShader, NULL, 0);
-	deviceContext->PSSetShader(m_pixelShader, NULL, 0);
-	
-	// The RenderShader function has been changed to include setting the sample state in the pixel shader before rendering.
-
-	// Set the sampler state in the pixel shader.
-	deviceContext->PSSetSamplers(0, 1, &m_sampleState);
+	// Set the vertex input layout and the vertex and pixel shaders that will be used to render this triangle.
+	// The device sets its sampler state in the pixel shader along with them.
+	device->SetShader(m_shader);
 
 	// Render the triangle.
-	deviceContext->DrawIndexed(indexCount, 0, 0);
+	device->DrawIndexed(indexCount, startIndex, baseVertex);
 
 	return;
 }
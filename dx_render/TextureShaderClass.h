@@ -8,11 +8,16 @@
 //////////////
 // INCLUDES //
 //////////////
-#include <d3d11.h>
 #include <DirectXMath.h>
-#include <d3dcompiler.h>
-// #include <d3dx11async.h>
-#include <fstream>
+#include <vector>
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "renderdeviceclass.h"
+#include "constantringclass.h"
+#include "transformbatchclass.h"
+
 using namespace std;
 using namespace DirectX;
 
@@ -22,40 +27,42 @@ using namespace DirectX;
 ////////////////////////////////////////////////////////////////////////////////
 class TextureShaderClass
 {
-private:
-	struct MatrixBufferType
-	{
-		XMMATRIX world;
-		XMMATRIX view;
-		XMMATRIX projection;
-	};
-
 public:
 	TextureShaderClass();
 	TextureShaderClass(const TextureShaderClass&);
 	~TextureShaderClass();
 
-	bool Initialize(ID3D11Device*, HWND);
+	bool Initialize(RenderDeviceClass*, const VertexElementDescType* layout, unsigned int elementCount);
+	void SetConstantRing(ConstantRingClass*);
 	void Shutdown();
-	bool Render(ID3D11DeviceContext*, int, XMMATRIX, XMMATRIX, XMMATRIX, ID3D11ShaderResourceView*);
+	bool SetFrameParameters(RenderDeviceClass*, const TransformBatchClass::FrameConstantsType&);
+	void BindFrameParameters(RenderDeviceClass*);
+	bool WriteObjectParameters(const TransformBatchClass::ObjectConstantsType*, unsigned int objectCount, OUT unsigned int& firstConstant,
+		OUT unsigned int& constantStride);
+	bool Render(RenderDeviceClass*, int, const TransformBatchClass::ObjectConstantsType&, unsigned int texture);
+	bool Render(RenderDeviceClass*, int indexCount, int startIndex, int baseVertex, const TransformBatchClass::ObjectConstantsType&,
+		unsigned int texture);
+	void Render(RenderDeviceClass*, int indexCount, int startIndex, int baseVertex, unsigned int firstConstant, unsigned int constantCount,
+		unsigned int texture);
+	void RenderInstanced(RenderDeviceClass*, int indexCount, int instanceCount, int startIndex, int baseVertex, int startInstance,
+		unsigned int texture);
 
 private:
-	bool InitializeShader(ID3D11Device*, HWND, const wchar_t*, const wchar_t*);
+	bool InitializeShader(RenderDeviceClass*, const wchar_t*, const wchar_t*, const VertexElementDescType*, unsigned int);
 	void ShutdownShader();
-	void OutputShaderErrorMessage(ID3D10Blob*, HWND, const wchar_t*);
 
-	bool SetShaderParameters(ID3D11DeviceContext*, XMMATRIX, XMMATRIX, XMMATRIX, ID3D11ShaderResourceView*);
-	void RenderShader(ID3D11DeviceContext*, int);
+	bool SetShaderParameters(RenderDeviceClass*, const TransformBatchClass::ObjectConstantsType&, unsigned int texture);
+	void RenderShader(RenderDeviceClass*, int, int, int);
 
 private:
-	ID3D11VertexShader* m_vertexShader;
-	ID3D11PixelShader* m_pixelShader;
-	ID3D11InputLayout* m_layout;
-	ID3D11Buffer* m_matrixBuffer;
-
-	// There is a new private variable for the sampler state pointer.
-	// This pointer will be used to interface with the texture shader.
-	ID3D11SamplerState* m_sampleState;
+	RenderDeviceClass* m_device;
+	// The vertex and pixel shader with their input layout, the device samples the texture through its linear wrapping sampler. The
+	// instanced shader has the same pixel shader and the instance stream after the vertex layout.
+	unsigned int m_shader;
+	unsigned int m_instancedShader;
+	unsigned int m_frameBuffer;
+	unsigned int m_objectBuffer;
+	ConstantRingClass* m_constantRing;
 };
 
 #endif
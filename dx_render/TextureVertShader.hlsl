@@ -6,11 +6,19 @@
 /////////////
 // GLOBALS //
 /////////////
-cbuffer MatrixBuffer
+// The camera matrices change once per frame and the object matrices once per draw, so they are uploaded separately. The
+// world-view-projection matrix is multiplied out on the CPU, the world matrix is there for shaders that light in world space.
+cbuffer FrameBuffer : register(b0)
 {
-    matrix worldMatrix;
     matrix viewMatrix;
     matrix projectionMatrix;
+    matrix viewProjectionMatrix;
+};
+
+cbuffer ObjectBuffer : register(b1)
+{
+    matrix worldViewProjectionMatrix;
+    matrix worldMatrix;
 };
 
 // We are no longer using color in our vertex type and have instead moved to using texture coordinates.
@@ -27,6 +35,16 @@ struct VertexInputType
     float2 tex : TEXCOORD0;
 };
 
+// The instanced shader reads the world matrix of each instance from the instance stream, as the first three rows of its transpose.
+struct InstancedVertexInputType
+{
+    float4 position : POSITION;
+    float2 tex : TEXCOORD0;
+    float4 world0 : WORLD0;
+    float4 world1 : WORLD1;
+    float4 world2 : WORLD2;
+};
+
 struct PixelInputType
 {
     float4 position : SV_POSITION;
@@ -45,10 +63,8 @@ PixelInputType TextureVertexShader(VertexInputType input)
     // Change the position vector to be 4 units for proper matrix calculations.
     input.position.w = 1.0f;
 
-    // Calculate the position of the vertex against the world, view, and projection matrices.
-    output.position = mul(input.position, worldMatrix);
-    output.position = mul(output.position, viewMatrix);
-    output.position = mul(output.position, projectionMatrix);
+    // Calculate the position of the vertex against the combined world, view, and projection matrix.
+    output.position = mul(input.position, worldViewProjectionMatrix);
     // The only difference in the texture vertex shader in comparison to the color vertex shader from the previous tutorial
     // is that instead of taking a copy of the color from the input vertex we take a copy of the texture coordinates and pass them to the pixel shader.
 
@@ -56,4 +72,29 @@ PixelInputType TextureVertexShader(VertexInputType input)
     output.tex = input.tex;
 
     return output;
-}
\ No newline at end of file
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Instanced Vertex Shader
+////////////////////////////////////////////////////////////////////////////////
+PixelInputType TextureInstancedVertexShader(InstancedVertexInputType input)
+{
+    PixelInputType output;
+    float4 worldPosition;
+
+
+    input.position.w = 1.0f;
+
+    // Each row of the transposed world matrix dotted with the position is one component of the world position, whose w stays one.
+    worldPosition.x = dot(input.position, input.world0);
+    worldPosition.y = dot(input.position, input.world1);
+    worldPosition.z = dot(input.position, input.world2);
+    worldPosition.w = 1.0f;
+
+    // The view and projection are the same for every instance and come from the frame constants.
+    output.position = mul(worldPosition, viewProjectionMatrix);
+    output.tex = input.tex;
+
+    return output;
+}
@@ -0,0 +1,489 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: tlsfallocatorclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "tlsfallocatorclass.h"
+#include <bit>
+#include <climits>
+#include <cstring>
+
+
+TlsfAllocatorClass::TlsfAllocatorClass()
+{
+	m_capacity = 0;
+	m_lastBlock = TLSF_HANDLE_NONE;
+	memset(m_freeLists, 0xff, sizeof(m_freeLists));
+	m_firstLevelBits = 0;
+	memset(m_secondLevelBits, 0, sizeof(m_secondLevelBits));
+	m_usedUnits = 0;
+	m_allocationCount = 0;
+	m_freeBlockCount = 0;
+}
+
+
+TlsfAllocatorClass::TlsfAllocatorClass(const TlsfAllocatorClass& other)
+{
+}
+
+
+TlsfAllocatorClass::~TlsfAllocatorClass()
+{
+}
+
+// Initialize starts over with a single free block of the given number of units. Handles of earlier allocations are invalid afterwards.
+bool TlsfAllocatorClass::Initialize(unsigned int capacity)
+{
+	Shutdown();
+	Grow(capacity);
+
+	return true;
+}
+
+
+void TlsfAllocatorClass::Shutdown()
+{
+	m_capacity = 0;
+	m_blocks.clear();
+	m_unusedBlocks.clear();
+	m_lastBlock = TLSF_HANDLE_NONE;
+	memset(m_freeLists, 0xff, sizeof(m_freeLists));
+	m_firstLevelBits = 0;
+	memset(m_secondLevelBits, 0, sizeof(m_secondLevelBits));
+	m_usedUnits = 0;
+	m_allocationCount = 0;
+	m_freeBlockCount = 0;
+
+	return;
+}
+
+// Allocate returns the handle of a range of size units, or TLSF_HANDLE_NONE when no free block is big enough. The smallest list that
+// only has blocks of at least size units is searched, and what the block has beyond size goes back into the lists as a block of its own.
+unsigned int TlsfAllocatorClass::Allocate(unsigned int size)
+{
+	unsigned int block, rest, next;
+
+
+	if (size == 0)
+	{
+		return TLSF_HANDLE_NONE;
+	}
+
+	block = FindFree(size);
+	if (block == TLSF_HANDLE_NONE)
+	{
+		return TLSF_HANDLE_NONE;
+	}
+
+	RemoveFree(block);
+	if (m_blocks[block].size > size)
+	{
+		// NewBlock can move the records, so they are only ever reached by index here.
+		rest = NewBlock();
+		next = m_blocks[block].next;
+		m_blocks[rest].offset = m_blocks[block].offset + size;
+		m_blocks[rest].size = m_blocks[block].size - size;
+		m_blocks[rest].previous = block;
+		m_blocks[rest].next = next;
+		if (next != TLSF_HANDLE_NONE)
+		{
+			m_blocks[next].previous = rest;
+		}
+		else
+		{
+			m_lastBlock = rest;
+		}
+		m_blocks[block].next = rest;
+		m_blocks[block].size = size;
+		InsertFree(rest);
+	}
+
+	m_blocks[block].free = false;
+	m_usedUnits += size;
+	m_allocationCount++;
+
+	return block;
+}
+
+// Free returns the range of a handle Allocate gave out and merges it with the free blocks on either side of it.
+void TlsfAllocatorClass::Free(unsigned int handle)
+{
+	unsigned int block, neighbour;
+
+
+	if (handle >= m_blocks.size() || !m_blocks[handle].live || m_blocks[handle].free)
+	{
+		return;
+	}
+
+	block = handle;
+	m_usedUnits -= m_blocks[block].size;
+	m_allocationCount--;
+
+	neighbour = m_blocks[block].previous;
+	if (neighbour != TLSF_HANDLE_NONE && m_blocks[neighbour].free)
+	{
+		RemoveFree(neighbour);
+		m_blocks[neighbour].size += m_blocks[block].size;
+		m_blocks[neighbour].next = m_blocks[block].next;
+		if (m_blocks[block].next != TLSF_HANDLE_NONE)
+		{
+			m_blocks[m_blocks[block].next].previous = neighbour;
+		}
+		else
+		{
+			m_lastBlock = neighbour;
+		}
+		ReleaseBlock(block);
+		block = neighbour;
+	}
+
+	neighbour = m_blocks[block].next;
+	if (neighbour != TLSF_HANDLE_NONE && m_blocks[neighbour].free)
+	{
+		RemoveFree(neighbour);
+		m_blocks[block].size += m_blocks[neighbour].size;
+		m_blocks[block].next = m_blocks[neighbour].next;
+		if (m_blocks[neighbour].next != TLSF_HANDLE_NONE)
+		{
+			m_blocks[m_blocks[neighbour].next].previous = block;
+		}
+		else
+		{
+			m_lastBlock = block;
+		}
+		ReleaseBlock(neighbour);
+	}
+
+	InsertFree(block);
+
+	return;
+}
+
+// Grow adds units to the end of the range, to the last block if that is free and as a new free block otherwise.
+void TlsfAllocatorClass::Grow(unsigned int capacity)
+{
+	unsigned int block;
+
+
+	if (capacity <= m_capacity)
+	{
+		return;
+	}
+
+	if (m_lastBlock != TLSF_HANDLE_NONE && m_blocks[m_lastBlock].free)
+	{
+		RemoveFree(m_lastBlock);
+		m_blocks[m_lastBlock].size += capacity - m_capacity;
+		InsertFree(m_lastBlock);
+	}
+	else
+	{
+		block = NewBlock();
+		m_blocks[block].offset = m_capacity;
+		m_blocks[block].size = capacity - m_capacity;
+		m_blocks[block].previous = m_lastBlock;
+		m_blocks[block].next = TLSF_HANDLE_NONE;
+		if (m_lastBlock != TLSF_HANDLE_NONE)
+		{
+			m_blocks[m_lastBlock].next = block;
+		}
+		m_lastBlock = block;
+		InsertFree(block);
+	}
+
+	m_capacity = capacity;
+
+	return;
+}
+
+// Defragment packs the allocations to the start of the range in the order they lie in, which leaves a single free block at the end.
+// Every allocation that moved is listed in out_moves in that order. Since none moves up, copying them in the order given never
+// overwrites one that has yet to be copied.
+void TlsfAllocatorClass::Defragment(OUT std::vector<MoveType>& out_moves)
+{
+	std::vector<unsigned int> order;
+	MoveType move;
+	unsigned int block, offset, previous;
+	size_t i;
+
+
+	out_moves.clear();
+
+	for (block = m_lastBlock; block != TLSF_HANDLE_NONE; block = m_blocks[block].previous)
+	{
+		if (!m_blocks[block].free)
+		{
+			order.push_back(block);
+		}
+	}
+
+	// Every free block goes, the records are rebuilt from the allocations alone.
+	memset(m_freeLists, 0xff, sizeof(m_freeLists));
+	m_firstLevelBits = 0;
+	memset(m_secondLevelBits, 0, sizeof(m_secondLevelBits));
+	m_freeBlockCount = 0;
+	m_unusedBlocks.clear();
+	for (i = m_blocks.size(); i-- > 0; )
+	{
+		if (!m_blocks[i].live || m_blocks[i].free)
+		{
+			m_blocks[i].live = false;
+			m_unusedBlocks.push_back((unsigned int)i);
+		}
+	}
+
+	offset = 0;
+	previous = TLSF_HANDLE_NONE;
+	for (i = order.size(); i-- > 0; )
+	{
+		block = order[i];
+		if (m_blocks[block].offset != offset)
+		{
+			move.handle = block;
+			move.oldOffset = m_blocks[block].offset;
+			move.newOffset = offset;
+			move.size = m_blocks[block].size;
+			out_moves.push_back(move);
+			m_blocks[block].offset = offset;
+		}
+
+		m_blocks[block].previous = previous;
+		m_blocks[block].next = TLSF_HANDLE_NONE;
+		if (previous != TLSF_HANDLE_NONE)
+		{
+			m_blocks[previous].next = block;
+		}
+		previous = block;
+		offset += m_blocks[block].size;
+	}
+
+	m_lastBlock = previous;
+	if (offset < m_capacity)
+	{
+		block = NewBlock();
+		m_blocks[block].offset = offset;
+		m_blocks[block].size = m_capacity - offset;
+		m_blocks[block].previous = previous;
+		m_blocks[block].next = TLSF_HANDLE_NONE;
+		if (previous != TLSF_HANDLE_NONE)
+		{
+			m_blocks[previous].next = block;
+		}
+		m_lastBlock = block;
+		InsertFree(block);
+	}
+
+	return;
+}
+
+
+unsigned int TlsfAllocatorClass::GetOffset(unsigned int handle)
+{
+	return m_blocks[handle].offset;
+}
+
+
+unsigned int TlsfAllocatorClass::GetSize(unsigned int handle)
+{
+	return m_blocks[handle].size;
+}
+
+
+unsigned int TlsfAllocatorClass::GetCapacity()
+{
+	return m_capacity;
+}
+
+// IsPacked tells whether Defragment would move nothing, with no free room in front of an allocation.
+bool TlsfAllocatorClass::IsPacked()
+{
+	return m_freeBlockCount == 0 || (m_freeBlockCount == 1 && m_blocks[m_lastBlock].free);
+}
+
+// GetStats counts the allocations and free space. The largest free block is in the highest list that is not empty, only that list
+// is walked to find it.
+TlsfAllocatorClass::StatsType TlsfAllocatorClass::GetStats()
+{
+	StatsType stats;
+	unsigned int firstLevel, secondLevel, block;
+
+
+	stats.capacity = m_capacity;
+	stats.usedUnits = m_usedUnits;
+	stats.freeUnits = m_capacity - m_usedUnits;
+	stats.allocationCount = m_allocationCount;
+	stats.freeBlockCount = m_freeBlockCount;
+	stats.largestFree = 0;
+	if (m_firstLevelBits != 0)
+	{
+		firstLevel = 31 - std::countl_zero(m_firstLevelBits);
+		secondLevel = 31 - std::countl_zero(m_secondLevelBits[firstLevel]);
+		for (block = m_freeLists[firstLevel][secondLevel]; block != TLSF_HANDLE_NONE; block = m_blocks[block].nextFree)
+		{
+			if (m_blocks[block].size > stats.largestFree)
+			{
+				stats.largestFree = m_blocks[block].size;
+			}
+		}
+	}
+
+	return stats;
+}
+
+// MapSize gives the list a block of the size belongs in. Sizes below SECOND_LEVEL_COUNT have a list each in the first level, every
+// larger power of two range [2^n, 2^(n+1)) is a first level split into SECOND_LEVEL_COUNT lists of equal width.
+void TlsfAllocatorClass::MapSize(unsigned int size, OUT unsigned int& firstLevel, OUT unsigned int& secondLevel)
+{
+	unsigned int power;
+
+
+	if (size < SECOND_LEVEL_COUNT)
+	{
+		firstLevel = 0;
+		secondLevel = size;
+		return;
+	}
+
+	power = (unsigned int)std::bit_width(size) - 1;
+	firstLevel = power - TLSF_SECOND_LEVEL_BITS + 1;
+	secondLevel = (size >> (power - TLSF_SECOND_LEVEL_BITS)) - SECOND_LEVEL_COUNT;
+
+	return;
+}
+
+// FindFree returns a free block of at least size units. The size is rounded up to the start of the next list first, so that any
+// block of the list it maps to is big enough, and the bit masks lead to the first list at or above it with a block in it.
+unsigned int TlsfAllocatorClass::FindFree(unsigned int size)
+{
+	unsigned int firstLevel, secondLevel, round;
+	uint32_t bits;
+
+
+	if (size >= SECOND_LEVEL_COUNT)
+	{
+		round = (1u << (std::bit_width(size) - 1 - TLSF_SECOND_LEVEL_BITS)) - 1;
+		if (size > UINT_MAX - round)
+		{
+			return TLSF_HANDLE_NONE;
+		}
+		size += round;
+	}
+
+	MapSize(size, firstLevel, secondLevel);
+
+	bits = m_secondLevelBits[firstLevel] & (~0u << secondLevel);
+	if (bits == 0)
+	{
+		if (firstLevel + 1 >= FIRST_LEVEL_COUNT)
+		{
+			return TLSF_HANDLE_NONE;
+		}
+
+		bits = m_firstLevelBits & (~0u << (firstLevel + 1));
+		if (bits == 0)
+		{
+			return TLSF_HANDLE_NONE;
+		}
+
+		firstLevel = std::countr_zero(bits);
+		bits = m_secondLevelBits[firstLevel];
+	}
+	secondLevel = std::countr_zero(bits);
+
+	return m_freeLists[firstLevel][secondLevel];
+}
+
+
+void TlsfAllocatorClass::InsertFree(unsigned int block)
+{
+	unsigned int firstLevel, secondLevel, head;
+
+
+	MapSize(m_blocks[block].size, firstLevel, secondLevel);
+
+	head = m_freeLists[firstLevel][secondLevel];
+	m_blocks[block].free = true;
+	m_blocks[block].previousFree = TLSF_HANDLE_NONE;
+	m_blocks[block].nextFree = head;
+	if (head != TLSF_HANDLE_NONE)
+	{
+		m_blocks[head].previousFree = block;
+	}
+	m_freeLists[firstLevel][secondLevel] = block;
+
+	m_firstLevelBits |= 1u << firstLevel;
+	m_secondLevelBits[firstLevel] |= 1u << secondLevel;
+	m_freeBlockCount++;
+
+	return;
+}
+
+
+void TlsfAllocatorClass::RemoveFree(unsigned int block)
+{
+	unsigned int firstLevel, secondLevel, previous, next;
+
+
+	MapSize(m_blocks[block].size, firstLevel, secondLevel);
+
+	previous = m_blocks[block].previousFree;
+	next = m_blocks[block].nextFree;
+	if (previous != TLSF_HANDLE_NONE)
+	{
+		m_blocks[previous].nextFree = next;
+	}
+	else
+	{
+		m_freeLists[firstLevel][secondLevel] = next;
+	}
+	if (next != TLSF_HANDLE_NONE)
+	{
+		m_blocks[next].previousFree = previous;
+	}
+
+	// Clear the bits of a list that became empty, and of its first level if that was its last list.
+	if (m_freeLists[firstLevel][secondLevel] == TLSF_HANDLE_NONE)
+	{
+		m_secondLevelBits[firstLevel] &= ~(1u << secondLevel);
+		if (m_secondLevelBits[firstLevel] == 0)
+		{
+			m_firstLevelBits &= ~(1u << firstLevel);
+		}
+	}
+
+	m_blocks[block].free = false;
+	m_freeBlockCount--;
+
+	return;
+}
+
+// NewBlock takes a record from the unused ones, or adds one. Records are reused so the handles stay small.
+unsigned int TlsfAllocatorClass::NewBlock()
+{
+	unsigned int block;
+
+
+	if (!m_unusedBlocks.empty())
+	{
+		block = m_unusedBlocks.back();
+		m_unusedBlocks.pop_back();
+	}
+	else
+	{
+		block = (unsigned int)m_blocks.size();
+		m_blocks.emplace_back();
+	}
+
+	memset(&m_blocks[block], 0, sizeof(BlockType));
+	m_blocks[block].live = true;
+
+	return block;
+}
+
+
+void TlsfAllocatorClass::ReleaseBlock(unsigned int block)
+{
+	m_blocks[block].live = false;
+	m_unusedBlocks.push_back(block);
+
+	return;
+}
@@ -0,0 +1,108 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: tlsfallocatorclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _TLSFALLOCATORCLASS_H_
+#define _TLSFALLOCATORCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <cstdint>
+#include <vector>
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "meshtypes.h"
+
+
+/////////////
+// GLOBALS //
+/////////////
+// Every power of two range of block sizes is split into this many free lists, 1 << TLSF_SECOND_LEVEL_BITS.
+const unsigned int TLSF_SECOND_LEVEL_BITS = 4;
+// What Allocate returns in place of a handle when it fails.
+const unsigned int TLSF_HANDLE_NONE = 0xffffffff;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: TlsfAllocatorClass
+////////////////////////////////////////////////////////////////////////////////
+// The TlsfAllocatorClass hands out ranges of a block of units it never touches, such as the vertices of a vertex buffer or the
+// indices of an index buffer, with a two level segregated fit allocator. Free blocks are kept in lists by the power of two of their
+// size and a finer split of that range, with a bit for every list that is not empty, so Allocate and Free take the same few steps
+// whatever the number of blocks. Neighbouring free blocks are merged as soon as one is freed.
+// The block records live in arrays of their own and a range is named by a handle that stays the same when Defragment moves it.
+class TlsfAllocatorClass
+{
+public:
+	// A range Defragment moved, so the caller can copy its contents from the old offset to the new one.
+	struct MoveType
+	{
+		unsigned int handle;
+		unsigned int oldOffset, newOffset, size;
+	};
+
+	struct StatsType
+	{
+		unsigned int capacity;
+		unsigned int usedUnits, freeUnits, largestFree;
+		unsigned int allocationCount, freeBlockCount;
+	};
+
+public:
+	TlsfAllocatorClass();
+	TlsfAllocatorClass(const TlsfAllocatorClass&);
+	~TlsfAllocatorClass();
+
+	bool Initialize(unsigned int capacity);
+	void Shutdown();
+
+	unsigned int Allocate(unsigned int size);
+	void Free(unsigned int handle);
+	void Grow(unsigned int capacity);
+	void Defragment(OUT std::vector<MoveType>& out_moves);
+
+	unsigned int GetOffset(unsigned int handle);
+	unsigned int GetSize(unsigned int handle);
+	unsigned int GetCapacity();
+	bool IsPacked();
+	StatsType GetStats();
+
+private:
+	struct BlockType
+	{
+		unsigned int offset, size;
+		// The blocks before and after this one in memory, and in its free list while it is free.
+		unsigned int previous, next;
+		unsigned int previousFree, nextFree;
+		// Whether the range is free, and whether the record describes a range at all or waits in m_unusedBlocks.
+		bool free, live;
+	};
+
+	void MapSize(unsigned int size, OUT unsigned int& firstLevel, OUT unsigned int& secondLevel);
+	unsigned int FindFree(unsigned int size);
+	void InsertFree(unsigned int block);
+	void RemoveFree(unsigned int block);
+	unsigned int NewBlock();
+	void ReleaseBlock(unsigned int block);
+
+private:
+	static const unsigned int FIRST_LEVEL_COUNT = 32;
+	static const unsigned int SECOND_LEVEL_COUNT = 1 << TLSF_SECOND_LEVEL_BITS;
+
+	unsigned int m_capacity;
+	std::vector<BlockType> m_blocks;
+	std::vector<unsigned int> m_unusedBlocks;
+	unsigned int m_lastBlock;
+
+	// The head of every free list, and a bit for every list that has a block in it and every first level with such a list.
+	unsigned int m_freeLists[FIRST_LEVEL_COUNT][SECOND_LEVEL_COUNT];
+	uint32_t m_firstLevelBits;
+	uint32_t m_secondLevelBits[FIRST_LEVEL_COUNT];
+
+	unsigned int m_usedUnits, m_allocationCount, m_freeBlockCount;
+};
+
+#endif
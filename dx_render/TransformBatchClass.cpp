@@ -0,0 +1,64 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: transformbatchclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "transformbatchclass.h"
+
+
+TransformBatchClass::TransformBatchClass()
+{
+	XMStoreFloat4x4(&m_view, XMMatrixIdentity());
+	XMStoreFloat4x4(&m_projection, XMMatrixIdentity());
+	XMStoreFloat4x4(&m_viewProjection, XMMatrixIdentity());
+}
+
+
+TransformBatchClass::TransformBatchClass(const TransformBatchClass& other)
+{
+}
+
+
+TransformBatchClass::~TransformBatchClass()
+{
+}
+
+// SetViewProjection takes the camera matrices of the frame, every object transformed after it is seen through them.
+void TransformBatchClass::SetViewProjection(XMMATRIX viewMatrix, XMMATRIX projectionMatrix)
+{
+	XMStoreFloat4x4(&m_view, viewMatrix);
+	XMStoreFloat4x4(&m_projection, projectionMatrix);
+	XMStoreFloat4x4(&m_viewProjection, XMMatrixMultiply(viewMatrix, projectionMatrix));
+
+	return;
+}
+
+// GetFrameConstants returns the camera matrices transposed for the frame constant buffer.
+TransformBatchClass::FrameConstantsType TransformBatchClass::GetFrameConstants()
+{
+	FrameConstantsType constants;
+
+
+	constants.view = XMMatrixTranspose(XMLoadFloat4x4(&m_view));
+	constants.projection = XMMatrixTranspose(XMLoadFloat4x4(&m_projection));
+	constants.viewProjection = XMMatrixTranspose(XMLoadFloat4x4(&m_viewProjection));
+
+	return constants;
+}
+
+// Transform fills in the constants of count objects from their world matrices. The view-projection matrix is loaded once for the
+// whole batch and every object costs one matrix multiply and two transposes.
+void TransformBatchClass::Transform(const XMMATRIX* worldMatrices, unsigned int count, OUT ObjectConstantsType* constants)
+{
+	XMMATRIX viewProjection, world;
+	unsigned int i;
+
+
+	viewProjection = XMLoadFloat4x4(&m_viewProjection);
+	for (i = 0; i < count; i++)
+	{
+		world = worldMatrices[i];
+		constants[i].worldViewProjection = XMMatrixTranspose(XMMatrixMultiply(world, viewProjection));
+		constants[i].world = XMMatrixTranspose(world);
+	}
+
+	return;
+}
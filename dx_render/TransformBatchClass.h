@@ -0,0 +1,51 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: transformbatchclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _TRANSFORMBATCHCLASS_H_
+#define _TRANSFORMBATCHCLASS_H_
+
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "meshtypes.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: TransformBatchClass
+////////////////////////////////////////////////////////////////////////////////
+// The TransformBatchClass works out the shader constants of a frame and of the objects drawn in it. The camera matrices are set
+// once per frame, then the constants of any number of objects are computed in one pass, so the view-projection matrix stays in
+// registers and the vertex shader gets a world-view-projection matrix it applies with a single multiply.
+// Both constant types are stored transposed, the way HLSL reads a matrix out of a constant buffer.
+class TransformBatchClass
+{
+public:
+	struct FrameConstantsType
+	{
+		XMMATRIX view;
+		XMMATRIX projection;
+		XMMATRIX viewProjection;
+	};
+
+	struct ObjectConstantsType
+	{
+		XMMATRIX worldViewProjection;
+		XMMATRIX world;
+	};
+
+public:
+	TransformBatchClass();
+	TransformBatchClass(const TransformBatchClass&);
+	~TransformBatchClass();
+
+	void SetViewProjection(XMMATRIX viewMatrix, XMMATRIX projectionMatrix);
+	FrameConstantsType GetFrameConstants();
+
+	void Transform(const XMMATRIX* worldMatrices, unsigned int count, OUT ObjectConstantsType* constants);
+
+private:
+	XMFLOAT4X4 m_view, m_projection, m_viewProjection;
+};
+
+#endif
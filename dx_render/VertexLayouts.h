@@ -0,0 +1,377 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: vertexlayouts.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _VERTEXLAYOUTS_H_
+#define _VERTEXLAYOUTS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <dxgiformat.h>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "meshtypes.h"
+#include "meshcompressionclass.h"
+
+// A vertex layout is described once, at compile time, as a list of elements: which attribute each is, in which format and in which
+// vertex buffer slot. The offsets and strides, the input element descriptions and a packer that writes VertexType vertices in that
+// layout are all generated from the list, so they can not drift apart, and a layout that does not match the struct it stands for
+// fails to compile. Every layout gets its own packer with the attribute encoders inlined in order, there is no per vertex switch
+// on the format. The header has no Direct3D dependency beyond the DXGI_FORMAT enum, the mesh classes pack vertices with it too.
+
+
+/////////////
+// GLOBALS //
+/////////////
+// The vertex buffer slots a layout can spread its elements over.
+const unsigned int VERTEX_LAYOUT_MAX_SLOTS = 2;
+// The vertex buffer slot the instance stream of an instanced draw is bound to, past the slots of every vertex layout.
+const unsigned int INSTANCE_VERTEX_SLOT = 3;
+
+
+//////////////
+// TYPEDEFS //
+//////////////
+// What the attribute packers need besides the vertex: the compression helpers and the grid quantized positions are snapped to, as
+// the bounds minimum and the inverse of the extent, zero for a flat axis.
+struct VertexPackContextType
+{
+	MeshCompressionClass* compression;
+	float boundsMin[3];
+	float invExtent[3];
+};
+
+// One element of a layout as an input layout needs it. An element of a per instance slot steps once per instance instead of once per
+// vertex, the semantic index tells apart the elements of one semantic, such as the rows of a matrix.
+struct VertexElementDescType
+{
+	const char* semantic;
+	DXGI_FORMAT format;
+	unsigned int slot, offset;
+	unsigned int semanticIndex;
+	bool perInstance;
+};
+
+
+// GetFormatSize returns the bytes one element of a vertex format takes, zero for formats no layout uses.
+constexpr unsigned int GetFormatSize(DXGI_FORMAT format)
+{
+	switch (format)
+	{
+	case DXGI_FORMAT_R32G32B32A32_FLOAT:
+		return 16;
+	case DXGI_FORMAT_R32G32B32_FLOAT:
+		return 12;
+	case DXGI_FORMAT_R32G32_FLOAT:
+	case DXGI_FORMAT_R16G16B16A16_UNORM:
+		return 8;
+	case DXGI_FORMAT_R16G16_FLOAT:
+	case DXGI_FORMAT_R16G16_SNORM:
+	case DXGI_FORMAT_R10G10B10A2_UNORM:
+		return 4;
+	default:
+		return 0;
+	}
+}
+
+
+////////////////
+// ATTRIBUTES //
+////////////////
+// Each attribute names the semantic the shader reads it by and the format it is stored in, and packs it from a VertexType.
+// The size of what Pack writes is the size of the format.
+struct PositionFloat3Attribute
+{
+	static constexpr const char* semantic = "POSITION";
+	static constexpr DXGI_FORMAT format = DXGI_FORMAT_R32G32B32_FLOAT;
+
+	static void Pack(const VertexType& vertex, const VertexPackContextType&, uint8_t* out)
+	{
+		memcpy(out, &vertex.position, sizeof(vertex.position));
+	}
+};
+
+// Positions as 16 bit UNORM on the grid of the context, with a w of 1 so the shader sees a regular point. Positions outside the grid
+// are clamped to it.
+struct PositionUnorm16Attribute
+{
+	static constexpr const char* semantic = "POSITION";
+	static constexpr DXGI_FORMAT format = DXGI_FORMAT_R16G16B16A16_UNORM;
+
+	static void Pack(const VertexType& vertex, const VertexPackContextType& context, uint8_t* out)
+	{
+		const float* position = &vertex.position.x;
+		uint16_t packed[4];
+		float unorm;
+		int k;
+
+
+		// Clamped with plain compares, which compile to single min and max instructions, a NaN ends up at 1.
+		for (k = 0; k < 3; k++)
+		{
+			unorm = (position[k] - context.boundsMin[k]) * context.invExtent[k];
+			unorm = unorm < 1.0f ? unorm : 1.0f;
+			unorm = unorm > 0.0f ? unorm : 0.0f;
+			packed[k] = (uint16_t)lroundf(unorm * 65535.0f);
+		}
+		packed[3] = 65535;
+
+		memcpy(out, packed, sizeof(packed));
+	}
+};
+
+struct TextureFloat2Attribute
+{
+	static constexpr const char* semantic = "TEXCOORD";
+	static constexpr DXGI_FORMAT format = DXGI_FORMAT_R32G32_FLOAT;
+
+	static void Pack(const VertexType& vertex, const VertexPackContextType&, uint8_t* out)
+	{
+		memcpy(out, &vertex.texture, sizeof(vertex.texture));
+	}
+};
+
+struct TextureHalf2Attribute
+{
+	static constexpr const char* semantic = "TEXCOORD";
+	static constexpr DXGI_FORMAT format = DXGI_FORMAT_R16G16_FLOAT;
+
+	static void Pack(const VertexType& vertex, const VertexPackContextType& context, uint8_t* out)
+	{
+		uint16_t packed[2];
+
+
+		packed[0] = context.compression->FloatToHalf(vertex.texture.x);
+		packed[1] = context.compression->FloatToHalf(vertex.texture.y);
+
+		memcpy(out, packed, sizeof(packed));
+	}
+};
+
+struct NormalFloat3Attribute
+{
+	static constexpr const char* semantic = "NORMAL";
+	static constexpr DXGI_FORMAT format = DXGI_FORMAT_R32G32B32_FLOAT;
+
+	static void Pack(const VertexType& vertex, const VertexPackContextType&, uint8_t* out)
+	{
+		memcpy(out, &vertex.normal, sizeof(vertex.normal));
+	}
+};
+
+struct NormalOctahedralAttribute
+{
+	static constexpr const char* semantic = "NORMAL";
+	static constexpr DXGI_FORMAT format = DXGI_FORMAT_R16G16_SNORM;
+
+	static void Pack(const VertexType& vertex, const VertexPackContextType& context, uint8_t* out)
+	{
+		uint32_t packed;
+
+
+		packed = context.compression->EncodeOctahedral(vertex.normal);
+		memcpy(out, &packed, sizeof(packed));
+	}
+};
+
+struct NormalPacked1010102Attribute
+{
+	static constexpr const char* semantic = "NORMAL";
+	static constexpr DXGI_FORMAT format = DXGI_FORMAT_R10G10B10A2_UNORM;
+
+	static void Pack(const VertexType& vertex, const VertexPackContextType& context, uint8_t* out)
+	{
+		uint32_t packed;
+
+
+		packed = context.compression->EncodePacked1010102(vertex.normal);
+		memcpy(out, &packed, sizeof(packed));
+	}
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: VertexLayout
+////////////////////////////////////////////////////////////////////////////////
+// An element of a layout is an attribute in a slot. Elements of one slot are packed in the order they are listed, each at the next
+// offset, so a slot is exactly the sum of its formats with no padding.
+template <unsigned int Slot, typename Attribute>
+struct VertexElement
+{
+	static_assert(Slot < VERTEX_LAYOUT_MAX_SLOTS, "A vertex element is in a slot past VERTEX_LAYOUT_MAX_SLOTS");
+	static_assert(GetFormatSize(Attribute::format) > 0, "A vertex element has a format GetFormatSize does not know");
+	// Every format is a multiple of 4 bytes, so every offset is on the 4 byte boundary the input assembler needs.
+	static_assert(GetFormatSize(Attribute::format) % 4 == 0, "A vertex element has a format that would misalign the ones after it");
+
+	static constexpr unsigned int slot = Slot;
+	typedef Attribute AttributeType;
+};
+
+template <typename... Elements>
+class VertexLayout
+{
+public:
+	static constexpr unsigned int elementCount = sizeof...(Elements);
+
+	// GetOffset returns where in its slot an element starts, GetStride how many bytes one vertex takes in a slot.
+	static constexpr unsigned int GetOffset(unsigned int element)
+	{
+		unsigned int offset, i;
+
+
+		offset = 0;
+		for (i = 0; i < element; i++)
+		{
+			if (m_slots[i] == m_slots[element])
+			{
+				offset += m_sizes[i];
+			}
+		}
+
+		return offset;
+	}
+
+	static constexpr unsigned int GetStride(unsigned int slot)
+	{
+		unsigned int stride, i;
+
+
+		stride = 0;
+		for (i = 0; i < elementCount; i++)
+		{
+			if (m_slots[i] == slot)
+			{
+				stride += m_sizes[i];
+			}
+		}
+
+		return stride;
+	}
+
+	static constexpr unsigned int GetSlotCount()
+	{
+		unsigned int slotCount, i;
+
+
+		slotCount = 0;
+		for (i = 0; i < elementCount; i++)
+		{
+			if (m_slots[i] + 1 > slotCount)
+			{
+				slotCount = m_slots[i] + 1;
+			}
+		}
+
+		return slotCount;
+	}
+
+	static constexpr VertexElementDescType GetElement(unsigned int element)
+	{
+		return VertexElementDescType{ m_semantics[element], m_formats[element], m_slots[element], GetOffset(element), 0, false };
+	}
+
+	// Pack writes vertexCount vertices into the streams of the layout, one pointer per slot, each with room for vertexCount strides.
+	static void Pack(const VertexType* verts, unsigned int vertexCount, const VertexPackContextType& context, uint8_t* const* streams)
+	{
+		uint8_t* out[VERTEX_LAYOUT_MAX_SLOTS];
+		unsigned int i, slot;
+
+
+		for (slot = 0; slot < GetSlotCount(); slot++)
+		{
+			out[slot] = streams[slot];
+		}
+
+		for (i = 0; i < vertexCount; i++)
+		{
+			PackVertex(verts[i], context, out, std::make_index_sequence<elementCount>());
+			for (slot = 0; slot < GetSlotCount(); slot++)
+			{
+				out[slot] += GetStride(slot);
+			}
+		}
+	}
+
+private:
+	template <size_t... Element>
+	static void PackVertex(const VertexType& vertex, const VertexPackContextType& context, uint8_t* const* out, std::index_sequence<Element...>)
+	{
+		// The offsets are template arguments so they are constants in the generated code, not loops.
+		(Elements::AttributeType::Pack(vertex, context, out[m_slots[Element]] + std::integral_constant<unsigned int, GetOffset(Element)>::value), ...);
+	}
+
+private:
+	static constexpr unsigned int m_slots[] = { Elements::slot... };
+	static constexpr unsigned int m_sizes[] = { GetFormatSize(Elements::AttributeType::format)... };
+	static constexpr DXGI_FORMAT m_formats[] = { Elements::AttributeType::format... };
+	static constexpr const char* m_semantics[] = { Elements::AttributeType::semantic... };
+
+	static_assert(elementCount > 0, "A vertex layout needs at least one element");
+};
+
+
+/////////////
+// LAYOUTS //
+/////////////
+// The layout of every VertexFormatType, interleaved in slot 0 or split into positions in slot 0 and the rest in slot 1.
+typedef VertexLayout<VertexElement<0, PositionFloat3Attribute>, VertexElement<0, TextureFloat2Attribute>,
+	VertexElement<0, NormalFloat3Attribute>> FullVertexLayoutType;
+typedef VertexLayout<VertexElement<0, PositionUnorm16Attribute>, VertexElement<0, TextureHalf2Attribute>,
+	VertexElement<0, NormalOctahedralAttribute>> CompactOctahedralVertexLayoutType;
+typedef VertexLayout<VertexElement<0, PositionUnorm16Attribute>, VertexElement<0, TextureHalf2Attribute>,
+	VertexElement<0, NormalPacked1010102Attribute>> CompactPackedVertexLayoutType;
+
+typedef VertexLayout<VertexElement<0, PositionFloat3Attribute>, VertexElement<1, TextureFloat2Attribute>,
+	VertexElement<1, NormalFloat3Attribute>> FullSplitVertexLayoutType;
+typedef VertexLayout<VertexElement<0, PositionUnorm16Attribute>, VertexElement<1, TextureHalf2Attribute>,
+	VertexElement<1, NormalOctahedralAttribute>> CompactOctahedralSplitVertexLayoutType;
+typedef VertexLayout<VertexElement<0, PositionUnorm16Attribute>, VertexElement<1, TextureHalf2Attribute>,
+	VertexElement<1, NormalPacked1010102Attribute>> CompactPackedSplitVertexLayoutType;
+
+// An instance of an instanced draw is its world matrix, transposed like the matrices of the constant buffers and without the last
+// row, which is always 0, 0, 0, 1. The shader reads the rows as WORLD0 to WORLD2 and dots each with the position.
+struct InstanceType
+{
+	float rows[3][4];
+};
+
+const VertexElementDescType INSTANCE_VERTEX_LAYOUT[] =
+{
+	{ "WORLD", DXGI_FORMAT_R32G32B32A32_FLOAT, INSTANCE_VERTEX_SLOT, 0, 0, true },
+	{ "WORLD", DXGI_FORMAT_R32G32B32A32_FLOAT, INSTANCE_VERTEX_SLOT, 16, 1, true },
+	{ "WORLD", DXGI_FORMAT_R32G32B32A32_FLOAT, INSTANCE_VERTEX_SLOT, 32, 2, true }
+};
+const unsigned int INSTANCE_VERTEX_ELEMENT_COUNT = sizeof(INSTANCE_VERTEX_LAYOUT) / sizeof(INSTANCE_VERTEX_LAYOUT[0]);
+
+static_assert(sizeof(InstanceType) == 48, "InstanceType is not the three rows INSTANCE_VERTEX_LAYOUT reads");
+
+// The interleaved layouts are the structs the CPU side keeps vertices in, member for member.
+static_assert(FullVertexLayoutType::GetStride(0) == sizeof(VertexType) && FullVertexLayoutType::GetOffset(1) == offsetof(VertexType, texture) &&
+	FullVertexLayoutType::GetOffset(2) == offsetof(VertexType, normal), "FullVertexLayoutType does not match VertexType");
+static_assert(CompactOctahedralVertexLayoutType::GetStride(0) == sizeof(CompactVertexType) &&
+	CompactOctahedralVertexLayoutType::GetOffset(1) == offsetof(CompactVertexType, texture) &&
+	CompactOctahedralVertexLayoutType::GetOffset(2) == offsetof(CompactVertexType, normal), "CompactOctahedralVertexLayoutType does not match CompactVertexType");
+static_assert(CompactPackedVertexLayoutType::GetStride(0) == sizeof(CompactVertexType) &&
+	CompactPackedVertexLayoutType::GetOffset(1) == offsetof(CompactVertexType, texture) &&
+	CompactPackedVertexLayoutType::GetOffset(2) == offsetof(CompactVertexType, normal), "CompactPackedVertexLayoutType does not match CompactVertexType");
+
+// A split layout is its interleaved layout cut after the position, which is what lets MeshCompressionClass::SplitStreams cut the bytes.
+static_assert(FullSplitVertexLayoutType::GetStride(0) == FullVertexLayoutType::GetOffset(1) &&
+	FullSplitVertexLayoutType::GetStride(1) == sizeof(VertexType) - FullVertexLayoutType::GetOffset(1), "FullSplitVertexLayoutType is not FullVertexLayoutType cut after the position");
+static_assert(CompactOctahedralSplitVertexLayoutType::GetStride(0) == CompactOctahedralVertexLayoutType::GetOffset(1) &&
+	CompactOctahedralSplitVertexLayoutType::GetStride(1) == sizeof(CompactVertexType) - CompactOctahedralVertexLayoutType::GetOffset(1),
+	"CompactOctahedralSplitVertexLayoutType is not CompactOctahedralVertexLayoutType cut after the position");
+static_assert(CompactPackedSplitVertexLayoutType::GetStride(0) == CompactPackedVertexLayoutType::GetOffset(1) &&
+	CompactPackedSplitVertexLayoutType::GetStride(1) == sizeof(CompactVertexType) - CompactPackedVertexLayoutType::GetOffset(1),
+	"CompactPackedSplitVertexLayoutType is not CompactPackedVertexLayoutType cut after the position");
+
+#endif
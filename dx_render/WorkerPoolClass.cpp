@@ -0,0 +1,138 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: workerpoolclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "workerpoolclass.h"
+
+
+WorkerPoolClass::WorkerPoolClass()
+{
+	m_job = 0;
+	m_partCount = 0;
+	m_pending = 0;
+	m_generation = 0;
+	m_stop = false;
+}
+
+
+WorkerPoolClass::WorkerPoolClass(const WorkerPoolClass& other)
+{
+}
+
+
+WorkerPoolClass::~WorkerPoolClass()
+{
+}
+
+// Initialize starts threadCount threads, which wait for Run. The thread that calls Run works too, so a job can have one part more.
+bool WorkerPoolClass::Initialize(unsigned int threadCount)
+{
+	unsigned int i;
+
+
+	m_stop = false;
+	for (i = 0; i < threadCount; i++)
+	{
+		m_threads.emplace_back(&WorkerPoolClass::Work, this, i + 1);
+	}
+
+	return true;
+}
+
+
+void WorkerPoolClass::Shutdown()
+{
+	size_t i;
+
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_start.notify_all();
+
+	for (i = 0; i < m_threads.size(); i++)
+	{
+		m_threads[i].join();
+	}
+	m_threads.clear();
+
+	return;
+}
+
+// Run calls job with every part from 0 to partCount - 1, part 0 on this thread and every other on a thread of the pool, and waits for
+// all of them. partCount may be at most one more than the threads of the pool.
+void WorkerPoolClass::Run(unsigned int partCount, const std::function<void(unsigned int)>& job)
+{
+	if (partCount > m_threads.size() + 1)
+	{
+		partCount = (unsigned int)m_threads.size() + 1;
+	}
+
+	if (partCount > 1)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_job = &job;
+			m_partCount = partCount;
+			m_pending = partCount - 1;
+			m_generation++;
+		}
+		m_start.notify_all();
+	}
+
+	job(0);
+
+	if (partCount > 1)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_done.wait(lock, [this] { return m_pending == 0; });
+		m_job = 0;
+	}
+
+	return;
+}
+
+
+unsigned int WorkerPoolClass::GetThreadCount()
+{
+	return (unsigned int)m_threads.size();
+}
+
+// Work is the loop of the thread that does the given part of every job that has that many parts, the others leave it waiting.
+void WorkerPoolClass::Work(unsigned int part)
+{
+	const std::function<void(unsigned int)>* job;
+	unsigned long long generation;
+
+
+	generation = 0;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_start.wait(lock, [&] { return m_stop || m_generation != generation; });
+			if (m_stop)
+			{
+				return;
+			}
+
+			generation = m_generation;
+			if (part >= m_partCount)
+			{
+				continue;
+			}
+			job = m_job;
+		}
+
+		(*job)(part);
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_pending--;
+			if (m_pending == 0)
+			{
+				m_done.notify_one();
+			}
+		}
+	}
+}
@@ -0,0 +1,53 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: workerpoolclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _WORKERPOOLCLASS_H_
+#define _WORKERPOOLCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: WorkerPoolClass
+////////////////////////////////////////////////////////////////////////////////
+// The WorkerPoolClass keeps threads waiting for work from Initialize to Shutdown, so work that is split over threads every frame
+// pays for waking them instead of for making them. Run hands a job to as many of them as it is asked for, does the first part itself
+// and returns once every part is done.
+class WorkerPoolClass
+{
+public:
+	WorkerPoolClass();
+	WorkerPoolClass(const WorkerPoolClass&);
+	~WorkerPoolClass();
+
+	bool Initialize(unsigned int threadCount);
+	void Shutdown();
+
+	void Run(unsigned int partCount, const std::function<void(unsigned int)>& job);
+
+	unsigned int GetThreadCount();
+
+private:
+	void Work(unsigned int part);
+
+private:
+	std::vector<std::thread> m_threads;
+	std::mutex m_mutex;
+	std::condition_variable m_start, m_done;
+
+	// The job of the last Run, told apart from the one before by its generation, and how many of its parts are still running.
+	const std::function<void(unsigned int)>* m_job;
+	unsigned int m_partCount, m_pending;
+	unsigned long long m_generation;
+	bool m_stop;
+};
+
+#endif
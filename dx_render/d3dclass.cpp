@@ -15,6 +15,7 @@ D3DClass::D3DClass()
 	m_depthStencilState = 0;
 	m_depthStencilView = 0;
 	m_rasterState = 0;
+	ZeroMemory(&m_viewport, sizeof(m_viewport));
 }
 
 
@@ -424,8 +425,9 @@ bool D3DClass::Initialize(int screenWidth, int screenHeight, bool vsync, HWND hw
 	viewport.TopLeftX = 0.0f;
 	viewport.TopLeftY = 0.0f;
 
-	// Create the viewport.
+	// Create the viewport, and keep it for the deferred contexts that draw into the same back buffer.
 	m_deviceContext->RSSetViewports(1, &viewport);
+	m_viewport = viewport;
 
 	// Now we will create the projection matrix.
 	// The projection matrix is used to translate the 3D scene into the 2D viewport space that we previously created.
@@ -581,6 +583,18 @@ ID3D11DeviceContext* D3DClass::GetDeviceContext()
 	return m_deviceContext;
 }
 
+// SetOutputState binds the render target, depth buffer, their states and the viewport on another context, a deferred context
+// starts out without any of them.
+void D3DClass::SetOutputState(ID3D11DeviceContext* deviceContext)
+{
+	deviceContext->OMSetRenderTargets(1, &m_renderTargetView, m_depthStencilView);
+	deviceContext->OMSetDepthStencilState(m_depthStencilState, 1);
+	deviceContext->RSSetState(m_rasterState);
+	deviceContext->RSSetViewports(1, &m_viewport);
+
+	return;
+}
+
 //The next three helper functions give copies of the projection, world, and orthographic matrices to calling functions.
 // Most shaders will need these matrices for rendering so there needed to be an easy way for outside objects to get a copy of them.
 // We won't call these functions in this tutorial but I'm just explaining why they are in the code.
@@ -0,0 +1,212 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: dx_render_headless.cpp
+////////////////////////////////////////////////////////////////////////////////
+// The entry point of the headless build. It draws frames of the same scene as the window version through the null or the software
+// render device, so the frame can be run and profiled on a machine without a GPU or without Windows:
+//
+//     dx_render_headless [null|software] [frames] [width] [height] [bitmap] [progressive]
+//
+// The model and its texture are loaded from the same places as by the window version, relative to the working directory. A last
+// argument of progressive streams the model in from its .dxpm file, which the window version leaves off. The stats
+// of the device and of the frame are printed once the frames are drawn, and the software device saves its last frame when a bitmap
+// is named. The exit code is not zero when the scene does not load, a frame fails or the device found errors in the calls made to it.
+#include "graphicsclass.h"
+#include "nullrenderdeviceclass.h"
+#include "softwarerenderdeviceclass.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+
+/////////////
+// GLOBALS //
+/////////////
+const int HEADLESS_DEFAULT_FRAMES = 100;
+const int HEADLESS_DEFAULT_WIDTH = 1280;
+const int HEADLESS_DEFAULT_HEIGHT = 720;
+// The null device acts as if the GPU were this many frames behind, like a driver that queues frames.
+const unsigned int HEADLESS_GPU_LATENCY_FRAMES = 2;
+
+
+static bool DrawFrames(RenderDeviceClass* device, int frameCount, int screenWidth, int screenHeight, bool progressive)
+{
+	GraphicsClass* Graphics;
+	RenderDeviceClass::StatsType stats;
+	GraphicsClass::FrameStatsType frameStats;
+	GraphicsClass::SceneOptionsType options;
+	double seconds;
+	int i;
+	bool result;
+
+
+	Graphics = new GraphicsClass;
+	if (!Graphics)
+	{
+		return false;
+	}
+
+	options = Graphics->GetSceneOptions();
+	options.progressive = progressive;
+	Graphics->SetSceneOptions(options);
+
+	result = Graphics->Initialize(device, screenWidth, screenHeight);
+	if (!result)
+	{
+		printf("Could not initialize the scene\n");
+		Graphics->Shutdown();
+		delete Graphics;
+		return false;
+	}
+
+	// Count only the frames themselves, not the uploads of the scene.
+	device->ResetStats();
+	Graphics->ResetFrameStats();
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (i = 0; i < frameCount && result; i++)
+	{
+		result = Graphics->Frame();
+	}
+	seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	stats = device->GetStats();
+	frameStats = Graphics->GetFrameStats();
+	if (!result)
+	{
+		printf("Frame %d failed\n", i - 1);
+	}
+	else if (frameCount > 0)
+	{
+		printf("%d frames in %.3f s, %.1f us a frame: %.1f draws, %.0f indices, %.1f binds, %.1f maps and %.0f upload bytes a frame\n",
+			frameCount, seconds, seconds * 1.0e6 / frameCount, (double)stats.drawCount / frameCount, (double)stats.indexCount / frameCount,
+			(double)stats.bindCount / frameCount, (double)stats.mapCount / frameCount, (double)stats.uploadBytes / frameCount);
+	}
+
+	// The culling is only counted for a model drawn in meshlets.
+	if (result && frameCount > 0 && frameStats.lastCull.meshletCount > 0)
+	{
+		printf("Culling: LOD %d of %d, %.1f%% of triangles culled (%u frustum, %u backface of %u meshlets, %u draws), %.1f us a frame\n",
+			frameStats.lod, frameStats.lodCount, 100.0 * frameStats.trianglesCulled / (double)(frameStats.trianglesDrawn + frameStats.trianglesCulled),
+			frameStats.lastCull.frustumCulled, frameStats.lastCull.backfaceCulled, frameStats.lastCull.meshletCount, frameStats.lastCull.drawCount,
+			frameStats.cullSeconds * 1.0e6 / frameCount);
+	}
+
+	// The constant ring is only counted on a device that can bind part of a constant buffer.
+	if (result && frameStats.constantRing.capacity > 0)
+	{
+		printf("Constant ring: %u of %u KB peak, %u allocations, %u wraps, %u discards\n", frameStats.constantRing.peakBytes / 1024,
+			frameStats.constantRing.capacity / 1024, frameStats.constantRing.allocationCount, frameStats.constantRing.wrapCount,
+			frameStats.constantRing.resetCount);
+	}
+
+	if (result && frameStats.staticProps.sourceCount > 0)
+	{
+		printf("Static props: %u props in %u batches over %u cells, %u vertices and %u indices, built in %.3f s\n",
+			frameStats.staticProps.sourceCount, frameStats.staticProps.batchCount, frameStats.staticProps.cellCount,
+			frameStats.staticProps.vertexCount, frameStats.staticProps.indexCount, frameStats.staticPropSeconds);
+	}
+
+	if (result && frameCount > 0 && frameStats.instances.instanceCount > 0)
+	{
+		printf("Instances: %u of %u visible, %u of room, %u grows, %.1f KB uploaded a frame\n", frameStats.instances.visibleCount,
+			frameStats.instances.instanceCount, frameStats.instances.capacity, frameStats.instances.growCount,
+			frameStats.instances.uploadBytes / 1024.0 / frameCount);
+	}
+
+	// Only frames with enough draws for more than one thread are recorded into command lists.
+	if (result && frameStats.recordedFrameCount > 0)
+	{
+		printf("Command lists: %u of %d frames recorded on %u threads, %.1f us recording and %.1f us executing a frame\n",
+			frameStats.recordedFrameCount, frameCount, frameStats.recordThreads, frameStats.recordSeconds * 1.0e6 / frameStats.recordedFrameCount,
+			frameStats.executeSeconds * 1.0e6 / frameStats.recordedFrameCount);
+	}
+
+	Graphics->Shutdown();
+	delete Graphics;
+	Graphics = 0;
+
+	return result;
+}
+
+
+int main(int argc, char** argv)
+{
+	const char* deviceName;
+	const char* bitmapFileName;
+	int frameCount, screenWidth, screenHeight;
+	RenderDeviceClass::StatsType stats;
+	bool progressive, result;
+
+
+	progressive = argc > 1 && strcmp(argv[argc - 1], "progressive") == 0;
+	if (progressive)
+	{
+		argc--;
+	}
+
+	deviceName = argc > 1 ? argv[1] : "null";
+	frameCount = argc > 2 ? atoi(argv[2]) : HEADLESS_DEFAULT_FRAMES;
+	screenWidth = argc > 3 ? atoi(argv[3]) : HEADLESS_DEFAULT_WIDTH;
+	screenHeight = argc > 4 ? atoi(argv[4]) : HEADLESS_DEFAULT_HEIGHT;
+	bitmapFileName = argc > 5 ? argv[5] : 0;
+	if (frameCount < 0 || screenWidth <= 0 || screenHeight <= 0)
+	{
+		printf("usage: %s [null|software] [frames] [width] [height] [bitmap] [progressive]\n", argv[0]);
+		return 1;
+	}
+
+	if (strcmp(deviceName, "null") == 0)
+	{
+		NullRenderDeviceClass device;
+		RenderDeviceClass::CapsType caps;
+
+		// Act like a Direct3D 11.1 device, which is what the window version draws with wherever it can.
+		caps.constantBufferOffsetting = true;
+		caps.mapNoOverwriteOnConstantBuffers = true;
+		result = device.Initialize(caps, HEADLESS_GPU_LATENCY_FRAMES);
+		if (result)
+		{
+			result = DrawFrames(&device, frameCount, screenWidth, screenHeight, progressive);
+		}
+
+		// Shutting the device down reports the resources the scene did not release as errors.
+		device.Shutdown();
+		stats = device.GetStats();
+		if (stats.errorCount > 0)
+		{
+			printf("The null device found %u errors, the last in %s\n", stats.errorCount, device.GetLastError());
+			result = false;
+		}
+	}
+	else if (strcmp(deviceName, "software") == 0)
+	{
+		SoftwareRenderDeviceClass device;
+
+		result = device.Initialize(screenWidth, screenHeight);
+		if (result)
+		{
+			result = DrawFrames(&device, frameCount, screenWidth, screenHeight, progressive);
+			if (result && bitmapFileName && !device.SaveBitmap(bitmapFileName))
+			{
+				printf("Could not save %s\n", bitmapFileName);
+				result = false;
+			}
+		}
+
+		device.Shutdown();
+		stats = device.GetStats();
+		if (stats.errorCount > 0)
+		{
+			printf("The software device found %u errors\n", stats.errorCount);
+			result = false;
+		}
+	}
+	else
+	{
+		printf("Unknown device %s, it is null or software\n", deviceName);
+		result = false;
+	}
+
+	return result ? 0 : 1;
+}
@@ -0,0 +1,58 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: dx_render_import.cpp
+////////////////////////////////////////////////////////////////////////////////
+// The entry point of the converter for OBJ files too big to load at once. It runs the ObjStreamImportClass over the file within
+// a memory budget and leaves the .dxmesh chunks and the .dxtiles manifest next to it:
+//
+//     dx_render_import model.obj [budget MB] [weld tolerance]
+//
+// The exit code is not zero when the file can not be read or the import would need more memory than the budget.
+#include "objstreamimportclass.h"
+#include <cstdio>
+#include <cstdlib>
+
+
+/////////////
+// GLOBALS //
+/////////////
+const unsigned int IMPORT_DEFAULT_BUDGET_MB = 1024;
+
+
+int main(int argc, char** argv)
+{
+	ObjStreamImportClass importer;
+	ObjStreamImportClass::ImportStatsType stats;
+	std::vector<ObjStreamImportClass::TileType> tiles;
+	long budget;
+	float tolerance;
+	bool result;
+
+
+	budget = argc > 2 ? atol(argv[2]) : IMPORT_DEFAULT_BUDGET_MB;
+	tolerance = argc > 3 ? (float)atof(argv[3]) : 0.0f;
+	if (argc < 2 || budget <= 0 || tolerance < 0.0f)
+	{
+		printf("usage: %s model.obj [budget MB] [weld tolerance]\n", argv[0]);
+		return 1;
+	}
+
+	importer.SetMemoryBudget((size_t)budget * 1024 * 1024);
+	importer.SetWeldTolerance(tolerance);
+	importer.SetThreadCount(0);
+	result = importer.Import(argv[1], tiles);
+	stats = importer.GetStats();
+	if (!result)
+	{
+		printf("Could not import %s\n", argv[1]);
+		return 1;
+	}
+
+	printf("Imported %s into %u chunks of %u tiles: %llu triangles from %llu bytes in %.3f s parsing, %.3f s routing in %u passes and %.3f s building\n",
+		argv[1], stats.chunkCount, stats.tileCount, (unsigned long long)stats.triangleCount, (unsigned long long)stats.fileSize, stats.parseSeconds,
+		stats.routeSeconds, stats.routingPasses, stats.buildSeconds);
+	printf("The working set grew by at most %.1f MB of the %.1f MB budget\n", stats.peakMemory / (1024.0 * 1024.0),
+		stats.memoryBudget / (1024.0 * 1024.0));
+	printf("The chunks are listed in %s\n", ObjStreamImportClass::GetManifestFilename(argv[1]).c_str());
+
+	return 0;
+}
@@ -0,0 +1,68 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: benchmarkutils.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _BENCHMARKUTILS_H_
+#define _BENCHMARKUTILS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <chrono>
+#include <cstdio>
+
+
+// The benchmarks are plain programs run by hand. WriteGridObj writes the mesh most of them load, a height field of size x size quads
+// with texture coordinates and normals and faces in the v/vt/vn form, so every grid vertex is the corner of up to six triangles.
+// A grid of 1024 x 1024 quads is about two million triangles and 145 MB of text. With more than one material the quads take turns at
+// them, so every visible part of the grid is a draw of its own for each material.
+inline bool WriteGridObj(const char* filename, int size, int materialCount = 1)
+{
+	FILE* file;
+	int x, y, a, b, c, d;
+
+
+	file = fopen(filename, "wb");
+	if (!file)
+	{
+		return false;
+	}
+
+	for (y = 0; y <= size; y++)
+	{
+		for (x = 0; x <= size; x++)
+		{
+			fprintf(file, "v %.6f %.6f %.6f\n", (float)x / size, (float)((x * 31 + y * 17) % 97) / 970.0f, (float)y / size);
+			fprintf(file, "vt %.6f %.6f\n", (float)x / size, (float)y / size);
+			fprintf(file, "vn 0 1 0\n");
+		}
+	}
+
+	for (y = 0; y < size; y++)
+	{
+		for (x = 0; x < size; x++)
+		{
+			a = y * (size + 1) + x + 1;
+			b = a + 1;
+			c = a + size + 1;
+			d = c + 1;
+			if (materialCount > 1)
+			{
+				fprintf(file, "usemtl material%d\n", (y * size + x) % materialCount);
+			}
+			fprintf(file, "f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, a, c, c, c, d, d, d, b, b, b);
+		}
+	}
+
+	fclose(file);
+
+	return true;
+}
+
+// SecondsSince returns the time from start to now.
+inline double SecondsSince(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+#endif
@@ -0,0 +1,151 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: ConstantRingBenchmark.cpp
+////////////////////////////////////////////////////////////////////////////////
+// Draws frames of the same number of draws through a ConstantRingClass on the null device, for rings from a few slices to several
+// frames of them, with the GPU a fixed number of frames behind. For every ring size it prints the maps and discards a frame takes,
+// how often the ring wraps, how much of it is used at most, what a Write costs and whether the device saw a slice overwritten while
+// a draw still read it. A ring that holds the frames in flight should map once per draw and discard never.
+//
+//     constant_ring_benchmark [draws per frame] [frames] [gpu latency]
+#include "constantringclass.h"
+#include "nullrenderdeviceclass.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+
+/////////////
+// GLOBALS //
+/////////////
+const int BENCHMARK_DEFAULT_DRAWS = 1000;
+const int BENCHMARK_DEFAULT_FRAMES = 200;
+const int BENCHMARK_DEFAULT_LATENCY = 2;
+const unsigned int BENCHMARK_CONSTANT_SIZE = 64;
+const unsigned int BENCHMARK_MIN_RING_SLICES = 64;
+
+
+// RunRing draws the frames with a ring of ringSize bytes and prints a line of what it took. It fails when the scene can not be made
+// or a call fails.
+static bool RunRing(unsigned int ringSize, unsigned int drawCount, int frameCount, unsigned int gpuLatency)
+{
+	static const VertexElementDescType layout[1] = { { "POSITION", DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, 0, false } };
+	static const float vertices[9] = { 0.0f };
+	static const uint16_t indices[3] = { 0, 1, 2 };
+	NullRenderDeviceClass device;
+	RenderDeviceClass::CapsType caps;
+	RenderDeviceClass::BufferDescType bufferDesc;
+	RenderDeviceClass::ShaderDescType shaderDesc;
+	RenderDeviceClass::StatsType deviceStats;
+	RingAllocatorClass::StatsType ringStats;
+	ConstantRingClass ring;
+	unsigned int vertexBuffer, indexBuffer, shader, stride, offset, firstConstant, constantCount, d;
+	float constants[BENCHMARK_CONSTANT_SIZE / sizeof(float)];
+	double writeSeconds;
+	bool result;
+	int frame;
+
+
+	caps.constantBufferOffsetting = true;
+	caps.mapNoOverwriteOnConstantBuffers = true;
+	if (!device.Initialize(caps, gpuLatency))
+	{
+		return false;
+	}
+	device.SetRecording(false);
+
+	bufferDesc.bind = RENDER_BIND_VERTEX_BUFFER;
+	bufferDesc.usage = RENDER_USAGE_DEFAULT;
+	bufferDesc.byteWidth = sizeof(vertices);
+	result = device.CreateBuffer(bufferDesc, vertices, vertexBuffer);
+	bufferDesc.bind = RENDER_BIND_INDEX_BUFFER;
+	bufferDesc.byteWidth = sizeof(indices);
+	result = result && device.CreateBuffer(bufferDesc, indices, indexBuffer);
+	shaderDesc.vertexShaderFile = L"ring.vs";
+	shaderDesc.vertexEntryPoint = "main";
+	shaderDesc.pixelShaderFile = L"ring.ps";
+	shaderDesc.pixelEntryPoint = "main";
+	shaderDesc.layout = layout;
+	shaderDesc.elementCount = 1;
+	result = result && device.CreateShader(shaderDesc, shader);
+	result = result && ring.Initialize(&device, ringSize);
+	if (!result)
+	{
+		device.Shutdown();
+		return false;
+	}
+
+	// Only the frames count, not the uploads of the scene.
+	device.ResetStats();
+
+	stride = sizeof(float) * 3;
+	offset = 0;
+	writeSeconds = 0.0;
+	for (frame = 0; frame < frameCount && result; frame++)
+	{
+		device.BeginScene(0.0f, 0.0f, 0.0f, 1.0f);
+		ring.BeginFrame();
+		device.SetShader(shader);
+		device.SetVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
+		device.SetIndexBuffer(indexBuffer, DXGI_FORMAT_R16_UINT, 0);
+		for (d = 0; d < drawCount && result; d++)
+		{
+			constants[0] = (float)d;
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			result = ring.Write(constants, sizeof(constants), firstConstant, constantCount);
+			writeSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			ring.SetVertexShaderConstants(&device, 0, firstConstant, constantCount);
+			device.DrawIndexed(3, 0, 0);
+		}
+		ring.EndFrame();
+		device.EndScene();
+	}
+
+	deviceStats = device.GetStats();
+	ringStats = ring.GetStats();
+	if (result)
+	{
+		printf("%8u KB %10.1f %10.2f %8u %10u KB %10.1f %8u\n", ringSize / 1024, (double)deviceStats.mapCount / frameCount,
+			(double)ringStats.resetCount / frameCount, ringStats.wrapCount, ringStats.peakBytes / 1024,
+			writeSeconds * 1.0e9 / ((double)frameCount * drawCount), deviceStats.errorCount);
+	}
+
+	ring.Shutdown();
+	device.ReleaseShader(shader);
+	device.ReleaseBuffer(indexBuffer);
+	device.ReleaseBuffer(vertexBuffer);
+	device.Shutdown();
+
+	return result;
+}
+
+
+int main(int argc, char** argv)
+{
+	unsigned int ringSize, maxSize;
+	int drawCount, frameCount, latency;
+
+
+	drawCount = argc > 1 ? atoi(argv[1]) : BENCHMARK_DEFAULT_DRAWS;
+	frameCount = argc > 2 ? atoi(argv[2]) : BENCHMARK_DEFAULT_FRAMES;
+	latency = argc > 3 ? atoi(argv[3]) : BENCHMARK_DEFAULT_LATENCY;
+	if (drawCount <= 0 || frameCount <= 0 || latency < 0)
+	{
+		printf("usage: %s [draws per frame] [frames] [gpu latency]\n", argv[0]);
+		return 1;
+	}
+
+	// From a ring smaller than a frame up to one that holds more frames than the ring keeps in flight.
+	maxSize = 2 * (CONSTANT_RING_FRAMES + 1) * drawCount * CONSTANT_RING_ALIGNMENT;
+	printf("%d draws of %u bytes a frame, %d frames, the GPU %d frames behind\n", drawCount, BENCHMARK_CONSTANT_SIZE, frameCount, latency);
+	printf("%11s %10s %10s %8s %13s %10s %8s\n", "ring", "maps", "discards", "wraps", "peak", "ns/write", "errors");
+	for (ringSize = BENCHMARK_MIN_RING_SLICES * CONSTANT_RING_ALIGNMENT; ringSize <= maxSize; ringSize *= 2)
+	{
+		if (!RunRing(ringSize, (unsigned int)drawCount, frameCount, (unsigned int)latency))
+		{
+			printf("A ring of %u bytes failed\n", ringSize);
+			return 1;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,168 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: FirstFrameBenchmark.cpp
+////////////////////////////////////////////////////////////////////////////////
+// Measures the time to the first frame of the scene on the null device with a large model, from creating the graphics to the end
+// of the first Frame. The model is loaded whole, first cold, from the OBJ file with no .dxmesh next to it, and then warm, from the
+// cache, and it is streamed in progressively, first cold, building its .dxpm stream, and then warm, from the stream. For each it
+// prints the time, the best of a few runs, the indices the first frame drew and those a frame draws once the model has settled.
+//
+//     first_frame_benchmark [grid size | OBJ file] [repeats]
+//
+// The default grid of 512 x 512 quads is half a million triangles. A file that is given is loaded where it is, its cache and stream
+// are written next to it and replaced on every cold run.
+#include "graphicsclass.h"
+#include "meshcacheclass.h"
+#include "progressivemeshclass.h"
+#include "nullrenderdeviceclass.h"
+#include "BenchmarkUtils.h"
+#include <cstdlib>
+#include <filesystem>
+
+
+/////////////
+// GLOBALS //
+/////////////
+const int BENCHMARK_DEFAULT_GRID = 512;
+const int BENCHMARK_DEFAULT_REPEATS = 3;
+const int BENCHMARK_SCREEN_WIDTH = 1280;
+const int BENCHMARK_SCREEN_HEIGHT = 720;
+// How many frames the model gets to stream in before the settled frame is counted.
+const int BENCHMARK_SETTLE_FRAMES = 120;
+const char* BENCHMARK_FILE_NAME = "first_frame_benchmark.obj";
+
+
+// FirstFrame draws the scene until it has settled and returns the time to the end of the first frame, or a negative time when the
+// scene did not load or a frame failed.
+static double FirstFrame(const char* filename, bool progressive, OUT unsigned long long& firstIndices, OUT unsigned long long& settledIndices)
+{
+	NullRenderDeviceClass device;
+	RenderDeviceClass::CapsType caps;
+	GraphicsClass* Graphics;
+	GraphicsClass::SceneOptionsType options;
+	double seconds;
+	bool result;
+	int i;
+
+
+	caps.constantBufferOffsetting = true;
+	caps.mapNoOverwriteOnConstantBuffers = true;
+	if (!device.Initialize(caps, 0))
+	{
+		return -1.0;
+	}
+	device.SetRecording(false);
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	Graphics = new GraphicsClass;
+	options = Graphics->GetSceneOptions();
+	options.modelFileName = filename;
+	options.progressive = progressive;
+	Graphics->SetSceneOptions(options);
+	result = Graphics->Initialize(&device, BENCHMARK_SCREEN_WIDTH, BENCHMARK_SCREEN_HEIGHT);
+	if (result)
+	{
+		device.ResetStats();
+		result = Graphics->Frame();
+	}
+	seconds = SecondsSince(start);
+	firstIndices = device.GetStats().indexCount;
+
+	for (i = 1; i < BENCHMARK_SETTLE_FRAMES && result; i++)
+	{
+		result = Graphics->Frame();
+	}
+	device.ResetStats();
+	result = result && Graphics->Frame();
+	settledIndices = device.GetStats().indexCount;
+
+	Graphics->Shutdown();
+	delete Graphics;
+	device.Shutdown();
+
+	return result ? seconds : -1.0;
+}
+
+
+static bool RunMode(const char* label, const char* filename, bool progressive, bool cold, int repeats)
+{
+	std::error_code error;
+	unsigned long long firstIndices, settledIndices;
+	double seconds, best;
+	int i;
+
+
+	best = 0.0;
+	firstIndices = settledIndices = 0;
+	for (i = 0; i < repeats; i++)
+	{
+		// A cold whole load has neither file to start from, a cold progressive one still has the cache its stream is built from.
+		if (cold)
+		{
+			std::filesystem::remove(ProgressiveMeshClass::GetStreamFilename(filename), error);
+			if (!progressive)
+			{
+				std::filesystem::remove(MeshCacheClass::GetCacheFilename(filename), error);
+			}
+		}
+
+		seconds = FirstFrame(filename, progressive, firstIndices, settledIndices);
+		if (seconds < 0.0)
+		{
+			printf("Could not draw %s\n", filename);
+			return false;
+		}
+		best = (i == 0 || seconds < best) ? seconds : best;
+	}
+
+	printf("%-18s %.3f s to the first frame, %llu indices drawn in it, %llu once settled\n", label, best, firstIndices, settledIndices);
+
+	return true;
+}
+
+
+int main(int argc, char** argv)
+{
+	std::error_code error;
+	const char* filename;
+	char* end;
+	int size, repeats;
+	bool result;
+
+
+	// A first argument that is not a number is the OBJ file to load.
+	size = BENCHMARK_DEFAULT_GRID;
+	filename = BENCHMARK_FILE_NAME;
+	if (argc > 1)
+	{
+		size = (int)strtol(argv[1], &end, 10);
+		if (*end != '\0')
+		{
+			filename = argv[1];
+			size = 0;
+		}
+	}
+	repeats = argc > 2 ? atoi(argv[2]) : BENCHMARK_DEFAULT_REPEATS;
+	if ((filename == BENCHMARK_FILE_NAME && size <= 0) || repeats <= 0)
+	{
+		printf("usage: %s [grid size | OBJ file] [repeats]\n", argv[0]);
+		return 1;
+	}
+
+	if (size > 0 && !WriteGridObj(BENCHMARK_FILE_NAME, size))
+	{
+		printf("Could not write %s\n", BENCHMARK_FILE_NAME);
+		return 1;
+	}
+
+	result = RunMode("Whole, cold:", filename, false, true, repeats) && RunMode("Whole, warm:", filename, false, false, repeats) &&
+		RunMode("Progressive, cold:", filename, true, true, repeats) && RunMode("Progressive, warm:", filename, true, false, repeats);
+
+	if (size > 0)
+	{
+		std::filesystem::remove(MeshCacheClass::GetCacheFilename(filename), error);
+		std::filesystem::remove(ProgressiveMeshClass::GetStreamFilename(filename), error);
+		remove(BENCHMARK_FILE_NAME);
+	}
+
+	return result ? 0 : 1;
+}
@@ -0,0 +1,240 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: GltfLoadBenchmark.cpp
+////////////////////////////////////////////////////////////////////////////////
+// Writes a large generated OBJ file, or takes the one it is given, and a .glb file of the same mesh, welded, with its vertices
+// interleaved as the VertexType and 32 bit indices, so the loader can hand both out in place. It then loads each on the null device
+// the way the scene does and prints the time of each, the best of a few runs: the OBJ cold, without its .dxmesh cache, and warm,
+// from the cache, and the .glb, which has no cache. The file readers are also timed on their own, ObjParserClass::Parse against
+// GltfLoaderClass::Initialize and GetMesh.
+//
+//     gltf_load_benchmark [grid size | OBJ file] [repeats]
+//
+// The default grid of 512 x 512 quads is half a million triangles.
+#include "modelclass.h"
+#include "meshcacheclass.h"
+#include "objparserclass.h"
+#include "meshweldclass.h"
+#include "gltfloaderclass.h"
+#include "nullrenderdeviceclass.h"
+#include "BenchmarkUtils.h"
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+
+
+/////////////
+// GLOBALS //
+/////////////
+const int BENCHMARK_DEFAULT_GRID = 512;
+const int BENCHMARK_DEFAULT_REPEATS = 3;
+const float BENCHMARK_WELD_TOLERANCE = 1.0e-6f;
+const char* BENCHMARK_FILE_NAME = "gltf_load_benchmark.obj";
+const char* BENCHMARK_GLB_FILE_NAME = "gltf_load_benchmark.glb";
+
+
+// WriteGlb writes the welded mesh as one primitive whose three attribute accessors step through one interleaved buffer view.
+static bool WriteGlb(const char* filename, const std::vector<VertexType>& verts, const std::vector<uint32_t>& indices)
+{
+	std::ofstream file;
+	std::string json;
+	uint32_t header[3], chunk[2];
+	size_t vertexBytes, indexBytes;
+	char text[2048];
+
+
+	vertexBytes = verts.size() * sizeof(VertexType);
+	indexBytes = indices.size() * sizeof(uint32_t);
+	snprintf(text, sizeof(text),
+		"{\"asset\":{\"version\":\"2.0\"},\"scene\":0,\"scenes\":[{\"nodes\":[0]}],\"nodes\":[{\"mesh\":0}],"
+		"\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":0,\"TEXCOORD_0\":1,\"NORMAL\":2},\"indices\":3}]}],"
+		"\"buffers\":[{\"byteLength\":%zu}],"
+		"\"bufferViews\":[{\"buffer\":0,\"byteOffset\":0,\"byteLength\":%zu,\"byteStride\":%zu},"
+		"{\"buffer\":0,\"byteOffset\":%zu,\"byteLength\":%zu}],"
+		"\"accessors\":[{\"bufferView\":0,\"byteOffset\":0,\"componentType\":5126,\"count\":%zu,\"type\":\"VEC3\"},"
+		"{\"bufferView\":0,\"byteOffset\":%zu,\"componentType\":5126,\"count\":%zu,\"type\":\"VEC2\"},"
+		"{\"bufferView\":0,\"byteOffset\":%zu,\"componentType\":5126,\"count\":%zu,\"type\":\"VEC3\"},"
+		"{\"bufferView\":1,\"componentType\":5125,\"count\":%zu,\"type\":\"SCALAR\"}]}",
+		vertexBytes + indexBytes, vertexBytes, sizeof(VertexType), vertexBytes, indexBytes, verts.size(), offsetof(VertexType, texture),
+		verts.size(), offsetof(VertexType, normal), verts.size(), indices.size());
+	json = text;
+	while (json.size() % 4 != 0)
+	{
+		json.push_back(' ');
+	}
+
+	// The vertex and index bytes are multiples of four already, so the binary chunk needs no padding.
+	header[0] = 0x46546c67;
+	header[1] = 2;
+	header[2] = (uint32_t)(sizeof(header) + sizeof(chunk) * 2 + json.size() + vertexBytes + indexBytes);
+
+	file.open(filename, std::ios::binary | std::ios::trunc);
+	file.write((const char*)header, sizeof(header));
+	chunk[0] = (uint32_t)json.size();
+	chunk[1] = 0x4e4f534a;
+	file.write((const char*)chunk, sizeof(chunk));
+	file.write(json.data(), (std::streamsize)json.size());
+	chunk[0] = (uint32_t)(vertexBytes + indexBytes);
+	chunk[1] = 0x004e4942;
+	file.write((const char*)chunk, sizeof(chunk));
+	file.write((const char*)verts.data(), (std::streamsize)vertexBytes);
+	file.write((const char*)indices.data(), (std::streamsize)indexBytes);
+	file.close();
+
+	return (bool)file;
+}
+
+
+// LoadModel loads the model and returns how long Initialize took, or a negative time when it failed.
+static double LoadModel(const char* filename)
+{
+	NullRenderDeviceClass device;
+	RenderDeviceClass::CapsType caps;
+	ModelClass model;
+	double seconds;
+	bool result;
+
+
+	if (!device.Initialize(caps, 0))
+	{
+		return -1.0;
+	}
+	device.SetRecording(false);
+
+	model.SetProgressive(false, 0);
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	result = model.Initialize(&device, filename, L"gltf_load_benchmark.dds");
+	seconds = SecondsSince(start);
+
+	model.Shutdown();
+	device.Shutdown();
+
+	return result ? seconds : -1.0;
+}
+
+
+// ReadGlb times the .glb reader alone, mapping the file and merging its primitives into one mesh.
+static double ReadGlb(const char* filename, OUT bool& inPlace)
+{
+	GltfLoaderClass loader;
+	std::vector<GltfLoaderClass::RangeType> ranges;
+	const VertexType* verts;
+	const void* indices;
+	unsigned int vertexCount, indexCount, indexStride;
+	double seconds;
+	bool result;
+
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	result = loader.Initialize(filename) && loader.GetMesh(verts, vertexCount, indices, indexCount, indexStride, ranges);
+	seconds = SecondsSince(start);
+	inPlace = result && loader.GetStats().vertexBytesConverted == 0 && loader.GetStats().indexBytesConverted == 0;
+	loader.Shutdown();
+
+	return result ? seconds : -1.0;
+}
+
+
+// Best keeps the smaller of two times, a negative time is a failure and is kept.
+static double Best(double best, double seconds, int run)
+{
+	if (best < 0.0 || seconds < 0.0)
+	{
+		return best < 0.0 ? best : seconds;
+	}
+
+	return (run == 0 || seconds < best) ? seconds : best;
+}
+
+
+int main(int argc, char** argv)
+{
+	ObjParserClass parser;
+	ObjParserClass::ObjDataType obj;
+	MeshWeldClass weld;
+	std::vector<VertexType> verts;
+	std::vector<uint32_t> indices;
+	std::string cacheFileName;
+	std::error_code error;
+	const char* filename;
+	char* end;
+	double objCold, objWarm, glb, objParse, glbRead;
+	int size, repeats, i;
+	bool inPlace;
+
+
+	// A first argument that is not a number is the OBJ file to compare against.
+	size = BENCHMARK_DEFAULT_GRID;
+	filename = BENCHMARK_FILE_NAME;
+	if (argc > 1)
+	{
+		size = (int)strtol(argv[1], &end, 10);
+		if (*end != '\0')
+		{
+			filename = argv[1];
+			size = 0;
+		}
+	}
+	repeats = argc > 2 ? atoi(argv[2]) : BENCHMARK_DEFAULT_REPEATS;
+	if ((filename == BENCHMARK_FILE_NAME && size <= 0) || repeats <= 0)
+	{
+		printf("usage: %s [grid size | OBJ file] [repeats]\n", argv[0]);
+		return 1;
+	}
+
+	if (size > 0 && !WriteGridObj(BENCHMARK_FILE_NAME, size))
+	{
+		printf("Could not write %s\n", BENCHMARK_FILE_NAME);
+		return 1;
+	}
+
+	weld.SetTolerance(BENCHMARK_WELD_TOLERANCE);
+	weld.SetRemoveDegenerates(true);
+	if (!parser.Parse(filename, obj) || !weld.Weld(obj.positions, obj.uvs, obj.normals, obj.positionIndices, obj.uvIndices,
+		obj.normalIndices, verts, indices, nullptr) || !WriteGlb(BENCHMARK_GLB_FILE_NAME, verts, indices))
+	{
+		printf("Could not convert %s to %s\n", filename, BENCHMARK_GLB_FILE_NAME);
+		return 1;
+	}
+	cacheFileName = MeshCacheClass::GetCacheFilename(filename);
+
+	objCold = objWarm = glb = objParse = glbRead = 0.0;
+	inPlace = false;
+	for (i = 0; i < repeats; i++)
+	{
+		std::filesystem::remove(cacheFileName, error);
+		objCold = Best(objCold, LoadModel(filename), i);
+	}
+	for (i = 0; i < repeats; i++)
+	{
+		objWarm = Best(objWarm, LoadModel(filename), i);
+		glb = Best(glb, LoadModel(BENCHMARK_GLB_FILE_NAME), i);
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		objParse = Best(objParse, parser.Parse(filename, obj) ? SecondsSince(start) : -1.0, i);
+		glbRead = Best(glbRead, ReadGlb(BENCHMARK_GLB_FILE_NAME, inPlace), i);
+	}
+	if (objCold < 0.0 || objWarm < 0.0 || glb < 0.0 || objParse < 0.0 || glbRead < 0.0)
+	{
+		printf("Could not load %s or %s\n", filename, BENCHMARK_GLB_FILE_NAME);
+		return 1;
+	}
+
+	printf("%s: %zu vertices, %zu triangles, %ju bytes of OBJ, %ju bytes of cache, %ju bytes of GLB\n", filename, verts.size(),
+		indices.size() / 3, (uintmax_t)std::filesystem::file_size(filename, error), (uintmax_t)std::filesystem::file_size(cacheFileName, error),
+		(uintmax_t)std::filesystem::file_size(BENCHMARK_GLB_FILE_NAME, error));
+	printf("Model load, OBJ cold:  %.3f s\n", objCold);
+	printf("Model load, OBJ warm:  %.3f s\n", objWarm);
+	printf("Model load, GLB:       %.3f s, %.1fx faster than the cold OBJ\n", glb, objCold / glb);
+	printf("OBJ parse:             %.3f s\n", objParse);
+	printf("GLB read:              %.3f s, %s, %.1fx faster than the OBJ parse\n", glbRead, inPlace ? "in place" : "converted",
+		objParse / glbRead);
+
+	std::filesystem::remove(cacheFileName, error);
+	remove(BENCHMARK_GLB_FILE_NAME);
+	if (size > 0)
+	{
+		remove(BENCHMARK_FILE_NAME);
+	}
+
+	return 0;
+}
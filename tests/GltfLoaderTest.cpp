@@ -0,0 +1,236 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: GltfLoaderTest.cpp
+////////////////////////////////////////////////////////////////////////////////
+// Writes small .glb files and checks the primitives the loader makes of them: indices of every width read back as the integers they
+// are, mirrored nodes reverse the winding, triangle lists that do not end on a whole triangle are rejected and the merged mesh keeps
+// a range and an image for every primitive.
+#include "gltfloaderclass.h"
+#include "TestUtils.h"
+#include <cstring>
+#include <fstream>
+
+
+/////////////
+// GLOBALS //
+/////////////
+const char* GLTF_TEST_FILE_NAME = "gltf_loader_test.glb";
+const unsigned int GLTF_UNSIGNED_BYTE = 5121;
+const unsigned int GLTF_UNSIGNED_SHORT = 5123;
+const unsigned int GLTF_UNSIGNED_INT = 5125;
+const unsigned int GLTF_FLOAT = 5126;
+
+
+// WriteGlb writes the JSON and the binary chunk into a .glb container, each padded to four bytes as the format wants.
+static bool WriteGlb(const char* filename, std::string json, std::vector<unsigned char> bin)
+{
+	std::ofstream file;
+	uint32_t header[3], chunk[2];
+
+
+	while (json.size() % 4 != 0)
+	{
+		json.push_back(' ');
+	}
+	while (bin.size() % 4 != 0)
+	{
+		bin.push_back(0);
+	}
+
+	header[0] = 0x46546c67;
+	header[1] = 2;
+	header[2] = (uint32_t)(sizeof(header) + sizeof(chunk) * 2 + json.size() + bin.size());
+
+	file.open(filename, std::ios::binary | std::ios::trunc);
+	file.write((const char*)header, sizeof(header));
+	chunk[0] = (uint32_t)json.size();
+	chunk[1] = 0x4e4f534a;
+	file.write((const char*)chunk, sizeof(chunk));
+	file.write(json.data(), (std::streamsize)json.size());
+	chunk[0] = (uint32_t)bin.size();
+	chunk[1] = 0x004e4942;
+	file.write((const char*)chunk, sizeof(chunk));
+	file.write((const char*)bin.data(), (std::streamsize)bin.size());
+	file.close();
+
+	return (bool)file;
+}
+
+
+static void Append(std::vector<unsigned char>& bin, const void* data, size_t size)
+{
+	bin.insert(bin.end(), (const unsigned char*)data, (const unsigned char*)data + size);
+	while (bin.size() % 4 != 0)
+	{
+		bin.push_back(0);
+	}
+
+	return;
+}
+
+
+// WriteQuad writes the four corners of a quad and the given index list, of the given component type, as one primitive. The node
+// it hangs from is scaled by nodeScale on x, a negative scale mirrors it. An index count of zero leaves the indices out.
+static bool WriteQuad(const void* indices, unsigned int indexCount, unsigned int indexSize, unsigned int componentType, float nodeScale)
+{
+	static const float positions[12] = { 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f };
+	std::vector<unsigned char> bin;
+	size_t indexOffset;
+	char json[2048];
+
+
+	Append(bin, positions, sizeof(positions));
+	indexOffset = bin.size();
+	Append(bin, indices, (size_t)indexCount * indexSize);
+
+	snprintf(json, sizeof(json),
+		"{\"asset\":{\"version\":\"2.0\"},\"scene\":0,\"scenes\":[{\"nodes\":[0]}],\"nodes\":[{\"mesh\":0,\"scale\":[%g,1,1]}],"
+		"\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":0}%s}]}],"
+		"\"buffers\":[{\"byteLength\":%zu}],"
+		"\"bufferViews\":[{\"buffer\":0,\"byteOffset\":0,\"byteLength\":48},{\"buffer\":0,\"byteOffset\":%zu,\"byteLength\":%zu}],"
+		"\"accessors\":[{\"bufferView\":0,\"componentType\":5126,\"count\":4,\"type\":\"VEC3\"},"
+		"{\"bufferView\":1,\"componentType\":%u,\"count\":%u,\"type\":\"SCALAR\"}]}",
+		nodeScale, indexCount > 0 ? ",\"indices\":1" : "", bin.size(), indexOffset, (size_t)indexCount * indexSize,
+		componentType, indexCount);
+
+	return WriteGlb(GLTF_TEST_FILE_NAME, json, bin);
+}
+
+
+// IndicesOf returns the indices of the primitive, whatever their width.
+static std::vector<uint32_t> IndicesOf(const GltfLoaderClass::PrimitiveType& primitive)
+{
+	std::vector<uint32_t> indices;
+	unsigned int i;
+
+
+	for (i = 0; i < primitive.indexCount; i++)
+	{
+		indices.push_back(primitive.indexStride == sizeof(uint16_t) ? ((const uint16_t*)primitive.indices)[i] : ((const uint32_t*)primitive.indices)[i]);
+	}
+
+	return indices;
+}
+
+
+static void TestIndexWidths()
+{
+	static const uint8_t byteIndices[6] = { 0, 1, 2, 0, 2, 3 };
+	static const uint16_t shortIndices[6] = { 0, 1, 2, 0, 2, 3 };
+	static const uint32_t longIndices[6] = { 0, 1, 2, 0, 2, 3 };
+	const std::vector<uint32_t> expected = { 0, 1, 2, 0, 2, 3 };
+	GltfLoaderClass loader;
+
+
+	CHECK(WriteQuad(byteIndices, 6, 1, GLTF_UNSIGNED_BYTE, 1.0f));
+	CHECK(loader.Initialize(GLTF_TEST_FILE_NAME));
+	CHECK(loader.GetPrimitives().size() == 1);
+	CHECK(loader.GetPrimitives().size() == 1 && !loader.GetPrimitives()[0].indicesInPlace && IndicesOf(loader.GetPrimitives()[0]) == expected);
+	loader.Shutdown();
+
+	CHECK(WriteQuad(shortIndices, 6, 2, GLTF_UNSIGNED_SHORT, 1.0f));
+	CHECK(loader.Initialize(GLTF_TEST_FILE_NAME));
+	CHECK(loader.GetPrimitives().size() == 1 && loader.GetPrimitives()[0].indicesInPlace && IndicesOf(loader.GetPrimitives()[0]) == expected);
+	loader.Shutdown();
+
+	// A mirroring node converts the indices with every triangle's winding reversed.
+	CHECK(WriteQuad(longIndices, 6, 4, GLTF_UNSIGNED_INT, -1.0f));
+	CHECK(loader.Initialize(GLTF_TEST_FILE_NAME));
+	CHECK(loader.GetPrimitives().size() == 1 && !loader.GetPrimitives()[0].indicesInPlace &&
+		IndicesOf(loader.GetPrimitives()[0]) == std::vector<uint32_t>({ 0, 2, 1, 0, 3, 2 }));
+	loader.Shutdown();
+
+	return;
+}
+
+
+static void TestRejectedIndices()
+{
+	static const uint16_t shortIndices[6] = { 0, 1, 2, 0, 2, 3 };
+	static const uint16_t outOfRange[6] = { 0, 1, 2, 0, 2, 4 };
+	static const float floatIndices[6] = { 0.0f, 1.0f, 2.0f, 0.0f, 2.0f, 3.0f };
+	GltfLoaderClass loader;
+
+
+	// Five indices are not a whole number of triangles, converted or used in place.
+	CHECK(WriteQuad(shortIndices, 5, 2, GLTF_UNSIGNED_SHORT, 1.0f));
+	CHECK(!loader.Initialize(GLTF_TEST_FILE_NAME));
+	CHECK(WriteQuad(shortIndices, 5, 2, GLTF_UNSIGNED_SHORT, -1.0f));
+	CHECK(!loader.Initialize(GLTF_TEST_FILE_NAME));
+
+	// Without indices the four vertices are the triangle list, which leaves one over.
+	CHECK(WriteQuad(shortIndices, 0, 2, GLTF_UNSIGNED_SHORT, 1.0f));
+	CHECK(!loader.Initialize(GLTF_TEST_FILE_NAME));
+
+	CHECK(WriteQuad(outOfRange, 6, 2, GLTF_UNSIGNED_SHORT, 1.0f));
+	CHECK(!loader.Initialize(GLTF_TEST_FILE_NAME));
+
+	// Indices are unsigned integers, floats are not allowed.
+	CHECK(WriteQuad(floatIndices, 6, 4, GLTF_FLOAT, 1.0f));
+	CHECK(!loader.Initialize(GLTF_TEST_FILE_NAME));
+	loader.Shutdown();
+
+	return;
+}
+
+
+// TestMergedRanges draws the quad twice from one mesh, once with 16 and once with 32 bit indices, the first with a textured material.
+static void TestMergedRanges()
+{
+	static const float positions[12] = { 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f };
+	static const uint16_t shortIndices[6] = { 0, 1, 2, 0, 2, 3 };
+	static const uint32_t longIndices[6] = { 0, 1, 2, 0, 2, 3 };
+	const std::vector<uint16_t> expected = { 0, 1, 2, 0, 2, 3, 4, 5, 6, 4, 6, 7 };
+	std::vector<unsigned char> bin;
+	std::vector<GltfLoaderClass::RangeType> ranges;
+	GltfLoaderClass loader;
+	const VertexType* verts;
+	const void* indices;
+	unsigned int vertexCount, indexCount, indexStride;
+	char json[2048];
+
+
+	Append(bin, positions, sizeof(positions));
+	Append(bin, shortIndices, sizeof(shortIndices));
+	Append(bin, longIndices, sizeof(longIndices));
+	snprintf(json, sizeof(json),
+		"{\"asset\":{\"version\":\"2.0\"},\"scene\":0,\"scenes\":[{\"nodes\":[0]}],\"nodes\":[{\"mesh\":0}],"
+		"\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":0},\"indices\":1,\"material\":0},"
+		"{\"attributes\":{\"POSITION\":0},\"indices\":2}]}],"
+		"\"images\":[{\"uri\":\"quad.dds\"}],\"textures\":[{\"source\":0}],"
+		"\"materials\":[{\"pbrMetallicRoughness\":{\"baseColorTexture\":{\"index\":0}}}],"
+		"\"buffers\":[{\"byteLength\":%zu}],"
+		"\"bufferViews\":[{\"buffer\":0,\"byteOffset\":0,\"byteLength\":48},{\"buffer\":0,\"byteOffset\":48,\"byteLength\":12},"
+		"{\"buffer\":0,\"byteOffset\":60,\"byteLength\":24}],"
+		"\"accessors\":[{\"bufferView\":0,\"componentType\":5126,\"count\":4,\"type\":\"VEC3\"},"
+		"{\"bufferView\":1,\"componentType\":%u,\"count\":6,\"type\":\"SCALAR\"},"
+		"{\"bufferView\":2,\"componentType\":%u,\"count\":6,\"type\":\"SCALAR\"}]}",
+		bin.size(), GLTF_UNSIGNED_SHORT, GLTF_UNSIGNED_INT);
+	CHECK(WriteGlb(GLTF_TEST_FILE_NAME, json, bin));
+
+	CHECK(loader.Initialize(GLTF_TEST_FILE_NAME));
+	CHECK(loader.GetPrimitives().size() == 2);
+	CHECK(loader.GetMesh(verts, vertexCount, indices, indexCount, indexStride, ranges));
+	CHECK(vertexCount == 8 && indexCount == 12);
+
+	// The merged vertices fit 16 bits, so the 32 bit primitive is narrowed rather than the 16 bit one widened.
+	CHECK(indexStride == sizeof(uint16_t));
+	CHECK(indexStride == sizeof(uint16_t) && std::vector<uint16_t>((const uint16_t*)indices, (const uint16_t*)indices + indexCount) == expected);
+
+	CHECK(ranges.size() == 2);
+	CHECK(ranges.size() == 2 && ranges[0].firstIndex == 0 && ranges[0].indexCount == 6 && ranges[0].image == 0);
+	CHECK(ranges.size() == 2 && ranges[1].firstIndex == 6 && ranges[1].indexCount == 6 && ranges[1].image == -1);
+	loader.Shutdown();
+
+	return;
+}
+
+
+int main()
+{
+	TestIndexWidths();
+	TestRejectedIndices();
+	TestMergedRanges();
+	remove(GLTF_TEST_FILE_NAME);
+
+	return TEST_RESULT;
+}
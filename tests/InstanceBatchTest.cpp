@@ -0,0 +1,214 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: InstanceBatchTest.cpp
+////////////////////////////////////////////////////////////////////////////////
+// Culls a few instances of a unit sphere on the null device from a camera ten units in front of the origin: ones in the middle,
+// behind the camera, off to the side, past the far plane and straddling the right plane, and one that only reaches into the view
+// once it is scaled up. The rows of the visible ones have to be in the stream in the order they were added, with the depth of the
+// nearest and the bytes uploaded. Adding instances past the capacity has to grow the stream to the next power of two in place of the
+// old one.
+#include "instancebatchclass.h"
+#include "nullrenderdeviceclass.h"
+#include "TestUtils.h"
+#include <cmath>
+#include <cstring>
+
+
+/////////////
+// GLOBALS //
+/////////////
+const float INSTANCE_TEST_NEAR = 0.1f;
+const float INSTANCE_TEST_FAR = 100.0f;
+
+
+static XMMATRIX GetViewMatrix()
+{
+	return XMMatrixLookAtLH(XMVectorSet(0.0f, 0.0f, -10.0f, 1.0f), XMVectorZero(), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+}
+
+
+static XMMATRIX GetProjectionMatrix()
+{
+	return XMMatrixPerspectiveFovLH(XM_PI / 4.0f, 1.0f, INSTANCE_TEST_NEAR, INSTANCE_TEST_FAR);
+}
+
+// CheckRows reads the stream the last Cull mapped with a discard back through a map without overwriting, and compares its first rows
+// with the ones packed for the given translations, in order.
+static void CheckRows(NullRenderDeviceClass& device, const float (*translations)[3], unsigned int count)
+{
+	NullRenderDeviceClass::CallType call;
+	InstanceType* rows;
+	void* data;
+	unsigned int buffer, i;
+	bool result;
+	int c;
+
+
+	buffer = RENDER_HANDLE_NONE;
+	for (c = 0; c < device.GetCallCount(); c++)
+	{
+		call = device.GetCall(c);
+		if (call.type == RENDER_CALL_MAP_BUFFER && call.arguments[1] == (unsigned int)RENDER_MAP_DISCARD)
+		{
+			buffer = call.arguments[0];
+		}
+	}
+	CHECK(buffer != RENDER_HANDLE_NONE);
+
+	result = device.MapBuffer(buffer, RENDER_MAP_NO_OVERWRITE, 0, count * sizeof(InstanceType), data);
+	CHECK(result);
+	if (!result)
+	{
+		return;
+	}
+
+	// The rows are the transposed world matrix, the translation is in the last column.
+	rows = (InstanceType*)data;
+	for (i = 0; i < count; i++)
+	{
+		CHECK(rows[i].rows[0][3] == translations[i][0]);
+		CHECK(rows[i].rows[1][3] == translations[i][1]);
+		CHECK(rows[i].rows[2][3] == translations[i][2]);
+	}
+	device.UnmapBuffer(buffer);
+
+	return;
+}
+
+
+static void TestCull()
+{
+	NullRenderDeviceClass device;
+	RenderDeviceClass::CapsType caps;
+	InstanceBatchClass batch;
+	InstanceBatchClass::StatsType stats;
+	const float visible[][3] = { { 0.0f, 0.0f, 0.0f }, { 4.9f, 0.0f, 0.0f } };
+	const float scaledVisible[][3] = { { 0.0f, 0.0f, 0.0f }, { 4.9f, 0.0f, 0.0f }, { 6.0f, 0.0f, 0.0f } };
+	unsigned int farInstance;
+	bool result;
+
+
+	caps.constantBufferOffsetting = true;
+	caps.mapNoOverwriteOnConstantBuffers = true;
+	result = device.Initialize(caps, 0);
+	CHECK(result);
+	device.SetRecording(true);
+	result = batch.Initialize(&device, 16);
+	CHECK(result);
+	batch.SetMesh(XMMatrixIdentity(), XMFLOAT3(0.0f, 0.0f, 0.0f), 1.0f);
+
+	// The right plane is tan(pi / 8) * 10 = 4.14 units from the middle at the origin's depth. The sphere at 4.9 still reaches into
+	// the view, the one at 6 does not.
+	batch.AddInstance(XMMatrixTranslation(0.0f, 0.0f, 0.0f));
+	batch.AddInstance(XMMatrixTranslation(0.0f, 0.0f, -20.0f));
+	batch.AddInstance(XMMatrixTranslation(50.0f, 0.0f, 0.0f));
+	farInstance = batch.AddInstance(XMMatrixTranslation(0.0f, 0.0f, 200.0f));
+	batch.AddInstance(XMMatrixTranslation(4.9f, 0.0f, 0.0f));
+	batch.AddInstance(XMMatrixTranslation(6.0f, 0.0f, 0.0f));
+	CHECK(farInstance == 3);
+	CHECK(batch.GetInstanceCount() == 6);
+
+	result = batch.Cull(&device, GetViewMatrix(), GetProjectionMatrix());
+	CHECK(result);
+	CHECK(batch.GetVisibleCount() == 2);
+	CHECK(fabsf(batch.GetVisibleDepth() - 9.0f) < 1.0e-4f);
+	CheckRows(device, visible, 2);
+
+	// Twice the size, its sphere reaches back over the right plane, and it comes after the others.
+	batch.SetInstance(5, XMMatrixScaling(2.0f, 2.0f, 2.0f) * XMMatrixTranslation(6.0f, 0.0f, 0.0f));
+	result = batch.Cull(&device, GetViewMatrix(), GetProjectionMatrix());
+	CHECK(result);
+	CHECK(batch.GetVisibleCount() == 3);
+	CheckRows(device, scaledVisible, 3);
+
+	stats = batch.GetStats();
+	CHECK(stats.instanceCount == 6);
+	CHECK(stats.visibleCount == 3);
+	CHECK(stats.uploadBytes == 5 * sizeof(InstanceType));
+	CHECK(stats.growCount == 0);
+
+	// Looking up from high above them leaves nothing to draw.
+	result = batch.Cull(&device, XMMatrixLookAtLH(XMVectorSet(0.0f, 500.0f, -10.0f, 1.0f), XMVectorSet(0.0f, 1000.0f, -10.0f, 1.0f),
+		XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f)), GetProjectionMatrix());
+	CHECK(result);
+	CHECK(batch.GetVisibleCount() == 0);
+
+	batch.Shutdown();
+	device.Shutdown();
+	CHECK(device.GetStats().errorCount == 0);
+
+	return;
+}
+
+
+static void TestGrowth()
+{
+	NullRenderDeviceClass device;
+	RenderDeviceClass::CapsType caps;
+	InstanceBatchClass batch;
+	InstanceBatchClass::StatsType stats;
+	unsigned int i;
+	bool result;
+
+
+	caps.constantBufferOffsetting = true;
+	caps.mapNoOverwriteOnConstantBuffers = true;
+	result = device.Initialize(caps, 0);
+	CHECK(result);
+
+	// The capacity is rounded up to a power of two, and making the first stream is not growing.
+	result = batch.Initialize(&device, 3);
+	CHECK(result);
+	stats = batch.GetStats();
+	CHECK(stats.capacity == 4);
+	CHECK(stats.growCount == 0);
+	CHECK(device.GetStats().bufferCount == 1);
+
+	batch.SetMesh(XMMatrixIdentity(), XMFLOAT3(0.0f, 0.0f, 0.0f), 1.0f);
+	for (i = 0; i < 5; i++)
+	{
+		batch.AddInstance(XMMatrixTranslation(0.1f * i, 0.0f, 0.0f));
+	}
+	result = batch.Cull(&device, GetViewMatrix(), GetProjectionMatrix());
+	CHECK(result);
+	stats = batch.GetStats();
+	CHECK(stats.capacity == 8);
+	CHECK(stats.growCount == 1);
+	CHECK(batch.GetVisibleCount() == 5);
+
+	// Many more at once grow it once more, straight to the power of two that holds them, and the old stream is released.
+	for (i = 5; i < 1000; i++)
+	{
+		batch.AddInstance(XMMatrixTranslation(0.0f, 0.0f, 0.01f * i));
+	}
+	result = batch.Cull(&device, GetViewMatrix(), GetProjectionMatrix());
+	CHECK(result);
+	stats = batch.GetStats();
+	CHECK(stats.capacity == 1024);
+	CHECK(stats.growCount == 2);
+	CHECK(batch.GetVisibleCount() == 1000);
+	CHECK(device.GetStats().bufferCount == 1);
+
+	// Fewer instances do not shrink it.
+	batch.SetMesh(XMMatrixIdentity(), XMFLOAT3(0.0f, 0.0f, 0.0f), 1.0f);
+	batch.AddInstance(XMMatrixIdentity());
+	result = batch.Cull(&device, GetViewMatrix(), GetProjectionMatrix());
+	CHECK(result);
+	CHECK(batch.GetStats().capacity == 1024);
+	CHECK(batch.GetStats().growCount == 2);
+
+	batch.Shutdown();
+	CHECK(device.GetStats().bufferCount == 0);
+	device.Shutdown();
+	CHECK(device.GetStats().errorCount == 0);
+
+	return;
+}
+
+
+int main()
+{
+	TestCull();
+	TestGrowth();
+
+	return TEST_RESULT;
+}
@@ -0,0 +1,198 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: InstanceBenchmark.cpp
+////////////////////////////////////////////////////////////////////////////////
+// Culls a million instances on the null device and prints how long it takes, the best of a few runs, with the instances that were
+// left visible and the bytes of rows a Cull uploads. The instances are scattered over a square around a camera that sees about a
+// third of them, so the spheres inside and outside the view are mixed the way a scene mixes them. It then draws as many frames as
+// runs of the scene with a million instances of a generated grid of 8 x 8 quads in place of its own, and prints the time of a frame
+// and what the instances drew and uploaded in it.
+//
+//     instance_benchmark [instance count] [repeats]
+#include "graphicsclass.h"
+#include "instancebatchclass.h"
+#include "meshcacheclass.h"
+#include "nullrenderdeviceclass.h"
+#include "BenchmarkUtils.h"
+#include <cstdlib>
+#include <filesystem>
+#include <random>
+
+
+/////////////
+// GLOBALS //
+/////////////
+const unsigned int BENCHMARK_DEFAULT_INSTANCES = 1000000;
+const int BENCHMARK_DEFAULT_REPEATS = 10;
+const float BENCHMARK_SPREAD = 1000.0f;
+const int BENCHMARK_PROP_GRID = 8;
+const int BENCHMARK_SCREEN_WIDTH = 1280;
+const int BENCHMARK_SCREEN_HEIGHT = 720;
+const char* BENCHMARK_FILE_NAME = "instance_benchmark.obj";
+
+
+static bool InitializeDevice(NullRenderDeviceClass& device)
+{
+	RenderDeviceClass::CapsType caps;
+
+
+	caps.constantBufferOffsetting = true;
+	caps.mapNoOverwriteOnConstantBuffers = true;
+	if (!device.Initialize(caps, 0))
+	{
+		return false;
+	}
+	device.SetRecording(false);
+
+	return true;
+}
+
+
+static bool RunCull(unsigned int instanceCount, int repeats)
+{
+	NullRenderDeviceClass device;
+	InstanceBatchClass batch;
+	InstanceBatchClass::StatsType stats;
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> position(-0.5f * BENCHMARK_SPREAD, 0.5f * BENCHMARK_SPREAD);
+	std::uniform_real_distribution<float> scale(0.5f, 2.0f);
+	std::uniform_real_distribution<float> turn(0.0f, XM_2PI);
+	XMMATRIX viewMatrix, projectionMatrix;
+	double seconds, best;
+	unsigned int i;
+	bool result;
+	int run;
+
+
+	if (!InitializeDevice(device))
+	{
+		return false;
+	}
+
+	result = batch.Initialize(&device, instanceCount);
+	batch.SetMesh(XMMatrixIdentity(), XMFLOAT3(0.0f, 0.0f, 0.0f), 1.0f);
+	for (i = 0; i < instanceCount; i++)
+	{
+		batch.AddInstance(XMMatrixScaling(scale(random), scale(random), scale(random)) * XMMatrixRotationY(turn(random)) *
+			XMMatrixTranslation(position(random), 0.0f, position(random)));
+	}
+
+	// From above the middle of the square, looking down at a slant, about a third of the square is in view.
+	viewMatrix = XMMatrixLookAtLH(XMVectorSet(0.0f, 50.0f, 0.0f, 1.0f), XMVectorSet(0.0f, 0.0f, 100.0f, 1.0f),
+		XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+	projectionMatrix = XMMatrixPerspectiveFovLH(XM_PI / 2.0f, (float)BENCHMARK_SCREEN_WIDTH / BENCHMARK_SCREEN_HEIGHT, 0.1f,
+		BENCHMARK_SPREAD);
+
+	best = 0.0;
+	for (run = 0; run < repeats && result; run++)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		result = batch.Cull(&device, viewMatrix, projectionMatrix);
+		seconds = SecondsSince(start);
+		best = (run == 0 || seconds < best) ? seconds : best;
+	}
+	stats = batch.GetStats();
+
+	batch.Shutdown();
+	device.Shutdown();
+
+	if (!result || device.GetStats().errorCount > 0)
+	{
+		printf("Could not cull %u instances\n", instanceCount);
+		return false;
+	}
+
+	printf("Cull of %u instances, best of %d runs:\n", instanceCount, repeats);
+	printf("    %7.2f ms, %6.1f M instances/s, %u visible, %.2f MB of rows uploaded\n", best * 1.0e3, instanceCount / best * 1.0e-6,
+		stats.visibleCount, (double)stats.visibleCount * sizeof(InstanceType) / (1024.0 * 1024.0));
+
+	return true;
+}
+
+
+static bool RunScene(unsigned int instanceCount, int frameCount)
+{
+	NullRenderDeviceClass device;
+	RenderDeviceClass::StatsType stats;
+	GraphicsClass* Graphics;
+	GraphicsClass::SceneOptionsType options;
+	GraphicsClass::FrameStatsType frameStats;
+	double seconds;
+	bool result;
+	int i;
+
+
+	if (!InitializeDevice(device))
+	{
+		return false;
+	}
+
+	Graphics = new GraphicsClass;
+	options = Graphics->GetSceneOptions();
+	options.modelFileName = BENCHMARK_FILE_NAME;
+	options.instanceCount = instanceCount;
+	Graphics->SetSceneOptions(options);
+	result = Graphics->Initialize(&device, BENCHMARK_SCREEN_WIDTH, BENCHMARK_SCREEN_HEIGHT);
+
+	// The first frame is left out, it is the one that makes the constant ring and the queue grow.
+	result = result && Graphics->Frame();
+	Graphics->ResetFrameStats();
+
+	device.ResetStats();
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (i = 0; i < frameCount && result; i++)
+	{
+		result = Graphics->Frame();
+	}
+	seconds = SecondsSince(start);
+	stats = device.GetStats();
+	frameStats = Graphics->GetFrameStats();
+
+	Graphics->Shutdown();
+	delete Graphics;
+	device.Shutdown();
+
+	if (!result || frameStats.instances.instanceCount != instanceCount)
+	{
+		printf("Could not draw %u instances\n", instanceCount);
+		return false;
+	}
+
+	printf("Scene of %u instances, %d frames:\n", instanceCount, frameCount);
+	printf("    %.1f us a frame, %u instances visible, %.1f draws and %.2f MB uploaded a frame, %.2f MB of it instance rows\n",
+		seconds * 1.0e6 / frameCount, frameStats.instances.visibleCount, (double)stats.drawCount / frameCount,
+		(double)stats.uploadBytes / frameCount / (1024.0 * 1024.0),
+		(double)frameStats.instances.uploadBytes / frameCount / (1024.0 * 1024.0));
+
+	return true;
+}
+
+
+int main(int argc, char** argv)
+{
+	std::error_code error;
+	unsigned int instanceCount;
+	int repeats;
+	bool result;
+
+
+	instanceCount = argc > 1 ? (unsigned int)strtoul(argv[1], 0, 10) : BENCHMARK_DEFAULT_INSTANCES;
+	repeats = argc > 2 ? atoi(argv[2]) : BENCHMARK_DEFAULT_REPEATS;
+	if (instanceCount == 0 || repeats <= 0)
+	{
+		printf("usage: %s [instance count] [repeats]\n", argv[0]);
+		return 1;
+	}
+
+	if (!WriteGridObj(BENCHMARK_FILE_NAME, BENCHMARK_PROP_GRID))
+	{
+		printf("Could not write %s\n", BENCHMARK_FILE_NAME);
+		return 1;
+	}
+
+	result = RunCull(instanceCount, repeats) && RunScene(instanceCount, repeats);
+
+	std::filesystem::remove(MeshCacheClass::GetCacheFilename(BENCHMARK_FILE_NAME), error);
+	remove(BENCHMARK_FILE_NAME);
+
+	return result ? 0 : 1;
+}
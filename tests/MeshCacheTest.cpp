@@ -0,0 +1,219 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: MeshCacheTest.cpp
+////////////////////////////////////////////////////////////////////////////////
+// Writes a small .dxmesh cache and checks that it loads back as written, that a cache whose indices name vertices it does not have or
+// whose header counts and offsets would overflow into a range that looks valid is refused, and that a cache is only used while its
+// source is what it was built from: a source of another size or with other contents under a new modification time invalidates it,
+// a source that was only touched does not.
+#include "meshcacheclass.h"
+#include "TestUtils.h"
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+
+/////////////
+// GLOBALS //
+/////////////
+const char* CACHE_TEST_SOURCE_NAME = "mesh_cache_test.obj";
+const char* CACHE_TEST_CACHE_NAME = "mesh_cache_test.dxmesh";
+const char* CACHE_TEST_CORRUPT_NAME = "mesh_cache_test_corrupt.dxmesh";
+const char* CACHE_TEST_SOURCE_TEXT = "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\nf 1 2 3\nf 1 3 4\n";
+// Where the header fields the test corrupts are in the file, as MeshCacheClass lays out its header.
+const size_t CACHE_VERTEX_COUNT_FIELD = 16;
+const size_t CACHE_VERTEX_OFFSET_FIELD = 32;
+const size_t CACHE_INDEX_OFFSET_FIELD = 40;
+
+
+static bool WriteText(const char* filename, const char* text)
+{
+	std::ofstream fout;
+
+
+	fout.open(filename, std::ios::binary | std::ios::trunc);
+	fout << text;
+	fout.close();
+
+	return (bool)fout;
+}
+
+
+static bool WriteQuadCache()
+{
+	std::vector<VertexType> verts(4);
+	std::vector<uint32_t> indices = { 0, 1, 2, 0, 2, 3 };
+	std::vector<MeshLodType> lods(1);
+	std::vector<MeshSubmeshType> submeshes(1);
+	MeshMaterialListType materials;
+	unsigned int i;
+
+
+	for (i = 0; i < 4; i++)
+	{
+		verts[i].position = XMFLOAT3((float)(i == 1 || i == 2), (float)(i >= 2), 0.0f);
+		verts[i].texture = XMFLOAT2(verts[i].position.x, verts[i].position.y);
+		verts[i].normal = XMFLOAT3(0.0f, 0.0f, -1.0f);
+	}
+	lods[0].startIndex = 0;
+	lods[0].indexCount = 6;
+	lods[0].error = 0.0f;
+	lods[0].firstSubmesh = 0;
+	lods[0].submeshCount = 1;
+	submeshes[0].material = 0;
+	submeshes[0].startIndex = 0;
+	submeshes[0].indexCount = 6;
+	materials.names.push_back("");
+
+	return MeshCacheClass::Write(CACHE_TEST_CACHE_NAME, CACHE_TEST_SOURCE_NAME, verts, indices, lods, submeshes, materials);
+}
+
+// LoadsPatched copies the cache with size bytes at offset replaced and returns whether the copy loads.
+static bool LoadsPatched(size_t offset, const void* data, size_t size)
+{
+	MeshCacheClass cache;
+	std::vector<char> bytes;
+	std::ifstream fin;
+	std::ofstream fout;
+	bool result;
+
+
+	fin.open(CACHE_TEST_CACHE_NAME, std::ios::binary);
+	bytes.assign(std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>());
+	fin.close();
+	if (offset + size > bytes.size())
+	{
+		return false;
+	}
+	memcpy(bytes.data() + offset, data, size);
+
+	fout.open(CACHE_TEST_CORRUPT_NAME, std::ios::binary | std::ios::trunc);
+	fout.write(bytes.data(), (std::streamsize)bytes.size());
+	fout.close();
+
+	result = cache.Initialize(CACHE_TEST_CORRUPT_NAME, CACHE_TEST_SOURCE_NAME);
+	cache.Shutdown();
+
+	return result;
+}
+
+
+static uint64_t ReadField(size_t offset)
+{
+	std::ifstream fin;
+	uint64_t value;
+
+
+	value = 0;
+	fin.open(CACHE_TEST_CACHE_NAME, std::ios::binary);
+	fin.seekg((std::streamoff)offset);
+	fin.read((char*)&value, sizeof(value));
+
+	return value;
+}
+
+
+static void TestRoundTrip()
+{
+	MeshCacheClass cache;
+	MeshMaterialListType materials;
+
+
+	CHECK(WriteText(CACHE_TEST_SOURCE_NAME, CACHE_TEST_SOURCE_TEXT));
+	CHECK(WriteQuadCache());
+	CHECK(cache.Initialize(CACHE_TEST_CACHE_NAME, CACHE_TEST_SOURCE_NAME));
+	CHECK(cache.GetVertexCount() == 4 && cache.GetIndexCount() == 6 && cache.GetLodCount() == 1 && cache.GetSubmeshCount() == 1);
+	CHECK(cache.GetIndexCount() == 6 && std::vector<uint32_t>(cache.GetIndices(), cache.GetIndices() + 6) == std::vector<uint32_t>({ 0, 1, 2, 0, 2, 3 }));
+	cache.GetMaterials(materials);
+	CHECK(materials.names.size() == 1 && materials.libraries.empty());
+	cache.Shutdown();
+
+	return;
+}
+
+
+static void TestCorruptCache()
+{
+	uint64_t indexOffset, value;
+	uint32_t index;
+
+
+	CHECK(WriteText(CACHE_TEST_SOURCE_NAME, CACHE_TEST_SOURCE_TEXT));
+	CHECK(WriteQuadCache());
+	indexOffset = ReadField(CACHE_INDEX_OFFSET_FIELD);
+
+	// The last vertex may be named, one past it may not.
+	index = 3;
+	CHECK(LoadsPatched((size_t)indexOffset + 5 * sizeof(uint32_t), &index, sizeof(index)));
+	index = 4;
+	CHECK(!LoadsPatched((size_t)indexOffset + 5 * sizeof(uint32_t), &index, sizeof(index)));
+	index = 0xffffffff;
+	CHECK(!LoadsPatched((size_t)indexOffset, &index, sizeof(index)));
+
+	// A vertex count whose bytes wrap around to the size of one vertex, and an offset just short of wrapping around.
+	value = (~0ull / sizeof(VertexType)) + 2;
+	CHECK(!LoadsPatched(CACHE_VERTEX_COUNT_FIELD, &value, sizeof(value)));
+	value = ~0ull - 63;
+	CHECK(!LoadsPatched(CACHE_VERTEX_OFFSET_FIELD, &value, sizeof(value)));
+
+	// A truncated file.
+	CHECK(!LoadsPatched(0, "XXXX", 4));
+	remove(CACHE_TEST_CORRUPT_NAME);
+
+	return;
+}
+
+
+static void TestInvalidation()
+{
+	MeshCacheClass cache;
+	std::filesystem::file_time_type time;
+	std::string changed;
+
+
+	CHECK(WriteText(CACHE_TEST_SOURCE_NAME, CACHE_TEST_SOURCE_TEXT));
+	CHECK(WriteQuadCache());
+	time = std::filesystem::last_write_time(CACHE_TEST_SOURCE_NAME);
+
+	// Touching the source gives it a new time but the same contents, the hash lets the cache stay.
+	std::filesystem::last_write_time(CACHE_TEST_SOURCE_NAME, time + std::chrono::hours(1));
+	CHECK(cache.Initialize(CACHE_TEST_CACHE_NAME, CACHE_TEST_SOURCE_NAME));
+	cache.Shutdown();
+
+	// The same size with other contents and a new time.
+	changed = CACHE_TEST_SOURCE_TEXT;
+	changed[2] = '5';
+	CHECK(WriteText(CACHE_TEST_SOURCE_NAME, changed.c_str()));
+	std::filesystem::last_write_time(CACHE_TEST_SOURCE_NAME, time + std::chrono::hours(2));
+	CHECK(!cache.Initialize(CACHE_TEST_CACHE_NAME, CACHE_TEST_SOURCE_NAME));
+
+	// Another size, even with the time the cache recorded.
+	changed = std::string(CACHE_TEST_SOURCE_TEXT) + "# one more line\n";
+	CHECK(WriteText(CACHE_TEST_SOURCE_NAME, changed.c_str()));
+	std::filesystem::last_write_time(CACHE_TEST_SOURCE_NAME, time);
+	CHECK(!cache.Initialize(CACHE_TEST_CACHE_NAME, CACHE_TEST_SOURCE_NAME));
+
+	// Putting the source back as it was makes the cache good again.
+	CHECK(WriteText(CACHE_TEST_SOURCE_NAME, CACHE_TEST_SOURCE_TEXT));
+	std::filesystem::last_write_time(CACHE_TEST_SOURCE_NAME, time);
+	CHECK(cache.Initialize(CACHE_TEST_CACHE_NAME, CACHE_TEST_SOURCE_NAME));
+	cache.Shutdown();
+
+	// A missing source can not be checked, so its cache is not used.
+	remove(CACHE_TEST_SOURCE_NAME);
+	CHECK(!cache.Initialize(CACHE_TEST_CACHE_NAME, CACHE_TEST_SOURCE_NAME));
+
+	return;
+}
+
+
+int main()
+{
+	TestRoundTrip();
+	TestCorruptCache();
+	TestInvalidation();
+	remove(CACHE_TEST_CACHE_NAME);
+	remove(CACHE_TEST_SOURCE_NAME);
+
+	return TEST_RESULT;
+}
@@ -0,0 +1,232 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: MeshCompressionTest.cpp
+////////////////////////////////////////////////////////////////////////////////
+// Encodes generated vertices in both compact layouts and checks that what decodes stays within the error the formats promise:
+// half a quantization step for positions, half a half float step for texture coordinates and a fraction of a degree for normals.
+// Also checks that split and narrowed index buffers still draw the same triangles.
+#include "meshcompressionclass.h"
+#include "TestUtils.h"
+#include <cmath>
+
+
+/////////////
+// GLOBALS //
+/////////////
+const unsigned int TEST_VERTEX_COUNT = 20000;
+// Texture coordinates in [0, 1] round to a half float step of at most 2^-11, so they move by at most half of that.
+const float TEXTURE_ERROR_LIMIT = 1.0f / 4096.0f;
+// Three 10 bit components resolve directions to about a tenth of a degree. Two 16 bit octahedral components do far better than that,
+// below what an angle taken with a float acos can still tell apart from zero, which is about 0.02 degrees.
+const float OCTAHEDRAL_NORMAL_LIMIT_DEGREES = 0.05f;
+const float PACKED_NORMAL_LIMIT_DEGREES = 0.15f;
+
+
+static float Random(unsigned int& seed)
+{
+	seed = seed * 1664525 + 1013904223;
+	return (float)(seed >> 8) / 16777216.0f;
+}
+
+
+// Vertices in an off center box with a different extent on every axis, texture coordinates in [0, 1] and normals in every direction.
+static void MakeVertices(std::vector<VertexType>& verts, unsigned int count)
+{
+	XMFLOAT3 normal;
+	unsigned int seed, i;
+	float length;
+
+
+	seed = 7;
+	verts.resize(count);
+	for (i = 0; i < count; i++)
+	{
+		verts[i].position = XMFLOAT3(-3.0f + 8.0f * Random(seed), 100.0f + 0.5f * Random(seed), -40.0f * Random(seed));
+		verts[i].texture = XMFLOAT2(Random(seed), Random(seed));
+
+		do
+		{
+			normal = XMFLOAT3(2.0f * Random(seed) - 1.0f, 2.0f * Random(seed) - 1.0f, 2.0f * Random(seed) - 1.0f);
+			length = sqrtf(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+		} while (length < 0.01f || length > 1.0f);
+		verts[i].normal = XMFLOAT3(normal.x / length, normal.y / length, normal.z / length);
+	}
+
+	// The axis directions and the corners of the box, where the encodings are at their limits.
+	verts[0].normal = XMFLOAT3(0.0f, 0.0f, 1.0f);
+	verts[1].normal = XMFLOAT3(0.0f, 0.0f, -1.0f);
+	verts[2].normal = XMFLOAT3(-1.0f, 0.0f, 0.0f);
+	verts[3].normal = XMFLOAT3(0.0f, -1.0f, 0.0f);
+	verts[4].position = XMFLOAT3(-3.0f, 100.0f, -40.0f);
+	verts[5].position = XMFLOAT3(5.0f, 100.5f, 0.0f);
+	verts[6].texture = XMFLOAT2(0.0f, 1.0f);
+
+	return;
+}
+
+
+static void TestVertexError(VertexFormatType format, float normalLimitDegrees)
+{
+	std::vector<VertexType> verts, decoded;
+	std::vector<CompactVertexType> compact;
+	MeshCompressionClass compression;
+	MeshCompressionClass::QuantizationType quantization;
+	MeshCompressionClass::ErrorStatsType stats;
+
+
+	MakeVertices(verts, TEST_VERTEX_COUNT);
+	compression.EncodeVertices(verts.data(), (unsigned int)verts.size(), format, compact, quantization);
+	compression.DecodeVertices(compact, format, quantization, decoded);
+	CHECK(compact.size() == verts.size());
+	CHECK(decoded.size() == verts.size());
+	CHECK(sizeof(CompactVertexType) == 16);
+
+	stats = compression.MeasureError(verts.data(), decoded, quantization);
+	printf("Format %d: position error %g (bound %g), texture error %g, normal error %.4f degrees\n", (int)format, stats.maxPositionError,
+		stats.positionErrorBound, stats.maxTextureError, XMConvertToDegrees(stats.maxNormalAngle));
+
+	// The bound is half a step of the longest axis, 40 / 65535 / 2, and a little float rounding.
+	CHECK(stats.positionErrorBound > 0.0f && stats.positionErrorBound < 4.0e-4f);
+	CHECK(stats.maxPositionError <= stats.positionErrorBound);
+	CHECK(stats.maxTextureError <= TEXTURE_ERROR_LIMIT);
+	CHECK(XMConvertToDegrees(stats.maxNormalAngle) <= normalLimitDegrees);
+
+	return;
+}
+
+
+// A flat mesh has a zero extent on one axis, which has to decode back to where it was rather than to a NaN.
+static void TestFlatAxis()
+{
+	std::vector<VertexType> verts, decoded;
+	std::vector<CompactVertexType> compact;
+	MeshCompressionClass compression;
+	MeshCompressionClass::QuantizationType quantization;
+	MeshCompressionClass::ErrorStatsType stats;
+	size_t i;
+
+
+	MakeVertices(verts, 256);
+	for (i = 0; i < verts.size(); i++)
+	{
+		verts[i].position.y = 2.5f;
+	}
+
+	compression.EncodeVertices(verts.data(), (unsigned int)verts.size(), VERTEX_FORMAT_COMPACT_OCTAHEDRAL, compact, quantization);
+	compression.DecodeVertices(compact, VERTEX_FORMAT_COMPACT_OCTAHEDRAL, quantization, decoded);
+	stats = compression.MeasureError(verts.data(), decoded, quantization);
+	CHECK(quantization.boundsExtent.y == 0.0f);
+	CHECK(stats.maxPositionError <= stats.positionErrorBound);
+	for (i = 0; i < decoded.size(); i++)
+	{
+		CHECK(decoded[i].position.y == 2.5f);
+	}
+
+	return;
+}
+
+
+// Every finite half float converts to a float and back to the same bits.
+static void TestHalfRoundTrip()
+{
+	MeshCompressionClass compression;
+	unsigned int bits, failures;
+
+
+	failures = 0;
+	for (bits = 0; bits < 65536; bits++)
+	{
+		// Skip the infinities and NaNs, exponent all ones.
+		if ((bits & 0x7c00) == 0x7c00)
+		{
+			continue;
+		}
+		if (compression.FloatToHalf(compression.HalfToFloat((uint16_t)bits)) != bits)
+		{
+			failures++;
+		}
+	}
+	CHECK(failures == 0);
+
+	CHECK(compression.HalfToFloat(compression.FloatToHalf(1.0f)) == 1.0f);
+	CHECK(compression.HalfToFloat(compression.FloatToHalf(0.5f)) == 0.5f);
+	CHECK(compression.HalfToFloat(compression.FloatToHalf(-2.0f)) == -2.0f);
+
+	return;
+}
+
+
+// A strip of triangles over more vertices than 16 bit indices reach is split into ranges, and every range still draws the triangles
+// it took with the same positions.
+static void TestSplitIndices()
+{
+	std::vector<VertexType> verts, splitVerts;
+	std::vector<uint32_t> indices;
+	std::vector<uint16_t> shortIndices;
+	std::vector<IndexRangeType> ranges;
+	MeshCompressionClass compression;
+	unsigned int i, k, triangleCount, mismatches, vertexCount;
+	size_t r;
+
+
+	MakeVertices(verts, 150000);
+	for (i = 0; i + 2 < verts.size(); i++)
+	{
+		indices.push_back(i);
+		indices.push_back(i + 1);
+		indices.push_back(i + 2);
+	}
+
+	CHECK(!compression.NarrowIndices(indices.data(), (unsigned int)indices.size(), (unsigned int)verts.size(), shortIndices));
+
+	compression.SplitIndices(verts.data(), indices.data(), (unsigned int)indices.size(), splitVerts, shortIndices, ranges);
+	CHECK(ranges.size() >= 3);
+	CHECK(shortIndices.size() == indices.size());
+
+	triangleCount = 0;
+	mismatches = 0;
+	for (r = 0; r < ranges.size(); r++)
+	{
+		CHECK(ranges[r].startIndex == triangleCount * 3);
+		vertexCount = 0;
+		for (i = ranges[r].startIndex; i < ranges[r].startIndex + ranges[r].indexCount; i++)
+		{
+			vertexCount = (unsigned int)shortIndices[i] + 1 > vertexCount ? (unsigned int)shortIndices[i] + 1 : vertexCount;
+		}
+		CHECK(vertexCount <= 65536);
+
+		for (i = ranges[r].startIndex; i < ranges[r].startIndex + ranges[r].indexCount; i += 3)
+		{
+			for (k = 0; k < 3; k++)
+			{
+				const XMFLOAT3& a = splitVerts[ranges[r].baseVertex + shortIndices[i + k]].position;
+				const XMFLOAT3& b = verts[indices[i + k]].position;
+				if (a.x != b.x || a.y != b.y || a.z != b.z)
+				{
+					mismatches++;
+				}
+			}
+			triangleCount++;
+		}
+	}
+	CHECK(triangleCount * 3 == indices.size());
+	CHECK(mismatches == 0);
+
+	// A mesh that fits narrows without a split and keeps every index.
+	indices.resize(3000);
+	CHECK(compression.NarrowIndices(indices.data(), (unsigned int)indices.size(), 1002, shortIndices));
+	CHECK(shortIndices.size() == indices.size() && shortIndices[2999] == indices[2999]);
+
+	return;
+}
+
+
+int main()
+{
+	TestVertexError(VERTEX_FORMAT_COMPACT_OCTAHEDRAL, OCTAHEDRAL_NORMAL_LIMIT_DEGREES);
+	TestVertexError(VERTEX_FORMAT_COMPACT_PACKED, PACKED_NORMAL_LIMIT_DEGREES);
+	TestFlatAxis();
+	TestHalfRoundTrip();
+	TestSplitIndices();
+
+	return TEST_RESULT;
+}
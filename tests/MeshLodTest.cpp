@@ -0,0 +1,326 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: MeshLodTest.cpp
+////////////////////////////////////////////////////////////////////////////////
+// Simplifies a sphere into the chain of levels of detail ModelClass builds for an OBJ and streams it as a progressive mesh, and checks
+// that every level keeps to its triangle budget and that the errors they report bound how far their surface is from the sphere.
+// A progressive stream cut short in the middle of its splits must leave a valid mesh at the error of the last split it has.
+#include "meshsimplifierclass.h"
+#include "progressivemeshclass.h"
+#include "progressiveloaderclass.h"
+#include "TestUtils.h"
+#include <cmath>
+#include <fstream>
+#include <map>
+
+
+/////////////
+// GLOBALS //
+/////////////
+const char* LOD_TEST_SOURCE_NAME = "mesh_lod_test.obj";
+const char* LOD_TEST_STREAM_NAME = "mesh_lod_test.dxpm";
+const char* LOD_TEST_CUT_STREAM_NAME = "mesh_lod_test_cut.dxpm";
+const int SPHERE_SUBDIVISIONS = 5;
+// The chain ModelClass::LoadOBJ builds: every level aims for half the triangles of the one before within a 2% error, and the chain
+// ends when a level no longer removes a tenth of them.
+const int LOD_MAX_LEVELS = 6;
+const float LOD_RATIO = 0.5f;
+const float LOD_MAX_ERROR = 0.02f;
+const float LOD_MIN_REDUCTION = 0.9f;
+const unsigned int REFINE_BYTES = 4096;
+const float PROGRESSIVE_ERROR_FACTOR = 2.0f;
+
+
+// MakeSphere subdivides an octahedron into a unit sphere, sharing the midpoint of every edge between its two triangles.
+static void MakeSphere(std::vector<VertexType>& verts, std::vector<uint32_t>& indices)
+{
+	static const float corners[6][3] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+	static const uint32_t faces[24] = { 0, 2, 4, 2, 1, 4, 1, 3, 4, 3, 0, 4, 2, 0, 5, 1, 2, 5, 3, 1, 5, 0, 3, 5 };
+	std::map<std::pair<uint32_t, uint32_t>, uint32_t> midpoints;
+	std::vector<uint32_t> coarse;
+	uint32_t triangle[3], middle[3];
+	XMVECTOR position;
+	int level, k;
+	size_t i;
+
+
+	verts.clear();
+	for (i = 0; i < 6; i++)
+	{
+		VertexType vertex = {};
+		vertex.position = XMFLOAT3(corners[i][0], corners[i][1], corners[i][2]);
+		verts.push_back(vertex);
+	}
+	indices.assign(faces, faces + 24);
+
+	for (level = 0; level < SPHERE_SUBDIVISIONS; level++)
+	{
+		coarse.swap(indices);
+		indices.clear();
+		midpoints.clear();
+		for (i = 0; i < coarse.size(); i += 3)
+		{
+			for (k = 0; k < 3; k++)
+			{
+				triangle[k] = coarse[i + k];
+			}
+
+			for (k = 0; k < 3; k++)
+			{
+				auto edge = std::make_pair(std::min(triangle[k], triangle[(k + 1) % 3]), std::max(triangle[k], triangle[(k + 1) % 3]));
+				auto found = midpoints.find(edge);
+				if (found != midpoints.end())
+				{
+					middle[k] = found->second;
+					continue;
+				}
+
+				VertexType vertex = {};
+				position = XMVectorAdd(XMLoadFloat3(&verts[edge.first].position), XMLoadFloat3(&verts[edge.second].position));
+				XMStoreFloat3(&vertex.position, XMVector3Normalize(position));
+				middle[k] = (uint32_t)verts.size();
+				midpoints[edge] = middle[k];
+				verts.push_back(vertex);
+			}
+
+			indices.insert(indices.end(), { triangle[0], middle[0], middle[2] });
+			indices.insert(indices.end(), { middle[0], triangle[1], middle[1] });
+			indices.insert(indices.end(), { middle[2], middle[1], triangle[2] });
+			indices.insert(indices.end(), { middle[0], middle[1], middle[2] });
+		}
+	}
+
+	// The normals point out of the sphere, so the attribute penalty does not get in the way of the collapses.
+	for (i = 0; i < verts.size(); i++)
+	{
+		verts[i].normal = verts[i].position;
+	}
+
+	return;
+}
+
+
+// SurfaceDistance returns how far the triangles get from the unit sphere, measured at their corners and centers. The corners are
+// always vertices of the sphere, the centers are where a flat triangle is furthest inside it.
+static float SurfaceDistance(const std::vector<VertexType>& verts, const uint32_t* indices, size_t indexCount)
+{
+	XMVECTOR center;
+	float distance;
+	size_t i;
+
+
+	distance = 0.0f;
+	for (i = 0; i + 2 < indexCount; i += 3)
+	{
+		center = XMVectorAdd(XMVectorAdd(XMLoadFloat3(&verts[indices[i]].position), XMLoadFloat3(&verts[indices[i + 1]].position)),
+			XMLoadFloat3(&verts[indices[i + 2]].position));
+		center = XMVectorScale(center, 1.0f / 3.0f);
+		distance = fmaxf(distance, fabsf(1.0f - XMVectorGetX(XMVector3Length(center))));
+	}
+
+	return distance;
+}
+
+
+// TestSimplifierChain builds the levels of detail one from the other like ModelClass does. A level either reaches its triangle target
+// or stops at the error limit, and its error summed over the chain bounds its distance from the sphere beyond what the full mesh has.
+static void TestSimplifierChain()
+{
+	MeshSimplifierClass simplifier;
+	std::vector<VertexType> verts;
+	std::vector<uint32_t> indices, previous, simplified;
+	unsigned int targetIndexCount;
+	float scale, error, levelError, baseDistance, distance;
+	int level, levelCount;
+
+
+	MakeSphere(verts, indices);
+	scale = simplifier.GetScale(verts);
+	CHECK(fabsf(scale - 2.0f) < 1.0e-5f);
+
+	baseDistance = SurfaceDistance(verts, indices.data(), indices.size());
+	previous = indices;
+	error = 0.0f;
+	levelCount = 1;
+	for (level = 1; level < LOD_MAX_LEVELS; level++)
+	{
+		targetIndexCount = (unsigned int)(previous.size() * LOD_RATIO) / 3 * 3;
+		levelError = simplifier.Simplify(verts, previous, targetIndexCount, LOD_MAX_ERROR, simplified);
+		CHECK(simplified.size() % 3 == 0);
+		CHECK(levelError >= 0.0f && levelError <= LOD_MAX_ERROR);
+		CHECK(simplified.size() <= previous.size());
+
+		// Stopping short of the target is only allowed at the error limit.
+		CHECK(simplified.size() <= targetIndexCount || levelError > LOD_MAX_ERROR * 0.5f);
+
+		if (simplified.empty() || simplified.size() > previous.size() * LOD_MIN_REDUCTION)
+		{
+			break;
+		}
+
+		error += levelError * scale;
+		distance = SurfaceDistance(verts, simplified.data(), simplified.size());
+		CHECK(distance <= baseDistance + error);
+
+		previous = simplified;
+		levelCount++;
+	}
+
+	// A sphere of 8192 triangles halves at least twice before the 2% limit stops it.
+	CHECK(levelCount >= 3);
+	CHECK(previous.size() <= indices.size() / 4);
+
+	return;
+}
+
+
+static bool WriteBytes(const char* filename, const char* data, size_t size)
+{
+	std::ofstream file;
+
+
+	file.open(filename, std::ios::binary | std::ios::trunc);
+	file.write(data, (std::streamsize)size);
+	file.close();
+
+	return (bool)file;
+}
+
+
+// Triangles returns the triangles the loader has so far, every submesh of it from the start of its slot.
+static std::vector<uint32_t> Triangles(ProgressiveLoaderClass& loader)
+{
+	std::vector<uint32_t> indices;
+	unsigned int i;
+
+
+	for (i = 0; i < loader.GetSubmeshCount(); i++)
+	{
+		indices.insert(indices.end(), loader.GetIndices() + loader.GetSubmeshes()[i].startIndex,
+			loader.GetIndices() + loader.GetSubmeshes()[i].startIndex + loader.GetSubmeshes()[i].indexCount);
+	}
+
+	return indices;
+}
+
+
+// MeshIsValid checks that the mesh so far only uses the vertices it has and that its error bounds its distance from the sphere. The
+// error is the furthest a collapsed vertex got from the planes it replaced, the middle of the wide triangles of the base mesh sags
+// up to half as far again, so the bound is twice the error.
+static bool MeshIsValid(ProgressiveLoaderClass& loader, float baseDistance)
+{
+	std::vector<VertexType> verts;
+	std::vector<uint32_t> indices;
+	size_t i;
+
+
+	indices = Triangles(loader);
+	for (i = 0; i < indices.size(); i++)
+	{
+		if (indices[i] >= loader.GetVertexCount())
+		{
+			return false;
+		}
+	}
+
+	verts.assign(loader.GetVertices(), loader.GetVertices() + loader.GetVertexCount());
+
+	return indices.size() % 3 == 0 && SurfaceDistance(verts, indices.data(), indices.size()) <=
+		baseDistance + PROGRESSIVE_ERROR_FACTOR * loader.GetError();
+}
+
+
+// TestProgressiveStream streams the sphere in steps of a few kilobytes, then stops it at an error, then loads a copy cut in half.
+static void TestProgressiveStream()
+{
+	ProgressiveMeshClass progressive;
+	ProgressiveMeshClass::BuildStatsType buildStats;
+	ProgressiveLoaderClass loader;
+	ProgressiveLoaderClass::LoadStatsType stats, previousStats;
+	std::vector<VertexType> verts;
+	std::vector<uint32_t> indices;
+	std::vector<MeshSubmeshType> submeshes;
+	MeshMaterialListType materials;
+	MeshSubmeshType submesh;
+	const std::vector<char>* data;
+	float baseDistance, previousError, targetError;
+	size_t cutSize;
+
+
+	MakeSphere(verts, indices);
+	baseDistance = SurfaceDistance(verts, indices.data(), indices.size());
+	submesh.material = 0;
+	submesh.startIndex = 0;
+	submesh.indexCount = (unsigned int)indices.size();
+	submeshes.push_back(submesh);
+	materials.names.push_back(std::string());
+
+	CHECK(WriteBytes(LOD_TEST_SOURCE_NAME, "o sphere\n", 9));
+	CHECK(progressive.Build(verts, indices, submeshes, materials));
+	CHECK(progressive.Write(LOD_TEST_STREAM_NAME, LOD_TEST_SOURCE_NAME));
+	buildStats = progressive.GetStats();
+	CHECK(buildStats.baseTriangleCount > 0 && buildStats.baseTriangleCount < indices.size() / 3);
+	CHECK(buildStats.splitCount > 0);
+
+	// The base has the error the build reports, and every step reads at most its budget and only ever lowers the error.
+	CHECK(loader.Initialize(LOD_TEST_STREAM_NAME, LOD_TEST_SOURCE_NAME));
+	stats = loader.GetStats();
+	CHECK(stats.triangleCount == buildStats.baseTriangleCount && stats.triangleCapacity == indices.size() / 3);
+	CHECK(loader.GetError() == buildStats.baseError);
+	CHECK(MeshIsValid(loader, baseDistance));
+	while (!loader.IsComplete())
+	{
+		previousStats = loader.GetStats();
+		previousError = loader.GetError();
+		CHECK(loader.Refine(REFINE_BYTES, 0.0f));
+		stats = loader.GetStats();
+		CHECK(stats.bytesRead - previousStats.bytesRead <= REFINE_BYTES);
+		CHECK(stats.triangleCount >= previousStats.triangleCount && loader.GetError() <= previousError);
+		if (stats.bytesRead == previousStats.bytesRead && !loader.IsComplete())
+		{
+			CHECK(!"the stream stopped before its end");
+			break;
+		}
+	}
+	CHECK(MeshIsValid(loader, baseDistance));
+	CHECK(loader.GetStats().triangleCount == indices.size() / 3 && loader.GetError() == 0.0f);
+	loader.Shutdown();
+
+	// Refining to an error stops at the first split that reaches it.
+	targetError = buildStats.baseError * 0.25f;
+	CHECK(loader.Initialize(LOD_TEST_STREAM_NAME, LOD_TEST_SOURCE_NAME));
+	CHECK(loader.Refine(UINT32_MAX, targetError));
+	CHECK(loader.GetError() <= targetError && !loader.IsComplete());
+	CHECK(MeshIsValid(loader, baseDistance));
+	loader.Shutdown();
+
+	// A stream cut in the middle of its splits is read up to the last whole split and left there.
+	data = &progressive.GetFileData();
+	cutSize = (size_t)(buildStats.baseBytes + (data->size() - buildStats.baseBytes) / 2);
+	CHECK(WriteBytes(LOD_TEST_CUT_STREAM_NAME, data->data(), cutSize));
+	CHECK(loader.Initialize(LOD_TEST_CUT_STREAM_NAME, LOD_TEST_SOURCE_NAME));
+	CHECK(loader.Refine(UINT32_MAX, 0.0f));
+	stats = loader.GetStats();
+	CHECK(!loader.IsComplete() && stats.splitsApplied > 0 && stats.splitsApplied < stats.splitCount);
+	CHECK(stats.triangleCount > buildStats.baseTriangleCount && stats.triangleCount < indices.size() / 3);
+	CHECK(loader.GetError() > 0.0f && loader.GetError() < buildStats.baseError);
+	CHECK(MeshIsValid(loader, baseDistance));
+
+	// Nothing more comes of asking again.
+	CHECK(loader.Refine(UINT32_MAX, 0.0f));
+	CHECK(loader.GetStats().splitsApplied == stats.splitsApplied);
+	loader.Shutdown();
+
+	return;
+}
+
+
+int main()
+{
+	TestSimplifierChain();
+	TestProgressiveStream();
+	remove(LOD_TEST_SOURCE_NAME);
+	remove(LOD_TEST_STREAM_NAME);
+	remove(LOD_TEST_CUT_STREAM_NAME);
+
+	return TEST_RESULT;
+}
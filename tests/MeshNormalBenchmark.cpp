@@ -0,0 +1,143 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: MeshNormalBenchmark.cpp
+////////////////////////////////////////////////////////////////////////////////
+// Generates a height field of about a million triangles with no normals, generates its normals and then the tangent frames of the
+// welded mesh, once on the calling thread and once on every hardware thread. The texture mapping is mirrored down the middle of
+// the field so the tangent pass also splits the vertices on the mirror line. It prints the time of each pass, the best of a few
+// runs, and the triangles per second.
+//
+//     mesh_normal_benchmark [grid size] [repeats]
+//
+// The default grid of 708 x 708 quads is a little over a million triangles.
+#include "meshnormalclass.h"
+#include "BenchmarkUtils.h"
+#include <cmath>
+#include <cstdlib>
+
+
+/////////////
+// GLOBALS //
+/////////////
+const int BENCHMARK_DEFAULT_GRID = 708;
+const int BENCHMARK_DEFAULT_REPEATS = 3;
+
+
+// MakeGrid makes a smooth rolling field, so the normals and tangents only change a little from one vertex to the next as on a real
+// surface and the splits stay on the mirror line.
+static void MakeGrid(int size, std::vector<XMFLOAT3>& positions, std::vector<unsigned int>& positionIndices)
+{
+	float u, v;
+	int x, y;
+	unsigned int a, b, c, d;
+
+
+	positions.clear();
+	for (y = 0; y <= size; y++)
+	{
+		for (x = 0; x <= size; x++)
+		{
+			u = (float)x / size;
+			v = (float)y / size;
+			positions.push_back(XMFLOAT3(u, 0.05f * sinf(u * 20.0f) * cosf(v * 15.0f), v));
+		}
+	}
+
+	positionIndices.clear();
+	for (y = 0; y < size; y++)
+	{
+		for (x = 0; x < size; x++)
+		{
+			a = y * (size + 1) + x;
+			b = a + 1;
+			c = a + size + 1;
+			d = c + 1;
+			positionIndices.insert(positionIndices.end(), { a, c, d, a, d, b });
+		}
+	}
+
+	return;
+}
+
+
+static bool RunPasses(const std::vector<XMFLOAT3>& positions, const std::vector<unsigned int>& positionIndices, unsigned int threadCount,
+	int repeats)
+{
+	MeshNormalClass generator;
+	MeshNormalClass::GenerateStatsType stats;
+	std::vector<XMFLOAT3> normals;
+	std::vector<unsigned int> normalIndices;
+	std::vector<VertexType> verts;
+	std::vector<uint32_t> indices;
+	std::vector<XMFLOAT4> tangents;
+	double normalBest, tangentBest;
+	size_t triangleCount, i;
+	int run;
+
+
+	generator.SetThreadCount(threadCount);
+	triangleCount = positionIndices.size() / 3;
+	normalBest = tangentBest = 0.0;
+	for (run = 0; run < repeats; run++)
+	{
+		normals.clear();
+		normalIndices.assign(positionIndices.size(), MESH_INDEX_NONE);
+		if (!generator.GenerateNormals(positions, positionIndices, normals, normalIndices))
+		{
+			return false;
+		}
+		stats = generator.GetStats();
+		normalBest = (run == 0 || stats.normalSeconds < normalBest) ? stats.normalSeconds : normalBest;
+
+		// Weld by position, which the smooth field allows, with u running back from the middle.
+		verts.resize(positions.size());
+		for (i = 0; i < positionIndices.size(); i++)
+		{
+			VertexType& vertex = verts[positionIndices[i]];
+			vertex.position = positions[positionIndices[i]];
+			vertex.normal = normals[normalIndices[i]];
+			vertex.texture = XMFLOAT2(fabsf(vertex.position.x - 0.5f), vertex.position.z);
+		}
+		indices.assign(positionIndices.begin(), positionIndices.end());
+
+		if (!generator.GenerateTangents(verts, indices, tangents))
+		{
+			return false;
+		}
+		stats = generator.GetStats();
+		tangentBest = (run == 0 || stats.tangentSeconds < tangentBest) ? stats.tangentSeconds : tangentBest;
+	}
+
+	printf("%u threads: normals %.3f s, %.1f M triangles/s; tangents %.3f s, %.1f M triangles/s, %u split, %u degenerate\n",
+		stats.threadCount, normalBest, triangleCount / normalBest * 1.0e-6, tangentBest, triangleCount / tangentBest * 1.0e-6,
+		stats.splitVertexCount, stats.degenerateTangentCount);
+
+	return true;
+}
+
+
+int main(int argc, char** argv)
+{
+	std::vector<XMFLOAT3> positions;
+	std::vector<unsigned int> positionIndices;
+	int size, repeats;
+
+
+	size = argc > 1 ? atoi(argv[1]) : BENCHMARK_DEFAULT_GRID;
+	repeats = argc > 2 ? atoi(argv[2]) : BENCHMARK_DEFAULT_REPEATS;
+	if (size <= 0 || repeats <= 0)
+	{
+		printf("usage: %s [grid size] [repeats]\n", argv[0]);
+		return 1;
+	}
+
+	MakeGrid(size, positions, positionIndices);
+	printf("Grid of %d x %d quads: %zu positions, %zu triangles\n", size, size, positions.size(), positionIndices.size() / 3);
+
+	if (!RunPasses(positions, positionIndices, 1, repeats) || !RunPasses(positions, positionIndices, 0, repeats))
+	{
+		printf("Could not generate the frames\n");
+		return 1;
+	}
+
+	return 0;
+}
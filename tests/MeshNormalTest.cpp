@@ -0,0 +1,145 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: MeshNormalTest.cpp
+////////////////////////////////////////////////////////////////////////////////
+// Generates tangent frames for two quads that share an edge and whose texture mapping is mirrored across it, and checks that
+// every corner gets a unit tangent at a right angle to its normal pointing along increasing u, that w gives the bitangent along
+// increasing v on both sides, and that the two vertices on the mirror edge are split so each side has its own frame. A quad with
+// no texture mapping gets frames that are still orthonormal.
+#include "meshnormalclass.h"
+#include "TestUtils.h"
+#include <cmath>
+
+
+/////////////
+// GLOBALS //
+/////////////
+const float TANGENT_EPSILON = 1.0e-5f;
+
+
+// MakeMirroredQuads lays two unit quads side by side in the xy plane facing -z, u runs along +x on the left one and back along -x
+// on the right one, so both meet at u = 1 on the shared edge and the corners there weld into one vertex.
+static void MakeMirroredQuads(std::vector<VertexType>& verts, std::vector<uint32_t>& indices)
+{
+	int x, y;
+
+
+	verts.clear();
+	for (y = 0; y <= 1; y++)
+	{
+		for (x = 0; x <= 2; x++)
+		{
+			VertexType vertex = {};
+			vertex.position = XMFLOAT3((float)x, (float)y, 0.0f);
+			vertex.texture = XMFLOAT2(x <= 1 ? (float)x : 2.0f - x, (float)y);
+			vertex.normal = XMFLOAT3(0.0f, 0.0f, -1.0f);
+			verts.push_back(vertex);
+		}
+	}
+
+	indices = { 0, 3, 4, 0, 4, 1, 1, 4, 5, 1, 5, 2 };
+
+	return;
+}
+
+
+// IsFrame checks that the tangent is unit length and at a right angle to the normal and that w is a sign.
+static bool IsFrame(const XMFLOAT3& normal, const XMFLOAT4& tangent)
+{
+	float length, dot;
+
+
+	length = sqrtf(tangent.x * tangent.x + tangent.y * tangent.y + tangent.z * tangent.z);
+	dot = normal.x * tangent.x + normal.y * tangent.y + normal.z * tangent.z;
+
+	return fabsf(length - 1.0f) < TANGENT_EPSILON && fabsf(dot) < TANGENT_EPSILON && (tangent.w == 1.0f || tangent.w == -1.0f);
+}
+
+
+static void TestMirroredQuads()
+{
+	std::vector<VertexType> verts;
+	std::vector<uint32_t> indices;
+	std::vector<XMFLOAT4> tangents;
+	MeshNormalClass normals;
+	MeshNormalClass::GenerateStatsType stats;
+	XMFLOAT3 bitangent;
+	float expectedX;
+	bool valid;
+	size_t i;
+
+
+	MakeMirroredQuads(verts, indices);
+	normals.SetThreadCount(1);
+	CHECK(normals.GenerateTangents(verts, indices, tangents));
+	stats = normals.GetStats();
+
+	// The two vertices on the shared edge are split, the copies are appended and keep their position.
+	CHECK(verts.size() == 8 && tangents.size() == 8);
+	CHECK(stats.splitVertexCount == 2 && stats.tangentCount == 8 && stats.degenerateTangentCount == 0);
+	CHECK(verts.size() == 8 && verts[6].position.x == 1.0f && verts[7].position.x == 1.0f);
+
+	valid = tangents.size() == verts.size();
+	for (i = 0; i < indices.size() && valid; i++)
+	{
+		const VertexType& vertex = verts[indices[i]];
+		const XMFLOAT4& tangent = tangents[indices[i]];
+
+		// The first two triangles are the left quad, u grows along +x there and along -x on the right quad.
+		expectedX = i < 6 ? 1.0f : -1.0f;
+		valid = IsFrame(vertex.normal, tangent) && fabsf(tangent.x - expectedX) < TANGENT_EPSILON;
+
+		// cross(normal, tangent) * w has to point along increasing v, +y, on both sides, which takes opposite signs.
+		bitangent.x = (vertex.normal.y * tangent.z - vertex.normal.z * tangent.y) * tangent.w;
+		bitangent.y = (vertex.normal.z * tangent.x - vertex.normal.x * tangent.z) * tangent.w;
+		bitangent.z = (vertex.normal.x * tangent.y - vertex.normal.y * tangent.x) * tangent.w;
+		valid = valid && fabsf(bitangent.x) < TANGENT_EPSILON && fabsf(bitangent.y - 1.0f) < TANGENT_EPSILON && fabsf(bitangent.z) < TANGENT_EPSILON;
+		valid = valid && tangent.w == tangents[indices[i / 3 * 3]].w;
+	}
+	CHECK(valid);
+	CHECK(tangents.size() == 8 && tangents[indices[0]].w == -tangents[indices[6]].w);
+
+	return;
+}
+
+
+// Without a texture mapping there is no direction of u, every vertex still gets some tangent in the plane of its normal.
+static void TestDegenerateMapping()
+{
+	std::vector<VertexType> verts;
+	std::vector<uint32_t> indices;
+	std::vector<XMFLOAT4> tangents;
+	MeshNormalClass normals;
+	bool valid;
+	size_t i;
+
+
+	MakeMirroredQuads(verts, indices);
+	for (i = 0; i < verts.size(); i++)
+	{
+		verts[i].texture = XMFLOAT2(0.5f, 0.5f);
+	}
+	CHECK(normals.GenerateTangents(verts, indices, tangents));
+	CHECK(verts.size() == 6 && normals.GetStats().splitVertexCount == 0 && normals.GetStats().degenerateTangentCount == 6);
+
+	valid = tangents.size() == verts.size();
+	for (i = 0; i < tangents.size() && valid; i++)
+	{
+		valid = IsFrame(verts[i].normal, tangents[i]);
+	}
+	CHECK(valid);
+
+	// An index past the vertices is refused.
+	indices[0] = 6;
+	CHECK(!normals.GenerateTangents(verts, indices, tangents));
+
+	return;
+}
+
+
+int main()
+{
+	TestMirroredQuads();
+	TestDegenerateMapping();
+
+	return TEST_RESULT;
+}
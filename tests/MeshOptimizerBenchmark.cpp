@@ -0,0 +1,134 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: MeshOptimizerBenchmark.cpp
+////////////////////////////////////////////////////////////////////////////////
+// Loads a large generated OBJ file, or the one it is given, parses and welds it the way the model loader does, and runs the
+// mesh optimizer over it twice, once in the order of the file and once with its triangles shuffled as a careless exporter leaves
+// them. For each it prints the vertex cache miss ratios, the overfetch and the overdraw before and after, and how long Optimize took.
+//
+//     mesh_optimizer_benchmark [grid size | OBJ file]
+//
+// The default grid of 512 x 512 quads is half a million triangles.
+#include "objparserclass.h"
+#include "meshweldclass.h"
+#include "meshoptimizerclass.h"
+#include "BenchmarkUtils.h"
+#include <algorithm>
+#include <cstdlib>
+
+
+/////////////
+// GLOBALS //
+/////////////
+const int BENCHMARK_DEFAULT_GRID = 512;
+const unsigned int BENCHMARK_CACHE_SIZE = 16;
+const float BENCHMARK_WELD_TOLERANCE = 1.0e-6f;
+const char* BENCHMARK_FILE_NAME = "mesh_optimizer_benchmark.obj";
+
+
+static void PrintStats(const char* label, const std::vector<VertexType>& verts, const std::vector<uint32_t>& indices)
+{
+	MeshOptimizerClass optimizer;
+	MeshOptimizerClass::VertexCacheStatsType cache;
+	MeshOptimizerClass::VertexFetchStatsType fetch;
+	MeshOptimizerClass::OverdrawStatsType overdraw;
+
+
+	cache = optimizer.AnalyzeVertexCache(indices, (unsigned int)verts.size(), BENCHMARK_CACHE_SIZE);
+	fetch = optimizer.AnalyzeVertexFetch(indices, (unsigned int)verts.size(), sizeof(VertexType));
+	overdraw = optimizer.AnalyzeOverdraw(indices, verts);
+	printf("  %-7s ACMR %.3f, ATVR %.3f, overfetch %.3f, overdraw %.3f\n", label, cache.acmr, cache.atvr, fetch.overfetch,
+		overdraw.overdraw);
+
+	return;
+}
+
+
+static void RunOptimizer(const char* label, std::vector<VertexType> verts, std::vector<uint32_t> indices)
+{
+	MeshOptimizerClass optimizer;
+	double seconds;
+
+
+	printf("%s:\n", label);
+	PrintStats("before", verts, indices);
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	optimizer.Optimize(verts, indices);
+	seconds = SecondsSince(start);
+
+	PrintStats("after", verts, indices);
+	printf("  Optimize %.3f s, %.1f M triangles/s\n", seconds, indices.size() / 3 / seconds * 1.0e-6);
+
+	return;
+}
+
+
+int main(int argc, char** argv)
+{
+	ObjParserClass parser;
+	ObjParserClass::ObjDataType obj;
+	MeshWeldClass weld;
+	std::vector<VertexType> verts;
+	std::vector<uint32_t> indices, shuffled;
+	const char* filename;
+	char* end;
+	unsigned int seed;
+	int size;
+	size_t i, j;
+	bool result;
+
+
+	// A first argument that is not a number is the OBJ file to optimize.
+	size = BENCHMARK_DEFAULT_GRID;
+	filename = BENCHMARK_FILE_NAME;
+	if (argc > 1)
+	{
+		size = (int)strtol(argv[1], &end, 10);
+		if (*end != '\0')
+		{
+			filename = argv[1];
+			size = 0;
+		}
+	}
+	if (filename == BENCHMARK_FILE_NAME && size <= 0)
+	{
+		printf("usage: %s [grid size | OBJ file]\n", argv[0]);
+		return 1;
+	}
+
+	if (size > 0 && !WriteGridObj(BENCHMARK_FILE_NAME, size))
+	{
+		printf("Could not write %s\n", BENCHMARK_FILE_NAME);
+		return 1;
+	}
+
+	result = parser.Parse(filename, obj);
+	if (size > 0)
+	{
+		remove(BENCHMARK_FILE_NAME);
+	}
+	weld.SetTolerance(BENCHMARK_WELD_TOLERANCE);
+	weld.SetRemoveDegenerates(true);
+	if (!result || !weld.Weld(obj.positions, obj.uvs, obj.normals, obj.positionIndices, obj.uvIndices, obj.normalIndices, verts, indices,
+		nullptr))
+	{
+		printf("Could not load %s\n", filename);
+		return 1;
+	}
+	printf("%s: %zu vertices, %zu triangles\n", filename, verts.size(), indices.size() / 3);
+
+	// The same fixed linear congruential shuffle of whole triangles as the optimizer test, so every run sees the same order.
+	shuffled = indices;
+	seed = 12345;
+	for (i = indices.size() / 3 - 1; i > 0; i--)
+	{
+		seed = seed * 1664525 + 1013904223;
+		j = seed % (i + 1);
+		std::swap_ranges(shuffled.begin() + i * 3, shuffled.begin() + i * 3 + 3, shuffled.begin() + j * 3);
+	}
+
+	RunOptimizer("File order", verts, indices);
+	RunOptimizer("Shuffled triangles", verts, shuffled);
+
+	return 0;
+}
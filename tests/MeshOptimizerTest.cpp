@@ -0,0 +1,223 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: MeshOptimizerTest.cpp
+////////////////////////////////////////////////////////////////////////////////
+// Optimizes a grid whose triangles are shuffled and checks that the vertex cache miss ratio and the overfetch go down to what a
+// well ordered grid gets, while the mesh keeps the same triangles with the same winding. It also checks the overdraw measure on two
+// stacked quads, which shade every covered pixel twice drawn back to front and once drawn front to back.
+#include "meshoptimizerclass.h"
+#include "TestUtils.h"
+#include <algorithm>
+#include <array>
+
+
+/////////////
+// GLOBALS //
+/////////////
+const int GRID_SIZE = 64;
+const unsigned int CACHE_SIZE = 16;
+// Forsyth's ordering of a regular grid comes out near 0.65 transforms a triangle with a 16 entry cache, 0.5 is the bound.
+const float OPTIMIZED_ACMR_LIMIT = 0.8f;
+
+
+static void MakeShuffledGrid(std::vector<VertexType>& verts, std::vector<uint32_t>& indices)
+{
+	std::vector<std::array<uint32_t, 3>> triangles;
+	unsigned int seed, a, b, c, d;
+	int x, y;
+	size_t i;
+
+
+	verts.clear();
+	for (y = 0; y <= GRID_SIZE; y++)
+	{
+		for (x = 0; x <= GRID_SIZE; x++)
+		{
+			VertexType vertex = {};
+			vertex.position = XMFLOAT3((float)x, (float)y, 0.0f);
+			vertex.normal = XMFLOAT3(0.0f, 0.0f, -1.0f);
+			verts.push_back(vertex);
+		}
+	}
+
+	for (y = 0; y < GRID_SIZE; y++)
+	{
+		for (x = 0; x < GRID_SIZE; x++)
+		{
+			a = y * (GRID_SIZE + 1) + x;
+			b = a + 1;
+			c = a + GRID_SIZE + 1;
+			d = c + 1;
+			triangles.push_back({ a, c, d });
+			triangles.push_back({ a, d, b });
+		}
+	}
+
+	// A fixed linear congruential shuffle, so the test sees the same order every run.
+	seed = 12345;
+	for (i = triangles.size() - 1; i > 0; i--)
+	{
+		seed = seed * 1664525 + 1013904223;
+		std::swap(triangles[i], triangles[seed % (i + 1)]);
+	}
+
+	indices.clear();
+	for (i = 0; i < triangles.size(); i++)
+	{
+		indices.insert(indices.end(), triangles[i].begin(), triangles[i].end());
+	}
+
+	return;
+}
+
+
+// The triangles of a mesh by the grid points of their corners, each rotated to start at its smallest corner so the winding is kept,
+// and sorted, so meshes that only order their triangles or vertices differently compare equal.
+static std::vector<std::array<int, 3>> TriangleSet(const std::vector<VertexType>& verts, const std::vector<uint32_t>& indices)
+{
+	std::vector<std::array<int, 3>> triangles;
+	std::array<int, 3> triangle;
+	size_t i;
+	int k;
+
+
+	for (i = 0; i + 2 < indices.size(); i += 3)
+	{
+		for (k = 0; k < 3; k++)
+		{
+			triangle[k] = (int)verts[indices[i + k]].position.y * (GRID_SIZE + 1) + (int)verts[indices[i + k]].position.x;
+		}
+		while (triangle[0] > triangle[1] || triangle[0] > triangle[2])
+		{
+			std::rotate(triangle.begin(), triangle.begin() + 1, triangle.end());
+		}
+		triangles.push_back(triangle);
+	}
+	std::sort(triangles.begin(), triangles.end());
+
+	return triangles;
+}
+
+
+static void TestOptimize()
+{
+	std::vector<VertexType> verts;
+	std::vector<uint32_t> indices;
+	std::vector<std::array<int, 3>> trianglesBefore;
+	MeshOptimizerClass optimizer;
+	MeshOptimizerClass::VertexCacheStatsType cacheBefore, cacheAfter;
+	MeshOptimizerClass::VertexFetchStatsType fetchBefore, fetchAfter;
+
+
+	MakeShuffledGrid(verts, indices);
+	trianglesBefore = TriangleSet(verts, indices);
+	cacheBefore = optimizer.AnalyzeVertexCache(indices, (unsigned int)verts.size(), CACHE_SIZE);
+	fetchBefore = optimizer.AnalyzeVertexFetch(indices, (unsigned int)verts.size(), sizeof(VertexType));
+
+	optimizer.Optimize(verts, indices);
+	cacheAfter = optimizer.AnalyzeVertexCache(indices, (unsigned int)verts.size(), CACHE_SIZE);
+	fetchAfter = optimizer.AnalyzeVertexFetch(indices, (unsigned int)verts.size(), sizeof(VertexType));
+	printf("ACMR %.3f -> %.3f, ATVR %.3f -> %.3f, overfetch %.3f -> %.3f\n", cacheBefore.acmr, cacheAfter.acmr, cacheBefore.atvr,
+		cacheAfter.atvr, fetchBefore.overfetch, fetchAfter.overfetch);
+
+	// A shuffled grid misses the cache on almost every corner.
+	CHECK(cacheBefore.acmr > 2.0f);
+	CHECK(cacheAfter.acmr < OPTIMIZED_ACMR_LIMIT);
+	CHECK(cacheAfter.acmr >= 0.5f);
+	CHECK(cacheAfter.atvr >= 1.0f && cacheAfter.atvr < cacheBefore.atvr);
+	CHECK(fetchAfter.overfetch <= fetchBefore.overfetch);
+	CHECK(fetchAfter.overfetch < 2.0f);
+
+	CHECK(verts.size() == (size_t)(GRID_SIZE + 1) * (GRID_SIZE + 1));
+	CHECK(TriangleSet(verts, indices) == trianglesBefore);
+
+	return;
+}
+
+
+// With submeshes every run is optimized by itself, so each keeps exactly the triangles it had.
+static void TestOptimizeSubmeshes()
+{
+	std::vector<VertexType> verts;
+	std::vector<uint32_t> indices, runIndices;
+	std::vector<MeshSubmeshType> submeshes;
+	std::vector<std::array<int, 3>> runsBefore[2];
+	MeshOptimizerClass optimizer;
+	MeshSubmeshType submesh;
+	float acmrBefore;
+	size_t half, i;
+
+
+	MakeShuffledGrid(verts, indices);
+	half = indices.size() / 6 * 3;
+	submesh.material = 0;
+	submesh.startIndex = 0;
+	submesh.indexCount = (unsigned int)half;
+	submeshes.push_back(submesh);
+	submesh.material = 1;
+	submesh.startIndex = (unsigned int)half;
+	submesh.indexCount = (unsigned int)(indices.size() - half);
+	submeshes.push_back(submesh);
+
+	for (i = 0; i < 2; i++)
+	{
+		runIndices.assign(indices.begin() + submeshes[i].startIndex, indices.begin() + submeshes[i].startIndex + submeshes[i].indexCount);
+		runsBefore[i] = TriangleSet(verts, runIndices);
+	}
+
+	acmrBefore = optimizer.AnalyzeVertexCache(indices, (unsigned int)verts.size(), CACHE_SIZE).acmr;
+	optimizer.Optimize(verts, indices, submeshes);
+
+	for (i = 0; i < 2; i++)
+	{
+		runIndices.assign(indices.begin() + submeshes[i].startIndex, indices.begin() + submeshes[i].startIndex + submeshes[i].indexCount);
+		CHECK(TriangleSet(verts, runIndices) == runsBefore[i]);
+	}
+	// Each run is a scattered half of the grid, which can not get as low as the whole grid but still has to gain most of the way.
+	CHECK(optimizer.AnalyzeVertexCache(indices, (unsigned int)verts.size(), CACHE_SIZE).acmr < acmrBefore * 0.5f);
+
+	return;
+}
+
+
+static void TestAnalyzeOverdraw()
+{
+	std::vector<VertexType> verts(8);
+	std::vector<uint32_t> backToFront = { 4, 5, 6, 4, 6, 7, 0, 1, 2, 0, 2, 3 };
+	std::vector<uint32_t> frontToBack = { 0, 1, 2, 0, 2, 3, 4, 5, 6, 4, 6, 7 };
+	MeshOptimizerClass optimizer;
+	MeshOptimizerClass::OverdrawStatsType back, front;
+	unsigned int i;
+
+
+	// Two quads facing -z, the first at z = 0 in front of the second at z = 1. Only the view along +z sees their front faces.
+	for (i = 0; i < 8; i++)
+	{
+		verts[i].position = XMFLOAT3((float)((i & 3) >= 2), (float)((i & 3) == 1 || (i & 3) == 2), (float)(i / 4));
+		verts[i].normal = XMFLOAT3(0.0f, 0.0f, -1.0f);
+	}
+
+	back = optimizer.AnalyzeOverdraw(backToFront, verts);
+	front = optimizer.AnalyzeOverdraw(frontToBack, verts);
+	CHECK(back.pixelsCovered > 0 && back.pixelsCovered == front.pixelsCovered);
+	CHECK(back.pixelsShaded == back.pixelsCovered * 2 && back.overdraw == 2.0f);
+	CHECK(front.pixelsShaded == front.pixelsCovered && front.overdraw == 1.0f);
+
+	// Turned around, the quads face the view along -z, which sees the quad at z = 1 in front, so the same order is now back to front.
+	std::swap(frontToBack[1], frontToBack[2]);
+	std::swap(frontToBack[4], frontToBack[5]);
+	std::swap(frontToBack[7], frontToBack[8]);
+	std::swap(frontToBack[10], frontToBack[11]);
+	CHECK(optimizer.AnalyzeOverdraw(frontToBack, verts).overdraw == 2.0f);
+
+	return;
+}
+
+
+int main()
+{
+	TestOptimize();
+	TestOptimizeSubmeshes();
+	TestAnalyzeOverdraw();
+
+	return TEST_RESULT;
+}
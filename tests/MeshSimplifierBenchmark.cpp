@@ -0,0 +1,135 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: MeshSimplifierBenchmark.cpp
+////////////////////////////////////////////////////////////////////////////////
+// Loads a large generated OBJ file, or the one it is given, parses and welds it the way the model loader does, and simplifies the
+// whole mesh to a half, a quarter, a tenth and a hundredth of its triangles with no error limit. For each it prints the triangles
+// and the error it reached, how long Simplify took, the best of a few runs, and the input triangles simplified per second.
+// The smallest target is also run with the collapses recorded, as the progressive meshes do.
+//
+//     mesh_simplifier_benchmark [grid size | OBJ file] [repeats]
+//
+// The default grid of 512 x 512 quads is half a million triangles.
+#include "objparserclass.h"
+#include "meshweldclass.h"
+#include "meshsimplifierclass.h"
+#include "BenchmarkUtils.h"
+#include <cstdlib>
+
+
+/////////////
+// GLOBALS //
+/////////////
+const int BENCHMARK_DEFAULT_GRID = 512;
+const int BENCHMARK_DEFAULT_REPEATS = 3;
+const float BENCHMARK_WELD_TOLERANCE = 1.0e-6f;
+// The error is relative to the mesh size, so 1 never stops a simplification short of its target.
+const float BENCHMARK_MAX_ERROR = 1.0f;
+const float BENCHMARK_RATIOS[] = { 0.5f, 0.25f, 0.1f, 0.01f };
+const char* BENCHMARK_FILE_NAME = "mesh_simplifier_benchmark.obj";
+
+
+static void RunSimplifier(const std::vector<VertexType>& verts, const std::vector<uint32_t>& indices, float ratio, bool recordCollapses,
+	int repeats)
+{
+	MeshSimplifierClass simplifier;
+	std::vector<uint32_t> simplified;
+	std::vector<MeshSimplifierClass::CollapseRecordType> collapses;
+	std::vector<unsigned int> triangleCollapses;
+	unsigned int targetIndexCount;
+	double seconds, best;
+	float error;
+	int i;
+
+
+	targetIndexCount = (unsigned int)(indices.size() * ratio) / 3 * 3;
+	best = 0.0;
+	error = 0.0f;
+	for (i = 0; i < repeats; i++)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		if (recordCollapses)
+		{
+			error = simplifier.Simplify(verts, indices, targetIndexCount, BENCHMARK_MAX_ERROR, simplified, collapses, triangleCollapses);
+		}
+		else
+		{
+			error = simplifier.Simplify(verts, indices, targetIndexCount, BENCHMARK_MAX_ERROR, simplified);
+		}
+		seconds = SecondsSince(start);
+		best = (i == 0 || seconds < best) ? seconds : best;
+	}
+
+	printf("%5.1f%%%s: %zu triangles, error %.5f, %.3f s, %.2f M input triangles/s", ratio * 100.0f, recordCollapses ? " recorded" : "",
+		simplified.size() / 3, error, best, indices.size() / 3 / best * 1.0e-6);
+	if (recordCollapses)
+	{
+		printf(", %zu collapses", collapses.size());
+	}
+	printf("\n");
+
+	return;
+}
+
+
+int main(int argc, char** argv)
+{
+	ObjParserClass parser;
+	ObjParserClass::ObjDataType obj;
+	MeshWeldClass weld;
+	std::vector<VertexType> verts;
+	std::vector<uint32_t> indices;
+	const char* filename;
+	char* end;
+	int size, repeats;
+	size_t i;
+	bool result;
+
+
+	// A first argument that is not a number is the OBJ file to simplify.
+	size = BENCHMARK_DEFAULT_GRID;
+	filename = BENCHMARK_FILE_NAME;
+	if (argc > 1)
+	{
+		size = (int)strtol(argv[1], &end, 10);
+		if (*end != '\0')
+		{
+			filename = argv[1];
+			size = 0;
+		}
+	}
+	repeats = argc > 2 ? atoi(argv[2]) : BENCHMARK_DEFAULT_REPEATS;
+	if ((filename == BENCHMARK_FILE_NAME && size <= 0) || repeats <= 0)
+	{
+		printf("usage: %s [grid size | OBJ file] [repeats]\n", argv[0]);
+		return 1;
+	}
+
+	if (size > 0 && !WriteGridObj(BENCHMARK_FILE_NAME, size))
+	{
+		printf("Could not write %s\n", BENCHMARK_FILE_NAME);
+		return 1;
+	}
+
+	result = parser.Parse(filename, obj);
+	if (size > 0)
+	{
+		remove(BENCHMARK_FILE_NAME);
+	}
+	weld.SetTolerance(BENCHMARK_WELD_TOLERANCE);
+	weld.SetRemoveDegenerates(true);
+	if (!result || !weld.Weld(obj.positions, obj.uvs, obj.normals, obj.positionIndices, obj.uvIndices, obj.normalIndices, verts, indices,
+		nullptr))
+	{
+		printf("Could not load %s\n", filename);
+		return 1;
+	}
+	printf("%s: %zu vertices, %zu triangles\n", filename, verts.size(), indices.size() / 3);
+
+	for (i = 0; i < sizeof(BENCHMARK_RATIOS) / sizeof(BENCHMARK_RATIOS[0]); i++)
+	{
+		RunSimplifier(verts, indices, BENCHMARK_RATIOS[i], false, repeats);
+	}
+	RunSimplifier(verts, indices, BENCHMARK_RATIOS[i - 1], true, repeats);
+
+	return 0;
+}
@@ -0,0 +1,123 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: MeshWeldBenchmark.cpp
+////////////////////////////////////////////////////////////////////////////////
+// Writes a large generated OBJ file, or takes the one it is given, parses it and welds its face corners into an indexed mesh, once
+// with identical triplets only and once with the tolerance the model loader uses. For each it prints the vertices and bytes of a
+// vertex per corner against those of the welded mesh and how long the weld took.
+//
+//     mesh_weld_benchmark [grid size | OBJ file] [repeats]
+//
+// The default grid of 1024 x 1024 quads has six million corners.
+#include "objparserclass.h"
+#include "meshweldclass.h"
+#include "BenchmarkUtils.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+
+/////////////
+// GLOBALS //
+/////////////
+const int BENCHMARK_DEFAULT_GRID = 1024;
+const int BENCHMARK_DEFAULT_REPEATS = 3;
+const float BENCHMARK_WELD_TOLERANCE = 1.0e-6f;
+const char* BENCHMARK_FILE_NAME = "mesh_weld_benchmark.obj";
+
+
+static bool RunWeld(const ObjParserClass::ObjDataType& obj, float tolerance, int repeats)
+{
+	MeshWeldClass weld;
+	MeshWeldClass::WeldStats stats;
+	std::vector<VertexType> verts;
+	std::vector<uint32_t> indices;
+	std::vector<unsigned int> triangleMaterials;
+	double seconds, best;
+	int i;
+
+
+	weld.SetTolerance(tolerance);
+	weld.SetRemoveDegenerates(true);
+	best = 0.0;
+	for (i = 0; i < repeats; i++)
+	{
+		triangleMaterials = obj.triangleMaterials;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		if (!weld.Weld(obj.positions, obj.uvs, obj.normals, obj.positionIndices, obj.uvIndices, obj.normalIndices, verts, indices,
+			&triangleMaterials))
+		{
+			return false;
+		}
+		seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		if (best == 0.0 || seconds < best)
+		{
+			best = seconds;
+		}
+	}
+
+	stats = weld.GetStats();
+	printf("Tolerance %g: %u vertices and %.1f MB before, %u vertices, %u indices and %.1f MB after (%.1f%%), %u merged, %u degenerate "
+		"triangles, %.3f s, %.1f M corners/s\n", tolerance, stats.inputVertexCount, stats.inputBytes / (1024.0 * 1024.0),
+		stats.outputVertexCount, stats.outputIndexCount, stats.outputBytes / (1024.0 * 1024.0), 100.0 * stats.outputBytes / stats.inputBytes,
+		stats.mergedVertexCount, stats.degenerateTriangleCount, best, stats.inputIndexCount / best * 1.0e-6);
+
+	return true;
+}
+
+
+int main(int argc, char** argv)
+{
+	ObjParserClass parser;
+	ObjParserClass::ObjDataType obj;
+	const char* filename;
+	char* end;
+	int size, repeats;
+	bool result;
+
+
+	// A first argument that is not a number is the OBJ file to weld.
+	size = BENCHMARK_DEFAULT_GRID;
+	filename = BENCHMARK_FILE_NAME;
+	if (argc > 1)
+	{
+		size = (int)strtol(argv[1], &end, 10);
+		if (*end != '\0')
+		{
+			filename = argv[1];
+			size = 0;
+		}
+	}
+	repeats = argc > 2 ? atoi(argv[2]) : BENCHMARK_DEFAULT_REPEATS;
+	if ((filename == BENCHMARK_FILE_NAME && size <= 0) || repeats <= 0)
+	{
+		printf("usage: %s [grid size | OBJ file] [repeats]\n", argv[0]);
+		return 1;
+	}
+
+	if (size > 0 && !WriteGridObj(BENCHMARK_FILE_NAME, size))
+	{
+		printf("Could not write %s\n", BENCHMARK_FILE_NAME);
+		return 1;
+	}
+
+	result = parser.Parse(filename, obj);
+	if (size > 0)
+	{
+		remove(BENCHMARK_FILE_NAME);
+	}
+	if (!result)
+	{
+		printf("Could not parse %s\n", filename);
+		return 1;
+	}
+
+	printf("%s: %zu bytes of OBJ, %zu positions, %zu corners\n", filename, parser.GetFileSize(), obj.positions.size(),
+		obj.positionIndices.size());
+	result = RunWeld(obj, 0.0f, repeats) && RunWeld(obj, BENCHMARK_WELD_TOLERANCE, repeats);
+	if (!result)
+	{
+		printf("Could not weld the mesh\n");
+	}
+
+	return result ? 0 : 1;
+}
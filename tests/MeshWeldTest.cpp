@@ -0,0 +1,235 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: MeshWeldTest.cpp
+////////////////////////////////////////////////////////////////////////////////
+// Welds small hand made meshes and checks the vertices and indices that come out, that two welds of the same input agree to the
+// byte, and that bad input is rejected.
+#include "meshweldclass.h"
+#include "TestUtils.h"
+#include <cstring>
+
+
+// A quad of two triangles as an OBJ stores it, one (v, vt, vn) triplet for each of the six corners.
+static void MakeQuad(std::vector<XMFLOAT3>& positions, std::vector<XMFLOAT2>& uvs, std::vector<XMFLOAT3>& normals,
+	std::vector<unsigned int>& positionIndices, std::vector<unsigned int>& uvIndices, std::vector<unsigned int>& normalIndices)
+{
+	positions = { XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(1.0f, 0.0f, 0.0f), XMFLOAT3(1.0f, 1.0f, 0.0f), XMFLOAT3(0.0f, 1.0f, 0.0f) };
+	uvs = { XMFLOAT2(0.0f, 1.0f), XMFLOAT2(1.0f, 1.0f), XMFLOAT2(1.0f, 0.0f), XMFLOAT2(0.0f, 0.0f) };
+	normals = { XMFLOAT3(0.0f, 0.0f, -1.0f) };
+	positionIndices = { 0, 1, 2, 0, 2, 3 };
+	uvIndices = { 0, 1, 2, 0, 2, 3 };
+	normalIndices = { 0, 0, 0, 0, 0, 0 };
+
+	return;
+}
+
+
+// A grid of quads whose shared corners are repeated with positions moved up by less than the tolerance, as a file written with rounding
+// would have them.
+static void MakeNoisyGrid(int size, std::vector<XMFLOAT3>& positions, std::vector<XMFLOAT2>& uvs, std::vector<XMFLOAT3>& normals,
+	std::vector<unsigned int>& positionIndices, std::vector<unsigned int>& uvIndices, std::vector<unsigned int>& normalIndices)
+{
+	static const int corners[6][2] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 0 }, { 1, 1 }, { 0, 1 } };
+	unsigned int index;
+	int x, y, i;
+	float noise;
+
+
+	positions.clear();
+	uvs.clear();
+	normals = { XMFLOAT3(0.0f, 0.0f, -1.0f) };
+	positionIndices.clear();
+	uvIndices.clear();
+	normalIndices.clear();
+
+	for (y = 0; y < size; y++)
+	{
+		for (x = 0; x < size; x++)
+		{
+			for (i = 0; i < 6; i++)
+			{
+				noise = (float)((x * 7 + y * 13 + i * 5) % 11) * 1.0e-6f;
+				index = (unsigned int)positions.size();
+				positions.push_back(XMFLOAT3((float)(x + corners[i][0]) + noise, (float)(y + corners[i][1]) + noise, 0.0f));
+				uvs.push_back(XMFLOAT2((float)(x + corners[i][0]) / size, (float)(y + corners[i][1]) / size));
+				positionIndices.push_back(index);
+				uvIndices.push_back(index);
+				normalIndices.push_back(0);
+			}
+		}
+	}
+
+	return;
+}
+
+
+static void TestExactWeld()
+{
+	std::vector<XMFLOAT3> positions, normals;
+	std::vector<XMFLOAT2> uvs;
+	std::vector<unsigned int> positionIndices, uvIndices, normalIndices;
+	std::vector<VertexType> verts;
+	std::vector<uint32_t> indices;
+	MeshWeldClass weld;
+	bool result;
+
+
+	MakeQuad(positions, uvs, normals, positionIndices, uvIndices, normalIndices);
+	weld.SetTolerance(0.0f);
+	result = weld.Weld(positions, uvs, normals, positionIndices, uvIndices, normalIndices, verts, indices, 0);
+	CHECK(result);
+	CHECK(verts.size() == 4);
+	CHECK(indices.size() == 6);
+	CHECK(weld.GetStats().inputVertexCount == 6);
+	CHECK(weld.GetStats().outputVertexCount == 4);
+
+	// The triangles keep their corners and their order.
+	for (size_t i = 0; i < indices.size() && i < positionIndices.size(); i++)
+	{
+		CHECK(indices[i] < verts.size());
+		CHECK(memcmp(&verts[indices[i]].position, &positions[positionIndices[i]], sizeof(XMFLOAT3)) == 0);
+		CHECK(memcmp(&verts[indices[i]].texture, &uvs[uvIndices[i]], sizeof(XMFLOAT2)) == 0);
+	}
+
+	return;
+}
+
+
+// Corners that only give a position, as v or v//vn faces do, weld on the position alone and get zero texture coordinates.
+static void TestPositionOnlyWeld()
+{
+	std::vector<XMFLOAT3> positions, normals;
+	std::vector<XMFLOAT2> uvs;
+	std::vector<unsigned int> positionIndices, uvIndices, normalIndices;
+	std::vector<VertexType> verts;
+	std::vector<uint32_t> indices;
+	MeshWeldClass weld;
+	bool result;
+
+
+	MakeQuad(positions, uvs, normals, positionIndices, uvIndices, normalIndices);
+	uvs.clear();
+	normals.clear();
+	uvIndices.assign(positionIndices.size(), MESH_INDEX_NONE);
+	normalIndices.assign(positionIndices.size(), MESH_INDEX_NONE);
+
+	result = weld.Weld(positions, uvs, normals, positionIndices, uvIndices, normalIndices, verts, indices, 0);
+	CHECK(result);
+	CHECK(verts.size() == 4);
+	CHECK(indices.size() == 6);
+	for (size_t i = 0; i < verts.size(); i++)
+	{
+		CHECK(verts[i].texture.x == 0.0f && verts[i].texture.y == 0.0f);
+	}
+	CHECK(indices[0] == indices[3]);
+	CHECK(indices[2] == indices[4]);
+
+	return;
+}
+
+
+// Welding the same input twice, with and without a tolerance, has to give the same buffers, or the mesh cache and every measure
+// taken from the mesh would change from run to run.
+static void TestDeterminism()
+{
+	std::vector<XMFLOAT3> positions, normals;
+	std::vector<XMFLOAT2> uvs;
+	std::vector<unsigned int> positionIndices, uvIndices, normalIndices;
+	std::vector<VertexType> verts[2];
+	std::vector<uint32_t> indices[2];
+	float tolerances[2] = { 0.0f, 1.0e-4f };
+	int t, run;
+	bool result;
+
+
+	MakeNoisyGrid(24, positions, uvs, normals, positionIndices, uvIndices, normalIndices);
+	for (t = 0; t < 2; t++)
+	{
+		for (run = 0; run < 2; run++)
+		{
+			MeshWeldClass weld;
+
+			weld.SetTolerance(tolerances[t]);
+			result = weld.Weld(positions, uvs, normals, positionIndices, uvIndices, normalIndices, verts[run], indices[run], 0);
+			CHECK(result);
+		}
+
+		CHECK(verts[0].size() == verts[1].size());
+		CHECK(indices[0] == indices[1]);
+		CHECK(verts[0].size() == verts[1].size() && memcmp(verts[0].data(), verts[1].data(), verts[0].size() * sizeof(VertexType)) == 0);
+	}
+
+	// The last pass used the tolerance, which merges the repeated grid corners down to one vertex for each grid point.
+	CHECK(verts[0].size() == 25 * 25);
+	CHECK(indices[0].size() == positionIndices.size());
+
+	return;
+}
+
+
+// A triangle that collapses once its corners are merged is dropped, and its material goes with it.
+static void TestDegenerateRemoval()
+{
+	std::vector<XMFLOAT3> positions, normals;
+	std::vector<XMFLOAT2> uvs;
+	std::vector<unsigned int> positionIndices, uvIndices, normalIndices, materials;
+	std::vector<VertexType> verts;
+	std::vector<uint32_t> indices;
+	MeshWeldClass weld;
+	bool result;
+
+
+	MakeQuad(positions, uvs, normals, positionIndices, uvIndices, normalIndices);
+	positionIndices.insert(positionIndices.end(), { 0, 0, 1 });
+	uvIndices.insert(uvIndices.end(), { 0, 0, 1 });
+	normalIndices.insert(normalIndices.end(), { 0, 0, 0 });
+	materials = { 3, 4, 5 };
+
+	weld.SetRemoveDegenerates(true);
+	result = weld.Weld(positions, uvs, normals, positionIndices, uvIndices, normalIndices, verts, indices, &materials);
+	CHECK(result);
+	CHECK(indices.size() == 6);
+	CHECK(materials.size() == 2);
+	CHECK(materials.size() == 2 && materials[0] == 3 && materials[1] == 4);
+	CHECK(weld.GetStats().degenerateTriangleCount == 1);
+
+	return;
+}
+
+
+static void TestRejectsBadInput()
+{
+	std::vector<XMFLOAT3> positions, normals;
+	std::vector<XMFLOAT2> uvs;
+	std::vector<unsigned int> positionIndices, uvIndices, normalIndices;
+	std::vector<VertexType> verts;
+	std::vector<uint32_t> indices;
+	MeshWeldClass weld;
+
+
+	// A corner that points past the positions.
+	MakeQuad(positions, uvs, normals, positionIndices, uvIndices, normalIndices);
+	positionIndices[4] = 4;
+	CHECK(!weld.Weld(positions, uvs, normals, positionIndices, uvIndices, normalIndices, verts, indices, 0));
+
+	// Index lists of different lengths, and a corner count that is not whole triangles.
+	MakeQuad(positions, uvs, normals, positionIndices, uvIndices, normalIndices);
+	uvIndices.pop_back();
+	CHECK(!weld.Weld(positions, uvs, normals, positionIndices, uvIndices, normalIndices, verts, indices, 0));
+	positionIndices.pop_back();
+	normalIndices.pop_back();
+	CHECK(!weld.Weld(positions, uvs, normals, positionIndices, uvIndices, normalIndices, verts, indices, 0));
+
+	return;
+}
+
+
+int main()
+{
+	TestExactWeld();
+	TestPositionOnlyWeld();
+	TestDeterminism();
+	TestDegenerateRemoval();
+	TestRejectsBadInput();
+
+	return TEST_RESULT;
+}
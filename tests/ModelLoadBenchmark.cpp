@@ -0,0 +1,132 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: ModelLoadBenchmark.cpp
+////////////////////////////////////////////////////////////////////////////////
+// Loads a model on the null device the way the scene does, first cold, from the OBJ file with no .dxmesh next to it, which parses,
+// welds and optimizes the mesh, builds its levels of detail and writes the cache, and then warm, from the cache that load wrote.
+// It prints the time of each, the best of a few runs, and how much faster the warm load is.
+//
+//     model_load_benchmark [grid size | OBJ file] [repeats]
+//
+// The default grid of 512 x 512 quads is half a million triangles. A file that is given is loaded where it is, its cache is written
+// next to it and replaced on every cold run.
+#include "modelclass.h"
+#include "meshcacheclass.h"
+#include "nullrenderdeviceclass.h"
+#include "BenchmarkUtils.h"
+#include <cstdlib>
+#include <filesystem>
+
+
+/////////////
+// GLOBALS //
+/////////////
+const int BENCHMARK_DEFAULT_GRID = 512;
+const int BENCHMARK_DEFAULT_REPEATS = 3;
+const char* BENCHMARK_FILE_NAME = "model_load_benchmark.obj";
+
+
+// LoadModel loads the model and returns how long Initialize took, or a negative time when it failed.
+static double LoadModel(const char* filename, OUT int& indexCount)
+{
+	NullRenderDeviceClass device;
+	RenderDeviceClass::CapsType caps;
+	ModelClass model;
+	double seconds;
+	bool result;
+
+
+	if (!device.Initialize(caps, 0))
+	{
+		return -1.0;
+	}
+	device.SetRecording(false);
+
+	model.SetProgressive(false, 0);
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	result = model.Initialize(&device, filename, L"model_load_benchmark.dds");
+	seconds = SecondsSince(start);
+	indexCount = model.GetIndexCount();
+
+	model.Shutdown();
+	device.Shutdown();
+
+	return result ? seconds : -1.0;
+}
+
+
+int main(int argc, char** argv)
+{
+	std::string cacheFileName;
+	std::error_code error;
+	const char* filename;
+	char* end;
+	double cold, warm, seconds;
+	int size, repeats, indexCount, i;
+
+
+	// A first argument that is not a number is the OBJ file to load.
+	size = BENCHMARK_DEFAULT_GRID;
+	filename = BENCHMARK_FILE_NAME;
+	if (argc > 1)
+	{
+		size = (int)strtol(argv[1], &end, 10);
+		if (*end != '\0')
+		{
+			filename = argv[1];
+			size = 0;
+		}
+	}
+	repeats = argc > 2 ? atoi(argv[2]) : BENCHMARK_DEFAULT_REPEATS;
+	if ((filename == BENCHMARK_FILE_NAME && size <= 0) || repeats <= 0)
+	{
+		printf("usage: %s [grid size | OBJ file] [repeats]\n", argv[0]);
+		return 1;
+	}
+
+	if (size > 0 && !WriteGridObj(BENCHMARK_FILE_NAME, size))
+	{
+		printf("Could not write %s\n", BENCHMARK_FILE_NAME);
+		return 1;
+	}
+	cacheFileName = MeshCacheClass::GetCacheFilename(filename);
+
+	// Every cold run starts without a cache and leaves one behind, the warm runs load the last one.
+	cold = 0.0;
+	warm = 0.0;
+	indexCount = 0;
+	for (i = 0; i < repeats; i++)
+	{
+		std::filesystem::remove(cacheFileName, error);
+		seconds = LoadModel(filename, indexCount);
+		if (seconds < 0.0 || !std::filesystem::exists(cacheFileName))
+		{
+			printf("Could not load %s and cache it in %s\n", filename, cacheFileName.c_str());
+			return 1;
+		}
+		cold = (i == 0 || seconds < cold) ? seconds : cold;
+	}
+
+	for (i = 0; i < repeats; i++)
+	{
+		seconds = LoadModel(filename, indexCount);
+		if (seconds < 0.0)
+		{
+			printf("Could not load %s from %s\n", filename, cacheFileName.c_str());
+			return 1;
+		}
+		warm = (i == 0 || seconds < warm) ? seconds : warm;
+	}
+
+	printf("%s: %d indices with every level of detail, %ju bytes of OBJ, %ju bytes of cache\n", filename, indexCount,
+		(uintmax_t)std::filesystem::file_size(filename, error), (uintmax_t)std::filesystem::file_size(cacheFileName, error));
+	printf("Cold load from the OBJ file: %.3f s\n", cold);
+	printf("Warm load from the cache:    %.3f s, %.1fx faster\n", warm, cold / warm);
+
+	if (size > 0)
+	{
+		std::filesystem::remove(cacheFileName, error);
+		remove(BENCHMARK_FILE_NAME);
+	}
+
+	return 0;
+}
@@ -0,0 +1,123 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: ObjParserBenchmark.cpp
+////////////////////////////////////////////////////////////////////////////////
+// Writes a large generated OBJ file and parses it with one thread and then twice as many each time up to the hardware threads,
+// printing the throughput of each. Every parse has to give the same arrays, bit for bit, as the one on a single thread.
+//
+//     obj_parser_benchmark [grid size] [repeats] [threads]
+//
+// The default grid of 1024 x 1024 quads is a file of about 145 MB. The sweep goes up to the hardware threads unless a count is given.
+#include "objparserclass.h"
+#include "BenchmarkUtils.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+
+/////////////
+// GLOBALS //
+/////////////
+const int BENCHMARK_DEFAULT_GRID = 1024;
+const int BENCHMARK_DEFAULT_REPEATS = 3;
+const char* BENCHMARK_FILE_NAME = "obj_parser_benchmark.obj";
+
+
+// SameBits compares two arrays of floats bit for bit, so every value has to be parsed the same, down to the sign of a zero.
+template <typename T>
+static bool SameBits(const std::vector<T>& a, const std::vector<T>& b)
+{
+	return a.size() == b.size() && (a.empty() || memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0);
+}
+
+
+static bool SameData(const ObjParserClass::ObjDataType& a, const ObjParserClass::ObjDataType& b)
+{
+	return SameBits(a.positions, b.positions) && SameBits(a.uvs, b.uvs) && SameBits(a.normals, b.normals) &&
+		a.positionIndices == b.positionIndices && a.uvIndices == b.uvIndices && a.normalIndices == b.normalIndices &&
+		a.triangleMaterials == b.triangleMaterials;
+}
+
+
+int main(int argc, char** argv)
+{
+	ObjParserClass::ObjDataType reference;
+	std::vector<unsigned int> threadCounts;
+	unsigned int hardwareThreads, threadCount;
+	double best;
+	size_t t;
+	int size, repeats, i;
+	bool result;
+
+
+	size = argc > 1 ? atoi(argv[1]) : BENCHMARK_DEFAULT_GRID;
+	repeats = argc > 2 ? atoi(argv[2]) : BENCHMARK_DEFAULT_REPEATS;
+	if (size <= 0 || repeats <= 0)
+	{
+		printf("usage: %s [grid size] [repeats] [threads]\n", argv[0]);
+		return 1;
+	}
+
+	if (!WriteGridObj(BENCHMARK_FILE_NAME, size))
+	{
+		printf("Could not write %s\n", BENCHMARK_FILE_NAME);
+		return 1;
+	}
+
+	hardwareThreads = argc > 3 ? atoi(argv[3]) : std::thread::hardware_concurrency();
+	if (hardwareThreads == 0)
+	{
+		hardwareThreads = 1;
+	}
+
+	// One thread, then doubled up to every hardware thread, and the hardware thread count itself when it is not a power of two.
+	for (threadCount = 1; threadCount < hardwareThreads; threadCount *= 2)
+	{
+		threadCounts.push_back(threadCount);
+	}
+	threadCounts.push_back(hardwareThreads);
+
+	result = true;
+	for (t = 0; t < threadCounts.size(); t++)
+	{
+		ObjParserClass parser;
+		ObjParserClass::ObjDataType data;
+
+		threadCount = threadCounts[t];
+		parser.SetThreadCount(threadCount);
+		best = 0.0;
+		for (i = 0; i < repeats && result; i++)
+		{
+			data = ObjParserClass::ObjDataType();
+			result = parser.Parse(BENCHMARK_FILE_NAME, data);
+			if (result && (best == 0.0 || parser.GetParseSeconds() < best))
+			{
+				best = parser.GetParseSeconds();
+			}
+		}
+
+		if (!result)
+		{
+			printf("Could not parse %s on %u threads\n", BENCHMARK_FILE_NAME, threadCount);
+			break;
+		}
+
+		if (t == 0)
+		{
+			reference = std::move(data);
+		}
+		else if (!SameData(reference, data))
+		{
+			printf("The parse on %u threads differs from the one on a single thread\n", threadCount);
+			result = false;
+			break;
+		}
+
+		printf("%u threads (%u used): %zu bytes in %.3f s, %.1f MB/s\n", threadCount, parser.GetThreadCount(), parser.GetFileSize(), best,
+			(double)parser.GetFileSize() / (1024.0 * 1024.0) / best);
+	}
+
+	remove(BENCHMARK_FILE_NAME);
+
+	return result ? 0 : 1;
+}
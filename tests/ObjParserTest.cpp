@@ -0,0 +1,293 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: ObjParserTest.cpp
+////////////////////////////////////////////////////////////////////////////////
+// Parses small OBJ texts and checks the records and the resolved face indices that come out, including indices too large for any
+// file to use, and the floats, which have to come out bit for bit as fscanf read them before the parser replaced it.
+#include "objparserclass.h"
+#include "TestUtils.h"
+#include <cmath>
+#include <cstring>
+
+
+/////////////
+// GLOBALS //
+/////////////
+const char* OBJ_TEST_FILE_NAME = "obj_parser_test.obj";
+
+
+static bool ParseText(const char* text, ObjParserClass::ObjDataType& data)
+{
+	ObjParserClass parser;
+	ObjParserClass::RecordCountType defined;
+
+
+	memset(&defined, 0, sizeof(defined));
+	parser.SetThreadCount(1);
+
+	return parser.ParseBlock(text, text + strlen(text), defined, data);
+}
+
+
+static void TestFaces()
+{
+	static const char* text =
+		"v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\n"
+		"vt 0 0\nvt 1 0\nvt 1 1\n"
+		"vn 0 0 1\n"
+		"f 1/1/1 2/2/1 3/3/1 4/3/1\n"
+		"f -4//1 -3//1 -2//1\n"
+		"f 1 3 4\n";
+	ObjParserClass::ObjDataType data;
+	bool result;
+
+
+	result = ParseText(text, data);
+	CHECK(result);
+	CHECK(data.positions.size() == 4);
+	CHECK(data.uvs.size() == 3);
+	CHECK(data.normals.size() == 1);
+
+	// The quad is split into a fan of two triangles, then come the relative v//vn face and the position only face.
+	CHECK(data.positionIndices == std::vector<unsigned int>({ 0, 1, 2, 0, 2, 3, 0, 1, 2, 0, 2, 3 }));
+	CHECK(data.uvIndices.size() == 12);
+	CHECK(data.uvIndices.size() == 12 && data.uvIndices[5] == 2 && data.uvIndices[6] == MESH_INDEX_NONE);
+	CHECK(data.normalIndices.size() == 12 && data.normalIndices[8] == 0 && data.normalIndices[9] == MESH_INDEX_NONE);
+	CHECK(data.triangleMaterials.size() == 4);
+
+	return;
+}
+
+
+// Indices past what a 32 bit index holds, however many digits they have, resolve to something the welder rejects rather than wrap
+// around into one of the vertices.
+static void TestIndexOverflow()
+{
+	static const char* texts[] =
+	{
+		"v 0 0 0\nv 1 0 0\nv 1 1 0\nf 1 2 4294967298\n",
+		"v 0 0 0\nv 1 0 0\nv 1 1 0\nf 1 2 18446744073709551619\n",
+		"v 0 0 0\nv 1 0 0\nv 1 1 0\nf 1 2 -18446744073709551615\n",
+		"v 0 0 0\nv 1 0 0\nv 1 1 0\nf 1 2 000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000003\n",
+	};
+	size_t i;
+	bool result;
+
+
+	for (i = 0; i < 3; i++)
+	{
+		ObjParserClass::ObjDataType data;
+
+		result = ParseText(texts[i], data);
+		CHECK(result);
+		CHECK(data.positionIndices.size() == 3);
+		CHECK(data.positionIndices.size() == 3 && data.positionIndices[2] >= data.positions.size() &&
+			data.positionIndices[2] != MESH_INDEX_NONE);
+	}
+
+	// Leading zeros do not count towards the limit.
+	{
+		ObjParserClass::ObjDataType data;
+
+		result = ParseText(texts[3], data);
+		CHECK(result);
+		CHECK(data.positionIndices.size() == 3 && data.positionIndices[2] == 2);
+	}
+
+	return;
+}
+
+
+// SameFloat compares the bits, so a zero of the wrong sign or a value off in its last bit counts as a difference.
+static bool SameFloat(float a, float b)
+{
+	return memcmp(&a, &b, sizeof(float)) == 0;
+}
+
+
+static void TestValues()
+{
+	static const char* text =
+		"v 1.5e3 +2.25 -0\n"
+		"v -1.25E-2 +0.0 3\n"
+		"vt .5 1e+1\n"
+		"vn -0.0 +1e0 0.1\n";
+	ObjParserClass::ObjDataType data;
+	bool result;
+
+
+	result = ParseText(text, data);
+	CHECK(result);
+	CHECK(data.positions.size() == 2 && data.uvs.size() == 1 && data.normals.size() == 1);
+	if (!result || data.positions.size() != 2 || data.uvs.size() != 1 || data.normals.size() != 1)
+	{
+		return;
+	}
+
+	// Exponents of either case and sign, a leading '+' and a negative zero that keeps its sign.
+	CHECK(SameFloat(data.positions[0].x, 1500.0f) && SameFloat(data.positions[0].y, 2.25f) && SameFloat(data.positions[0].z, -0.0f));
+	CHECK(std::signbit(data.positions[0].z));
+	CHECK(SameFloat(data.positions[1].x, -0.0125f) && SameFloat(data.positions[1].y, 0.0f) && SameFloat(data.positions[1].z, 3.0f));
+	CHECK(SameFloat(data.uvs[0].x, 0.5f) && SameFloat(data.uvs[0].y, 10.0f));
+	CHECK(SameFloat(data.normals[0].x, -0.0f) && SameFloat(data.normals[0].y, 1.0f) && SameFloat(data.normals[0].z, 0.1f));
+
+	// A sign on its own or a number that does not start is not a value.
+	CHECK(!ParseText("v 1 + 2\n", data));
+	CHECK(!ParseText("v 1 2 e3\n", data));
+
+	return;
+}
+
+
+// ReferenceStream reads the file the way the model loader did before the parser replaced it, with fscanf and whole v/vt/vn triangles,
+// and returns a vertex for every face corner.
+static bool ReferenceStream(const char* filename, std::vector<VertexType>& out_verts)
+{
+	std::vector<XMFLOAT3> verts, norms;
+	std::vector<XMFLOAT2> uvs;
+	std::vector<unsigned int> vertexIndices, uvIndices, normalIndices;
+	unsigned int vertexIndex[3], uvIndex[3], normalIndex[3];
+	char lineHeader[128];
+	FILE* file;
+	VertexType vertex;
+	size_t i;
+	int k;
+
+
+	file = fopen(filename, "r");
+	if (!file)
+	{
+		return false;
+	}
+
+	while (fscanf(file, "%127s", lineHeader) == 1)
+	{
+		if (strcmp(lineHeader, "v") == 0)
+		{
+			verts.emplace_back();
+			fscanf(file, "%f %f %f\n", &verts.back().x, &verts.back().y, &verts.back().z);
+		}
+		else if (strcmp(lineHeader, "vt") == 0)
+		{
+			uvs.emplace_back();
+			fscanf(file, "%f %f\n", &uvs.back().x, &uvs.back().y);
+		}
+		else if (strcmp(lineHeader, "vn") == 0)
+		{
+			norms.emplace_back();
+			fscanf(file, "%f %f %f\n", &norms.back().x, &norms.back().y, &norms.back().z);
+		}
+		else if (strcmp(lineHeader, "f") == 0)
+		{
+			if (fscanf(file, "%u/%u/%u %u/%u/%u %u/%u/%u\n", &vertexIndex[0], &uvIndex[0], &normalIndex[0], &vertexIndex[1], &uvIndex[1],
+				&normalIndex[1], &vertexIndex[2], &uvIndex[2], &normalIndex[2]) != 9)
+			{
+				fclose(file);
+				return false;
+			}
+			for (k = 0; k < 3; k++)
+			{
+				vertexIndices.push_back(vertexIndex[k]);
+				uvIndices.push_back(uvIndex[k]);
+				normalIndices.push_back(normalIndex[k]);
+			}
+		}
+	}
+	fclose(file);
+
+	for (i = 0; i < vertexIndices.size(); i++)
+	{
+		vertex.position = verts[vertexIndices[i] - 1];
+		vertex.texture = uvs[uvIndices[i] - 1];
+		vertex.normal = norms[normalIndices[i] - 1];
+		out_verts.push_back(vertex);
+	}
+
+	return true;
+}
+
+
+static bool SameVertex(const VertexType& a, const VertexType& b)
+{
+	return SameFloat(a.position.x, b.position.x) && SameFloat(a.position.y, b.position.y) && SameFloat(a.position.z, b.position.z) &&
+		SameFloat(a.texture.x, b.texture.x) && SameFloat(a.texture.y, b.texture.y) &&
+		SameFloat(a.normal.x, b.normal.x) && SameFloat(a.normal.y, b.normal.y) && SameFloat(a.normal.z, b.normal.z);
+}
+
+
+// TestReferenceStream writes a small OBJ file of awkward floats in the triangle only form the old loader read and checks that the
+// parser's records, looked up through its face indices, give the same vertex for every corner, on one thread and on several.
+static void TestReferenceStream()
+{
+	static const char* text =
+		"# written by hand\n"
+		"v 0.1 -0.2 0.30000001\n"
+		"v 1.0e-3 +123456.789 -0\n"
+		"v 3.4028234e38 1.17549435E-38 -7.0e-45\n"
+		"v 0.333333333333333333333 -2.5 1e1\n"
+		"vt 0.1 0.9\n"
+		"vt +0.25 1.0000001\n"
+		"vt 0.5e0 -0.0\n"
+		"vn 0.57735026 0.57735026 -0.57735026\n"
+		"vn -0 -0 1\n"
+		"f 1/1/1 2/2/1 3/3/2\n"
+		"f 1/3/2 3/2/1 4/1/2\n"
+		"f 4/2/2 2/3/1 1/1/1\n";
+	std::vector<VertexType> reference;
+	VertexType vertex;
+	FILE* file;
+	bool valid;
+	size_t i;
+	unsigned int threadCount;
+
+
+	file = fopen(OBJ_TEST_FILE_NAME, "wb");
+	CHECK(file != 0);
+	if (!file)
+	{
+		return;
+	}
+	fputs(text, file);
+	fclose(file);
+
+	CHECK(ReferenceStream(OBJ_TEST_FILE_NAME, reference));
+	CHECK(reference.size() == 9);
+
+	for (threadCount = 1; threadCount <= 4; threadCount *= 2)
+	{
+		ObjParserClass parser;
+		ObjParserClass::ObjDataType data;
+
+		parser.SetThreadCount(threadCount);
+		CHECK(parser.Parse(OBJ_TEST_FILE_NAME, data));
+		CHECK(data.positionIndices.size() == reference.size());
+		if (data.positionIndices.size() != reference.size())
+		{
+			continue;
+		}
+
+		valid = true;
+		for (i = 0; i < reference.size(); i++)
+		{
+			vertex.position = data.positions[data.positionIndices[i]];
+			vertex.texture = data.uvs[data.uvIndices[i]];
+			vertex.normal = data.normals[data.normalIndices[i]];
+			valid = valid && SameVertex(vertex, reference[i]);
+		}
+		CHECK(valid);
+	}
+
+	remove(OBJ_TEST_FILE_NAME);
+
+	return;
+}
+
+
+int main()
+{
+	TestFaces();
+	TestIndexOverflow();
+	TestValues();
+	TestReferenceStream();
+
+	return TEST_RESULT;
+}
@@ -0,0 +1,129 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: ObjStreamImportTest.cpp
+////////////////////////////////////////////////////////////////////////////////
+// Imports a generated OBJ file larger than the memory budget and checks that the working set never grew by more than the budget,
+// that the triangles were spread over several chunks without losing any, and that the manifest reads back.
+#include "objstreamimportclass.h"
+#include "TestUtils.h"
+#include <cstdio>
+#include <filesystem>
+
+
+/////////////
+// GLOBALS //
+/////////////
+const char* IMPORT_FILE_NAME = "obj_stream_import_test.obj";
+// The smallest budget the import takes, and a grid that makes a file of about 75 MB, over it.
+const size_t IMPORT_BUDGET = 64 * 1024 * 1024;
+const int IMPORT_GRID = 640;
+
+
+// WriteGrid writes a height field of size x size quads in the v/vt/vn form, without keeping any of it in memory.
+static bool WriteGrid(const char* filename, int size)
+{
+	FILE* file;
+	int x, y, a, b, c, d;
+
+
+	file = fopen(filename, "wb");
+	if (!file)
+	{
+		return false;
+	}
+
+	for (y = 0; y <= size; y++)
+	{
+		for (x = 0; x <= size; x++)
+		{
+			fprintf(file, "v %.6f %.6f %.6f\nvt %.6f %.6f\nvn 0 1 0\n", (float)x / size, (float)((x * 31 + y * 17) % 97) / 970.0f, (float)y / size,
+				(float)x / size, (float)y / size);
+		}
+	}
+
+	for (y = 0; y < size; y++)
+	{
+		for (x = 0; x < size; x++)
+		{
+			a = y * (size + 1) + x + 1;
+			b = a + 1;
+			c = a + size + 1;
+			d = c + 1;
+			fprintf(file, "f %d/%d/%d %d/%d/%d %d/%d/%d\nf %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, a, c, c, c, d, d, d, a, a, a, d, d, d, b, b, b);
+		}
+	}
+
+	fclose(file);
+
+	return true;
+}
+
+
+static void RemoveOutputs(unsigned int chunkCount)
+{
+	std::error_code error;
+	unsigned int i;
+
+
+	for (i = 0; i < chunkCount; i++)
+	{
+		std::filesystem::remove(ObjStreamImportClass::GetTileFilename(IMPORT_FILE_NAME, i), error);
+	}
+	std::filesystem::remove(ObjStreamImportClass::GetManifestFilename(IMPORT_FILE_NAME), error);
+	std::filesystem::remove(IMPORT_FILE_NAME, error);
+
+	return;
+}
+
+
+int main()
+{
+	ObjStreamImportClass importer;
+	ObjStreamImportClass::ImportStatsType stats;
+	std::vector<ObjStreamImportClass::TileType> tiles, manifestTiles;
+	uint64_t indexCount;
+	size_t i;
+	bool result;
+
+
+	result = WriteGrid(IMPORT_FILE_NAME, IMPORT_GRID);
+	CHECK(result);
+	if (!result)
+	{
+		return TEST_RESULT;
+	}
+
+	// Below the smallest budget nothing is read.
+	importer.SetMemoryBudget(IMPORT_BUDGET / 2);
+	CHECK(!importer.Import(IMPORT_FILE_NAME, tiles));
+
+	importer.SetMemoryBudget(IMPORT_BUDGET);
+	importer.SetThreadCount(1);
+	result = importer.Import(IMPORT_FILE_NAME, tiles);
+	stats = importer.GetStats();
+	printf("%llu bytes, %llu triangles in %u chunks, the working set grew by %.1f MB of %.1f MB\n", (unsigned long long)stats.fileSize,
+		(unsigned long long)stats.triangleCount, stats.chunkCount, stats.peakMemory / (1024.0 * 1024.0), IMPORT_BUDGET / (1024.0 * 1024.0));
+
+	CHECK(result);
+	CHECK(stats.fileSize > IMPORT_BUDGET);
+	CHECK(stats.peakMemory > 0);
+	CHECK(stats.peakMemory <= IMPORT_BUDGET);
+	CHECK(stats.triangleCount == (uint64_t)IMPORT_GRID * IMPORT_GRID * 2);
+	CHECK(stats.chunkCount > 1);
+	CHECK(tiles.size() == stats.chunkCount);
+
+	indexCount = 0;
+	for (i = 0; i < tiles.size(); i++)
+	{
+		CHECK(tiles[i].boundsMin.x <= tiles[i].boundsMax.x && tiles[i].boundsMin.z <= tiles[i].boundsMax.z);
+		CHECK(tiles[i].indexCount <= stats.trianglesPerChunk * 3);
+		indexCount += tiles[i].indexCount;
+	}
+	CHECK(indexCount == stats.triangleCount * 3);
+
+	CHECK(ObjStreamImportClass::ReadManifest(IMPORT_FILE_NAME, manifestTiles));
+	CHECK(manifestTiles.size() == tiles.size());
+
+	RemoveOutputs(stats.chunkCount);
+
+	return TEST_RESULT;
+}
@@ -0,0 +1,128 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: RecordBenchmark.cpp
+////////////////////////////////////////////////////////////////////////////////
+// Draws a scene of many draws on the null device with its draws recorded on one up to RECORD_THREAD_COUNT threads and prints, for
+// each thread count, the time of a frame, the time spent recording the command lists and executing them, and the draws and threads a
+// frame took. One thread draws straight on the device. The model is a generated grid of 32 x 32 quads that take turns at many
+// materials, with static props and instances of it, so every visible part of them is a draw for each material.
+//
+//     record_benchmark [material count] [frames]
+#include "graphicsclass.h"
+#include "meshcacheclass.h"
+#include "nullrenderdeviceclass.h"
+#include "BenchmarkUtils.h"
+#include <cstdlib>
+#include <filesystem>
+
+
+/////////////
+// GLOBALS //
+/////////////
+const int BENCHMARK_DEFAULT_MATERIALS = 256;
+const int BENCHMARK_DEFAULT_FRAMES = 100;
+const int BENCHMARK_GRID = 32;
+const unsigned int BENCHMARK_PROP_COUNT = 1000;
+const unsigned int BENCHMARK_INSTANCE_COUNT = 1000;
+const int BENCHMARK_SCREEN_WIDTH = 1280;
+const int BENCHMARK_SCREEN_HEIGHT = 720;
+const char* BENCHMARK_FILE_NAME = "record_benchmark.obj";
+
+
+static bool RunThreads(unsigned int threadCount, int frameCount)
+{
+	NullRenderDeviceClass device;
+	RenderDeviceClass::CapsType caps;
+	RenderDeviceClass::StatsType stats;
+	GraphicsClass* Graphics;
+	GraphicsClass::SceneOptionsType options;
+	GraphicsClass::FrameStatsType frameStats;
+	double seconds;
+	bool result;
+	int i;
+
+
+	caps.constantBufferOffsetting = true;
+	caps.mapNoOverwriteOnConstantBuffers = true;
+	if (!device.Initialize(caps, 0))
+	{
+		return false;
+	}
+	device.SetRecording(false);
+
+	Graphics = new GraphicsClass;
+	options = Graphics->GetSceneOptions();
+	options.modelFileName = BENCHMARK_FILE_NAME;
+	options.staticPropCount = BENCHMARK_PROP_COUNT;
+	options.instanceCount = BENCHMARK_INSTANCE_COUNT;
+	options.recordThreadCount = threadCount;
+	Graphics->SetSceneOptions(options);
+	result = Graphics->Initialize(&device, BENCHMARK_SCREEN_WIDTH, BENCHMARK_SCREEN_HEIGHT);
+
+	// The first frame is left out, it is the one that makes the constant ring and the queue grow.
+	result = result && Graphics->Frame();
+	Graphics->ResetFrameStats();
+
+	device.ResetStats();
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (i = 0; i < frameCount && result; i++)
+	{
+		result = Graphics->Frame();
+	}
+	seconds = SecondsSince(start);
+	stats = device.GetStats();
+	frameStats = Graphics->GetFrameStats();
+
+	Graphics->Shutdown();
+	delete Graphics;
+	device.Shutdown();
+
+	if (!result || device.GetStats().errorCount > 0)
+	{
+		printf("Could not draw the scene on %u threads\n", threadCount);
+		return false;
+	}
+
+	printf("    %u threads: %8.1f us a frame, %8.1f us recording and %8.1f us executing, %.0f draws on %u threads, %u of %d frames "
+		"recorded\n", threadCount, seconds * 1.0e6 / frameCount, frameStats.recordSeconds * 1.0e6 / frameCount,
+		frameStats.executeSeconds * 1.0e6 / frameCount, (double)stats.drawCount / frameCount,
+		frameStats.recordedFrameCount > 0 ? frameStats.recordThreads : 1, frameStats.recordedFrameCount, frameCount);
+
+	return true;
+}
+
+
+int main(int argc, char** argv)
+{
+	std::error_code error;
+	unsigned int threadCount;
+	int materialCount, frameCount;
+	bool result;
+
+
+	materialCount = argc > 1 ? atoi(argv[1]) : BENCHMARK_DEFAULT_MATERIALS;
+	frameCount = argc > 2 ? atoi(argv[2]) : BENCHMARK_DEFAULT_FRAMES;
+	if (materialCount <= 0 || frameCount <= 0)
+	{
+		printf("usage: %s [material count] [frames]\n", argv[0]);
+		return 1;
+	}
+
+	if (!WriteGridObj(BENCHMARK_FILE_NAME, BENCHMARK_GRID, materialCount))
+	{
+		printf("Could not write %s\n", BENCHMARK_FILE_NAME);
+		return 1;
+	}
+
+	printf("%u props and %u instances of a grid of %d materials, %d frames:\n", BENCHMARK_PROP_COUNT, BENCHMARK_INSTANCE_COUNT,
+		materialCount, frameCount);
+	result = true;
+	for (threadCount = 1; threadCount <= RECORD_THREAD_COUNT && result; threadCount++)
+	{
+		result = RunThreads(threadCount, frameCount);
+	}
+
+	std::filesystem::remove(MeshCacheClass::GetCacheFilename(BENCHMARK_FILE_NAME), error);
+	remove(BENCHMARK_FILE_NAME);
+
+	return result ? 0 : 1;
+}
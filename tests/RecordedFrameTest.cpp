@@ -0,0 +1,349 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: RecordedFrameTest.cpp
+////////////////////////////////////////////////////////////////////////////////
+// Draws a scene of a grid model of many materials with static props and instances on the null device, straight on the device and
+// recorded into command lists on two, three and four threads, and checks the recorded frames draw the same as the straight one. The
+// calls the device logged are replayed into the state every draw reads: the shader, buffers and texture it is drawn with and the
+// bytes of object constants the slice it binds holds. The constant ring has to write the object constants of a recorded frame into
+// one slice, so filling the ring up between them can not discard the ones written before, which is checked on a ring that is nearly
+// full.
+#include "graphicsclass.h"
+#include "constantringclass.h"
+#include "meshcacheclass.h"
+#include "nullrenderdeviceclass.h"
+#include "BenchmarkUtils.h"
+#include "TestUtils.h"
+#include <cstring>
+#include <filesystem>
+
+
+/////////////
+// GLOBALS //
+/////////////
+const char* RECORD_TEST_FILE_NAME = "recorded_frame_test.obj";
+const int RECORD_TEST_GRID = 32;
+const int RECORD_TEST_MATERIALS = 64;
+const unsigned int RECORD_TEST_PROPS = 200;
+const unsigned int RECORD_TEST_INSTANCES = 200;
+// Few enough draws a thread that the scene records on every thread it is given.
+const unsigned int RECORD_TEST_MIN_PACKETS = 4;
+const unsigned int RECORD_TEST_RING_SIZE = 16 * CONSTANT_RING_ALIGNMENT;
+
+
+// The state one draw reads, with the object constants as the bytes its slice holds rather than where the slice is.
+struct DrawStateType
+{
+	NullRenderDeviceClass::CallType draw;
+	unsigned int shader, texture;
+	unsigned int vertexBuffers[RENDER_MAX_VERTEX_BUFFERS][3];
+	unsigned int indexBuffer[3];
+	unsigned int frameConstants[3];
+	unsigned int objectBuffer, objectFirstConstant, objectConstantCount;
+	TransformBatchClass::ObjectConstantsType objectConstants;
+};
+
+
+// GetDrawStates replays the calls the device logged into the state of every draw from firstCall on. The binds before it are replayed
+// too, a frame drawn straight on the device keeps what the frame before bound. A command list starts out with nothing bound.
+static void GetDrawStates(NullRenderDeviceClass& device, int firstCall, OUT std::vector<DrawStateType>& draws)
+{
+	NullRenderDeviceClass::CallType call;
+	DrawStateType state;
+	unsigned int slot;
+	int i;
+
+
+	draws.clear();
+	memset(&state, 0, sizeof(state));
+	for (i = 0; i < device.GetCallCount(); i++)
+	{
+		call = device.GetCall(i);
+		switch (call.type)
+		{
+		case RENDER_CALL_EXECUTE_COMMAND_LIST:
+			memset(&state, 0, sizeof(state));
+			break;
+		case RENDER_CALL_SET_VERTEX_BUFFER:
+			memcpy(state.vertexBuffers[call.arguments[0]], &call.arguments[1], sizeof(state.vertexBuffers[0]));
+			break;
+		case RENDER_CALL_SET_INDEX_BUFFER:
+			memcpy(state.indexBuffer, call.arguments, sizeof(state.indexBuffer));
+			break;
+		case RENDER_CALL_SET_SHADER:
+			state.shader = call.arguments[0];
+			break;
+		case RENDER_CALL_SET_CONSTANT_BUFFER:
+			slot = call.arguments[0];
+			if (slot == RENDER_STAGE_VERTEX * RENDER_MAX_CONSTANT_BUFFERS)
+			{
+				memcpy(state.frameConstants, &call.arguments[1], sizeof(state.frameConstants));
+			}
+			else if (slot == RENDER_STAGE_VERTEX * RENDER_MAX_CONSTANT_BUFFERS + 1)
+			{
+				state.objectBuffer = call.arguments[1];
+				state.objectFirstConstant = call.arguments[2];
+				state.objectConstantCount = call.arguments[3];
+			}
+			break;
+		case RENDER_CALL_SET_TEXTURE:
+			state.texture = call.arguments[0] == 0 ? call.arguments[1] : state.texture;
+			break;
+		case RENDER_CALL_DRAW_INDEXED:
+		case RENDER_CALL_DRAW_INDEXED_INSTANCED:
+			state.draw = call;
+			if (i >= firstCall)
+			{
+				draws.push_back(state);
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	return;
+}
+
+// ReadObjectConstants fills in the object constants of the draws that read them from the slices they bind. It has to run before the
+// next frame writes over the slices, and the frame has to be finished, so reading does not touch constants a draw still reads.
+static void ReadObjectConstants(NullRenderDeviceClass& device, std::vector<DrawStateType>& draws)
+{
+	void* data;
+	size_t i;
+	bool result;
+
+
+	for (i = 0; i < draws.size(); i++)
+	{
+		// The instanced draws read their world matrices from the instance stream, not from a slice.
+		if (draws[i].draw.type != RENDER_CALL_DRAW_INDEXED)
+		{
+			continue;
+		}
+
+		result = device.MapBuffer(draws[i].objectBuffer, RENDER_MAP_NO_OVERWRITE, draws[i].objectFirstConstant * 16,
+			sizeof(draws[i].objectConstants), data);
+		CHECK(result);
+		if (result)
+		{
+			memcpy(&draws[i].objectConstants, data, sizeof(draws[i].objectConstants));
+			device.UnmapBuffer(draws[i].objectBuffer);
+		}
+	}
+
+	return;
+}
+
+// SameDraw compares two draws. Where the object constants are in the ring may differ, what they hold may not. The draws that are not
+// instanced do not read the instance stream and the instanced ones no object constants, so those may be whatever was left bound.
+static bool SameDraw(const DrawStateType& a, const DrawStateType& b)
+{
+	unsigned int slotCount;
+
+
+	if (a.draw.type != b.draw.type || memcmp(a.draw.arguments, b.draw.arguments, sizeof(a.draw.arguments)) != 0)
+	{
+		return false;
+	}
+
+	slotCount = a.draw.type == RENDER_CALL_DRAW_INDEXED_INSTANCED ? RENDER_MAX_VERTEX_BUFFERS : INSTANCE_VERTEX_SLOT;
+	if (a.shader != b.shader || a.texture != b.texture ||
+		memcmp(a.vertexBuffers, b.vertexBuffers, slotCount * sizeof(a.vertexBuffers[0])) != 0 ||
+		memcmp(a.indexBuffer, b.indexBuffer, sizeof(a.indexBuffer)) != 0 ||
+		memcmp(a.frameConstants, b.frameConstants, sizeof(a.frameConstants)) != 0)
+	{
+		return false;
+	}
+
+	if (a.draw.type == RENDER_CALL_DRAW_INDEXED_INSTANCED)
+	{
+		return true;
+	}
+
+	return a.objectBuffer == b.objectBuffer && a.objectConstantCount == b.objectConstantCount &&
+		memcmp(&a.objectConstants, &b.objectConstants, sizeof(a.objectConstants)) == 0;
+}
+
+// DrawFrame draws the scene with recording on at most threadCount threads and returns the state of every draw of the second frame.
+static void DrawFrame(unsigned int threadCount, OUT std::vector<DrawStateType>& draws, OUT GraphicsClass::FrameStatsType& frameStats)
+{
+	NullRenderDeviceClass device;
+	RenderDeviceClass::CapsType caps;
+	GraphicsClass* Graphics;
+	GraphicsClass::SceneOptionsType options;
+	int firstCall;
+	bool result;
+
+
+	caps.constantBufferOffsetting = true;
+	caps.mapNoOverwriteOnConstantBuffers = true;
+	result = device.Initialize(caps, 0);
+	CHECK(result);
+	device.SetRecording(true);
+
+	Graphics = new GraphicsClass;
+	options = Graphics->GetSceneOptions();
+	options.modelFileName = RECORD_TEST_FILE_NAME;
+	options.staticPropCount = RECORD_TEST_PROPS;
+	options.instanceCount = RECORD_TEST_INSTANCES;
+	options.recordThreadCount = threadCount;
+	options.recordMinPackets = RECORD_TEST_MIN_PACKETS;
+	Graphics->SetSceneOptions(options);
+	result = Graphics->Initialize(&device, 1280, 720);
+	CHECK(result);
+
+	// The first frame loads and uploads, the second one only draws.
+	result = result && Graphics->Frame();
+	CHECK(result);
+	Graphics->ResetFrameStats();
+	firstCall = device.GetCallCount();
+	result = result && Graphics->Frame();
+	CHECK(result);
+	device.SetRecording(false);
+
+	GetDrawStates(device, firstCall, draws);
+	ReadObjectConstants(device, draws);
+	frameStats = Graphics->GetFrameStats();
+
+	Graphics->Shutdown();
+	delete Graphics;
+	device.Shutdown();
+	CHECK(device.GetStats().errorCount == 0);
+
+	return;
+}
+
+
+static void TestRecordedFrames()
+{
+	std::vector<DrawStateType> straight, recorded;
+	GraphicsClass::FrameStatsType frameStats;
+	std::error_code error;
+	unsigned int threadCount, instanced, wrongCount;
+	size_t i;
+
+
+	CHECK(WriteGridObj(RECORD_TEST_FILE_NAME, RECORD_TEST_GRID, RECORD_TEST_MATERIALS));
+
+	// One thread draws straight on the device.
+	DrawFrame(1, straight, frameStats);
+	CHECK(frameStats.recordedFrameCount == 0);
+	CHECK(straight.size() >= RECORD_THREAD_COUNT * RECORD_TEST_MIN_PACKETS);
+
+	// Draws with object constants and instanced ones both have to be in it, or the comparisons miss some.
+	instanced = 0;
+	for (i = 0; i < straight.size(); i++)
+	{
+		instanced += straight[i].draw.type == RENDER_CALL_DRAW_INDEXED_INSTANCED ? 1 : 0;
+	}
+	CHECK(instanced > 0 && instanced < straight.size());
+
+	for (threadCount = 2; threadCount <= RECORD_THREAD_COUNT; threadCount++)
+	{
+		DrawFrame(threadCount, recorded, frameStats);
+		CHECK(frameStats.recordedFrameCount == 1);
+		CHECK(frameStats.recordThreads == threadCount);
+
+		CHECK(recorded.size() == straight.size());
+		wrongCount = 0;
+		for (i = 0; i < straight.size() && i < recorded.size(); i++)
+		{
+			wrongCount += SameDraw(straight[i], recorded[i]) ? 0 : 1;
+		}
+		CHECK(wrongCount == 0);
+	}
+
+	std::filesystem::remove(MeshCacheClass::GetCacheFilename(RECORD_TEST_FILE_NAME), error);
+	remove(RECORD_TEST_FILE_NAME);
+
+	return;
+}
+
+
+static void TestWriteArray()
+{
+	NullRenderDeviceClass device;
+	RenderDeviceClass::CapsType caps;
+	ConstantRingClass ring;
+	NullRenderDeviceClass::CallType call;
+	float constants[3][32];
+	void* data;
+	unsigned int firstConstant, constantCount, buffer, mapCount, i, j;
+	bool result;
+	int c;
+
+
+	caps.constantBufferOffsetting = true;
+	caps.mapNoOverwriteOnConstantBuffers = true;
+	result = device.Initialize(caps, 0);
+	CHECK(result);
+	result = ring.Initialize(&device, RECORD_TEST_RING_SIZE);
+	CHECK(result);
+
+	for (i = 0; i < 3; i++)
+	{
+		for (j = 0; j < 32; j++)
+		{
+			constants[i][j] = (float)(i * 100 + j);
+		}
+	}
+
+	// Fill all but two slices of the ring, so the three blocks do not fit and the ring starts over in fresh memory for them.
+	ring.BeginFrame();
+	for (i = 0; i < RECORD_TEST_RING_SIZE / CONSTANT_RING_ALIGNMENT - 2; i++)
+	{
+		result = ring.Write(constants[0], sizeof(constants[0]), firstConstant, constantCount);
+		CHECK(result);
+	}
+
+	device.SetRecording(true);
+	device.ClearCalls();
+	result = ring.WriteArray(constants, sizeof(constants[0]), 3, firstConstant, constantCount);
+	CHECK(result);
+	CHECK(firstConstant == 0);
+	CHECK(constantCount == CONSTANT_RING_ALIGNMENT / 16);
+	CHECK(ring.GetStats().resetCount == 1);
+
+	// One map for all three, with the discard.
+	buffer = RENDER_HANDLE_NONE;
+	mapCount = 0;
+	for (c = 0; c < device.GetCallCount(); c++)
+	{
+		call = device.GetCall(c);
+		if (call.type == RENDER_CALL_MAP_BUFFER)
+		{
+			buffer = call.arguments[0];
+			mapCount++;
+			CHECK(call.arguments[1] == (unsigned int)RENDER_MAP_DISCARD);
+		}
+	}
+	CHECK(mapCount == 1);
+
+	for (i = 0; i < 3; i++)
+	{
+		result = device.MapBuffer(buffer, RENDER_MAP_NO_OVERWRITE, (firstConstant + i * constantCount) * 16,
+			sizeof(constants[i]), data);
+		CHECK(result);
+		if (result)
+		{
+			CHECK(memcmp(data, constants[i], sizeof(constants[i])) == 0);
+			device.UnmapBuffer(buffer);
+		}
+	}
+	ring.EndFrame();
+
+	ring.Shutdown();
+	device.Shutdown();
+	CHECK(device.GetStats().errorCount == 0);
+
+	return;
+}
+
+
+int main()
+{
+	TestWriteArray();
+	TestRecordedFrames();
+
+	return TEST_RESULT;
+}
@@ -0,0 +1,148 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: RenderQueueBenchmark.cpp
+////////////////////////////////////////////////////////////////////////////////
+// Fills a RenderQueueClass with a million packets of the keys a frame makes and prints how long adding them and sorting them takes,
+// the best of a few runs, with the radix passes Sort ran and skipped. The same packets are also sorted by key with std::sort and
+// std::stable_sort to compare against. The keys are drawn from a few shaders and many materials at random depths, and a tenth of
+// the packets are transparent. A run of opaque packets that all have the same shader and one of a few materials shows the passes
+// skipped.
+//
+//     render_queue_benchmark [packet count] [repeats]
+#include "renderqueueclass.h"
+#include "BenchmarkUtils.h"
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+
+
+/////////////
+// GLOBALS //
+/////////////
+const unsigned int BENCHMARK_DEFAULT_PACKETS = 1000000;
+const int BENCHMARK_DEFAULT_REPEATS = 7;
+const unsigned int BENCHMARK_SHADER_COUNT = 8;
+const unsigned int BENCHMARK_MATERIAL_COUNT = 4096;
+const float BENCHMARK_MAX_DEPTH = 1000.0f;
+
+
+static void MakePackets(unsigned int packetCount, unsigned int shaderCount, unsigned int materialCount, bool transparent,
+	std::vector<RenderQueueClass::PacketType>& packets)
+{
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> depth(0.1f, BENCHMARK_MAX_DEPTH);
+	unsigned int i;
+
+
+	packets.resize(packetCount);
+	for (i = 0; i < packetCount; i++)
+	{
+		packets[i].key = RenderQueueClass::MakeKey(transparent && random() % 10 == 0 ? RENDER_PASS_TRANSPARENT : RENDER_PASS_OPAQUE,
+			random() % shaderCount, random() % materialCount, depth(random));
+		packets[i].geometry = 0;
+		packets[i].object = i;
+		packets[i].texture = 0;
+		packets[i].range.startIndex = 0;
+		packets[i].range.indexCount = 3;
+		packets[i].range.baseVertex = 0;
+		packets[i].range.material = 0;
+		packets[i].firstInstance = 0;
+		packets[i].instanceCount = 0;
+	}
+
+	return;
+}
+
+
+static void RunKeys(const char* label, const std::vector<RenderQueueClass::PacketType>& packets, int repeats)
+{
+	RenderQueueClass queue;
+	RenderQueueClass::StatsType stats;
+	std::vector<RenderQueueClass::PacketType> copy;
+	double seconds, addBest, sortBest, stdBest, stableBest;
+	unsigned int packetCount, i;
+	bool sorted;
+	int run;
+
+
+	packetCount = (unsigned int)packets.size();
+	queue.Initialize(packetCount);
+	addBest = sortBest = stdBest = stableBest = 0.0;
+	for (run = 0; run < repeats; run++)
+	{
+		// A frame's worth: the queue is reset and filled in the memory it kept, then sorted.
+		queue.Reset();
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (i = 0; i < packetCount; i++)
+		{
+			queue.Add(packets[i]);
+		}
+		seconds = SecondsSince(start);
+		addBest = (run == 0 || seconds < addBest) ? seconds : addBest;
+
+		start = std::chrono::steady_clock::now();
+		queue.Sort();
+		seconds = SecondsSince(start);
+		sortBest = (run == 0 || seconds < sortBest) ? seconds : sortBest;
+
+		copy = packets;
+		start = std::chrono::steady_clock::now();
+		std::sort(copy.begin(), copy.end(), [](const RenderQueueClass::PacketType& a, const RenderQueueClass::PacketType& b)
+		{
+			return a.key < b.key;
+		});
+		seconds = SecondsSince(start);
+		stdBest = (run == 0 || seconds < stdBest) ? seconds : stdBest;
+
+		copy = packets;
+		start = std::chrono::steady_clock::now();
+		std::stable_sort(copy.begin(), copy.end(), [](const RenderQueueClass::PacketType& a, const RenderQueueClass::PacketType& b)
+		{
+			return a.key < b.key;
+		});
+		seconds = SecondsSince(start);
+		stableBest = (run == 0 || seconds < stableBest) ? seconds : stableBest;
+	}
+	stats = queue.GetStats();
+
+	// The queue has to come out as std::stable_sort left the packets.
+	sorted = queue.GetPacketCount() == (int)packetCount;
+	for (i = 0; i < packetCount && sorted; i++)
+	{
+		sorted = queue.GetPacket((int)i).object == copy[i].object;
+	}
+	queue.Shutdown();
+
+	printf("%s:\n", label);
+	printf("    Add:                 %7.2f ms, %6.1f M packets/s\n", addBest * 1.0e3, packetCount / addBest * 1.0e-6);
+	printf("    Sort:                %7.2f ms, %6.1f M packets/s, %u passes run and %u skipped%s\n", sortBest * 1.0e3,
+		packetCount / sortBest * 1.0e-6, stats.sortPasses, stats.skippedPasses, sorted ? "" : ", NOT in stable key order");
+	printf("    std::sort:           %7.2f ms, %6.1f M packets/s\n", stdBest * 1.0e3, packetCount / stdBest * 1.0e-6);
+	printf("    std::stable_sort:    %7.2f ms, %6.1f M packets/s\n", stableBest * 1.0e3, packetCount / stableBest * 1.0e-6);
+
+	return;
+}
+
+
+int main(int argc, char** argv)
+{
+	std::vector<RenderQueueClass::PacketType> packets;
+	unsigned int packetCount;
+	int repeats;
+
+
+	packetCount = argc > 1 ? (unsigned int)strtoul(argv[1], 0, 10) : BENCHMARK_DEFAULT_PACKETS;
+	repeats = argc > 2 ? atoi(argv[2]) : BENCHMARK_DEFAULT_REPEATS;
+	if (packetCount == 0 || repeats <= 0)
+	{
+		printf("usage: %s [packet count] [repeats]\n", argv[0]);
+		return 1;
+	}
+
+	printf("%u packets, best of %d runs\n", packetCount, repeats);
+	MakePackets(packetCount, BENCHMARK_SHADER_COUNT, BENCHMARK_MATERIAL_COUNT, true, packets);
+	RunKeys("8 shaders, 4096 materials, opaque and transparent", packets, repeats);
+	MakePackets(packetCount, 1, 4, false, packets);
+	RunKeys("1 shader, 4 materials, opaque", packets, repeats);
+
+	return 0;
+}
@@ -0,0 +1,192 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: RenderQueueTest.cpp
+////////////////////////////////////////////////////////////////////////////////
+// Checks that the keys of the RenderQueueClass order the passes, the state and the depth the way the frame draws them, and that Sort
+// hands back the packets in key order with the ones of equal keys in the order they were added. Queues of random keys with many
+// repeats are sorted at sizes on both sides of the insertion sort limit and compared with std::stable_sort, and keys that only differ
+// in some digits have to skip the passes of the others.
+#include "renderqueueclass.h"
+#include "TestUtils.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+
+/////////////
+// GLOBALS //
+/////////////
+const unsigned int QUEUE_TEST_SIZES[] = { 2, 10, RENDER_QUEUE_INSERTION_SORT_LIMIT, RENDER_QUEUE_INSERTION_SORT_LIMIT + 1, 1000, 100000 };
+
+
+// AddPacket adds a packet with the given key whose object is the order it was added in, for the checks of stability.
+static void AddPacket(RenderQueueClass& queue, unsigned long long key)
+{
+	RenderQueueClass::PacketType packet;
+
+
+	packet.key = key;
+	packet.geometry = 0;
+	packet.object = (unsigned int)queue.GetPacketCount();
+	packet.texture = 0;
+	packet.range.startIndex = 0;
+	packet.range.indexCount = 3;
+	packet.range.baseVertex = 0;
+	packet.range.material = 0;
+	packet.firstInstance = 0;
+	packet.instanceCount = 0;
+	queue.Add(packet);
+
+	return;
+}
+
+// CheckSorted compares the sorted queue with the keys it was given sorted by std::stable_sort, with the order each was added in.
+static void CheckSorted(RenderQueueClass& queue, const std::vector<unsigned long long>& keys)
+{
+	std::vector<std::pair<unsigned long long, unsigned int>> expected;
+	size_t i, wrongCount;
+
+
+	expected.resize(keys.size());
+	for (i = 0; i < keys.size(); i++)
+	{
+		expected[i] = std::make_pair(keys[i], (unsigned int)i);
+	}
+	std::stable_sort(expected.begin(), expected.end(), [](const std::pair<unsigned long long, unsigned int>& a,
+		const std::pair<unsigned long long, unsigned int>& b)
+	{
+		return a.first < b.first;
+	});
+
+	CHECK(queue.GetPacketCount() == (int)keys.size());
+	wrongCount = 0;
+	for (i = 0; i < keys.size() && (int)i < queue.GetPacketCount(); i++)
+	{
+		if (queue.GetPacket((int)i).key != expected[i].first || queue.GetPacket((int)i).object != expected[i].second)
+		{
+			wrongCount++;
+		}
+	}
+	CHECK(wrongCount == 0);
+
+	return;
+}
+
+
+static void TestMakeKey()
+{
+	unsigned long long nearOpaque, farOpaque, otherMaterial, otherShader, nearTransparent, farTransparent;
+
+
+	nearOpaque = RenderQueueClass::MakeKey(RENDER_PASS_OPAQUE, 1, 5, 1.0f);
+	farOpaque = RenderQueueClass::MakeKey(RENDER_PASS_OPAQUE, 1, 5, 100.0f);
+	otherMaterial = RenderQueueClass::MakeKey(RENDER_PASS_OPAQUE, 1, 6, 0.5f);
+	otherShader = RenderQueueClass::MakeKey(RENDER_PASS_OPAQUE, 2, 0, 0.5f);
+	nearTransparent = RenderQueueClass::MakeKey(RENDER_PASS_TRANSPARENT, 0, 0, 1.0f);
+	farTransparent = RenderQueueClass::MakeKey(RENDER_PASS_TRANSPARENT, 3, 9, 100.0f);
+
+	// Opaque draws by shader, then material, then front to back, and every one of them before the transparent ones, back to front.
+	CHECK(nearOpaque < farOpaque);
+	CHECK(farOpaque < otherMaterial);
+	CHECK(otherMaterial < otherShader);
+	CHECK(otherShader < farTransparent);
+	CHECK(farTransparent < nearTransparent);
+
+	// Depths behind the camera and NaN count as zero, ids too large for their bits are cut.
+	CHECK(RenderQueueClass::MakeKey(RENDER_PASS_OPAQUE, 1, 5, -3.0f) == RenderQueueClass::MakeKey(RENDER_PASS_OPAQUE, 1, 5, 0.0f));
+	CHECK(RenderQueueClass::MakeKey(RENDER_PASS_OPAQUE, 1, 5, std::nanf("")) == RenderQueueClass::MakeKey(RENDER_PASS_OPAQUE, 1, 5, 0.0f));
+	CHECK(RenderQueueClass::MakeKey(RENDER_PASS_OPAQUE, 1 + (1 << RENDER_QUEUE_SHADER_BITS), 5, 1.0f) == nearOpaque);
+
+	return;
+}
+
+
+static void TestRandomKeys()
+{
+	RenderQueueClass queue;
+	std::vector<unsigned long long> keys;
+	std::mt19937_64 random(1);
+	unsigned int growCount;
+	size_t size, i;
+
+
+	queue.Initialize(256);
+	for (size = 0; size < sizeof(QUEUE_TEST_SIZES) / sizeof(QUEUE_TEST_SIZES[0]); size++)
+	{
+		// Few distinct values in every digit, so most keys are shared by many packets and stability is put to the test.
+		keys.resize(QUEUE_TEST_SIZES[size]);
+		queue.Reset();
+		for (i = 0; i < keys.size(); i++)
+		{
+			keys[i] = (random() % 7) << 60 | (random() % 5) << 35 | (random() % 13) << 11 | (random() % 3);
+			AddPacket(queue, keys[i]);
+		}
+
+		// Before Sort the packets come back in the order they were added.
+		CHECK(queue.GetPacket((int)keys.size() - 1).object == keys.size() - 1);
+		queue.Sort();
+		CheckSorted(queue, keys);
+	}
+
+	// The largest queue again, in the memory it already has.
+	growCount = queue.GetStats().growCount;
+	queue.Reset();
+	for (i = 0; i < keys.size(); i++)
+	{
+		keys[i] = random();
+		AddPacket(queue, keys[i]);
+	}
+	queue.Sort();
+	CheckSorted(queue, keys);
+	CHECK(queue.GetStats().growCount == growCount);
+	CHECK(queue.GetStats().sortPasses == RENDER_QUEUE_RADIX_PASSES);
+	queue.Shutdown();
+
+	return;
+}
+
+
+static void TestSkippedPasses()
+{
+	RenderQueueClass queue;
+	std::vector<unsigned long long> keys;
+	std::mt19937 random(2);
+	unsigned int i;
+
+
+	// Opaque keys of one shader and a few materials at a few depths only differ in the digits of the material and the depth.
+	queue.Initialize(256);
+	keys.resize(5000);
+	for (i = 0; i < keys.size(); i++)
+	{
+		keys[i] = RenderQueueClass::MakeKey(RENDER_PASS_OPAQUE, 3, random() % 4, (float)(random() % 8));
+		AddPacket(queue, keys[i]);
+	}
+	queue.Sort();
+	CheckSorted(queue, keys);
+	CHECK(queue.GetStats().skippedPasses > 0);
+	CHECK(queue.GetStats().sortPasses + queue.GetStats().skippedPasses == RENDER_QUEUE_RADIX_PASSES);
+
+	// Keys that are all the same need no pass at all, and keep the order the packets were added in.
+	queue.Reset();
+	keys.assign(1000, keys[0]);
+	for (i = 0; i < keys.size(); i++)
+	{
+		AddPacket(queue, keys[i]);
+	}
+	queue.Sort();
+	CheckSorted(queue, keys);
+	CHECK(queue.GetStats().sortPasses == 0);
+	queue.Shutdown();
+
+	return;
+}
+
+
+int main()
+{
+	TestMakeKey();
+	TestRandomKeys();
+	TestSkippedPasses();
+
+	return TEST_RESULT;
+}
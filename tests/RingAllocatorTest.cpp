@@ -0,0 +1,307 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: RingAllocatorTest.cpp
+////////////////////////////////////////////////////////////////////////////////
+// Checks that the RingAllocatorClass hands out aligned ranges, wraps around the end of its block, refuses what would overwrite a frame
+// in flight and gives a frame's ranges back only when it is retired. The ConstantRingClass is then run on the null device, whose GPU
+// finishes frames some submissions late and reports every map that overwrites constants a draw it has not finished reads.
+#include "ringallocatorclass.h"
+#include "constantringclass.h"
+#include "nullrenderdeviceclass.h"
+#include "TestUtils.h"
+#include <deque>
+
+
+/////////////
+// GLOBALS //
+/////////////
+const unsigned int RING_TEST_ALIGNMENT = 256;
+const int RING_RANDOM_FRAMES = 2000;
+
+
+static void TestInitialize()
+{
+	RingAllocatorClass ring;
+
+
+	CHECK(!ring.Initialize(1024, 0, 3));
+	CHECK(!ring.Initialize(1024, 96, 3));
+	CHECK(!ring.Initialize(1000, RING_TEST_ALIGNMENT, 3));
+	CHECK(!ring.Initialize(1024, RING_TEST_ALIGNMENT, 0));
+	CHECK(ring.Initialize(1024, RING_TEST_ALIGNMENT, 3));
+	CHECK(ring.GetMaxFrames() == 3 && ring.GetFramesInFlight() == 0);
+	ring.Shutdown();
+
+	return;
+}
+
+
+static void TestAlignment()
+{
+	RingAllocatorClass ring;
+	unsigned int offset, alignedSize;
+
+
+	CHECK(ring.Initialize(4096, RING_TEST_ALIGNMENT, 3));
+	CHECK(!ring.Allocate(0, offset, alignedSize));
+	CHECK(!ring.Allocate(4097, offset, alignedSize));
+
+	// Every range is rounded up to the alignment and starts where the one before ended.
+	CHECK(ring.Allocate(1, offset, alignedSize) && offset == 0 && alignedSize == 256);
+	CHECK(ring.Allocate(256, offset, alignedSize) && offset == 256 && alignedSize == 256);
+	CHECK(ring.Allocate(257, offset, alignedSize) && offset == 512 && alignedSize == 512);
+	CHECK(ring.Allocate(64, offset, alignedSize) && offset == 1024 && alignedSize == 256);
+	CHECK(ring.GetStats().usedBytes == 1280 && ring.GetStats().allocationCount == 4 && ring.GetStats().failCount == 2);
+	ring.Shutdown();
+
+	return;
+}
+
+
+static void TestWraparound()
+{
+	RingAllocatorClass ring;
+	RingAllocatorClass::StatsType stats;
+	unsigned int offset, alignedSize;
+
+
+	CHECK(ring.Initialize(1024, RING_TEST_ALIGNMENT, 3));
+
+	// The first frame takes three quarters of the ring and is still in flight, so half the ring is more than is left.
+	CHECK(ring.Allocate(768, offset, alignedSize) && offset == 0);
+	CHECK(ring.EndFrame());
+	CHECK(!ring.Allocate(512, offset, alignedSize));
+	stats = ring.GetStats();
+	CHECK(stats.usedBytes == 768 && stats.failCount == 1 && stats.wrapCount == 0);
+
+	// Once it is retired the range wraps to the start and the quarter it skips at the end belongs to the new frame.
+	ring.RetireFrame();
+	CHECK(ring.GetFramesInFlight() == 0);
+	CHECK(ring.Allocate(512, offset, alignedSize) && offset == 0);
+	stats = ring.GetStats();
+	CHECK(stats.wrapCount == 1 && stats.usedBytes == 768);
+
+	// The skipped quarter and the start are not free again until that frame is retired.
+	CHECK(ring.EndFrame());
+	CHECK(ring.Allocate(256, offset, alignedSize) && offset == 512);
+	CHECK(!ring.Allocate(512, offset, alignedSize));
+	CHECK(ring.EndFrame());
+	ring.RetireFrame();
+	CHECK(ring.Allocate(512, offset, alignedSize) && offset == 0);
+	ring.Shutdown();
+
+	return;
+}
+
+
+static void TestFrames()
+{
+	RingAllocatorClass ring;
+	unsigned int offset, alignedSize;
+
+
+	CHECK(ring.Initialize(1024, RING_TEST_ALIGNMENT, 2));
+	CHECK(ring.Allocate(256, offset, alignedSize));
+	CHECK(ring.EndFrame());
+	CHECK(ring.Allocate(256, offset, alignedSize));
+	CHECK(ring.EndFrame());
+	CHECK(!ring.EndFrame());
+	CHECK(ring.GetFramesInFlight() == 2);
+
+	// Retiring frames in order frees their ranges in order, an empty frame frees nothing.
+	ring.RetireFrame();
+	CHECK(ring.GetStats().usedBytes == 256);
+	CHECK(ring.EndFrame());
+	ring.RetireFrame();
+	ring.RetireFrame();
+	CHECK(ring.GetFramesInFlight() == 0 && ring.GetStats().usedBytes == 0);
+	ring.RetireFrame();
+	CHECK(ring.GetFramesInFlight() == 0);
+
+	// Reset frees everything but keeps the frames to retire. The ring is filled from the middle, wrapping once.
+	CHECK(ring.Allocate(512, offset, alignedSize) && offset == 512);
+	CHECK(ring.Allocate(512, offset, alignedSize) && offset == 0);
+	CHECK(ring.EndFrame());
+	CHECK(!ring.Allocate(256, offset, alignedSize));
+	ring.Reset();
+	CHECK(ring.GetFramesInFlight() == 1 && ring.GetStats().usedBytes == 0 && ring.GetStats().resetCount == 1);
+	CHECK(ring.Allocate(256, offset, alignedSize));
+	ring.RetireFrame();
+	CHECK(ring.GetStats().usedBytes == 256);
+	ring.Shutdown();
+
+	return;
+}
+
+
+// TestRandomFrames makes frames of random numbers and sizes of ranges and retires each a fixed number of frames later, like a GPU
+// that is that far behind. No range may overlap one of a frame that is not retired yet, the current frame included.
+static void TestRandomFrames()
+{
+	const unsigned int capacity = 16 * RING_TEST_ALIGNMENT, latency = 3;
+	RingAllocatorClass ring;
+	std::deque<std::vector<unsigned char>> frames;
+	std::vector<unsigned char> owned;
+	unsigned int seed, count, size, offset, alignedSize, k;
+	bool valid;
+	size_t f;
+	int frame, i;
+
+
+	CHECK(ring.Initialize(capacity, RING_TEST_ALIGNMENT, latency + 1));
+	seed = 777;
+	valid = true;
+	for (frame = 0; frame < RING_RANDOM_FRAMES && valid; frame++)
+	{
+		if (frames.size() > latency)
+		{
+			ring.RetireFrame();
+			frames.pop_front();
+		}
+
+		// A frame marks the bytes of every range it got, and no frame still around may have marked them before.
+		owned.assign(capacity, 0);
+		seed = seed * 1664525 + 1013904223;
+		count = (seed >> 16) % 6;
+		for (i = 0; i < (int)count; i++)
+		{
+			seed = seed * 1664525 + 1013904223;
+			size = 1 + (seed >> 8) % (3 * RING_TEST_ALIGNMENT);
+			if (!ring.Allocate(size, offset, alignedSize))
+			{
+				continue;
+			}
+
+			valid = valid && offset % RING_TEST_ALIGNMENT == 0 && offset + alignedSize <= capacity && alignedSize >= size;
+			for (k = offset; k < offset + alignedSize && valid; k++)
+			{
+				for (f = 0; f < frames.size(); f++)
+				{
+					valid = valid && !frames[f][k];
+				}
+				valid = valid && !owned[k];
+				owned[k] = 1;
+			}
+		}
+
+		CHECK(ring.EndFrame());
+		frames.push_back(owned);
+	}
+	CHECK(valid);
+	CHECK(ring.GetStats().wrapCount > 0 && ring.GetStats().failCount > 0);
+	ring.Shutdown();
+
+	return;
+}
+
+
+// DrawFrames draws frames of drawCount draws on the null device, each with its own constantSize byte slice of the constant ring, and
+// returns the errors the device found. The slices hold the draw's number so a draw that read another's constants would show.
+static unsigned int DrawFrames(unsigned int ringSize, unsigned int gpuLatency, unsigned int drawCount, unsigned int constantSize,
+	int frameCount, OUT RingAllocatorClass::StatsType& ringStats)
+{
+	static const VertexElementDescType layout[1] = { { "POSITION", DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, 0, false } };
+	static const float vertices[9] = { 0.0f };
+	static const uint16_t indices[3] = { 0, 1, 2 };
+	NullRenderDeviceClass device;
+	RenderDeviceClass::CapsType caps;
+	RenderDeviceClass::BufferDescType bufferDesc;
+	RenderDeviceClass::ShaderDescType shaderDesc;
+	ConstantRingClass ring;
+	unsigned int vertexBuffer, indexBuffer, shader, stride, offset, firstConstant, constantCount, errors, d;
+	float constants[2 * CONSTANT_RING_ALIGNMENT / sizeof(float)];
+	int frame;
+
+
+	caps.constantBufferOffsetting = true;
+	caps.mapNoOverwriteOnConstantBuffers = true;
+	CHECK(device.Initialize(caps, gpuLatency));
+	device.SetRecording(false);
+
+	bufferDesc.bind = RENDER_BIND_VERTEX_BUFFER;
+	bufferDesc.usage = RENDER_USAGE_DEFAULT;
+	bufferDesc.byteWidth = sizeof(vertices);
+	CHECK(device.CreateBuffer(bufferDesc, vertices, vertexBuffer));
+	bufferDesc.bind = RENDER_BIND_INDEX_BUFFER;
+	bufferDesc.byteWidth = sizeof(indices);
+	CHECK(device.CreateBuffer(bufferDesc, indices, indexBuffer));
+	shaderDesc.vertexShaderFile = L"ring.vs";
+	shaderDesc.vertexEntryPoint = "main";
+	shaderDesc.pixelShaderFile = L"ring.ps";
+	shaderDesc.pixelEntryPoint = "main";
+	shaderDesc.layout = layout;
+	shaderDesc.elementCount = 1;
+	CHECK(device.CreateShader(shaderDesc, shader));
+	CHECK(ring.Initialize(&device, ringSize));
+
+	stride = sizeof(float) * 3;
+	offset = 0;
+	for (frame = 0; frame < frameCount; frame++)
+	{
+		device.BeginScene(0.0f, 0.0f, 0.0f, 1.0f);
+		ring.BeginFrame();
+		device.SetShader(shader);
+		device.SetVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
+		device.SetIndexBuffer(indexBuffer, DXGI_FORMAT_R16_UINT, 0);
+		for (d = 0; d < drawCount; d++)
+		{
+			constants[0] = (float)(frame * drawCount + d);
+			CHECK(ring.Write(constants, constantSize, firstConstant, constantCount));
+			ring.SetVertexShaderConstants(&device, 0, firstConstant, constantCount);
+			device.DrawIndexed(3, 0, 0);
+		}
+		ring.EndFrame();
+		device.EndScene();
+	}
+
+	ringStats = ring.GetStats();
+	ring.Shutdown();
+	device.ReleaseShader(shader);
+	device.ReleaseBuffer(indexBuffer);
+	device.ReleaseBuffer(vertexBuffer);
+	errors = device.GetStats().errorCount;
+	device.Shutdown();
+
+	return errors + device.GetStats().errorCount;
+}
+
+
+// TestConstantRing draws frames that fit in the ring with room for the frames in flight, frames that need it to wait for the GPU,
+// and frames bigger than the whole ring, which have to discard it. None of them may overwrite a slice the GPU still reads.
+static void TestConstantRing()
+{
+	RingAllocatorClass::StatsType stats;
+
+
+	// 15 slices, 2 draws of two slices a frame and the GPU two frames behind: a draw does not fit in the last slice, so the ring skips
+	// it to start over and reuses the slices of retired frames.
+	CHECK(DrawFrames(15 * CONSTANT_RING_ALIGNMENT, 2, 2, 320, 50, stats) == 0);
+	CHECK(stats.allocationCount == 100 && stats.wrapCount > 0 && stats.resetCount == 0);
+	CHECK(stats.framesInFlight <= CONSTANT_RING_FRAMES && stats.peakBytes <= stats.capacity);
+
+	// With the GPU five frames behind BeginFrame has to wait for the oldest of the three frames the ring keeps.
+	CHECK(DrawFrames(16 * CONSTANT_RING_ALIGNMENT, 5, 4, 64, 50, stats) == 0);
+	CHECK(stats.allocationCount == 200 && stats.resetCount == 0);
+
+	// 6 draws a frame leave too little room for three frames in flight, the ring discards instead of waiting.
+	CHECK(DrawFrames(16 * CONSTANT_RING_ALIGNMENT, 2, 6, 64, 50, stats) == 0);
+	CHECK(stats.resetCount > 0);
+
+	// A frame of more draws than the ring has slices discards it within the frame.
+	CHECK(DrawFrames(16 * CONSTANT_RING_ALIGNMENT, 2, 40, 64, 10, stats) == 0);
+	CHECK(stats.resetCount >= 20);
+
+	return;
+}
+
+
+int main()
+{
+	TestInitialize();
+	TestAlignment();
+	TestWraparound();
+	TestFrames();
+	TestRandomFrames();
+	TestConstantRing();
+
+	return TEST_RESULT;
+}
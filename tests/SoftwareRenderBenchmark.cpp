@@ -0,0 +1,207 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: SoftwareRenderBenchmark.cpp
+////////////////////////////////////////////////////////////////////////////////
+// Draws the scene on the SoftwareRenderDeviceClass at 320 x 180, 1280 x 720 and 1920 x 1080 and prints the time of a frame and the
+// throughput of the device: the triangles it set up a second, in millions over the time spent setting them up, and the pixels it
+// shaded a second, in millions over the time spent rasterizing. The cube of the headless tests is drawn, where the time goes to
+// filling the screen, and a generated sphere of half a million triangles, where more of it goes to setting up small triangles. The
+// sphere is drawn at the level of detail the scene picks for the screen, the triangles of a frame are printed with the rest.
+//
+//     software_render_benchmark [sphere segments | OBJ file] [frames]
+//
+// Run it from the folder the headless tests run in, build/tests/headless/run, the scene loads ../cube.obj and its texture
+// ../happy.dds from there like the window version. The sphere is written there too, with its cache. A file that is given is drawn in
+// place of both.
+#include "graphicsclass.h"
+#include "meshcacheclass.h"
+#include "softwarerenderdeviceclass.h"
+#include "BenchmarkUtils.h"
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+
+
+/////////////
+// GLOBALS //
+/////////////
+const int BENCHMARK_RESOLUTIONS[][2] = { { 320, 180 }, { 1280, 720 }, { 1920, 1080 } };
+const int BENCHMARK_DEFAULT_SEGMENTS = 720;
+const int BENCHMARK_DEFAULT_FRAMES = 20;
+const float BENCHMARK_SPHERE_RADIUS = 3.0f;
+const char* BENCHMARK_CUBE_FILE_NAME = "../cube.obj";
+const char* BENCHMARK_FILE_NAME = "software_render_benchmark.obj";
+
+
+// WriteSphereObj writes a sphere around the origin of segments slices and half as many rings, with texture coordinates and normals.
+// Its faces are clockwise seen from outside, the way the scene draws front faces.
+static bool WriteSphereObj(const char* filename, int segments)
+{
+	FILE* file;
+	float theta, phi;
+	int rings, ring, slice, a, b, c, d;
+
+
+	file = fopen(filename, "wb");
+	if (!file)
+	{
+		return false;
+	}
+
+	rings = segments / 2;
+	for (ring = 0; ring <= rings; ring++)
+	{
+		for (slice = 0; slice <= segments; slice++)
+		{
+			theta = XM_PI * ring / rings;
+			phi = XM_2PI * slice / segments;
+			fprintf(file, "v %.6f %.6f %.6f\n", BENCHMARK_SPHERE_RADIUS * sinf(theta) * cosf(phi), BENCHMARK_SPHERE_RADIUS * cosf(theta),
+				BENCHMARK_SPHERE_RADIUS * sinf(theta) * sinf(phi));
+			fprintf(file, "vt %.6f %.6f\n", (float)slice / segments, (float)ring / rings);
+			fprintf(file, "vn %.6f %.6f %.6f\n", sinf(theta) * cosf(phi), cosf(theta), sinf(theta) * sinf(phi));
+		}
+	}
+
+	for (ring = 0; ring < rings; ring++)
+	{
+		for (slice = 0; slice < segments; slice++)
+		{
+			a = ring * (segments + 1) + slice + 1;
+			b = a + 1;
+			c = a + segments + 1;
+			d = c + 1;
+			fprintf(file, "f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, a, b, b, b, d, d, d, c, c, c);
+		}
+	}
+
+	fclose(file);
+
+	return true;
+}
+
+
+static bool RunResolution(const char* filename, int screenWidth, int screenHeight, int frameCount)
+{
+	SoftwareRenderDeviceClass device;
+	SoftwareRenderDeviceClass::FrameStatsType frameStats;
+	GraphicsClass* Graphics;
+	GraphicsClass::SceneOptionsType options;
+	unsigned long long triangleCount, culledCount, pixelCount;
+	double seconds, setupSeconds, rasterSeconds;
+	bool result;
+	int i;
+
+
+	if (!device.Initialize(screenWidth, screenHeight))
+	{
+		return false;
+	}
+
+	Graphics = new GraphicsClass;
+	options = Graphics->GetSceneOptions();
+	options.modelFileName = filename;
+	Graphics->SetSceneOptions(options);
+	result = Graphics->Initialize(&device, screenWidth, screenHeight);
+
+	// The first frame is left out, it is the one that touches the render target and the buffers first.
+	result = result && Graphics->Frame();
+
+	triangleCount = culledCount = pixelCount = 0;
+	setupSeconds = rasterSeconds = 0.0;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (i = 0; i < frameCount && result; i++)
+	{
+		result = Graphics->Frame();
+		frameStats = device.GetFrameStats();
+		triangleCount += frameStats.triangleCount;
+		culledCount += frameStats.culledCount;
+		pixelCount += frameStats.pixelCount;
+		setupSeconds += frameStats.setupSeconds;
+		rasterSeconds += frameStats.rasterSeconds;
+	}
+	seconds = SecondsSince(start);
+
+	Graphics->Shutdown();
+	delete Graphics;
+	device.Shutdown();
+
+	if (!result || device.GetStats().errorCount > 0)
+	{
+		printf("Could not draw %s at %d x %d\n", filename, screenWidth, screenHeight);
+		return false;
+	}
+
+	printf("    %4d x %-4d %7.2f ms a frame on %u threads, %llu triangles (%llu culled), %llu pixels shaded\n", screenWidth, screenHeight,
+		seconds * 1.0e3 / frameCount, frameStats.threadCount, triangleCount / frameCount, culledCount / frameCount, pixelCount / frameCount);
+	printf("                %7.1f Mtri/s in %.2f ms of setup, %7.1f Mpix/s in %.2f ms of rasterizing a frame\n",
+		setupSeconds > 0.0 ? triangleCount / setupSeconds * 1.0e-6 : 0.0, setupSeconds * 1.0e3 / frameCount,
+		rasterSeconds > 0.0 ? pixelCount / rasterSeconds * 1.0e-6 : 0.0, rasterSeconds * 1.0e3 / frameCount);
+
+	return true;
+}
+
+
+static bool RunModel(const char* filename, int frameCount)
+{
+	size_t i;
+
+
+	printf("%s, %d frames:\n", filename, frameCount);
+	for (i = 0; i < sizeof(BENCHMARK_RESOLUTIONS) / sizeof(BENCHMARK_RESOLUTIONS[0]); i++)
+	{
+		if (!RunResolution(filename, BENCHMARK_RESOLUTIONS[i][0], BENCHMARK_RESOLUTIONS[i][1], frameCount))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+int main(int argc, char** argv)
+{
+	std::error_code error;
+	const char* filename;
+	char* end;
+	int segments, frameCount;
+	bool result;
+
+
+	// A first argument that is not a number is the OBJ file to draw.
+	segments = BENCHMARK_DEFAULT_SEGMENTS;
+	filename = BENCHMARK_FILE_NAME;
+	if (argc > 1)
+	{
+		segments = (int)strtol(argv[1], &end, 10);
+		if (*end != '\0')
+		{
+			filename = argv[1];
+			segments = 0;
+		}
+	}
+	frameCount = argc > 2 ? atoi(argv[2]) : BENCHMARK_DEFAULT_FRAMES;
+	if ((filename == BENCHMARK_FILE_NAME && segments < 4) || frameCount <= 0)
+	{
+		printf("usage: %s [sphere segments | OBJ file] [frames]\n", argv[0]);
+		return 1;
+	}
+
+	if (segments > 0 && !WriteSphereObj(BENCHMARK_FILE_NAME, segments))
+	{
+		printf("Could not write %s\n", BENCHMARK_FILE_NAME);
+		return 1;
+	}
+
+	if (segments > 0)
+	{
+		result = RunModel(BENCHMARK_CUBE_FILE_NAME, frameCount) && RunModel(BENCHMARK_FILE_NAME, frameCount);
+		std::filesystem::remove(MeshCacheClass::GetCacheFilename(BENCHMARK_FILE_NAME), error);
+		remove(BENCHMARK_FILE_NAME);
+	}
+	else
+	{
+		result = RunModel(filename, frameCount);
+	}
+
+	return result ? 0 : 1;
+}
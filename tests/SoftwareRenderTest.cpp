@@ -0,0 +1,330 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: SoftwareRenderTest.cpp
+////////////////////////////////////////////////////////////////////////////////
+// Checks the pixels the SoftwareRenderDeviceClass draws. Overlapping rectangles at different depths are drawn through the color
+// shader and the frame is compared pixel for pixel against a reference worked out here, which holds the edges to the pixel centers,
+// the fill rule on the shared diagonals and the depth test. A frame of random triangles is then drawn on one thread and on several,
+// which have to give the same pixels, and the checksum of the frame has to be the same every time it is drawn.
+#include "softwarerenderdeviceclass.h"
+#include "TestUtils.h"
+#include <cstring>
+#include <random>
+
+
+/////////////
+// GLOBALS //
+/////////////
+const int SOFTWARE_TEST_WIDTH = 64;
+const int SOFTWARE_TEST_HEIGHT = 48;
+// Not a whole number of tiles, so the padding of the render target is drawn over and read past.
+const int SOFTWARE_RANDOM_WIDTH = 200;
+const int SOFTWARE_RANDOM_HEIGHT = 150;
+const unsigned int SOFTWARE_RANDOM_TRIANGLES = 3000;
+const unsigned int SOFTWARE_TEST_THREADS = 4;
+const unsigned int SOFTWARE_CLEAR_COLOR = 0xff000000;
+
+
+// The vertices of the color shader, a position and a color.
+struct ColorVertexType
+{
+	float position[3];
+	float color[4];
+};
+
+// A rectangle in pixels, from its first column and row up to but not including its last, the depth it is drawn at and its color.
+struct RectangleType
+{
+	int left, top, right, bottom;
+	float depth;
+	float color[4];
+};
+
+
+// PackTestColor packs a color whose channels are zero or one the way the device stores it, RGBA with red in the low byte.
+static unsigned int PackTestColor(const float* color)
+{
+	return (color[0] > 0.5f ? 0xffu : 0u) | (color[1] > 0.5f ? 0xff00u : 0u) | (color[2] > 0.5f ? 0xff0000u : 0u) |
+		(color[3] > 0.5f ? 0xff000000u : 0u);
+}
+
+// Checksum is the 32 bit FNV-1a hash of the pixels of a frame.
+static unsigned int Checksum(const std::vector<unsigned int>& pixels)
+{
+	unsigned int hash;
+	size_t i;
+	int k;
+
+
+	hash = 2166136261u;
+	for (i = 0; i < pixels.size(); i++)
+	{
+		for (k = 0; k < 32; k += 8)
+		{
+			hash = (hash ^ ((pixels[i] >> k) & 0xff)) * 16777619u;
+		}
+	}
+
+	return hash;
+}
+
+// DrawFrame draws a list of triangles in clip space with the color shader and identity matrices, on the given number of threads.
+// It returns false when the device could not make the resources or found an error.
+static bool DrawFrame(SoftwareRenderDeviceClass& device, unsigned int threadCount, const std::vector<ColorVertexType>& verts,
+	OUT std::vector<unsigned int>& pixels)
+{
+	VertexElementDescType layout[2];
+	RenderDeviceClass::ShaderDescType shaderDesc;
+	RenderDeviceClass::BufferDescType bufferDesc;
+	std::vector<unsigned int> indices;
+	float matrices[48];
+	unsigned int shader, constants, vertexBuffer, indexBuffer, stride, offset, i;
+	bool result;
+
+
+	layout[0].semantic = "POSITION";
+	layout[0].format = DXGI_FORMAT_R32G32B32_FLOAT;
+	layout[0].slot = 0;
+	layout[0].offset = 0;
+	layout[0].semanticIndex = 0;
+	layout[0].perInstance = false;
+	layout[1].semantic = "COLOR";
+	layout[1].format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+	layout[1].slot = 0;
+	layout[1].offset = 12;
+	layout[1].semanticIndex = 0;
+	layout[1].perInstance = false;
+
+	shaderDesc.vertexShaderFile = L"../Color.hlsl";
+	shaderDesc.vertexEntryPoint = "ColorVertexShader";
+	shaderDesc.pixelShaderFile = L"../Color.hlsl";
+	shaderDesc.pixelEntryPoint = "ColorPixelShader";
+	shaderDesc.layout = layout;
+	shaderDesc.elementCount = 2;
+
+	// The world, view and projection matrices are all identity, so the positions are in clip space already.
+	memset(matrices, 0, sizeof(matrices));
+	for (i = 0; i < 12; i++)
+	{
+		matrices[(i / 4) * 16 + (i % 4) * 5] = 1.0f;
+	}
+
+	indices.resize(verts.size());
+	for (i = 0; i < indices.size(); i++)
+	{
+		indices[i] = i;
+	}
+
+	device.SetThreadCount(threadCount);
+	shader = constants = vertexBuffer = indexBuffer = RENDER_HANDLE_NONE;
+	result = device.CreateShader(shaderDesc, shader);
+
+	bufferDesc.bind = RENDER_BIND_CONSTANT_BUFFER;
+	bufferDesc.usage = RENDER_USAGE_DEFAULT;
+	bufferDesc.byteWidth = sizeof(matrices);
+	result = result && device.CreateBuffer(bufferDesc, matrices, constants);
+
+	bufferDesc.bind = RENDER_BIND_VERTEX_BUFFER;
+	bufferDesc.byteWidth = (unsigned int)(verts.size() * sizeof(ColorVertexType));
+	result = result && device.CreateBuffer(bufferDesc, verts.data(), vertexBuffer);
+
+	bufferDesc.bind = RENDER_BIND_INDEX_BUFFER;
+	bufferDesc.byteWidth = (unsigned int)(indices.size() * sizeof(unsigned int));
+	result = result && device.CreateBuffer(bufferDesc, indices.data(), indexBuffer);
+
+	if (result)
+	{
+		stride = sizeof(ColorVertexType);
+		offset = 0;
+		device.BeginScene(0.0f, 0.0f, 0.0f, 1.0f);
+		device.SetVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
+		device.SetIndexBuffer(indexBuffer, DXGI_FORMAT_R32_UINT, 0);
+		device.SetShader(shader);
+		device.SetConstantBuffer(RENDER_STAGE_VERTEX, 0, constants, 0, 0);
+		device.DrawIndexed((unsigned int)indices.size(), 0, 0);
+		device.EndScene();
+		device.ReadPixels(pixels);
+	}
+
+	if (indexBuffer != RENDER_HANDLE_NONE)
+	{
+		device.ReleaseBuffer(indexBuffer);
+	}
+	if (vertexBuffer != RENDER_HANDLE_NONE)
+	{
+		device.ReleaseBuffer(vertexBuffer);
+	}
+	if (constants != RENDER_HANDLE_NONE)
+	{
+		device.ReleaseBuffer(constants);
+	}
+	if (shader != RENDER_HANDLE_NONE)
+	{
+		device.ReleaseShader(shader);
+	}
+
+	return result && device.GetStats().errorCount == 0;
+}
+
+// AddVertex adds a corner in pixels, with y down, as a position in clip space.
+static void AddVertex(std::vector<ColorVertexType>& verts, float x, float y, float depth, const float* color, int width, int height)
+{
+	ColorVertexType vertex;
+
+
+	vertex.position[0] = 2.0f * x / width - 1.0f;
+	vertex.position[1] = 1.0f - 2.0f * y / height;
+	vertex.position[2] = depth;
+	memcpy(vertex.color, color, sizeof(vertex.color));
+	verts.push_back(vertex);
+
+	return;
+}
+
+
+static void TestReferenceImage()
+{
+	const RectangleType rectangles[] =
+	{
+		{ 8, 8, 40, 24, 0.5f, { 1.0f, 0.0f, 0.0f, 1.0f } },
+		// Nearer and drawn later, so it covers the first where they overlap.
+		{ 24, 16, 56, 40, 0.25f, { 0.0f, 1.0f, 0.0f, 1.0f } },
+		// Farther and drawn last, so it only shows where the others are not.
+		{ 0, 0, 64, 48, 0.75f, { 0.0f, 0.0f, 1.0f, 1.0f } },
+		// Across the edge of a tile and off the right of the screen, nearer than everything.
+		{ 30, 30, 70, 34, 0.1f, { 1.0f, 1.0f, 1.0f, 1.0f } }
+	};
+	SoftwareRenderDeviceClass device;
+	std::vector<ColorVertexType> verts;
+	std::vector<unsigned int> pixels, expected;
+	std::vector<float> depths;
+	unsigned long long shadedCount;
+	size_t i, mismatches;
+	int x, y;
+
+
+	// Each rectangle is two clockwise triangles sharing a diagonal, and the reference draws them the way the device has to, a pixel
+	// belongs to a rectangle when its center is inside, and it is only written when it is nearer than what is there.
+	expected.assign((size_t)SOFTWARE_TEST_WIDTH * SOFTWARE_TEST_HEIGHT, SOFTWARE_CLEAR_COLOR);
+	depths.assign(expected.size(), 1.0f);
+	shadedCount = 0;
+	for (i = 0; i < sizeof(rectangles) / sizeof(rectangles[0]); i++)
+	{
+		const RectangleType& rect = rectangles[i];
+
+		AddVertex(verts, (float)rect.left, (float)rect.top, rect.depth, rect.color, SOFTWARE_TEST_WIDTH, SOFTWARE_TEST_HEIGHT);
+		AddVertex(verts, (float)rect.right, (float)rect.top, rect.depth, rect.color, SOFTWARE_TEST_WIDTH, SOFTWARE_TEST_HEIGHT);
+		AddVertex(verts, (float)rect.right, (float)rect.bottom, rect.depth, rect.color, SOFTWARE_TEST_WIDTH, SOFTWARE_TEST_HEIGHT);
+		AddVertex(verts, (float)rect.left, (float)rect.top, rect.depth, rect.color, SOFTWARE_TEST_WIDTH, SOFTWARE_TEST_HEIGHT);
+		AddVertex(verts, (float)rect.right, (float)rect.bottom, rect.depth, rect.color, SOFTWARE_TEST_WIDTH, SOFTWARE_TEST_HEIGHT);
+		AddVertex(verts, (float)rect.left, (float)rect.bottom, rect.depth, rect.color, SOFTWARE_TEST_WIDTH, SOFTWARE_TEST_HEIGHT);
+
+		for (y = rect.top; y < rect.bottom && y < SOFTWARE_TEST_HEIGHT; y++)
+		{
+			for (x = rect.left; x < rect.right && x < SOFTWARE_TEST_WIDTH; x++)
+			{
+				if (rect.depth < depths[(size_t)y * SOFTWARE_TEST_WIDTH + x])
+				{
+					depths[(size_t)y * SOFTWARE_TEST_WIDTH + x] = rect.depth;
+					expected[(size_t)y * SOFTWARE_TEST_WIDTH + x] = PackTestColor(rect.color);
+					shadedCount++;
+				}
+			}
+		}
+	}
+
+	// The same rectangles wound the other way face away and are culled.
+	for (i = 0; i < 6; i += 3)
+	{
+		verts.push_back(verts[i + 2]);
+		verts.push_back(verts[i + 1]);
+		verts.push_back(verts[i]);
+	}
+
+	CHECK(device.Initialize(SOFTWARE_TEST_WIDTH, SOFTWARE_TEST_HEIGHT));
+	CHECK(DrawFrame(device, 1, verts, pixels));
+	CHECK(pixels.size() == expected.size());
+
+	mismatches = 0;
+	for (i = 0; i < pixels.size() && i < expected.size(); i++)
+	{
+		if (pixels[i] != expected[i])
+		{
+			if (mismatches == 0)
+			{
+				printf("First differing pixel at %zu, %zu: %08x, expected %08x\n", i % SOFTWARE_TEST_WIDTH, i / SOFTWARE_TEST_WIDTH, pixels[i],
+					expected[i]);
+			}
+			mismatches++;
+		}
+	}
+	CHECK(mismatches == 0);
+	CHECK(Checksum(pixels) == Checksum(expected));
+
+	// Every pixel is shaded once for every rectangle it is nearer in, no more, so the shared diagonals are not drawn twice.
+	CHECK(device.GetFrameStats().triangleCount == verts.size() / 3);
+	CHECK(device.GetFrameStats().culledCount == 2);
+	CHECK(device.GetFrameStats().pixelCount == shadedCount);
+	device.Shutdown();
+
+	return;
+}
+
+
+static void TestThreadsMatch()
+{
+	SoftwareRenderDeviceClass device;
+	std::vector<ColorVertexType> verts;
+	std::vector<unsigned int> onePixels, manyPixels, againPixels;
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> position(-60.0f, 260.0f);
+	std::uniform_real_distribution<float> size(-40.0f, 40.0f);
+	std::uniform_real_distribution<float> depth(0.05f, 0.95f);
+	std::uniform_real_distribution<float> channel(0.0f, 1.0f);
+	float color[4], x, y;
+	size_t i, drawnCount;
+	unsigned int k;
+
+
+	// Small triangles of random sizes, some of them off the screen and some across it, with a color at every corner.
+	for (k = 0; k < SOFTWARE_RANDOM_TRIANGLES; k++)
+	{
+		x = position(random);
+		y = position(random) * SOFTWARE_RANDOM_HEIGHT / SOFTWARE_RANDOM_WIDTH;
+		for (i = 0; i < 3; i++)
+		{
+			color[0] = channel(random);
+			color[1] = channel(random);
+			color[2] = channel(random);
+			color[3] = 1.0f;
+			AddVertex(verts, x + size(random), y + size(random), depth(random), color, SOFTWARE_RANDOM_WIDTH, SOFTWARE_RANDOM_HEIGHT);
+		}
+	}
+
+	CHECK(device.Initialize(SOFTWARE_RANDOM_WIDTH, SOFTWARE_RANDOM_HEIGHT));
+	CHECK(DrawFrame(device, 1, verts, onePixels));
+	CHECK(device.GetFrameStats().threadCount == 1);
+	CHECK(DrawFrame(device, SOFTWARE_TEST_THREADS, verts, manyPixels));
+	CHECK(device.GetFrameStats().threadCount == SOFTWARE_TEST_THREADS);
+	CHECK(DrawFrame(device, SOFTWARE_TEST_THREADS, verts, againPixels));
+	device.Shutdown();
+
+	drawnCount = 0;
+	for (i = 0; i < onePixels.size(); i++)
+	{
+		drawnCount += onePixels[i] != SOFTWARE_CLEAR_COLOR ? 1 : 0;
+	}
+	CHECK(drawnCount > onePixels.size() / 2);
+	CHECK(onePixels == manyPixels);
+	CHECK(Checksum(onePixels) == Checksum(manyPixels) && Checksum(manyPixels) == Checksum(againPixels));
+
+	return;
+}
+
+
+int main()
+{
+	TestReferenceImage();
+	TestThreadsMatch();
+
+	return TEST_RESULT;
+}
@@ -0,0 +1,320 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: StateFilterTest.cpp
+////////////////////////////////////////////////////////////////////////////////
+// Puts the StateFilterRenderDeviceClass in front of the null device and draws 10000 objects whose shader, geometry and texture
+// repeat in runs, the way a sorted queue draws them, with the frame constants bound before every draw and the object constants at a
+// new offset for each. The filter has to pass on exactly the binds that change something, so its counts and the binds the device saw
+// are checked against a count made here, and the calls the device logged are replayed to check every draw still reads what it was
+// meant to. Invalidate has to make the filter pass the next binds on again.
+#include "statefilterrenderdeviceclass.h"
+#include "nullrenderdeviceclass.h"
+#include "TestUtils.h"
+#include <cstring>
+
+
+/////////////
+// GLOBALS //
+/////////////
+const unsigned int FILTER_OBJECT_COUNT = 10000;
+const unsigned int FILTER_SHADER_COUNT = 2;
+const unsigned int FILTER_GEOMETRY_COUNT = 4;
+const unsigned int FILTER_TEXTURE_COUNT = 4;
+// How many objects in a row share a shader, geometry and texture, the texture changing most often.
+const unsigned int FILTER_SHADER_RUN = 2500;
+const unsigned int FILTER_GEOMETRY_RUN = 500;
+const unsigned int FILTER_TEXTURE_RUN = 100;
+// The object constants are 256 byte slices of one buffer, as the constant ring hands them out.
+const unsigned int FILTER_OBJECT_SLICES = 64;
+
+
+// The state one object is drawn with.
+struct ObjectStateType
+{
+	unsigned int shader, vertexBuffer, indexBuffer, texture, objectConstant;
+};
+
+// The resources the objects are drawn with.
+struct SceneType
+{
+	unsigned int shaders[FILTER_SHADER_COUNT];
+	unsigned int vertexBuffers[FILTER_GEOMETRY_COUNT], indexBuffers[FILTER_GEOMETRY_COUNT];
+	unsigned int textures[FILTER_TEXTURE_COUNT];
+	unsigned int frameConstants, objectConstants;
+};
+
+
+static bool CreateScene(RenderDeviceClass* device, OUT SceneType& scene)
+{
+	VertexElementDescType layout;
+	RenderDeviceClass::ShaderDescType shaderDesc;
+	RenderDeviceClass::BufferDescType bufferDesc;
+	float positions[9] = { 0.0f };
+	unsigned short indices[3] = { 0, 1, 2 };
+	unsigned int i;
+	bool result;
+
+
+	layout.semantic = "POSITION";
+	layout.format = DXGI_FORMAT_R32G32B32_FLOAT;
+	layout.slot = 0;
+	layout.offset = 0;
+	layout.semanticIndex = 0;
+	layout.perInstance = false;
+	shaderDesc.vertexShaderFile = L"../Color.hlsl";
+	shaderDesc.vertexEntryPoint = "ColorVertexShader";
+	shaderDesc.pixelShaderFile = L"../Color.hlsl";
+	shaderDesc.pixelEntryPoint = "ColorPixelShader";
+	shaderDesc.layout = &layout;
+	shaderDesc.elementCount = 1;
+
+	result = true;
+	for (i = 0; i < FILTER_SHADER_COUNT; i++)
+	{
+		result = result && device->CreateShader(shaderDesc, scene.shaders[i]);
+	}
+
+	bufferDesc.usage = RENDER_USAGE_DEFAULT;
+	for (i = 0; i < FILTER_GEOMETRY_COUNT; i++)
+	{
+		bufferDesc.bind = RENDER_BIND_VERTEX_BUFFER;
+		bufferDesc.byteWidth = sizeof(positions);
+		result = result && device->CreateBuffer(bufferDesc, positions, scene.vertexBuffers[i]);
+		bufferDesc.bind = RENDER_BIND_INDEX_BUFFER;
+		bufferDesc.byteWidth = sizeof(indices);
+		result = result && device->CreateBuffer(bufferDesc, indices, scene.indexBuffers[i]);
+	}
+
+	for (i = 0; i < FILTER_TEXTURE_COUNT; i++)
+	{
+		result = result && device->CreateTexture(L"../happy.dds", scene.textures[i]);
+	}
+
+	bufferDesc.bind = RENDER_BIND_CONSTANT_BUFFER;
+	bufferDesc.byteWidth = 256;
+	result = result && device->CreateBuffer(bufferDesc, 0, scene.frameConstants);
+	bufferDesc.byteWidth = 256 * FILTER_OBJECT_SLICES;
+	result = result && device->CreateBuffer(bufferDesc, 0, scene.objectConstants);
+
+	return result;
+}
+
+
+static void ReleaseScene(RenderDeviceClass* device, const SceneType& scene)
+{
+	unsigned int i;
+
+
+	for (i = 0; i < FILTER_SHADER_COUNT; i++)
+	{
+		device->ReleaseShader(scene.shaders[i]);
+	}
+	for (i = 0; i < FILTER_GEOMETRY_COUNT; i++)
+	{
+		device->ReleaseBuffer(scene.vertexBuffers[i]);
+		device->ReleaseBuffer(scene.indexBuffers[i]);
+	}
+	for (i = 0; i < FILTER_TEXTURE_COUNT; i++)
+	{
+		device->ReleaseTexture(scene.textures[i]);
+	}
+	device->ReleaseBuffer(scene.frameConstants);
+	device->ReleaseBuffer(scene.objectConstants);
+
+	return;
+}
+
+
+static ObjectStateType GetObjectState(const SceneType& scene, unsigned int object)
+{
+	ObjectStateType state;
+
+
+	state.shader = scene.shaders[(object / FILTER_SHADER_RUN) % FILTER_SHADER_COUNT];
+	state.vertexBuffer = scene.vertexBuffers[(object / FILTER_GEOMETRY_RUN) % FILTER_GEOMETRY_COUNT];
+	state.indexBuffer = scene.indexBuffers[(object / FILTER_GEOMETRY_RUN) % FILTER_GEOMETRY_COUNT];
+	state.texture = scene.textures[(object / FILTER_TEXTURE_RUN) % FILTER_TEXTURE_COUNT];
+	state.objectConstant = (object % FILTER_OBJECT_SLICES) * 16;
+
+	return state;
+}
+
+// DrawObject binds everything an object reads, whether or not it is bound already, and draws it.
+static void DrawObject(RenderDeviceClass* device, const SceneType& scene, const ObjectStateType& state)
+{
+	unsigned int stride, offset;
+
+
+	stride = 12;
+	offset = 0;
+	device->SetShader(state.shader);
+	device->SetVertexBuffers(0, 1, &state.vertexBuffer, &stride, &offset);
+	device->SetIndexBuffer(state.indexBuffer, DXGI_FORMAT_R16_UINT, 0);
+	device->SetConstantBuffer(RENDER_STAGE_VERTEX, 0, scene.frameConstants, 0, 0);
+	device->SetConstantBuffer(RENDER_STAGE_VERTEX, 1, scene.objectConstants, state.objectConstant, 16);
+	device->SetTexture(0, state.texture);
+	device->DrawIndexed(3, 0, 0);
+
+	return;
+}
+
+
+static void TestRepeatedState()
+{
+	NullRenderDeviceClass device;
+	StateFilterRenderDeviceClass filter;
+	RenderDeviceClass::CapsType caps;
+	RenderDeviceClass::StatsType stats;
+	StateFilterRenderDeviceClass::FilterStatsType filterStats;
+	NullRenderDeviceClass::CallType call;
+	SceneType scene;
+	ObjectStateType state, last, bound;
+	unsigned int expectedIssued[RENDER_STATE_COUNT], expectedBinds, object, drawnCount, wrongCount;
+	int i, k;
+
+
+	caps.constantBufferOffsetting = true;
+	caps.mapNoOverwriteOnConstantBuffers = true;
+	CHECK(device.Initialize(caps, 0));
+	CHECK(filter.Initialize(&device));
+	CHECK(CreateScene(&filter, scene));
+
+	// A bind is passed on when it is the first of its slot or differs from the one before. The frame constants only ever are once.
+	memset(expectedIssued, 0, sizeof(expectedIssued));
+	expectedIssued[RENDER_STATE_CONSTANT_BUFFER] = 1;
+	last = GetObjectState(scene, 0);
+	for (object = 0; object < FILTER_OBJECT_COUNT; object++)
+	{
+		state = GetObjectState(scene, object);
+		expectedIssued[RENDER_STATE_SHADER] += (object == 0 || state.shader != last.shader) ? 1 : 0;
+		expectedIssued[RENDER_STATE_VERTEX_BUFFERS] += (object == 0 || state.vertexBuffer != last.vertexBuffer) ? 1 : 0;
+		expectedIssued[RENDER_STATE_INDEX_BUFFER] += (object == 0 || state.indexBuffer != last.indexBuffer) ? 1 : 0;
+		expectedIssued[RENDER_STATE_TEXTURE] += (object == 0 || state.texture != last.texture) ? 1 : 0;
+		expectedIssued[RENDER_STATE_CONSTANT_BUFFER] += (object == 0 || state.objectConstant != last.objectConstant) ? 1 : 0;
+		last = state;
+	}
+
+	filter.ResetStats();
+	device.SetRecording(true);
+	filter.BeginScene(0.0f, 0.0f, 0.0f, 1.0f);
+	for (object = 0; object < FILTER_OBJECT_COUNT; object++)
+	{
+		DrawObject(&filter, scene, GetObjectState(scene, object));
+	}
+	filter.EndScene();
+	device.SetRecording(false);
+
+	// Every call binds one state, so the device sees one bind for every call passed on and none of the ones dropped.
+	stats = filter.GetStats();
+	filterStats = filter.GetFilterStats();
+	expectedBinds = 0;
+	for (k = 0; k < RENDER_STATE_COUNT; k++)
+	{
+		CHECK(filterStats.issuedCounts[k] == expectedIssued[k]);
+		CHECK(filterStats.filteredCounts[k] == (k == RENDER_STATE_CONSTANT_BUFFER ? 2 : 1) * FILTER_OBJECT_COUNT - expectedIssued[k]);
+		expectedBinds += expectedIssued[k];
+	}
+	CHECK(expectedIssued[RENDER_STATE_SHADER] == FILTER_OBJECT_COUNT / FILTER_SHADER_RUN);
+	CHECK(expectedIssued[RENDER_STATE_TEXTURE] == FILTER_OBJECT_COUNT / FILTER_TEXTURE_RUN);
+	CHECK(stats.bindCount == expectedBinds);
+	CHECK(stats.drawCount == FILTER_OBJECT_COUNT);
+	CHECK(stats.errorCount == 0);
+
+	// Every draw the device logged has to read the state of its object, whatever binds were dropped before it.
+	memset(&bound, 0, sizeof(bound));
+	drawnCount = 0;
+	wrongCount = 0;
+	for (i = 0; i < device.GetCallCount(); i++)
+	{
+		call = device.GetCall(i);
+		switch (call.type)
+		{
+		case RENDER_CALL_SET_SHADER:
+			bound.shader = call.arguments[0];
+			break;
+		case RENDER_CALL_SET_VERTEX_BUFFER:
+			bound.vertexBuffer = call.arguments[0] == 0 ? call.arguments[1] : bound.vertexBuffer;
+			break;
+		case RENDER_CALL_SET_INDEX_BUFFER:
+			bound.indexBuffer = call.arguments[0];
+			break;
+		case RENDER_CALL_SET_CONSTANT_BUFFER:
+			bound.objectConstant = call.arguments[0] == 1 ? call.arguments[2] : bound.objectConstant;
+			break;
+		case RENDER_CALL_SET_TEXTURE:
+			bound.texture = call.arguments[0] == 0 ? call.arguments[1] : bound.texture;
+			break;
+		case RENDER_CALL_DRAW_INDEXED:
+			state = GetObjectState(scene, drawnCount);
+			if (memcmp(&bound, &state, sizeof(state)) != 0)
+			{
+				wrongCount++;
+			}
+			drawnCount++;
+			break;
+		default:
+			break;
+		}
+	}
+	CHECK(drawnCount == FILTER_OBJECT_COUNT);
+	CHECK(wrongCount == 0);
+	device.ClearCalls();
+
+	ReleaseScene(&filter, scene);
+	filter.Shutdown();
+	device.Shutdown();
+	CHECK(device.GetStats().errorCount == 0);
+
+	return;
+}
+
+
+static void TestInvalidate()
+{
+	NullRenderDeviceClass device;
+	StateFilterRenderDeviceClass filter;
+	RenderDeviceClass::CapsType caps;
+	StateFilterRenderDeviceClass::FilterStatsType filterStats;
+	SceneType scene;
+	ObjectStateType state;
+
+
+	caps.constantBufferOffsetting = true;
+	caps.mapNoOverwriteOnConstantBuffers = true;
+	CHECK(device.Initialize(caps, 0));
+	CHECK(filter.Initialize(&device));
+	CHECK(CreateScene(&filter, scene));
+	state = GetObjectState(scene, 0);
+
+	// Drawn twice, the second draw binds nothing new.
+	filter.BeginScene(0.0f, 0.0f, 0.0f, 1.0f);
+	DrawObject(&filter, scene, state);
+	filter.ResetStats();
+	DrawObject(&filter, scene, state);
+	CHECK(filter.GetStats().bindCount == 0);
+
+	// After Invalidate, as after anything that bound on the device behind the filter, all six are passed on again.
+	filter.Invalidate();
+	filter.ResetStats();
+	DrawObject(&filter, scene, state);
+	filterStats = filter.GetFilterStats();
+	CHECK(filter.GetStats().bindCount == 6);
+	CHECK(filterStats.filteredCounts[RENDER_STATE_SHADER] == 0 && filterStats.filteredCounts[RENDER_STATE_CONSTANT_BUFFER] == 0);
+
+	filter.EndScene();
+
+	ReleaseScene(&filter, scene);
+	filter.Shutdown();
+	device.Shutdown();
+	CHECK(device.GetStats().errorCount == 0);
+
+	return;
+}
+
+
+int main()
+{
+	TestRepeatedState();
+	TestInvalidate();
+
+	return TEST_RESULT;
+}
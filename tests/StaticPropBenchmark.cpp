@@ -0,0 +1,145 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: StaticPropBenchmark.cpp
+////////////////////////////////////////////////////////////////////////////////
+// Scatters growing numbers of copies of a small model around the scene as static props on the null device and prints what their
+// batch came to: the batches and cells, the vertices and indices, and how long scattering, merging and uploading them took. It then
+// draws frames of the scene and prints the draws a frame takes against one draw per prop, and the time of a frame.
+//
+//     static_prop_benchmark [prop count | OBJ file] [frames]
+//
+// Without a count it runs 1000, 10000 and 50000 props of a generated grid of 8 x 8 quads. A file that is given is the model the
+// props are copies of, scattered the same three times, and its cache is written next to it.
+#include "graphicsclass.h"
+#include "meshcacheclass.h"
+#include "nullrenderdeviceclass.h"
+#include "BenchmarkUtils.h"
+#include <cstdlib>
+#include <filesystem>
+
+
+/////////////
+// GLOBALS //
+/////////////
+const unsigned int BENCHMARK_PROP_COUNTS[] = { 1000, 10000, 50000 };
+const int BENCHMARK_DEFAULT_FRAMES = 60;
+const int BENCHMARK_PROP_GRID = 8;
+const int BENCHMARK_SCREEN_WIDTH = 1280;
+const int BENCHMARK_SCREEN_HEIGHT = 720;
+const char* BENCHMARK_FILE_NAME = "static_prop_benchmark.obj";
+
+
+static bool RunProps(const char* filename, unsigned int propCount, int frameCount)
+{
+	NullRenderDeviceClass device;
+	RenderDeviceClass::CapsType caps;
+	RenderDeviceClass::StatsType stats;
+	GraphicsClass* Graphics;
+	GraphicsClass::SceneOptionsType options;
+	GraphicsClass::FrameStatsType frameStats;
+	double seconds;
+	bool result;
+	int i;
+
+
+	caps.constantBufferOffsetting = true;
+	caps.mapNoOverwriteOnConstantBuffers = true;
+	if (!device.Initialize(caps, 0))
+	{
+		return false;
+	}
+	device.SetRecording(false);
+
+	Graphics = new GraphicsClass;
+	options = Graphics->GetSceneOptions();
+	options.modelFileName = filename;
+	options.staticPropCount = propCount;
+	Graphics->SetSceneOptions(options);
+	result = Graphics->Initialize(&device, BENCHMARK_SCREEN_WIDTH, BENCHMARK_SCREEN_HEIGHT);
+
+	device.ResetStats();
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (i = 0; i < frameCount && result; i++)
+	{
+		result = Graphics->Frame();
+	}
+	seconds = SecondsSince(start);
+	stats = device.GetStats();
+	frameStats = Graphics->GetFrameStats();
+
+	Graphics->Shutdown();
+	delete Graphics;
+	device.Shutdown();
+
+	if (!result || frameStats.staticProps.sourceCount != propCount)
+	{
+		printf("Could not draw %u props of %s\n", propCount, filename);
+		return false;
+	}
+
+	printf("%u props: %u batches over %u cells, %u vertices and %u indices, scattered, merged and uploaded in %.3f s\n", propCount,
+		frameStats.staticProps.batchCount, frameStats.staticProps.cellCount, frameStats.staticProps.vertexCount,
+		frameStats.staticProps.indexCount, frameStats.staticPropSeconds);
+	printf("    %.1f draws a frame for %u props and the model, %.1f us a frame\n", (double)stats.drawCount / frameCount, propCount,
+		seconds * 1.0e6 / frameCount);
+
+	return true;
+}
+
+
+int main(int argc, char** argv)
+{
+	std::error_code error;
+	const char* filename;
+	char* end;
+	unsigned int propCount;
+	int frameCount;
+	size_t i;
+	bool result;
+
+
+	// A first argument that is not a number is the model to scatter.
+	propCount = 0;
+	filename = BENCHMARK_FILE_NAME;
+	if (argc > 1)
+	{
+		propCount = (unsigned int)strtoul(argv[1], &end, 10);
+		if (*end != '\0')
+		{
+			filename = argv[1];
+			propCount = 0;
+		}
+	}
+	frameCount = argc > 2 ? atoi(argv[2]) : BENCHMARK_DEFAULT_FRAMES;
+	if ((argc > 1 && filename == BENCHMARK_FILE_NAME && propCount == 0) || frameCount <= 0)
+	{
+		printf("usage: %s [prop count | OBJ file] [frames]\n", argv[0]);
+		return 1;
+	}
+
+	if (filename == BENCHMARK_FILE_NAME && !WriteGridObj(BENCHMARK_FILE_NAME, BENCHMARK_PROP_GRID))
+	{
+		printf("Could not write %s\n", BENCHMARK_FILE_NAME);
+		return 1;
+	}
+
+	if (propCount > 0)
+	{
+		result = RunProps(filename, propCount, frameCount);
+	}
+	else
+	{
+		result = true;
+		for (i = 0; i < sizeof(BENCHMARK_PROP_COUNTS) / sizeof(BENCHMARK_PROP_COUNTS[0]) && result; i++)
+		{
+			result = RunProps(filename, BENCHMARK_PROP_COUNTS[i], frameCount);
+		}
+	}
+
+	if (filename == BENCHMARK_FILE_NAME)
+	{
+		std::filesystem::remove(MeshCacheClass::GetCacheFilename(filename), error);
+		remove(BENCHMARK_FILE_NAME);
+	}
+
+	return result ? 0 : 1;
+}
@@ -0,0 +1,30 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: testutils.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _TESTUTILS_H_
+#define _TESTUTILS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <cstdio>
+
+
+// The tests are plain programs run by ctest. CHECK reports a failed condition with its line and counts it, and the test returns
+// TEST_RESULT from main so ctest sees any failure in the exit code.
+static int g_testFailures = 0;
+
+#define CHECK(condition) \
+	do \
+	{ \
+		if (!(condition)) \
+		{ \
+			printf("%s(%d): CHECK failed: %s\n", __FILE__, __LINE__, #condition); \
+			g_testFailures++; \
+		} \
+	} while (0)
+
+#define TEST_RESULT (g_testFailures == 0 ? 0 : 1)
+
+#endif
@@ -0,0 +1,146 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: TlsfAllocatorBenchmark.cpp
+////////////////////////////////////////////////////////////////////////////////
+// Churns a TlsfAllocatorClass the way a geometry pool sees meshes come and go: it fills the range to a load factor with sizes spread
+// evenly over the powers of two between a few dozen and a few ten thousand units, then frees a random allocation and makes a new one
+// over and over. It prints the throughput of Allocate and Free, how fragmented the free space ends up, 1 - largest free block /
+// free units, how many allocations found no block although the free units would have held them, and what Defragment then costs.
+//
+//     tlsf_allocator_benchmark [operations] [capacity] [load percent]
+#include "tlsfallocatorclass.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+
+/////////////
+// GLOBALS //
+/////////////
+const int BENCHMARK_DEFAULT_OPERATIONS = 4000000;
+const unsigned int BENCHMARK_DEFAULT_CAPACITY = 64 * 1024 * 1024;
+const int BENCHMARK_DEFAULT_LOAD = 75;
+const float BENCHMARK_MIN_SIZE_BITS = 5.0f;
+const float BENCHMARK_MAX_SIZE_BITS = 16.0f;
+
+
+// NextRandom steps a linear congruential generator, so every run churns through the same sizes.
+static unsigned int NextRandom(unsigned int& seed)
+{
+	seed = seed * 1664525 + 1013904223;
+
+	return seed >> 8;
+}
+
+
+static unsigned int RandomSize(unsigned int& seed)
+{
+	float bits;
+
+
+	bits = BENCHMARK_MIN_SIZE_BITS + (BENCHMARK_MAX_SIZE_BITS - BENCHMARK_MIN_SIZE_BITS) * (float)(NextRandom(seed) & 0xffff) / 65535.0f;
+
+	return (unsigned int)exp2f(bits);
+}
+
+
+static void PrintStats(const char* when, TlsfAllocatorClass& allocator)
+{
+	TlsfAllocatorClass::StatsType stats;
+
+
+	stats = allocator.GetStats();
+	printf("%s: %u allocations using %.1f%% of %u units, %u free blocks, fragmentation %.3f\n", when, stats.allocationCount,
+		100.0 * stats.usedUnits / stats.capacity, stats.capacity, stats.freeBlockCount,
+		stats.freeUnits > 0 ? 1.0 - (double)stats.largestFree / stats.freeUnits : 0.0);
+
+	return;
+}
+
+
+int main(int argc, char** argv)
+{
+	TlsfAllocatorClass allocator;
+	std::vector<TlsfAllocatorClass::MoveType> moves;
+	std::vector<unsigned int> handles;
+	unsigned int capacity, seed, size, handle, failures, fragmentedFailures;
+	unsigned long long target, used, movedUnits;
+	int operations, load, i;
+	size_t victim;
+	double seconds;
+
+
+	operations = argc > 1 ? atoi(argv[1]) : BENCHMARK_DEFAULT_OPERATIONS;
+	capacity = argc > 2 ? (unsigned int)strtoul(argv[2], 0, 10) : BENCHMARK_DEFAULT_CAPACITY;
+	load = argc > 3 ? atoi(argv[3]) : BENCHMARK_DEFAULT_LOAD;
+	if (operations <= 0 || capacity < (1u << (int)BENCHMARK_MAX_SIZE_BITS) || load <= 0 || load >= 100)
+	{
+		printf("usage: %s [operations] [capacity of at least %u] [load percent below 100]\n", argv[0], 1u << (int)BENCHMARK_MAX_SIZE_BITS);
+		return 1;
+	}
+
+	allocator.Initialize(capacity);
+	seed = 12345;
+
+	// Fill the range up to the load factor.
+	target = (unsigned long long)capacity * load / 100;
+	used = 0;
+	while (used < target)
+	{
+		size = RandomSize(seed);
+		handle = allocator.Allocate(size);
+		if (handle == TLSF_HANDLE_NONE)
+		{
+			break;
+		}
+		handles.push_back(handle);
+		used += size;
+	}
+	PrintStats("Filled", allocator);
+
+	// Every operation frees a random allocation and makes one of a new random size, each Allocate and Free counts as one.
+	failures = 0;
+	fragmentedFailures = 0;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (i = 0; i < operations / 2; i++)
+	{
+		victim = NextRandom(seed) % handles.size();
+		allocator.Free(handles[victim]);
+
+		size = RandomSize(seed);
+		handle = allocator.Allocate(size);
+		if (handle == TLSF_HANDLE_NONE)
+		{
+			// Keep the slot with a small allocation so the load stays about the same.
+			failures++;
+			if (allocator.GetStats().freeUnits >= size)
+			{
+				fragmentedFailures++;
+			}
+			handle = allocator.Allocate(1);
+		}
+		handles[victim] = handle;
+	}
+	seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	printf("Churned %d operations in %.3f s, %.1f Mops/s, %.1f ns per operation\n", operations / 2 * 2, seconds,
+		operations / 2 * 2 / seconds * 1.0e-6, seconds * 1.0e9 / (operations / 2 * 2));
+	printf("%u allocations failed, %u of them with enough free units in smaller blocks\n", failures, fragmentedFailures);
+	PrintStats("Churned", allocator);
+
+	start = std::chrono::steady_clock::now();
+	allocator.Defragment(moves);
+	seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	movedUnits = 0;
+	for (i = 0; i < (int)moves.size(); i++)
+	{
+		movedUnits += moves[i].size;
+	}
+	printf("Defragmented in %.3f ms, %zu moves of %llu units\n", seconds * 1.0e3, moves.size(), movedUnits);
+	PrintStats("Defragmented", allocator);
+
+	allocator.Shutdown();
+
+	return 0;
+}
@@ -0,0 +1,268 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: TlsfAllocatorTest.cpp
+////////////////////////////////////////////////////////////////////////////////
+// Checks the ranges the TlsfAllocatorClass hands out: exactly the units asked for, packed against each other and never overlapping,
+// merged with their free neighbours when they are freed, refused once nothing big enough is left and moved by Defragment without
+// losing what they hold. A long run of random allocations and frees checks the same after every step.
+#include "tlsfallocatorclass.h"
+#include "TestUtils.h"
+#include <algorithm>
+#include <map>
+
+
+/////////////
+// GLOBALS //
+/////////////
+const unsigned int RANDOM_CAPACITY = 1 << 16;
+const int RANDOM_STEPS = 20000;
+const unsigned int RANDOM_MAX_SIZE = 2048;
+
+
+static void TestAllocateFree()
+{
+	TlsfAllocatorClass allocator;
+	TlsfAllocatorClass::StatsType stats;
+	unsigned int a, b, c;
+
+
+	CHECK(allocator.Initialize(1000));
+	CHECK(allocator.Allocate(0) == TLSF_HANDLE_NONE);
+
+	// Allocations from a fresh range follow each other without a gap.
+	a = allocator.Allocate(100);
+	b = allocator.Allocate(37);
+	c = allocator.Allocate(1);
+	CHECK(a != TLSF_HANDLE_NONE && b != TLSF_HANDLE_NONE && c != TLSF_HANDLE_NONE);
+	CHECK(allocator.GetOffset(a) == 0 && allocator.GetSize(a) == 100);
+	CHECK(allocator.GetOffset(b) == 100 && allocator.GetSize(b) == 37);
+	CHECK(allocator.GetOffset(c) == 137 && allocator.GetSize(c) == 1);
+
+	stats = allocator.GetStats();
+	CHECK(stats.capacity == 1000 && stats.usedUnits == 138 && stats.freeUnits == 862 && stats.largestFree == 862);
+	CHECK(stats.allocationCount == 3 && stats.freeBlockCount == 1);
+	CHECK(allocator.IsPacked());
+
+	// Freeing leaves a hole in front of the others, freeing it again changes nothing.
+	allocator.Free(b);
+	allocator.Free(b);
+	stats = allocator.GetStats();
+	CHECK(stats.usedUnits == 101 && stats.allocationCount == 2 && stats.freeBlockCount == 2);
+	CHECK(!allocator.IsPacked());
+
+	// The hole is reused by an allocation that fits in it.
+	b = allocator.Allocate(30);
+	CHECK(b != TLSF_HANDLE_NONE && allocator.GetOffset(b) == 100);
+	allocator.Shutdown();
+
+	return;
+}
+
+
+static void TestCoalesce()
+{
+	TlsfAllocatorClass allocator;
+	TlsfAllocatorClass::StatsType stats;
+	unsigned int handles[4];
+	int i;
+
+
+	CHECK(allocator.Initialize(400));
+	for (i = 0; i < 4; i++)
+	{
+		handles[i] = allocator.Allocate(100);
+		CHECK(handles[i] != TLSF_HANDLE_NONE);
+	}
+	CHECK(allocator.GetStats().freeBlockCount == 0 && allocator.GetStats().largestFree == 0);
+
+	// Two holes apart, then the block between them joins all three into one.
+	allocator.Free(handles[0]);
+	allocator.Free(handles[2]);
+	stats = allocator.GetStats();
+	CHECK(stats.freeBlockCount == 2 && stats.largestFree == 100);
+	CHECK(allocator.Allocate(200) == TLSF_HANDLE_NONE);
+
+	allocator.Free(handles[1]);
+	stats = allocator.GetStats();
+	CHECK(stats.freeBlockCount == 1 && stats.largestFree == 300);
+
+	// Sizes are rounded up to the start of the next free list, [288, 304) for the merged block, so that list's start is what it
+	// is certain to take. 300 units would round past it.
+	CHECK(allocator.Allocate(300) == TLSF_HANDLE_NONE);
+	handles[0] = allocator.Allocate(288);
+	CHECK(handles[0] != TLSF_HANDLE_NONE && allocator.GetOffset(handles[0]) == 0);
+	allocator.Free(handles[0]);
+
+	// The last one merges with the free block in front of it, which leaves the whole range free again.
+	allocator.Free(handles[3]);
+	stats = allocator.GetStats();
+	CHECK(stats.freeBlockCount == 1 && stats.largestFree == 400 && stats.usedUnits == 0 && stats.allocationCount == 0);
+	CHECK(allocator.IsPacked());
+	allocator.Shutdown();
+
+	return;
+}
+
+
+static void TestExhaustion()
+{
+	TlsfAllocatorClass allocator;
+	unsigned int handles[10], handle;
+	int i;
+
+
+	CHECK(allocator.Initialize(1000));
+	for (i = 0; i < 10; i++)
+	{
+		handles[i] = allocator.Allocate(100);
+		CHECK(handles[i] != TLSF_HANDLE_NONE);
+	}
+	CHECK(allocator.Allocate(1) == TLSF_HANDLE_NONE);
+	CHECK(allocator.Allocate(0xffffffff) == TLSF_HANDLE_NONE);
+
+	// A hole of 100 units takes 100 again, not one more.
+	allocator.Free(handles[4]);
+	CHECK(allocator.Allocate(101) == TLSF_HANDLE_NONE);
+	handle = allocator.Allocate(100);
+	CHECK(handle != TLSF_HANDLE_NONE && allocator.GetOffset(handle) == 400);
+
+	// Growing a full range adds a free block at its end.
+	allocator.Grow(1100);
+	handle = allocator.Allocate(100);
+	CHECK(handle != TLSF_HANDLE_NONE && allocator.GetOffset(handle) == 1000);
+	CHECK(allocator.GetCapacity() == 1100 && allocator.GetStats().freeUnits == 0);
+	allocator.Shutdown();
+
+	return;
+}
+
+
+// CheckRanges checks that the live allocations are the sizes they were asked for, lie inside the range without overlapping and add
+// up to the used units the allocator reports.
+static bool CheckRanges(TlsfAllocatorClass& allocator, const std::map<unsigned int, unsigned int>& live)
+{
+	std::vector<std::pair<unsigned int, unsigned int>> ranges;
+	TlsfAllocatorClass::StatsType stats;
+	unsigned int used;
+	size_t i;
+
+
+	used = 0;
+	for (auto& entry : live)
+	{
+		if (allocator.GetSize(entry.first) != entry.second)
+		{
+			return false;
+		}
+		ranges.push_back(std::make_pair(allocator.GetOffset(entry.first), entry.second));
+		used += entry.second;
+	}
+
+	std::sort(ranges.begin(), ranges.end());
+	for (i = 0; i < ranges.size(); i++)
+	{
+		if (ranges[i].first + ranges[i].second > allocator.GetCapacity())
+		{
+			return false;
+		}
+		if (i > 0 && ranges[i - 1].first + ranges[i - 1].second > ranges[i].first)
+		{
+			return false;
+		}
+	}
+
+	stats = allocator.GetStats();
+
+	return stats.usedUnits == used && stats.allocationCount == live.size() && stats.freeUnits + stats.usedUnits == stats.capacity &&
+		stats.largestFree <= stats.freeUnits;
+}
+
+
+// TestRandom allocates and frees random sizes in a fixed pseudo random order. An allocation may only fail when no free block is big
+// enough for the size rounded up to the start of the next free list, at most a sixteenth more. Defragment then has to pack every
+// allocation with its contents, which the test keeps as the handle in every unit of a shadow of the range.
+static void TestRandom()
+{
+	TlsfAllocatorClass allocator;
+	TlsfAllocatorClass::StatsType stats;
+	std::vector<TlsfAllocatorClass::MoveType> moves;
+	std::map<unsigned int, unsigned int> live;
+	std::vector<unsigned int> shadow;
+	unsigned int seed, size, handle, k;
+	bool valid;
+	size_t i;
+	int step;
+
+
+	CHECK(allocator.Initialize(RANDOM_CAPACITY));
+	shadow.assign(RANDOM_CAPACITY, TLSF_HANDLE_NONE);
+	seed = 12345;
+	valid = true;
+	for (step = 0; step < RANDOM_STEPS && valid; step++)
+	{
+		seed = seed * 1664525 + 1013904223;
+		if (live.empty() || (seed >> 16) % 5 < 3)
+		{
+			seed = seed * 1664525 + 1013904223;
+			size = 1 + (seed >> 8) % RANDOM_MAX_SIZE;
+			stats = allocator.GetStats();
+			handle = allocator.Allocate(size);
+			if (handle == TLSF_HANDLE_NONE)
+			{
+				valid = stats.largestFree < size + size / 16 + 1;
+				continue;
+			}
+
+			valid = live.count(handle) == 0;
+			live[handle] = size;
+			for (k = 0; k < size; k++)
+			{
+				shadow[allocator.GetOffset(handle) + k] = handle;
+			}
+		}
+		else
+		{
+			auto victim = live.begin();
+			std::advance(victim, (seed >> 8) % live.size());
+			allocator.Free(victim->first);
+			live.erase(victim);
+		}
+
+		valid = valid && CheckRanges(allocator, live);
+	}
+	CHECK(valid);
+	CHECK(live.size() > 10);
+
+	allocator.Defragment(moves);
+	for (i = 0; i < moves.size(); i++)
+	{
+		CHECK(moves[i].newOffset < moves[i].oldOffset && live.count(moves[i].handle) == 1);
+		std::copy(shadow.begin() + moves[i].oldOffset, shadow.begin() + moves[i].oldOffset + moves[i].size, shadow.begin() + moves[i].newOffset);
+	}
+	CHECK(allocator.IsPacked());
+	CHECK(CheckRanges(allocator, live));
+
+	stats = allocator.GetStats();
+	CHECK(stats.freeBlockCount <= 1 && stats.largestFree == stats.freeUnits);
+	for (auto& entry : live)
+	{
+		for (k = 0; k < entry.second; k++)
+		{
+			valid = valid && shadow[allocator.GetOffset(entry.first) + k] == entry.first;
+		}
+	}
+	CHECK(valid);
+	allocator.Shutdown();
+
+	return;
+}
+
+
+int main()
+{
+	TestAllocateFree();
+	TestCoalesce();
+	TestExhaustion();
+	TestRandom();
+
+	return TEST_RESULT;
+}
@@ -0,0 +1,119 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: TransformBatchBenchmark.cpp
+////////////////////////////////////////////////////////////////////////////////
+// Works out the object constants of 100000 objects with random world matrices, the way the texture shader used to, transposing and
+// writing the world, view and projection matrices of every object, and with TransformBatchClass::Transform, which writes a
+// world-view-projection and a world matrix per object. It prints the time of each, the best of a few runs, the objects per second
+// and the bytes written, and the largest difference of the batch from multiplying the three matrices of an object one at a time.
+//
+//     transform_batch_benchmark [object count] [repeats]
+#include "transformbatchclass.h"
+#include "BenchmarkUtils.h"
+#include <cmath>
+#include <cstdlib>
+#include <random>
+
+
+/////////////
+// GLOBALS //
+/////////////
+const unsigned int BENCHMARK_DEFAULT_OBJECTS = 100000;
+const int BENCHMARK_DEFAULT_REPEATS = 20;
+
+
+// The constants of one object as the texture shader wrote them before the frame and object constants were split.
+struct MatrixConstantsType
+{
+	XMMATRIX world;
+	XMMATRIX view;
+	XMMATRIX projection;
+};
+
+
+int main(int argc, char** argv)
+{
+	TransformBatchClass batch;
+	std::vector<XMMATRIX> worldMatrices;
+	std::vector<MatrixConstantsType> oldConstants;
+	std::vector<TransformBatchClass::ObjectConstantsType> constants;
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+	std::uniform_real_distribution<float> angle(0.0f, XM_2PI);
+	std::uniform_real_distribution<float> scale(0.5f, 2.0f);
+	XMMATRIX viewMatrix, projectionMatrix, reference;
+	XMFLOAT4X4 expected, actual;
+	double seconds, oldBest, batchBest;
+	float error, largest, difference, size;
+	unsigned int objectCount, i;
+	int repeats, run, row, column;
+
+
+	objectCount = argc > 1 ? (unsigned int)strtoul(argv[1], 0, 10) : BENCHMARK_DEFAULT_OBJECTS;
+	repeats = argc > 2 ? atoi(argv[2]) : BENCHMARK_DEFAULT_REPEATS;
+	if (objectCount == 0 || repeats <= 0)
+	{
+		printf("usage: %s [object count] [repeats]\n", argv[0]);
+		return 1;
+	}
+
+	worldMatrices.resize(objectCount);
+	for (i = 0; i < objectCount; i++)
+	{
+		size = scale(random);
+		worldMatrices[i] = XMMatrixScaling(size, size, size) * XMMatrixRotationRollPitchYaw(angle(random), angle(random), angle(random)) *
+			XMMatrixTranslation(position(random), position(random), position(random));
+	}
+	viewMatrix = XMMatrixLookAtLH(XMVectorSet(0.0f, 50.0f, -200.0f, 1.0f), XMVectorZero(), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+	projectionMatrix = XMMatrixPerspectiveFovLH(XM_PI / 4.0f, 16.0f / 9.0f, 0.1f, 1000.0f);
+
+	oldConstants.resize(objectCount);
+	constants.resize(objectCount);
+	oldBest = batchBest = 0.0;
+	for (run = 0; run < repeats; run++)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (i = 0; i < objectCount; i++)
+		{
+			oldConstants[i].world = XMMatrixTranspose(worldMatrices[i]);
+			oldConstants[i].view = XMMatrixTranspose(viewMatrix);
+			oldConstants[i].projection = XMMatrixTranspose(projectionMatrix);
+		}
+		seconds = SecondsSince(start);
+		oldBest = (run == 0 || seconds < oldBest) ? seconds : oldBest;
+
+		start = std::chrono::steady_clock::now();
+		batch.SetViewProjection(viewMatrix, projectionMatrix);
+		batch.Transform(worldMatrices.data(), objectCount, constants.data());
+		seconds = SecondsSince(start);
+		batchBest = (run == 0 || seconds < batchBest) ? seconds : batchBest;
+	}
+
+	// The batch against the three multiplies the old vertex shader did, relative to the largest element of the reference.
+	error = 0.0f;
+	for (i = 0; i < objectCount; i++)
+	{
+		reference = XMMatrixTranspose(worldMatrices[i] * viewMatrix * projectionMatrix);
+		XMStoreFloat4x4(&expected, reference);
+		XMStoreFloat4x4(&actual, constants[i].worldViewProjection);
+		largest = 0.0f;
+		difference = 0.0f;
+		for (row = 0; row < 4; row++)
+		{
+			for (column = 0; column < 4; column++)
+			{
+				largest = fmaxf(largest, fabsf(expected.m[row][column]));
+				difference = fmaxf(difference, fabsf(expected.m[row][column] - actual.m[row][column]));
+			}
+		}
+		error = fmaxf(error, largest > 0.0f ? difference / largest : difference);
+	}
+
+	printf("%u objects, best of %d runs\n", objectCount, repeats);
+	printf("Transposed world, view and projection: %.2f ms, %.1f M objects/s, %.1f MB written\n", oldBest * 1.0e3, objectCount / oldBest * 1.0e-6,
+		objectCount * sizeof(MatrixConstantsType) / (1024.0 * 1024.0));
+	printf("Batched world-view-projection:         %.2f ms, %.1f M objects/s, %.1f MB written\n", batchBest * 1.0e3,
+		objectCount / batchBest * 1.0e-6, objectCount * sizeof(TransformBatchClass::ObjectConstantsType) / (1024.0 * 1024.0));
+	printf("Largest relative difference from multiplying each object's matrices: %.2g\n", error);
+
+	return 0;
+}
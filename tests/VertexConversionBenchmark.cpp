@@ -0,0 +1,153 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: VertexConversionBenchmark.cpp
+////////////////////////////////////////////////////////////////////////////////
+// Packs a million generated vertices into every vertex layout with the packers the layouts generate, interleaved and split, and
+// prints the time of each, the best of a few runs, with the vertices per second and the bytes written. A plain copy of the vertices,
+// MeshCompressionClass::EncodeVertices with its bounds pass and SplitStreams after it are timed the same way to compare against.
+//
+//     vertex_conversion_benchmark [vertex count] [repeats]
+#include "meshcompressionclass.h"
+#include "vertexlayouts.h"
+#include "BenchmarkUtils.h"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+
+
+/////////////
+// GLOBALS //
+/////////////
+const unsigned int BENCHMARK_DEFAULT_VERTICES = 1000000;
+const int BENCHMARK_DEFAULT_REPEATS = 7;
+
+
+// MakeVertices places the vertices on a sphere of radius 10, with texture coordinates from their angles and unit normals.
+static void MakeVertices(unsigned int vertexCount, std::vector<VertexType>& verts)
+{
+	float theta, phi;
+	unsigned int i;
+
+
+	verts.resize(vertexCount);
+	for (i = 0; i < vertexCount; i++)
+	{
+		theta = (float)i * 2.39996323f;
+		phi = acosf(1.0f - 2.0f * (i + 0.5f) / vertexCount);
+		verts[i].normal = XMFLOAT3(sinf(phi) * cosf(theta), cosf(phi), sinf(phi) * sinf(theta));
+		verts[i].position = XMFLOAT3(verts[i].normal.x * 10.0f, verts[i].normal.y * 10.0f, verts[i].normal.z * 10.0f);
+		verts[i].texture = XMFLOAT2(fmodf(theta, XM_2PI) / XM_2PI, phi / XM_PI);
+	}
+
+	return;
+}
+
+
+static void Report(const char* label, unsigned int vertexCount, size_t bytes, int repeats, std::function<void()> convert)
+{
+	double seconds, best;
+	int i;
+
+
+	best = 0.0;
+	for (i = 0; i < repeats; i++)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		convert();
+		seconds = SecondsSince(start);
+		best = (i == 0 || seconds < best) ? seconds : best;
+	}
+
+	printf("%-36s %7.2f ms, %6.1f M vertices/s, %5.1f MB written\n", label, best * 1.0e3, vertexCount / best * 1.0e-6,
+		bytes / (1024.0 * 1024.0));
+
+	return;
+}
+
+
+// ReportLayout times the packer of one layout into streams with room for every vertex.
+template <typename Layout>
+static void ReportLayout(const char* label, const std::vector<VertexType>& verts, const VertexPackContextType& context, int repeats)
+{
+	std::vector<uint8_t> streams[VERTEX_LAYOUT_MAX_SLOTS];
+	uint8_t* pointers[VERTEX_LAYOUT_MAX_SLOTS];
+	size_t bytes;
+	unsigned int slot;
+
+
+	bytes = 0;
+	for (slot = 0; slot < Layout::GetSlotCount(); slot++)
+	{
+		streams[slot].resize(verts.size() * Layout::GetStride(slot));
+		pointers[slot] = streams[slot].data();
+		bytes += streams[slot].size();
+	}
+
+	Report(label, (unsigned int)verts.size(), bytes, repeats, [&]()
+	{
+		Layout::Pack(verts.data(), (unsigned int)verts.size(), context, pointers);
+	});
+
+	return;
+}
+
+
+int main(int argc, char** argv)
+{
+	MeshCompressionClass compression;
+	MeshCompressionClass::QuantizationType quantization;
+	VertexPackContextType context;
+	std::vector<VertexType> verts, copy;
+	std::vector<CompactVertexType> compact;
+	std::vector<uint8_t> positions, attributes;
+	unsigned int vertexCount, k;
+	int repeats;
+
+
+	vertexCount = argc > 1 ? (unsigned int)strtoul(argv[1], 0, 10) : BENCHMARK_DEFAULT_VERTICES;
+	repeats = argc > 2 ? atoi(argv[2]) : BENCHMARK_DEFAULT_REPEATS;
+	if (vertexCount == 0 || repeats <= 0)
+	{
+		printf("usage: %s [vertex count] [repeats]\n", argv[0]);
+		return 1;
+	}
+
+	MakeVertices(vertexCount, verts);
+	compression.EncodeVertices(verts.data(), vertexCount, VERTEX_FORMAT_COMPACT_OCTAHEDRAL, compact, quantization);
+	context.compression = &compression;
+	for (k = 0; k < 3; k++)
+	{
+		context.boundsMin[k] = (&quantization.boundsMin.x)[k];
+		context.invExtent[k] = 1.0f / (&quantization.boundsExtent.x)[k];
+	}
+	printf("%u vertices, best of %d runs\n", vertexCount, repeats);
+
+	copy.resize(vertexCount);
+	Report("Copy of the full vertices", vertexCount, vertexCount * sizeof(VertexType), repeats, [&]()
+	{
+		memcpy(copy.data(), verts.data(), vertexCount * sizeof(VertexType));
+	});
+
+	ReportLayout<FullVertexLayoutType>("Full layout", verts, context, repeats);
+	ReportLayout<CompactOctahedralVertexLayoutType>("Compact octahedral layout", verts, context, repeats);
+	ReportLayout<CompactPackedVertexLayoutType>("Compact packed layout", verts, context, repeats);
+	ReportLayout<FullSplitVertexLayoutType>("Full split layout", verts, context, repeats);
+	ReportLayout<CompactOctahedralSplitVertexLayoutType>("Compact octahedral split layout", verts, context, repeats);
+	ReportLayout<CompactPackedSplitVertexLayoutType>("Compact packed split layout", verts, context, repeats);
+
+	// What the model loader runs: the bounds and the packer, and the byte split for a model with split streams.
+	Report("EncodeVertices, octahedral", vertexCount, vertexCount * sizeof(CompactVertexType), repeats, [&]()
+	{
+		compression.EncodeVertices(verts.data(), vertexCount, VERTEX_FORMAT_COMPACT_OCTAHEDRAL, compact, quantization);
+	});
+	Report("EncodeVertices, packed", vertexCount, vertexCount * sizeof(CompactVertexType), repeats, [&]()
+	{
+		compression.EncodeVertices(verts.data(), vertexCount, VERTEX_FORMAT_COMPACT_PACKED, compact, quantization);
+	});
+	Report("SplitStreams of the full vertices", vertexCount, vertexCount * sizeof(VertexType), repeats, [&]()
+	{
+		compression.SplitStreams(verts.data(), vertexCount, VERTEX_FORMAT_FULL, positions, attributes);
+	});
+
+	return 0;
+}
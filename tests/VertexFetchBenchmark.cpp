@@ -0,0 +1,171 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: VertexFetchBenchmark.cpp
+////////////////////////////////////////////////////////////////////////////////
+// Loads a large generated OBJ file, or the one it is given, welds and optimizes it the way the model loader does, and measures for
+// every vertex format what a pass that only reads positions fetches from one interleaved buffer against the position stream of a
+// split one. The fetches are replayed in index order through the optimizer's cache of 64 byte lines, and the same gather is also
+// timed on the CPU, the best of a few runs. A pass that reads every attribute is shown too, split buffers cost it a little more.
+//
+//     vertex_fetch_benchmark [grid size | OBJ file] [repeats]
+//
+// The default grid of 1000 x 1000 quads is two million triangles.
+#include "objparserclass.h"
+#include "meshweldclass.h"
+#include "meshoptimizerclass.h"
+#include "meshcompressionclass.h"
+#include "BenchmarkUtils.h"
+#include <cstdlib>
+#include <cstring>
+
+
+/////////////
+// GLOBALS //
+/////////////
+const int BENCHMARK_DEFAULT_GRID = 1000;
+const int BENCHMARK_DEFAULT_REPEATS = 5;
+const float BENCHMARK_WELD_TOLERANCE = 1.0e-6f;
+const char* BENCHMARK_FILE_NAME = "vertex_fetch_benchmark.obj";
+
+
+// GatherPositions reads the position of every index from a buffer of the given stride, like the input assembler of a depth pass,
+// and returns the time it took. The sum keeps the reads from being optimized away.
+static double GatherPositions(const uint8_t* buffer, unsigned int stride, unsigned int positionSize, const std::vector<uint32_t>& indices,
+	OUT uint32_t& sum)
+{
+	uint32_t word;
+	size_t i;
+	unsigned int k;
+
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	sum = 0;
+	for (i = 0; i < indices.size(); i++)
+	{
+		for (k = 0; k < positionSize; k += sizeof(word))
+		{
+			memcpy(&word, buffer + (size_t)indices[i] * stride + k, sizeof(word));
+			sum += word;
+		}
+	}
+
+	return SecondsSince(start);
+}
+
+
+static void RunFormat(const char* label, VertexFormatType format, const std::vector<VertexType>& verts, const std::vector<uint32_t>& indices,
+	int repeats)
+{
+	MeshCompressionClass compression;
+	MeshCompressionClass::QuantizationType quantization;
+	MeshOptimizerClass optimizer;
+	std::vector<CompactVertexType> compact;
+	std::vector<uint8_t> positions, attributes;
+	const uint8_t* interleaved;
+	unsigned int vertexCount, stride, positionStride, attributeStride;
+	size_t interleavedBytes, positionBytes, attributeBytes;
+	double interleavedBest, splitBest, seconds;
+	uint32_t interleavedSum, splitSum;
+	int i;
+
+
+	vertexCount = (unsigned int)verts.size();
+	if (format == VERTEX_FORMAT_FULL)
+	{
+		interleaved = (const uint8_t*)verts.data();
+	}
+	else
+	{
+		compression.EncodeVertices(verts.data(), vertexCount, format, compact, quantization);
+		interleaved = (const uint8_t*)compact.data();
+	}
+	compression.SplitStreams(interleaved, vertexCount, format, positions, attributes);
+
+	stride = compression.GetVertexStride(format);
+	positionStride = compression.GetPositionStride(format);
+	attributeStride = compression.GetAttributeStride(format);
+	interleavedBytes = optimizer.AnalyzeVertexFetch(indices, vertexCount, stride).bytesFetched;
+	positionBytes = optimizer.AnalyzeVertexFetch(indices, vertexCount, positionStride).bytesFetched;
+	attributeBytes = optimizer.AnalyzeVertexFetch(indices, vertexCount, attributeStride).bytesFetched;
+
+	interleavedBest = splitBest = 0.0;
+	interleavedSum = splitSum = 0;
+	for (i = 0; i < repeats; i++)
+	{
+		seconds = GatherPositions(interleaved, stride, positionStride, indices, interleavedSum);
+		interleavedBest = (i == 0 || seconds < interleavedBest) ? seconds : interleavedBest;
+		seconds = GatherPositions(positions.data(), positionStride, positionStride, indices, splitSum);
+		splitBest = (i == 0 || seconds < splitBest) ? seconds : splitBest;
+	}
+
+	printf("%s, %u byte vertices, %u byte positions:\n", label, stride, positionStride);
+	printf("    position pass: %.1f MB interleaved, %.1f MB from the position stream (%.0f%% less), gather %.2f ms against %.2f ms%s\n",
+		interleavedBytes / (1024.0 * 1024.0), positionBytes / (1024.0 * 1024.0), 100.0 - 100.0 * positionBytes / interleavedBytes,
+		interleavedBest * 1.0e3, splitBest * 1.0e3, interleavedSum == splitSum ? "" : ", the streams differ");
+	printf("    full pass:     %.1f MB interleaved, %.1f MB from both streams\n", interleavedBytes / (1024.0 * 1024.0),
+		(positionBytes + attributeBytes) / (1024.0 * 1024.0));
+
+	return;
+}
+
+
+int main(int argc, char** argv)
+{
+	ObjParserClass parser;
+	ObjParserClass::ObjDataType obj;
+	MeshWeldClass weld;
+	MeshOptimizerClass optimizer;
+	std::vector<VertexType> verts;
+	std::vector<uint32_t> indices;
+	const char* filename;
+	char* end;
+	int size, repeats;
+	bool result;
+
+
+	// A first argument that is not a number is the OBJ file to measure.
+	size = BENCHMARK_DEFAULT_GRID;
+	filename = BENCHMARK_FILE_NAME;
+	if (argc > 1)
+	{
+		size = (int)strtol(argv[1], &end, 10);
+		if (*end != '\0')
+		{
+			filename = argv[1];
+			size = 0;
+		}
+	}
+	repeats = argc > 2 ? atoi(argv[2]) : BENCHMARK_DEFAULT_REPEATS;
+	if ((filename == BENCHMARK_FILE_NAME && size <= 0) || repeats <= 0)
+	{
+		printf("usage: %s [grid size | OBJ file] [repeats]\n", argv[0]);
+		return 1;
+	}
+
+	if (size > 0 && !WriteGridObj(BENCHMARK_FILE_NAME, size))
+	{
+		printf("Could not write %s\n", BENCHMARK_FILE_NAME);
+		return 1;
+	}
+
+	result = parser.Parse(filename, obj);
+	if (size > 0)
+	{
+		remove(BENCHMARK_FILE_NAME);
+	}
+	weld.SetTolerance(BENCHMARK_WELD_TOLERANCE);
+	weld.SetRemoveDegenerates(true);
+	if (!result || !weld.Weld(obj.positions, obj.uvs, obj.normals, obj.positionIndices, obj.uvIndices, obj.normalIndices, verts, indices,
+		nullptr))
+	{
+		printf("Could not load %s\n", filename);
+		return 1;
+	}
+	optimizer.Optimize(verts, indices);
+	printf("%s: %zu vertices, %zu triangles, optimized\n", filename, verts.size(), indices.size() / 3);
+
+	RunFormat("Full", VERTEX_FORMAT_FULL, verts, indices, repeats);
+	RunFormat("Compact octahedral", VERTEX_FORMAT_COMPACT_OCTAHEDRAL, verts, indices, repeats);
+	RunFormat("Compact packed", VERTEX_FORMAT_COMPACT_PACKED, verts, indices, repeats);
+
+	return 0;
+}
@@ -0,0 +1,73 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: WorkerPoolTest.cpp
+////////////////////////////////////////////////////////////////////////////////
+// Runs jobs of every number of parts on a WorkerPoolClass many times over, the way a frame hands its recording to the pool, and
+// checks that every part runs exactly once per Run, on the calling thread for part 0, and is done before Run returns.
+#include "workerpoolclass.h"
+#include "TestUtils.h"
+#include <atomic>
+
+
+/////////////
+// GLOBALS //
+/////////////
+const unsigned int POOL_TEST_THREADS = 3;
+const int POOL_TEST_RUNS = 2000;
+
+
+static void TestRun()
+{
+	WorkerPoolClass pool;
+	std::atomic<unsigned int> counts[POOL_TEST_THREADS + 1];
+	std::thread::id caller, firstPart;
+	unsigned int partCount, i;
+	bool valid;
+	int run;
+
+
+	CHECK(pool.Initialize(POOL_TEST_THREADS));
+	CHECK(pool.GetThreadCount() == POOL_TEST_THREADS);
+	caller = std::this_thread::get_id();
+
+	std::function<void(unsigned int)> job = [&](unsigned int part)
+	{
+		counts[part]++;
+		if (part == 0)
+		{
+			firstPart = std::this_thread::get_id();
+		}
+	};
+
+	valid = true;
+	for (run = 0; run < POOL_TEST_RUNS && valid; run++)
+	{
+		// Every part count from one to one more than the threads, and more than that, which the pool cuts down.
+		partCount = 1 + run % (POOL_TEST_THREADS + 2);
+		for (i = 0; i <= POOL_TEST_THREADS; i++)
+		{
+			counts[i] = 0;
+		}
+		firstPart = std::thread::id();
+
+		pool.Run(partCount, job);
+
+		for (i = 0; i <= POOL_TEST_THREADS; i++)
+		{
+			valid = valid && counts[i] == (i < partCount ? 1u : 0u);
+		}
+		valid = valid && firstPart == caller;
+	}
+	CHECK(valid);
+	pool.Shutdown();
+	CHECK(pool.GetThreadCount() == 0);
+
+	return;
+}
+
+
+int main()
+{
+	TestRun();
+
+	return TEST_RESULT;
+}